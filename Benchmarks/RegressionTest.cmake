@@ -0,0 +1,99 @@
+# Runs one benchmark and compares its results with a checked-in baseline; see CMakeLists.txt.
+#   BENCHMARK        the benchmark executable
+#   ARGUMENTS        extra arguments for it, separated by spaces
+#   RESULTS          where its results are written as JSON
+#   BASELINE         the baseline to compare with
+#   UPDATE_BASELINE  when true, the results are written into the baseline instead of compared
+#
+# A baseline gives each metric's best time in nanoseconds and how much slower, in percent, a run
+# may be before it counts as a regression. A metric without a tolerance of its own takes the
+# baseline's:
+#   { "tolerancePercent": 15, "metrics": { "Scalar BVH": { "minNs": 820000, "tolerancePercent": 25 } } }
+# A missing baseline, or a measured metric without a recorded time, fails the test: there is
+# nothing to compare with, and passing would hide that. Baseline metrics the run did not measure,
+# such as kernels for instructions this CPU lacks, pass with a note.
+cmake_minimum_required(VERSION 3.19)
+
+# Checked before the run, so a missing baseline is what the test reports even where the benchmark cannot run
+if(EXISTS "${BASELINE}")
+    file(READ "${BASELINE}" baseline)
+elseif(UPDATE_BASELINE)
+    set(baseline "{ \"tolerancePercent\": 15, \"metrics\": {} }")
+else()
+    message(FATAL_ERROR "No baseline at ${BASELINE}; record one with BENCHMARK_UPDATE_BASELINES=ON")
+endif()
+string(JSON defaultTolerance GET "${baseline}" tolerancePercent)
+
+separate_arguments(arguments UNIX_COMMAND "${ARGUMENTS}")
+get_filename_component(resultsDirectory "${RESULTS}" DIRECTORY)
+file(MAKE_DIRECTORY "${resultsDirectory}")
+file(REMOVE "${RESULTS}")
+
+execute_process(COMMAND "${BENCHMARK}" ${arguments} --json "${RESULTS}" RESULT_VARIABLE exitCode)
+if(NOT exitCode EQUAL 0 OR NOT EXISTS "${RESULTS}")
+    message(FATAL_ERROR "${BENCHMARK} failed (${exitCode})")
+endif()
+
+file(READ "${RESULTS}" results)
+string(JSON resultCount LENGTH "${results}" results)
+if(resultCount EQUAL 0)
+    message(FATAL_ERROR "${BENCHMARK} measured nothing")
+endif()
+
+math(EXPR lastResult "${resultCount} - 1")
+set(measured "")
+set(regressions 0)
+set(unrecorded 0)
+foreach(index RANGE ${lastResult})
+    string(JSON name GET "${results}" results ${index} name)
+    string(JSON minNs GET "${results}" results ${index} minNs)
+    list(APPEND measured "${name}")
+
+    string(JSON metric ERROR_VARIABLE missingMetric GET "${baseline}" metrics "${name}")
+    if(missingMetric)
+        set(metric "{}")
+        if(UPDATE_BASELINE)
+            string(JSON baseline SET "${baseline}" metrics "${name}" "{}")
+        endif()
+    endif()
+    string(JSON tolerance ERROR_VARIABLE missingTolerance GET "${metric}" tolerancePercent)
+    if(missingTolerance)
+        set(tolerance ${defaultTolerance})
+    endif()
+    string(JSON baselineNs ERROR_VARIABLE missingTime GET "${metric}" minNs)
+
+    if(UPDATE_BASELINE)
+        string(JSON baseline SET "${baseline}" metrics "${name}" minNs ${minNs})
+        message(STATUS "${name}: recorded ${minNs} ns")
+    elseif(missingTime)
+        message(STATUS "${name}: ${minNs} ns, NO BASELINE recorded")
+        math(EXPR unrecorded "${unrecorded} + 1")
+    else()
+        math(EXPR limitNs "${baselineNs} * (100 + ${tolerance}) / 100")
+        math(EXPR changePercent "(${minNs} - ${baselineNs}) * 100 / ${baselineNs}")
+        if(minNs GREATER limitNs)
+            message(STATUS "${name}: ${minNs} ns against ${baselineNs} ns, ${changePercent}% slower, REGRESSION (tolerance ${tolerance}%)")
+            math(EXPR regressions "${regressions} + 1")
+        else()
+            message(STATUS "${name}: ${minNs} ns against ${baselineNs} ns (${changePercent}%)")
+        endif()
+    endif()
+endforeach()
+
+string(JSON metricCount LENGTH "${baseline}" metrics)
+if(metricCount GREATER 0)
+    math(EXPR lastMetric "${metricCount} - 1")
+    foreach(index RANGE ${lastMetric})
+        string(JSON name MEMBER "${baseline}" metrics ${index})
+        if(NOT name IN_LIST measured)
+            message(STATUS "${name}: in the baseline but not measured")
+        endif()
+    endforeach()
+endif()
+
+if(UPDATE_BASELINE)
+    file(WRITE "${BASELINE}" "${baseline}\n")
+    message(STATUS "Baseline written to ${BASELINE}")
+elseif(regressions GREATER 0 OR unrecorded GREATER 0)
+    message(FATAL_ERROR "${regressions} metric(s) regressed, ${unrecorded} without a baseline time")
+endif()
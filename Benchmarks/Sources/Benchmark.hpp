@@ -0,0 +1,124 @@
+#pragma once
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace Benchmark
+{
+    struct Result
+    {
+        std::string name;
+        uint32_t    iterations = 0;
+        double      minMs      = 0.0;
+        double      averageMs  = 0.0;
+        double      maxMs      = 0.0;
+    };
+
+    // Every result of the run, in order, for --json
+    inline std::vector<Result>& GetResults()
+    {
+        static std::vector<Result> results;
+        return results;
+    }
+
+    // Runs one untimed warm-up iteration, then times each iteration separately. The name is the
+    // metric's key in the regression baselines, so it should not depend on the machine.
+    template <typename Function>
+    Result Run(const std::string& name, uint32_t iterations, Function&& function)
+    {
+        using Clock = std::chrono::steady_clock;
+
+        function();
+
+        Result result{ name, iterations, 1e30, 0.0, 0.0 };
+        for (uint32_t i = 0; i < iterations; ++i)
+        {
+            const auto start = Clock::now();
+            function();
+            const double elapsedMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+            result.minMs = std::min(result.minMs, elapsedMs);
+            result.maxMs = std::max(result.maxMs, elapsedMs);
+            result.averageMs += elapsedMs;
+        }
+        result.averageMs /= iterations;
+
+        spdlog::info("{:<40} avg {:9.3f} ms   min {:9.3f} ms   max {:9.3f} ms",
+            result.name, result.averageMs, result.minMs, result.maxMs);
+        GetResults().push_back(result);
+        return result;
+    }
+
+    // Writes the results as JSON for RegressionTest.cmake. CMake only does integer arithmetic, so
+    // the best time is also given in whole nanoseconds, which is what baselines are compared on.
+    inline bool WriteResults(const std::string& benchmark, const std::string& path)
+    {
+        std::FILE* file = std::fopen(path.c_str(), "wb");
+        if (!file)
+        {
+            spdlog::error("Failed to create {}", path);
+            return false;
+        }
+
+        auto quoted = [](const std::string& text)
+        {
+            std::string escaped = "\"";
+            for (char c : text)
+            {
+                if (c == '"' || c == '\\')
+                {
+                    escaped += '\\';
+                }
+                escaped += c;
+            }
+            return escaped + '"';
+        };
+
+        std::string json = fmt::format("{{\n  \"benchmark\": {},\n  \"results\": [", quoted(benchmark));
+        const std::vector<Result>& results = GetResults();
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            const Result& result = results[i];
+            json += fmt::format("{}\n    {{ \"name\": {}, \"iterations\": {}, \"minMs\": {:.6f}, \"averageMs\": {:.6f}, \"maxMs\": {:.6f}, \"minNs\": {} }}",
+                i == 0 ? "" : ",", quoted(result.name), result.iterations, result.minMs, result.averageMs, result.maxMs,
+                static_cast<uint64_t>(result.minMs * 1e6 + 0.5));
+        }
+        json += "\n  ]\n}\n";
+
+        const bool written = std::fwrite(json.data(), 1, json.size(), file) == json.size();
+        if (std::fclose(file) != 0 || !written)
+        {
+            spdlog::error("Failed to write {}", path);
+            return false;
+        }
+        return true;
+    }
+
+    // Ends a benchmark's main: with --json PATH the results are written there. Returns the exit code.
+    inline int Finish(int argc, char** argv, const std::string& benchmark)
+    {
+        for (int i = 1; i + 1 < argc; ++i)
+        {
+            if (std::strcmp(argv[i], "--json") == 0)
+            {
+                return WriteResults(benchmark, argv[i + 1]) ? 0 : 1;
+            }
+        }
+        return 0;
+    }
+
+    inline volatile double g_Sink = 0.0;
+
+    // Keeps the optimizer from discarding a computed value
+    inline void Consume(double value)
+    {
+        g_Sink = value;
+    }
+}
@@ -0,0 +1,166 @@
+#include "Benchmark.hpp"
+
+#include <MiniEngine/Core/CpuFeatures.hpp>
+#include <MiniEngine/Core/JobSystem.hpp>
+#include <MiniEngine/Scene/CullingSystem.hpp>
+#include <MiniEngine/Scene/Frustum.hpp>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+using namespace MiniEngine;
+
+namespace
+{
+    constexpr uint32_t ObjectCount    = 200'000;
+    constexpr float    WorldSize      = 1000.0f;
+    constexpr float    MovingFraction = 0.05f;
+    constexpr uint32_t Iterations     = 200;
+
+    std::vector<Scene::Bounds> CreateBounds()
+    {
+        std::mt19937 random(3);
+        std::uniform_real_distribution<float> position(-WorldSize * 0.5f, WorldSize * 0.5f);
+        std::uniform_real_distribution<float> size(0.5f, 4.0f);
+
+        std::vector<Scene::Bounds> bounds(ObjectCount);
+        for (Scene::Bounds& object : bounds)
+        {
+            object.center = glm::vec3(position(random), position(random) * 0.1f, position(random));
+            object.extents = glm::vec3(size(random), size(random), size(random));
+            object.radius = glm::length(object.extents);
+        }
+        return bounds;
+    }
+
+    // A camera near the middle of the world looking along the ground, rotating a little each frame
+    Scene::Frustum CreateFrustum(float time)
+    {
+        const glm::vec3 eye(0.0f, 20.0f, 0.0f);
+        const glm::vec3 target = eye + glm::vec3(std::sin(time), -0.1f, std::cos(time));
+        const glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 400.0f);
+        return Scene::Frustum::FromMatrix(projection * glm::lookAt(eye, target, glm::vec3(0.0f, 1.0f, 0.0f)));
+    }
+
+    // The BVH emits objects in slot order rather than the order they were added, so sets are compared sorted
+    bool SameObjects(std::vector<uint32_t> a, std::vector<uint32_t> b)
+    {
+        std::sort(a.begin(), a.end());
+        std::sort(b.begin(), b.end());
+        return a == b;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Core::JobSystem jobs;
+    spdlog::info("{} objects, best kernel: {}, parallel culling on {} threads",
+        ObjectCount, Core::ToString(Core::GetSupportedSimdLevel()), jobs.GetConcurrency());
+
+    const std::vector<Scene::Bounds> bounds = CreateBounds();
+    const Scene::Frustum frustum = CreateFrustum(0.3f);
+
+    // Brute-force reference for the visible set
+    size_t expectedVisible = 0;
+    for (const Scene::Bounds& object : bounds)
+    {
+        expectedVisible += frustum.Intersects(object) ? 1 : 0;
+    }
+    spdlog::info("{} objects intersect the reference frustum", expectedVisible);
+    int exitCode = 0;
+
+    for (Core::SimdLevel level : { Core::SimdLevel::Scalar, Core::SimdLevel::Sse, Core::SimdLevel::Avx2 })
+    {
+        if (level > Core::GetSupportedSimdLevel())
+        {
+            spdlog::info("{} not supported on this CPU, skipped", Core::ToString(level));
+            continue;
+        }
+
+        Scene::CullingSystem culling(level);
+        std::vector<Scene::CullingSystem::ObjectId> objects;
+        for (uint32_t i = 0; i < ObjectCount; ++i)
+        {
+            objects.push_back(culling.AddObject(bounds[i], i));
+        }
+
+        std::vector<uint32_t> linearVisible;
+        std::vector<uint32_t> visible;
+        std::vector<uint32_t> parallelVisible;
+
+        Benchmark::Run(fmt::format("{} linear", Core::ToString(level)), Iterations, [&]
+        {
+            culling.CullLinear(frustum, linearVisible);
+        });
+
+        Benchmark::Run(fmt::format("{} BVH", Core::ToString(level)), Iterations, [&]
+        {
+            culling.Cull(frustum, visible);
+        });
+
+        const Scene::CullingStats stats = culling.GetStats();
+        spdlog::info("  visible {} (linear {}), nodes tested {}, objects tested {}, accepted by node {}",
+            stats.visibleObjects, linearVisible.size(), stats.testedNodes, stats.testedObjects, stats.acceptedObjects);
+
+        Benchmark::Run(fmt::format("{} BVH, parallel", Core::ToString(level)), Iterations, [&]
+        {
+            culling.Cull(frustum, parallelVisible, &jobs);
+        });
+
+        // A fast cull is only worth timing if it is right: the BVH must keep exactly what the linear
+        // pass keeps, and the parallel walk exactly what the serial one does
+        if (!SameObjects(visible, linearVisible))
+        {
+            spdlog::error("{} BVH culling keeps {} objects, the linear pass {}; the sets differ",
+                Core::ToString(level), visible.size(), linearVisible.size());
+            exitCode = 1;
+        }
+        if (!SameObjects(parallelVisible, visible))
+        {
+            spdlog::error("{} parallel BVH culling keeps {} objects, the serial walk {}; the sets differ",
+                Core::ToString(level), parallelVisible.size(), visible.size());
+            exitCode = 1;
+        }
+
+        // Some objects drift every frame, so each cull pays for a refit as well
+        std::mt19937 random(5);
+        std::uniform_int_distribution<size_t> pick(0, objects.size() - 1);
+        const size_t movingCount = static_cast<size_t>(ObjectCount * MovingFraction);
+        float time = 0.0f;
+
+        Benchmark::Run(fmt::format("{} BVH, {:.0f}% moving, rotating camera", Core::ToString(level), MovingFraction * 100.0f), Iterations, [&]
+        {
+            time += 0.016f;
+            for (size_t i = 0; i < movingCount; ++i)
+            {
+                const size_t object = pick(random);
+                Scene::Bounds moved = bounds[object];
+                moved.center += glm::vec3(std::sin(time + object), 0.0f, std::cos(time + object));
+                culling.UpdateObject(objects[object], moved);
+            }
+            culling.Cull(CreateFrustum(time), visible, &jobs);
+        });
+
+        const Scene::CullingStats movingStats = culling.GetStats();
+        spdlog::info("  last frame: {} nodes refitted, rebuilt: {}, {:.3f} ms including refit",
+            movingStats.refittedNodes, movingStats.rebuilt, movingStats.cullTimeMs);
+
+        // Refits move boxes without changing the tree, which must still agree with testing every object
+        culling.CullLinear(CreateFrustum(time), linearVisible);
+        if (!SameObjects(visible, linearVisible))
+        {
+            spdlog::error("{} BVH culling after refits keeps {} objects, the linear pass {}; the sets differ",
+                Core::ToString(level), visible.size(), linearVisible.size());
+            exitCode = 1;
+        }
+    }
+
+    const int result = Benchmark::Finish(argc, argv, "CullingBenchmark");
+    return exitCode != 0 ? exitCode : result;
+}
@@ -0,0 +1,103 @@
+#include "Benchmark.hpp"
+
+#include <MiniEngine/Graphics/DrawQueue.hpp>
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+using namespace MiniEngine;
+
+namespace
+{
+    constexpr uint32_t DrawCount           = 100'000;
+    constexpr uint32_t PipelineCount       = 24;
+    constexpr uint32_t MaterialCount       = 400;
+    constexpr float    TransparentFraction = 0.1f;
+    constexpr float    NearPlane           = 0.1f;
+    constexpr float    FarPlane            = 500.0f;
+    constexpr uint32_t Iterations          = 200;
+
+    // Draws in the order a scene traversal would produce them: state is unrelated to position
+    std::vector<Graphics::QueuedDraw> CreateDraws()
+    {
+        std::mt19937 random(7);
+        std::uniform_int_distribution<uint32_t> pipeline(0, PipelineCount - 1);
+        std::uniform_int_distribution<uint32_t> material(0, MaterialCount - 1);
+        std::uniform_real_distribution<float> depth(NearPlane, FarPlane);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+        std::vector<Graphics::QueuedDraw> draws(DrawCount);
+        for (uint32_t i = 0; i < DrawCount; ++i)
+        {
+            const Graphics::DrawPass pass = unit(random) < TransparentFraction ? Graphics::DrawPass::Transparent : Graphics::DrawPass::Opaque;
+            const uint32_t bucket = Graphics::DrawKey::MakeDepthBucket(depth(random), NearPlane, FarPlane);
+            draws[i] = { Graphics::DrawKey::Make(pass, pipeline(random), material(random), bucket), i };
+        }
+        return draws;
+    }
+
+    bool IsOrdered(const std::vector<Graphics::QueuedDraw>& draws)
+    {
+        for (size_t i = 1; i < draws.size(); ++i)
+        {
+            const Graphics::QueuedDraw& previous = draws[i - 1];
+            const Graphics::QueuedDraw& current = draws[i];
+            if (previous.key > current.key || (previous.key == current.key && previous.drawIndex > current.drawIndex))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    spdlog::info("{} draws, {} pipelines, {} materials, {:.0f}% transparent",
+        DrawCount, PipelineCount, MaterialCount, TransparentFraction * 100.0f);
+
+    const std::vector<Graphics::QueuedDraw> draws = CreateDraws();
+    Graphics::DrawQueue queue;
+    queue.Reserve(DrawCount);
+
+    Benchmark::Run("Submit + radix sort", Iterations, [&]
+    {
+        queue.Clear();
+        for (const Graphics::QueuedDraw& draw : draws)
+        {
+            queue.Submit(draw.key, draw.drawIndex);
+        }
+        queue.Sort();
+    });
+    spdlog::info("  {} radix passes, last sort {:.3f} ms, ordered and stable: {}",
+        queue.GetStats().radixPasses, queue.GetStats().sortTimeMs, IsOrdered(queue.GetDraws()) ? "yes" : "NO");
+
+    std::vector<Graphics::QueuedDraw> reference;
+    Benchmark::Run("std::stable_sort reference", Iterations, [&]
+    {
+        reference = draws;
+        std::stable_sort(reference.begin(), reference.end(), [](const Graphics::QueuedDraw& a, const Graphics::QueuedDraw& b)
+        {
+            return a.key < b.key;
+        });
+    });
+
+    const bool matches = std::equal(reference.begin(), reference.end(), queue.GetDraws().begin(), [](const Graphics::QueuedDraw& a, const Graphics::QueuedDraw& b)
+    {
+        return a.key == b.key && a.drawIndex == b.drawIndex;
+    });
+    spdlog::info("  radix order matches std::stable_sort: {}", matches ? "yes" : "NO");
+
+    const Graphics::BindCounts unsorted = Graphics::CountBinds(draws.data(), draws.size());
+    const Graphics::BindCounts sorted = Graphics::CountBinds(queue.GetDraws().data(), queue.GetDrawCount());
+    spdlog::info("Pipeline binds:   {:>7} unsorted, {:>7} sorted ({:.1f}x fewer)",
+        unsorted.pipelineBinds, sorted.pipelineBinds, static_cast<double>(unsorted.pipelineBinds) / sorted.pipelineBinds);
+    spdlog::info("Descriptor binds: {:>7} unsorted, {:>7} sorted ({:.1f}x fewer)",
+        unsorted.descriptorBinds, sorted.descriptorBinds, static_cast<double>(unsorted.descriptorBinds) / sorted.descriptorBinds);
+
+    return Benchmark::Finish(argc, argv, "DrawQueueBenchmark");
+}
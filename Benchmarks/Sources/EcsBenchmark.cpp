@@ -0,0 +1,140 @@
+#include "Benchmark.hpp"
+
+#include <MiniEngine/Core/JobSystem.hpp>
+#include <MiniEngine/Scene/Components.hpp>
+#include <MiniEngine/Scene/Registry.hpp>
+
+#include <spdlog/spdlog.h>
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+using namespace MiniEngine;
+
+namespace
+{
+    constexpr uint32_t EntityCount = 1'000'000;
+    constexpr uint32_t Iterations  = 20;
+
+    const glm::vec3 MeshExtents = glm::vec3(0.5f, 1.0f, 0.5f);
+
+    // What a scene looks like without an ECS: one fat struct per object, mesh handles held by value
+    struct AosSceneObject
+    {
+        Scene::Transform transform;
+        glm::mat4        worldMatrix;
+        Scene::Bounds    bounds;
+        uint64_t         vertexBuffer       = 0;
+        uint64_t         vertexBufferMemory = 0;
+        uint32_t         vertexCount        = 0;
+        uint32_t         flags              = 0;
+    };
+
+    // Present on a quarter of the entities so the view spans more than one archetype
+    struct MeshRenderer
+    {
+        uint64_t vertexBuffer = 0;
+        uint32_t vertexCount  = 0;
+    };
+
+    Scene::Transform RandomTransform(std::mt19937& random)
+    {
+        std::uniform_real_distribution<float> position(-1000.0f, 1000.0f);
+        std::uniform_real_distribution<float> scale(0.5f, 2.0f);
+
+        Scene::Transform transform;
+        transform.position = glm::vec3(position(random), position(random), position(random));
+        transform.scale = glm::vec3(scale(random));
+        return transform;
+    }
+
+    void UpdateBounds(const Scene::Transform& transform, Scene::Bounds& bounds)
+    {
+        bounds.center = transform.position;
+        bounds.extents = MeshExtents * transform.scale;
+        bounds.radius = glm::length(bounds.extents);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Core::JobSystem jobs;
+    spdlog::info("Iterating {} entities with Transform + Bounds, {} iterations, parallel on {} threads",
+        EntityCount, Iterations, jobs.GetConcurrency());
+
+    std::mt19937 random(42);
+
+    std::vector<AosSceneObject> objects(EntityCount);
+    for (AosSceneObject& object : objects)
+    {
+        object.transform = RandomTransform(random);
+    }
+
+    random.seed(42);
+    Scene::Registry registry;
+    registry.Reserve<Scene::Transform, Scene::Bounds>(EntityCount);
+    for (uint32_t i = 0; i < EntityCount; ++i)
+    {
+        const Scene::Entity entity = registry.Create(RandomTransform(random), Scene::Bounds{});
+        if (i % 4 == 0)
+        {
+            registry.Add(entity, MeshRenderer{});
+        }
+    }
+
+    auto view = registry.Query<Scene::Transform, Scene::Bounds>();
+
+    const Benchmark::Result aos = Benchmark::Run("AoS vector<SceneObject>", Iterations, [&]
+    {
+        float totalRadius = 0.0f;
+        for (AosSceneObject& object : objects)
+        {
+            UpdateBounds(object.transform, object.bounds);
+            totalRadius += object.bounds.radius;
+        }
+        Benchmark::Consume(totalRadius);
+    });
+
+    const Benchmark::Result each = Benchmark::Run("ECS View::Each", Iterations, [&]
+    {
+        float totalRadius = 0.0f;
+        view.Each([&](Scene::Entity, Scene::Transform& transform, Scene::Bounds& bounds)
+        {
+            UpdateBounds(transform, bounds);
+            totalRadius += bounds.radius;
+        });
+        Benchmark::Consume(totalRadius);
+    });
+
+    const Benchmark::Result chunk = Benchmark::Run("ECS View::EachChunk", Iterations, [&]
+    {
+        float totalRadius = 0.0f;
+        view.EachChunk([&](size_t count, const Scene::Entity*, Scene::Transform* transforms, Scene::Bounds* bounds)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                UpdateBounds(transforms[i], bounds[i]);
+                totalRadius += bounds[i].radius;
+            }
+        });
+        Benchmark::Consume(totalRadius);
+    });
+
+    const Benchmark::Result parallel = Benchmark::Run("ECS View::ParallelEachChunk", Iterations, [&]
+    {
+        view.ParallelEachChunk(jobs, [](size_t count, const Scene::Entity*, Scene::Transform* transforms, Scene::Bounds* bounds)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                UpdateBounds(transforms[i], bounds[i]);
+            }
+        });
+    });
+
+    spdlog::info("Speed-up over AoS: Each {:.2f}x, EachChunk {:.2f}x, ParallelEachChunk {:.2f}x",
+        aos.averageMs / each.averageMs, aos.averageMs / chunk.averageMs, aos.averageMs / parallel.averageMs);
+    spdlog::info("Bytes per object: AoS {}, ECS columns {}", sizeof(AosSceneObject), sizeof(Scene::Transform) + sizeof(Scene::Bounds));
+
+    return Benchmark::Finish(argc, argv, "EcsBenchmark");
+}
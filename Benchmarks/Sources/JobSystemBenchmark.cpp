@@ -0,0 +1,109 @@
+#include "Benchmark.hpp"
+
+#include <MiniEngine/Core/JobSystem.hpp>
+#include <MiniEngine/Core/TaskGraph.hpp>
+
+#include <spdlog/spdlog.h>
+
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+using namespace MiniEngine;
+
+namespace
+{
+    constexpr uint32_t ElementCount    = 1'000'000;
+    constexpr uint32_t SmallLoopCount  = 1000;
+    constexpr uint32_t SmallLoopSize   = 64;
+    constexpr uint32_t SubmittedJobs   = 10'000;
+    constexpr uint32_t GraphLayers     = 16;
+    constexpr uint32_t GraphWidth      = 16;
+    constexpr uint32_t Iterations      = 100;
+}
+
+// Times the scheduling the engine leans on every frame: one large ParallelFor, many small ones where
+// the overhead is most of the cost, fire-and-forget jobs, and a task graph shaped like layered work
+int main(int argc, char** argv)
+{
+    Core::JobSystem jobs;
+    spdlog::info("{} threads", jobs.GetConcurrency());
+
+    std::vector<float> input(ElementCount);
+    std::vector<float> output(ElementCount);
+    for (uint32_t i = 0; i < ElementCount; ++i)
+    {
+        input[i] = static_cast<float>(i);
+    }
+
+    Benchmark::Run("ParallelFor, 1M elements", Iterations, [&]
+    {
+        jobs.ParallelFor(ElementCount, 4096, [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                output[i] = std::sqrt(input[i]) * 0.5f + 1.0f;
+            }
+        });
+    });
+    Benchmark::Consume(output[ElementCount / 2]);
+
+    Benchmark::Run(fmt::format("ParallelFor, {} loops of {}", SmallLoopCount, SmallLoopSize), Iterations, [&]
+    {
+        for (uint32_t loop = 0; loop < SmallLoopCount; ++loop)
+        {
+            jobs.ParallelFor(SmallLoopSize, 1, [&](size_t begin, size_t end)
+            {
+                for (size_t i = begin; i < end; ++i)
+                {
+                    output[i] = input[i] + static_cast<float>(loop);
+                }
+            });
+        }
+    });
+
+    std::atomic<uint32_t> finishedJobs = 0;
+    Benchmark::Run(fmt::format("Submit {} jobs", SubmittedJobs), Iterations, [&]
+    {
+        finishedJobs.store(0, std::memory_order_relaxed);
+        for (uint32_t i = 0; i < SubmittedJobs; ++i)
+        {
+            jobs.Submit([&finishedJobs] { finishedJobs.fetch_add(1, std::memory_order_release); });
+        }
+        while (finishedJobs.load(std::memory_order_acquire) != SubmittedJobs)
+        {
+            std::this_thread::yield();
+        }
+    });
+
+    // Every task waits on two of the layer before it, so work fans out and joins again throughout
+    std::atomic<uint32_t> taskWork = 0;
+    Benchmark::Run(fmt::format("Task graph, {} tasks", GraphLayers * GraphWidth), Iterations, [&]
+    {
+        Core::TaskGraph graph;
+        std::array<Core::TaskGraph::TaskId, GraphWidth> previous{};
+        std::array<Core::TaskGraph::TaskId, GraphWidth> current{};
+        for (uint32_t layer = 0; layer < GraphLayers; ++layer)
+        {
+            for (uint32_t task = 0; task < GraphWidth; ++task)
+            {
+                auto function = [&taskWork]
+                {
+                    taskWork.fetch_add(1, std::memory_order_relaxed);
+                    return true;
+                };
+                current[task] = layer == 0
+                    ? graph.Add("Task", function)
+                    : graph.Add("Task", function, { previous[task], previous[(task + 1) % GraphWidth] });
+            }
+            previous = current;
+        }
+        graph.Run(&jobs);
+    });
+    Benchmark::Consume(taskWork.load());
+
+    return Benchmark::Finish(argc, argv, "JobSystemBenchmark");
+}
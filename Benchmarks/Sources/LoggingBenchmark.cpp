@@ -0,0 +1,101 @@
+// Debug and trace are stripped as in a release build, whatever this build is
+#undef MINIENGINE_ACTIVE_LOG_LEVEL
+#define MINIENGINE_ACTIVE_LOG_LEVEL MINIENGINE_LOG_LEVEL_INFO
+
+#include "Benchmark.hpp"
+
+#include <MiniEngine/Core/Log.hpp>
+
+#include <spdlog/sinks/basic_file_sink.h>
+#include <spdlog/spdlog.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+
+using namespace MiniEngine;
+
+namespace
+{
+    // One message per simulated frame, shaped like the per-frame messages of the renderer
+    constexpr uint32_t FramesPerIteration = 1000;
+    constexpr uint32_t Iterations         = 50;
+    constexpr uint32_t RateLimitMs        = 1000;
+}
+
+int main()
+{
+    // Written to a file rather than the console, so the terminal does not dominate the timings
+    const std::filesystem::path logPath = std::filesystem::temp_directory_path() / "MiniEngineLoggingBenchmark.log";
+    auto fileSink = std::make_shared<spdlog::sinks::basic_file_sink_mt>(logPath.string(), true);
+    spdlog::info("{} messages per iteration, written to {}", FramesPerIteration, logPath.string());
+
+    auto syncLogger = std::make_shared<spdlog::logger>("sync", fileSink);
+    syncLogger->set_level(spdlog::level::debug);
+
+    // Room for every message of the run, so the timings are the caller's cost alone and nothing is dropped
+    auto asyncSink = std::make_shared<Core::AsyncLogSink>(std::vector<spdlog::sink_ptr>{ fileSink }, FramesPerIteration * (Iterations + 1));
+    auto asyncLogger = std::make_shared<spdlog::logger>("async", asyncSink);
+    asyncLogger->set_level(spdlog::level::debug);
+
+    uint32_t imageIndex = 0;
+
+    const Benchmark::Result syncResult = Benchmark::Run("debug, synchronous sink", Iterations, [&]
+    {
+        for (uint32_t frame = 0; frame < FramesPerIteration; ++frame)
+        {
+            syncLogger->debug("Command buffer recorded successfully for image index {}", ++imageIndex % 3);
+        }
+    });
+
+    const Benchmark::Result asyncResult = Benchmark::Run("debug, async sink", Iterations, [&]
+    {
+        for (uint32_t frame = 0; frame < FramesPerIteration; ++frame)
+        {
+            asyncLogger->debug("Command buffer recorded successfully for image index {}", ++imageIndex % 3);
+        }
+    });
+    asyncSink->flush();
+    const Core::AsyncLogStats asyncStats = asyncSink->GetStats();
+    spdlog::info("  async sink wrote {} messages, dropped {}", asyncStats.written, asyncStats.dropped);
+
+    // The level check alone: the arguments are still evaluated and the call still made
+    syncLogger->set_level(spdlog::level::info);
+    const Benchmark::Result filteredResult = Benchmark::Run("debug, filtered at runtime", Iterations, [&]
+    {
+        for (uint32_t frame = 0; frame < FramesPerIteration; ++frame)
+        {
+            syncLogger->debug("Command buffer recorded successfully for image index {}", ++imageIndex % 3);
+        }
+    });
+
+    const Benchmark::Result strippedResult = Benchmark::Run("debug, stripped at compile time", Iterations, [&]
+    {
+        for (uint32_t frame = 0; frame < FramesPerIteration; ++frame)
+        {
+            MINIENGINE_LOG_DEBUG("Command buffer recorded successfully for image index {}", ++imageIndex % 3);
+        }
+        Benchmark::Consume(imageIndex);
+    });
+
+    // Goes to the console, about once a second
+    const Benchmark::Result limitedResult = Benchmark::Run("info, rate limited", Iterations, [&]
+    {
+        for (uint32_t frame = 0; frame < FramesPerIteration; ++frame)
+        {
+            MINIENGINE_LOG_INFO_RATE_LIMITED(RateLimitMs, "Command buffer recorded successfully for image index {}", ++imageIndex % 3);
+        }
+    });
+
+    for (const Benchmark::Result* result : { &syncResult, &asyncResult, &filteredResult, &strippedResult, &limitedResult })
+    {
+        spdlog::info("{:<40} {:9.1f} ns per frame", result->name, result->averageMs * 1e6 / FramesPerIteration);
+    }
+
+    asyncLogger.reset();
+    asyncSink.reset();
+    syncLogger.reset();
+    fileSink.reset();
+    std::filesystem::remove(logPath);
+    return 0;
+}
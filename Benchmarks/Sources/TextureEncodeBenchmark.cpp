@@ -0,0 +1,140 @@
+#include "Benchmark.hpp"
+
+#include <MiniEngine/Core/CpuFeatures.hpp>
+#include <MiniEngine/Core/JobSystem.hpp>
+#include <MiniEngine/Graphics/TextureEncoder.hpp>
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <random>
+#include <utility>
+#include <vector>
+
+using namespace MiniEngine;
+
+namespace
+{
+    constexpr uint32_t ImageSize  = 1024;
+    constexpr uint32_t Iterations = 3;
+
+    constexpr Graphics::TextureFormat Formats[] = {
+        Graphics::TextureFormat::Bc1RgbaSrgb,
+        Graphics::TextureFormat::Bc3Srgb,
+        Graphics::TextureFormat::Bc4Unorm,
+        Graphics::TextureFormat::Bc5Unorm,
+        Graphics::TextureFormat::Bc7Srgb,
+    };
+
+    // Smooth gradients with some grain and a few hard edges, so blocks are neither flat nor noise.
+    // The top half is opaque, as most colour textures are.
+    std::vector<uint8_t> CreateImage()
+    {
+        std::mt19937 random(11);
+        std::uniform_int_distribution<int> grain(-6, 6);
+
+        std::vector<uint8_t> rgba(static_cast<size_t>(ImageSize) * ImageSize * 4);
+        for (uint32_t y = 0; y < ImageSize; ++y)
+        {
+            for (uint32_t x = 0; x < ImageSize; ++x)
+            {
+                const bool stripe = ((x / 37) + (y / 53)) % 5 == 0;
+                const int base[4] = {
+                    static_cast<int>(128.0f + 100.0f * std::sin(x * 0.013f)),
+                    static_cast<int>(y * 255 / ImageSize),
+                    stripe ? 230 : static_cast<int>(64.0f + 60.0f * std::cos((x + y) * 0.02f)),
+                    y < ImageSize / 2 ? 255 : static_cast<int>(255 - x * 128 / ImageSize),
+                };
+                uint8_t* texel = &rgba[(static_cast<size_t>(y) * ImageSize + x) * 4];
+                for (int c = 0; c < 4; ++c)
+                {
+                    texel[c] = static_cast<uint8_t>(std::clamp(base[c] + grain(random), 0, 255));
+                }
+            }
+        }
+        return rgba;
+    }
+}
+
+// Times block compression of one 1024x1024 image into every format the encoder writes: each kernel
+// on one thread, then the widest on the job system, reporting megapixels per second and the PSNR of
+// what it wrote at every quality. Fails when a kernel's blocks differ from the scalar ones, or when
+// BC7 comes out worse than BC3 at any quality.
+int main(int argc, char** argv)
+{
+    int exitCode = 0;
+    std::map<std::pair<Graphics::TextureFormat, Graphics::TextureEncodeQuality>, double> psnrs;
+
+    Core::JobSystem jobs;
+    spdlog::info("{}x{} image, best kernel: {}, parallel encoding on {} threads",
+        ImageSize, ImageSize, Core::ToString(Core::GetSupportedSimdLevel()), jobs.GetConcurrency());
+
+    const std::vector<uint8_t> image = CreateImage();
+    const double megapixels = static_cast<double>(ImageSize) * ImageSize / 1e6;
+    std::vector<uint8_t> decoded(image.size());
+
+    for (Graphics::TextureFormat format : Formats)
+    {
+        std::vector<uint8_t> blocks(Graphics::GetTextureLevelSize(format, ImageSize, ImageSize));
+        std::vector<uint8_t> scalarBlocks;
+
+        for (Core::SimdLevel level : { Core::SimdLevel::Scalar, Core::SimdLevel::Sse, Core::SimdLevel::Avx2 })
+        {
+            if (level > Core::GetSupportedSimdLevel())
+            {
+                spdlog::info("{} not supported on this CPU, skipped", Core::ToString(level));
+                continue;
+            }
+
+            const Graphics::TextureEncoder encoder(level);
+            const Benchmark::Result result = Benchmark::Run(fmt::format("{} {}", Graphics::ToString(format), Core::ToString(level)), Iterations, [&]
+            {
+                encoder.Encode(format, Graphics::TextureEncodeQuality::Normal, image.data(), ImageSize, ImageSize, blocks.data());
+            });
+            spdlog::info("  {:.1f} MP/s", megapixels / (result.minMs / 1000.0));
+
+            if (level == Core::SimdLevel::Scalar)
+            {
+                scalarBlocks = blocks;
+            }
+            else if (std::memcmp(blocks.data(), scalarBlocks.data(), blocks.size()) != 0)
+            {
+                spdlog::error("{} blocks from the {} kernel differ from the scalar ones", Graphics::ToString(format), Core::ToString(level));
+                exitCode = 1;
+            }
+        }
+
+        const Graphics::TextureEncoder encoder;
+        for (Graphics::TextureEncodeQuality quality : { Graphics::TextureEncodeQuality::Fast, Graphics::TextureEncodeQuality::Normal, Graphics::TextureEncodeQuality::High })
+        {
+            const Benchmark::Result result = Benchmark::Run(fmt::format("{}, {} quality, job system", Graphics::ToString(format), Graphics::ToString(quality)), Iterations, [&]
+            {
+                encoder.Encode(format, quality, image.data(), ImageSize, ImageSize, blocks.data(), &jobs);
+            });
+
+            Graphics::DecodeTexture(format, blocks.data(), ImageSize, ImageSize, decoded.data());
+            const double psnr = Graphics::ComputePsnr(image.data(), decoded.data(), ImageSize, ImageSize, Graphics::GetEncodedChannelCount(format));
+            psnrs[{ format, quality }] = psnr;
+            spdlog::info("  {:.1f} MP/s, PSNR {:.2f} dB", megapixels / (result.minMs / 1000.0), psnr);
+        }
+    }
+
+    // BC7 spends the same 16 bytes as BC3 with finer endpoints and indices, so it should never lose
+    for (Graphics::TextureEncodeQuality quality : { Graphics::TextureEncodeQuality::Fast, Graphics::TextureEncodeQuality::Normal, Graphics::TextureEncodeQuality::High })
+    {
+        const double bc3 = psnrs[{ Graphics::TextureFormat::Bc3Srgb, quality }];
+        const double bc7 = psnrs[{ Graphics::TextureFormat::Bc7Srgb, quality }];
+        if (bc7 < bc3)
+        {
+            spdlog::error("BC7 PSNR {:.2f} dB is below BC3's {:.2f} dB at {} quality", bc7, bc3, Graphics::ToString(quality));
+            exitCode = 1;
+        }
+    }
+
+    const int result = Benchmark::Finish(argc, argv, "TextureEncodeBenchmark");
+    return exitCode != 0 ? exitCode : result;
+}
@@ -0,0 +1,176 @@
+#include "Benchmark.hpp"
+
+#include <MiniEngine/Core/JobSystem.hpp>
+#include <MiniEngine/Graphics/TextureFile.hpp>
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace MiniEngine;
+
+namespace
+{
+    constexpr uint32_t SyntheticTextureCount = 400;
+    constexpr uint32_t Iterations            = 5;
+
+    struct SyntheticTexture
+    {
+        Graphics::TextureFormat    format;
+        Graphics::TextureContainer container;
+        uint32_t                   size;
+        bool                       fullMipChain;
+    };
+
+    // What a scene's texture directory tends to hold: mostly block compressed colour and normal maps,
+    // some uncompressed textures that only store their top level and get their mips on the GPU
+    constexpr SyntheticTexture SyntheticKinds[] = {
+        { Graphics::TextureFormat::Bc1RgbaSrgb,   Graphics::TextureContainer::Ktx2, 512, true  },
+        { Graphics::TextureFormat::Bc3Srgb,       Graphics::TextureContainer::Dds,  512, true  },
+        { Graphics::TextureFormat::Bc7Srgb,       Graphics::TextureContainer::Ktx2, 512, true  },
+        { Graphics::TextureFormat::Bc5Unorm,      Graphics::TextureContainer::Dds,  512, true  },
+        { Graphics::TextureFormat::R8G8B8A8Srgb,  Graphics::TextureContainer::Ktx2, 256, false },
+    };
+
+    std::vector<std::filesystem::path> WriteSyntheticTextures(const std::filesystem::path& directory)
+    {
+        std::filesystem::create_directories(directory);
+
+        std::mt19937 random(42);
+        std::vector<uint8_t> data;
+        std::vector<std::filesystem::path> paths;
+        for (uint32_t i = 0; i < SyntheticTextureCount; ++i)
+        {
+            const SyntheticTexture& kind = SyntheticKinds[i % std::size(SyntheticKinds)];
+            const uint32_t levelCount = kind.fullMipChain ? Graphics::GetFullMipCount(kind.size, kind.size) : 1;
+            const Graphics::TextureDescription description = Graphics::MakeTextureDescription(kind.format, kind.size, kind.size, levelCount);
+
+            data.resize(description.dataSize);
+            std::generate(data.begin(), data.end(), [&] { return static_cast<uint8_t>(random()); });
+
+            const char* extension = kind.container == Graphics::TextureContainer::Ktx2 ? ".ktx2" : ".dds";
+            std::filesystem::path path = directory / fmt::format("texture{:03}{}", i, extension);
+            if (!Graphics::WriteTextureFile(path, kind.container, description, data.data()))
+            {
+                return {};
+            }
+            paths.push_back(std::move(path));
+        }
+        return paths;
+    }
+
+    std::vector<std::filesystem::path> ListTextures(const std::filesystem::path& directory)
+    {
+        std::vector<std::filesystem::path> paths;
+        for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(directory))
+        {
+            const std::filesystem::path extension = entry.path().extension();
+            if (entry.is_regular_file() && (extension == ".ktx2" || extension == ".dds"))
+            {
+                paths.push_back(entry.path());
+            }
+        }
+        std::sort(paths.begin(), paths.end());
+        return paths;
+    }
+
+    bool ReadTexture(const std::filesystem::path& path, std::vector<uint8_t>& destination)
+    {
+        Graphics::TextureFile file;
+        if (!file.Open(path))
+        {
+            return false;
+        }
+        destination.resize(file.GetDescription().dataSize);
+        return file.ReadLevels(destination.data());
+    }
+}
+
+// Times what the renderer's texture loader does on the CPU: parsing headers and reading levels into
+// upload memory, on one thread and spread over the job system. Pass a directory to measure real files;
+// otherwise a synthetic set is written to the temp directory and removed afterwards. Files are read
+// from the page cache after the first iteration, so this measures parsing and copying, not the disk.
+int main(int argc, char** argv)
+{
+    const bool synthetic = argc < 2;
+    const std::filesystem::path directory = synthetic
+        ? std::filesystem::temp_directory_path() / "MiniEngineTextureLoadBenchmark"
+        : std::filesystem::path(argv[1]);
+
+    const std::vector<std::filesystem::path> paths = synthetic ? WriteSyntheticTextures(directory) : ListTextures(directory);
+    if (paths.empty())
+    {
+        spdlog::error("No textures to load in {}", directory.string());
+        return 1;
+    }
+
+    // Every buffer is sized up front, as the staging buffers are, so allocation stays out of the timings
+    uint64_t totalBytes = 0;
+    uint32_t generatedMipTextures = 0;
+    std::vector<std::vector<uint8_t>> buffers(paths.size());
+    for (size_t i = 0; i < paths.size(); ++i)
+    {
+        if (!ReadTexture(paths[i], buffers[i]))
+        {
+            return 1;
+        }
+        totalBytes += buffers[i].size();
+    }
+    for (const std::filesystem::path& path : paths)
+    {
+        Graphics::TextureFile file;
+        file.Open(path);
+        generatedMipTextures += file.GetDescription().generateMips ? 1 : 0;
+    }
+    const double totalMiB = totalBytes / (1024.0 * 1024.0);
+    spdlog::info("{} textures, {:.1f} MiB of levels, {} leave their mips to the GPU, from {}",
+        paths.size(), totalMiB, generatedMipTextures, directory.string());
+
+    Benchmark::Run("open headers", Iterations, [&]
+    {
+        uint32_t levels = 0;
+        for (const std::filesystem::path& path : paths)
+        {
+            Graphics::TextureFile file;
+            file.Open(path);
+            levels += static_cast<uint32_t>(file.GetDescription().levels.size());
+        }
+        Benchmark::Consume(levels);
+    });
+
+    const Benchmark::Result serial = Benchmark::Run("open and read, 1 thread", Iterations, [&]
+    {
+        for (size_t i = 0; i < paths.size(); ++i)
+        {
+            ReadTexture(paths[i], buffers[i]);
+        }
+    });
+
+    Core::JobSystem jobs;
+    const Benchmark::Result parallel = Benchmark::Run(fmt::format("open and read, job system ({})", jobs.GetConcurrency()), Iterations, [&]
+    {
+        jobs.ParallelFor(paths.size(), 4, [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                ReadTexture(paths[i], buffers[i]);
+            }
+        });
+    });
+
+    spdlog::info("Throughput: {:.0f} MiB/s on 1 thread, {:.0f} MiB/s on the job system ({} threads), {:.2f} ms per texture serially",
+        totalMiB / (serial.averageMs / 1000.0), totalMiB / (parallel.averageMs / 1000.0), jobs.GetConcurrency(),
+        serial.averageMs / paths.size());
+
+    if (synthetic)
+    {
+        std::error_code error;
+        std::filesystem::remove_all(directory, error);
+    }
+    return 0;
+}
@@ -0,0 +1,395 @@
+#include "Benchmark.hpp"
+#include "VulkanHeadless.hpp"
+
+#include <MiniEngine/Graphics/VulkanCommandEncoder.hpp>
+#include <MiniEngine/Graphics/VulkanContext.hpp>
+#include <MiniEngine/Graphics/VulkanDebugUtils.hpp>
+#include <MiniEngine/Graphics/VulkanFrameReadback.hpp>
+#include <MiniEngine/Graphics/VulkanMemory.hpp>
+#include <MiniEngine/Graphics/VulkanQueues.hpp>
+
+#include <glm/glm.hpp>
+#include <spdlog/spdlog.h>
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+#include <vector>
+
+using namespace MiniEngine;
+using namespace Headless;
+
+namespace
+{
+    constexpr uint32_t ObjectCount        = 10'000;
+    constexpr uint32_t ObjectsPerLabel    = 1000; // About the objects a labelled pass of the frame draws
+    constexpr uint32_t GeometryBuffers    = 8;
+    constexpr uint32_t UploadMiB          = 64;
+    constexpr uint32_t AllocationCount    = 1000;
+    constexpr uint32_t RecordIterations   = 200;
+    constexpr uint32_t SubmitIterations   = 500;
+    constexpr uint32_t UploadIterations   = 20;
+    constexpr uint32_t AllocateIterations = 50;
+    constexpr uint32_t FrameIterations    = 300;
+    constexpr uint32_t LevelIterations    = 20; // Full validation checks every command, so each level gets fewer
+    constexpr VkExtent2D FrameExtent      = { 1920, 1080 };
+
+    // What the per-object recordings bind. Without shaders there is no pipeline to draw with, so
+    // recording measures writing the command stream rather than draw validation.
+    struct ObjectScene
+    {
+        VkPipelineLayout layout = VK_NULL_HANDLE;
+        std::array<Buffer, GeometryBuffers> geometry;
+        std::vector<glm::mat4> transforms;
+    };
+
+    bool CreateObjectScene(Context& context, ObjectScene& scene)
+    {
+        VkPushConstantRange pushConstants{ VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::mat4) };
+        VkPipelineLayoutCreateInfo layoutInfo{};
+        layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        layoutInfo.pushConstantRangeCount = 1;
+        layoutInfo.pPushConstantRanges = &pushConstants;
+        if (vkCreatePipelineLayout(context.device.device, &layoutInfo, nullptr, &scene.layout) != VK_SUCCESS)
+        {
+            spdlog::error("Failed to create pipeline layout");
+            return false;
+        }
+        for (Buffer& buffer : scene.geometry)
+        {
+            if (!CreateBuffer(context, buffer, 64 * 1024, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, false))
+            {
+                return false;
+            }
+        }
+
+        scene.transforms.resize(ObjectCount);
+        for (uint32_t i = 0; i < ObjectCount; ++i)
+        {
+            scene.transforms[i] = glm::mat4(1.0f);
+            scene.transforms[i][3] = glm::vec4(static_cast<float>(i % 100), 0.0f, static_cast<float>(i / 100), 1.0f);
+        }
+        return true;
+    }
+
+    void DestroyObjectScene(Context& context, ObjectScene& scene)
+    {
+        for (Buffer& buffer : scene.geometry)
+        {
+            DestroyBuffer(context, buffer);
+        }
+        if (scene.layout != VK_NULL_HANDLE)
+        {
+            vkDestroyPipelineLayout(context.device.device, scene.layout, nullptr);
+            scene.layout = VK_NULL_HANDLE;
+        }
+    }
+
+    // The binds and push constants a frame issues per object, with a label around each pass's worth.
+    // Unloaded debug utils label nothing, so the same recording measures both with and without labels.
+    bool RecordObjects(Context& context, const ObjectScene& scene, Graphics::VulkanCommandEncoder& encoder,
+        const Graphics::VulkanDebugUtils& debugUtils, VkCommandBufferUsageFlags flags)
+    {
+        if (!BeginCommands(context, flags))
+        {
+            return false;
+        }
+        encoder.Begin(context.commandBuffer);
+        const VkViewport viewport{ 0.0f, 0.0f, 1920.0f, 1080.0f, 0.0f, 1.0f };
+        const VkRect2D scissor{ { 0, 0 }, { 1920, 1080 } };
+        encoder.SetViewport(0, 1, &viewport);
+        encoder.SetScissor(0, 1, &scissor);
+        for (uint32_t i = 0; i < ObjectCount; ++i)
+        {
+            if (i % ObjectsPerLabel == 0)
+            {
+                debugUtils.BeginLabel(context.commandBuffer, "Objects");
+            }
+            const VkDeviceSize offset = (i % 64) * 1024;
+            encoder.BindVertexBuffers(0, 1, &scene.geometry[i % GeometryBuffers].buffer, &offset);
+            encoder.BindIndexBuffer(scene.geometry[(i / 4) % GeometryBuffers].buffer, 0, VK_INDEX_TYPE_UINT16);
+            encoder.PushConstants(scene.layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::mat4), &scene.transforms[i]);
+            if (i % ObjectsPerLabel == ObjectsPerLabel - 1 || i == ObjectCount - 1)
+            {
+                debugUtils.EndLabel(context.commandBuffer);
+            }
+        }
+        return vkEndCommandBuffer(context.commandBuffer) == VK_SUCCESS;
+    }
+
+    // The same frame's recording and submit on an instance of its own at every instrumentation level,
+    // so one run gives what each level costs over none. A level the loader cannot provide is left
+    // out rather than measured at a lower one under its name. Returns false if a Vulkan call failed.
+    bool MeasureInstrumentationLevels(bool cpuDevice)
+    {
+        using Graphics::InstrumentationLevel;
+        double offMs = 0.0;
+        bool failed = false;
+        for (InstrumentationLevel level : { InstrumentationLevel::Off, InstrumentationLevel::Labels,
+                 InstrumentationLevel::Validation, InstrumentationLevel::FullValidation })
+        {
+            Context context;
+            ObjectScene scene;
+            if (!CreateContext(context, "VulkanBenchmark", cpuDevice, level) || !CreateObjectScene(context, scene))
+            {
+                DestroyObjectScene(context, scene);
+                DestroyContext(context);
+                return false;
+            }
+
+            if (context.instrumentation == level)
+            {
+                Graphics::VulkanCommandEncoder encoder;
+                const Benchmark::Result result = Benchmark::Run(fmt::format("Record and submit {} objects, {}", ObjectCount, Graphics::ToString(level)),
+                    LevelIterations, [&]
+                {
+                    failed |= !RecordObjects(context, scene, encoder, context.debugUtils, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT) ||
+                        !SubmitAndWait(context);
+                });
+                if (level == InstrumentationLevel::Off)
+                {
+                    offMs = result.minMs;
+                }
+                else if (offMs > 0.0)
+                {
+                    spdlog::info("  {:+.3f} ms over off ({:+.0f}%)", result.minMs - offMs, 100.0 * (result.minMs - offMs) / offMs);
+                }
+            }
+            else
+            {
+                spdlog::warn("Instrumentation level {} is not available here, not measured", Graphics::ToString(level));
+            }
+
+            DestroyObjectScene(context, scene);
+            DestroyContext(context);
+        }
+        return !failed;
+    }
+}
+
+// Times the renderer's per-frame work against the driver: recording per-object state into a command
+// buffer, with and without debug labels, a submit and fence round trip, re-recording against reusing a
+// recording, staging uploads, VMA allocation churn, and frames with and without frame capture; then
+// recording and submitting once more at every instrumentation level, each on an instance of its own.
+// --device cpu picks a CPU implementation such as lavapipe, which is what the checked-in baseline is
+// recorded on. --instrumentation off|labels|validation|full picks the level the instance for the
+// other cases is created with, labels by default, which is what the baseline is recorded at.
+int main(int argc, char** argv)
+{
+    bool cpuDevice = false;
+    Graphics::InstrumentationLevel instrumentation = Graphics::InstrumentationLevel::Labels;
+    for (int i = 1; i + 1 < argc; ++i)
+    {
+        cpuDevice |= std::strcmp(argv[i], "--device") == 0 && std::strcmp(argv[i + 1], "cpu") == 0;
+        if (std::strcmp(argv[i], "--instrumentation") == 0 && !Graphics::ParseInstrumentationLevel(argv[i + 1], instrumentation))
+        {
+            spdlog::error("Invalid value '{}' for --instrumentation", argv[i + 1]);
+            return 1;
+        }
+    }
+
+    Context context;
+    if (!CreateContext(context, "VulkanBenchmark", cpuDevice, instrumentation))
+    {
+        DestroyContext(context);
+        return 1;
+    }
+    VkDevice device = context.device.device;
+    bool failed = false;
+
+    // Recording the objects of a frame, with and without labels, then submitting it or a kept recording
+    ObjectScene scene;
+    failed |= !CreateObjectScene(context, scene);
+    Graphics::VulkanCommandEncoder encoder;
+    const Graphics::VulkanDebugUtils noLabels;
+    auto recordObjects = [&](const Graphics::VulkanDebugUtils& debugUtils, VkCommandBufferUsageFlags flags)
+    {
+        failed |= !RecordObjects(context, scene, encoder, debugUtils, flags);
+    };
+
+    if (!failed)
+    {
+        Benchmark::Run(fmt::format("Record {} objects", ObjectCount), RecordIterations, [&]
+        {
+            recordObjects(noLabels, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+        });
+        if (context.debugUtils.IsEnabled())
+        {
+            Benchmark::Run(fmt::format("Record {} objects, labelled", ObjectCount), RecordIterations, [&]
+            {
+                recordObjects(context.debugUtils, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+            });
+        }
+
+        // What a frame pays for its commands when it records them again, against submitting the
+        // recording it kept; the renderer reuses recordings while nothing they depend on changes
+        Benchmark::Run(fmt::format("Record and submit {} objects", ObjectCount), RecordIterations, [&]
+        {
+            recordObjects(context.debugUtils, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+            failed |= !SubmitAndWait(context);
+        });
+        recordObjects(context.debugUtils, 0);
+        Benchmark::Run(fmt::format("Submit {} objects, reused", ObjectCount), RecordIterations, [&]
+        {
+            failed |= !SubmitAndWait(context);
+        });
+
+        // An empty command buffer, so the timing is the submit and fence round trip alone
+        failed |= !BeginCommands(context, 0) || vkEndCommandBuffer(context.commandBuffer) != VK_SUCCESS;
+        Benchmark::Run("Submit and wait, empty", SubmitIterations, [&]
+        {
+            failed |= !SubmitAndWait(context);
+        });
+    }
+
+    // Uploads: writing a staging buffer and copying it to device memory, as texture and mesh uploads do
+    const VkDeviceSize uploadSize = static_cast<VkDeviceSize>(UploadMiB) * 1024 * 1024;
+    Buffer staging;
+    Buffer destination;
+    std::vector<uint8_t> source(uploadSize);
+    for (size_t i = 0; i < source.size(); ++i)
+    {
+        source[i] = static_cast<uint8_t>(i * 31);
+    }
+    failed |= !CreateBuffer(context, staging, uploadSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, true) ||
+        !CreateBuffer(context, destination, uploadSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT, false);
+    if (!failed)
+    {
+        const Benchmark::Result upload = Benchmark::Run(fmt::format("Upload {} MiB through staging", UploadMiB), UploadIterations, [&]
+        {
+            std::memcpy(staging.mapped, source.data(), source.size());
+            vmaFlushAllocation(context.memory.GetAllocator(), staging.allocation, 0, VK_WHOLE_SIZE);
+            failed |= !BeginCommands(context);
+            const VkBufferCopy copy{ 0, 0, uploadSize };
+            vkCmdCopyBuffer(context.commandBuffer, staging.buffer, destination.buffer, 1, &copy);
+            failed |= vkEndCommandBuffer(context.commandBuffer) != VK_SUCCESS || !SubmitAndWait(context);
+        });
+        spdlog::info("  {:.0f} MiB/s at best", UploadMiB / (upload.minMs / 1000.0));
+    }
+
+    // Allocation churn in the sizes of meshes and per-frame buffers
+    std::vector<Buffer> allocations(AllocationCount);
+    if (!failed)
+    {
+        Benchmark::Run(fmt::format("Allocate and free {} buffers", AllocationCount), AllocateIterations, [&]
+        {
+            for (uint32_t i = 0; i < AllocationCount; ++i)
+            {
+                const VkDeviceSize size = (4 + (i * 37) % 252) * 1024;
+                failed |= !CreateBuffer(context, allocations[i], size, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, false);
+            }
+            for (Buffer& buffer : allocations)
+            {
+                DestroyBuffer(context, buffer);
+            }
+        });
+    }
+
+    // Frame capture: what copying every presented frame out costs the render thread, a clear standing
+    // in for the frame. The image writer runs beside it as it does in the renderer, so frames arriving
+    // while every slot is still being written are skipped rather than waited for.
+    const Graphics::VulkanContext vulkanContext = CreateModuleContext(context, {});
+
+    VkImageCreateInfo imageInfo{};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+    imageInfo.extent = { FrameExtent.width, FrameExtent.height, 1 };
+    imageInfo.mipLevels = 1;
+    imageInfo.arrayLayers = 1;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    VkImage frameImage = VK_NULL_HANDLE;
+    VmaAllocation frameAllocation = VK_NULL_HANDLE;
+    const VkImageSubresourceRange frameRange{ VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+    if (!failed && !context.memory.CreateImage(imageInfo, Graphics::MemoryCategory::RenderTargets, frameImage, frameAllocation))
+    {
+        spdlog::error("Failed to create a {}x{} frame image", FrameExtent.width, FrameExtent.height);
+        failed = true;
+    }
+    if (!failed)
+    {
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = frameImage;
+        barrier.subresourceRange = frameRange;
+        failed |= !BeginCommands(context);
+        vkCmdPipelineBarrier(context.commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0, 0, nullptr, 0, nullptr, 1, &barrier);
+        failed |= vkEndCommandBuffer(context.commandBuffer) != VK_SUCCESS || !SubmitAndWait(context);
+    }
+
+    const std::filesystem::path captureDirectory = std::filesystem::temp_directory_path() / "VulkanBenchmarkFrames";
+    Graphics::FrameReadbackInfo readbackInfo;
+    readbackInfo.directory = captureDirectory;
+    readbackInfo.fileFormat = Graphics::ImageFileFormat::Pam;
+    readbackInfo.imageFormat = imageInfo.format;
+    readbackInfo.extent = FrameExtent;
+    Graphics::VulkanFrameReadback readback;
+    if (!failed && !readback.Initialize(vulkanContext, readbackInfo))
+    {
+        failed = true;
+    }
+    if (!failed)
+    {
+        uint32_t frame = 0;
+        auto renderFrame = [&]
+        {
+            // Every submission is waited for, so the frame's previous copy has always finished
+            readback.ReadResults(frame);
+            failed |= !BeginCommands(context);
+            const VkClearColorValue color{ { static_cast<float>(frame), 0.25f, 0.5f, 1.0f } };
+            vkCmdClearColorImage(context.commandBuffer, frameImage, VK_IMAGE_LAYOUT_GENERAL, &color, 1, &frameRange);
+            failed |= vkEndCommandBuffer(context.commandBuffer) != VK_SUCCESS ||
+                !SubmitAndWait(context, readback.Record(frame, frameImage, FrameExtent, VK_IMAGE_LAYOUT_GENERAL));
+            frame = (frame + 1) % FramesInFlight;
+        };
+
+        const Benchmark::Result uncaptured = Benchmark::Run(fmt::format("Frame {}x{}, not captured", FrameExtent.width, FrameExtent.height),
+            FrameIterations, renderFrame);
+        readback.SetEnabled(true);
+        const Benchmark::Result captured = Benchmark::Run(fmt::format("Frame {}x{}, captured", FrameExtent.width, FrameExtent.height),
+            FrameIterations, renderFrame);
+        readback.SetEnabled(false);
+        for (uint32_t i = 0; i < FramesInFlight; ++i)
+        {
+            readback.ReadResults(i);
+        }
+
+        const Graphics::FrameReadbackStats& captureStats = readback.GetStats();
+        const Graphics::ImageSequenceStats writerStats = readback.GetWriterStats();
+        spdlog::info("  capture costs the render thread {:+.3f} ms a frame at best, {:+.3f} ms on average",
+            captured.minMs - uncaptured.minMs, captured.averageMs - uncaptured.averageMs);
+        spdlog::info("  {} captured, {} skipped, {:.3f} ms to write each on the writer thread", captureStats.copied, captureStats.skipped,
+            writerStats.written > 0 ? writerStats.encodeMs / writerStats.written : 0.0);
+    }
+
+    vkDeviceWaitIdle(device);
+    readback.Destroy();
+    std::error_code removeError;
+    std::filesystem::remove_all(captureDirectory, removeError);
+    context.memory.DestroyImage(frameImage, frameAllocation);
+    DestroyBuffer(context, staging);
+    DestroyBuffer(context, destination);
+    DestroyObjectScene(context, scene);
+    DestroyContext(context);
+
+    failed = failed || !MeasureInstrumentationLevels(cpuDevice);
+
+    if (failed)
+    {
+        spdlog::error("A Vulkan call failed, the timings are not meaningful");
+        return 1;
+    }
+    return Benchmark::Finish(argc, argv, "VulkanBenchmark");
+}
@@ -0,0 +1,332 @@
+#pragma once
+
+#include <vk_mem_alloc.h>
+#include <VkBootstrap.h>
+
+#include <MiniEngine/Graphics/VulkanContext.hpp>
+#include <MiniEngine/Graphics/VulkanDebugUtils.hpp>
+#include <MiniEngine/Graphics/VulkanMemory.hpp>
+#include <MiniEngine/Graphics/VulkanQueues.hpp>
+
+#include <spdlog/spdlog.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+
+// A Vulkan device without a window for the GPU benchmarks, so they run where there is no display
+namespace Headless
+{
+    constexpr uint32_t FramesInFlight = 2;
+
+    struct Context
+    {
+        vkb::Instance   instance;
+        vkb::Device     device;
+        MiniEngine::Graphics::InstrumentationLevel instrumentation = MiniEngine::Graphics::InstrumentationLevel::Off; // What the instance was created with
+        MiniEngine::Graphics::VulkanDebugUtils     debugUtils;
+        VkQueue         queue         = VK_NULL_HANDLE;
+        MiniEngine::Graphics::VulkanMemory memory;
+        MiniEngine::Graphics::VulkanQueues queues;
+        VkCommandPool   commandPool   = VK_NULL_HANDLE;
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+        VkFence         fence         = VK_NULL_HANDLE;
+    };
+
+    struct Buffer
+    {
+        VkBuffer      buffer     = VK_NULL_HANDLE;
+        VmaAllocation allocation = VK_NULL_HANDLE;
+        void*         mapped     = nullptr;
+    };
+
+    // A CPU device is lavapipe on the machines that record baselines. Instrumented as the renderer is
+    // at the same level, minus the debug messenger, whose output is not part of what is measured.
+    // Levels the loader cannot provide are lowered to what it can. indirectDraws requires what the
+    // renderer's occlusion culling draws with, as the application's device does.
+    inline bool CreateContext(Context& context, const char* name, bool cpuDevice, MiniEngine::Graphics::InstrumentationLevel instrumentation,
+        bool indirectDraws = false)
+    {
+        using MiniEngine::Graphics::InstrumentationLevel;
+        auto systemInfo = vkb::SystemInfo::get_system_info();
+        if (!systemInfo)
+        {
+            spdlog::error("Failed to query the Vulkan loader: {}", systemInfo.error().message());
+            return false;
+        }
+        if (instrumentation >= InstrumentationLevel::Validation && !systemInfo.value().validation_layers_available)
+        {
+            spdlog::warn("The validation layer is not installed, measuring with labels only");
+            instrumentation = InstrumentationLevel::Labels;
+        }
+        if (instrumentation >= InstrumentationLevel::Labels && !systemInfo.value().debug_utils_available)
+        {
+            spdlog::warn("{} is not available, measuring without labels", VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+            instrumentation = InstrumentationLevel::Off;
+        }
+
+        vkb::InstanceBuilder instanceBuilder;
+        instanceBuilder.set_app_name(name)
+            .set_engine_name("MiniEngine")
+            .require_api_version(1, 2, 0)
+            .set_headless(true);
+        if (instrumentation >= InstrumentationLevel::Labels)
+        {
+            instanceBuilder.enable_extension(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+        }
+        if (instrumentation >= InstrumentationLevel::Validation)
+        {
+            instanceBuilder.request_validation_layers(true);
+        }
+        if (instrumentation >= InstrumentationLevel::FullValidation)
+        {
+            instanceBuilder.add_validation_feature_enable(VK_VALIDATION_FEATURE_ENABLE_SYNCHRONIZATION_VALIDATION_EXT)
+                .add_validation_feature_enable(VK_VALIDATION_FEATURE_ENABLE_GPU_ASSISTED_EXT)
+                .add_validation_feature_enable(VK_VALIDATION_FEATURE_ENABLE_GPU_ASSISTED_RESERVE_BINDING_SLOT_EXT);
+        }
+        auto instanceResult = instanceBuilder.build();
+        if (!instanceResult)
+        {
+            spdlog::error("Failed to create Vulkan instance: {}", instanceResult.error().message());
+            return false;
+        }
+        context.instance = instanceResult.value();
+        context.instrumentation = instrumentation;
+        spdlog::info("Instrumentation: {}", MiniEngine::Graphics::ToString(instrumentation));
+
+        vkb::PhysicalDeviceSelector selector{ context.instance };
+        selector.set_minimum_version(1, 2);
+        if (cpuDevice)
+        {
+            selector.prefer_gpu_device_type(vkb::PreferredDeviceType::cpu)
+                .allow_any_gpu_device_type(false);
+        }
+        if (indirectDraws)
+        {
+            VkPhysicalDeviceFeatures requiredFeatures{};
+            requiredFeatures.multiDrawIndirect = VK_TRUE;
+            requiredFeatures.drawIndirectFirstInstance = VK_TRUE;
+            VkPhysicalDeviceVulkan12Features requiredFeatures12{};
+            requiredFeatures12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+            requiredFeatures12.drawIndirectCount = VK_TRUE;
+            selector.set_required_features(requiredFeatures)
+                .set_required_features_12(requiredFeatures12);
+        }
+        auto physicalDeviceResult = selector.select();
+        if (!physicalDeviceResult)
+        {
+            spdlog::error("Failed to select a {}device: {}", cpuDevice ? "CPU " : "", physicalDeviceResult.error().message());
+            return false;
+        }
+        spdlog::info("Device: {}", physicalDeviceResult.value().name);
+
+        auto deviceResult = vkb::DeviceBuilder{ physicalDeviceResult.value() }.build();
+        if (!deviceResult)
+        {
+            spdlog::error("Failed to create logical device: {}", deviceResult.error().message());
+            return false;
+        }
+        context.device = deviceResult.value();
+        context.debugUtils.Load(context.instance.instance, context.device.device, instrumentation);
+
+        auto queueResult = context.device.get_queue(vkb::QueueType::graphics);
+        auto queueIndexResult = context.device.get_queue_index(vkb::QueueType::graphics);
+        if (!queueResult || !queueIndexResult)
+        {
+            spdlog::error("Failed to get graphics queue");
+            return false;
+        }
+        context.queue = queueResult.value();
+
+        VmaAllocatorCreateInfo allocatorInfo = {};
+        allocatorInfo.vulkanApiVersion = VK_API_VERSION_1_2;
+        allocatorInfo.physicalDevice = context.device.physical_device.physical_device;
+        allocatorInfo.device = context.device.device;
+        allocatorInfo.instance = context.instance.instance;
+        if (!context.memory.Initialize(allocatorInfo, false))
+        {
+            return false;
+        }
+
+        context.queues.Select(context.device);
+        if (!context.queues.Initialize(context.device.device, FramesInFlight, context.debugUtils))
+        {
+            return false;
+        }
+
+        VkCommandPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+        poolInfo.queueFamilyIndex = queueIndexResult.value();
+        if (vkCreateCommandPool(context.device.device, &poolInfo, nullptr, &context.commandPool) != VK_SUCCESS)
+        {
+            spdlog::error("Failed to create command pool");
+            return false;
+        }
+
+        VkCommandBufferAllocateInfo commandBufferInfo{};
+        commandBufferInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        commandBufferInfo.commandPool = context.commandPool;
+        commandBufferInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        commandBufferInfo.commandBufferCount = 1;
+        VkFenceCreateInfo fenceInfo{};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        if (vkAllocateCommandBuffers(context.device.device, &commandBufferInfo, &context.commandBuffer) != VK_SUCCESS ||
+            vkCreateFence(context.device.device, &fenceInfo, nullptr, &context.fence) != VK_SUCCESS)
+        {
+            spdlog::error("Failed to create command buffer and fence");
+            return false;
+        }
+        return true;
+    }
+
+    inline void DestroyContext(Context& context)
+    {
+        if (context.device.device != VK_NULL_HANDLE)
+        {
+            vkDeviceWaitIdle(context.device.device);
+            if (context.fence != VK_NULL_HANDLE)
+            {
+                vkDestroyFence(context.device.device, context.fence, nullptr);
+            }
+            if (context.commandPool != VK_NULL_HANDLE)
+            {
+                vkDestroyCommandPool(context.device.device, context.commandPool, nullptr);
+            }
+            context.queues.Destroy();
+            context.memory.Destroy();
+            vkb::destroy_device(context.device);
+        }
+        if (context.instance.instance != VK_NULL_HANDLE)
+        {
+            vkb::destroy_instance(context.instance);
+        }
+    }
+
+    // What the MiniEngine rendering modules are created with. Shaders are read from shaderDirectory by
+    // file name, and immediate commands run in a command buffer of their own, waited for on the queue.
+    inline MiniEngine::Graphics::VulkanContext CreateModuleContext(Context& context, const std::filesystem::path& shaderDirectory)
+    {
+        MiniEngine::Graphics::VulkanContext moduleContext;
+        moduleContext.physicalDevice = context.device.physical_device.physical_device;
+        moduleContext.device = context.device.device;
+        moduleContext.framesInFlight = FramesInFlight;
+        moduleContext.memory = &context.memory;
+        moduleContext.queues = &context.queues;
+        moduleContext.debugUtils = &context.debugUtils;
+        moduleContext.loadShader = [shaderDirectory](const std::string& name)
+        {
+            std::ifstream file(shaderDirectory / name, std::ios::binary | std::ios::ate);
+            if (!file)
+            {
+                return std::vector<char>();
+            }
+            std::vector<char> code(static_cast<size_t>(file.tellg()));
+            file.seekg(0);
+            file.read(code.data(), static_cast<std::streamsize>(code.size()));
+            return code;
+        };
+        moduleContext.executeImmediate = [&context](const std::function<void(VkCommandBuffer)>& record)
+        {
+            VkCommandBufferAllocateInfo allocateInfo{};
+            allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocateInfo.commandPool = context.commandPool;
+            allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            allocateInfo.commandBufferCount = 1;
+            VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+            if (vkAllocateCommandBuffers(context.device.device, &allocateInfo, &commandBuffer) != VK_SUCCESS)
+            {
+                spdlog::error("Failed to allocate an immediate command buffer");
+                return false;
+            }
+
+            VkCommandBufferBeginInfo beginInfo{};
+            beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+            beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+            vkBeginCommandBuffer(commandBuffer, &beginInfo);
+            record(commandBuffer);
+            vkEndCommandBuffer(commandBuffer);
+
+            VkSubmitInfo submitInfo{};
+            submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+            submitInfo.commandBufferCount = 1;
+            submitInfo.pCommandBuffers = &commandBuffer;
+            const bool success = vkQueueSubmit(context.queue, 1, &submitInfo, VK_NULL_HANDLE) == VK_SUCCESS &&
+                vkQueueWaitIdle(context.queue) == VK_SUCCESS;
+            vkFreeCommandBuffers(context.device.device, context.commandPool, 1, &commandBuffer);
+            if (!success)
+            {
+                spdlog::error("Failed to execute immediate commands");
+            }
+            return success;
+        };
+        return moduleContext;
+    }
+
+    inline bool CreateBuffer(Context& context, Buffer& buffer, VkDeviceSize size, VkBufferUsageFlags usage, bool mapped)
+    {
+        VkBufferCreateInfo bufferInfo{};
+        bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferInfo.size = size;
+        bufferInfo.usage = usage;
+        bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        VmaAllocationCreateInfo allocationInfo{};
+        allocationInfo.usage = VMA_MEMORY_USAGE_AUTO;
+        if (mapped)
+        {
+            allocationInfo.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
+        }
+
+        VmaAllocationInfo allocated{};
+        if (vmaCreateBuffer(context.memory.GetAllocator(), &bufferInfo, &allocationInfo, &buffer.buffer, &buffer.allocation, &allocated) != VK_SUCCESS)
+        {
+            spdlog::error("Failed to create a buffer of {} bytes", size);
+            return false;
+        }
+        buffer.mapped = allocated.pMappedData;
+        return true;
+    }
+
+    inline void DestroyBuffer(Context& context, Buffer& buffer)
+    {
+        if (buffer.buffer != VK_NULL_HANDLE)
+        {
+            vmaDestroyBuffer(context.memory.GetAllocator(), buffer.buffer, buffer.allocation);
+            buffer = {};
+        }
+    }
+
+    inline bool BeginCommands(Context& context, VkCommandBufferUsageFlags flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT)
+    {
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = flags;
+        return vkResetCommandBuffer(context.commandBuffer, 0) == VK_SUCCESS &&
+            vkBeginCommandBuffer(context.commandBuffer, &beginInfo) == VK_SUCCESS;
+    }
+
+    // Submits the context's command buffer, followed by another one when it is given. A wait
+    // semaphore, such as the frame's async compute work, holds the submission back at waitStage.
+    inline bool SubmitAndWait(Context& context, VkCommandBuffer nextCommands = VK_NULL_HANDLE,
+        VkSemaphore waitSemaphore = VK_NULL_HANDLE, VkPipelineStageFlags waitStage = 0)
+    {
+        const VkCommandBuffer commandBuffers[2] = { context.commandBuffer, nextCommands };
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        if (waitSemaphore != VK_NULL_HANDLE)
+        {
+            submitInfo.waitSemaphoreCount = 1;
+            submitInfo.pWaitSemaphores = &waitSemaphore;
+            submitInfo.pWaitDstStageMask = &waitStage;
+        }
+        submitInfo.commandBufferCount = nextCommands != VK_NULL_HANDLE ? 2 : 1;
+        submitInfo.pCommandBuffers = commandBuffers;
+        return vkQueueSubmit(context.queue, 1, &submitInfo, context.fence) == VK_SUCCESS &&
+            vkWaitForFences(context.device.device, 1, &context.fence, VK_TRUE, UINT64_MAX) == VK_SUCCESS &&
+            vkResetFences(context.device.device, 1, &context.fence) == VK_SUCCESS;
+    }
+}
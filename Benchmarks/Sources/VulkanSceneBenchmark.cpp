@@ -0,0 +1,884 @@
+#include "Benchmark.hpp"
+#include "VulkanHeadless.hpp"
+
+#include <MiniEngine/Graphics/MeshLod.hpp>
+#include <MiniEngine/Graphics/Meshlet.hpp>
+#include <MiniEngine/Graphics/VulkanClusteredLighting.hpp>
+#include <MiniEngine/Graphics/VulkanCommandEncoder.hpp>
+#include <MiniEngine/Graphics/VulkanContext.hpp>
+#include <MiniEngine/Graphics/VulkanOcclusionCulling.hpp>
+#include <MiniEngine/Graphics/VulkanParticleSystem.hpp>
+#include <MiniEngine/Graphics/VulkanTextureSystem.hpp>
+#include <MiniEngine/Scene/Components.hpp>
+#include <MiniEngine/Scene/Frustum.hpp>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <span>
+#include <vector>
+
+using namespace MiniEngine;
+using namespace Headless;
+
+namespace
+{
+    constexpr uint32_t ObjectCount        = 4096;
+    constexpr uint32_t LightCount         = 1024;
+    constexpr uint32_t FrameIterations    = 60;
+    constexpr uint32_t SettleFrames       = 8; // Every frame in flight has a pyramid to test against and results to read
+    constexpr VkExtent2D FrameExtent      = { 1280, 720 };
+    constexpr float    NearPlane          = 0.1f;
+    constexpr float    FarPlane           = 200.0f;
+    constexpr float    MeshRadius         = 0.71f; // Bounding sphere of the unscaled triangle
+    constexpr float    LodThresholdPixels = 1.0f;
+    constexpr float    FrameSeconds       = 1.0f / 60.0f;
+    constexpr float    SettleSeconds      = 0.1f; // The longest step the particle system takes, so populations settle in few frames
+
+    constexpr uint32_t ParticleCounts[] = { 16384, 65536, 262144, 1048576 };
+    constexpr uint32_t LightCounts[]    = { 1000, 10000 };
+    constexpr uint32_t LightIterations  = 10; // Every fragment shading 10000 lights is seconds a frame on a CPU device
+
+    // The application's vertex, which triangle.vert reads
+    struct Vertex
+    {
+        glm::vec3 position;
+        glm::vec3 color;
+        glm::vec2 texCoord;
+    };
+
+    struct Mesh
+    {
+        VkBuffer                           vertexBuffer     = VK_NULL_HANDLE;
+        VmaAllocation                      vertexAllocation = VK_NULL_HANDLE;
+        VkBuffer                           indexBuffer      = VK_NULL_HANDLE;
+        VmaAllocation                      indexAllocation  = VK_NULL_HANDLE;
+        VkBuffer                           meshletBuffer    = VK_NULL_HANDLE;
+        VmaAllocation                      meshletAllocation = VK_NULL_HANDLE;
+        std::vector<Graphics::MeshLod>     lods;
+        std::vector<glm::uvec2>            lodMeshlets; // First meshlet and meshlet count of each level
+    };
+
+    // Offscreen color and depth in place of the swap chain; depth is sampled for the Hi-Z pyramid
+    struct Targets
+    {
+        VkImage       colorImage      = VK_NULL_HANDLE;
+        VmaAllocation colorAllocation = VK_NULL_HANDLE;
+        VkImageView   colorView       = VK_NULL_HANDLE;
+        VkImage       depthImage      = VK_NULL_HANDLE;
+        VmaAllocation depthAllocation = VK_NULL_HANDLE;
+        VkImageView   depthView       = VK_NULL_HANDLE;
+        VkFormat      depthFormat     = VK_FORMAT_UNDEFINED;
+        VkRenderPass  renderPass      = VK_NULL_HANDLE; // Clears, for phase 1
+        VkRenderPass  loadRenderPass  = VK_NULL_HANDLE; // Continues, for phase 2
+        VkFramebuffer framebuffer     = VK_NULL_HANDLE;
+    };
+
+    // The application's renderer minus the window: the same modules, shaders and pipeline state
+    struct SceneRenderer
+    {
+        Targets                           targets;
+        Mesh                              mesh;
+        VkPipelineLayout                  pipelineLayout = VK_NULL_HANDLE;
+        VkPipeline                        pipeline       = VK_NULL_HANDLE;
+        Graphics::VulkanOcclusionCulling  occlusion;
+        Graphics::VulkanClusteredLighting lighting;
+        Graphics::VulkanTextureSystem     textures; // Only its white texel, which every object samples
+        Graphics::VulkanParticleSystem    particles; // Created for the particle measurements only
+        Graphics::VulkanCommandEncoder    encoder;
+        uint32_t                          frame = 0;
+    };
+
+    // What the camera sees, as the application's draw list hands it to the renderer
+    struct SceneView
+    {
+        glm::vec3                              eye            = glm::vec3(0.0f);
+        glm::mat4                              view           = glm::mat4(1.0f);
+        glm::mat4                              projection     = glm::mat4(1.0f);
+        glm::mat4                              viewProjection = glm::mat4(1.0f);
+        std::vector<Graphics::OcclusionObject> objects; // Frustum-visible, front to back
+        std::vector<Graphics::ClusteredLight>  lights;
+    };
+
+    // The application's triangle: split into subdivisions^2 smaller ones and rippled, with a back of its own
+    void TessellateTriangle(const Vertex (&corners)[3], uint32_t subdivisions, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+    {
+        auto rowStart = [](uint32_t row) { return row * (row + 1) / 2; };
+        for (uint32_t row = 0; row <= subdivisions; ++row)
+        {
+            for (uint32_t column = 0; column <= row; ++column)
+            {
+                const float toEdge = static_cast<float>(row) / static_cast<float>(subdivisions);
+                const float along = static_cast<float>(column) / static_cast<float>(subdivisions);
+                const float weights[3] = { 1.0f - toEdge, along, toEdge - along };
+                Vertex vertex{ glm::vec3(0.0f), glm::vec3(0.0f), glm::vec2(0.0f) };
+                for (uint32_t corner = 0; corner < 3; ++corner)
+                {
+                    vertex.position += corners[corner].position * weights[corner];
+                    vertex.color += corners[corner].color * weights[corner];
+                    vertex.texCoord += corners[corner].texCoord * weights[corner];
+                }
+                vertex.position.z += 0.04f * std::sin(vertex.position.x * 9.0f) * std::sin(vertex.position.y * 7.0f);
+                vertices.push_back(vertex);
+            }
+        }
+
+        for (uint32_t row = 0; row < subdivisions; ++row)
+        {
+            for (uint32_t column = 0; column <= row; ++column)
+            {
+                const uint32_t top = rowStart(row) + column;
+                const uint32_t below = rowStart(row + 1) + column;
+                indices.insert(indices.end(), { top, below + 1, below });
+                if (column < row)
+                {
+                    indices.insert(indices.end(), { top, top + 1, below + 1 });
+                }
+            }
+        }
+
+        const uint32_t frontVertices = static_cast<uint32_t>(vertices.size());
+        const size_t frontIndices = indices.size();
+        vertices.insert(vertices.end(), vertices.begin(), vertices.end());
+        for (size_t i = 0; i < frontIndices; i += 3)
+        {
+            indices.insert(indices.end(), { indices[i] + frontVertices, indices[i + 2] + frontVertices, indices[i + 1] + frontVertices });
+        }
+    }
+
+    bool UploadMeshBuffer(Context& context, const void* data, VkDeviceSize size, VkBufferUsageFlags usage, VkPipelineStageFlags stage,
+        VkAccessFlags access, VkBuffer& buffer, VmaAllocation& allocation)
+    {
+        return context.memory.CreateBuffer(size, usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_ONLY,
+                   Graphics::MemoryCategory::Geometry, buffer, allocation) &&
+            context.queues.UploadBuffer(context.memory, context.commandPool, buffer, data, size, stage, access);
+    }
+
+    // Levels of detail and meshlets built as the application builds them at load
+    bool CreateMesh(Context& context, Mesh& mesh)
+    {
+        const Vertex corners[3] = {
+            { { 0.0f, -0.5f, 0.0f }, { 1.0f, 0.0f, 0.0f }, { 0.5f, 0.0f } },
+            { { 0.5f,  0.5f, 0.0f }, { 0.0f, 1.0f, 0.0f }, { 1.0f, 1.0f } },
+            { {-0.5f,  0.5f, 0.0f }, { 0.0f, 0.0f, 1.0f }, { 0.0f, 1.0f } },
+        };
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        TessellateTriangle(corners, 48, vertices, indices);
+
+        Graphics::MeshLodSettings lodSettings;
+        lodSettings.maxLevels = Graphics::MaxOcclusionLods;
+        mesh.lods = Graphics::BuildMeshLods(indices, &vertices[0].position.x, vertices.size(), sizeof(Vertex), lodSettings);
+        std::vector<Graphics::Meshlet> meshlets;
+        for (const Graphics::MeshLod& lod : mesh.lods)
+        {
+            const std::vector<Graphics::Meshlet> lodMeshlets = Graphics::BuildMeshlets(
+                std::span<uint32_t>(indices).subspan(lod.firstIndex, lod.indexCount), lod.firstIndex, &vertices[0].position.x, vertices.size(), sizeof(Vertex));
+            mesh.lodMeshlets.emplace_back(static_cast<uint32_t>(meshlets.size()), static_cast<uint32_t>(lodMeshlets.size()));
+            meshlets.insert(meshlets.end(), lodMeshlets.begin(), lodMeshlets.end());
+        }
+
+        if (!UploadMeshBuffer(context, vertices.data(), sizeof(Vertex) * vertices.size(), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT, mesh.vertexBuffer, mesh.vertexAllocation) ||
+            !UploadMeshBuffer(context, indices.data(), sizeof(uint32_t) * indices.size(), VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+                VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_INDEX_READ_BIT, mesh.indexBuffer, mesh.indexAllocation) ||
+            !UploadMeshBuffer(context, meshlets.data(), sizeof(Graphics::Meshlet) * meshlets.size(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, mesh.meshletBuffer, mesh.meshletAllocation))
+        {
+            spdlog::error("Failed to create mesh buffers");
+            return false;
+        }
+        spdlog::info("Mesh: {} triangles at full detail, {} levels, {} meshlets", mesh.lods[0].indexCount / 3, mesh.lods.size(), meshlets.size());
+        return true;
+    }
+
+    // As the application's passes: the clearing one leaves depth stored for the Hi-Z build, and the
+    // loading one continues from there. Both are compatible, so they share the framebuffer and pipelines.
+    bool CreateRenderPass(Context& context, VkFormat depthFormat, bool clearAttachments, VkRenderPass& renderPass)
+    {
+        VkAttachmentDescription attachments[2]{};
+        attachments[0].format = VK_FORMAT_R8G8B8A8_UNORM;
+        attachments[0].samples = VK_SAMPLE_COUNT_1_BIT;
+        attachments[0].loadOp = clearAttachments ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD;
+        attachments[0].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+        attachments[0].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        attachments[0].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        attachments[0].initialLayout = clearAttachments ? VK_IMAGE_LAYOUT_UNDEFINED : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        attachments[0].finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        attachments[1].format = depthFormat;
+        attachments[1].samples = VK_SAMPLE_COUNT_1_BIT;
+        attachments[1].loadOp = clearAttachments ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD;
+        attachments[1].storeOp = clearAttachments ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        attachments[1].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        attachments[1].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        attachments[1].initialLayout = clearAttachments ? VK_IMAGE_LAYOUT_UNDEFINED : VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        attachments[1].finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+        const VkAttachmentReference colorReference{ 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+        const VkAttachmentReference depthReference{ 1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+        VkSubpassDescription subpass{};
+        subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+        subpass.colorAttachmentCount = 1;
+        subpass.pColorAttachments = &colorReference;
+        subpass.pDepthStencilAttachment = &depthReference;
+
+        // Earlier attachment writes, and the Hi-Z build reading depth
+        VkSubpassDependency dependency{};
+        dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+        dependency.dstSubpass = 0;
+        dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+        dependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+        dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT
+            | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+        VkRenderPassCreateInfo renderPassInfo{};
+        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+        renderPassInfo.attachmentCount = 2;
+        renderPassInfo.pAttachments = attachments;
+        renderPassInfo.subpassCount = 1;
+        renderPassInfo.pSubpasses = &subpass;
+        renderPassInfo.dependencyCount = 1;
+        renderPassInfo.pDependencies = &dependency;
+        return vkCreateRenderPass(context.device.device, &renderPassInfo, nullptr, &renderPass) == VK_SUCCESS;
+    }
+
+    bool CreateTargets(Context& context, Targets& targets)
+    {
+        const VkFormat depthCandidates[] = { VK_FORMAT_D32_SFLOAT, VK_FORMAT_D16_UNORM };
+        const VkFormatFeatureFlags depthFeatures = VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT;
+        for (VkFormat candidate : depthCandidates)
+        {
+            VkFormatProperties properties;
+            vkGetPhysicalDeviceFormatProperties(context.device.physical_device.physical_device, candidate, &properties);
+            if ((properties.optimalTilingFeatures & depthFeatures) == depthFeatures)
+            {
+                targets.depthFormat = candidate;
+                break;
+            }
+        }
+        if (targets.depthFormat == VK_FORMAT_UNDEFINED)
+        {
+            spdlog::error("No depth format supports both depth attachments and sampling");
+            return false;
+        }
+
+        VkImageCreateInfo imageInfo{};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.extent = { FrameExtent.width, FrameExtent.height, 1 };
+        imageInfo.mipLevels = 1;
+        imageInfo.arrayLayers = 1;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkImageViewCreateInfo viewInfo{};
+        viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewInfo.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+
+        imageInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+        imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+        if (!context.memory.CreateImage(imageInfo, Graphics::MemoryCategory::RenderTargets, targets.colorImage, targets.colorAllocation))
+        {
+            spdlog::error("Failed to create a {}x{} color target", FrameExtent.width, FrameExtent.height);
+            return false;
+        }
+        viewInfo.image = targets.colorImage;
+        viewInfo.format = imageInfo.format;
+        if (vkCreateImageView(context.device.device, &viewInfo, nullptr, &targets.colorView) != VK_SUCCESS)
+        {
+            spdlog::error("Failed to create the color target view");
+            return false;
+        }
+
+        imageInfo.format = targets.depthFormat;
+        imageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+        if (!context.memory.CreateImage(imageInfo, Graphics::MemoryCategory::RenderTargets, targets.depthImage, targets.depthAllocation))
+        {
+            spdlog::error("Failed to create a {}x{} depth target", FrameExtent.width, FrameExtent.height);
+            return false;
+        }
+        viewInfo.image = targets.depthImage;
+        viewInfo.format = imageInfo.format;
+        viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+        if (vkCreateImageView(context.device.device, &viewInfo, nullptr, &targets.depthView) != VK_SUCCESS)
+        {
+            spdlog::error("Failed to create the depth target view");
+            return false;
+        }
+
+        if (!CreateRenderPass(context, targets.depthFormat, true, targets.renderPass) ||
+            !CreateRenderPass(context, targets.depthFormat, false, targets.loadRenderPass))
+        {
+            spdlog::error("Failed to create render passes");
+            return false;
+        }
+
+        const VkImageView attachments[2] = { targets.colorView, targets.depthView };
+        VkFramebufferCreateInfo framebufferInfo{};
+        framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+        framebufferInfo.renderPass = targets.renderPass;
+        framebufferInfo.attachmentCount = 2;
+        framebufferInfo.pAttachments = attachments;
+        framebufferInfo.width = FrameExtent.width;
+        framebufferInfo.height = FrameExtent.height;
+        framebufferInfo.layers = 1;
+        if (vkCreateFramebuffer(context.device.device, &framebufferInfo, nullptr, &targets.framebuffer) != VK_SUCCESS)
+        {
+            spdlog::error("Failed to create the framebuffer");
+            return false;
+        }
+        return true;
+    }
+
+    // The application's scene pipeline: sets for the scene, the lights and the texture, back faces
+    // culled, depth tested and written
+    bool CreateScenePipeline(Context& context, const Graphics::VulkanContext& moduleContext, SceneRenderer& renderer)
+    {
+        const VkDescriptorSetLayout setLayouts[] = {
+            renderer.occlusion.GetSceneSetLayout(), renderer.lighting.GetSetLayout(), renderer.textures.GetSetLayout() };
+        VkPipelineLayoutCreateInfo layoutInfo{};
+        layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        layoutInfo.setLayoutCount = 3;
+        layoutInfo.pSetLayouts = setLayouts;
+        if (vkCreatePipelineLayout(context.device.device, &layoutInfo, nullptr, &renderer.pipelineLayout) != VK_SUCCESS)
+        {
+            spdlog::error("Failed to create the scene pipeline layout");
+            return false;
+        }
+
+        const VkShaderModule vertexShader = Graphics::CreateShaderModule(moduleContext, "Triangle.vert.spv");
+        const VkShaderModule fragmentShader = Graphics::CreateShaderModule(moduleContext, "Triangle.frag.spv");
+        VkPipelineShaderStageCreateInfo stages[2]{};
+        stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+        stages[0].module = vertexShader;
+        stages[0].pName = "main";
+        stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+        stages[1].module = fragmentShader;
+        stages[1].pName = "main";
+
+        const VkVertexInputBindingDescription binding{ 0, sizeof(Vertex), VK_VERTEX_INPUT_RATE_VERTEX };
+        const VkVertexInputAttributeDescription attributes[] = {
+            { 0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, position) },
+            { 1, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, color) },
+            { 2, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(Vertex, texCoord) },
+        };
+        VkPipelineVertexInputStateCreateInfo vertexInput{};
+        vertexInput.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+        vertexInput.vertexBindingDescriptionCount = 1;
+        vertexInput.pVertexBindingDescriptions = &binding;
+        vertexInput.vertexAttributeDescriptionCount = 3;
+        vertexInput.pVertexAttributeDescriptions = attributes;
+
+        VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
+        inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+        inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+        VkPipelineViewportStateCreateInfo viewportState{};
+        viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+        viewportState.viewportCount = 1;
+        viewportState.scissorCount = 1;
+        const VkDynamicState dynamicStates[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+        VkPipelineDynamicStateCreateInfo dynamicState{};
+        dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+        dynamicState.dynamicStateCount = 2;
+        dynamicState.pDynamicStates = dynamicStates;
+
+        VkPipelineRasterizationStateCreateInfo rasterizer{};
+        rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+        rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+        rasterizer.lineWidth = 1.0f;
+        rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
+        rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+
+        VkPipelineMultisampleStateCreateInfo multisampling{};
+        multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+        multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+        VkPipelineDepthStencilStateCreateInfo depthStencil{};
+        depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+        depthStencil.depthTestEnable = VK_TRUE;
+        depthStencil.depthWriteEnable = VK_TRUE;
+        depthStencil.depthCompareOp = VK_COMPARE_OP_LESS;
+
+        VkPipelineColorBlendAttachmentState blendAttachment{};
+        blendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+        VkPipelineColorBlendStateCreateInfo colorBlending{};
+        colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+        colorBlending.attachmentCount = 1;
+        colorBlending.pAttachments = &blendAttachment;
+
+        VkGraphicsPipelineCreateInfo pipelineInfo{};
+        pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+        pipelineInfo.stageCount = 2;
+        pipelineInfo.pStages = stages;
+        pipelineInfo.pVertexInputState = &vertexInput;
+        pipelineInfo.pInputAssemblyState = &inputAssembly;
+        pipelineInfo.pViewportState = &viewportState;
+        pipelineInfo.pDynamicState = &dynamicState;
+        pipelineInfo.pRasterizationState = &rasterizer;
+        pipelineInfo.pMultisampleState = &multisampling;
+        pipelineInfo.pDepthStencilState = &depthStencil;
+        pipelineInfo.pColorBlendState = &colorBlending;
+        pipelineInfo.layout = renderer.pipelineLayout;
+        pipelineInfo.renderPass = renderer.targets.renderPass;
+        const bool created = vertexShader != VK_NULL_HANDLE && fragmentShader != VK_NULL_HANDLE &&
+            vkCreateGraphicsPipelines(context.device.device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &renderer.pipeline) == VK_SUCCESS;
+        vkDestroyShaderModule(context.device.device, vertexShader, nullptr);
+        vkDestroyShaderModule(context.device.device, fragmentShader, nullptr);
+        if (!created)
+        {
+            spdlog::error("Failed to create the scene pipeline");
+        }
+        return created;
+    }
+
+    bool CreateSceneRenderer(Context& context, const Graphics::VulkanContext& moduleContext, SceneRenderer& renderer)
+    {
+        if (!CreateTargets(context, renderer.targets) || !CreateMesh(context, renderer.mesh))
+        {
+            return false;
+        }
+
+        Graphics::OcclusionCullingInfo occlusionInfo;
+        occlusionInfo.cullShader = "OcclusionCull.comp.spv";
+        occlusionInfo.scanShader = "DrawScan.comp.spv";
+        occlusionInfo.reduceShader = "HiZReduce.comp.spv";
+        occlusionInfo.meshletBuffer = renderer.mesh.meshletBuffer;
+        for (const glm::uvec2& range : renderer.mesh.lodMeshlets)
+        {
+            occlusionInfo.drawsPerObject = std::max(occlusionInfo.drawsPerObject, range.y);
+        }
+        occlusionInfo.depthImage = renderer.targets.depthImage;
+        occlusionInfo.depthView = renderer.targets.depthView;
+        occlusionInfo.depthExtent = FrameExtent;
+
+        Graphics::TextureSystemInfo textureInfo;
+        textureInfo.mipShader = "TextureMipgen.comp.spv";
+        return renderer.occlusion.Initialize(moduleContext, occlusionInfo) &&
+            renderer.lighting.Initialize(moduleContext, "LightCull.comp.spv") &&
+            renderer.textures.Initialize(moduleContext, textureInfo) &&
+            CreateScenePipeline(context, moduleContext, renderer);
+    }
+
+    void DestroySceneRenderer(Context& context, SceneRenderer& renderer)
+    {
+        VkDevice device = context.device.device;
+        if (device == VK_NULL_HANDLE)
+        {
+            return;
+        }
+        vkDeviceWaitIdle(device);
+        renderer.particles.Destroy();
+        renderer.textures.Destroy();
+        renderer.lighting.Destroy();
+        renderer.occlusion.Destroy();
+        vkDestroyPipeline(device, renderer.pipeline, nullptr);
+        vkDestroyPipelineLayout(device, renderer.pipelineLayout, nullptr);
+
+        Mesh& mesh = renderer.mesh;
+        context.memory.DestroyBuffer(mesh.vertexBuffer, mesh.vertexAllocation);
+        context.memory.DestroyBuffer(mesh.indexBuffer, mesh.indexAllocation);
+        context.memory.DestroyBuffer(mesh.meshletBuffer, mesh.meshletAllocation);
+
+        Targets& targets = renderer.targets;
+        vkDestroyFramebuffer(device, targets.framebuffer, nullptr);
+        vkDestroyRenderPass(device, targets.loadRenderPass, nullptr);
+        vkDestroyRenderPass(device, targets.renderPass, nullptr);
+        vkDestroyImageView(device, targets.depthView, nullptr);
+        vkDestroyImageView(device, targets.colorView, nullptr);
+        context.memory.DestroyImage(targets.depthImage, targets.depthAllocation);
+        context.memory.DestroyImage(targets.colorImage, targets.colorAllocation);
+    }
+
+    // The application's scene as it starts, seen from where its camera orbit begins: a grid of triangles
+    // two units apart with every 97th a large occluder raised above the rest. Only the frustum-visible
+    // objects go to the GPU, front to back, each at the coarsest level whose error stays under a pixel.
+    void CreateView(SceneView& view, const Mesh& mesh, uint32_t objectCount)
+    {
+        const uint32_t side = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<float>(objectCount))));
+        const float extent = side * 2.0f * 0.5f;
+        view.eye = glm::vec3(extent * 0.5f, 6.0f, 0.0f);
+        const glm::vec3 forward = glm::normalize(glm::vec3(1.0f, -0.15f, 0.0f));
+        view.view = glm::lookAt(view.eye, view.eye + forward, glm::vec3(0.0f, 1.0f, 0.0f));
+        view.projection = glm::perspective(glm::radians(60.0f), static_cast<float>(FrameExtent.width) / FrameExtent.height, NearPlane, FarPlane);
+        view.projection[1][1] *= -1.0f;
+        view.viewProjection = view.projection * view.view;
+
+        const Scene::Frustum frustum = Scene::Frustum::FromMatrix(view.viewProjection);
+        const float pixelsPerUnitAtOne = std::abs(view.projection[1][1]) * FrameExtent.height * 0.5f;
+        std::vector<std::pair<float, Graphics::OcclusionObject>> visible;
+        for (uint32_t i = 0; i < objectCount; ++i)
+        {
+            glm::vec3 position((i % side) * 2.0f - extent, 0.5f, (i / side) * 2.0f - extent);
+            float scale = 1.0f;
+            if (i % 97 == 0)
+            {
+                position.y = 3.0f;
+                scale = 6.0f;
+            }
+            const Scene::Bounds bounds{ position, MeshRadius * scale, glm::vec3(MeshRadius * scale) };
+            if (!frustum.Intersects(bounds))
+            {
+                continue;
+            }
+
+            const float distance = std::max(glm::length(position - view.eye) - bounds.radius, NearPlane);
+            const uint32_t lod = Graphics::SelectMeshLod(mesh.lods, pixelsPerUnitAtOne * scale / distance, 0, LodThresholdPixels, 0.0f);
+            Graphics::OcclusionObject object;
+            object.model = glm::scale(glm::rotate(glm::translate(glm::mat4(1.0f), position), static_cast<float>(i), glm::vec3(0.0f, 1.0f, 0.0f)),
+                glm::vec3(scale));
+            object.boundsCenterRadius = glm::vec4(position, bounds.radius);
+            object.boundsExtents = glm::vec4(bounds.extents, static_cast<float>(lod));
+            visible.emplace_back(glm::dot(position - view.eye, forward), object);
+        }
+        std::sort(visible.begin(), visible.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+        view.objects.clear();
+        for (const auto& [depth, object] : visible)
+        {
+            view.objects.push_back(object);
+        }
+    }
+
+    // The application's lights where their orbits start, in view space: the same fixed sequence, so a
+    // smaller set is a prefix of a larger one, with every fourth a spot light pointing down
+    void CreateLights(SceneView& view, uint32_t objectCount, uint32_t lightCount)
+    {
+        const float extent = std::ceil(std::sqrt(static_cast<float>(objectCount)));
+        std::mt19937 random(11);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        view.lights.clear();
+        for (uint32_t i = 0; i < lightCount; ++i)
+        {
+            glm::vec3 position((unit(random) * 2.0f - 1.0f) * extent, 1.0f + unit(random) * 2.0f, (unit(random) * 2.0f - 1.0f) * extent);
+            position.x += 1.0f + unit(random) * 3.0f;
+            unit(random); // Orbit speed and phase, which a still frame does not use
+            unit(random);
+            const glm::vec3 color = glm::vec3(0.3f + 0.7f * unit(random), 0.3f + 0.7f * unit(random), 0.3f + 0.7f * unit(random)) * 4.0f;
+            const bool spot = i % 4 == 3;
+
+            Graphics::ClusteredLight light;
+            light.positionRange = glm::vec4(glm::vec3(view.view * glm::vec4(position, 1.0f)), spot ? 6.0f : 4.0f);
+            light.directionCosine = glm::vec4(glm::vec3(view.view * glm::vec4(0.0f, -1.0f, 0.0f, 0.0f)), spot ? std::cos(0.6f) : -1.0f);
+            light.color = glm::vec4(color, 1.0f);
+            view.lights.push_back(light);
+        }
+    }
+
+    void RecordSceneDraws(SceneRenderer& renderer, uint32_t frame, uint32_t phase)
+    {
+        const VkDescriptorSet sets[] = {
+            renderer.occlusion.GetSceneSet(frame), renderer.lighting.GetDescriptorSet(frame), renderer.textures.GetActiveTexture().descriptorSet };
+        const VkDeviceSize offset = 0;
+        Graphics::VulkanCommandEncoder& encoder = renderer.encoder;
+        encoder.BindPipeline(VK_PIPELINE_BIND_POINT_GRAPHICS, renderer.pipeline);
+        encoder.BindDescriptorSets(VK_PIPELINE_BIND_POINT_GRAPHICS, renderer.pipelineLayout, 0, 3, sets);
+        encoder.BindVertexBuffers(0, 1, &renderer.mesh.vertexBuffer, &offset);
+        encoder.BindIndexBuffer(renderer.mesh.indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+        renderer.occlusion.RecordDraws(encoder, frame, phase);
+    }
+
+    // One frame of the application's renderer, recorded as it records one and waited for, so its time
+    // is the frame's GPU work plus a submission. Returns false if a Vulkan call failed.
+    bool RenderFrame(Context& context, SceneRenderer& renderer, const SceneView& view, float deltaTime = FrameSeconds)
+    {
+        const uint32_t frame = renderer.frame;
+        Graphics::VulkanParticleSystem& particles = renderer.particles;
+        if (particles.GetCapacity() > 0)
+        {
+            particles.ReadResults(frame);
+            particles.Update(view.view, deltaTime);
+            if (!particles.Simulate(frame, view.view, view.viewProjection))
+            {
+                return false;
+            }
+        }
+
+        Graphics::OcclusionUniforms uniforms{};
+        uniforms.viewProjection = view.viewProjection;
+        uniforms.lodCount = static_cast<uint32_t>(std::min<size_t>(renderer.mesh.lods.size(), Graphics::MaxOcclusionLods));
+        for (uint32_t level = 0; level < uniforms.lodCount; ++level)
+        {
+            const glm::uvec2 meshlets = renderer.mesh.lodMeshlets[level];
+            uniforms.lods[level] = glm::uvec4(renderer.mesh.lods[level].indexCount, renderer.mesh.lods[level].firstIndex, meshlets.x, meshlets.y);
+        }
+        const Scene::Frustum frustum = Scene::Frustum::FromMatrix(view.viewProjection);
+        std::copy(frustum.planes.begin(), frustum.planes.end(), uniforms.frustumPlanes);
+        uniforms.cameraPosition = glm::vec4(view.eye, 1.0f);
+        uniforms.renderScale = glm::vec2(1.0f);
+
+        Graphics::LightingCamera camera;
+        camera.view = view.view;
+        camera.projection = view.projection;
+        camera.nearPlane = NearPlane;
+        camera.farPlane = FarPlane;
+        if (!renderer.occlusion.PrepareFrame(frame, view.objects, uniforms) ||
+            !renderer.lighting.PrepareFrame(frame, view.lights, camera, FrameExtent) ||
+            !BeginCommands(context))
+        {
+            return false;
+        }
+
+        VkCommandBuffer commandBuffer = context.commandBuffer;
+        renderer.encoder.Begin(commandBuffer);
+        renderer.lighting.RecordBinning(renderer.encoder, frame);
+        renderer.occlusion.RecordPhase1(renderer.encoder, frame);
+
+        VkClearValue clearValues[2]{};
+        clearValues[0].color = { { 0.2f, 0.2f, 0.2f, 1.0f } };
+        clearValues[1].depthStencil = { 1.0f, 0 };
+        VkRenderPassBeginInfo renderPassInfo{};
+        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        renderPassInfo.renderPass = renderer.targets.renderPass;
+        renderPassInfo.framebuffer = renderer.targets.framebuffer;
+        renderPassInfo.renderArea.extent = FrameExtent;
+        renderPassInfo.clearValueCount = 2;
+        renderPassInfo.pClearValues = clearValues;
+        const VkViewport viewport{ 0.0f, 0.0f, static_cast<float>(FrameExtent.width), static_cast<float>(FrameExtent.height), 0.0f, 1.0f };
+        const VkRect2D scissor{ { 0, 0 }, FrameExtent };
+
+        vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+        renderer.encoder.SetViewport(0, 1, &viewport);
+        renderer.encoder.SetScissor(0, 1, &scissor);
+        RecordSceneDraws(renderer, frame, 0);
+        vkCmdEndRenderPass(commandBuffer);
+
+        renderer.occlusion.RecordPhase2(renderer.encoder, frame);
+
+        renderPassInfo.renderPass = renderer.targets.loadRenderPass;
+        renderPassInfo.clearValueCount = 0;
+        renderPassInfo.pClearValues = nullptr;
+        vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+        if (renderer.occlusion.IsEnabledFor(frame))
+        {
+            RecordSceneDraws(renderer, frame, 1);
+        }
+        if (particles.GetCapacity() > 0)
+        {
+            particles.RecordDraw(renderer.encoder, frame);
+        }
+        vkCmdEndRenderPass(commandBuffer);
+
+        renderer.occlusion.RecordFrameEnd(commandBuffer, frame);
+        renderer.lighting.RecordFrameEnd(commandBuffer, frame);
+
+        // The culling counters are read by the host once the fence signals
+        VkMemoryBarrier readbackBarrier{};
+        readbackBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        readbackBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        readbackBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &readbackBarrier, 0, nullptr, 0, nullptr);
+
+        // The particles' compute submission has to finish before their draw reads its results
+        VkSemaphore computeSemaphore = VK_NULL_HANDLE;
+        VkPipelineStageFlags computeStage = 0;
+        context.queues.TakeComputeWait(frame, computeSemaphore, computeStage);
+        if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS || !SubmitAndWait(context, VK_NULL_HANDLE, computeSemaphore, computeStage))
+        {
+            return false;
+        }
+        renderer.occlusion.MarkSubmitted(frame);
+        renderer.lighting.MarkSubmitted(frame);
+        renderer.frame = (frame + 1) % FramesInFlight;
+        return true;
+    }
+
+    // The same still frame with occlusion culling off and on. The camera does not move, so the pyramid
+    // each frame tests against is exactly what it will draw, which is the best case for phase 1.
+    bool MeasureOcclusion(Context& context, SceneRenderer& renderer, const SceneView& view)
+    {
+        bool failed = false;
+        auto renderFrames = [&](uint32_t count)
+        {
+            for (uint32_t i = 0; i < count && !failed; ++i)
+            {
+                failed = !RenderFrame(context, renderer, view);
+            }
+        };
+
+        renderer.occlusion.SetEnabled(false);
+        renderFrames(SettleFrames);
+        const Benchmark::Result off = Benchmark::Run(fmt::format("Scene frame {} objects, occlusion off", ObjectCount), FrameIterations,
+            [&] { renderFrames(1); });
+        const Graphics::OcclusionStats offStats = renderer.occlusion.GetStats();
+
+        renderer.occlusion.SetEnabled(true);
+        renderFrames(SettleFrames);
+        const Benchmark::Result on = Benchmark::Run(fmt::format("Scene frame {} objects, occlusion on", ObjectCount), FrameIterations,
+            [&] { renderFrames(1); });
+        const Graphics::OcclusionStats& onStats = renderer.occlusion.GetStats();
+        if (failed)
+        {
+            return false;
+        }
+
+        spdlog::info("  {} of {} frustum-visible objects occluded ({:.1f}%), draws {} -> {}, triangles {} -> {}",
+            onStats.occluded, onStats.frustumVisible, onStats.frustumVisible > 0 ? 100.0 * onStats.occluded / onStats.frustumVisible : 0.0,
+            offStats.draws, onStats.draws, offStats.triangles, onStats.triangles);
+        spdlog::info("  occlusion saves {:.3f} ms a frame at best ({:.0f}%)", off.minMs - on.minMs,
+            off.minMs > 0.0 ? 100.0 * (off.minMs - on.minMs) / off.minMs : 0.0);
+        if (renderer.occlusion.GetTimestampPeriod() > 0.0f)
+        {
+            spdlog::info("  GPU frame {:.3f} ms off, {:.3f} ms on, {:.3f} ms of it culling and the Hi-Z build",
+                onStats.gpuFrameMs[0], onStats.gpuFrameMs[1], onStats.gpuCullMs[1]);
+        }
+        else
+        {
+            spdlog::info("  no GPU timestamps on this queue");
+        }
+        return true;
+    }
+
+    // The scene with occlusion culling on, shading each light count clustered and then with the naive
+    // loop over every light. Leaves the default light set, clustered, for what is measured after.
+    bool MeasureLights(Context& context, SceneRenderer& renderer, SceneView& view)
+    {
+        Graphics::VulkanClusteredLighting& lighting = renderer.lighting;
+        renderer.occlusion.SetEnabled(true);
+        bool failed = false;
+        for (uint32_t count : LightCounts)
+        {
+            CreateLights(view, ObjectCount, count);
+            for (bool clustered : { true, false })
+            {
+                lighting.SetClustered(clustered);
+                for (uint32_t i = 0; i < FramesInFlight && !failed; ++i)
+                {
+                    failed = !RenderFrame(context, renderer, view);
+                }
+                lighting.ResetStats();
+
+                Benchmark::Run(fmt::format("Scene frame with {} lights, {}", count, clustered ? "clustered" : "naive"), LightIterations,
+                    [&] { failed = failed || !RenderFrame(context, renderer, view); });
+                if (failed)
+                {
+                    return false;
+                }
+                const Graphics::LightingStats& stats = lighting.GetStats();
+                if (lighting.GetTimestampPeriod() <= 0.0f)
+                {
+                    spdlog::info("  no GPU timestamps on this queue");
+                }
+                else if (clustered)
+                {
+                    spdlog::info("  GPU frame {:.3f} ms, {:.3f} ms of it binning, {} light indices", stats.gpuFrameMs[1], stats.gpuBinMs,
+                        stats.lightIndices);
+                }
+                else
+                {
+                    spdlog::info("  GPU frame {:.3f} ms", stats.gpuFrameMs[0]);
+                }
+            }
+        }
+
+        CreateLights(view, ObjectCount, LightCount);
+        lighting.SetClustered(true);
+        return true;
+    }
+
+    // The scene with occlusion culling on and each particle population in turn, simulated on the
+    // async compute queue and drawn over it. Each population settles for two lifetimes first, so
+    // what is measured is the steady state with as many dying as being emitted.
+    bool MeasureParticles(const Graphics::VulkanContext& moduleContext, Context& context, SceneRenderer& renderer, const SceneView& view)
+    {
+        Graphics::ParticleSystemInfo particleInfo;
+        particleInfo.prepareShader = "ParticlePrepare.comp.spv";
+        particleInfo.emitShader = "ParticleEmit.comp.spv";
+        particleInfo.simulateShader = "ParticleSimulate.comp.spv";
+        particleInfo.vertexShader = "Particle.vert.spv";
+        particleInfo.fragmentShader = "Particle.frag.spv";
+        particleInfo.renderPass = renderer.targets.loadRenderPass;
+        const uint32_t largest = ParticleCounts[std::size(ParticleCounts) - 1];
+        particleInfo.capacity = largest + largest / 4; // Room for the population to fluctuate around its target
+        Graphics::VulkanParticleSystem& particles = renderer.particles;
+        if (!particles.Initialize(moduleContext, particleInfo))
+        {
+            spdlog::error("Failed to create the particle system");
+            return false;
+        }
+
+        renderer.occlusion.SetEnabled(true);
+        bool failed = false;
+        for (uint32_t count : ParticleCounts)
+        {
+            particles.SetTargetCount(count);
+            const uint32_t settleFrames = static_cast<uint32_t>(std::ceil(particles.GetLifetime() * 2.0f / SettleSeconds));
+            for (uint32_t i = 0; i < settleFrames && !failed; ++i)
+            {
+                failed = !RenderFrame(context, renderer, view, SettleSeconds);
+            }
+            particles.ResetStats();
+
+            Benchmark::Run(fmt::format("Scene frame with {} particles", count), FrameIterations,
+                [&] { failed = failed || !RenderFrame(context, renderer, view); });
+            if (failed)
+            {
+                return false;
+            }
+            const Graphics::ParticleStats& stats = particles.GetStats();
+            spdlog::info("  {} alive: GPU simulate {:.3f} ms, render {:.3f} ms{}", stats.alive, stats.gpuSimulateMs, stats.gpuRenderMs,
+                particles.GetTimestampPeriod() > 0.0f ? "" : " (no timestamps)");
+        }
+        return true;
+    }
+}
+
+// Times whole frames of the application's renderer offscreen, with its shaders, modules and scene as
+// it starts: occlusion culling off against on, logging how much of the frustum-visible scene the Hi-Z
+// pyramid rejected and the frame time that saved; then with 1000 and 10000 lights, clustered against
+// naive; then with each particle population drawn over it.
+// --shaders DIR is where the build compiled the SPIR-V to; --device cpu picks a CPU implementation
+// such as lavapipe, which is what the checked-in baseline is recorded on.
+int main(int argc, char** argv)
+{
+    bool cpuDevice = false;
+    std::filesystem::path shaderDirectory = "Shaders";
+    for (int i = 1; i + 1 < argc; ++i)
+    {
+        cpuDevice |= std::strcmp(argv[i], "--device") == 0 && std::strcmp(argv[i + 1], "cpu") == 0;
+        if (std::strcmp(argv[i], "--shaders") == 0)
+        {
+            shaderDirectory = argv[i + 1];
+        }
+    }
+
+    Context context;
+    if (!CreateContext(context, "VulkanSceneBenchmark", cpuDevice, Graphics::InstrumentationLevel::Off, true))
+    {
+        DestroyContext(context);
+        return 1;
+    }
+    const Graphics::VulkanContext moduleContext = CreateModuleContext(context, shaderDirectory);
+
+    SceneRenderer renderer;
+    SceneView view;
+    bool failed = !CreateSceneRenderer(context, moduleContext, renderer);
+    if (!failed)
+    {
+        CreateView(view, renderer.mesh, ObjectCount);
+        CreateLights(view, ObjectCount, LightCount);
+        spdlog::info("{} of {} objects in the frustum, {} lights", view.objects.size(), ObjectCount, view.lights.size());
+        failed = !MeasureOcclusion(context, renderer, view) || !MeasureLights(context, renderer, view) ||
+            !MeasureParticles(moduleContext, context, renderer, view);
+    }
+
+    DestroySceneRenderer(context, renderer);
+    DestroyContext(context);
+    if (failed)
+    {
+        spdlog::error("A Vulkan call failed, the timings are not meaningful");
+        return 1;
+    }
+    return Benchmark::Finish(argc, argv, "VulkanSceneBenchmark");
+}
@@ -1,18 +1,46 @@
 #pragma once
 
+#include "MiniEngine/Core/FrameClock.hpp"
 #include "MiniEngine/Graphics/Window.hpp"
 
 namespace MiniEngine
 {
+    // Runs the frame loop: simulation advances in fixed steps of the frame clock, and each frame is
+    // rendered between the last two steps. Derived applications fill in the two hooks.
     class Application
     {
     public:
         Application();
-        ~Application();
+        virtual ~Application();
 
         void Run();
 
+        const Core::FrameClock& GetFrameClock() const
+        {
+            return m_Clock;
+        }
+
+    protected:
+        // Redraws on demand; applications that simulate all the time switch its scheduler to continuous
+        Graphics::Window& GetWindow()
+        {
+            return *m_Window;
+        }
+
+        // Advances the simulation by exactly stepSeconds
+        virtual void FixedUpdate(double stepSeconds)
+        {
+            static_cast<void>(stepSeconds);
+        }
+
+        // Renders the simulation alpha of the way from the previous step's state to the latest one
+        virtual void Render(float alpha)
+        {
+            static_cast<void>(alpha);
+        }
+
     private:
         Graphics::Window* m_Window;
+        Core::FrameClock m_Clock;
     };
-}
\ No newline at end of file
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define MINIENGINE_SIMD_X86 1
+#else
+#define MINIENGINE_SIMD_X86 0
+#endif
+
+namespace MiniEngine::Core
+{
+    // Instruction sets that MiniEngine ships dedicated kernels for, in increasing order
+    enum class SimdLevel
+    {
+        Scalar,
+        Sse,
+        Avx2,
+    };
+
+    struct CpuFeatures
+    {
+        bool sse2  = false;
+        bool sse41 = false;
+        bool avx   = false; // Only set when the OS also saves the YMM registers
+        bool avx2  = false;
+        bool fma   = false;
+    };
+
+    // Queried once through CPUID and cached
+    const CpuFeatures& GetCpuFeatures();
+
+    // Highest level both the CPU and this build support
+    SimdLevel GetSupportedSimdLevel();
+
+    const char* ToString(SimdLevel level);
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+namespace MiniEngine::Core
+{
+    struct FrameClockStats
+    {
+        uint64_t frames       = 0;
+        uint64_t steps        = 0; // Fixed steps simulated
+        uint64_t droppedSteps = 0; // Steps skipped because a frame fell further behind than the catch-up limit
+
+        // Over the last FrameClock::StatsWindow frames
+        double averageFrameMs = 0.0;
+        double minFrameMs     = 0.0;
+        double maxFrameMs     = 0.0;
+        double p99FrameMs     = 0.0;
+    };
+
+    // Drives a fixed-timestep simulation from a variable frame rate. Each Tick measures the frame with
+    // the steady clock, adds it to an accumulator and returns how many whole steps are due; rendering
+    // then interpolates between the last two simulated states by GetAlpha. A frame owes at most
+    // maxStepsPerFrame steps, and time beyond that is dropped, so a slow frame cannot make the next
+    // one slower still. Not thread-safe.
+    class FrameClock
+    {
+    public:
+        static constexpr uint32_t StatsWindow = 256;
+
+        explicit FrameClock(double stepSeconds = 1.0 / 60.0, uint32_t maxStepsPerFrame = 8);
+
+        // Starts a frame. The first one measures nothing and simulates nothing.
+        uint32_t Tick();
+
+        // Makes the next Tick start over like the first, for when the time since the last one was spent
+        // asleep rather than on a frame; it would otherwise count as one long frame and owe its steps
+        void Resync();
+
+        // While paused, frames are still timed but no simulation time accrues
+        void SetPaused(bool paused);
+
+        bool IsPaused() const
+        {
+            return m_Paused;
+        }
+
+        double GetStepSeconds() const
+        {
+            return m_StepSeconds;
+        }
+
+        // The last frame's length, as measured by Tick
+        double GetFrameSeconds() const
+        {
+            return m_FrameSeconds;
+        }
+
+        // Time simulated so far, in whole steps
+        double GetSimulationTime() const
+        {
+            return static_cast<double>(m_Stats.steps) * m_StepSeconds;
+        }
+
+        // How far rendering sits between the previous step's state (0) and the latest one (1)
+        float GetAlpha() const
+        {
+            return static_cast<float>(m_Accumulator / m_StepSeconds);
+        }
+
+        FrameClockStats GetStats() const;
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        const double m_StepSeconds;
+        const uint32_t m_MaxStepsPerFrame;
+        Clock::time_point m_LastTick;
+        bool m_Started = false;
+        bool m_Paused = false;
+        double m_Accumulator = 0.0;
+        double m_FrameSeconds = 0.0;
+        std::array<float, StatsWindow> m_FrameMs = {};
+        FrameClockStats m_Stats;
+    };
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+namespace MiniEngine::Core
+{
+    struct FramePipelineStats
+    {
+        uint64_t packets        = 0; // Released by the consumer
+        double   producerWaitMs = 0.0; // Time BeginWrite spent waiting for a free slot
+        double   consumerWaitMs = 0.0; // Time BeginRead spent waiting for a packet
+    };
+
+    // Hands frame packets from the thread that simulates to the thread that renders through a ring of
+    // slots the caller owns, indexed 0 to slotCount - 1. The producer fills a free slot and publishes it,
+    // the consumer reads published slots in order and releases each once it no longer needs it, so a
+    // packet never changes while it is read. With n slots the producer runs at most n - 1 frames ahead of
+    // the frame being rendered; a single slot makes both sides take turns, which is how one thread can
+    // drive both ends. All totals in the stats are cumulative.
+    class FramePipeline
+    {
+    public:
+        explicit FramePipeline(uint32_t slotCount);
+
+        FramePipeline(const FramePipeline&) = delete;
+        FramePipeline& operator=(const FramePipeline&) = delete;
+        FramePipeline(FramePipeline&&) = delete;
+        FramePipeline& operator=(FramePipeline&&) = delete;
+
+        uint32_t GetSlotCount() const
+        {
+            return m_SlotCount;
+        }
+
+        // Waits for a free slot; false once the pipeline is closed. Until EndWrite publishes it the
+        // slot stays the producer's, and calling BeginWrite again hands back the same one.
+        bool BeginWrite(uint32_t& slot);
+        void EndWrite();
+
+        // Waits for the oldest published packet; false once the pipeline is closed and drained
+        bool BeginRead(uint32_t& slot);
+        void EndRead();
+
+        // Wakes both sides; packets already published can still be read
+        void Close();
+
+        FramePipelineStats GetStats() const;
+
+    private:
+        const uint32_t m_SlotCount;
+        mutable std::mutex m_Mutex;
+        std::condition_variable m_Written;
+        std::condition_variable m_Released;
+        uint64_t m_WriteCount = 0; // Published
+        uint64_t m_ReadCount = 0;  // Released
+        bool m_Closed = false;
+        FramePipelineStats m_Stats;
+    };
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace MiniEngine::Core
+{
+    class JobSystem
+    {
+    public:
+        // A thread count of 0 spawns one worker per hardware thread, minus the calling thread
+        explicit JobSystem(uint32_t threadCount = 0);
+        ~JobSystem();
+
+        JobSystem(const JobSystem&) = delete;
+        JobSystem& operator=(const JobSystem&) = delete;
+        JobSystem(JobSystem&&) = delete;
+        JobSystem& operator=(JobSystem&&) = delete;
+
+        uint32_t GetWorkerCount() const
+        {
+            return static_cast<uint32_t>(m_Workers.size());
+        }
+
+        // Threads taking part in ParallelFor: the workers plus the caller
+        uint32_t GetConcurrency() const
+        {
+            return GetWorkerCount() + 1;
+        }
+
+        // Splits [0, count) into batches of at least minBatchSize elements and blocks until every
+        // batch has run. The caller executes batches as well, so nested calls cannot deadlock.
+        void ParallelFor(size_t count, size_t minBatchSize, const std::function<void(size_t begin, size_t end)>& function);
+
+        // Runs the job on a worker without waiting for it, or right away on the caller when there are no workers
+        void Submit(std::function<void()> job);
+
+    private:
+        void WorkerLoop();
+        void Enqueue(std::function<void()> job);
+
+        std::vector<std::thread> m_Workers;
+        std::deque<std::function<void()>> m_Jobs;
+        std::mutex m_Mutex;
+        std::condition_variable m_Condition;
+        bool m_Stopping = false;
+    };
+}
@@ -0,0 +1,202 @@
+#pragma once
+
+#include <spdlog/sinks/sink.h>
+#include <spdlog/spdlog.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Log levels, numbered like spdlog's so they convert directly
+#define MINIENGINE_LOG_LEVEL_TRACE    0
+#define MINIENGINE_LOG_LEVEL_DEBUG    1
+#define MINIENGINE_LOG_LEVEL_INFO     2
+#define MINIENGINE_LOG_LEVEL_WARN     3
+#define MINIENGINE_LOG_LEVEL_ERROR    4
+#define MINIENGINE_LOG_LEVEL_CRITICAL 5
+#define MINIENGINE_LOG_LEVEL_OFF      6
+
+// Calls below the active level compile to nothing, arguments included. Release builds keep info
+// and above unless the build sets the level explicitly.
+#ifndef MINIENGINE_ACTIVE_LOG_LEVEL
+#ifdef NDEBUG
+#define MINIENGINE_ACTIVE_LOG_LEVEL MINIENGINE_LOG_LEVEL_INFO
+#else
+#define MINIENGINE_ACTIVE_LOG_LEVEL MINIENGINE_LOG_LEVEL_TRACE
+#endif
+#endif
+
+// Logs at most once per interval from one call site, for messages that would otherwise repeat every
+// frame. The first message after a quiet period reports how many were skipped in between.
+#define MINIENGINE_LOG_RATE_LIMITED_IMPL(level, intervalMs, ...)                                              \
+    do                                                                                                        \
+    {                                                                                                         \
+        static ::MiniEngine::Core::LogRateLimiter miniEngineRateLimiter(intervalMs);                          \
+        uint32_t miniEngineSuppressed = 0;                                                                    \
+        if (miniEngineRateLimiter.ShouldLog(miniEngineSuppressed))                                            \
+        {                                                                                                     \
+            if (miniEngineSuppressed == 0)                                                                    \
+            {                                                                                                 \
+                spdlog::log(level, __VA_ARGS__);                                                              \
+            }                                                                                                 \
+            else                                                                                              \
+            {                                                                                                 \
+                spdlog::log(level, "{} ({} more suppressed)", fmt::format(__VA_ARGS__), miniEngineSuppressed); \
+            }                                                                                                 \
+        }                                                                                                     \
+    } while (false)
+
+#if MINIENGINE_ACTIVE_LOG_LEVEL <= MINIENGINE_LOG_LEVEL_TRACE
+#define MINIENGINE_LOG_TRACE(...) spdlog::trace(__VA_ARGS__)
+#define MINIENGINE_LOG_TRACE_RATE_LIMITED(intervalMs, ...) MINIENGINE_LOG_RATE_LIMITED_IMPL(spdlog::level::trace, intervalMs, __VA_ARGS__)
+#else
+#define MINIENGINE_LOG_TRACE(...) (void)0
+#define MINIENGINE_LOG_TRACE_RATE_LIMITED(intervalMs, ...) (void)0
+#endif
+
+#if MINIENGINE_ACTIVE_LOG_LEVEL <= MINIENGINE_LOG_LEVEL_DEBUG
+#define MINIENGINE_LOG_DEBUG(...) spdlog::debug(__VA_ARGS__)
+#define MINIENGINE_LOG_DEBUG_RATE_LIMITED(intervalMs, ...) MINIENGINE_LOG_RATE_LIMITED_IMPL(spdlog::level::debug, intervalMs, __VA_ARGS__)
+#else
+#define MINIENGINE_LOG_DEBUG(...) (void)0
+#define MINIENGINE_LOG_DEBUG_RATE_LIMITED(intervalMs, ...) (void)0
+#endif
+
+#if MINIENGINE_ACTIVE_LOG_LEVEL <= MINIENGINE_LOG_LEVEL_INFO
+#define MINIENGINE_LOG_INFO(...) spdlog::info(__VA_ARGS__)
+#define MINIENGINE_LOG_INFO_RATE_LIMITED(intervalMs, ...) MINIENGINE_LOG_RATE_LIMITED_IMPL(spdlog::level::info, intervalMs, __VA_ARGS__)
+#else
+#define MINIENGINE_LOG_INFO(...) (void)0
+#define MINIENGINE_LOG_INFO_RATE_LIMITED(intervalMs, ...) (void)0
+#endif
+
+#if MINIENGINE_ACTIVE_LOG_LEVEL <= MINIENGINE_LOG_LEVEL_WARN
+#define MINIENGINE_LOG_WARN(...) spdlog::warn(__VA_ARGS__)
+#define MINIENGINE_LOG_WARN_RATE_LIMITED(intervalMs, ...) MINIENGINE_LOG_RATE_LIMITED_IMPL(spdlog::level::warn, intervalMs, __VA_ARGS__)
+#else
+#define MINIENGINE_LOG_WARN(...) (void)0
+#define MINIENGINE_LOG_WARN_RATE_LIMITED(intervalMs, ...) (void)0
+#endif
+
+#if MINIENGINE_ACTIVE_LOG_LEVEL <= MINIENGINE_LOG_LEVEL_ERROR
+#define MINIENGINE_LOG_ERROR(...) spdlog::error(__VA_ARGS__)
+#define MINIENGINE_LOG_ERROR_RATE_LIMITED(intervalMs, ...) MINIENGINE_LOG_RATE_LIMITED_IMPL(spdlog::level::err, intervalMs, __VA_ARGS__)
+#else
+#define MINIENGINE_LOG_ERROR(...) (void)0
+#define MINIENGINE_LOG_ERROR_RATE_LIMITED(intervalMs, ...) (void)0
+#endif
+
+#if MINIENGINE_ACTIVE_LOG_LEVEL <= MINIENGINE_LOG_LEVEL_CRITICAL
+#define MINIENGINE_LOG_CRITICAL(...) spdlog::critical(__VA_ARGS__)
+#else
+#define MINIENGINE_LOG_CRITICAL(...) (void)0
+#endif
+
+namespace MiniEngine::Core
+{
+    // Per call site state of the rate-limited macros. Thread-safe without locks: concurrent callers
+    // race for the next slot and exactly one of them wins it.
+    class LogRateLimiter
+    {
+    public:
+        explicit LogRateLimiter(uint32_t intervalMs);
+
+        // True when the caller should log now; suppressed receives the calls skipped since the last one that logged
+        bool ShouldLog(uint32_t& suppressed);
+
+    private:
+        int64_t m_IntervalNs = 0;
+        std::atomic<int64_t> m_NextNs = 0;
+        std::atomic<uint32_t> m_Suppressed = 0;
+    };
+
+    struct AsyncLogStats
+    {
+        uint64_t queued    = 0;
+        uint64_t written   = 0;
+        uint64_t dropped   = 0; // The queue was full; logging never blocks the caller
+        uint64_t truncated = 0; // Longer than a queue slot, cut to fit
+    };
+
+    // A spdlog sink that hands messages to a worker thread through a bounded lock-free queue. The
+    // calling thread only copies the already formatted text into a slot; the pattern formatting
+    // (time, level, colors) and the writes of the wrapped sinks happen on the worker.
+    class AsyncLogSink final : public spdlog::sinks::sink
+    {
+    public:
+        static constexpr size_t MaxMessageLength = 480;
+        static constexpr size_t MaxLoggerNameLength = 31;
+
+        // The capacity is rounded up to a power of two
+        AsyncLogSink(std::vector<spdlog::sink_ptr> sinks, size_t capacity);
+        ~AsyncLogSink() override;
+
+        AsyncLogSink(const AsyncLogSink&) = delete;
+        AsyncLogSink& operator=(const AsyncLogSink&) = delete;
+        AsyncLogSink(AsyncLogSink&&) = delete;
+        AsyncLogSink& operator=(AsyncLogSink&&) = delete;
+
+        void log(const spdlog::details::log_msg& message) override;
+
+        // Blocks until everything queued so far is written, then flushes the wrapped sinks
+        void flush() override;
+        void set_pattern(const std::string& pattern) override;
+        void set_formatter(std::unique_ptr<spdlog::formatter> formatter) override;
+
+        AsyncLogStats GetStats() const;
+
+    private:
+        struct Slot
+        {
+            std::atomic<size_t> sequence = 0;
+            spdlog::log_clock::time_point time;
+            size_t threadId = 0;
+            spdlog::level::level_enum level = spdlog::level::info;
+            uint16_t loggerNameLength = 0;
+            uint16_t messageLength = 0;
+            char loggerName[MaxLoggerNameLength];
+            char message[MaxMessageLength];
+        };
+
+        void WorkerLoop();
+        bool WriteNext();
+
+        std::vector<spdlog::sink_ptr> m_Sinks;
+        std::unique_ptr<Slot[]> m_Slots;
+        size_t m_Mask = 0;
+
+        // Producers claim slots by advancing the tail; the single worker consumes from the head
+        alignas(64) std::atomic<size_t> m_Tail = 0;
+        alignas(64) std::atomic<size_t> m_Head = 0;
+        alignas(64) std::atomic<uint32_t> m_Signal = 0; // Bumped on every push, the worker sleeps on it
+        std::atomic<bool> m_WorkerWaiting = false;       // Producers only pay for a wake-up while it sleeps
+        std::atomic<bool> m_Stopping = false;
+
+        std::atomic<uint64_t> m_Dropped = 0;
+        std::atomic<uint64_t> m_Truncated = 0;
+        std::atomic<uint64_t> m_Written = 0;
+
+        std::thread m_Worker;
+    };
+
+    struct LogSettings
+    {
+        spdlog::level::level_enum level = MINIENGINE_ACTIVE_LOG_LEVEL <= MINIENGINE_LOG_LEVEL_DEBUG ? spdlog::level::debug : spdlog::level::info;
+        bool   async         = true;
+        size_t queueCapacity = 4096;
+    };
+
+    // Replaces the default spdlog logger with a colored console logger, written through an
+    // AsyncLogSink unless async is off. Existing spdlog:: calls go through it unchanged.
+    void InitializeLogging(const LogSettings& settings = {});
+
+    // Writes out whatever is still queued and stops the worker
+    void ShutdownLogging();
+
+    // The sink installed by InitializeLogging, nullptr when logging is synchronous
+    std::shared_ptr<AsyncLogSink> GetAsyncLogSink();
+}
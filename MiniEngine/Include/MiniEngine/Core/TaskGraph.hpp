@@ -0,0 +1,96 @@
+#pragma once
+
+#include "MiniEngine/Core/JobSystem.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace MiniEngine::Core
+{
+    enum class TaskThread
+    {
+        Any,  // A job system worker, or the thread calling Run
+        Main  // Only the thread calling Run, for APIs bound to it such as window creation
+    };
+
+    struct TaskTiming
+    {
+        std::string name;
+        double      startMs    = 0.0; // Since the graph's origin
+        double      durationMs = 0.0;
+        uint32_t    thread     = 0;   // 0 is the thread that called Run, workers count up from 1 as they join in
+        bool        succeeded  = false;
+        bool        skipped    = false; // Never ran because a dependency failed
+    };
+
+    // Work split into named tasks that declare what they depend on. Run starts every task as soon as
+    // its dependencies have finished, so independent tasks overlap across the job system's workers,
+    // and records when and where each one ran. A task that fails, by returning false or throwing,
+    // skips everything depending on it. Tasks may be added after a run and run in a later one, but
+    // not while one is in progress.
+    class TaskGraph
+    {
+    public:
+        using TaskId = uint32_t;
+        using Clock = std::chrono::steady_clock;
+
+        // Timings are measured from origin, so several graphs, or work outside them, share a timeline
+        explicit TaskGraph(Clock::time_point origin = Clock::now());
+
+        TaskGraph(const TaskGraph&) = delete;
+        TaskGraph& operator=(const TaskGraph&) = delete;
+        TaskGraph(TaskGraph&&) = delete;
+        TaskGraph& operator=(TaskGraph&&) = delete;
+
+        // Dependencies must be tasks added before this one
+        TaskId Add(std::string name, std::function<bool()> function, std::initializer_list<TaskId> dependencies = {}, TaskThread thread = TaskThread::Any);
+
+        // Runs the tasks added since the last run and returns once all of them are done; false if any
+        // failed or was skipped. Without a job system, or one without workers, they run one at a time
+        // on the caller, in an order that respects the dependencies.
+        bool Run(JobSystem* jobs);
+
+        // Adds work done outside the graph to the timeline, as thread 0. Not while a run is in progress.
+        void Record(std::string name, Clock::time_point start, Clock::time_point end, bool succeeded = true);
+
+        // Tasks and recorded work, in the order they were added
+        const std::vector<TaskTiming>& GetTimeline() const
+        {
+            return m_Timeline;
+        }
+
+        double GetElapsedMs() const;
+
+        // Chrome trace event JSON, for chrome://tracing or Perfetto. Logs why and returns false on failure.
+        bool WriteChromeTrace(const std::filesystem::path& path) const;
+
+    private:
+        struct Task
+        {
+            std::function<bool()> function;
+            std::vector<TaskId>    dependents;
+            uint32_t               dependencyCount = 0;
+            TaskThread             thread = TaskThread::Any;
+            bool                   finished = false;
+            bool                   failed = false;
+            size_t                 timing = 0; // Index into m_Timeline
+        };
+
+        struct RunState;
+
+        static void Help(const std::shared_ptr<RunState>& state);
+        static void SubmitHelpers(const std::shared_ptr<RunState>& state, uint32_t count);
+        uint32_t Execute(RunState& state, TaskId id); // Returns how many worker tasks it made ready
+
+        Clock::time_point m_Origin;
+        std::vector<Task> m_Tasks;
+        std::vector<TaskTiming> m_Timeline;
+        TaskId m_FirstPending = 0;
+    };
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace MiniEngine::Graphics
+{
+    // Passes are recorded in this order
+    enum class DrawPass : uint8_t
+    {
+        Opaque,
+        Transparent,
+    };
+
+    // Packs the state a draw needs into a key whose ascending order is the order to record draws in.
+    //   Opaque:      pass | pipeline | material | depth     front to back within each material
+    //   Transparent: pass | ~depth   | pipeline | material  back to front, state only breaks ties
+    // Values wider than their field are truncated.
+    namespace DrawKey
+    {
+        constexpr uint32_t PassBits     = 4;
+        constexpr uint32_t PipelineBits = 12;
+        constexpr uint32_t MaterialBits = 24;
+        constexpr uint32_t DepthBits    = 24;
+
+        constexpr uint32_t MaxPipeline = (1u << PipelineBits) - 1;
+        constexpr uint32_t MaxMaterial = (1u << MaterialBits) - 1;
+        constexpr uint32_t MaxDepth    = (1u << DepthBits) - 1;
+
+        constexpr uint64_t Make(DrawPass pass, uint32_t pipeline, uint32_t material, uint32_t depthBucket)
+        {
+            const uint64_t passField     = static_cast<uint64_t>(pass) << (64 - PassBits);
+            const uint64_t pipelineField = pipeline & MaxPipeline;
+            const uint64_t materialField = material & MaxMaterial;
+            const uint64_t depthField    = depthBucket & MaxDepth;
+
+            if (pass == DrawPass::Transparent)
+            {
+                return passField | ((MaxDepth - depthField) << (PipelineBits + MaterialBits)) | (pipelineField << MaterialBits) | materialField;
+            }
+            return passField | (pipelineField << (MaterialBits + DepthBits)) | (materialField << DepthBits) | depthField;
+        }
+
+        constexpr DrawPass GetPass(uint64_t key)
+        {
+            return static_cast<DrawPass>(key >> (64 - PassBits));
+        }
+
+        constexpr uint32_t GetPipeline(uint64_t key)
+        {
+            const uint32_t shift = GetPass(key) == DrawPass::Transparent ? MaterialBits : MaterialBits + DepthBits;
+            return static_cast<uint32_t>(key >> shift) & MaxPipeline;
+        }
+
+        constexpr uint32_t GetMaterial(uint64_t key)
+        {
+            const uint32_t shift = GetPass(key) == DrawPass::Transparent ? 0 : DepthBits;
+            return static_cast<uint32_t>(key >> shift) & MaxMaterial;
+        }
+
+        constexpr uint32_t GetDepthBucket(uint64_t key)
+        {
+            if (GetPass(key) == DrawPass::Transparent)
+            {
+                return MaxDepth - (static_cast<uint32_t>(key >> (PipelineBits + MaterialBits)) & MaxDepth);
+            }
+            return static_cast<uint32_t>(key) & MaxDepth;
+        }
+
+        // Quantizes a view-space distance linearly between the clip planes, clamping outside them
+        uint32_t MakeDepthBucket(float viewDepth, float nearPlane, float farPlane);
+    }
+
+    struct QueuedDraw
+    {
+        uint64_t key       = 0;
+        uint32_t drawIndex = 0; // Caller's index into its own draw data
+    };
+
+    // Bind calls needed to record draws in a given order, assuming every change of pipeline costs a
+    // pipeline bind and every change of pipeline or material costs a descriptor set bind
+    struct BindCounts
+    {
+        uint32_t pipelineBinds   = 0;
+        uint32_t descriptorBinds = 0;
+    };
+
+    BindCounts CountBinds(const QueuedDraw* draws, size_t count);
+
+    struct DrawQueueStats
+    {
+        uint32_t drawCount   = 0;
+        uint32_t radixPasses = 0; // Passes actually run, digits shared by every key are skipped
+        double   sortTimeMs  = 0.0;
+    };
+
+    // Collects a frame's draws and orders them by key with a stable least-significant-digit radix
+    // sort. Storage is kept between frames, so the steady state does not allocate.
+    class DrawQueue
+    {
+    public:
+        DrawQueue() = default;
+
+        DrawQueue(const DrawQueue&) = delete;
+        DrawQueue& operator=(const DrawQueue&) = delete;
+        DrawQueue(DrawQueue&&) = delete;
+        DrawQueue& operator=(DrawQueue&&) = delete;
+
+        void Reserve(size_t count);
+        void Clear();
+
+        void Submit(uint64_t key, uint32_t drawIndex)
+        {
+            m_Draws.push_back({ key, drawIndex });
+        }
+
+        void Sort();
+
+        const std::vector<QueuedDraw>& GetDraws() const
+        {
+            return m_Draws;
+        }
+
+        size_t GetDrawCount() const
+        {
+            return m_Draws.size();
+        }
+
+        const DrawQueueStats& GetStats() const
+        {
+            return m_Stats;
+        }
+
+    private:
+        std::vector<QueuedDraw> m_Draws;
+        std::vector<QueuedDraw> m_Scratch;
+        DrawQueueStats m_Stats;
+    };
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <span>
+#include <vector>
+
+namespace MiniEngine::Graphics
+{
+    struct FrameTraceStats
+    {
+        uint64_t frames       = 0;
+        uint64_t rawBytes     = 0; // What the frames held
+        uint64_t encodedBytes = 0; // What they took in the file
+    };
+
+    // A recording of what the renderer was asked to draw, frame by frame, for replaying it later.
+    // Each frame holds the same streams of fixed-size records, laid out however the application
+    // likes: a camera, the objects, the lights. The file stores a record only where it differs from
+    // the record at the same index in the previous frame, so what stays put costs a bit per record.
+    // Streams are raw bytes; a trace only replays on a build with the same record layouts.
+    class FrameTraceWriter
+    {
+    public:
+        FrameTraceWriter() = default;
+        ~FrameTraceWriter();
+
+        FrameTraceWriter(const FrameTraceWriter&) = delete;
+        FrameTraceWriter& operator=(const FrameTraceWriter&) = delete;
+        FrameTraceWriter(FrameTraceWriter&&) = delete;
+        FrameTraceWriter& operator=(FrameTraceWriter&&) = delete;
+
+        // One record size per stream. Logs why and returns false if the file cannot be created.
+        bool Open(const std::filesystem::path& path, std::span<const uint32_t> recordSizes);
+
+        // Records the frame count in the header; the trace is complete once this returns. Until then
+        // the count reads 0, and readers take the trace to be unfinished.
+        void Close();
+
+        bool IsOpen() const
+        {
+            return m_File != nullptr;
+        }
+
+        // One span per stream, each a whole number of records. Logs why and returns false on failure.
+        bool WriteFrame(std::span<const std::span<const uint8_t>> streams);
+
+        const FrameTraceStats& GetStats() const
+        {
+            return m_Stats;
+        }
+
+    private:
+        std::FILE* m_File = nullptr;
+        std::filesystem::path m_Path;
+        std::vector<uint32_t> m_RecordSizes;
+        std::vector<std::vector<uint8_t>> m_Previous;
+        std::vector<uint8_t> m_Encoded;
+        FrameTraceStats m_Stats;
+    };
+
+    class FrameTraceReader
+    {
+    public:
+        FrameTraceReader() = default;
+        ~FrameTraceReader();
+
+        FrameTraceReader(const FrameTraceReader&) = delete;
+        FrameTraceReader& operator=(const FrameTraceReader&) = delete;
+        FrameTraceReader(FrameTraceReader&&) = delete;
+        FrameTraceReader& operator=(FrameTraceReader&&) = delete;
+
+        // Fails, logging why, unless the trace has exactly the given record sizes
+        bool Open(const std::filesystem::path& path, std::span<const uint32_t> recordSizes);
+        void Close();
+
+        // 0 for a trace whose writer never closed it, like after a crash; its frames are then read up
+        // to the end of the file instead
+        uint64_t GetFrameCount() const
+        {
+            return m_FrameCount;
+        }
+
+        // Decodes the next frame. False at the end of the trace, or, logging why, on a damaged one.
+        // The last frame of an unfinished trace may be cut short, which ends it without an error.
+        bool ReadFrame();
+
+        // The last frame read; valid until the next ReadFrame
+        std::span<const uint8_t> GetStream(uint32_t stream) const
+        {
+            return m_Streams[stream];
+        }
+
+        // Starts over at the first frame
+        bool Rewind();
+
+    private:
+        bool Fail(const char* reason);
+        bool Truncated(bool unfinished); // A frame ran past the end of the file
+
+        std::FILE* m_File = nullptr;
+        std::filesystem::path m_Path;
+        std::vector<uint32_t> m_RecordSizes;
+        uint64_t m_FrameCount = 0;
+        uint64_t m_NextFrame = 0;
+        long m_FirstFrameOffset = 0;
+        uint64_t m_FileSize = 0;
+        std::vector<std::vector<uint8_t>> m_Streams;
+        std::vector<uint8_t> m_Mask;
+    };
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace MiniEngine::Graphics
+{
+    enum class ImageFileFormat
+    {
+        Png, // RGB, stored without compression so encoding costs little more than a copy
+        Pam  // Netpbm RGB, the pixels as they are behind a short text header
+    };
+
+    const char* ToString(ImageFileFormat format);
+
+    // Byte order of a 32-bit pixel in memory
+    enum class PixelLayout
+    {
+        Rgba8,
+        Bgra8
+    };
+
+    struct SequenceImage
+    {
+        const uint8_t* pixels   = nullptr;
+        uint32_t       width    = 0;
+        uint32_t       height   = 0;
+        uint32_t       rowPitch = 0; // Bytes from one row to the next
+        PixelLayout    layout   = PixelLayout::Rgba8;
+    };
+
+    struct ImageSequenceStats
+    {
+        uint64_t queued        = 0;
+        uint64_t written       = 0;
+        uint64_t failed        = 0;
+        uint64_t bytes         = 0; // Written to disk
+        double   encodeMs      = 0.0; // Converting and writing, summed over written images
+        size_t   maxQueueDepth = 0;
+    };
+
+    // Writes numbered image files from a thread of its own, so whoever produces the images only pays
+    // for queueing them. The writer reads the pixels where they are; the producer learns through a
+    // release callback when it may reuse the memory. Alpha is dropped.
+    class ImageSequenceWriter
+    {
+    public:
+        ImageSequenceWriter() = default;
+        ~ImageSequenceWriter();
+
+        ImageSequenceWriter(const ImageSequenceWriter&) = delete;
+        ImageSequenceWriter& operator=(const ImageSequenceWriter&) = delete;
+        ImageSequenceWriter(ImageSequenceWriter&&) = delete;
+        ImageSequenceWriter& operator=(ImageSequenceWriter&&) = delete;
+
+        // Creates the directory if needed; files are named frame_000000 onwards. Logs why and returns false on failure.
+        bool Start(const std::filesystem::path& directory, ImageFileFormat format);
+
+        // Writes everything still queued, then stops the thread
+        void Stop();
+
+        bool IsRunning() const
+        {
+            return m_Thread.joinable();
+        }
+
+        // Queues the next image of the sequence. Its pixels must stay valid until release runs on the
+        // writer's thread, which it does whether or not the file could be written.
+        void Write(const SequenceImage& image, std::function<void()> release);
+
+        ImageSequenceStats GetStats() const;
+
+    private:
+        struct Job
+        {
+            SequenceImage         image;
+            std::function<void()> release;
+            uint64_t              index = 0;
+        };
+
+        void WorkerLoop();
+        bool WriteImage(const Job& job);
+
+        std::filesystem::path m_Directory;
+        ImageFileFormat m_Format = ImageFileFormat::Png;
+        std::thread m_Thread;
+        mutable std::mutex m_Mutex;
+        std::condition_variable m_Condition;
+        std::deque<Job> m_Jobs;
+        bool m_Stopping = false;
+        ImageSequenceStats m_Stats;
+
+        // Only touched by the writer's thread
+        std::vector<uint8_t> m_Rows;    // RGB rows, each behind a PNG filter byte when writing PNG
+        std::vector<uint8_t> m_Encoded;
+    };
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace MiniEngine::Graphics
+{
+    // One level of detail: a range of the mesh's index buffer, drawn with the vertices all levels share
+    struct MeshLod
+    {
+        uint32_t firstIndex = 0;
+        uint32_t indexCount = 0;
+        float    error      = 0.0f; // How far the surface may have moved from the full detail mesh, in mesh units
+    };
+
+    struct MeshLodSettings
+    {
+        uint32_t maxLevels    = 6;    // Including the full detail mesh
+        float    reduction    = 0.5f; // Fraction of the triangles one level keeps of the one before
+        uint32_t minTriangles = 8;    // No level goes below this
+    };
+
+    // Builds a chain of ever coarser levels by quadric error simplification, for meshes to be drawn
+    // at less detail as they get smaller on screen. Each level collapses edges of the one before onto
+    // one of their own vertices, so every level indexes the original vertices and no new ones are
+    // made; mesh borders only collapse along themselves. Level 0 is the indices as given; the others
+    // are appended to indices. The chain stops early once simplifying no longer gets close to the
+    // reduction asked for. positions points at the first vertex's position, three floats, with
+    // vertexStride bytes from one vertex to the next. Throws std::invalid_argument if the indices are
+    // not whole triangles of existing vertices.
+    std::vector<MeshLod> BuildMeshLods(std::vector<uint32_t>& indices, const float* positions, size_t vertexCount, size_t vertexStride,
+                                       const MeshLodSettings& settings = {});
+
+    // Picks the level to draw an instance at: the coarsest whose error covers at most thresholdPixels
+    // on screen, given how many pixels a mesh unit covers where the instance is. Going coarser than
+    // currentLod also needs the error to be under the threshold by the hysteresis fraction, so an
+    // instance at the boundary between two levels does not switch back and forth every frame.
+    uint32_t SelectMeshLod(std::span<const MeshLod> lods, float pixelsPerUnit, uint32_t currentLod, float thresholdPixels, float hysteresis);
+}
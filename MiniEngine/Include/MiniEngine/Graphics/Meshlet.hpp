@@ -0,0 +1,42 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace MiniEngine::Graphics
+{
+    // A small cluster of a mesh's triangles, with what it takes to cull it as a whole. Laid out to be
+    // uploaded to a std430 buffer as is.
+    struct Meshlet
+    {
+        glm::vec3 center{ 0.0f };                // Bounding sphere, in mesh units
+        float     radius = 0.0f;
+        glm::vec3 coneAxis{ 0.0f, 0.0f, 1.0f };  // Average facing of the triangles
+        float     coneCutoff = 1.0f;             // Sine of the cone's half angle; 1 when it is too wide to ever face away
+        uint32_t  firstIndex = 0;                // Into the mesh's index buffer
+        uint32_t  indexCount = 0;
+        uint32_t  vertexCount = 0;               // Distinct vertices the triangles use
+        uint32_t  padding = 0;
+    };
+
+    struct MeshletLimits
+    {
+        uint32_t maxVertices  = 64;
+        uint32_t maxTriangles = 124;
+    };
+
+    // Splits a range of an index buffer into meshlets, growing each from a seed triangle through its
+    // neighbours while it stays within the limits, preferring triangles that add the fewest vertices.
+    // indices is the range, starting at firstIndex in the whole buffer, and is reordered in place so
+    // each meshlet's triangles are contiguous. Front faces wind counter-clockwise; a meshlet is facing
+    // away from a viewer at v when dot(center - v, coneAxis) >= coneCutoff * length(center - v) + radius.
+    // positions points at the first vertex's position, three floats, with vertexStride bytes from one
+    // vertex to the next. Throws std::invalid_argument if the range is not whole triangles of existing
+    // vertices or the limits cannot hold a triangle.
+    std::vector<Meshlet> BuildMeshlets(std::span<uint32_t> indices, uint32_t firstIndex, const float* positions, size_t vertexCount,
+                                       size_t vertexStride, const MeshletLimits& limits = {});
+}
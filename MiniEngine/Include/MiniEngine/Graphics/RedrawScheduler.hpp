@@ -0,0 +1,132 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+struct GLFWwindow;
+
+namespace MiniEngine::Graphics
+{
+    enum class RedrawMode : uint8_t
+    {
+        Continuous, // Every WaitForRedraw polls and asks for a frame
+        OnDemand    // WaitForRedraw sleeps until input, a resize, an invalidation or an animation needs one
+    };
+
+    const char* ToString(RedrawMode mode);
+
+    // A rectangle in framebuffer pixels
+    struct RedrawRegion
+    {
+        int32_t  x      = 0;
+        int32_t  y      = 0;
+        uint32_t width  = 0;
+        uint32_t height = 0;
+
+        bool IsEmpty() const
+        {
+            return width == 0 || height == 0;
+        }
+
+        // The smallest rectangle holding both
+        RedrawRegion Union(const RedrawRegion& other) const;
+    };
+
+    // One frame to render, as WaitForRedraw hands it out
+    struct Redraw
+    {
+        RedrawRegion                          region; // Within the framebuffer; everything when full is set
+        bool                                  full = false;
+        std::chrono::steady_clock::time_point wakeTime; // When the wait ended, or the poll for continuous frames
+        bool                                  idle = false; // Since the last frame the loop slept with nothing animating
+    };
+
+    struct RedrawStats
+    {
+        uint64_t frames             = 0;
+        uint64_t wakeups            = 0;   // Waits that ended, whether or not a frame followed
+        double   idleSeconds        = 0.0; // Wall time spent waiting for events
+        double   idleCpuSeconds     = 0.0; // CPU time the whole process used meanwhile
+        uint64_t presents           = 0;
+        double   wakeToPresentMs    = 0.0; // Summed over the presents
+        double   maxWakeToPresentMs = 0.0;
+    };
+
+    // Decides when a window needs a new frame. In continuous mode that is always; on demand the
+    // loop sleeps in glfwWaitEvents until the window sees input or a resize, someone invalidates
+    // it, or an animation is due. Animations keep part of the framebuffer redrawing at an interval
+    // of their own while the rest stays idle. All totals in the stats are cumulative.
+    //
+    // WaitForRedraw, Attach and SetMode belong to the thread that owns the window; Invalidate,
+    // RequestQuit, the animations, NotifyPresented and GetStats may be called from any thread.
+    class RedrawScheduler
+    {
+    public:
+        explicit RedrawScheduler(RedrawMode mode = RedrawMode::Continuous);
+
+        RedrawScheduler(const RedrawScheduler&) = delete;
+        RedrawScheduler& operator=(const RedrawScheduler&) = delete;
+        RedrawScheduler(RedrawScheduler&&) = delete;
+        RedrawScheduler& operator=(RedrawScheduler&&) = delete;
+
+        // Installs input, resize and refresh callbacks that invalidate the whole framebuffer. Takes
+        // over the window's user pointer; pass null to detach before the window is destroyed.
+        void Attach(GLFWwindow* window);
+
+        void SetMode(RedrawMode mode);
+        RedrawMode GetMode() const;
+
+        // Queues a redraw of the whole framebuffer or part of it and wakes the waiting thread
+        void Invalidate();
+        void Invalidate(const RedrawRegion& region);
+
+        // Asks the thread that owns the window to close it, which GLFW allows no other thread to do.
+        // Wakes it like Invalidate; from then on WaitForRedraw returns false without waiting.
+        void RequestQuit();
+        bool IsQuitRequested() const;
+
+        // Redraws region every interval seconds, or every frame when interval is 0; an empty region
+        // stands for the whole framebuffer. Returns the id to remove it with.
+        uint32_t AddAnimation(const RedrawRegion& region, double interval);
+        void RemoveAnimation(uint32_t id);
+
+        // Processes events, sleeping first when on demand and nothing is due. True with the frame
+        // to render, false when the wait ended without one, like on a close or quit request.
+        bool WaitForRedraw(Redraw& redraw);
+
+        // Call once the frame is queued for presentation, on any thread, to measure wake-to-present latency
+        void NotifyPresented(const Redraw& redraw);
+
+        RedrawStats GetStats() const;
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        struct Animation
+        {
+            uint32_t          id       = 0;
+            RedrawRegion      region;
+            double            interval = 0.0;
+            Clock::time_point due;
+        };
+
+        static void InvalidateWindow(GLFWwindow* window); // From the window's callbacks
+        void InvalidateAll();
+        void SetFramebufferSize(int width, int height);
+        bool TakeRedraw(Redraw& redraw, Clock::time_point now); // Called with m_Mutex held
+
+        mutable std::mutex m_Mutex;
+        GLFWwindow* m_Window = nullptr;
+        RedrawMode m_Mode;
+        RedrawRegion m_Framebuffer;
+        RedrawRegion m_Dirty;
+        bool m_DirtyAll = true; // The first frame always draws
+        bool m_QuitRequested = false;
+        bool m_Idle = false; // Slept for events with no animation to wake for since the last frame
+        std::vector<Animation> m_Animations;
+        uint32_t m_NextAnimationId = 1;
+        RedrawStats m_Stats;
+    };
+}
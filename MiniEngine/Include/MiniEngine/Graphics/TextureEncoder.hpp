@@ -0,0 +1,69 @@
+#pragma once
+
+#include "MiniEngine/Core/CpuFeatures.hpp"
+#include "MiniEngine/Core/JobSystem.hpp"
+#include "MiniEngine/Graphics/TextureFile.hpp"
+
+#include <cstdint>
+
+namespace MiniEngine::Graphics
+{
+    // How hard the encoder searches for each block's endpoints
+    enum class TextureEncodeQuality
+    {
+        Fast,   // The texels' principal axis, quantized
+        Normal, // Refined once by least squares
+        High,   // Refined until it stops improving, then each endpoint nudged a step at a time
+    };
+
+    const char* ToString(TextureEncodeQuality quality);
+
+    // BC1, BC3 and BC7 in either colour space, BC4 and BC5 unorm
+    bool CanEncodeTexture(TextureFormat format);
+
+    // How many of the RGBA channels the format keeps, from red onwards: 3 for BC1, whose alpha the
+    // encoder leaves opaque, 1 for BC4, 2 for BC5 and 4 otherwise
+    uint32_t GetEncodedChannelCount(TextureFormat format);
+
+    // Compresses RGBA8 images into 4x4 blocks. The inner loop, matching texels to the points between
+    // a block's endpoints, runs on the widest kernels the CPU supports; blocks are independent, so
+    // block rows are spread over a job system when one is given. sRGB formats store the texels as
+    // given; only the format's tag differs. Each BC7 block is tried in mode 6, one subset with RGBA
+    // endpoints, mode 5, with alpha fitted apart from colour, and on opaque blocks mode 1, two
+    // subsets of colour, and written in whichever decodes closest. Every kernel rounds alike, so the
+    // output is the same whichever instruction set encoded it.
+    class TextureEncoder
+    {
+    public:
+        // Picks the widest kernel the CPU supports
+        TextureEncoder();
+        explicit TextureEncoder(Core::SimdLevel simdLevel);
+
+        Core::SimdLevel GetSimdLevel() const
+        {
+            return m_SimdLevel;
+        }
+
+        // Requests above what the CPU supports are clamped
+        void SetSimdLevel(Core::SimdLevel simdLevel);
+
+        // Writes GetTextureLevelSize(format, width, height) bytes of blocks to destination. rgba holds
+        // width * height texels, rows packed; blocks past the right or bottom edge repeat the last
+        // column or row. Throws std::invalid_argument for formats CanEncodeTexture rejects.
+        void Encode(TextureFormat format, TextureEncodeQuality quality, const uint8_t* rgba, uint32_t width, uint32_t height, void* destination,
+                    Core::JobSystem* jobs = nullptr) const;
+
+    private:
+        Core::SimdLevel m_SimdLevel = Core::SimdLevel::Scalar;
+    };
+
+    // Expands blocks of a format CanEncodeTexture accepts back into RGBA8, for checking what the GPU
+    // will sample. Channels the format lacks come out as 0, alpha as 255. Of BC7, the modes the
+    // encoder writes (1, 5 and 6) are decoded; others come out as zero, as reserved modes do. Throws
+    // std::invalid_argument for other formats.
+    void DecodeTexture(TextureFormat format, const void* blocks, uint32_t width, uint32_t height, uint8_t* rgba);
+
+    // Peak signal to noise ratio between two RGBA8 images over their first channelCount channels, in
+    // decibels; infinite when they are identical
+    double ComputePsnr(const uint8_t* reference, const uint8_t* image, uint32_t width, uint32_t height, uint32_t channelCount);
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <vector>
+
+namespace MiniEngine::Graphics
+{
+    // The formats texture files may hold, numbered like VkFormat so they convert directly
+    enum class TextureFormat : uint32_t
+    {
+        Undefined     = 0,
+        R8G8B8A8Unorm = 37,
+        R8G8B8A8Srgb  = 43,
+        B8G8R8A8Unorm = 44,
+        B8G8R8A8Srgb  = 50,
+        Bc1RgbaUnorm  = 133,
+        Bc1RgbaSrgb   = 134,
+        Bc2Unorm      = 135,
+        Bc2Srgb       = 136,
+        Bc3Unorm      = 137,
+        Bc3Srgb       = 138,
+        Bc4Unorm      = 139,
+        Bc4Snorm      = 140,
+        Bc5Unorm      = 141,
+        Bc5Snorm      = 142,
+        Bc6hUfloat    = 143,
+        Bc6hSfloat    = 144,
+        Bc7Unorm      = 145,
+        Bc7Srgb       = 146
+    };
+
+    const char* ToString(TextureFormat format);
+
+    // Block compressed formats store 4x4 texel blocks
+    bool IsBlockCompressed(TextureFormat format);
+    bool IsSrgb(TextureFormat format);
+
+    // Bytes per 4x4 block for block compressed formats, per texel otherwise; 0 for unknown formats
+    uint32_t GetBytesPerBlock(TextureFormat format);
+
+    uint64_t GetTextureLevelSize(TextureFormat format, uint32_t width, uint32_t height);
+
+    // Levels down to 1x1
+    uint32_t GetFullMipCount(uint32_t width, uint32_t height);
+
+    enum class TextureContainer : uint8_t
+    {
+        Ktx2,
+        Dds
+    };
+
+    struct TextureLevel
+    {
+        uint32_t width      = 0;
+        uint32_t height     = 0;
+        uint64_t size       = 0;
+        uint64_t fileOffset = 0;
+        uint64_t dataOffset = 0; // Where ReadLevels puts it, aligned for buffer to image copies
+    };
+
+    // A 2D texture with its mip levels, largest first
+    struct TextureDescription
+    {
+        TextureFormat             format       = TextureFormat::Undefined;
+        uint32_t                  width        = 0;
+        uint32_t                  height       = 0;
+        std::vector<TextureLevel> levels;
+        uint64_t                  dataSize     = 0; // All levels as ReadLevels lays them out
+        bool                      generateMips = false; // Uncompressed with fewer levels than a full chain: the rest are left to the GPU
+    };
+
+    // Lays out levelCount levels of the given format and size back to back, as WriteTextureFile expects
+    // its data. generateMips is left false.
+    TextureDescription MakeTextureDescription(TextureFormat format, uint32_t width, uint32_t height, uint32_t levelCount);
+
+    // A KTX2 or DDS file holding a single 2D texture, read without any conversion so compressed
+    // levels go from the file straight into upload memory. KTX2 files must not be supercompressed.
+    class TextureFile
+    {
+    public:
+        TextureFile() = default;
+        ~TextureFile();
+
+        TextureFile(const TextureFile&) = delete;
+        TextureFile& operator=(const TextureFile&) = delete;
+        TextureFile(TextureFile&&) = delete;
+        TextureFile& operator=(TextureFile&&) = delete;
+
+        // Parses the header, leaving the level data on disk. Logs why and returns false on files it cannot read.
+        bool Open(const std::filesystem::path& path);
+        void Close();
+
+        const TextureDescription& GetDescription() const
+        {
+            return m_Description;
+        }
+
+        // Reads every level to destination + its dataOffset; destination holds the description's dataSize bytes
+        bool ReadLevels(void* destination);
+
+    private:
+        bool ParseKtx2();
+        bool ParseDds();
+        bool Fail(const char* reason);
+
+        std::FILE* m_File = nullptr;
+        uint64_t m_FileSize = 0;
+        std::filesystem::path m_Path;
+        TextureDescription m_Description;
+    };
+
+    // Writes a description made by MakeTextureDescription and its packed level data. Logs why and returns false on failure.
+    bool WriteTextureFile(const std::filesystem::path& path, TextureContainer container, const TextureDescription& description, const void* data);
+}
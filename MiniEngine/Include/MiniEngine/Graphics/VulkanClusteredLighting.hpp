@@ -0,0 +1,187 @@
+#pragma once
+
+#include "MiniEngine/Graphics/VulkanContext.hpp"
+
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.h>
+#include <vk_mem_alloc.h>
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace MiniEngine::Graphics
+{
+    class VulkanCommandEncoder;
+
+    // A light as the binning and lit shaders read it (std430 layout)
+    struct ClusteredLight
+    {
+        glm::vec4 positionRange;   // View space position, range in w
+        glm::vec4 directionCosine; // View space spot direction, cosine of the cone half angle in w (-1 for point lights)
+        glm::vec4 color;
+    };
+
+    // The camera the lights are binned for
+    struct LightingCamera
+    {
+        glm::mat4 view       = glm::mat4(1.0f);
+        glm::mat4 projection = glm::mat4(1.0f);
+        float     nearPlane  = 0.1f;
+        float     farPlane   = 200.0f;
+    };
+
+    // Results gathered from finished frames
+    struct LightingStats
+    {
+        uint32_t lightCount    = 0;
+        uint32_t lightIndices  = 0;            // Entries in all cluster lists of the last finished frame
+        double   gpuBinMs      = 0.0;          // Smoothed binning dispatch
+        double   gpuFrameMs[2] = { 0.0, 0.0 }; // Smoothed GPU time from binning to the end of the frame, naive / clustered
+        uint32_t samples[2]    = { 0, 0 };
+    };
+
+    // Clustered forward lighting. The view frustum is split into froxels, screen tiles cut by
+    // exponentially spaced depth slices. A compute pass bins the frame's lights into them, writing
+    // one compact index list per cluster, and the lit shader only evaluates the lights listed for
+    // the cluster its fragment falls in. The graphics pipeline reads them through the lighting set,
+    // whose layout this class owns.
+    class VulkanClusteredLighting
+    {
+    public:
+        static constexpr uint32_t GridSizeX           = 16;
+        static constexpr uint32_t GridSizeY           = 9;
+        static constexpr uint32_t GridSizeZ           = 24;
+        static constexpr uint32_t ClusterCount        = GridSizeX * GridSizeY * GridSizeZ;
+        static constexpr uint32_t MaxLightsPerCluster = 256; // Must match light_cull.comp
+
+        VulkanClusteredLighting() = default;
+        ~VulkanClusteredLighting();
+
+        VulkanClusteredLighting(const VulkanClusteredLighting&) = delete;
+        VulkanClusteredLighting& operator=(const VulkanClusteredLighting&) = delete;
+        VulkanClusteredLighting(VulkanClusteredLighting&&) = delete;
+        VulkanClusteredLighting& operator=(VulkanClusteredLighting&&) = delete;
+
+        bool Initialize(const VulkanContext& context, const std::string& cullShader);
+
+        // Call once the device is idle
+        void Destroy();
+
+        // Off, every fragment is shaded with every light and binning records nothing
+        void SetClustered(bool clustered)
+        {
+            m_Clustered = clustered;
+        }
+
+        bool IsClustered() const
+        {
+            return m_Clustered;
+        }
+
+        VkDescriptorSetLayout GetSetLayout() const
+        {
+            return m_SetLayout;
+        }
+
+        // Nanoseconds per tick, 0 when the graphics queue has no timestamps
+        float GetTimestampPeriod() const
+        {
+            return m_TimestampPeriod;
+        }
+
+        const LightingStats& GetStats() const
+        {
+            return m_Stats;
+        }
+
+        // Starts the smoothed times over, e.g. once a new configuration has settled
+        void ResetStats()
+        {
+            m_Stats = {};
+        }
+
+        // Once the frame's fence has signaled: collects what its last submission measured, then
+        // uploads the lights and the cluster grid for the camera and the render extent
+        bool PrepareFrame(uint32_t frame, std::span<const ClusteredLight> lights, const LightingCamera& camera, VkExtent2D extent);
+
+        // Once the frame's commands are submitted
+        void MarkSubmitted(uint32_t frame)
+        {
+            m_Frames[frame].submitted = true;
+        }
+
+        // What recorded commands depend on: they stay valid while both are unchanged
+        uint32_t GetLightCapacity(uint32_t frame) const
+        {
+            return m_Frames[frame].lightCapacity;
+        }
+
+        bool IsClusteredFor(uint32_t frame) const
+        {
+            return m_Frames[frame].clustered;
+        }
+
+        VkDescriptorSet GetDescriptorSet(uint32_t frame) const
+        {
+            return m_Frames[frame].descriptorSet;
+        }
+
+        // Before the first render pass: rebuilds the cluster lists from the frame's lights, one
+        // workgroup per cluster. Unclustered, only the timestamps are written, so both modes measure
+        // the frame from the same point.
+        void RecordBinning(VulkanCommandEncoder& encoder, uint32_t frame);
+
+        // After the frame's last draw, for the GPU frame time
+        void RecordFrameEnd(VkCommandBuffer commandBuffer, uint32_t frame);
+
+        // Shrinks the light buffer of a frame that is not in flight to what its last submission
+        // needed, if it is more than twice that. Returns the bytes released; recorded commands using
+        // the frame are stale when it is not 0.
+        VkDeviceSize Trim(uint32_t frame);
+
+    private:
+        // Resources owned by one frame in flight
+        struct Frame
+        {
+            VkBuffer        uniformBuffer        = VK_NULL_HANDLE;
+            VmaAllocation   uniformAllocation    = VK_NULL_HANDLE;
+            void*           uniformMapped        = nullptr;
+            VkBuffer        lightBuffer          = VK_NULL_HANDLE;
+            VmaAllocation   lightAllocation      = VK_NULL_HANDLE;
+            void*           lightMapped          = nullptr;
+            VkBuffer        clusterBuffer        = VK_NULL_HANDLE;
+            VmaAllocation   clusterAllocation    = VK_NULL_HANDLE;
+            VkBuffer        lightIndexBuffer     = VK_NULL_HANDLE; // Every cluster's lights, packed back to back
+            VmaAllocation   lightIndexAllocation = VK_NULL_HANDLE;
+            VkBuffer        counterBuffer        = VK_NULL_HANDLE; // Length of the index list, read back for stats
+            VmaAllocation   counterAllocation    = VK_NULL_HANDLE;
+            void*           counterMapped        = nullptr;
+            uint32_t        lightCapacity        = 0;
+            VkDescriptorSet descriptorSet        = VK_NULL_HANDLE;
+            VkQueryPool     timestampPool        = VK_NULL_HANDLE;
+            uint32_t        lightCount           = 0;     // Lights in the last submission
+            bool            clustered            = false; // Mode of the last submission
+            bool            submitted            = false;
+        };
+
+        void WriteDescriptorSet(Frame& frame);
+        bool ReserveLights(Frame& frame, uint32_t lightCount);
+        void ReadResults(Frame& frame);
+
+        VkDevice      m_Device = VK_NULL_HANDLE;
+        VulkanMemory* m_Memory = nullptr;
+
+        VkDescriptorSetLayout m_SetLayout          = VK_NULL_HANDLE; // Set 1 of the graphics pipeline
+        VkDescriptorPool      m_DescriptorPool     = VK_NULL_HANDLE;
+        VkPipelineLayout      m_CullPipelineLayout = VK_NULL_HANDLE;
+        VkPipeline            m_CullPipeline       = VK_NULL_HANDLE;
+        std::vector<Frame>    m_Frames;
+        float                 m_TimestampPeriod    = 0.0f;
+
+        glm::vec3     m_Ambient   = glm::vec3(0.08f);
+        bool          m_Clustered = true;
+        LightingStats m_Stats;
+    };
+}
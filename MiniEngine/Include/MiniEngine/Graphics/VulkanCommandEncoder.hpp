@@ -0,0 +1,130 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <bitset>
+#include <cstdint>
+
+namespace MiniEngine::Graphics
+{
+    enum class EncodedCommand : uint8_t
+    {
+        BindPipeline,
+        BindDescriptorSets,
+        BindVertexBuffers,
+        BindIndexBuffer,
+        PushConstants,
+        SetViewport,
+        SetScissor,
+        Draw,
+        Dispatch,
+        Count
+    };
+
+    const char* ToString(EncodedCommand command);
+
+    struct CommandEncoderStats
+    {
+        std::array<uint32_t, static_cast<size_t>(EncodedCommand::Count)> issued{};
+        std::array<uint32_t, static_cast<size_t>(EncodedCommand::Count)> elided{};
+
+        uint32_t GetIssued() const;
+        uint32_t GetElided() const;
+    };
+
+    // Records into a command buffer through a shadow copy of the bound state, dropping binds and
+    // state changes that would not change anything. Draws and dispatches always go through.
+    // Commands recorded on the command buffer directly are not seen; call Invalidate after any that
+    // disturb bound state, such as executing secondary command buffers.
+    class VulkanCommandEncoder
+    {
+    public:
+        static constexpr uint32_t MaxDescriptorSets   = 8;
+        static constexpr uint32_t MaxVertexBindings   = 16;
+        static constexpr uint32_t MaxViewports        = 16;
+        static constexpr uint32_t MaxPushConstantSize = 256;
+
+        VulkanCommandEncoder() = default;
+
+        VulkanCommandEncoder(const VulkanCommandEncoder&) = delete;
+        VulkanCommandEncoder& operator=(const VulkanCommandEncoder&) = delete;
+        VulkanCommandEncoder(VulkanCommandEncoder&&) = delete;
+        VulkanCommandEncoder& operator=(VulkanCommandEncoder&&) = delete;
+
+        // Starts tracking a command buffer in the recording state. Nothing is known to be bound yet.
+        void Begin(VkCommandBuffer commandBuffer);
+
+        // Forgets all shadowed state, so the next call of every kind is issued
+        void Invalidate();
+
+        VkCommandBuffer GetCommandBuffer() const
+        {
+            return m_CommandBuffer;
+        }
+
+        void BindPipeline(VkPipelineBindPoint bindPoint, VkPipeline pipeline);
+
+        // Calls with dynamic offsets are always issued
+        void BindDescriptorSets(VkPipelineBindPoint bindPoint, VkPipelineLayout layout, uint32_t firstSet, uint32_t setCount,
+                                const VkDescriptorSet* sets, uint32_t dynamicOffsetCount = 0, const uint32_t* dynamicOffsets = nullptr);
+
+        void BindVertexBuffers(uint32_t firstBinding, uint32_t bindingCount, const VkBuffer* buffers, const VkDeviceSize* offsets);
+        void BindIndexBuffer(VkBuffer buffer, VkDeviceSize offset, VkIndexType indexType);
+
+        void PushConstants(VkPipelineLayout layout, VkShaderStageFlags stages, uint32_t offset, uint32_t size, const void* data);
+
+        void SetViewport(uint32_t firstViewport, uint32_t viewportCount, const VkViewport* viewports);
+        void SetScissor(uint32_t firstScissor, uint32_t scissorCount, const VkRect2D* scissors);
+
+        void Draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance);
+        void DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance);
+        void DrawIndirect(VkBuffer buffer, VkDeviceSize offset, uint32_t drawCount, uint32_t stride);
+        void DrawIndexedIndirect(VkBuffer buffer, VkDeviceSize offset, uint32_t drawCount, uint32_t stride);
+        void DrawIndexedIndirectCount(VkBuffer buffer, VkDeviceSize offset, VkBuffer countBuffer, VkDeviceSize countOffset, uint32_t maxDrawCount, uint32_t stride);
+        void Dispatch(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ);
+        void DispatchIndirect(VkBuffer buffer, VkDeviceSize offset);
+
+        // Counts since the last Begin
+        const CommandEncoderStats& GetStats() const
+        {
+            return m_Stats;
+        }
+
+    private:
+        // Graphics and compute each have their own pipeline and descriptor set bindings
+        struct BindPointState
+        {
+            VkPipeline pipeline = VK_NULL_HANDLE;
+            std::array<VkDescriptorSet, MaxDescriptorSets> sets{};
+            std::array<VkPipelineLayout, MaxDescriptorSets> setLayouts{};
+        };
+
+        static uint32_t GetBindPointIndex(VkPipelineBindPoint bindPoint);
+
+        void Count(EncodedCommand command, bool issued);
+
+        VkCommandBuffer m_CommandBuffer = VK_NULL_HANDLE;
+
+        std::array<BindPointState, 2> m_BindPoints{};
+
+        std::array<VkBuffer, MaxVertexBindings> m_VertexBuffers{};
+        std::array<VkDeviceSize, MaxVertexBindings> m_VertexOffsets{};
+        std::bitset<MaxVertexBindings> m_VertexBound;
+
+        VkBuffer m_IndexBuffer = VK_NULL_HANDLE;
+        VkDeviceSize m_IndexOffset = 0;
+        VkIndexType m_IndexType = VK_INDEX_TYPE_UINT16;
+
+        VkPipelineLayout m_PushConstantLayout = VK_NULL_HANDLE;
+        std::array<uint8_t, MaxPushConstantSize> m_PushConstantData{};
+        std::array<VkShaderStageFlags, MaxPushConstantSize> m_PushConstantStages{};
+
+        std::array<VkViewport, MaxViewports> m_Viewports{};
+        std::bitset<MaxViewports> m_ViewportSet;
+        std::array<VkRect2D, MaxViewports> m_Scissors{};
+        std::bitset<MaxViewports> m_ScissorSet;
+
+        CommandEncoderStats m_Stats;
+    };
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "MiniEngine/Graphics/VulkanMemory.hpp"
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace MiniEngine::Graphics
+{
+    class VulkanDebugUtils;
+    class VulkanQueues;
+
+    // SPIR-V by path; empty when it cannot be read
+    using ShaderLoader = std::function<std::vector<char>(const std::string& path)>;
+
+    // What the rendering modules create their resources with. The application owns everything it
+    // points to, which must outlive the modules created from it.
+    struct VulkanContext
+    {
+        VkPhysicalDevice          physicalDevice = VK_NULL_HANDLE;
+        VkDevice                  device         = VK_NULL_HANDLE;
+        VkPipelineCache           pipelineCache  = VK_NULL_HANDLE;
+        uint32_t                  framesInFlight = 0;
+        VulkanMemory*             memory         = nullptr;
+        VulkanQueues*             queues         = nullptr;
+        const VulkanDebugUtils*   debugUtils     = nullptr;
+        ShaderLoader              loadShader;
+        ImmediateCommandsFunction executeImmediate; // On the graphics queue
+    };
+
+    // Logs and returns VK_NULL_HANDLE on failure; the caller destroys the module once its pipelines exist
+    VkShaderModule CreateShaderModule(const VulkanContext& context, const std::string& shaderPath);
+
+    // Named after the shader in capture tools. Logs and returns false on failure.
+    bool CreateComputePipeline(const VulkanContext& context, VkPipelineLayout layout, const std::string& shaderPath, VkPipeline& pipeline);
+
+    // Nanoseconds per timestamp tick on the queue family, 0 when it cannot write timestamps
+    float GetTimestampPeriod(VkPhysicalDevice physicalDevice, uint32_t queueFamily);
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+// Instrumentation levels, each including the ones before it
+#define MINIENGINE_INSTRUMENTATION_OFF             0 // No layers, no debug utils
+#define MINIENGINE_INSTRUMENTATION_LABELS          1 // Object names and command buffer regions for capture tools
+#define MINIENGINE_INSTRUMENTATION_VALIDATION      2 // The Khronos validation layer and its messenger
+#define MINIENGINE_INSTRUMENTATION_FULL_VALIDATION 3 // Plus synchronization validation and GPU-assisted validation
+
+// The level used unless the application picks another at runtime. Release builds pay for no
+// instrumentation unless the build sets the level explicitly.
+#ifndef MINIENGINE_INSTRUMENTATION_LEVEL
+#ifdef NDEBUG
+#define MINIENGINE_INSTRUMENTATION_LEVEL MINIENGINE_INSTRUMENTATION_OFF
+#else
+#define MINIENGINE_INSTRUMENTATION_LEVEL MINIENGINE_INSTRUMENTATION_VALIDATION
+#endif
+#endif
+
+namespace MiniEngine::Graphics
+{
+    enum class InstrumentationLevel : uint8_t
+    {
+        Off            = MINIENGINE_INSTRUMENTATION_OFF,
+        Labels         = MINIENGINE_INSTRUMENTATION_LABELS,
+        Validation     = MINIENGINE_INSTRUMENTATION_VALIDATION,
+        FullValidation = MINIENGINE_INSTRUMENTATION_FULL_VALIDATION
+    };
+
+    constexpr InstrumentationLevel DefaultInstrumentationLevel = static_cast<InstrumentationLevel>(MINIENGINE_INSTRUMENTATION_LEVEL);
+
+    const char* ToString(InstrumentationLevel level);
+
+    // Accepts the names ToString returns; leaves level untouched and returns false on anything else
+    bool ParseInstrumentationLevel(std::string_view text, InstrumentationLevel& level);
+
+    // VK_EXT_debug_utils entry points for naming objects and labelling command buffer regions. Until
+    // Load finds them every call is a no-op costing one branch, so call sites need no checks of their own.
+    class VulkanDebugUtils
+    {
+    public:
+        // Loads nothing below InstrumentationLevel::Labels. The instance must have been created with
+        // VK_EXT_debug_utils enabled for the entry points to be found.
+        void Load(VkInstance instance, VkDevice device, InstrumentationLevel level);
+
+        bool IsEnabled() const
+        {
+            return m_BeginLabel != nullptr;
+        }
+
+        // Handle is any Vulkan handle, dispatchable or not
+        template <typename Handle>
+        void SetObjectName(VkObjectType type, Handle handle, const char* name) const
+        {
+            if (m_SetObjectName != nullptr)
+            {
+                SetHandleName(type, (uint64_t)handle, name);
+            }
+        }
+
+        void BeginLabel(VkCommandBuffer commandBuffer, const char* name, const std::array<float, 4>& color = {}) const;
+        void EndLabel(VkCommandBuffer commandBuffer) const;
+
+    private:
+        void SetHandleName(VkObjectType type, uint64_t handle, const char* name) const;
+
+        VkDevice m_Device = VK_NULL_HANDLE;
+        PFN_vkSetDebugUtilsObjectNameEXT m_SetObjectName = nullptr;
+        PFN_vkCmdBeginDebugUtilsLabelEXT m_BeginLabel = nullptr;
+        PFN_vkCmdEndDebugUtilsLabelEXT m_EndLabel = nullptr;
+    };
+}
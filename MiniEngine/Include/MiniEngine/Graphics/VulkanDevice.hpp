@@ -1,7 +1,6 @@
 #pragma once
 
 #include <vulkan/vulkan.h>
-#define VMA_IMPLEMENTATION
 #include <vk_mem_alloc.h>
 
 namespace MiniEngine::Graphics
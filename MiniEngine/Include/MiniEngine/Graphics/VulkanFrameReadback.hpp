@@ -0,0 +1,121 @@
+#pragma once
+
+#include "MiniEngine/Graphics/ImageSequenceWriter.hpp"
+#include "MiniEngine/Graphics/VulkanContext.hpp"
+
+#include <vulkan/vulkan.h>
+#include <vk_mem_alloc.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <vector>
+
+namespace MiniEngine::Graphics
+{
+    struct FrameReadbackStats
+    {
+        uint64_t copied  = 0; // Images copied on the GPU and handed to the writer
+        uint64_t skipped = 0; // Frames presented while every slot was still with the writer
+    };
+
+    struct FrameReadbackInfo
+    {
+        std::filesystem::path directory;                             // Where the writer puts the images
+        ImageFileFormat       fileFormat  = ImageFileFormat::Png;
+        VkFormat              imageFormat = VK_FORMAT_UNDEFINED;     // Of the images copied out; 8-bit RGBA or BGRA
+        VkExtent2D            extent      = {};                      // Initial slot size; slots follow the images they are given
+        uint32_t              slotCount   = 4;                       // Raised to one more than the frames in flight
+    };
+
+    // Asynchronous capture of presented frames. A captured frame submits a second, small command buffer
+    // after its own, copying the presented image into a free slot of a ring of readback buffers. When
+    // that frame in flight next comes round and its fence has signaled, the slot goes to the image
+    // writer's thread, which hands it back once the file is written. Nothing waits: with no free slot
+    // the frame is not captured. The frame's own command buffer is left alone, so it is still reused.
+    class VulkanFrameReadback
+    {
+    public:
+        VulkanFrameReadback() = default;
+        ~VulkanFrameReadback();
+
+        VulkanFrameReadback(const VulkanFrameReadback&) = delete;
+        VulkanFrameReadback& operator=(const VulkanFrameReadback&) = delete;
+        VulkanFrameReadback(VulkanFrameReadback&&) = delete;
+        VulkanFrameReadback& operator=(VulkanFrameReadback&&) = delete;
+
+        // Creates the slots and starts the writer; capture starts disabled. Logs why and returns false on failure.
+        bool Initialize(const VulkanContext& context, const FrameReadbackInfo& info);
+
+        // Writes what is queued first; call once the device is idle
+        void Destroy();
+
+        // Whether the writer is up, i.e. Initialize succeeded
+        bool IsRunning() const
+        {
+            return m_Writer.IsRunning();
+        }
+
+        // Disabled, frames are not captured and Record returns VK_NULL_HANDLE
+        void SetEnabled(bool enabled)
+        {
+            m_Enabled = enabled && IsRunning();
+        }
+
+        bool IsEnabled() const
+        {
+            return m_Enabled;
+        }
+
+        uint32_t GetSlotCount() const
+        {
+            return static_cast<uint32_t>(m_Slots.size());
+        }
+
+        const FrameReadbackStats& GetStats() const
+        {
+            return m_Stats;
+        }
+
+        ImageSequenceStats GetWriterStats() const
+        {
+            return m_Writer.GetStats();
+        }
+
+        // Once the frame's fence has signaled: hands the image its last submission copied to the writer
+        void ReadResults(uint32_t frame);
+
+        // Records the copy of a presented image for the frame, to be submitted right after the frame's
+        // own commands, which leave the image in layout, as the copy does. VK_NULL_HANDLE when the frame
+        // is not captured.
+        VkCommandBuffer Record(uint32_t frame, VkImage image, VkExtent2D extent, VkImageLayout layout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+
+    private:
+        // A host-visible buffer one presented image is copied into, then read on the writer's thread
+        struct Slot
+        {
+            VkBuffer      buffer     = VK_NULL_HANDLE;
+            VmaAllocation allocation = VK_NULL_HANDLE;
+            void*         mapped     = nullptr;
+            VkExtent2D    extent     = {};
+        };
+
+        bool ReserveSlot(Slot& slot, VkExtent2D extent);
+        void ReturnSlot(uint32_t slotIndex);
+
+        VkDevice                m_Device     = VK_NULL_HANDLE;
+        VulkanMemory*           m_Memory     = nullptr;
+        const VulkanDebugUtils* m_DebugUtils = nullptr;
+
+        VkCommandPool                m_CommandPool = VK_NULL_HANDLE;
+        std::vector<VkCommandBuffer> m_CommandBuffers; // One per frame in flight, recorded again for every capture
+        std::vector<Slot>            m_Slots;
+        std::vector<int32_t>         m_FrameSlots;     // Slot each frame in flight last copied into, -1 for none
+        std::mutex                   m_Mutex;          // Guards m_FreeSlots, which the writer's thread returns slots to
+        std::vector<uint32_t>        m_FreeSlots;
+        PixelLayout                  m_Layout      = PixelLayout::Bgra8;
+        ImageSequenceWriter          m_Writer;
+        bool                         m_Enabled     = false;
+        FrameReadbackStats           m_Stats;
+    };
+}
@@ -0,0 +1,207 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vk_mem_alloc.h>
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace MiniEngine::Graphics
+{
+    // What an allocation is for, so memory use can be broken down by purpose
+    enum class MemoryCategory : uint8_t
+    {
+        Geometry,      // Vertex data and particle state
+        Textures,
+        RenderTargets, // Depth, scene color and the Hi-Z pyramid
+        Staging,       // Upload sources, released once their copy completes
+        FrameData,     // Per-frame uniforms, object and light lists, indirect draws and counters
+        Count
+    };
+
+    constexpr size_t MemoryCategoryCount = static_cast<size_t>(MemoryCategory::Count);
+
+    const char* ToString(MemoryCategory category);
+
+    struct MemoryCategoryUsage
+    {
+        VkDeviceSize bytes       = 0;
+        VkDeviceSize peakBytes   = 0;
+        uint32_t     allocations = 0;
+    };
+
+    struct MemoryHeapUsage
+    {
+        uint32_t     heapIndex       = 0;
+        bool         deviceLocal     = false;
+        VkDeviceSize usage           = 0; // By this process, from the driver when the budget extension is present
+        VkDeviceSize budget          = 0;
+        VkDeviceSize blockBytes      = 0; // Device memory VMA allocated
+        VkDeviceSize allocationBytes = 0; // The part of it handed out
+    };
+
+    struct MemoryDefragmentationStats
+    {
+        uint32_t     passes           = 0;
+        uint32_t     movesIgnored     = 0; // Proposed by the allocator for buffers nobody registered as movable
+        uint32_t     allocationsMoved = 0;
+        VkDeviceSize bytesMoved       = 0;
+        VkDeviceSize bytesFreed       = 0; // Released to the driver by finished defragmentations
+        uint32_t     blocksFreed      = 0;
+    };
+
+    // Releases memory while a device-local heap is over its eviction threshold. Called for a frame whose
+    // fence has signaled, so a hook may free that frame's resources; returns how many bytes it released.
+    using MemoryEvictionHook = std::function<VkDeviceSize(uint32_t frameIndex, VkDeviceSize bytesOverThreshold)>;
+
+    // A buffer the defragmenter may move. The owner's handle and mapping are rewritten in place, then
+    // relocated re-points whatever else refers to the buffer. It needs transfer source and destination
+    // usage for the copy.
+    struct MovableBuffer
+    {
+        VkBuffer*             buffer = nullptr;
+        void**                mapped = nullptr;
+        VkDeviceSize          size   = 0;
+        VkBufferUsageFlags    usage  = 0;
+        std::function<void()> relocated;
+    };
+
+    // Records commands into a one-off command buffer, submits it and waits for it; false when that fails
+    using ImmediateCommandsFunction = std::function<bool(const std::function<void(VkCommandBuffer)>& record)>;
+
+    // The VMA allocator with allocation tagging, budget tracking and eviction, and incremental
+    // defragmentation on top. Every allocation is counted under a category from creation until it is
+    // destroyed through this class. Creation and destruction may happen on any thread; budgets,
+    // eviction and defragmentation belong to the render thread.
+    class VulkanMemory
+    {
+    public:
+        static constexpr float        EvictionThreshold      = 0.9f;      // Fraction of a device-local heap's budget
+        static constexpr VkDeviceSize DefragmentBytesPerPass = 16u << 20; // Bounds the stall of each pass
+        static constexpr uint32_t     DefragmentMovesPerPass = 64;
+        static constexpr float        DefragmentWaste        = 0.25f;     // Unused fraction of the allocated blocks that starts it
+        static constexpr VkDeviceSize DefragmentMinWaste     = 32u << 20;
+
+        VulkanMemory() = default;
+        ~VulkanMemory();
+
+        VulkanMemory(const VulkanMemory&) = delete;
+        VulkanMemory& operator=(const VulkanMemory&) = delete;
+        VulkanMemory(VulkanMemory&&) = delete;
+        VulkanMemory& operator=(VulkanMemory&&) = delete;
+
+        // Creates the allocator. budgetExtension says the device was created with VK_EXT_memory_budget,
+        // whose heap budgets then replace VMA's estimates.
+        bool Initialize(const VmaAllocatorCreateInfo& info, bool budgetExtension);
+
+        // Ends any defragmentation and destroys the allocator; call once every allocation is gone and
+        // before the device is destroyed
+        void Destroy();
+
+        VmaAllocator GetAllocator() const
+        {
+            return m_Allocator;
+        }
+
+        bool HasBudgetExtension() const
+        {
+            return m_BudgetExtension;
+        }
+
+        // When mapped is given the memory stays persistently mapped there
+        bool CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VmaMemoryUsage memoryUsage, MemoryCategory category,
+                          VkBuffer& buffer, VmaAllocation& allocation, void** mapped = nullptr);
+
+        // In device-local memory. Logs nothing on failure, callers know what the image was for.
+        bool CreateImage(const VkImageCreateInfo& info, MemoryCategory category, VkImage& image, VmaAllocation& allocation);
+
+        // Both accept null handles and reset the ones they destroy. A destroyed buffer is no longer movable.
+        void DestroyBuffer(VkBuffer& buffer, VmaAllocation& allocation);
+        void DestroyImage(VkImage& image, VmaAllocation& allocation);
+
+        // Counts an allocation made through GetAllocator directly, until DestroyBuffer or DestroyImage
+        void Track(VmaAllocation allocation, MemoryCategory category);
+
+        // Lets defragmentation move the buffer
+        void RegisterMovableBuffer(VmaAllocation allocation, const MovableBuffer& movable);
+
+        // Consistent while other threads allocate
+        std::array<MemoryCategoryUsage, MemoryCategoryCount> GetCategoryUsage() const;
+        std::vector<MemoryHeapUsage> GetHeapUsage() const;
+
+        // Hooks are called in the order they were added until enough is released
+        void AddEvictionHook(std::string name, MemoryEvictionHook hook);
+
+        // Once per frame, after the frame's fence: advances VMA's frame index and asks the eviction
+        // hooks to release whatever the device-local heaps use beyond EvictionThreshold of their budget
+        void UpdateBudget(uint32_t frameIndex);
+
+        uint32_t GetEvictionCount() const
+        {
+            return m_Evictions;
+        }
+
+        VkDeviceSize GetEvictedBytes() const
+        {
+            return m_EvictedBytes;
+        }
+
+        // Memory VMA holds in its blocks without handing it out
+        VkDeviceSize GetUnusedBlockBytes() const;
+
+        // Heaps, categories, eviction, defragmentation and VMA's own report as JSON, replaced atomically
+        bool WriteStats(const std::string& path) const;
+
+        // One line short enough for a window title
+        std::string FormatOverlay() const;
+
+        bool BeginDefragmentation();
+
+        // Starts a defragmentation once the unused block memory is over DefragmentWaste of the blocks
+        // and has grown DefragmentMinWaste past what the last run left
+        void DefragmentIfWasteful();
+
+        // Moves at most a pass's worth of allocations and returns false once defragmentation is over.
+        // Only registered buffers move: they are recreated over the new memory, their contents copied
+        // through execute, and their owners told to repoint descriptors. Everything else, images
+        // included, stays where it is. The device is idle for the pass, which the per-pass limits keep
+        // short. buffersMoved tells the caller whether command buffers recorded earlier are stale.
+        bool Defragment(const ImmediateCommandsFunction& execute, uint32_t& buffersMoved);
+
+        void EndDefragmentation();
+
+        bool IsDefragmenting() const
+        {
+            return m_Defragmentation != VK_NULL_HANDLE;
+        }
+
+        const MemoryDefragmentationStats& GetDefragmentationStats() const
+        {
+            return m_DefragmentationStats;
+        }
+
+    private:
+        VkDevice     m_Device          = VK_NULL_HANDLE;
+        VmaAllocator m_Allocator       = VK_NULL_HANDLE;
+        bool         m_BudgetExtension = false;
+        uint32_t     m_FrameIndex      = 0;
+
+        mutable std::mutex                                   m_Mutex; // Guards m_Categories and m_MovableBuffers
+        std::array<MemoryCategoryUsage, MemoryCategoryCount> m_Categories{};
+        std::unordered_map<VmaAllocation, MovableBuffer>     m_MovableBuffers;
+
+        std::vector<std::pair<std::string, MemoryEvictionHook>> m_EvictionHooks;
+        uint32_t                                                m_Evictions    = 0;
+        VkDeviceSize                                            m_EvictedBytes = 0;
+
+        VmaDefragmentationContext  m_Defragmentation   = VK_NULL_HANDLE; // Set while a defragmentation runs
+        MemoryDefragmentationStats m_DefragmentationStats;
+        VkDeviceSize               m_WasteAtDefragmentation = 0;
+    };
+}
@@ -0,0 +1,258 @@
+#pragma once
+
+#include "MiniEngine/Graphics/VulkanContext.hpp"
+#include "MiniEngine/Scene/Frustum.hpp"
+
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.h>
+#include <vk_mem_alloc.h>
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace MiniEngine::Graphics
+{
+    class VulkanCommandEncoder;
+
+    constexpr uint32_t MaxOcclusionLods = 8;
+
+    // Per-object data read by the culling and vertex shaders (std430 layout)
+    struct OcclusionObject
+    {
+        glm::mat4 model;
+        glm::vec4 boundsCenterRadius; // World-space box center and sphere radius
+        glm::vec4 boundsExtents;      // World-space box half extents, level of detail in w
+    };
+
+    // Per-frame constants shared by the culling, Hi-Z and vertex shaders (std140 layout). The caller
+    // fills in the camera, the mesh's levels and the render scale; PrepareFrame the rest.
+    struct OcclusionUniforms
+    {
+        glm::mat4  viewProjection;
+        glm::mat4  previousViewProjection; // The camera the Hi-Z pyramid was rendered with
+        glm::vec2  pyramidSize;
+        uint32_t   pyramidMipCount;
+        uint32_t   objectCount;
+        uint32_t   lodCount;
+        uint32_t   occlusionEnabled;
+        uint32_t   pyramidValid;
+        uint32_t   meshletCulling;
+        glm::vec2  previousRenderScale; // Part of the pyramid the previous frame rendered into
+        glm::vec2  renderScale;
+        glm::uvec4 lods[MaxOcclusionLods]; // Index count, first index, first meshlet and meshlet count of each level
+        glm::vec4  frustumPlanes[Scene::Frustum::PlaneCount];
+        glm::vec4  cameraPosition;
+    };
+
+    // Results gathered from finished frames
+    struct OcclusionStats
+    {
+        uint32_t frustumVisible     = 0;
+        uint32_t phase1Visible      = 0;
+        uint32_t phase2Visible      = 0;
+        uint32_t occluded           = 0;
+        uint32_t meshletsTested     = 0;
+        uint32_t meshletsBackfacing = 0;
+        uint32_t meshletsOutside    = 0;
+        uint32_t draws              = 0;
+        uint32_t triangles          = 0;
+        double   gpuFrameMs[2]      = { 0.0, 0.0 }; // Smoothed GPU time of the whole frame, with occlusion off / on
+        double   gpuCullMs[2]       = { 0.0, 0.0 }; // Smoothed time spent in culling dispatches and the Hi-Z build
+        uint32_t samples[2]         = { 0, 0 };
+    };
+
+    struct OcclusionCullingInfo
+    {
+        std::string cullShader;     // Counts and writes each object's draws
+        std::string scanShader;     // Turns the counts into offsets, sharing the culling layout
+        std::string reduceShader;   // Builds one pyramid level from the one below
+        VkBuffer    meshletBuffer  = VK_NULL_HANDLE; // The drawn mesh's, bound to every frame's scene set
+        uint32_t    drawsPerObject = 1;              // Most meshlets a level of the mesh has
+        VkImage     depthImage     = VK_NULL_HANDLE; // Sampled to build the pyramid, so it needs sampled usage
+        VkImageView depthView      = VK_NULL_HANDLE;
+        VkExtent2D  depthExtent    = {};
+    };
+
+    // Two-phase occlusion culling against a hierarchical depth (Hi-Z) pyramid. Phase 1 tests the
+    // frustum-visible objects against the pyramid built from the previous frame's depth and draws the
+    // survivors. The pyramid is then rebuilt from that depth, and phase 2 retests what phase 1 rejected,
+    // drawing anything that turned out visible so nothing pops in when the camera moves. The graphics
+    // pipeline drawing the objects reads them through the scene set, whose layout this class owns.
+    class VulkanOcclusionCulling
+    {
+    public:
+        VulkanOcclusionCulling() = default;
+        ~VulkanOcclusionCulling();
+
+        VulkanOcclusionCulling(const VulkanOcclusionCulling&) = delete;
+        VulkanOcclusionCulling& operator=(const VulkanOcclusionCulling&) = delete;
+        VulkanOcclusionCulling(VulkanOcclusionCulling&&) = delete;
+        VulkanOcclusionCulling& operator=(VulkanOcclusionCulling&&) = delete;
+
+        bool Initialize(const VulkanContext& context, const OcclusionCullingInfo& info);
+
+        // Call once the device is idle
+        void Destroy();
+
+        // Off, phase 1 draws every frustum-visible object and phase 2 records nothing
+        void SetEnabled(bool enabled)
+        {
+            m_Enabled = enabled;
+        }
+
+        bool IsEnabled() const
+        {
+            return m_Enabled;
+        }
+
+        // Off, every visible object is one draw of its whole level
+        void SetMeshletCulling(bool meshletCulling)
+        {
+            m_MeshletCulling = meshletCulling;
+        }
+
+        bool IsMeshletCulling() const
+        {
+            return m_MeshletCulling;
+        }
+
+        VkDescriptorSetLayout GetSceneSetLayout() const
+        {
+            return m_SceneSetLayout;
+        }
+
+        VkExtent2D GetPyramidExtent() const
+        {
+            return m_PyramidExtent;
+        }
+
+        uint32_t GetPyramidMipCount() const
+        {
+            return m_PyramidMipCount;
+        }
+
+        // Nanoseconds per tick, 0 when the graphics queue has no timestamps
+        float GetTimestampPeriod() const
+        {
+            return m_TimestampPeriod;
+        }
+
+        const OcclusionStats& GetStats() const
+        {
+            return m_Stats;
+        }
+
+        // Once the frame's fence has signaled: collects what its last submission measured, grows its
+        // buffers to fit the objects, and uploads them with the uniforms after filling in the
+        // pyramid's and this class's settings
+        bool PrepareFrame(uint32_t frame, std::span<const OcclusionObject> objects, OcclusionUniforms& uniforms);
+
+        // Once the frame's commands are submitted; the pyramid they build is what the next frame tests against
+        void MarkSubmitted(uint32_t frame);
+
+        // What recorded commands depend on: they stay valid while both are unchanged
+        uint32_t GetObjectCapacity(uint32_t frame) const
+        {
+            return m_Frames[frame].objectCapacity;
+        }
+
+        bool IsEnabledFor(uint32_t frame) const
+        {
+            return m_Frames[frame].occlusionEnabled;
+        }
+
+        VkDescriptorSet GetSceneSet(uint32_t frame) const
+        {
+            return m_Frames[frame].descriptorSet;
+        }
+
+        // Before the first render pass: resets the counters and culls against the previous frame's pyramid
+        void RecordPhase1(VulkanCommandEncoder& encoder, uint32_t frame);
+
+        // Between the render passes, with depth in the attachment layout: rebuilds the pyramid from
+        // it and retests what phase 1 rejected. Leaves depth an attachment again.
+        void RecordPhase2(VulkanCommandEncoder& encoder, uint32_t frame);
+
+        // Inside a render pass, with the graphics pipeline, the scene set, and the mesh bound. Sized
+        // by capacity rather than the frame's count, so the recording stays valid while the count changes.
+        void RecordDraws(VulkanCommandEncoder& encoder, uint32_t frame, uint32_t phase);
+
+        // After the frame's last draw, for the GPU frame time
+        void RecordFrameEnd(VkCommandBuffer commandBuffer, uint32_t frame);
+
+        // Shrinks the buffers of a frame that is not in flight to what its last submission needed,
+        // if they are more than twice that. Returns the bytes released; recorded commands using the
+        // frame are stale when it is not 0.
+        VkDeviceSize Trim(uint32_t frame);
+
+    private:
+        // Resources owned by one frame in flight
+        struct Frame
+        {
+            VkBuffer        uniformBuffer             = VK_NULL_HANDLE;
+            VmaAllocation   uniformAllocation         = VK_NULL_HANDLE;
+            void*           uniformMapped             = nullptr;
+            VkBuffer        objectBuffer              = VK_NULL_HANDLE;
+            VmaAllocation   objectAllocation          = VK_NULL_HANDLE;
+            void*           objectMapped              = nullptr;
+            VkBuffer        drawCommandBuffers[2]     = { VK_NULL_HANDLE, VK_NULL_HANDLE }; // One per phase
+            VmaAllocation   drawCommandAllocations[2] = { VK_NULL_HANDLE, VK_NULL_HANDLE };
+            VkBuffer        visibilityBuffer          = VK_NULL_HANDLE;
+            VmaAllocation   visibilityAllocation      = VK_NULL_HANDLE;
+            VkBuffer        drawOffsetBuffer          = VK_NULL_HANDLE; // Each object's draw count, then its first draw
+            VmaAllocation   drawOffsetAllocation      = VK_NULL_HANDLE;
+            VkBuffer        counterBuffer             = VK_NULL_HANDLE;
+            VmaAllocation   counterAllocation         = VK_NULL_HANDLE;
+            void*           counterMapped             = nullptr;
+            uint32_t        objectCapacity            = 0;
+            VkDescriptorSet descriptorSet             = VK_NULL_HANDLE;
+            VkQueryPool     timestampPool             = VK_NULL_HANDLE;
+            uint32_t        objectCount               = 0;     // Objects recorded in the last submission
+            bool            occlusionEnabled          = false; // Mode of the last submission
+            bool            submitted                 = false;
+            glm::mat4       viewProjection            = glm::mat4(1.0f); // Camera and scale of the last upload
+            glm::vec2       renderScale               = glm::vec2(1.0f);
+        };
+
+        void WriteDescriptorSet(Frame& frame);
+        bool ReserveObjects(Frame& frame, uint32_t objectCount);
+        void ReadResults(Frame& frame);
+        void RecordCulling(VulkanCommandEncoder& encoder, Frame& frame, uint32_t phase);
+        void RecordDepthPyramid(VulkanCommandEncoder& encoder);
+
+        VkDevice                m_Device     = VK_NULL_HANDLE;
+        VulkanMemory*           m_Memory     = nullptr;
+        const VulkanDebugUtils* m_DebugUtils = nullptr;
+
+        VkDescriptorSetLayout        m_SceneSetLayout       = VK_NULL_HANDLE;
+        VkDescriptorSetLayout        m_ReduceSetLayout      = VK_NULL_HANDLE;
+        VkDescriptorPool             m_DescriptorPool       = VK_NULL_HANDLE;
+        VkPipelineLayout             m_CullPipelineLayout   = VK_NULL_HANDLE;
+        VkPipelineLayout             m_ReducePipelineLayout = VK_NULL_HANDLE;
+        VkPipeline                   m_CullPipeline         = VK_NULL_HANDLE;
+        VkPipeline                   m_ScanPipeline         = VK_NULL_HANDLE;
+        VkPipeline                   m_ReducePipeline       = VK_NULL_HANDLE;
+        VkBuffer                     m_MeshletBuffer        = VK_NULL_HANDLE;
+        uint32_t                     m_DrawsPerObject       = 1;
+        VkImage                      m_DepthImage           = VK_NULL_HANDLE;
+        VkSampler                    m_PyramidSampler       = VK_NULL_HANDLE;
+        VkImage                      m_PyramidImage         = VK_NULL_HANDLE;
+        VmaAllocation                m_PyramidAllocation    = VK_NULL_HANDLE;
+        VkImageView                  m_PyramidView          = VK_NULL_HANDLE; // All mips, for the culling shader
+        std::vector<VkImageView>     m_PyramidMipViews;                        // One per mip, for the reduction
+        std::vector<VkDescriptorSet> m_ReduceSets;                             // One per mip
+        VkExtent2D                   m_PyramidExtent        = {};
+        uint32_t                     m_PyramidMipCount      = 0;
+        std::vector<Frame>           m_Frames;
+        float                        m_TimestampPeriod      = 0.0f;
+
+        glm::mat4      m_PreviousViewProjection = glm::mat4(1.0f);
+        glm::vec2      m_PreviousRenderScale    = glm::vec2(1.0f);
+        bool           m_PyramidValid           = false;
+        bool           m_Enabled                = true;
+        bool           m_MeshletCulling         = true;
+        OcclusionStats m_Stats;
+    };
+}
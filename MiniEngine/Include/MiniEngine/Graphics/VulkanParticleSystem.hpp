@@ -0,0 +1,171 @@
+#pragma once
+
+#include "MiniEngine/Graphics/VulkanCommandEncoder.hpp"
+#include "MiniEngine/Graphics/VulkanContext.hpp"
+
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.h>
+#include <vk_mem_alloc.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace MiniEngine::Graphics
+{
+    // Results gathered from finished frames
+    struct ParticleStats
+    {
+        uint32_t alive         = 0;
+        double   gpuSimulateMs = 0.0; // Smoothed prepare, emit and simulate passes on the compute queue
+        double   gpuRenderMs   = 0.0; // Smoothed indirect draw on the graphics queue
+        uint32_t samples       = 0;
+    };
+
+    struct ParticleSystemInfo
+    {
+        std::string  prepareShader;                 // Turns the requested emission into indirect dispatch arguments
+        std::string  emitShader;
+        std::string  simulateShader;
+        std::string  vertexShader;                  // Expands the frame's instances into quads
+        std::string  fragmentShader;
+        VkRenderPass renderPass = VK_NULL_HANDLE;   // Any pass compatible with the one the particles are drawn in
+        uint32_t     capacity   = 0;
+    };
+
+    // GPU particles that never touch the CPU. Each frame a prepare pass turns the requested emission
+    // into indirect dispatch arguments, an emit pass takes particles off the dead list, and a simulate
+    // pass integrates the alive list and compacts the survivors into the other list, writing the
+    // frame's instances and indirect draw. The passes run on the async compute queue; the graphics
+    // queue only draws the frame's instances.
+    class VulkanParticleSystem
+    {
+    public:
+        VulkanParticleSystem() = default;
+        ~VulkanParticleSystem();
+
+        VulkanParticleSystem(const VulkanParticleSystem&) = delete;
+        VulkanParticleSystem& operator=(const VulkanParticleSystem&) = delete;
+        VulkanParticleSystem(VulkanParticleSystem&&) = delete;
+        VulkanParticleSystem& operator=(VulkanParticleSystem&&) = delete;
+
+        bool Initialize(const VulkanContext& context, const ParticleSystemInfo& info);
+
+        // Call once the device is idle
+        void Destroy();
+
+        // 0 until initialized
+        uint32_t GetCapacity() const
+        {
+            return m_Capacity;
+        }
+
+        // Population the emission rate aims for
+        void SetTargetCount(uint32_t targetCount)
+        {
+            m_TargetCount = targetCount;
+        }
+
+        uint32_t GetTargetCount() const
+        {
+            return m_TargetCount;
+        }
+
+        // Mean, in seconds
+        float GetLifetime() const
+        {
+            return m_Lifetime;
+        }
+
+        // Nanoseconds per tick, 0 when either queue lacks timestamps
+        float GetTimestampPeriod() const
+        {
+            return m_TimestampPeriod;
+        }
+
+        const ParticleStats& GetStats() const
+        {
+            return m_Stats;
+        }
+
+        // Starts the smoothed times over, e.g. once a new population has settled
+        void ResetStats()
+        {
+            m_Stats = {};
+        }
+
+        // Once per frame: turns the target population into this frame's emission and places the
+        // emitter ahead of the camera
+        void Update(const glm::mat4& view, float deltaTime);
+
+        // Once the frame's fence has signaled: collects the alive count and timestamps of its last submission
+        void ReadResults(uint32_t frame);
+
+        // Records and submits the frame's passes on the compute queue. The frame's graphics
+        // submission waits for them before reading the indirect draw and the instances.
+        bool Simulate(uint32_t frame, const glm::mat4& view, const glm::mat4& viewProjection);
+
+        // Inside a render pass with depth attached. The indirect draw holds the frame's survivor
+        // count, so the recording stays valid as the population changes.
+        void RecordDraw(VulkanCommandEncoder& encoder, uint32_t frame);
+
+    private:
+        // Resources owned by one frame in flight, shared by the compute and graphics queues
+        struct Frame
+        {
+            VkBuffer        uniformBuffer      = VK_NULL_HANDLE;
+            VmaAllocation   uniformAllocation  = VK_NULL_HANDLE;
+            void*           uniformMapped      = nullptr;
+            VkBuffer        instanceBuffer     = VK_NULL_HANDLE;
+            VmaAllocation   instanceAllocation = VK_NULL_HANDLE;
+            VkBuffer        drawBuffer         = VK_NULL_HANDLE; // Indirect draw of the survivors, read back for the alive count
+            VmaAllocation   drawAllocation     = VK_NULL_HANDLE;
+            void*           drawMapped         = nullptr;
+            VkDescriptorSet descriptorSet      = VK_NULL_HANDLE;
+            VkQueryPool     timestampPool      = VK_NULL_HANDLE;
+            bool            submitted          = false;
+        };
+
+        bool CreateRenderPipeline(const VulkanContext& context, const ParticleSystemInfo& info);
+        bool CreateFrameBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VmaMemoryUsage memoryUsage,
+                               VkBuffer& buffer, VmaAllocation& allocation, void** mapped);
+
+        VkDevice      m_Device = VK_NULL_HANDLE;
+        VulkanMemory* m_Memory = nullptr;
+        VulkanQueues* m_Queues = nullptr;
+
+        VkDescriptorSetLayout m_SetLayout           = VK_NULL_HANDLE;
+        VkDescriptorPool      m_DescriptorPool      = VK_NULL_HANDLE;
+        VkPipelineLayout      m_ComputeLayout       = VK_NULL_HANDLE;
+        VkPipelineLayout      m_RenderLayout        = VK_NULL_HANDLE;
+        VkPipeline            m_PreparePipeline     = VK_NULL_HANDLE;
+        VkPipeline            m_EmitPipeline        = VK_NULL_HANDLE;
+        VkPipeline            m_SimulatePipeline    = VK_NULL_HANDLE;
+        VkPipeline            m_RenderPipeline      = VK_NULL_HANDLE;
+        VkBuffer              m_ParticleBuffer      = VK_NULL_HANDLE;
+        VmaAllocation         m_ParticleAllocation  = VK_NULL_HANDLE;
+        VkBuffer              m_AliveListBuffer     = VK_NULL_HANDLE; // Two lists of capacity entries, swapped every frame
+        VmaAllocation         m_AliveListAllocation = VK_NULL_HANDLE;
+        VkBuffer              m_DeadListBuffer      = VK_NULL_HANDLE;
+        VmaAllocation         m_DeadListAllocation  = VK_NULL_HANDLE;
+        VkBuffer              m_CounterBuffer       = VK_NULL_HANDLE;
+        VmaAllocation         m_CounterAllocation   = VK_NULL_HANDLE;
+        uint32_t              m_SharingFamilies[2]  = { 0, 0 };       // Compute and graphics
+        std::vector<Frame>    m_Frames;
+        VulkanCommandEncoder  m_Encoder;                              // Records the compute passes
+        float                 m_TimestampPeriod     = 0.0f;
+
+        uint32_t      m_Capacity        = 0;
+        uint32_t      m_TargetCount     = 0;
+        float         m_Lifetime        = 3.0f;
+        float         m_ParticleSize    = 0.08f;
+        glm::vec3     m_EmitterPosition = glm::vec3(0.0f);
+        float         m_EmitterRadius   = 1.5f;
+        float         m_DeltaTime       = 0.0f;
+        float         m_EmitAccumulator = 0.0f; // Fractional particles carried to the next frame
+        uint32_t      m_EmitCount       = 0;
+        uint32_t      m_Seed            = 0;
+        bool          m_Initialized     = false; // The dead list is filled by the first simulation
+        ParticleStats m_Stats;
+    };
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace vkb
+{
+    struct Device;
+}
+
+namespace MiniEngine::Graphics
+{
+    class VulkanDebugUtils;
+    class VulkanMemory;
+
+    struct VulkanQueue
+    {
+        uint32_t family = 0;
+        VkQueue  queue  = VK_NULL_HANDLE;
+    };
+
+    // Queue family ownership transfer of an exclusive buffer: the release half goes to a command buffer
+    // of the queue giving the buffer up, the acquire half to one of the queue taking it, ordered by a
+    // semaphore. Within one family the semaphore alone is enough, so both halves record nothing.
+    void RecordBufferRelease(VkCommandBuffer commandBuffer, VkBuffer buffer, uint32_t srcFamily, uint32_t dstFamily,
+                             VkPipelineStageFlags srcStage, VkAccessFlags srcAccess);
+    void RecordBufferAcquire(VkCommandBuffer commandBuffer, VkBuffer buffer, uint32_t srcFamily, uint32_t dstFamily,
+                             VkPipelineStageFlags dstStage, VkAccessFlags dstAccess);
+
+    // The graphics queue with the compute and transfer queues beside it, and the command recording for
+    // the latter two. Compute work submitted for a frame signals that frame's semaphore and the frame's
+    // graphics submission waits on it, so compute can overlap the graphics work of earlier frames.
+    // Without separate queue families everything goes to the graphics queue through the same calls,
+    // just without the overlap. Not thread-safe.
+    class VulkanQueues
+    {
+    public:
+        VulkanQueues() = default;
+        ~VulkanQueues();
+
+        VulkanQueues(const VulkanQueues&) = delete;
+        VulkanQueues& operator=(const VulkanQueues&) = delete;
+        VulkanQueues(VulkanQueues&&) = delete;
+        VulkanQueues& operator=(VulkanQueues&&) = delete;
+
+        // Compute and transfer use a family without graphics when the device has one, otherwise the
+        // graphics queue. Call once the device is created.
+        void Select(const vkb::Device& device);
+
+        // Creates the command pools and the per-frame compute command buffers and semaphores
+        bool Initialize(VkDevice device, uint32_t framesInFlight, const VulkanDebugUtils& debugUtils);
+
+        // Destroying the pools frees their command buffers; call before the device is destroyed
+        void Destroy();
+
+        const VulkanQueue& GetGraphics() const
+        {
+            return m_Graphics;
+        }
+
+        const VulkanQueue& GetCompute() const
+        {
+            return m_Compute;
+        }
+
+        const VulkanQueue& GetTransfer() const
+        {
+            return m_Transfer;
+        }
+
+        bool HasAsyncCompute() const
+        {
+            return m_Compute.queue != m_Graphics.queue;
+        }
+
+        // Whether resources the transfer queue fills must change family before graphics uses them
+        bool TransfersOwnership() const
+        {
+            return m_Transfer.family != m_Graphics.family;
+        }
+
+        // Transient, for one-off uploads
+        VkCommandPool GetTransferCommandPool() const
+        {
+            return m_TransferCommandPool;
+        }
+
+        // Only once the frame's fence has signaled: the frame's graphics submission waited on the
+        // previous compute submission, so the frame's compute command buffer is free to record again
+        VkCommandBuffer BeginCompute(uint32_t frame);
+
+        // Submits the frame's compute work; the frame's graphics submission waits for it at graphicsWaitStage
+        bool SubmitCompute(uint32_t frame, VkPipelineStageFlags graphicsWaitStage);
+
+        // What the frame's graphics submission has to wait on, once: false when no compute work was
+        // submitted for the frame since the last call
+        bool TakeComputeWait(uint32_t frame, VkSemaphore& semaphore, VkPipelineStageFlags& stage);
+
+        // Copies data into a device-local buffer through a staging buffer on the transfer queue, then
+        // hands the buffer to the graphics queue through a command buffer from graphicsCommandPool.
+        // Blocks until the graphics queue owns it; meant for load time.
+        bool UploadBuffer(VulkanMemory& memory, VkCommandPool graphicsCommandPool, VkBuffer buffer, const void* data, VkDeviceSize size,
+                          VkPipelineStageFlags dstStage, VkAccessFlags dstAccess);
+
+    private:
+        VkDevice                m_Device     = VK_NULL_HANDLE;
+        const VulkanDebugUtils* m_DebugUtils = nullptr;
+
+        VulkanQueue m_Graphics;
+        VulkanQueue m_Compute;  // The graphics queue when there is no separate compute family
+        VulkanQueue m_Transfer; // The graphics queue when there is no separate transfer family
+
+        VkCommandPool                     m_ComputeCommandPool  = VK_NULL_HANDLE;
+        VkCommandPool                     m_TransferCommandPool = VK_NULL_HANDLE;
+        std::vector<VkCommandBuffer>      m_ComputeCommandBuffers; // One per frame in flight
+        std::vector<VkSemaphore>          m_ComputeFinished;       // Signaled by the frame's compute submission
+        std::vector<VkPipelineStageFlags> m_GraphicsWaitStages;    // Where the frame's graphics work waits, 0 when there is nothing to wait for
+    };
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+namespace MiniEngine::Graphics
+{
+    // Hands out one VkSampler per distinct sampler state, so textures asking for the same filtering
+    // and addressing share a sampler instead of each creating its own against the device's limit.
+    // Not thread-safe; samplers live until Destroy.
+    class VulkanSamplerCache
+    {
+    public:
+        VulkanSamplerCache() = default;
+        ~VulkanSamplerCache();
+
+        VulkanSamplerCache(const VulkanSamplerCache&) = delete;
+        VulkanSamplerCache& operator=(const VulkanSamplerCache&) = delete;
+        VulkanSamplerCache(VulkanSamplerCache&&) = delete;
+        VulkanSamplerCache& operator=(VulkanSamplerCache&&) = delete;
+
+        void Initialize(VkDevice device);
+
+        // Destroys every sampler handed out; call before the device is destroyed
+        void Destroy();
+
+        // Creates the sampler on the first request for its state. pNext is not part of the state and
+        // must be null. Returns VK_NULL_HANDLE if creation fails.
+        VkSampler Get(const VkSamplerCreateInfo& info);
+
+        size_t GetSamplerCount() const
+        {
+            return m_Samplers.size();
+        }
+
+        uint64_t GetRequestCount() const
+        {
+            return m_Requests;
+        }
+
+    private:
+        // Every field of VkSamplerCreateInfo after pNext, floats by their bits
+        using Key = std::array<uint32_t, 16>;
+
+        struct KeyHash
+        {
+            size_t operator()(const Key& key) const;
+        };
+
+        VkDevice m_Device = VK_NULL_HANDLE;
+        std::unordered_map<Key, VkSampler, KeyHash> m_Samplers;
+        uint64_t m_Requests = 0;
+    };
+}
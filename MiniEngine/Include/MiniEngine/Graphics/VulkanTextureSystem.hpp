@@ -0,0 +1,198 @@
+#pragma once
+
+#include "MiniEngine/Graphics/TextureFile.hpp"
+#include "MiniEngine/Graphics/VulkanContext.hpp"
+#include "MiniEngine/Graphics/VulkanSamplerCache.hpp"
+
+#include <vulkan/vulkan.h>
+#include <vk_mem_alloc.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace MiniEngine::Graphics
+{
+    // A texture on the GPU with the descriptor set the lit shader samples it through
+    struct VulkanTexture
+    {
+        std::string     name;
+        VkImage         image         = VK_NULL_HANDLE;
+        VmaAllocation   allocation    = VK_NULL_HANDLE;
+        VkImageView     view          = VK_NULL_HANDLE;
+        VkFormat        format        = VK_FORMAT_UNDEFINED;
+        VkExtent2D      extent        = {};
+        uint32_t        mipCount      = 0;
+        VkSampler       sampler       = VK_NULL_HANDLE; // Owned by the sampler cache
+        VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+    };
+
+    struct TextureStats
+    {
+        uint32_t     requested     = 0;
+        uint32_t     loaded        = 0;
+        uint32_t     failed        = 0;
+        uint32_t     batches       = 0;
+        uint32_t     generatedMips = 0; // Levels written by the mip generation shader
+        VkDeviceSize uploadedBytes = 0;
+        double       readMs        = 0.0; // Summed over the loader's reads
+    };
+
+    struct TextureSystemInfo
+    {
+        std::string mipShader;                    // Writes one level from the level above it
+        bool        textureCompressionBC = false; // Whether the device was created with BC textures enabled
+    };
+
+    // Textures streamed from KTX2 and DDS files. A loader thread opens each requested file and reads its
+    // levels straight into a staging buffer, so block compressed data is never touched by the CPU. Once
+    // per frame the render thread submits what is ready: copies on the transfer queue, then a compute
+    // pass on the graphics queue for the mips uncompressed files leave out. Texture 0 is a white texel,
+    // sampled until another one is picked. Apart from the loader, not thread-safe.
+    class VulkanTextureSystem
+    {
+    public:
+        static constexpr uint32_t     MaxTextures            = 1024;
+        static constexpr uint32_t     MaxUploadsPerFrame     = 32;
+        static constexpr VkDeviceSize MaxUploadBytesPerFrame = 64u << 20;  // Bounds the copy work one frame submits
+        static constexpr VkDeviceSize MaxStagingBytes        = 256u << 20; // The loader waits while this much is read but not yet copied
+
+        VulkanTextureSystem() = default;
+        ~VulkanTextureSystem();
+
+        VulkanTextureSystem(const VulkanTextureSystem&) = delete;
+        VulkanTextureSystem& operator=(const VulkanTextureSystem&) = delete;
+        VulkanTextureSystem(VulkanTextureSystem&&) = delete;
+        VulkanTextureSystem& operator=(VulkanTextureSystem&&) = delete;
+
+        // Uploads the white texel and starts the loader
+        bool Initialize(const VulkanContext& context, const TextureSystemInfo& info);
+
+        // Stops the loader and waits for the uploads in flight; call before the device is destroyed
+        void Destroy();
+
+        // Set 2 of the lit pipeline
+        VkDescriptorSetLayout GetSetLayout() const
+        {
+            return m_SetLayout;
+        }
+
+        const VulkanSamplerCache& GetSamplers() const
+        {
+            return m_Samplers;
+        }
+
+        const TextureStats& GetStats() const
+        {
+            return m_Stats;
+        }
+
+        // The resident textures, in the order their uploads finished
+        uint32_t GetTextureCount() const
+        {
+            return static_cast<uint32_t>(m_Textures.size());
+        }
+
+        const VulkanTexture& GetTexture(uint32_t index) const
+        {
+            return m_Textures[index];
+        }
+
+        // The texture every object samples, clamped to the resident ones
+        void SetActiveIndex(uint32_t index)
+        {
+            m_Active = std::min(index, GetTextureCount() - 1);
+        }
+
+        uint32_t GetActiveIndex() const
+        {
+            return m_Active;
+        }
+
+        const VulkanTexture& GetActiveTexture() const
+        {
+            return m_Textures[m_Active];
+        }
+
+        // Queues a file for the loader; false once MaxTextures are requested
+        bool RequestTexture(const std::filesystem::path& path);
+
+        // Every .ktx2 and .dds file, by name. Returns the number requested.
+        uint32_t RequestDirectory(const std::filesystem::path& directory);
+
+        // Once per frame on the render thread. Retires batches the GPU has finished, making their
+        // textures resident, then submits what the loader has ready within the per-frame limits.
+        // Never waits for the GPU or the loader.
+        bool Update();
+
+    private:
+        // A texture the loader thread has read into its own staging buffer, waiting for its copy
+        struct Upload
+        {
+            VulkanTexture      texture;
+            TextureDescription description;
+            VkBuffer           stagingBuffer     = VK_NULL_HANDLE;
+            VmaAllocation      stagingAllocation = VK_NULL_HANDLE;
+            double             readMs            = 0.0; // Opening the file and reading its levels
+        };
+
+        // The uploads submitted in one frame: copied on the transfer queue, then taken over by the
+        // graphics queue, which generates the mips the files left out
+        struct Batch
+        {
+            std::vector<Upload>      uploads;
+            VkCommandBuffer          transferCommands  = VK_NULL_HANDLE;
+            VkCommandBuffer          graphicsCommands  = VK_NULL_HANDLE;
+            VkSemaphore              transferred       = VK_NULL_HANDLE;
+            VkFence                  finished          = VK_NULL_HANDLE;
+            VkDescriptorPool         mipDescriptorPool = VK_NULL_HANDLE; // Null when no mips are generated
+            std::vector<VkImageView> mipViews;                           // Single-level storage views for the mip generation
+        };
+
+        bool CreateTextureImage(VulkanTexture& texture, bool generateMips);
+        void DestroyTexture(VulkanTexture& texture);
+        bool WriteDescriptorSet(VulkanTexture& texture);
+        bool UploadWhiteTexel(VulkanTexture& white, const ImmediateCommandsFunction& execute);
+        bool Load(Upload& upload, const std::filesystem::path& path);
+        void RunLoader();
+        void ReleaseBatch(Batch& batch);
+        void RecordCopies(Batch& batch);
+        uint32_t RecordMipGeneration(Batch& batch, VkPipelineStageFlags waitStage);
+
+        VkDevice                m_Device               = VK_NULL_HANDLE;
+        VkPhysicalDevice        m_PhysicalDevice       = VK_NULL_HANDLE;
+        VulkanMemory*           m_Memory               = nullptr;
+        VulkanQueues*           m_Queues               = nullptr;
+        const VulkanDebugUtils* m_DebugUtils           = nullptr;
+        bool                    m_TextureCompressionBC = false;
+
+        VulkanSamplerCache         m_Samplers;
+        VkSamplerCreateInfo        m_SamplerInfo{};                      // Trilinear and repeating
+        VkDescriptorSetLayout      m_SetLayout         = VK_NULL_HANDLE;
+        VkDescriptorPool           m_DescriptorPool    = VK_NULL_HANDLE;
+        VkDescriptorSetLayout      m_MipSetLayout      = VK_NULL_HANDLE;
+        VkPipelineLayout           m_MipPipelineLayout = VK_NULL_HANDLE;
+        VkPipeline                 m_MipPipeline       = VK_NULL_HANDLE;
+        VkCommandPool              m_CommandPool       = VK_NULL_HANDLE; // Graphics queue, for the mip generation
+        std::vector<VulkanTexture> m_Textures;
+        uint32_t                   m_Active            = 0;
+        std::deque<Batch>          m_Batches;                            // Submitted, oldest first
+        TextureStats               m_Stats;
+
+        // Shared with the loader thread, guarded by m_Mutex
+        std::thread                       m_Loader;
+        std::mutex                        m_Mutex;
+        std::condition_variable           m_Condition;
+        std::deque<std::filesystem::path> m_Requests;
+        std::deque<Upload>                m_Ready;
+        VkDeviceSize                      m_StagingBytes = 0;
+        uint32_t                          m_FailedLoads  = 0;
+        bool                              m_Stopping     = false;
+    };
+}
@@ -3,6 +3,8 @@
 #define GLFW_INCLUDE_NONE
 #include <GLFW/glfw3.h>
 
+#include "MiniEngine/Graphics/RedrawScheduler.hpp"
+
 #include <string>
 
 namespace MiniEngine::Graphics
@@ -23,12 +25,26 @@ namespace MiniEngine::Graphics
             return glfwWindowShouldClose(m_Handle);
         }
 
-        void Update();
+        // Processes events; on demand, sleeps until something needs redrawing. True when a frame
+        // should be rendered, which GetRedraw then describes.
+        bool Update();
+
+        const Redraw& GetRedraw() const
+        {
+            return m_Redraw;
+        }
+
+        RedrawScheduler& GetRedrawScheduler()
+        {
+            return m_RedrawScheduler;
+        }
 
     private:
         std::string m_Title;
         uint32_t m_Width;
         uint32_t m_Height;
         GLFWwindow* m_Handle = nullptr;
+        RedrawScheduler m_RedrawScheduler;
+        Redraw m_Redraw;
     };
 }
\ No newline at end of file
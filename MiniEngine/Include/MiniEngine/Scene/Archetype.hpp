@@ -0,0 +1,111 @@
+#pragma once
+
+#include "MiniEngine/Scene/Entity.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+namespace MiniEngine::Scene
+{
+    using ComponentId = uint32_t;
+    using ComponentMask = uint64_t;
+
+    inline constexpr uint32_t MaxComponentTypes = 64;
+
+    namespace Detail
+    {
+        ComponentId RegisterComponentType(size_t size, size_t alignment);
+    }
+
+    // Columns are relocated with memcpy, so components must be plain data
+    template <typename T>
+    ComponentId GetComponentId()
+    {
+        static_assert(std::is_trivially_copyable_v<T> && std::is_trivially_destructible_v<T>,
+            "Components must be trivially copyable plain data");
+
+        static const ComponentId id = Detail::RegisterComponentType(sizeof(T), alignof(T));
+        return id;
+    }
+
+    template <typename... Ts>
+    ComponentMask GetComponentMask()
+    {
+        return (ComponentMask{ 0 } | ... | (ComponentMask{ 1 } << GetComponentId<Ts>()));
+    }
+
+    // All entities that share one exact component set, stored as one tightly packed column per component
+    class Archetype
+    {
+    public:
+        explicit Archetype(ComponentMask mask);
+        ~Archetype();
+
+        Archetype(const Archetype&) = delete;
+        Archetype& operator=(const Archetype&) = delete;
+        Archetype(Archetype&&) = delete;
+        Archetype& operator=(Archetype&&) = delete;
+
+        ComponentMask GetMask() const
+        {
+            return m_Mask;
+        }
+
+        size_t GetSize() const
+        {
+            return m_Entities.size();
+        }
+
+        const Entity* GetEntities() const
+        {
+            return m_Entities.data();
+        }
+
+        bool HasComponent(ComponentId id) const
+        {
+            return (m_Mask >> id) & 1;
+        }
+
+        void* GetColumn(ComponentId id)
+        {
+            const uint8_t column = m_ColumnIndex[id];
+            return column == NoColumn ? nullptr : m_Columns[column].data;
+        }
+
+        template <typename T>
+        T* GetColumn()
+        {
+            return static_cast<T*>(GetColumn(GetComponentId<T>()));
+        }
+
+        void Reserve(size_t capacity);
+
+        // Appends an entity whose components are left uninitialized and returns its row
+        uint32_t AddRow(Entity entity);
+
+        // Swap-removes a row and returns the entity that was moved into it, or an invalid entity
+        Entity RemoveRow(uint32_t row);
+
+        // Copies every component the target archetype also has into the given target row
+        void CopyRowTo(uint32_t row, Archetype& target, uint32_t targetRow) const;
+
+    private:
+        static constexpr uint8_t NoColumn = 0xFF;
+
+        struct Column
+        {
+            ComponentId id          = 0;
+            size_t      elementSize = 0;
+            std::byte*  data        = nullptr;
+        };
+
+        ComponentMask m_Mask;
+        std::vector<Column> m_Columns;
+        std::array<uint8_t, MaxComponentTypes> m_ColumnIndex;
+        std::vector<Entity> m_Entities;
+        size_t m_Capacity = 0;
+    };
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+namespace MiniEngine::Scene
+{
+    struct Transform
+    {
+        glm::vec3 position = glm::vec3(0.0f);
+        glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+        glm::vec3 scale    = glm::vec3(1.0f);
+    };
+
+    // Where rendering puts a transform between two simulation steps: alpha 0 is previous, 1 is current
+    inline Transform Interpolate(const Transform& previous, const Transform& current, float alpha)
+    {
+        Transform transform;
+        transform.position = glm::mix(previous.position, current.position, alpha);
+        transform.rotation = glm::slerp(previous.rotation, current.rotation, alpha);
+        transform.scale = glm::mix(previous.scale, current.scale, alpha);
+        return transform;
+    }
+
+    // The transform as of the previous simulation step, for entities that get interpolated
+    struct PreviousTransform
+    {
+        Transform value;
+    };
+
+    // World-space bounds: an axis-aligned box (center/half-extents) plus an enclosing sphere radius
+    struct Bounds
+    {
+        glm::vec3 center  = glm::vec3(0.0f);
+        float     radius  = 0.0f;
+        glm::vec3 extents = glm::vec3(0.0f);
+    };
+}
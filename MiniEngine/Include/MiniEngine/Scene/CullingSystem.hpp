@@ -0,0 +1,152 @@
+#pragma once
+
+#include "MiniEngine/Core/CpuFeatures.hpp"
+#include "MiniEngine/Core/JobSystem.hpp"
+#include "MiniEngine/Scene/Components.hpp"
+#include "MiniEngine/Scene/Frustum.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace MiniEngine::Scene
+{
+    struct CullingStats
+    {
+        uint32_t objectCount     = 0;
+        uint32_t testedNodes     = 0;
+        uint32_t testedObjects   = 0; // Objects that went through the per-object SIMD test
+        uint32_t acceptedObjects = 0; // Objects accepted untested because their whole node was inside
+        uint32_t visibleObjects  = 0;
+        uint32_t refittedNodes   = 0;
+        bool     rebuilt         = false;
+        double   cullTimeMs      = 0.0; // Refit or rebuild plus traversal
+    };
+
+    // Frustum culling over a bounding volume hierarchy. Moving objects only refit the nodes above
+    // them; adding or removing objects, or letting refits degrade the tree too far, triggers a rebuild.
+    class CullingSystem
+    {
+    public:
+        using ObjectId = uint32_t;
+        static constexpr ObjectId InvalidObject = 0xFFFFFFFFu;
+
+        // Picks the widest kernel the CPU supports
+        CullingSystem();
+        explicit CullingSystem(Core::SimdLevel simdLevel);
+
+        CullingSystem(const CullingSystem&) = delete;
+        CullingSystem& operator=(const CullingSystem&) = delete;
+        CullingSystem(CullingSystem&&) = delete;
+        CullingSystem& operator=(CullingSystem&&) = delete;
+
+        // userData is what Cull reports for the object, typically an index into the caller's draw data
+        ObjectId AddObject(const Bounds& bounds, uint32_t userData);
+        void UpdateObject(ObjectId object, const Bounds& bounds);
+        void RemoveObject(ObjectId object);
+
+        size_t GetObjectCount() const
+        {
+            return m_ObjectCount;
+        }
+
+        // Replaces the contents of visible with the user data of every object intersecting the frustum.
+        // The order is deterministic and the same whether or not a job system is given.
+        void Cull(const Frustum& frustum, std::vector<uint32_t>& visible, Core::JobSystem* jobs = nullptr);
+
+        // Tests every object without using the hierarchy; a reference for Cull and for benchmarks
+        void CullLinear(const Frustum& frustum, std::vector<uint32_t>& visible);
+
+        const CullingStats& GetStats() const
+        {
+            return m_Stats;
+        }
+
+        Core::SimdLevel GetSimdLevel() const
+        {
+            return m_SimdLevel;
+        }
+
+        // Requests above what the CPU supports are clamped
+        void SetSimdLevel(Core::SimdLevel simdLevel);
+
+    private:
+        struct Object
+        {
+            Bounds   bounds;
+            uint32_t userData = 0;
+            uint32_t slot     = 0;
+            bool     alive    = false;
+        };
+
+        // Children are stored as a pair at firstChild and firstChild + 1, always after their parent.
+        // The objects of a whole subtree occupy one contiguous slot range.
+        struct Node
+        {
+            glm::vec3 boundsMin   = glm::vec3(0.0f);
+            uint32_t  firstChild  = 0; // 0 marks a leaf, the root is never a child
+            glm::vec3 boundsMax   = glm::vec3(0.0f);
+            uint32_t  parent      = 0;
+            uint32_t  objectFirst = 0;
+            uint32_t  objectCount = 0;
+        };
+
+        struct Task
+        {
+            uint32_t node       = 0;
+            uint32_t planeMask  = 0;
+            bool     accepted   = false; // Fully inside, emit without traversal
+            bool     classified = false; // planeMask is already the node's own, so it is not tested again
+        };
+
+        struct Counters
+        {
+            uint32_t testedNodes     = 0;
+            uint32_t testedObjects   = 0;
+            uint32_t acceptedObjects = 0;
+        };
+
+        void Commit();
+        void Rebuild();
+        void BuildNode(uint32_t nodeIndex, uint32_t first, uint32_t count);
+        void WriteSlot(uint32_t slot, const Object& object);
+        void MarkDirty(uint32_t node);
+        void RefitNode(Node& node);
+        uint32_t Classify(const Node& node, uint32_t planeMask, Counters& counters) const;
+        size_t TraverseSubtree(const Task& task, uint32_t* output, Counters& counters) const;
+
+        Core::SimdLevel m_SimdLevel = Core::SimdLevel::Scalar;
+
+        std::vector<Object> m_Objects;
+        std::vector<ObjectId> m_FreeObjects;
+        size_t m_ObjectCount = 0;
+
+        // Per slot, in leaf order, so every leaf tests a contiguous run with SIMD loads
+        std::vector<float> m_CenterX, m_CenterY, m_CenterZ;
+        std::vector<float> m_ExtentX, m_ExtentY, m_ExtentZ;
+        std::vector<float> m_Radius;
+        std::vector<uint32_t> m_UserData;
+        std::vector<ObjectId> m_SlotObject;
+        std::vector<uint32_t> m_SlotLeaf;
+
+        std::vector<Node> m_Nodes;
+        std::vector<uint8_t> m_NodeDirty;
+        bool m_StructureDirty = false;
+        bool m_HasDirtyNodes = false;
+        float m_BuildLeafArea = 0.0f;
+        float m_LeafArea = 0.0f;
+
+        Frustum m_Frustum;
+
+        // Frame-to-frame scratch so culling does not allocate in the steady state
+        std::vector<Task> m_Tasks;
+        std::vector<Task> m_Pending;
+        std::vector<std::vector<uint32_t>> m_TaskOutputs;
+        std::vector<size_t> m_TaskVisible;
+        std::vector<Counters> m_TaskCounters;
+
+        CullingStats m_Stats;
+    };
+}
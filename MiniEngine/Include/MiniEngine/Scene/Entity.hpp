@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+
+namespace MiniEngine::Scene
+{
+    // Stable entity handle. The generation is bumped whenever an index is recycled,
+    // so a handle to a destroyed entity never aliases the entity that reuses its slot.
+    struct Entity
+    {
+        static constexpr uint32_t InvalidIndex = 0xFFFFFFFFu;
+
+        uint32_t index      = InvalidIndex;
+        uint32_t generation = 0;
+
+        bool IsValid() const
+        {
+            return index != InvalidIndex;
+        }
+
+        friend bool operator==(const Entity&, const Entity&) = default;
+    };
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "MiniEngine/Scene/Components.hpp"
+
+#include <glm/glm.hpp>
+
+#include <array>
+
+namespace MiniEngine::Scene
+{
+    // Six inward-facing planes (xyz = normal, w = distance), so a point p is inside when dot(n, p) + w >= 0
+    struct Frustum
+    {
+        enum Plane { Left, Right, Bottom, Top, Near, Far, PlaneCount };
+
+        std::array<glm::vec4, PlaneCount> planes;
+
+        // Extracts the planes from a view-projection matrix with Vulkan's [0, 1] clip depth
+        static Frustum FromMatrix(const glm::mat4& viewProjection);
+
+        // Conservative: may report boxes slightly outside a frustum corner as visible
+        bool Intersects(const Bounds& bounds) const;
+    };
+}
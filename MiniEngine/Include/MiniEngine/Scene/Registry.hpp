@@ -0,0 +1,241 @@
+#pragma once
+
+#include "MiniEngine/Core/JobSystem.hpp"
+#include "MiniEngine/Scene/Archetype.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace MiniEngine::Scene
+{
+    // Iterates every entity that has all of Ts. A view is a snapshot of the matching archetypes;
+    // creating, destroying or changing the components of entities invalidates it.
+    template <typename... Ts>
+    class View
+    {
+    public:
+        explicit View(std::vector<Archetype*> archetypes)
+            : m_Archetypes(std::move(archetypes))
+        {
+        }
+
+        size_t GetSize() const
+        {
+            size_t size = 0;
+            for (const Archetype* archetype : m_Archetypes)
+            {
+                size += archetype->GetSize();
+            }
+            return size;
+        }
+
+        // function(Entity, Ts&...)
+        template <typename Function>
+        void Each(Function&& function) const
+        {
+            EachChunk([&](size_t count, const Entity* entities, Ts*... columns)
+            {
+                for (size_t i = 0; i < count; ++i)
+                {
+                    function(entities[i], columns[i]...);
+                }
+            });
+        }
+
+        // function(size_t count, const Entity* entities, Ts*... columns), once per contiguous column range
+        template <typename Function>
+        void EachChunk(Function&& function) const
+        {
+            for (Archetype* archetype : m_Archetypes)
+            {
+                if (archetype->GetSize() > 0)
+                {
+                    function(archetype->GetSize(), archetype->GetEntities(), archetype->template GetColumn<Ts>()...);
+                }
+            }
+        }
+
+        // Like EachChunk, but rows are split into batches that run on the job system
+        template <typename Function>
+        void ParallelEachChunk(Core::JobSystem& jobs, Function&& function, size_t minBatchSize = 4096) const
+        {
+            std::vector<size_t> offsets(m_Archetypes.size() + 1, 0);
+            for (size_t i = 0; i < m_Archetypes.size(); ++i)
+            {
+                offsets[i + 1] = offsets[i] + m_Archetypes[i]->GetSize();
+            }
+
+            jobs.ParallelFor(offsets.back(), minBatchSize, [&](size_t begin, size_t end)
+            {
+                size_t index = static_cast<size_t>(std::upper_bound(offsets.begin(), offsets.end(), begin) - offsets.begin()) - 1;
+
+                while (begin < end)
+                {
+                    Archetype* archetype = m_Archetypes[index];
+                    const size_t rowBegin = begin - offsets[index];
+                    const size_t rowEnd = std::min(end, offsets[index + 1]) - offsets[index];
+
+                    if (rowEnd > rowBegin)
+                    {
+                        function(rowEnd - rowBegin, archetype->GetEntities() + rowBegin, (archetype->template GetColumn<Ts>() + rowBegin)...);
+                    }
+
+                    begin = offsets[index] + rowEnd;
+                    ++index;
+                }
+            });
+        }
+
+        // function(Entity, Ts&...), called concurrently from several threads
+        template <typename Function>
+        void ParallelEach(Core::JobSystem& jobs, Function&& function, size_t minBatchSize = 4096) const
+        {
+            ParallelEachChunk(jobs, [&](size_t count, const Entity* entities, Ts*... columns)
+            {
+                for (size_t i = 0; i < count; ++i)
+                {
+                    function(entities[i], columns[i]...);
+                }
+            }, minBatchSize);
+        }
+
+    private:
+        std::vector<Archetype*> m_Archetypes;
+    };
+
+    class Registry
+    {
+    public:
+        Registry();
+        ~Registry();
+
+        Registry(const Registry&) = delete;
+        Registry& operator=(const Registry&) = delete;
+        Registry(Registry&&) = delete;
+        Registry& operator=(Registry&&) = delete;
+
+        Entity Create();
+        void Destroy(Entity entity);
+        bool IsAlive(Entity entity) const;
+
+        size_t GetEntityCount() const
+        {
+            return m_AliveCount;
+        }
+
+        // Creates an entity directly in its final archetype, without intermediate moves
+        template <typename... Ts>
+        Entity Create(const Ts&... components)
+        {
+            Archetype& archetype = GetOrCreateArchetype(GetComponentMask<Ts...>());
+            const Entity entity = AllocateEntity();
+            const uint32_t row = archetype.AddRow(entity);
+            ((archetype.GetColumn<Ts>()[row] = components), ...);
+            m_Records[entity.index].archetype = &archetype;
+            m_Records[entity.index].row = row;
+            return entity;
+        }
+
+        // Makes room for count more entities created with exactly these components
+        template <typename... Ts>
+        void Reserve(size_t count)
+        {
+            Archetype& archetype = GetOrCreateArchetype(GetComponentMask<Ts...>());
+            archetype.Reserve(archetype.GetSize() + count);
+            m_Records.reserve(m_Records.size() + count);
+        }
+
+        template <typename T>
+        T& Add(Entity entity, const T& component = T{})
+        {
+            EntityRecord& record = GetRecord(entity);
+            const ComponentId id = GetComponentId<T>();
+
+            if (!record.archetype->HasComponent(id))
+            {
+                MoveEntity(record, GetOrCreateArchetype(record.archetype->GetMask() | (ComponentMask{ 1 } << id)));
+            }
+
+            T& stored = record.archetype->GetColumn<T>()[record.row];
+            stored = component;
+            return stored;
+        }
+
+        template <typename T>
+        void Remove(Entity entity)
+        {
+            EntityRecord& record = GetRecord(entity);
+            const ComponentId id = GetComponentId<T>();
+
+            if (record.archetype->HasComponent(id))
+            {
+                MoveEntity(record, GetOrCreateArchetype(record.archetype->GetMask() & ~(ComponentMask{ 1 } << id)));
+            }
+        }
+
+        template <typename T>
+        bool Has(Entity entity) const
+        {
+            return GetRecord(entity).archetype->HasComponent(GetComponentId<T>());
+        }
+
+        template <typename T>
+        T* TryGet(Entity entity)
+        {
+            const EntityRecord& record = GetRecord(entity);
+            T* column = record.archetype->GetColumn<T>();
+            return column ? column + record.row : nullptr;
+        }
+
+        template <typename T>
+        T& Get(Entity entity)
+        {
+            T* component = TryGet<T>(entity);
+            if (!component)
+            {
+                ThrowMissingComponent();
+            }
+            return *component;
+        }
+
+        template <typename... Ts>
+        View<Ts...> Query()
+        {
+            const ComponentMask mask = GetComponentMask<Ts...>();
+            std::vector<Archetype*> matches;
+
+            for (const auto& archetype : m_Archetypes)
+            {
+                if ((archetype->GetMask() & mask) == mask)
+                {
+                    matches.push_back(archetype.get());
+                }
+            }
+
+            return View<Ts...>(std::move(matches));
+        }
+
+    private:
+        struct EntityRecord
+        {
+            Archetype* archetype  = nullptr;
+            uint32_t   row        = 0;
+            uint32_t   generation = 0;
+        };
+
+        EntityRecord& GetRecord(Entity entity);
+        const EntityRecord& GetRecord(Entity entity) const;
+        Entity AllocateEntity();
+        Archetype& GetOrCreateArchetype(ComponentMask mask);
+        void MoveEntity(EntityRecord& record, Archetype& target);
+        [[noreturn]] static void ThrowMissingComponent();
+
+        std::vector<EntityRecord> m_Records;
+        std::vector<uint32_t> m_FreeIndices;
+        std::vector<std::unique_ptr<Archetype>> m_Archetypes;
+        std::unordered_map<ComponentMask, Archetype*> m_ArchetypesByMask;
+        size_t m_AliveCount = 0;
+    };
+}
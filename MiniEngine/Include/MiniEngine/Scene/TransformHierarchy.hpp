@@ -0,0 +1,115 @@
+#pragma once
+
+#include "MiniEngine/Core/CpuFeatures.hpp"
+#include "MiniEngine/Core/JobSystem.hpp"
+#include "MiniEngine/Scene/Components.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace MiniEngine::Scene
+{
+    // Local transforms stored as structure-of-arrays and kept sorted by depth, so every parent
+    // precedes its children and all nodes of one depth can be processed as a single batch.
+    // Only dirty nodes and their descendants get their world matrices recomputed.
+    class TransformHierarchy
+    {
+    public:
+        // Stable node handle. Like entity handles, the generation is bumped whenever an index is
+        // recycled, so a handle to a destroyed node never reaches the node that reuses its index.
+        struct NodeId
+        {
+            static constexpr uint32_t InvalidIndex = 0xFFFFFFFFu;
+
+            uint32_t index      = InvalidIndex;
+            uint32_t generation = 0;
+
+            bool IsValid() const
+            {
+                return index != InvalidIndex;
+            }
+
+            friend bool operator==(const NodeId&, const NodeId&) = default;
+        };
+
+        static constexpr NodeId InvalidNode = { NodeId::InvalidIndex, 0 };
+
+        // Picks the widest kernel the CPU supports
+        TransformHierarchy();
+        explicit TransformHierarchy(Core::SimdLevel simdLevel);
+
+        TransformHierarchy(const TransformHierarchy&) = delete;
+        TransformHierarchy& operator=(const TransformHierarchy&) = delete;
+        TransformHierarchy(TransformHierarchy&&) = delete;
+        TransformHierarchy& operator=(TransformHierarchy&&) = delete;
+
+        // An invalid parent attaches the node to the implicit root
+        NodeId CreateNode(NodeId parent = InvalidNode, const Transform& local = Transform{});
+
+        // Destroys the node together with all of its descendants. Every other member taking a node
+        // throws std::invalid_argument for destroyed or stale handles.
+        void DestroyNode(NodeId node);
+        bool IsAlive(NodeId node) const;
+
+        void SetParent(NodeId node, NodeId parent);
+        NodeId GetParent(NodeId node) const;
+
+        void SetLocalTransform(NodeId node, const Transform& local);
+        void SetLocalPosition(NodeId node, const glm::vec3& position);
+        void SetLocalRotation(NodeId node, const glm::quat& rotation);
+        void SetLocalScale(NodeId node, const glm::vec3& scale);
+        Transform GetLocalTransform(NodeId node) const;
+
+        // Valid after the Update that followed the last change to the node or its ancestors
+        const glm::mat4& GetWorldMatrix(NodeId node) const;
+
+        // Recomputes the world matrices of dirty nodes and their descendants and returns how many
+        // were updated. Depth levels with many dirty nodes are split across the job system if given.
+        size_t Update(Core::JobSystem* jobs = nullptr);
+
+        size_t GetNodeCount() const
+        {
+            return m_NodeCount;
+        }
+
+        Core::SimdLevel GetSimdLevel() const
+        {
+            return m_SimdLevel;
+        }
+
+        // Requests above what the CPU supports are clamped
+        void SetSimdLevel(Core::SimdLevel simdLevel);
+
+    private:
+        uint32_t GetSlot(NodeId node) const;
+        void AppendSlot(NodeId node, uint32_t parentSlot, const Transform& local);
+        void WriteLocal(uint32_t slot, const Transform& local);
+        void Reorder();
+
+        Core::SimdLevel m_SimdLevel = Core::SimdLevel::Scalar;
+
+        // Per slot; slot 0 is the implicit root with an identity world matrix
+        std::vector<float> m_PositionX, m_PositionY, m_PositionZ;
+        std::vector<float> m_RotationX, m_RotationY, m_RotationZ, m_RotationW;
+        std::vector<float> m_ScaleX, m_ScaleY, m_ScaleZ;
+        std::vector<uint32_t> m_Parent;
+        std::vector<uint8_t> m_Dirty;
+        std::vector<uint8_t> m_Alive;
+        std::vector<glm::mat4> m_World;
+        std::vector<NodeId> m_NodeOfSlot;
+
+        // Per node index
+        std::vector<uint32_t> m_SlotOfNode;
+        std::vector<uint32_t> m_NodeGenerations;
+        std::vector<uint32_t> m_FreeIndices;
+
+        // Slot ranges of each depth, valid while the order is not dirty
+        std::vector<uint32_t> m_LevelOffsets;
+        std::vector<uint32_t> m_DirtySlots;
+        bool m_OrderDirty = false;
+        size_t m_NodeCount = 0;
+    };
+}
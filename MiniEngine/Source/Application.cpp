@@ -5,6 +5,8 @@ using namespace MiniEngine;
 Application::Application()
     : m_Window(new Graphics::Window("MiniEngine", 1280, 720))
 {
+    // Until an application animates something, there is no reason to spin while the window sits there
+    m_Window->GetRedrawScheduler().SetMode(Graphics::RedrawMode::OnDemand);
 }
 
 Application::~Application()
@@ -16,6 +18,22 @@ void Application::Run()
 {
     while (!m_Window->ShouldClose())
     {
-        m_Window->Update();
+        if (!m_Window->Update())
+        {
+            continue;
+        }
+
+        // On demand the loop may have slept since the last frame, which is neither frame time nor simulated
+        if (m_Window->GetRedraw().idle)
+        {
+            m_Clock.Resync();
+        }
+
+        for (uint32_t steps = m_Clock.Tick(); steps > 0; --steps)
+        {
+            FixedUpdate(m_Clock.GetStepSeconds());
+        }
+        Render(m_Clock.GetAlpha());
+        m_Window->GetRedrawScheduler().NotifyPresented(m_Window->GetRedraw());
     }
 }
\ No newline at end of file
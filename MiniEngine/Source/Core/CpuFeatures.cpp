@@ -0,0 +1,118 @@
+#include "MiniEngine/Core/CpuFeatures.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <cstdint>
+
+#if MINIENGINE_SIMD_X86
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+using namespace MiniEngine::Core;
+
+namespace
+{
+#if MINIENGINE_SIMD_X86
+    void Cpuid(uint32_t leaf, uint32_t subleaf, uint32_t registers[4])
+    {
+#if defined(_MSC_VER)
+        int values[4];
+        __cpuidex(values, static_cast<int>(leaf), static_cast<int>(subleaf));
+        for (int i = 0; i < 4; ++i)
+        {
+            registers[i] = static_cast<uint32_t>(values[i]);
+        }
+#else
+        __cpuid_count(leaf, subleaf, registers[0], registers[1], registers[2], registers[3]);
+#endif
+    }
+
+    uint64_t ReadExtendedControlRegister()
+    {
+#if defined(_MSC_VER)
+        return _xgetbv(0);
+#else
+        uint32_t eax = 0;
+        uint32_t edx = 0;
+        __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+        return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+    }
+#endif
+
+    CpuFeatures DetectCpuFeatures()
+    {
+        CpuFeatures features;
+
+#if MINIENGINE_SIMD_X86
+        uint32_t registers[4] = {};
+        Cpuid(0, 0, registers);
+        const uint32_t maxLeaf = registers[0];
+
+        if (maxLeaf >= 1)
+        {
+            Cpuid(1, 0, registers);
+            const uint32_t ecx = registers[2];
+            const uint32_t edx = registers[3];
+
+            features.sse2 = (edx >> 26) & 1;
+            features.sse41 = (ecx >> 19) & 1;
+
+            // AVX state must be enabled by the OS (OSXSAVE + XCR0 bits 1 and 2), not just reported
+            const bool osSavesYmm = ((ecx >> 27) & 1) && (ReadExtendedControlRegister() & 0x6) == 0x6;
+            features.avx = ((ecx >> 28) & 1) && osSavesYmm;
+            features.fma = ((ecx >> 12) & 1) && features.avx;
+        }
+
+        if (maxLeaf >= 7 && features.avx)
+        {
+            Cpuid(7, 0, registers);
+            features.avx2 = (registers[1] >> 5) & 1;
+        }
+#endif
+
+        return features;
+    }
+}
+
+const CpuFeatures& MiniEngine::Core::GetCpuFeatures()
+{
+    static const CpuFeatures features = []
+    {
+        const CpuFeatures detected = DetectCpuFeatures();
+        spdlog::debug("CPU features: SSE2 {}, SSE4.1 {}, AVX {}, AVX2 {}, FMA {}",
+            detected.sse2, detected.sse41, detected.avx, detected.avx2, detected.fma);
+        return detected;
+    }();
+    return features;
+}
+
+SimdLevel MiniEngine::Core::GetSupportedSimdLevel()
+{
+    const CpuFeatures& features = GetCpuFeatures();
+
+    if (features.avx2 && features.fma)
+    {
+        return SimdLevel::Avx2;
+    }
+    if (features.sse2)
+    {
+        return SimdLevel::Sse;
+    }
+    return SimdLevel::Scalar;
+}
+
+const char* MiniEngine::Core::ToString(SimdLevel level)
+{
+    switch (level)
+    {
+    case SimdLevel::Scalar: return "Scalar";
+    case SimdLevel::Sse:    return "SSE";
+    case SimdLevel::Avx2:   return "AVX2";
+    }
+    return "Unknown";
+}
@@ -0,0 +1,87 @@
+#include "MiniEngine/Core/FrameClock.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using namespace MiniEngine::Core;
+
+FrameClock::FrameClock(double stepSeconds, uint32_t maxStepsPerFrame)
+    : m_StepSeconds(stepSeconds), m_MaxStepsPerFrame(maxStepsPerFrame)
+{
+    if (!(stepSeconds > 0.0) || maxStepsPerFrame == 0)
+    {
+        throw std::invalid_argument("A frame clock needs a positive step and at least one step per frame");
+    }
+}
+
+uint32_t FrameClock::Tick()
+{
+    const Clock::time_point now = Clock::now();
+    if (!m_Started)
+    {
+        m_LastTick = now;
+        m_Started = true;
+        return 0;
+    }
+
+    m_FrameSeconds = std::chrono::duration<double>(now - m_LastTick).count();
+    m_LastTick = now;
+    m_FrameMs[m_Stats.frames % StatsWindow] = static_cast<float>(m_FrameSeconds * 1000.0);
+    ++m_Stats.frames;
+
+    if (m_Paused)
+    {
+        return 0;
+    }
+
+    m_Accumulator += m_FrameSeconds;
+    const double dueSteps = std::floor(m_Accumulator / m_StepSeconds);
+    const uint32_t steps = static_cast<uint32_t>(std::min(dueSteps, static_cast<double>(m_MaxStepsPerFrame)));
+    if (dueSteps > steps)
+    {
+        m_Stats.droppedSteps += static_cast<uint64_t>(dueSteps) - steps;
+    }
+
+    // Dropped steps go with the ones simulated; only the fraction of a step carries over
+    m_Accumulator = std::clamp(m_Accumulator - dueSteps * m_StepSeconds, 0.0, m_StepSeconds);
+    m_Stats.steps += steps;
+    return steps;
+}
+
+void FrameClock::Resync()
+{
+    m_Started = false;
+    m_FrameSeconds = 0.0;
+}
+
+void FrameClock::SetPaused(bool paused)
+{
+    m_Paused = paused;
+}
+
+FrameClockStats FrameClock::GetStats() const
+{
+    FrameClockStats stats = m_Stats;
+    const size_t count = static_cast<size_t>(std::min<uint64_t>(m_Stats.frames, StatsWindow));
+    if (count == 0)
+    {
+        return stats;
+    }
+
+    std::array<float, StatsWindow> frameMs = m_FrameMs;
+    double total = 0.0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        total += frameMs[i];
+    }
+    const auto [min, max] = std::minmax_element(frameMs.begin(), frameMs.begin() + count);
+    stats.averageFrameMs = total / static_cast<double>(count);
+    stats.minFrameMs = *min;
+    stats.maxFrameMs = *max;
+
+    const size_t p99 = std::min(count - 1, count * 99 / 100);
+    std::nth_element(frameMs.begin(), frameMs.begin() + p99, frameMs.begin() + count);
+    stats.p99FrameMs = frameMs[p99];
+    return stats;
+}
@@ -0,0 +1,93 @@
+#include "MiniEngine/Core/FramePipeline.hpp"
+
+#include <chrono>
+#include <stdexcept>
+
+using namespace MiniEngine::Core;
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double MillisecondsSince(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+}
+
+FramePipeline::FramePipeline(uint32_t slotCount)
+    : m_SlotCount(slotCount)
+{
+    if (slotCount == 0)
+    {
+        throw std::invalid_argument("A frame pipeline needs at least one slot");
+    }
+}
+
+bool FramePipeline::BeginWrite(uint32_t& slot)
+{
+    const auto start = Clock::now();
+    std::unique_lock lock(m_Mutex);
+
+    // Slots published but not yet released, including the one being read, are off limits
+    m_Released.wait(lock, [this] { return m_Closed || m_WriteCount - m_ReadCount < m_SlotCount; });
+    m_Stats.producerWaitMs += MillisecondsSince(start);
+    if (m_Closed)
+    {
+        return false;
+    }
+
+    slot = static_cast<uint32_t>(m_WriteCount % m_SlotCount);
+    return true;
+}
+
+void FramePipeline::EndWrite()
+{
+    {
+        std::lock_guard lock(m_Mutex);
+        ++m_WriteCount;
+    }
+    m_Written.notify_one();
+}
+
+bool FramePipeline::BeginRead(uint32_t& slot)
+{
+    const auto start = Clock::now();
+    std::unique_lock lock(m_Mutex);
+
+    m_Written.wait(lock, [this] { return m_Closed || m_ReadCount < m_WriteCount; });
+    m_Stats.consumerWaitMs += MillisecondsSince(start);
+    if (m_ReadCount == m_WriteCount)
+    {
+        return false;
+    }
+
+    slot = static_cast<uint32_t>(m_ReadCount % m_SlotCount);
+    return true;
+}
+
+void FramePipeline::EndRead()
+{
+    {
+        std::lock_guard lock(m_Mutex);
+        ++m_ReadCount;
+        ++m_Stats.packets;
+    }
+    m_Released.notify_one();
+}
+
+void FramePipeline::Close()
+{
+    {
+        std::lock_guard lock(m_Mutex);
+        m_Closed = true;
+    }
+    m_Written.notify_all();
+    m_Released.notify_all();
+}
+
+FramePipelineStats FramePipeline::GetStats() const
+{
+    std::lock_guard lock(m_Mutex);
+    return m_Stats;
+}
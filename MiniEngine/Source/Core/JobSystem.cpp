@@ -0,0 +1,158 @@
+#include "MiniEngine/Core/JobSystem.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+using namespace MiniEngine::Core;
+
+namespace
+{
+    // Shared between the caller and the helper jobs of one ParallelFor call. Helpers that are
+    // dequeued after all batches were consumed only touch this state, never the caller's stack.
+    struct ParallelForState
+    {
+        std::atomic<size_t> nextBatch = 0;
+        std::atomic<size_t> completedBatches = 0;
+        size_t batchCount = 0;
+        size_t batchSize = 0;
+        size_t count = 0;
+        const std::function<void(size_t, size_t)>* function = nullptr;
+        std::mutex mutex;
+        std::condition_variable finished;
+    };
+
+    void RunBatches(ParallelForState& state)
+    {
+        for (;;)
+        {
+            const size_t batch = state.nextBatch.fetch_add(1, std::memory_order_relaxed);
+            if (batch >= state.batchCount)
+            {
+                return;
+            }
+
+            const size_t begin = batch * state.batchSize;
+            const size_t end = std::min(begin + state.batchSize, state.count);
+            (*state.function)(begin, end);
+
+            if (state.completedBatches.fetch_add(1, std::memory_order_acq_rel) + 1 == state.batchCount)
+            {
+                std::lock_guard lock(state.mutex);
+                state.finished.notify_all();
+            }
+        }
+    }
+}
+
+JobSystem::JobSystem(uint32_t threadCount)
+{
+    if (threadCount == 0)
+    {
+        const uint32_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+        threadCount = hardwareThreads - 1;
+    }
+
+    m_Workers.reserve(threadCount);
+    for (uint32_t i = 0; i < threadCount; ++i)
+    {
+        m_Workers.emplace_back([this] { WorkerLoop(); });
+    }
+
+    spdlog::debug("Job system started with {} worker threads", threadCount);
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard lock(m_Mutex);
+        m_Stopping = true;
+    }
+    m_Condition.notify_all();
+
+    for (std::thread& worker : m_Workers)
+    {
+        worker.join();
+    }
+
+    spdlog::debug("Job system stopped");
+}
+
+void JobSystem::ParallelFor(size_t count, size_t minBatchSize, const std::function<void(size_t begin, size_t end)>& function)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    // Aim for a few batches per thread so uneven batches balance out, but never go below minBatchSize
+    const size_t targetBatches = static_cast<size_t>(GetConcurrency()) * 4;
+    const size_t batchSize = std::max(std::max<size_t>(minBatchSize, 1), (count + targetBatches - 1) / targetBatches);
+    const size_t batchCount = (count + batchSize - 1) / batchSize;
+
+    if (batchCount == 1 || m_Workers.empty())
+    {
+        function(0, count);
+        return;
+    }
+
+    auto state = std::make_shared<ParallelForState>();
+    state->batchCount = batchCount;
+    state->batchSize = batchSize;
+    state->count = count;
+    state->function = &function;
+
+    const size_t helperCount = std::min<size_t>(m_Workers.size(), batchCount - 1);
+    for (size_t i = 0; i < helperCount; ++i)
+    {
+        Enqueue([state] { RunBatches(*state); });
+    }
+
+    RunBatches(*state);
+
+    std::unique_lock lock(state->mutex);
+    state->finished.wait(lock, [&] { return state->completedBatches.load(std::memory_order_acquire) == batchCount; });
+}
+
+void JobSystem::Submit(std::function<void()> job)
+{
+    if (m_Workers.empty())
+    {
+        job();
+        return;
+    }
+    Enqueue(std::move(job));
+}
+
+void JobSystem::WorkerLoop()
+{
+    for (;;)
+    {
+        std::function<void()> job;
+        {
+            std::unique_lock lock(m_Mutex);
+            m_Condition.wait(lock, [this] { return m_Stopping || !m_Jobs.empty(); });
+
+            if (m_Stopping && m_Jobs.empty())
+            {
+                return;
+            }
+
+            job = std::move(m_Jobs.front());
+            m_Jobs.pop_front();
+        }
+
+        job();
+    }
+}
+
+void JobSystem::Enqueue(std::function<void()> job)
+{
+    {
+        std::lock_guard lock(m_Mutex);
+        m_Jobs.push_back(std::move(job));
+    }
+    m_Condition.notify_one();
+}
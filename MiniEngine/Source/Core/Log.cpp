@@ -0,0 +1,273 @@
+#include "MiniEngine/Core/Log.hpp"
+
+#include <spdlog/sinks/stdout_color_sinks.h>
+
+#include <algorithm>
+#include <cstring>
+#include <exception>
+
+using namespace MiniEngine::Core;
+
+namespace
+{
+    std::shared_ptr<AsyncLogSink> g_AsyncLogSink;
+
+    int64_t NowNs()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    size_t RoundUpToPowerOfTwo(size_t value)
+    {
+        size_t result = 1;
+        while (result < value)
+        {
+            result <<= 1;
+        }
+        return result;
+    }
+}
+
+LogRateLimiter::LogRateLimiter(uint32_t intervalMs)
+    : m_IntervalNs(static_cast<int64_t>(intervalMs) * 1'000'000)
+{
+}
+
+bool LogRateLimiter::ShouldLog(uint32_t& suppressed)
+{
+    const int64_t now = NowNs();
+    int64_t next = m_NextNs.load(std::memory_order_relaxed);
+    if (now < next || !m_NextNs.compare_exchange_strong(next, now + m_IntervalNs, std::memory_order_relaxed))
+    {
+        m_Suppressed.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    suppressed = m_Suppressed.exchange(0, std::memory_order_relaxed);
+    return true;
+}
+
+AsyncLogSink::AsyncLogSink(std::vector<spdlog::sink_ptr> sinks, size_t capacity)
+    : m_Sinks(std::move(sinks))
+{
+    const size_t slotCount = RoundUpToPowerOfTwo(std::max<size_t>(capacity, 2));
+    m_Slots = std::make_unique<Slot[]>(slotCount);
+    m_Mask = slotCount - 1;
+
+    // A slot is free for the producer at position p when its sequence is p, and holds a message
+    // for the consumer when it is p + 1
+    for (size_t i = 0; i < slotCount; ++i)
+    {
+        m_Slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    m_Worker = std::thread([this] { WorkerLoop(); });
+}
+
+AsyncLogSink::~AsyncLogSink()
+{
+    m_Stopping.store(true, std::memory_order_release);
+    m_Signal.fetch_add(1);
+    m_Signal.notify_all();
+    m_Worker.join();
+}
+
+void AsyncLogSink::log(const spdlog::details::log_msg& message)
+{
+    size_t position = m_Tail.load(std::memory_order_relaxed);
+    Slot* slot = nullptr;
+    for (;;)
+    {
+        slot = &m_Slots[position & m_Mask];
+        const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        const ptrdiff_t difference = static_cast<ptrdiff_t>(sequence) - static_cast<ptrdiff_t>(position);
+
+        if (difference == 0)
+        {
+            if (m_Tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (difference < 0)
+        {
+            // Still holding a message from a full lap ago: the queue is full
+            m_Dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        else
+        {
+            position = m_Tail.load(std::memory_order_relaxed);
+        }
+    }
+
+    const size_t nameLength = std::min(message.logger_name.size(), MaxLoggerNameLength);
+    const size_t messageLength = std::min(message.payload.size(), MaxMessageLength);
+    if (messageLength < message.payload.size())
+    {
+        m_Truncated.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    slot->time = message.time;
+    slot->threadId = message.thread_id;
+    slot->level = message.level;
+    slot->loggerNameLength = static_cast<uint16_t>(nameLength);
+    slot->messageLength = static_cast<uint16_t>(messageLength);
+    std::memcpy(slot->loggerName, message.logger_name.data(), nameLength);
+    std::memcpy(slot->message, message.payload.data(), messageLength);
+    slot->sequence.store(position + 1, std::memory_order_release);
+
+    // Sequentially consistent against the worker announcing it is about to sleep: either it sees
+    // the new signal value, or this sees it waiting and wakes it
+    m_Signal.fetch_add(1);
+    if (m_WorkerWaiting.load())
+    {
+        m_Signal.notify_one();
+    }
+}
+
+void AsyncLogSink::flush()
+{
+    const size_t target = m_Tail.load(std::memory_order_acquire);
+    while (m_Head.load(std::memory_order_acquire) < target)
+    {
+        std::this_thread::yield();
+    }
+
+    for (const spdlog::sink_ptr& sink : m_Sinks)
+    {
+        sink->flush();
+    }
+}
+
+void AsyncLogSink::set_pattern(const std::string& pattern)
+{
+    for (const spdlog::sink_ptr& sink : m_Sinks)
+    {
+        sink->set_pattern(pattern);
+    }
+}
+
+void AsyncLogSink::set_formatter(std::unique_ptr<spdlog::formatter> formatter)
+{
+    for (const spdlog::sink_ptr& sink : m_Sinks)
+    {
+        sink->set_formatter(formatter->clone());
+    }
+}
+
+AsyncLogStats AsyncLogSink::GetStats() const
+{
+    AsyncLogStats stats;
+    stats.written = m_Written.load(std::memory_order_relaxed);
+    stats.dropped = m_Dropped.load(std::memory_order_relaxed);
+    stats.truncated = m_Truncated.load(std::memory_order_relaxed);
+    stats.queued = m_Tail.load(std::memory_order_relaxed) - m_Head.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void AsyncLogSink::WorkerLoop()
+{
+    for (;;)
+    {
+        // Read the signal before looking at the queue, so a push in between cannot be slept through
+        const uint32_t signal = m_Signal.load(std::memory_order_acquire);
+        while (WriteNext())
+        {
+        }
+
+        if (m_Stopping.load(std::memory_order_acquire))
+        {
+            while (WriteNext())
+            {
+            }
+            return;
+        }
+
+        m_WorkerWaiting.store(true);
+        if (m_Signal.load() == signal)
+        {
+            m_Signal.wait(signal);
+        }
+        m_WorkerWaiting.store(false, std::memory_order_relaxed);
+    }
+}
+
+bool AsyncLogSink::WriteNext()
+{
+    const size_t position = m_Head.load(std::memory_order_relaxed);
+    Slot& slot = m_Slots[position & m_Mask];
+    if (slot.sequence.load(std::memory_order_acquire) != position + 1)
+    {
+        return false;
+    }
+
+    spdlog::details::log_msg message(slot.time, spdlog::source_loc{}, spdlog::string_view_t(slot.loggerName, slot.loggerNameLength),
+        slot.level, spdlog::string_view_t(slot.message, slot.messageLength));
+    message.thread_id = slot.threadId;
+
+    for (const spdlog::sink_ptr& sink : m_Sinks)
+    {
+        if (!sink->should_log(message.level))
+        {
+            continue;
+        }
+
+        // A failing sink loses the message but must not take the worker down with it
+        try
+        {
+            sink->log(message);
+        }
+        catch (const std::exception&)
+        {
+        }
+    }
+
+    // Hand the slot back to producers one lap ahead
+    slot.sequence.store(position + m_Mask + 1, std::memory_order_release);
+    m_Head.store(position + 1, std::memory_order_release);
+    m_Written.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void MiniEngine::Core::InitializeLogging(const LogSettings& settings)
+{
+    spdlog::sink_ptr console = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
+
+    std::shared_ptr<spdlog::logger> logger;
+    if (settings.async)
+    {
+        g_AsyncLogSink = std::make_shared<AsyncLogSink>(std::vector<spdlog::sink_ptr>{ console }, settings.queueCapacity);
+        logger = std::make_shared<spdlog::logger>("", g_AsyncLogSink);
+    }
+    else
+    {
+        logger = std::make_shared<spdlog::logger>("", console);
+    }
+
+    // Critical messages usually precede an exit, so they wait until they are written
+    logger->set_level(settings.level);
+    logger->flush_on(spdlog::level::critical);
+    spdlog::set_default_logger(logger);
+}
+
+void MiniEngine::Core::ShutdownLogging()
+{
+    if (!g_AsyncLogSink)
+    {
+        return;
+    }
+
+    // Anything logged from here on, from destructors for instance, is written synchronously
+    const spdlog::level::level_enum level = spdlog::default_logger()->level();
+    g_AsyncLogSink->flush();
+    auto logger = std::make_shared<spdlog::logger>("", std::make_shared<spdlog::sinks::stdout_color_sink_mt>());
+    logger->set_level(level);
+    spdlog::set_default_logger(logger);
+    g_AsyncLogSink.reset();
+}
+
+std::shared_ptr<AsyncLogSink> MiniEngine::Core::GetAsyncLogSink()
+{
+    return g_AsyncLogSink;
+}
@@ -0,0 +1,274 @@
+#include "MiniEngine/Core/TaskGraph.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+using namespace MiniEngine::Core;
+
+namespace
+{
+    double Milliseconds(TaskGraph::Clock::duration duration)
+    {
+        return std::chrono::duration<double, std::milli>(duration).count();
+    }
+
+    std::string EscapeJson(const std::string& text)
+    {
+        std::string escaped;
+        escaped.reserve(text.size());
+        for (char c : text)
+        {
+            if (c == '"' || c == '\\')
+            {
+                escaped.push_back('\\');
+            }
+            escaped.push_back(static_cast<unsigned char>(c) < 0x20 ? ' ' : c);
+        }
+        return escaped;
+    }
+}
+
+// Shared with the helper jobs of one run. A helper dequeued after every task was taken only looks
+// at the empty queue, so it never touches a graph that has already returned from Run.
+struct TaskGraph::RunState
+{
+    TaskGraph* graph = nullptr;
+    JobSystem* jobs = nullptr; // Null when tasks only run on the caller
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<TaskId> readyMain;
+    std::deque<TaskId> readyAny;
+    size_t remaining = 0;
+    std::vector<std::thread::id> threads; // Indexed by TaskTiming::thread
+};
+
+TaskGraph::TaskGraph(Clock::time_point origin)
+    : m_Origin(origin)
+{
+}
+
+TaskGraph::TaskId TaskGraph::Add(std::string name, std::function<bool()> function, std::initializer_list<TaskId> dependencies, TaskThread thread)
+{
+    const TaskId id = static_cast<TaskId>(m_Tasks.size());
+    if (!function)
+    {
+        throw std::invalid_argument("A task needs a function");
+    }
+
+    Task task;
+    task.function = std::move(function);
+    task.thread = thread;
+    task.timing = m_Timeline.size();
+    for (TaskId dependency : dependencies)
+    {
+        if (dependency >= id)
+        {
+            throw std::invalid_argument("A task can only depend on tasks added before it");
+        }
+
+        Task& other = m_Tasks[dependency];
+        if (other.finished)
+        {
+            task.failed = task.failed || other.failed;
+            continue;
+        }
+        other.dependents.push_back(id);
+        ++task.dependencyCount;
+    }
+
+    m_Tasks.push_back(std::move(task));
+    m_Timeline.push_back({ std::move(name) });
+    return id;
+}
+
+bool TaskGraph::Run(JobSystem* jobs)
+{
+    const TaskId end = static_cast<TaskId>(m_Tasks.size());
+    if (m_FirstPending == end)
+    {
+        return true;
+    }
+
+    auto state = std::make_shared<RunState>();
+    state->graph = this;
+    state->jobs = jobs != nullptr && jobs->GetWorkerCount() > 0 ? jobs : nullptr;
+    state->remaining = end - m_FirstPending;
+    state->threads.push_back(std::this_thread::get_id());
+
+    uint32_t readyAny = 0;
+    for (TaskId id = m_FirstPending; id < end; ++id)
+    {
+        const Task& task = m_Tasks[id];
+        if (task.dependencyCount == 0)
+        {
+            (task.thread == TaskThread::Main ? state->readyMain : state->readyAny).push_back(id);
+            readyAny += task.thread == TaskThread::Any ? 1 : 0;
+        }
+    }
+    SubmitHelpers(state, readyAny);
+
+    // The caller runs main thread tasks as they become ready and helps with the rest in between
+    for (;;)
+    {
+        TaskId id = 0;
+        {
+            std::unique_lock lock(state->mutex);
+            state->changed.wait(lock, [&] { return state->remaining == 0 || !state->readyMain.empty() || !state->readyAny.empty(); });
+            if (state->remaining == 0)
+            {
+                break;
+            }
+
+            std::deque<TaskId>& ready = state->readyMain.empty() ? state->readyAny : state->readyMain;
+            id = ready.front();
+            ready.pop_front();
+        }
+        SubmitHelpers(state, Execute(*state, id));
+    }
+
+    bool succeeded = true;
+    for (TaskId id = m_FirstPending; id < end; ++id)
+    {
+        succeeded = succeeded && !m_Tasks[id].failed;
+    }
+    m_FirstPending = end;
+    return succeeded;
+}
+
+void TaskGraph::Record(std::string name, Clock::time_point start, Clock::time_point end, bool succeeded)
+{
+    TaskTiming timing;
+    timing.name = std::move(name);
+    timing.startMs = Milliseconds(start - m_Origin);
+    timing.durationMs = Milliseconds(end - start);
+    timing.succeeded = succeeded;
+    m_Timeline.push_back(std::move(timing));
+}
+
+double TaskGraph::GetElapsedMs() const
+{
+    return Milliseconds(Clock::now() - m_Origin);
+}
+
+bool TaskGraph::WriteChromeTrace(const std::filesystem::path& path) const
+{
+    std::FILE* file = std::fopen(path.string().c_str(), "wb");
+    if (!file)
+    {
+        spdlog::error("Failed to create trace {}", path.string());
+        return false;
+    }
+
+    std::fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", file);
+    bool first = true;
+    for (const TaskTiming& timing : m_Timeline)
+    {
+        if (timing.skipped)
+        {
+            continue;
+        }
+        std::fprintf(file, "%s\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+            first ? "" : ",", EscapeJson(timing.name).c_str(), timing.succeeded ? "task" : "failed", timing.thread,
+            timing.startMs * 1000.0, timing.durationMs * 1000.0);
+        first = false;
+    }
+    std::fputs("\n]}\n", file);
+
+    if (std::fclose(file) != 0)
+    {
+        spdlog::error("Failed to write trace {}", path.string());
+        return false;
+    }
+    return true;
+}
+
+void TaskGraph::Help(const std::shared_ptr<RunState>& state)
+{
+    TaskId id = 0;
+    {
+        std::lock_guard lock(state->mutex);
+        if (state->readyAny.empty())
+        {
+            return; // Someone else took it
+        }
+        id = state->readyAny.front();
+        state->readyAny.pop_front();
+    }
+    SubmitHelpers(state, state->graph->Execute(*state, id));
+}
+
+void TaskGraph::SubmitHelpers(const std::shared_ptr<RunState>& state, uint32_t count)
+{
+    if (state->jobs == nullptr)
+    {
+        return;
+    }
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        state->jobs->Submit([state] { Help(state); });
+    }
+}
+
+uint32_t TaskGraph::Execute(RunState& state, TaskId id)
+{
+    // Ready tasks are only taken under the lock, after their dependencies finished under it, so
+    // everything those dependencies wrote is visible here
+    Task& task = m_Tasks[id];
+    const bool skipped = task.failed;
+    const Clock::time_point start = Clock::now();
+    bool succeeded = false;
+    if (!skipped)
+    {
+        try
+        {
+            succeeded = task.function();
+        }
+        catch (const std::exception& exception)
+        {
+            spdlog::error("Task {} failed: {}", m_Timeline[task.timing].name, exception.what());
+        }
+    }
+    const Clock::time_point end = Clock::now();
+
+    uint32_t readyAny = 0;
+    {
+        std::lock_guard lock(state.mutex);
+        const std::thread::id threadId = std::this_thread::get_id();
+        auto thread = std::find(state.threads.begin(), state.threads.end(), threadId);
+        if (thread == state.threads.end())
+        {
+            thread = state.threads.insert(state.threads.end(), threadId);
+        }
+
+        TaskTiming& timing = m_Timeline[task.timing];
+        timing.startMs = Milliseconds(start - m_Origin);
+        timing.durationMs = Milliseconds(end - start);
+        timing.thread = static_cast<uint32_t>(thread - state.threads.begin());
+        timing.succeeded = succeeded;
+        timing.skipped = skipped;
+
+        task.finished = true;
+        task.failed = !succeeded;
+        for (TaskId dependentId : task.dependents)
+        {
+            Task& dependent = m_Tasks[dependentId];
+            dependent.failed = dependent.failed || !succeeded;
+            if (--dependent.dependencyCount == 0)
+            {
+                (dependent.thread == TaskThread::Main ? state.readyMain : state.readyAny).push_back(dependentId);
+                readyAny += dependent.thread == TaskThread::Any ? 1 : 0;
+            }
+        }
+        --state.remaining;
+    }
+    state.changed.notify_all();
+    return readyAny;
+}
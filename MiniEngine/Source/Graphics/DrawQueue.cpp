@@ -0,0 +1,117 @@
+#include "MiniEngine/Graphics/DrawQueue.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+
+using namespace MiniEngine::Graphics;
+
+namespace
+{
+    constexpr uint32_t DigitBits   = 11;
+    constexpr uint32_t DigitCount  = (64 + DigitBits - 1) / DigitBits;
+    constexpr uint32_t BucketCount = 1u << DigitBits;
+}
+
+uint32_t DrawKey::MakeDepthBucket(float viewDepth, float nearPlane, float farPlane)
+{
+    const float normalized = std::clamp((viewDepth - nearPlane) / (farPlane - nearPlane), 0.0f, 1.0f);
+    return static_cast<uint32_t>(normalized * static_cast<float>(MaxDepth));
+}
+
+BindCounts MiniEngine::Graphics::CountBinds(const QueuedDraw* draws, size_t count)
+{
+    BindCounts binds;
+    uint32_t pipeline = 0;
+    uint32_t material = 0;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const uint32_t drawPipeline = DrawKey::GetPipeline(draws[i].key);
+        const uint32_t drawMaterial = DrawKey::GetMaterial(draws[i].key);
+
+        if (i == 0 || drawPipeline != pipeline)
+        {
+            ++binds.pipelineBinds;
+            ++binds.descriptorBinds;
+        }
+        else if (drawMaterial != material)
+        {
+            ++binds.descriptorBinds;
+        }
+
+        pipeline = drawPipeline;
+        material = drawMaterial;
+    }
+
+    return binds;
+}
+
+void DrawQueue::Reserve(size_t count)
+{
+    m_Draws.reserve(count);
+    m_Scratch.reserve(count);
+}
+
+void DrawQueue::Clear()
+{
+    m_Draws.clear();
+}
+
+void DrawQueue::Sort()
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    const size_t count = m_Draws.size();
+    m_Scratch.resize(count);
+    m_Stats.drawCount = static_cast<uint32_t>(count);
+    m_Stats.radixPasses = 0;
+
+    // Histograms for every digit in a single read of the keys
+    std::array<std::array<uint32_t, BucketCount>, DigitCount> histograms{};
+    for (const QueuedDraw& draw : m_Draws)
+    {
+        for (uint32_t digit = 0; digit < DigitCount; ++digit)
+        {
+            ++histograms[digit][(draw.key >> (digit * DigitBits)) & (BucketCount - 1)];
+        }
+    }
+
+    QueuedDraw* source = m_Draws.data();
+    QueuedDraw* destination = m_Scratch.data();
+
+    for (uint32_t digit = 0; digit < DigitCount && count > 1; ++digit)
+    {
+        std::array<uint32_t, BucketCount>& histogram = histograms[digit];
+
+        // All keys share this digit, so scattering would not reorder anything
+        const uint32_t shift = digit * DigitBits;
+        if (histogram[(source[0].key >> shift) & (BucketCount - 1)] == count)
+        {
+            continue;
+        }
+
+        uint32_t offset = 0;
+        for (uint32_t& bucket : histogram)
+        {
+            const uint32_t bucketCount = bucket;
+            bucket = offset;
+            offset += bucketCount;
+        }
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            destination[histogram[(source[i].key >> shift) & (BucketCount - 1)]++] = source[i];
+        }
+
+        std::swap(source, destination);
+        ++m_Stats.radixPasses;
+    }
+
+    if (source != m_Draws.data())
+    {
+        m_Draws.swap(m_Scratch);
+    }
+
+    m_Stats.sortTimeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
@@ -0,0 +1,305 @@
+#include "MiniEngine/Graphics/FrameTrace.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cstring>
+
+using namespace MiniEngine::Graphics;
+
+namespace
+{
+    // File header: magic, stream count, reserved, frame count, then one record size per stream.
+    // Each frame then holds, per stream: its record count, a bit per record the previous frame
+    // also had (set where it changed), the changed records, and the records past the previous count.
+    constexpr char TraceMagic[8] = { 'M', 'E', 'T', 'R', 'A', 'C', 'E', '1' };
+    constexpr long FrameCountOffset = 16;
+    constexpr uint32_t MaxStreams = 64;
+
+    void AppendBytes(std::vector<uint8_t>& bytes, const void* data, size_t size)
+    {
+        const uint8_t* source = static_cast<const uint8_t*>(data);
+        bytes.insert(bytes.end(), source, source + size);
+    }
+}
+
+FrameTraceWriter::~FrameTraceWriter()
+{
+    Close();
+}
+
+bool FrameTraceWriter::Open(const std::filesystem::path& path, std::span<const uint32_t> recordSizes)
+{
+    Close();
+    if (recordSizes.empty() || recordSizes.size() > MaxStreams ||
+        std::any_of(recordSizes.begin(), recordSizes.end(), [](uint32_t size) { return size == 0; }))
+    {
+        spdlog::error("Frame trace {} needs 1 to {} streams with records of at least a byte", path.string(), MaxStreams);
+        return false;
+    }
+
+    m_File = std::fopen(path.string().c_str(), "wb");
+    if (!m_File)
+    {
+        spdlog::error("Failed to create frame trace {}", path.string());
+        return false;
+    }
+
+    m_Path = path;
+    m_RecordSizes.assign(recordSizes.begin(), recordSizes.end());
+    m_Previous.assign(m_RecordSizes.size(), {});
+    m_Stats = {};
+
+    m_Encoded.clear();
+    AppendBytes(m_Encoded, TraceMagic, sizeof(TraceMagic));
+    const uint32_t streamCount = static_cast<uint32_t>(m_RecordSizes.size());
+    const uint32_t reserved = 0;
+    const uint64_t frameCount = 0;
+    AppendBytes(m_Encoded, &streamCount, sizeof(streamCount));
+    AppendBytes(m_Encoded, &reserved, sizeof(reserved));
+    AppendBytes(m_Encoded, &frameCount, sizeof(frameCount));
+    AppendBytes(m_Encoded, m_RecordSizes.data(), m_RecordSizes.size() * sizeof(uint32_t));
+    if (std::fwrite(m_Encoded.data(), 1, m_Encoded.size(), m_File) != m_Encoded.size())
+    {
+        spdlog::error("Failed to write frame trace {}", m_Path.string());
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void FrameTraceWriter::Close()
+{
+    if (!m_File)
+    {
+        return;
+    }
+
+    if (std::fseek(m_File, FrameCountOffset, SEEK_SET) != 0 ||
+        std::fwrite(&m_Stats.frames, sizeof(m_Stats.frames), 1, m_File) != 1)
+    {
+        spdlog::error("Failed to finish frame trace {}", m_Path.string());
+    }
+    std::fclose(m_File);
+    m_File = nullptr;
+}
+
+bool FrameTraceWriter::WriteFrame(std::span<const std::span<const uint8_t>> streams)
+{
+    if (!m_File)
+    {
+        return false;
+    }
+    if (streams.size() != m_RecordSizes.size())
+    {
+        spdlog::error("Frame trace {} has {} streams, a frame gave {}", m_Path.string(), m_RecordSizes.size(), streams.size());
+        return false;
+    }
+
+    m_Encoded.clear();
+    for (size_t i = 0; i < streams.size(); ++i)
+    {
+        const std::span<const uint8_t> stream = streams[i];
+        const size_t recordSize = m_RecordSizes[i];
+        if (stream.size() % recordSize != 0)
+        {
+            spdlog::error("Frame trace {}: stream {} is not a whole number of {} byte records", m_Path.string(), i, recordSize);
+            return false;
+        }
+
+        std::vector<uint8_t>& previous = m_Previous[i];
+        const uint32_t recordCount = static_cast<uint32_t>(stream.size() / recordSize);
+        const uint32_t comparedCount = static_cast<uint32_t>(std::min(stream.size(), previous.size()) / recordSize);
+        AppendBytes(m_Encoded, &recordCount, sizeof(recordCount));
+
+        const size_t maskOffset = m_Encoded.size();
+        m_Encoded.resize(maskOffset + (comparedCount + 7) / 8, 0);
+        for (uint32_t record = 0; record < comparedCount; ++record)
+        {
+            const uint8_t* current = stream.data() + record * recordSize;
+            if (std::memcmp(current, previous.data() + record * recordSize, recordSize) != 0)
+            {
+                m_Encoded[maskOffset + record / 8] |= static_cast<uint8_t>(1u << (record % 8));
+                AppendBytes(m_Encoded, current, recordSize);
+            }
+        }
+        AppendBytes(m_Encoded, stream.data() + comparedCount * recordSize, stream.size() - comparedCount * recordSize);
+
+        previous.assign(stream.begin(), stream.end());
+        m_Stats.rawBytes += stream.size();
+    }
+
+    if (std::fwrite(m_Encoded.data(), 1, m_Encoded.size(), m_File) != m_Encoded.size())
+    {
+        spdlog::error("Failed to write frame {} of frame trace {}", m_Stats.frames, m_Path.string());
+        return false;
+    }
+    m_Stats.encodedBytes += m_Encoded.size();
+    ++m_Stats.frames;
+    return true;
+}
+
+FrameTraceReader::~FrameTraceReader()
+{
+    Close();
+}
+
+bool FrameTraceReader::Open(const std::filesystem::path& path, std::span<const uint32_t> recordSizes)
+{
+    Close();
+    m_Path = path;
+    m_File = std::fopen(path.string().c_str(), "rb");
+    if (!m_File)
+    {
+        spdlog::error("Failed to open frame trace {}", path.string());
+        return false;
+    }
+
+    char magic[sizeof(TraceMagic)];
+    uint32_t streamCount = 0;
+    uint32_t reserved = 0;
+    if (std::fread(magic, sizeof(magic), 1, m_File) != 1 || std::memcmp(magic, TraceMagic, sizeof(magic)) != 0 ||
+        std::fread(&streamCount, sizeof(streamCount), 1, m_File) != 1 || std::fread(&reserved, sizeof(reserved), 1, m_File) != 1 ||
+        std::fread(&m_FrameCount, sizeof(m_FrameCount), 1, m_File) != 1 || streamCount == 0 || streamCount > MaxStreams)
+    {
+        return Fail("not a frame trace");
+    }
+
+    m_RecordSizes.resize(streamCount);
+    if (std::fread(m_RecordSizes.data(), sizeof(uint32_t), streamCount, m_File) != streamCount)
+    {
+        return Fail("truncated header");
+    }
+    if (!std::equal(m_RecordSizes.begin(), m_RecordSizes.end(), recordSizes.begin(), recordSizes.end()))
+    {
+        return Fail("recorded with different record layouts");
+    }
+
+    // Record counts are checked against what is left of the file before anything is allocated for them
+    m_FirstFrameOffset = std::ftell(m_File);
+    if (std::fseek(m_File, 0, SEEK_END) != 0)
+    {
+        return Fail("cannot seek");
+    }
+    m_FileSize = static_cast<uint64_t>(std::ftell(m_File));
+    if (std::fseek(m_File, m_FirstFrameOffset, SEEK_SET) != 0)
+    {
+        return Fail("cannot seek");
+    }
+
+    if (m_FrameCount == 0 && m_FileSize > static_cast<uint64_t>(m_FirstFrameOffset))
+    {
+        spdlog::warn("Frame trace {} was not closed, reading its frames up to the end of the file", path.string());
+    }
+    m_NextFrame = 0;
+    m_Streams.assign(streamCount, {});
+    return true;
+}
+
+void FrameTraceReader::Close()
+{
+    if (m_File)
+    {
+        std::fclose(m_File);
+        m_File = nullptr;
+    }
+    m_FrameCount = 0;
+    m_NextFrame = 0;
+    m_Streams.clear();
+}
+
+bool FrameTraceReader::ReadFrame()
+{
+    if (!m_File)
+    {
+        return false;
+    }
+
+    const uint64_t frameStart = static_cast<uint64_t>(std::ftell(m_File));
+    const bool unfinished = m_FrameCount == 0;
+    if (unfinished ? frameStart >= m_FileSize : m_NextFrame == m_FrameCount)
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < m_RecordSizes.size(); ++i)
+    {
+        const size_t recordSize = m_RecordSizes[i];
+        std::vector<uint8_t>& stream = m_Streams[i];
+
+        uint32_t recordCount = 0;
+        if (std::fread(&recordCount, sizeof(recordCount), 1, m_File) != 1)
+        {
+            return Truncated(unfinished);
+        }
+
+        // Records the previous frame had stay unless their bit is set
+        const uint32_t comparedCount = static_cast<uint32_t>(std::min<size_t>(recordCount, stream.size() / recordSize));
+        m_Mask.resize((comparedCount + 7) / 8);
+        if (std::fread(m_Mask.data(), 1, m_Mask.size(), m_File) != m_Mask.size())
+        {
+            return Truncated(unfinished);
+        }
+
+        // The records past the previous frame's count are all stored, so they have to fit in the file
+        const uint64_t remaining = m_FileSize - static_cast<uint64_t>(std::ftell(m_File));
+        if (static_cast<uint64_t>(recordCount - comparedCount) * recordSize > remaining)
+        {
+            return unfinished ? Truncated(true) : Fail("record count runs past the end of the file");
+        }
+
+        stream.resize(static_cast<size_t>(recordCount) * recordSize);
+        for (uint32_t record = 0; record < comparedCount; ++record)
+        {
+            if ((m_Mask[record / 8] & (1u << (record % 8))) != 0 &&
+                std::fread(stream.data() + record * recordSize, recordSize, 1, m_File) != 1)
+            {
+                return Truncated(unfinished);
+            }
+        }
+
+        const size_t appendedBytes = stream.size() - comparedCount * recordSize;
+        if (appendedBytes > 0 && std::fread(stream.data() + comparedCount * recordSize, 1, appendedBytes, m_File) != appendedBytes)
+        {
+            return Truncated(unfinished);
+        }
+    }
+
+    ++m_NextFrame;
+    return true;
+}
+
+bool FrameTraceReader::Rewind()
+{
+    if (!m_File || std::fseek(m_File, m_FirstFrameOffset, SEEK_SET) != 0)
+    {
+        return false;
+    }
+
+    m_NextFrame = 0;
+    for (std::vector<uint8_t>& stream : m_Streams)
+    {
+        stream.clear();
+    }
+    return true;
+}
+
+bool FrameTraceReader::Truncated(bool unfinished)
+{
+    if (!unfinished)
+    {
+        return Fail("truncated frame");
+    }
+
+    // The writer stopped partway through this frame; the frames before it make up the trace
+    spdlog::warn("Frame trace {} ends partway through frame {}", m_Path.string(), m_NextFrame);
+    m_FrameCount = m_NextFrame;
+    return false;
+}
+
+bool FrameTraceReader::Fail(const char* reason)
+{
+    spdlog::error("Failed to read frame trace {}: {}", m_Path.string(), reason);
+    Close();
+    return false;
+}
@@ -0,0 +1,293 @@
+#include "MiniEngine/Graphics/ImageSequenceWriter.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+using namespace MiniEngine::Graphics;
+
+namespace
+{
+    constexpr size_t MaxStoredBlock = 65535;
+
+    std::array<uint32_t, 256> MakeCrcTable()
+    {
+        std::array<uint32_t, 256> table = {};
+        for (uint32_t i = 0; i < 256; ++i)
+        {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; ++bit)
+            {
+                crc = (crc & 1u) ? 0xEDB88320u ^ (crc >> 1) : crc >> 1;
+            }
+            table[i] = crc;
+        }
+        return table;
+    }
+
+    uint32_t Crc32(const uint8_t* data, size_t size)
+    {
+        static const std::array<uint32_t, 256> table = MakeCrcTable();
+        uint32_t crc = 0xFFFFFFFFu;
+        for (size_t i = 0; i < size; ++i)
+        {
+            crc = table[(crc ^ data[i]) & 0xFFu] ^ (crc >> 8);
+        }
+        return crc ^ 0xFFFFFFFFu;
+    }
+
+    uint32_t Adler32(const uint8_t* data, size_t size)
+    {
+        // 5552 bytes is the most that can be summed before the 32-bit sums need reducing
+        uint32_t a = 1;
+        uint32_t b = 0;
+        while (size > 0)
+        {
+            const size_t run = std::min<size_t>(size, 5552);
+            for (size_t i = 0; i < run; ++i)
+            {
+                a += data[i];
+                b += a;
+            }
+            a %= 65521u;
+            b %= 65521u;
+            data += run;
+            size -= run;
+        }
+        return (b << 16) | a;
+    }
+
+    void AppendBigEndian(std::vector<uint8_t>& bytes, uint32_t value)
+    {
+        bytes.push_back(static_cast<uint8_t>(value >> 24));
+        bytes.push_back(static_cast<uint8_t>(value >> 16));
+        bytes.push_back(static_cast<uint8_t>(value >> 8));
+        bytes.push_back(static_cast<uint8_t>(value));
+    }
+
+    // Length, type, data, then a CRC over the type and data
+    template <typename WriteData>
+    void AppendChunk(std::vector<uint8_t>& bytes, const char (&type)[5], uint32_t length, WriteData writeData)
+    {
+        AppendBigEndian(bytes, length);
+        const size_t typeOffset = bytes.size();
+        bytes.insert(bytes.end(), type, type + 4);
+        writeData();
+        AppendBigEndian(bytes, Crc32(bytes.data() + typeOffset, bytes.size() - typeOffset));
+    }
+
+    // Converts the image to RGB rows, each preceded by filterBytes zero bytes
+    void CopyRows(std::vector<uint8_t>& rows, const SequenceImage& image, size_t filterBytes)
+    {
+        const size_t rowSize = filterBytes + static_cast<size_t>(image.width) * 3;
+        rows.resize(rowSize * image.height);
+
+        const bool bgra = image.layout == PixelLayout::Bgra8;
+        for (uint32_t y = 0; y < image.height; ++y)
+        {
+            const uint8_t* source = image.pixels + static_cast<size_t>(y) * image.rowPitch;
+            uint8_t* destination = rows.data() + y * rowSize;
+            std::fill_n(destination, filterBytes, uint8_t(0));
+            destination += filterBytes;
+            for (uint32_t x = 0; x < image.width; ++x, source += 4, destination += 3)
+            {
+                destination[0] = source[bgra ? 2 : 0];
+                destination[1] = source[1];
+                destination[2] = source[bgra ? 0 : 2];
+            }
+        }
+    }
+}
+
+const char* MiniEngine::Graphics::ToString(ImageFileFormat format)
+{
+    switch (format)
+    {
+    case ImageFileFormat::Png: return "png";
+    case ImageFileFormat::Pam: return "pam";
+    default:                   return "unknown";
+    }
+}
+
+ImageSequenceWriter::~ImageSequenceWriter()
+{
+    Stop();
+}
+
+bool ImageSequenceWriter::Start(const std::filesystem::path& directory, ImageFileFormat format)
+{
+    Stop();
+
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    if (error)
+    {
+        spdlog::error("Failed to create image directory {}: {}", directory.string(), error.message());
+        return false;
+    }
+
+    m_Directory = directory;
+    m_Format = format;
+    m_Stopping = false;
+    m_Stats = {};
+    m_Thread = std::thread(&ImageSequenceWriter::WorkerLoop, this);
+    return true;
+}
+
+void ImageSequenceWriter::Stop()
+{
+    if (!m_Thread.joinable())
+    {
+        return;
+    }
+
+    {
+        std::lock_guard lock(m_Mutex);
+        m_Stopping = true;
+    }
+    m_Condition.notify_one();
+    m_Thread.join();
+}
+
+void ImageSequenceWriter::Write(const SequenceImage& image, std::function<void()> release)
+{
+    if (image.pixels == nullptr || image.width == 0 || image.height == 0 || image.rowPitch < image.width * 4)
+    {
+        throw std::invalid_argument("An image needs pixels and a row pitch of at least four bytes per pixel");
+    }
+    if (!m_Thread.joinable())
+    {
+        if (release)
+        {
+            release();
+        }
+        return;
+    }
+
+    {
+        std::lock_guard lock(m_Mutex);
+        m_Jobs.push_back({ image, std::move(release), m_Stats.queued++ });
+        m_Stats.maxQueueDepth = std::max(m_Stats.maxQueueDepth, m_Jobs.size());
+    }
+    m_Condition.notify_one();
+}
+
+ImageSequenceStats ImageSequenceWriter::GetStats() const
+{
+    std::lock_guard lock(m_Mutex);
+    return m_Stats;
+}
+
+void ImageSequenceWriter::WorkerLoop()
+{
+    while (true)
+    {
+        Job job;
+        {
+            std::unique_lock lock(m_Mutex);
+            m_Condition.wait(lock, [this] { return m_Stopping || !m_Jobs.empty(); });
+            if (m_Jobs.empty())
+            {
+                return; // Stopping with nothing left to write
+            }
+            job = std::move(m_Jobs.front());
+            m_Jobs.pop_front();
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        const bool written = WriteImage(job);
+        const double encodeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (job.release)
+        {
+            job.release();
+        }
+
+        std::lock_guard lock(m_Mutex);
+        if (written)
+        {
+            ++m_Stats.written;
+            m_Stats.bytes += m_Encoded.size();
+            m_Stats.encodeMs += encodeMs;
+        }
+        else
+        {
+            ++m_Stats.failed;
+        }
+    }
+}
+
+bool ImageSequenceWriter::WriteImage(const Job& job)
+{
+    const SequenceImage& image = job.image;
+    m_Encoded.clear();
+
+    if (m_Format == ImageFileFormat::Png)
+    {
+        // Every row uses filter 0, and the zlib stream is a run of stored deflate blocks
+        CopyRows(m_Rows, image, 1);
+        const size_t blockCount = std::max<size_t>((m_Rows.size() + MaxStoredBlock - 1) / MaxStoredBlock, 1);
+        const size_t zlibSize = 2 + blockCount * 5 + m_Rows.size() + 4;
+        m_Encoded.reserve(8 + 25 + zlibSize + 12 + 12);
+
+        const uint8_t signature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+        m_Encoded.insert(m_Encoded.end(), std::begin(signature), std::end(signature));
+        AppendChunk(m_Encoded, "IHDR", 13, [&]
+        {
+            AppendBigEndian(m_Encoded, image.width);
+            AppendBigEndian(m_Encoded, image.height);
+            const uint8_t format[] = { 8, 2, 0, 0, 0 }; // 8 bits per channel, RGB, deflate, filter set 0, no interlace
+            m_Encoded.insert(m_Encoded.end(), std::begin(format), std::end(format));
+        });
+        AppendChunk(m_Encoded, "IDAT", static_cast<uint32_t>(zlibSize), [&]
+        {
+            m_Encoded.push_back(0x78); // Deflate with a 32K window, no dictionary
+            m_Encoded.push_back(0x01);
+            for (size_t offset = 0, block = 0; block < blockCount; ++block, offset += MaxStoredBlock)
+            {
+                const uint16_t length = static_cast<uint16_t>(std::min(MaxStoredBlock, m_Rows.size() - offset));
+                const uint16_t inverse = static_cast<uint16_t>(~length);
+                m_Encoded.push_back(block + 1 == blockCount ? 1 : 0);
+                m_Encoded.push_back(static_cast<uint8_t>(length));
+                m_Encoded.push_back(static_cast<uint8_t>(length >> 8));
+                m_Encoded.push_back(static_cast<uint8_t>(inverse));
+                m_Encoded.push_back(static_cast<uint8_t>(inverse >> 8));
+                m_Encoded.insert(m_Encoded.end(), m_Rows.begin() + offset, m_Rows.begin() + offset + length);
+            }
+            AppendBigEndian(m_Encoded, Adler32(m_Rows.data(), m_Rows.size()));
+        });
+        AppendChunk(m_Encoded, "IEND", 0, [] {});
+    }
+    else
+    {
+        const std::string header = "P7\nWIDTH " + std::to_string(image.width) + "\nHEIGHT " + std::to_string(image.height) +
+            "\nDEPTH 3\nMAXVAL 255\nTUPLTYPE RGB\nENDHDR\n";
+        CopyRows(m_Rows, image, 0);
+        m_Encoded.reserve(header.size() + m_Rows.size());
+        m_Encoded.insert(m_Encoded.end(), header.begin(), header.end());
+        m_Encoded.insert(m_Encoded.end(), m_Rows.begin(), m_Rows.end());
+    }
+
+    char name[32];
+    std::snprintf(name, sizeof(name), "frame_%06llu.%s", static_cast<unsigned long long>(job.index), ToString(m_Format));
+    const std::filesystem::path path = m_Directory / name;
+
+    std::FILE* file = std::fopen(path.string().c_str(), "wb");
+    if (!file)
+    {
+        spdlog::error("Failed to create {}", path.string());
+        return false;
+    }
+    const bool written = std::fwrite(m_Encoded.data(), 1, m_Encoded.size(), file) == m_Encoded.size();
+    if (std::fclose(file) != 0 || !written)
+    {
+        spdlog::error("Failed to write {}", path.string());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,414 @@
+#include "MiniEngine/Graphics/MeshLod.hpp"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+using namespace MiniEngine::Graphics;
+
+namespace
+{
+    // Borders are held in place by planes through them, perpendicular to the surface, weighted well
+    // above the surface itself so the outline of an open mesh survives
+    constexpr double BorderWeight = 10.0;
+
+    // A collapse may turn a triangle by at most this much (the cosine of the angle), and never over
+    constexpr double MinNormalCosine = 0.25;
+
+    // Sum of squared distances to a set of planes, weighted by the area they came from
+    struct Quadric
+    {
+        double a00 = 0.0, a01 = 0.0, a02 = 0.0, a11 = 0.0, a12 = 0.0, a22 = 0.0;
+        double b0 = 0.0, b1 = 0.0, b2 = 0.0;
+        double c = 0.0;
+        double area = 0.0; // Of the surface planes only, to turn the sum into an average
+
+        // The plane through point with the given unit normal
+        void AddPlane(const glm::dvec3& normal, const glm::dvec3& point, double weight)
+        {
+            const double d = -glm::dot(normal, point);
+            a00 += weight * normal.x * normal.x;
+            a01 += weight * normal.x * normal.y;
+            a02 += weight * normal.x * normal.z;
+            a11 += weight * normal.y * normal.y;
+            a12 += weight * normal.y * normal.z;
+            a22 += weight * normal.z * normal.z;
+            b0 += weight * normal.x * d;
+            b1 += weight * normal.y * d;
+            b2 += weight * normal.z * d;
+            c += weight * d * d;
+        }
+
+        Quadric& operator+=(const Quadric& other)
+        {
+            a00 += other.a00; a01 += other.a01; a02 += other.a02;
+            a11 += other.a11; a12 += other.a12; a22 += other.a22;
+            b0 += other.b0; b1 += other.b1; b2 += other.b2;
+            c += other.c;
+            area += other.area;
+            return *this;
+        }
+
+        double Evaluate(const glm::dvec3& p) const
+        {
+            const double squared = a00 * p.x * p.x + a11 * p.y * p.y + a22 * p.z * p.z +
+                2.0 * (a01 * p.x * p.y + a02 * p.x * p.z + a12 * p.y * p.z);
+            return squared + 2.0 * (b0 * p.x + b1 * p.y + b2 * p.z) + c;
+        }
+    };
+
+    struct Collapse
+    {
+        uint32_t from = 0;
+        uint32_t to   = 0;
+        double   cost = 0.0; // Mean squared distance the surface moves
+    };
+
+    uint64_t EdgeKey(uint32_t a, uint32_t b)
+    {
+        return a < b ? (static_cast<uint64_t>(a) << 32) | b : (static_cast<uint64_t>(b) << 32) | a;
+    }
+
+    // Greedy half-edge collapses in passes: each pass ranks every edge by the error of collapsing it,
+    // then collapses the cheapest ones that do not touch a neighbourhood already changed in the pass
+    class Simplifier
+    {
+    public:
+        Simplifier(const std::vector<uint32_t>& indices, const float* positions, size_t vertexCount, size_t vertexStride)
+            : m_Indices(indices), m_Positions(vertexCount), m_Quadrics(vertexCount), m_Remap(vertexCount)
+        {
+            const uint8_t* bytes = reinterpret_cast<const uint8_t*>(positions);
+            for (size_t i = 0; i < vertexCount; ++i)
+            {
+                float position[3];
+                std::memcpy(position, bytes + i * vertexStride, sizeof(position));
+                m_Positions[i] = glm::dvec3(position[0], position[1], position[2]);
+            }
+
+            std::unordered_map<uint64_t, uint32_t> edgeUses = CountEdges();
+            for (size_t triangle = 0; triangle < m_Indices.size(); triangle += 3)
+            {
+                const uint32_t* corners = &m_Indices[triangle];
+                const glm::dvec3 p0 = m_Positions[corners[0]];
+                const glm::dvec3 cross = glm::cross(m_Positions[corners[1]] - p0, m_Positions[corners[2]] - p0);
+                const double length = glm::length(cross);
+                if (length <= 0.0)
+                {
+                    continue;
+                }
+
+                const glm::dvec3 normal = cross / length;
+                Quadric quadric;
+                quadric.AddPlane(normal, p0, length * 0.5);
+                quadric.area = length * 0.5;
+                for (uint32_t corner = 0; corner < 3; ++corner)
+                {
+                    m_Quadrics[corners[corner]] += quadric;
+                }
+
+                for (uint32_t edge = 0; edge < 3; ++edge)
+                {
+                    const uint32_t a = corners[edge];
+                    const uint32_t b = corners[(edge + 1) % 3];
+                    if (edgeUses[EdgeKey(a, b)] != 1)
+                    {
+                        continue;
+                    }
+                    const glm::dvec3 direction = m_Positions[b] - m_Positions[a];
+                    const double edgeLength = glm::length(direction);
+                    if (edgeLength <= 0.0)
+                    {
+                        continue;
+                    }
+                    Quadric border;
+                    border.AddPlane(glm::normalize(glm::cross(direction, normal)), m_Positions[a], BorderWeight * edgeLength * edgeLength);
+                    m_Quadrics[a] += border;
+                    m_Quadrics[b] += border;
+                }
+            }
+        }
+
+        // Collapses edges until at most targetTriangles remain or no edge can go
+        void SimplifyTo(size_t targetTriangles)
+        {
+            while (m_Indices.size() / 3 > targetTriangles && CollapsePass(targetTriangles))
+            {
+            }
+        }
+
+        const std::vector<uint32_t>& GetIndices() const
+        {
+            return m_Indices;
+        }
+
+        // Root mean squared distance of the costliest collapse so far
+        double GetError() const
+        {
+            return std::sqrt(m_MaxCost);
+        }
+
+    private:
+        std::unordered_map<uint64_t, uint32_t> CountEdges() const
+        {
+            std::unordered_map<uint64_t, uint32_t> uses;
+            uses.reserve(m_Indices.size());
+            for (size_t triangle = 0; triangle < m_Indices.size(); triangle += 3)
+            {
+                for (uint32_t edge = 0; edge < 3; ++edge)
+                {
+                    ++uses[EdgeKey(m_Indices[triangle + edge], m_Indices[triangle + (edge + 1) % 3])];
+                }
+            }
+            return uses;
+        }
+
+        double CollapseCost(uint32_t from, uint32_t to) const
+        {
+            Quadric merged = m_Quadrics[from];
+            merged += m_Quadrics[to];
+            return std::max(merged.Evaluate(m_Positions[to]), 0.0) / std::max(merged.area, 1e-12);
+        }
+
+        // Moving from onto to must not fold over or sharply turn any triangle that survives it
+        bool KeepsOrientation(uint32_t from, uint32_t to) const
+        {
+            for (uint32_t i = m_TriangleOffsets[from]; i < m_TriangleOffsets[from + 1]; ++i)
+            {
+                const uint32_t* corners = &m_Indices[m_VertexTriangles[i] * 3];
+                if (corners[0] == to || corners[1] == to || corners[2] == to)
+                {
+                    continue;
+                }
+
+                glm::dvec3 before[3];
+                glm::dvec3 after[3];
+                for (uint32_t corner = 0; corner < 3; ++corner)
+                {
+                    before[corner] = m_Positions[corners[corner]];
+                    after[corner] = corners[corner] == from ? m_Positions[to] : before[corner];
+                }
+                const glm::dvec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+                const glm::dvec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+                const double lengths = glm::length(normalBefore) * glm::length(normalAfter);
+                if (lengths <= 0.0 || glm::dot(normalBefore, normalAfter) < MinNormalCosine * lengths)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        void LockNeighbourhood(uint32_t vertex)
+        {
+            m_Locked[vertex] = true;
+            for (uint32_t i = m_TriangleOffsets[vertex]; i < m_TriangleOffsets[vertex + 1]; ++i)
+            {
+                const uint32_t* corners = &m_Indices[m_VertexTriangles[i] * 3];
+                m_Locked[corners[0]] = m_Locked[corners[1]] = m_Locked[corners[2]] = true;
+            }
+        }
+
+        bool CollapsePass(size_t targetTriangles)
+        {
+            const size_t vertexCount = m_Positions.size();
+            const size_t triangleCount = m_Indices.size() / 3;
+
+            // Triangles around each vertex
+            m_TriangleOffsets.assign(vertexCount + 1, 0);
+            for (uint32_t index : m_Indices)
+            {
+                ++m_TriangleOffsets[index + 1];
+            }
+            for (size_t i = 0; i < vertexCount; ++i)
+            {
+                m_TriangleOffsets[i + 1] += m_TriangleOffsets[i];
+            }
+            m_VertexTriangles.resize(m_Indices.size());
+            std::vector<uint32_t> fill(m_TriangleOffsets.begin(), m_TriangleOffsets.end() - 1);
+            for (size_t i = 0; i < m_Indices.size(); ++i)
+            {
+                m_VertexTriangles[fill[m_Indices[i]]++] = static_cast<uint32_t>(i / 3);
+            }
+
+            // A border vertex may only slide along the border, onto another vertex of it
+            const std::unordered_map<uint64_t, uint32_t> edgeUses = CountEdges();
+            std::vector<bool> border(vertexCount, false);
+            for (const auto& [key, uses] : edgeUses)
+            {
+                if (uses == 1)
+                {
+                    border[key >> 32] = true;
+                    border[key & 0xFFFFFFFFu] = true;
+                }
+            }
+
+            m_Collapses.clear();
+            for (const auto& [key, uses] : edgeUses)
+            {
+                const uint32_t a = static_cast<uint32_t>(key >> 32);
+                const uint32_t b = static_cast<uint32_t>(key & 0xFFFFFFFFu);
+                const bool borderEdge = uses == 1;
+                Collapse best{ a, b, -1.0 };
+                for (const auto& [from, to] : { std::pair{ a, b }, std::pair{ b, a } })
+                {
+                    if (border[from] && (!borderEdge || !border[to]))
+                    {
+                        continue;
+                    }
+                    const double cost = CollapseCost(from, to);
+                    if (best.cost < 0.0 || cost < best.cost)
+                    {
+                        best = { from, to, cost };
+                    }
+                }
+                if (best.cost >= 0.0)
+                {
+                    m_Collapses.push_back(best);
+                }
+            }
+            if (m_Collapses.empty())
+            {
+                return false;
+            }
+
+            // Ties are broken by vertex, so the result does not depend on the hash map's order
+            std::sort(m_Collapses.begin(), m_Collapses.end(), [](const Collapse& a, const Collapse& b)
+            {
+                return a.cost != b.cost ? a.cost < b.cost : a.from != b.from ? a.from < b.from : a.to < b.to;
+            });
+
+            // Each collapse removes up to two triangles and locks its neighbours, so a pass looks a
+            // little past the collapses it needs, but not far enough to take expensive ones early
+            const size_t excess = triangleCount - targetTriangles;
+            const double costLimit = m_Collapses[std::min(m_Collapses.size() - 1, excess)].cost;
+
+            m_Locked.assign(vertexCount, false);
+            for (size_t i = 0; i < vertexCount; ++i)
+            {
+                m_Remap[i] = static_cast<uint32_t>(i);
+            }
+
+            size_t removed = 0;
+            for (const Collapse& collapse : m_Collapses)
+            {
+                if (collapse.cost > costLimit || removed >= excess)
+                {
+                    break;
+                }
+                if (m_Locked[collapse.from] || m_Locked[collapse.to] || !KeepsOrientation(collapse.from, collapse.to))
+                {
+                    continue;
+                }
+
+                for (uint32_t i = m_TriangleOffsets[collapse.from]; i < m_TriangleOffsets[collapse.from + 1]; ++i)
+                {
+                    const uint32_t* corners = &m_Indices[m_VertexTriangles[i] * 3];
+                    removed += corners[0] == collapse.to || corners[1] == collapse.to || corners[2] == collapse.to ? 1 : 0;
+                }
+                m_Remap[collapse.from] = collapse.to;
+                m_Quadrics[collapse.to] += m_Quadrics[collapse.from];
+                m_MaxCost = std::max(m_MaxCost, collapse.cost);
+                LockNeighbourhood(collapse.from);
+                LockNeighbourhood(collapse.to);
+            }
+            if (removed == 0)
+            {
+                return false;
+            }
+
+            // Collapsed triangles are left with a repeated corner and go
+            size_t kept = 0;
+            for (size_t triangle = 0; triangle < m_Indices.size(); triangle += 3)
+            {
+                const uint32_t a = m_Remap[m_Indices[triangle]];
+                const uint32_t b = m_Remap[m_Indices[triangle + 1]];
+                const uint32_t c = m_Remap[m_Indices[triangle + 2]];
+                if (a != b && b != c && a != c)
+                {
+                    m_Indices[kept++] = a;
+                    m_Indices[kept++] = b;
+                    m_Indices[kept++] = c;
+                }
+            }
+            m_Indices.resize(kept);
+            return true;
+        }
+
+        std::vector<uint32_t> m_Indices;
+        std::vector<glm::dvec3> m_Positions;
+        std::vector<Quadric> m_Quadrics;
+        std::vector<uint32_t> m_Remap;
+        double m_MaxCost = 0.0;
+
+        // Rebuilt every pass
+        std::vector<uint32_t> m_TriangleOffsets;
+        std::vector<uint32_t> m_VertexTriangles;
+        std::vector<Collapse> m_Collapses;
+        std::vector<bool> m_Locked;
+    };
+}
+
+std::vector<MeshLod> MiniEngine::Graphics::BuildMeshLods(std::vector<uint32_t>& indices, const float* positions, size_t vertexCount,
+                                                         size_t vertexStride, const MeshLodSettings& settings)
+{
+    if (indices.size() % 3 != 0 || std::any_of(indices.begin(), indices.end(), [&](uint32_t index) { return index >= vertexCount; }))
+    {
+        throw std::invalid_argument("Mesh LODs need whole triangles of existing vertices");
+    }
+    if (!(settings.reduction > 0.0f && settings.reduction < 1.0f))
+    {
+        throw std::invalid_argument("Mesh LOD reduction must be between 0 and 1");
+    }
+
+    std::vector<MeshLod> lods = { { 0, static_cast<uint32_t>(indices.size()), 0.0f } };
+    Simplifier simplifier(indices, positions, vertexCount, vertexStride);
+    size_t triangles = indices.size() / 3;
+    while (lods.size() < settings.maxLevels)
+    {
+        const size_t target = std::max<size_t>(settings.minTriangles, static_cast<size_t>(triangles * settings.reduction));
+        if (target >= triangles)
+        {
+            break;
+        }
+
+        simplifier.SimplifyTo(target);
+        const std::vector<uint32_t>& simplified = simplifier.GetIndices();
+
+        // Stuck well short of the target, a level would cost memory without saving much
+        const size_t simplifiedTriangles = simplified.size() / 3;
+        if (simplifiedTriangles > (triangles + target) / 2)
+        {
+            break;
+        }
+
+        lods.push_back({ static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(simplified.size()), static_cast<float>(simplifier.GetError()) });
+        indices.insert(indices.end(), simplified.begin(), simplified.end());
+        triangles = simplifiedTriangles;
+    }
+    return lods;
+}
+
+uint32_t MiniEngine::Graphics::SelectMeshLod(std::span<const MeshLod> lods, float pixelsPerUnit, uint32_t currentLod, float thresholdPixels, float hysteresis)
+{
+    uint32_t selected = 0;
+    for (uint32_t level = static_cast<uint32_t>(lods.size()); level-- > 1;)
+    {
+        if (lods[level].error * pixelsPerUnit <= thresholdPixels)
+        {
+            selected = level;
+            break;
+        }
+    }
+
+    // Finer levels are taken as soon as they are needed, coarser ones only with some margin
+    while (selected > currentLod && lods[selected].error * pixelsPerUnit > thresholdPixels * (1.0f - hysteresis))
+    {
+        --selected;
+    }
+    return selected;
+}
@@ -0,0 +1,201 @@
+#include "MiniEngine/Graphics/Meshlet.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+using namespace MiniEngine::Graphics;
+
+namespace
+{
+    // Below this, the triangles face too many ways for a cone to be worth testing
+    constexpr float MinConeCosine = 0.1f;
+
+    void ComputeBounds(Meshlet& meshlet, std::span<const uint32_t> indices, std::span<const uint32_t> vertices, const std::vector<glm::vec3>& positions)
+    {
+        glm::vec3 boxMin(std::numeric_limits<float>::max());
+        glm::vec3 boxMax(-std::numeric_limits<float>::max());
+        for (uint32_t vertex : vertices)
+        {
+            boxMin = glm::min(boxMin, positions[vertex]);
+            boxMax = glm::max(boxMax, positions[vertex]);
+        }
+        meshlet.center = (boxMin + boxMax) * 0.5f;
+        meshlet.radius = 0.0f;
+        for (uint32_t vertex : vertices)
+        {
+            meshlet.radius = std::max(meshlet.radius, glm::length(positions[vertex] - meshlet.center));
+        }
+
+        std::vector<glm::vec3> normals;
+        normals.reserve(indices.size() / 3);
+        glm::vec3 normalSum(0.0f);
+        for (size_t triangle = 0; triangle < indices.size(); triangle += 3)
+        {
+            const glm::vec3& p0 = positions[indices[triangle]];
+            const glm::vec3 cross = glm::cross(positions[indices[triangle + 1]] - p0, positions[indices[triangle + 2]] - p0);
+            const float length = glm::length(cross);
+            if (length > 0.0f)
+            {
+                normals.push_back(cross / length);
+                normalSum += normals.back();
+            }
+        }
+
+        const float sumLength = glm::length(normalSum);
+        if (normals.empty() || sumLength <= 0.0f)
+        {
+            return;
+        }
+        meshlet.coneAxis = normalSum / sumLength;
+        float minCosine = 1.0f;
+        for (const glm::vec3& normal : normals)
+        {
+            minCosine = std::min(minCosine, glm::dot(normal, meshlet.coneAxis));
+        }
+        meshlet.coneCutoff = minCosine < MinConeCosine ? 1.0f : std::sqrt(1.0f - minCosine * minCosine);
+    }
+}
+
+std::vector<Meshlet> MiniEngine::Graphics::BuildMeshlets(std::span<uint32_t> indices, uint32_t firstIndex, const float* positions, size_t vertexCount,
+                                                         size_t vertexStride, const MeshletLimits& limits)
+{
+    if (indices.size() % 3 != 0 || std::any_of(indices.begin(), indices.end(), [&](uint32_t index) { return index >= vertexCount; }))
+    {
+        throw std::invalid_argument("Meshlets need whole triangles of existing vertices");
+    }
+    if (limits.maxVertices < 3 || limits.maxTriangles < 1)
+    {
+        throw std::invalid_argument("Meshlet limits must hold at least one triangle");
+    }
+
+    std::vector<glm::vec3> points(vertexCount);
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(positions);
+    for (size_t i = 0; i < vertexCount; ++i)
+    {
+        std::memcpy(&points[i], bytes + i * vertexStride, sizeof(float) * 3);
+    }
+
+    // Triangles around each vertex
+    const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+    std::vector<uint32_t> offsets(vertexCount + 1, 0);
+    for (uint32_t index : indices)
+    {
+        ++offsets[index + 1];
+    }
+    for (size_t i = 0; i < vertexCount; ++i)
+    {
+        offsets[i + 1] += offsets[i];
+    }
+    std::vector<uint32_t> adjacency(indices.size());
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < indices.size(); ++i)
+    {
+        adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+
+    std::vector<Meshlet> meshlets;
+    std::vector<uint32_t> ordered;
+    ordered.reserve(indices.size());
+    std::vector<bool> used(triangleCount, false);
+    std::vector<uint32_t> vertexMeshlet(vertexCount, std::numeric_limits<uint32_t>::max()); // Last meshlet each vertex joined
+    std::vector<uint32_t> vertices;
+
+    uint32_t seed = 0;
+    while (true)
+    {
+        while (seed < triangleCount && used[seed])
+        {
+            ++seed;
+        }
+        if (seed == triangleCount)
+        {
+            break;
+        }
+
+        const uint32_t id = static_cast<uint32_t>(meshlets.size());
+        const size_t first = ordered.size();
+        vertices.clear();
+        glm::vec3 positionSum(0.0f);
+        auto newVertices = [&](uint32_t triangle)
+        {
+            uint32_t count = 0;
+            for (uint32_t corner = 0; corner < 3; ++corner)
+            {
+                count += vertexMeshlet[indices[triangle * 3 + corner]] != id ? 1 : 0;
+            }
+            return count;
+        };
+        auto add = [&](uint32_t triangle)
+        {
+            used[triangle] = true;
+            for (uint32_t corner = 0; corner < 3; ++corner)
+            {
+                const uint32_t vertex = indices[triangle * 3 + corner];
+                if (vertexMeshlet[vertex] != id)
+                {
+                    vertexMeshlet[vertex] = id;
+                    vertices.push_back(vertex);
+                    positionSum += points[vertex];
+                }
+                ordered.push_back(vertex);
+            }
+        };
+
+        add(seed);
+        uint32_t triangles = 1;
+
+        // Grow through triangles sharing a vertex: fewest new vertices first, then the closest, so
+        // meshlets stay compact and their bounds and cones tight. A meshlet with no neighbour left
+        // ends there rather than jumping elsewhere.
+        while (triangles < limits.maxTriangles)
+        {
+            const glm::vec3 centroid = positionSum / static_cast<float>(vertices.size());
+            uint32_t best = triangleCount;
+            uint32_t bestNew = 4;
+            float bestDistance = 0.0f;
+            for (uint32_t vertex : vertices)
+            {
+                for (uint32_t i = offsets[vertex]; i < offsets[vertex + 1]; ++i)
+                {
+                    const uint32_t triangle = adjacency[i];
+                    if (used[triangle])
+                    {
+                        continue;
+                    }
+                    const uint32_t added = newVertices(triangle);
+                    if (vertices.size() + added > limits.maxVertices || added > bestNew)
+                    {
+                        continue;
+                    }
+                    const glm::vec3 center = (points[indices[triangle * 3]] + points[indices[triangle * 3 + 1]] + points[indices[triangle * 3 + 2]]) / 3.0f;
+                    const float distance = glm::dot(center - centroid, center - centroid);
+                    if (added < bestNew || distance < bestDistance)
+                    {
+                        best = triangle;
+                        bestNew = added;
+                        bestDistance = distance;
+                    }
+                }
+            }
+            if (best == triangleCount)
+            {
+                break;
+            }
+            add(best);
+            ++triangles;
+        }
+
+        Meshlet meshlet;
+        meshlet.firstIndex = firstIndex + static_cast<uint32_t>(first);
+        meshlet.indexCount = triangles * 3;
+        meshlet.vertexCount = static_cast<uint32_t>(vertices.size());
+        ComputeBounds(meshlet, std::span<const uint32_t>(ordered).subspan(first), vertices, points);
+        meshlets.push_back(meshlet);
+    }
+
+    std::copy(ordered.begin(), ordered.end(), indices.begin());
+    return meshlets;
+}
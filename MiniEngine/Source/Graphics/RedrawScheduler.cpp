@@ -0,0 +1,315 @@
+#include "MiniEngine/Graphics/RedrawScheduler.hpp"
+
+#define GLFW_INCLUDE_NONE
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#endif
+
+using namespace MiniEngine::Graphics;
+
+namespace
+{
+    // User and kernel time of every thread in the process
+    double GetProcessCpuSeconds()
+    {
+#if defined(_WIN32)
+        FILETIME creation, exit, kernel, user;
+        if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user))
+        {
+            return 0.0;
+        }
+        auto seconds = [](const FILETIME& time)
+        {
+            return static_cast<double>((static_cast<uint64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime) * 1e-7;
+        };
+        return seconds(kernel) + seconds(user);
+#else
+        rusage usage = {};
+        if (getrusage(RUSAGE_SELF, &usage) != 0)
+        {
+            return 0.0;
+        }
+        return static_cast<double>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+            static_cast<double>(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1e-6;
+#endif
+    }
+
+    RedrawRegion Intersect(const RedrawRegion& a, const RedrawRegion& b)
+    {
+        const int64_t left = std::max<int64_t>(a.x, b.x);
+        const int64_t top = std::max<int64_t>(a.y, b.y);
+        const int64_t right = std::min<int64_t>(int64_t(a.x) + a.width, int64_t(b.x) + b.width);
+        const int64_t bottom = std::min<int64_t>(int64_t(a.y) + a.height, int64_t(b.y) + b.height);
+        if (right <= left || bottom <= top)
+        {
+            return {};
+        }
+        return { static_cast<int32_t>(left), static_cast<int32_t>(top), static_cast<uint32_t>(right - left), static_cast<uint32_t>(bottom - top) };
+    }
+}
+
+const char* MiniEngine::Graphics::ToString(RedrawMode mode)
+{
+    switch (mode)
+    {
+    case RedrawMode::Continuous: return "continuous";
+    case RedrawMode::OnDemand:   return "on demand";
+    default:                     return "unknown";
+    }
+}
+
+RedrawRegion RedrawRegion::Union(const RedrawRegion& other) const
+{
+    if (IsEmpty())
+    {
+        return other;
+    }
+    if (other.IsEmpty())
+    {
+        return *this;
+    }
+
+    const int64_t left = std::min<int64_t>(x, other.x);
+    const int64_t top = std::min<int64_t>(y, other.y);
+    const int64_t right = std::max<int64_t>(int64_t(x) + width, int64_t(other.x) + other.width);
+    const int64_t bottom = std::max<int64_t>(int64_t(y) + height, int64_t(other.y) + other.height);
+    return { static_cast<int32_t>(left), static_cast<int32_t>(top), static_cast<uint32_t>(right - left), static_cast<uint32_t>(bottom - top) };
+}
+
+RedrawScheduler::RedrawScheduler(RedrawMode mode)
+    : m_Mode(mode)
+{
+}
+
+void RedrawScheduler::Attach(GLFWwindow* window)
+{
+    if (m_Window)
+    {
+        glfwSetWindowUserPointer(m_Window, nullptr);
+        glfwSetFramebufferSizeCallback(m_Window, nullptr);
+        glfwSetWindowRefreshCallback(m_Window, nullptr);
+        glfwSetWindowFocusCallback(m_Window, nullptr);
+        glfwSetKeyCallback(m_Window, nullptr);
+        glfwSetCharCallback(m_Window, nullptr);
+        glfwSetMouseButtonCallback(m_Window, nullptr);
+        glfwSetCursorPosCallback(m_Window, nullptr);
+        glfwSetScrollCallback(m_Window, nullptr);
+    }
+
+    m_Window = window;
+    if (!m_Window)
+    {
+        return;
+    }
+
+    int width = 0;
+    int height = 0;
+    glfwGetFramebufferSize(m_Window, &width, &height);
+    SetFramebufferSize(width, height);
+
+    // Anything the user does may change what is on screen, so every event redraws everything
+    glfwSetWindowUserPointer(m_Window, this);
+    glfwSetFramebufferSizeCallback(m_Window, [](GLFWwindow* window, int width, int height)
+    {
+        static_cast<RedrawScheduler*>(glfwGetWindowUserPointer(window))->SetFramebufferSize(width, height);
+    });
+    glfwSetWindowRefreshCallback(m_Window, [](GLFWwindow* window) { InvalidateWindow(window); });
+    glfwSetWindowFocusCallback(m_Window, [](GLFWwindow* window, int) { InvalidateWindow(window); });
+    glfwSetKeyCallback(m_Window, [](GLFWwindow* window, int, int, int, int) { InvalidateWindow(window); });
+    glfwSetCharCallback(m_Window, [](GLFWwindow* window, unsigned int) { InvalidateWindow(window); });
+    glfwSetMouseButtonCallback(m_Window, [](GLFWwindow* window, int, int, int) { InvalidateWindow(window); });
+    glfwSetCursorPosCallback(m_Window, [](GLFWwindow* window, double, double) { InvalidateWindow(window); });
+    glfwSetScrollCallback(m_Window, [](GLFWwindow* window, double, double) { InvalidateWindow(window); });
+}
+
+void RedrawScheduler::SetMode(RedrawMode mode)
+{
+    std::lock_guard lock(m_Mutex);
+    m_Mode = mode;
+    m_DirtyAll = true;
+}
+
+RedrawMode RedrawScheduler::GetMode() const
+{
+    std::lock_guard lock(m_Mutex);
+    return m_Mode;
+}
+
+void RedrawScheduler::Invalidate()
+{
+    InvalidateAll();
+    glfwPostEmptyEvent();
+}
+
+void RedrawScheduler::Invalidate(const RedrawRegion& region)
+{
+    {
+        std::lock_guard lock(m_Mutex);
+        m_Dirty = m_Dirty.Union(region);
+    }
+    glfwPostEmptyEvent();
+}
+
+void RedrawScheduler::RequestQuit()
+{
+    {
+        std::lock_guard lock(m_Mutex);
+        m_QuitRequested = true;
+    }
+    glfwPostEmptyEvent();
+}
+
+bool RedrawScheduler::IsQuitRequested() const
+{
+    std::lock_guard lock(m_Mutex);
+    return m_QuitRequested;
+}
+
+uint32_t RedrawScheduler::AddAnimation(const RedrawRegion& region, double interval)
+{
+    uint32_t id = 0;
+    {
+        std::lock_guard lock(m_Mutex);
+        id = m_NextAnimationId++;
+        m_Animations.push_back({ id, region, std::max(interval, 0.0), Clock::now() });
+    }
+    glfwPostEmptyEvent(); // The waiting thread picks up the new deadline
+    return id;
+}
+
+void RedrawScheduler::RemoveAnimation(uint32_t id)
+{
+    std::lock_guard lock(m_Mutex);
+    std::erase_if(m_Animations, [id](const Animation& animation) { return animation.id == id; });
+}
+
+bool RedrawScheduler::WaitForRedraw(Redraw& redraw)
+{
+    glfwPollEvents();
+
+    bool waitForEvents = true;
+    double timeout = 0.0;
+    {
+        std::lock_guard lock(m_Mutex);
+        if (m_QuitRequested)
+        {
+            return false;
+        }
+
+        const Clock::time_point now = Clock::now();
+        if (TakeRedraw(redraw, now))
+        {
+            return true;
+        }
+
+        // Nothing to draw yet: sleep until the next animation is due. A minimized window draws
+        // nothing, continuous or not, until it is restored.
+        if (!m_Framebuffer.IsEmpty())
+        {
+            for (const Animation& animation : m_Animations)
+            {
+                const double untilDue = std::max(std::chrono::duration<double>(animation.due - now).count(), 0.0);
+                timeout = waitForEvents ? untilDue : std::min(timeout, untilDue);
+                waitForEvents = false;
+            }
+        }
+    }
+
+    const Clock::time_point waitStart = Clock::now();
+    const double cpuStart = GetProcessCpuSeconds();
+    if (waitForEvents)
+    {
+        glfwWaitEvents();
+    }
+    else
+    {
+        glfwWaitEventsTimeout(timeout);
+    }
+    const Clock::time_point wakeTime = Clock::now();
+    const double cpuSeconds = GetProcessCpuSeconds() - cpuStart;
+
+    std::lock_guard lock(m_Mutex);
+    ++m_Stats.wakeups;
+    m_Idle = m_Idle || waitForEvents;
+    m_Stats.idleSeconds += std::chrono::duration<double>(wakeTime - waitStart).count();
+    m_Stats.idleCpuSeconds += cpuSeconds;
+    return !m_QuitRequested && TakeRedraw(redraw, wakeTime);
+}
+
+void RedrawScheduler::NotifyPresented(const Redraw& redraw)
+{
+    const double latencyMs = std::chrono::duration<double, std::milli>(Clock::now() - redraw.wakeTime).count();
+
+    std::lock_guard lock(m_Mutex);
+    ++m_Stats.presents;
+    m_Stats.wakeToPresentMs += latencyMs;
+    m_Stats.maxWakeToPresentMs = std::max(m_Stats.maxWakeToPresentMs, latencyMs);
+}
+
+RedrawStats RedrawScheduler::GetStats() const
+{
+    std::lock_guard lock(m_Mutex);
+    return m_Stats;
+}
+
+void RedrawScheduler::InvalidateWindow(GLFWwindow* window)
+{
+    static_cast<RedrawScheduler*>(glfwGetWindowUserPointer(window))->InvalidateAll();
+}
+
+void RedrawScheduler::InvalidateAll()
+{
+    std::lock_guard lock(m_Mutex);
+    m_DirtyAll = true;
+}
+
+void RedrawScheduler::SetFramebufferSize(int width, int height)
+{
+    std::lock_guard lock(m_Mutex);
+    m_Framebuffer = { 0, 0, static_cast<uint32_t>(std::max(width, 0)), static_cast<uint32_t>(std::max(height, 0)) };
+    m_DirtyAll = true;
+}
+
+bool RedrawScheduler::TakeRedraw(Redraw& redraw, Clock::time_point now)
+{
+    if (m_Framebuffer.IsEmpty())
+    {
+        return false;
+    }
+
+    bool full = m_DirtyAll || m_Mode == RedrawMode::Continuous;
+    RedrawRegion region = m_Dirty;
+    for (Animation& animation : m_Animations)
+    {
+        if (animation.due <= now)
+        {
+            full = full || animation.region.IsEmpty();
+            region = region.Union(animation.region);
+            animation.due = now + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(animation.interval));
+        }
+    }
+
+    region = full ? m_Framebuffer : Intersect(region, m_Framebuffer);
+    if (region.IsEmpty())
+    {
+        return false;
+    }
+
+    m_Dirty = {};
+    m_DirtyAll = false;
+    ++m_Stats.frames;
+    redraw.region = region;
+    redraw.full = full;
+    redraw.wakeTime = now;
+    redraw.idle = m_Idle;
+    m_Idle = false;
+    return true;
+}
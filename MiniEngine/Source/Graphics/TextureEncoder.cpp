@@ -0,0 +1,1294 @@
+#include "MiniEngine/Graphics/TextureEncoder.hpp"
+
+#include "TextureEncoderKernels.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+using namespace MiniEngine::Graphics;
+
+namespace
+{
+    using Detail::BlockTexelCount;
+    using Detail::BlockTexels;
+
+    using RgbaBlock = uint8_t[BlockTexelCount][4];
+
+    // Every texel of a block, as a mask with bit i for texel i
+    constexpr uint32_t AllTexels = 0xFFFF;
+
+    // High quality refines until the error stops falling or this many times
+    constexpr uint32_t MaxRefinements = 8;
+    constexpr uint32_t MaxNudgePasses = 2;
+    constexpr uint32_t PowerIterations = 8;
+
+    // BC7's interpolation weights for 2, 3 and 4-bit indices, out of 64
+    constexpr uint32_t Bc7Weights2[4] = { 0, 21, 43, 64 };
+    constexpr uint32_t Bc7Weights3[8] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+    constexpr uint32_t Bc7Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+    // BC7's partitions of a block into two subsets, bit i set when texel i is in the second
+    constexpr uint16_t Bc7Partitions2[64] = {
+        0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80, 0xC800, 0xFFEC, 0xFE80, 0xE800, 0xFFE8, 0xFF00, 0xFFF0, 0xF000,
+        0xF710, 0x008E, 0x7100, 0x08CE, 0x008C, 0x7310, 0x3100, 0x8CCE, 0x088C, 0x3110, 0x6666, 0x366C, 0x17E8, 0x0FF0, 0x718E, 0x399C,
+        0xAAAA, 0xF0F0, 0x5A5A, 0x33CC, 0x3C3C, 0x55AA, 0x9696, 0xA55A, 0x73CE, 0x13C8, 0x324C, 0x3BDC, 0x6996, 0xC33C, 0x9966, 0x0660,
+        0x0272, 0x04E4, 0x4E40, 0x2720, 0xC936, 0x936C, 0x39C6, 0x639C, 0x9336, 0x9CC6, 0x817E, 0xE718, 0xCCF0, 0x0FCC, 0x7744, 0xEE22,
+    };
+
+    // The texel of the second subset whose index has an implied top bit of zero; the first subset's is texel 0
+    constexpr uint8_t Bc7Anchors2[64] = {
+        15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+        15,  2,  8,  2,  2,  8,  8, 15,  2,  8,  2,  2,  8,  8,  2,  2,
+        15, 15,  6,  8,  2,  8, 15, 15,  2,  8,  2,  2,  2, 15, 15,  6,
+         6,  2,  6,  8, 15, 15,  2,  2, 15, 15, 15, 15, 15,  2,  2, 15,
+    };
+
+    constexpr bool AnchorsMatchPartitions()
+    {
+        for (uint32_t partition = 0; partition < 64; ++partition)
+        {
+            if ((Bc7Partitions2[partition] & 1) != 0 || ((Bc7Partitions2[partition] >> Bc7Anchors2[partition]) & 1) == 0)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+    static_assert(AnchorsMatchPartitions(), "Texel 0 anchors the first subset and each second anchor lies in the second");
+
+    // Mode 1 has too many partitions to fit every one; the best by EstimateLineResidual are fitted in full
+    uint32_t GetBc7PartitionCandidates(TextureEncodeQuality quality)
+    {
+        switch (quality)
+        {
+        case TextureEncodeQuality::Fast:   return 1;
+        case TextureEncodeQuality::Normal: return 2;
+        default:                           return 4;
+        }
+    }
+
+    Detail::FitBlockIndicesFunction GetKernel(MiniEngine::Core::SimdLevel simdLevel)
+    {
+        switch (simdLevel)
+        {
+        case MiniEngine::Core::SimdLevel::Avx2: return Detail::FitBlockIndicesAvx2;
+        case MiniEngine::Core::SimdLevel::Sse:  return Detail::FitBlockIndicesSse;
+        default:                                return Detail::FitBlockIndicesScalar;
+        }
+    }
+
+    float SnapToBits(float value, uint32_t bits)
+    {
+        const float levels = static_cast<float>((1u << bits) - 1);
+        const uint32_t quantized = static_cast<uint32_t>(std::clamp(value, 0.0f, 255.0f) * levels / 255.0f + 0.5f);
+        return static_cast<float>((quantized << (8 - bits)) | (quantized >> (2 * bits - 8)));
+    }
+
+    void Snap565(float* endpoint)
+    {
+        endpoint[0] = SnapToBits(endpoint[0], 5);
+        endpoint[1] = SnapToBits(endpoint[1], 6);
+        endpoint[2] = SnapToBits(endpoint[2], 5);
+    }
+
+    void SnapBytes(float* endpoint)
+    {
+        for (int c = 0; c < 4; ++c)
+        {
+            endpoint[c] = std::floor(std::clamp(endpoint[c], 0.0f, 255.0f) + 0.5f);
+        }
+    }
+
+    // Seven bits per channel, expanded to eight by repeating the top bit
+    void SnapBc7Rgb7(float* endpoint)
+    {
+        for (int c = 0; c < 3; ++c)
+        {
+            endpoint[c] = SnapToBits(endpoint[c], 7);
+        }
+    }
+
+    // Seven bits per channel and a bit shared by all four as the lowest, whichever lands closer
+    void SnapBc7Mode6(float* endpoint)
+    {
+        float best[4] = {};
+        float bestError = std::numeric_limits<float>::max();
+        for (uint32_t pBit = 0; pBit < 2; ++pBit)
+        {
+            float snapped[4];
+            float error = 0.0f;
+            for (int c = 0; c < 4; ++c)
+            {
+                const float quantized = std::clamp(std::floor((endpoint[c] - pBit) * 0.5f + 0.5f), 0.0f, 127.0f);
+                snapped[c] = quantized * 2.0f + pBit;
+                error += (snapped[c] - endpoint[c]) * (snapped[c] - endpoint[c]);
+            }
+            if (error < bestError)
+            {
+                bestError = error;
+                std::memcpy(best, snapped, sizeof(best));
+            }
+        }
+        std::memcpy(endpoint, best, sizeof(best));
+    }
+
+    // Six bits per channel and a seventh shared by both endpoints, whichever lands closer, then
+    // expanded to eight by repeating the top bit
+    void SnapBc7Mode1(float* start, float* end)
+    {
+        float* endpoints[2] = { start, end };
+        float best[2][3] = {};
+        float bestError = std::numeric_limits<float>::max();
+        for (uint32_t pBit = 0; pBit < 2; ++pBit)
+        {
+            float snapped[2][3];
+            float error = 0.0f;
+            for (int e = 0; e < 2; ++e)
+            {
+                for (int c = 0; c < 3; ++c)
+                {
+                    const float value = std::clamp(endpoints[e][c], 0.0f, 255.0f);
+                    const float quantized = std::clamp(std::floor((value * 127.0f / 255.0f - pBit) * 0.5f + 0.5f), 0.0f, 63.0f);
+                    const uint32_t bits = static_cast<uint32_t>(quantized) * 2 + pBit;
+                    snapped[e][c] = static_cast<float>((bits << 1) | (bits >> 6));
+                    error += (snapped[e][c] - value) * (snapped[e][c] - value);
+                }
+            }
+            if (error < bestError)
+            {
+                bestError = error;
+                std::memcpy(best, snapped, sizeof(best));
+            }
+        }
+        std::memcpy(start, best[0], sizeof(best[0]));
+        std::memcpy(end, best[1], sizeof(best[1]));
+    }
+
+    template <void (*SnapEndpoint)(float*)>
+    void SnapEach(float* start, float* end)
+    {
+        SnapEndpoint(start);
+        SnapEndpoint(end);
+    }
+
+    // How a format stores a block's endpoints; fits work on their values from 0 to 255, snapped to what it can hold
+    struct EndpointCodec
+    {
+        uint32_t channels;   // Leading channels that are fitted
+        uint32_t steps;      // Points from one endpoint to the other
+        float    quantum[4]; // Distance between neighbouring values each channel can hold
+        void   (*snap)(float* start, float* end);
+    };
+
+    constexpr EndpointCodec Bc1Codec = { 3, 4, { 255.0f / 31.0f, 255.0f / 63.0f, 255.0f / 31.0f, 0.0f }, SnapEach<Snap565> };
+    constexpr EndpointCodec Bc4Codec = { 1, 8, { 1.0f, 0.0f, 0.0f, 0.0f }, SnapEach<SnapBytes> };
+
+    // BC7 mode 6 fits RGBA together, mode 5 colour and alpha apart, and mode 1 the colour of each of two subsets
+    constexpr EndpointCodec Bc7Mode6Codec      = { 4, 16, { 2.0f, 2.0f, 2.0f, 2.0f }, SnapEach<SnapBc7Mode6> };
+    constexpr EndpointCodec Bc7Mode5ColorCodec = { 3, 4, { 255.0f / 127.0f, 255.0f / 127.0f, 255.0f / 127.0f, 0.0f }, SnapEach<SnapBc7Rgb7> };
+    constexpr EndpointCodec Bc7Mode5AlphaCodec = { 1, 4, { 1.0f, 0.0f, 0.0f, 0.0f }, SnapEach<SnapBytes> };
+    constexpr EndpointCodec Bc7Mode1Codec      = { 3, 8, { 255.0f / 63.0f, 255.0f / 63.0f, 255.0f / 63.0f, 0.0f }, SnapBc7Mode1 };
+
+    struct BlockFit
+    {
+        float   start[4] = {};
+        float   end[4]   = {};
+        uint8_t indices[BlockTexelCount] = {}; // From 0 at start to steps - 1 at end; only the fitted texels' are meaningful
+        float   error    = std::numeric_limits<float>::max();
+    };
+
+    bool HasTexel(uint32_t mask, uint32_t texel)
+    {
+        return ((mask >> texel) & 1) != 0;
+    }
+
+    // The texels of the block at (blockX, blockY), repeating the last column and row past the edges
+    void LoadBlock(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t blockX, uint32_t blockY, RgbaBlock& block)
+    {
+        for (uint32_t y = 0; y < 4; ++y)
+        {
+            const uint32_t row = std::min(blockY * 4 + y, height - 1);
+            for (uint32_t x = 0; x < 4; ++x)
+            {
+                const uint32_t column = std::min(blockX * 4 + x, width - 1);
+                std::memcpy(block[y * 4 + x], rgba + (static_cast<size_t>(row) * width + column) * 4, 4);
+            }
+        }
+    }
+
+    BlockTexels SelectChannels(const RgbaBlock& block, uint32_t first, uint32_t count)
+    {
+        BlockTexels texels{};
+        for (uint32_t c = 0; c < count; ++c)
+        {
+            for (uint32_t texel = 0; texel < BlockTexelCount; ++texel)
+            {
+                texels.channel[c][texel] = block[texel][first + c];
+            }
+        }
+        return texels;
+    }
+
+    // The line through the mean of the texels in mask along their principal axis, clipped to where they project onto it
+    void FindPrincipalEndpoints(const BlockTexels& texels, uint32_t mask, uint32_t channels, float* start, float* end)
+    {
+        float mean[4] = {};
+        float low[4] = {};
+        float high[4] = {};
+        uint32_t count = 0;
+        for (uint32_t c = 0; c < channels; ++c)
+        {
+            low[c] = std::numeric_limits<float>::max();
+            high[c] = -std::numeric_limits<float>::max();
+            count = 0;
+            for (uint32_t texel = 0; texel < BlockTexelCount; ++texel)
+            {
+                if (HasTexel(mask, texel))
+                {
+                    mean[c] += texels.channel[c][texel];
+                    low[c] = std::min(low[c], texels.channel[c][texel]);
+                    high[c] = std::max(high[c], texels.channel[c][texel]);
+                    ++count;
+                }
+            }
+            mean[c] /= static_cast<float>(count);
+        }
+
+        float covariance[4][4] = {};
+        for (uint32_t texel = 0; texel < BlockTexelCount; ++texel)
+        {
+            if (!HasTexel(mask, texel))
+            {
+                continue;
+            }
+            for (uint32_t i = 0; i < channels; ++i)
+            {
+                for (uint32_t j = 0; j < channels; ++j)
+                {
+                    covariance[i][j] += (texels.channel[i][texel] - mean[i]) * (texels.channel[j][texel] - mean[j]);
+                }
+            }
+        }
+
+        // Power iteration from the bounding box's diagonal
+        float axis[4] = {};
+        for (uint32_t c = 0; c < channels; ++c)
+        {
+            axis[c] = high[c] - low[c];
+        }
+        for (uint32_t iteration = 0; iteration < PowerIterations; ++iteration)
+        {
+            float next[4] = {};
+            float largest = 0.0f;
+            for (uint32_t i = 0; i < channels; ++i)
+            {
+                for (uint32_t j = 0; j < channels; ++j)
+                {
+                    next[i] += covariance[i][j] * axis[j];
+                }
+                largest = std::max(largest, std::abs(next[i]));
+            }
+            if (largest <= 0.0f)
+            {
+                break;
+            }
+            for (uint32_t c = 0; c < channels; ++c)
+            {
+                axis[c] = next[c] / largest;
+            }
+        }
+
+        float length = 0.0f;
+        for (uint32_t c = 0; c < channels; ++c)
+        {
+            length += axis[c] * axis[c];
+        }
+        length = std::sqrt(length);
+        if (length <= 0.0f)
+        {
+            // Every texel is the same
+            std::memcpy(start, mean, sizeof(mean));
+            std::memcpy(end, mean, sizeof(mean));
+            return;
+        }
+
+        float minProjection = std::numeric_limits<float>::max();
+        float maxProjection = -std::numeric_limits<float>::max();
+        for (uint32_t texel = 0; texel < BlockTexelCount; ++texel)
+        {
+            if (!HasTexel(mask, texel))
+            {
+                continue;
+            }
+            float projection = 0.0f;
+            for (uint32_t c = 0; c < channels; ++c)
+            {
+                projection += (texels.channel[c][texel] - mean[c]) * axis[c] / length;
+            }
+            minProjection = std::min(minProjection, projection);
+            maxProjection = std::max(maxProjection, projection);
+        }
+        for (uint32_t c = 0; c < 4; ++c)
+        {
+            start[c] = std::clamp(mean[c] + axis[c] / length * minProjection, 0.0f, 255.0f);
+            end[c] = std::clamp(mean[c] + axis[c] / length * maxProjection, 0.0f, 255.0f);
+        }
+    }
+
+    // The endpoints that best reproduce the texels in mask with the indices they were given. False
+    // when every texel has the same index, which leaves them undetermined.
+    bool SolveEndpoints(const BlockTexels& texels, uint32_t mask, uint32_t channels, uint32_t steps, const uint8_t* indices, float* start, float* end)
+    {
+        float startStart = 0.0f;
+        float startEnd = 0.0f;
+        float endEnd = 0.0f;
+        float startTexel[4] = {};
+        float endTexel[4] = {};
+        for (uint32_t texel = 0; texel < BlockTexelCount; ++texel)
+        {
+            if (!HasTexel(mask, texel))
+            {
+                continue;
+            }
+            const float toEnd = static_cast<float>(indices[texel]) / (steps - 1);
+            const float toStart = 1.0f - toEnd;
+            startStart += toStart * toStart;
+            startEnd += toStart * toEnd;
+            endEnd += toEnd * toEnd;
+            for (uint32_t c = 0; c < channels; ++c)
+            {
+                startTexel[c] += toStart * texels.channel[c][texel];
+                endTexel[c] += toEnd * texels.channel[c][texel];
+            }
+        }
+
+        const float determinant = startStart * endEnd - startEnd * startEnd;
+        if (determinant < 1e-6f)
+        {
+            return false;
+        }
+        for (uint32_t c = 0; c < channels; ++c)
+        {
+            start[c] = std::clamp((endEnd * startTexel[c] - startEnd * endTexel[c]) / determinant, 0.0f, 255.0f);
+            end[c] = std::clamp((startStart * endTexel[c] - startEnd * startTexel[c]) / determinant, 0.0f, 255.0f);
+        }
+        return true;
+    }
+
+    // Fits the texels in mask. The kernel measures every texel, and the errors of those in mask are
+    // summed here pairwise in a fixed order, so the result is the same whichever kernel measured them.
+    BlockFit FitBlock(const BlockTexels& texels, const EndpointCodec& codec, TextureEncodeQuality quality, Detail::FitBlockIndicesFunction fitIndices,
+                      uint32_t mask = AllTexels)
+    {
+        auto evaluate = [&](const float* start, const float* end)
+        {
+            BlockFit fit;
+            std::memcpy(fit.start, start, sizeof(fit.start));
+            std::memcpy(fit.end, end, sizeof(fit.end));
+            codec.snap(fit.start, fit.end);
+
+            float errors[BlockTexelCount];
+            fitIndices(texels, fit.start, fit.end, codec.steps, fit.indices, errors);
+            for (uint32_t texel = 0; texel < BlockTexelCount; ++texel)
+            {
+                errors[texel] = HasTexel(mask, texel) ? errors[texel] : 0.0f;
+            }
+            for (uint32_t width = BlockTexelCount / 2; width > 0; width /= 2)
+            {
+                for (uint32_t texel = 0; texel < width; ++texel)
+                {
+                    errors[texel] += errors[texel + width];
+                }
+            }
+            fit.error = errors[0];
+            return fit;
+        };
+
+        float start[4] = {};
+        float end[4] = {};
+        FindPrincipalEndpoints(texels, mask, codec.channels, start, end);
+        BlockFit best = evaluate(start, end);
+
+        const uint32_t refinements = quality == TextureEncodeQuality::Fast ? 0 : (quality == TextureEncodeQuality::Normal ? 1 : MaxRefinements);
+        for (uint32_t i = 0; i < refinements && best.error > 0.0f; ++i)
+        {
+            if (!SolveEndpoints(texels, mask, codec.channels, codec.steps, best.indices, start, end))
+            {
+                break;
+            }
+            const BlockFit candidate = evaluate(start, end);
+            if (candidate.error >= best.error)
+            {
+                break;
+            }
+            best = candidate;
+        }
+
+        if (quality != TextureEncodeQuality::High)
+        {
+            return best;
+        }
+
+        // Least squares ignores where the format can put endpoints; trying their neighbours makes up for some of it
+        for (uint32_t pass = 0; pass < MaxNudgePasses && best.error > 0.0f; ++pass)
+        {
+            bool improved = false;
+            for (uint32_t endpoint = 0; endpoint < 2; ++endpoint)
+            {
+                for (uint32_t c = 0; c < codec.channels; ++c)
+                {
+                    for (float direction : { -1.0f, 1.0f })
+                    {
+                        std::memcpy(start, best.start, sizeof(start));
+                        std::memcpy(end, best.end, sizeof(end));
+                        (endpoint == 0 ? start : end)[c] += direction * codec.quantum[c];
+                        const BlockFit candidate = evaluate(start, end);
+                        if (candidate.error < best.error)
+                        {
+                            best = candidate;
+                            improved = true;
+                        }
+                    }
+                }
+            }
+            if (!improved)
+            {
+                break;
+            }
+        }
+        return best;
+    }
+
+    uint16_t To565(const float* color)
+    {
+        const uint32_t red = static_cast<uint32_t>(color[0] * 31.0f / 255.0f + 0.5f);
+        const uint32_t green = static_cast<uint32_t>(color[1] * 63.0f / 255.0f + 0.5f);
+        const uint32_t blue = static_cast<uint32_t>(color[2] * 31.0f / 255.0f + 0.5f);
+        return static_cast<uint16_t>((red << 11) | (green << 5) | blue);
+    }
+
+    // Always in four colour mode, which BC3 requires and which leaves BC1 opaque
+    void WriteBc1Colors(const BlockFit& fit, uint8_t* output)
+    {
+        constexpr uint32_t Codes[4] = { 0, 2, 3, 1 }; // From start to end, as BC1 numbers its colours
+
+        uint16_t color0 = To565(fit.start);
+        uint16_t color1 = To565(fit.end);
+        const bool reversed = color0 < color1;
+        if (reversed)
+        {
+            std::swap(color0, color1);
+        }
+
+        // Equal colours leave every index at the first
+        uint32_t bits = 0;
+        if (color0 != color1)
+        {
+            for (uint32_t texel = 0; texel < BlockTexelCount; ++texel)
+            {
+                const uint32_t index = reversed ? 3 - fit.indices[texel] : fit.indices[texel];
+                bits |= Codes[index] << (texel * 2);
+            }
+        }
+
+        std::memcpy(output, &color0, sizeof(color0));
+        std::memcpy(output + 2, &color1, sizeof(color1));
+        std::memcpy(output + 4, &bits, sizeof(bits));
+    }
+
+    // Always in eight value mode, with the first value the larger
+    void WriteBc4Values(const BlockFit& fit, uint8_t* output)
+    {
+        uint8_t value0 = static_cast<uint8_t>(fit.start[0]);
+        uint8_t value1 = static_cast<uint8_t>(fit.end[0]);
+        const bool reversed = value0 < value1;
+        if (reversed)
+        {
+            std::swap(value0, value1);
+        }
+
+        uint64_t bits = 0;
+        if (value0 != value1)
+        {
+            for (uint32_t texel = 0; texel < BlockTexelCount; ++texel)
+            {
+                const uint32_t index = reversed ? 7 - fit.indices[texel] : fit.indices[texel];
+                const uint64_t code = index == 0 ? 0 : (index == 7 ? 1 : index + 1);
+                bits |= code << (texel * 3);
+            }
+        }
+
+        output[0] = value0;
+        output[1] = value1;
+        for (uint32_t i = 0; i < 6; ++i)
+        {
+            output[2 + i] = static_cast<uint8_t>(bits >> (i * 8));
+        }
+    }
+
+    // BC7 fields are packed from the lowest bit of the first byte up
+    struct BitWriter
+    {
+        uint8_t* bytes;
+        uint32_t position = 0;
+
+        void Write(uint32_t value, uint32_t bitCount)
+        {
+            for (uint32_t bit = 0; bit < bitCount; ++bit, ++position)
+            {
+                bytes[position / 8] |= static_cast<uint8_t>(((value >> bit) & 1) << (position % 8));
+            }
+        }
+    };
+
+    struct BitReader
+    {
+        const uint8_t* bytes;
+        uint32_t position = 0;
+
+        uint32_t Read(uint32_t bitCount)
+        {
+            uint32_t value = 0;
+            for (uint32_t bit = 0; bit < bitCount; ++bit, ++position)
+            {
+                value |= ((bytes[position / 8] >> (position % 8)) & 1u) << bit;
+            }
+            return value;
+        }
+    };
+
+    // Mode 6: one subset with RGBA endpoints and 4-bit indices
+    void WriteBc7Mode6(const BlockFit& fit, uint8_t* output)
+    {
+        // Snapped endpoints carry their shared bit as the lowest
+        uint32_t endpoints[2][4];
+        for (int c = 0; c < 4; ++c)
+        {
+            endpoints[0][c] = static_cast<uint32_t>(fit.start[c]);
+            endpoints[1][c] = static_cast<uint32_t>(fit.end[c]);
+        }
+
+        // The first texel's index has an implied top bit of zero
+        const bool reversed = fit.indices[0] >= 8;
+        const uint32_t first = reversed ? 1 : 0;
+
+        std::memset(output, 0, 16);
+        BitWriter writer{ output };
+        writer.Write(1u << 6, 7);
+        for (int c = 0; c < 4; ++c)
+        {
+            writer.Write(endpoints[first][c] >> 1, 7);
+            writer.Write(endpoints[1 - first][c] >> 1, 7);
+        }
+        writer.Write(endpoints[first][0] & 1, 1);
+        writer.Write(endpoints[1 - first][0] & 1, 1);
+        for (uint32_t texel = 0; texel < BlockTexelCount; ++texel)
+        {
+            const uint32_t index = reversed ? 15 - fit.indices[texel] : fit.indices[texel];
+            writer.Write(index, texel == 0 ? 3 : 4);
+        }
+    }
+
+    // Mode 5: one subset with 7-bit colour and 8-bit alpha endpoints, each with its own 2-bit indices
+    void WriteBc7Mode5(const BlockFit& color, const BlockFit& alpha, uint8_t* output)
+    {
+        // The first texel's indices have an implied top bit of zero
+        const bool colorReversed = color.indices[0] >= 2;
+        const bool alphaReversed = alpha.indices[0] >= 2;
+        const float* colorEndpoints[2] = { colorReversed ? color.end : color.start, colorReversed ? color.start : color.end };
+        const float* alphaEndpoints[2] = { alphaReversed ? alpha.end : alpha.start, alphaReversed ? alpha.start : alpha.end };
+
+        std::memset(output, 0, 16);
+        BitWriter writer{ output };
+        writer.Write(1u << 5, 6);
+        writer.Write(0, 2); // No channel rotation
+        for (int c = 0; c < 3; ++c)
+        {
+            writer.Write(static_cast<uint32_t>(colorEndpoints[0][c]) >> 1, 7);
+            writer.Write(static_cast<uint32_t>(colorEndpoints[1][c]) >> 1, 7);
+        }
+        writer.Write(static_cast<uint32_t>(alphaEndpoints[0][0]), 8);
+        writer.Write(static_cast<uint32_t>(alphaEndpoints[1][0]), 8);
+        for (uint32_t texel = 0; texel < BlockTexelCount; ++texel)
+        {
+            writer.Write(colorReversed ? 3 - color.indices[texel] : color.indices[texel], texel == 0 ? 1 : 2);
+        }
+        for (uint32_t texel = 0; texel < BlockTexelCount; ++texel)
+        {
+            writer.Write(alphaReversed ? 3 - alpha.indices[texel] : alpha.indices[texel], texel == 0 ? 1 : 2);
+        }
+    }
+
+    // Mode 1: two subsets with 6-bit colour endpoints, a p-bit per subset and 3-bit indices; alpha is opaque
+    void WriteBc7Mode1(uint32_t partition, const BlockFit (&subsets)[2], uint8_t* output)
+    {
+        const uint32_t mask = Bc7Partitions2[partition];
+        const uint32_t anchors[2] = { 0, Bc7Anchors2[partition] };
+
+        // Snapped endpoints carry their subset's p-bit below the six stored bits. Each subset's
+        // anchor index has an implied top bit of zero.
+        uint32_t endpoints[2][2][3];
+        uint32_t pBits[2];
+        bool reversed[2];
+        for (uint32_t subset = 0; subset < 2; ++subset)
+        {
+            const BlockFit& fit = subsets[subset];
+            reversed[subset] = fit.indices[anchors[subset]] >= 4;
+            for (int c = 0; c < 3; ++c)
+            {
+                endpoints[subset][0][c] = static_cast<uint32_t>(reversed[subset] ? fit.end[c] : fit.start[c]) >> 2;
+                endpoints[subset][1][c] = static_cast<uint32_t>(reversed[subset] ? fit.start[c] : fit.end[c]) >> 2;
+            }
+            pBits[subset] = (static_cast<uint32_t>(fit.start[0]) >> 1) & 1;
+        }
+
+        std::memset(output, 0, 16);
+        BitWriter writer{ output };
+        writer.Write(1u << 1, 2);
+        writer.Write(partition, 6);
+        for (int c = 0; c < 3; ++c)
+        {
+            for (uint32_t subset = 0; subset < 2; ++subset)
+            {
+                writer.Write(endpoints[subset][0][c], 6);
+                writer.Write(endpoints[subset][1][c], 6);
+            }
+        }
+        writer.Write(pBits[0], 1);
+        writer.Write(pBits[1], 1);
+        for (uint32_t texel = 0; texel < BlockTexelCount; ++texel)
+        {
+            const uint32_t subset = HasTexel(mask, texel) ? 1 : 0;
+            const uint32_t index = subsets[subset].indices[texel];
+            writer.Write(reversed[subset] ? 7 - index : index, texel == anchors[subset] ? 2 : 3);
+        }
+    }
+
+    // An endpoint channel of bits bits, expanded to eight by repeating its top bits
+    uint32_t ExpandBits(uint32_t value, uint32_t bits)
+    {
+        return (value << (8 - bits)) | (value >> (2 * bits - 8));
+    }
+
+    uint8_t Interpolate(uint32_t start, uint32_t end, uint32_t weight)
+    {
+        return static_cast<uint8_t>(((64 - weight) * start + weight * end + 32) >> 6);
+    }
+
+    void DecodeBc7Mode1(BitReader& reader, RgbaBlock& block)
+    {
+        reader.Read(2);
+        const uint32_t partition = reader.Read(6);
+        uint32_t endpoints[2][2][3];
+        for (int c = 0; c < 3; ++c)
+        {
+            for (uint32_t subset = 0; subset < 2; ++subset)
+            {
+                endpoints[subset][0][c] = reader.Read(6) << 1;
+                endpoints[subset][1][c] = reader.Read(6) << 1;
+            }
+        }
+        for (uint32_t subset = 0; subset < 2; ++subset)
+        {
+            const uint32_t pBit = reader.Read(1);
+            for (int c = 0; c < 3; ++c)
+            {
+                endpoints[subset][0][c] = ExpandBits(endpoints[subset][0][c] | pBit, 7);
+                endpoints[subset][1][c] = ExpandBits(endpoints[subset][1][c] | pBit, 7);
+            }
+        }
+
+        for (uint32_t texel = 0; texel < BlockTexelCount; ++texel)
+        {
+            const uint32_t subset = HasTexel(Bc7Partitions2[partition], texel) ? 1 : 0;
+            const bool anchor = texel == 0 || texel == Bc7Anchors2[partition];
+            const uint32_t weight = Bc7Weights3[reader.Read(anchor ? 2 : 3)];
+            for (int c = 0; c < 3; ++c)
+            {
+                block[texel][c] = Interpolate(endpoints[subset][0][c], endpoints[subset][1][c], weight);
+            }
+            block[texel][3] = 255;
+        }
+    }
+
+    void DecodeBc7Mode5(BitReader& reader, RgbaBlock& block)
+    {
+        reader.Read(6);
+        const uint32_t rotation = reader.Read(2);
+        uint32_t endpoints[2][4];
+        for (int c = 0; c < 3; ++c)
+        {
+            endpoints[0][c] = ExpandBits(reader.Read(7), 7);
+            endpoints[1][c] = ExpandBits(reader.Read(7), 7);
+        }
+        endpoints[0][3] = reader.Read(8);
+        endpoints[1][3] = reader.Read(8);
+
+        for (uint32_t texel = 0; texel < BlockTexelCount; ++texel)
+        {
+            const uint32_t weight = Bc7Weights2[reader.Read(texel == 0 ? 1 : 2)];
+            for (int c = 0; c < 3; ++c)
+            {
+                block[texel][c] = Interpolate(endpoints[0][c], endpoints[1][c], weight);
+            }
+        }
+        for (uint32_t texel = 0; texel < BlockTexelCount; ++texel)
+        {
+            const uint32_t weight = Bc7Weights2[reader.Read(texel == 0 ? 1 : 2)];
+            block[texel][3] = Interpolate(endpoints[0][3], endpoints[1][3], weight);
+            if (rotation != 0)
+            {
+                std::swap(block[texel][rotation - 1], block[texel][3]);
+            }
+        }
+    }
+
+    void DecodeBc7Mode6(BitReader& reader, RgbaBlock& block)
+    {
+        reader.Read(7);
+        uint32_t endpoints[2][4];
+        for (int c = 0; c < 4; ++c)
+        {
+            endpoints[0][c] = reader.Read(7) << 1;
+            endpoints[1][c] = reader.Read(7) << 1;
+        }
+        const uint32_t pBit0 = reader.Read(1);
+        const uint32_t pBit1 = reader.Read(1);
+        for (int c = 0; c < 4; ++c)
+        {
+            endpoints[0][c] |= pBit0;
+            endpoints[1][c] |= pBit1;
+        }
+
+        for (uint32_t texel = 0; texel < BlockTexelCount; ++texel)
+        {
+            const uint32_t weight = Bc7Weights4[reader.Read(texel == 0 ? 3 : 4)];
+            for (int c = 0; c < 4; ++c)
+            {
+                block[texel][c] = Interpolate(endpoints[0][c], endpoints[1][c], weight);
+            }
+        }
+    }
+
+    // A block's mode is the position of the lowest set bit of its first byte
+    void DecodeBc7Block(const uint8_t* input, RgbaBlock& block)
+    {
+        std::memset(block, 0, sizeof(RgbaBlock));
+        BitReader reader{ input };
+        if ((input[0] & 0x03) == 0x02)
+        {
+            DecodeBc7Mode1(reader, block);
+        }
+        else if ((input[0] & 0x3F) == 0x20)
+        {
+            DecodeBc7Mode5(reader, block);
+        }
+        else if ((input[0] & 0x7F) == 0x40)
+        {
+            DecodeBc7Mode6(reader, block);
+        }
+    }
+
+    // Squared error of a BC7 block as it decodes, over all four channels
+    uint32_t MeasureBc7Error(const uint8_t* encoded, const RgbaBlock& block)
+    {
+        RgbaBlock decoded;
+        DecodeBc7Block(encoded, decoded);
+        uint32_t error = 0;
+        for (uint32_t texel = 0; texel < BlockTexelCount; ++texel)
+        {
+            for (int c = 0; c < 4; ++c)
+            {
+                const int difference = static_cast<int>(decoded[texel][c]) - static_cast<int>(block[texel][c]);
+                error += static_cast<uint32_t>(difference * difference);
+            }
+        }
+        return error;
+    }
+
+    // Sums and products of a set of RGB texels: xx, xy, xz, yy, yz, zz
+    struct TexelMoments
+    {
+        float count = 0.0f;
+        float sum[3] = {};
+        float product[6] = {};
+    };
+
+    // What is left of a set of texels' spread once their principal axis is taken out: how far they
+    // are from lying on the line a subset's endpoints can reach
+    float EstimateLineResidual(const TexelMoments& moments)
+    {
+        if (moments.count < 2.0f)
+        {
+            return 0.0f;
+        }
+
+        float covariance[3][3];
+        for (int i = 0, k = 0; i < 3; ++i)
+        {
+            for (int j = i; j < 3; ++j, ++k)
+            {
+                covariance[i][j] = covariance[j][i] = moments.product[k] - moments.sum[i] * moments.sum[j] / moments.count;
+            }
+        }
+
+        float axis[3] = { 1.0f, 1.0f, 1.0f };
+        for (uint32_t iteration = 0; iteration < PowerIterations; ++iteration)
+        {
+            float next[3] = {};
+            float largest = 0.0f;
+            for (int i = 0; i < 3; ++i)
+            {
+                for (int j = 0; j < 3; ++j)
+                {
+                    next[i] += covariance[i][j] * axis[j];
+                }
+                largest = std::max(largest, std::abs(next[i]));
+            }
+            if (largest == 0.0f)
+            {
+                return 0.0f;
+            }
+            for (int i = 0; i < 3; ++i)
+            {
+                axis[i] = next[i] / largest;
+            }
+        }
+
+        float spread = 0.0f;
+        float length = 0.0f;
+        for (int i = 0; i < 3; ++i)
+        {
+            for (int j = 0; j < 3; ++j)
+            {
+                spread += axis[i] * covariance[i][j] * axis[j];
+            }
+            length += axis[i] * axis[i];
+        }
+        const float trace = covariance[0][0] + covariance[1][1] + covariance[2][2];
+        return std::max(trace - spread / length, 0.0f);
+    }
+
+    // Orders mode 1's partitions by how well each subset lies on a line, best first
+    void RankBc7Partitions(const RgbaBlock& block, uint32_t* partitions, uint32_t count)
+    {
+        TexelMoments texelMoments[BlockTexelCount];
+        TexelMoments total;
+        for (uint32_t texel = 0; texel < BlockTexelCount; ++texel)
+        {
+            TexelMoments& moments = texelMoments[texel];
+            moments.count = 1.0f;
+            for (int i = 0, k = 0; i < 3; ++i)
+            {
+                moments.sum[i] = block[texel][i];
+                for (int j = i; j < 3; ++j, ++k)
+                {
+                    moments.product[k] = static_cast<float>(block[texel][i]) * block[texel][j];
+                }
+            }
+
+            total.count += moments.count;
+            for (int i = 0; i < 3; ++i)
+            {
+                total.sum[i] += moments.sum[i];
+            }
+            for (int k = 0; k < 6; ++k)
+            {
+                total.product[k] += moments.product[k];
+            }
+        }
+
+        float estimates[64];
+        for (uint32_t partition = 0; partition < 64; ++partition)
+        {
+            TexelMoments second;
+            for (uint32_t texel = 0; texel < BlockTexelCount; ++texel)
+            {
+                if (HasTexel(Bc7Partitions2[partition], texel))
+                {
+                    second.count += 1.0f;
+                    for (int i = 0; i < 3; ++i)
+                    {
+                        second.sum[i] += texelMoments[texel].sum[i];
+                    }
+                    for (int k = 0; k < 6; ++k)
+                    {
+                        second.product[k] += texelMoments[texel].product[k];
+                    }
+                }
+            }
+
+            TexelMoments first = total;
+            first.count -= second.count;
+            for (int i = 0; i < 3; ++i)
+            {
+                first.sum[i] -= second.sum[i];
+            }
+            for (int k = 0; k < 6; ++k)
+            {
+                first.product[k] -= second.product[k];
+            }
+            estimates[partition] = EstimateLineResidual(first) + EstimateLineResidual(second);
+        }
+
+        uint32_t order[64];
+        for (uint32_t partition = 0; partition < 64; ++partition)
+        {
+            order[partition] = partition;
+        }
+        std::partial_sort(order, order + count, order + 64, [&](uint32_t a, uint32_t b)
+        {
+            return estimates[a] < estimates[b] || (estimates[a] == estimates[b] && a < b);
+        });
+        std::copy(order, order + count, partitions);
+    }
+
+    // Tries mode 6, mode 5 and, on opaque blocks, mode 1, keeping whichever decodes closest. Mode 6
+    // suits smooth colour, mode 5 alpha that varies apart from the colour, and mode 1 blocks with
+    // two distinct colours.
+    void EncodeBc7Block(TextureEncodeQuality quality, const RgbaBlock& block, Detail::FitBlockIndicesFunction fitIndices, uint8_t* output)
+    {
+        WriteBc7Mode6(FitBlock(SelectChannels(block, 0, 4), Bc7Mode6Codec, quality, fitIndices), output);
+        uint32_t bestError = MeasureBc7Error(output, block);
+
+        uint8_t candidate[16];
+        auto keepIfCloser = [&]
+        {
+            const uint32_t error = MeasureBc7Error(candidate, block);
+            if (error < bestError)
+            {
+                bestError = error;
+                std::memcpy(output, candidate, sizeof(candidate));
+            }
+        };
+
+        const BlockTexels color = SelectChannels(block, 0, 3);
+        if (bestError != 0)
+        {
+            WriteBc7Mode5(FitBlock(color, Bc7Mode5ColorCodec, quality, fitIndices), FitBlock(SelectChannels(block, 3, 1), Bc7Mode5AlphaCodec, quality, fitIndices),
+                          candidate);
+            keepIfCloser();
+        }
+
+        const bool opaque = std::all_of(std::begin(block), std::end(block), [](const uint8_t* texel) { return texel[3] == 255; });
+        if (bestError == 0 || !opaque)
+        {
+            return;
+        }
+
+        uint32_t partitions[64];
+        const uint32_t candidates = GetBc7PartitionCandidates(quality);
+        RankBc7Partitions(block, partitions, candidates);
+        for (uint32_t i = 0; i < candidates; ++i)
+        {
+            const uint32_t mask = Bc7Partitions2[partitions[i]];
+            const BlockFit subsets[2] = {
+                FitBlock(color, Bc7Mode1Codec, quality, fitIndices, ~mask & AllTexels),
+                FitBlock(color, Bc7Mode1Codec, quality, fitIndices, mask),
+            };
+            WriteBc7Mode1(partitions[i], subsets, candidate);
+            keepIfCloser();
+        }
+    }
+
+    void EncodeBlock(TextureFormat format, TextureEncodeQuality quality, const RgbaBlock& block, Detail::FitBlockIndicesFunction fitIndices, uint8_t* output)
+    {
+        switch (format)
+        {
+        case TextureFormat::Bc1RgbaUnorm:
+        case TextureFormat::Bc1RgbaSrgb:
+            WriteBc1Colors(FitBlock(SelectChannels(block, 0, 3), Bc1Codec, quality, fitIndices), output);
+            break;
+        case TextureFormat::Bc3Unorm:
+        case TextureFormat::Bc3Srgb:
+            WriteBc4Values(FitBlock(SelectChannels(block, 3, 1), Bc4Codec, quality, fitIndices), output);
+            WriteBc1Colors(FitBlock(SelectChannels(block, 0, 3), Bc1Codec, quality, fitIndices), output + 8);
+            break;
+        case TextureFormat::Bc4Unorm:
+            WriteBc4Values(FitBlock(SelectChannels(block, 0, 1), Bc4Codec, quality, fitIndices), output);
+            break;
+        case TextureFormat::Bc5Unorm:
+            WriteBc4Values(FitBlock(SelectChannels(block, 0, 1), Bc4Codec, quality, fitIndices), output);
+            WriteBc4Values(FitBlock(SelectChannels(block, 1, 1), Bc4Codec, quality, fitIndices), output + 8);
+            break;
+        default:
+            EncodeBc7Block(quality, block, fitIndices, output);
+            break;
+        }
+    }
+
+    void Expand565(uint16_t color, uint32_t* rgb)
+    {
+        const uint32_t red = (color >> 11) & 31;
+        const uint32_t green = (color >> 5) & 63;
+        const uint32_t blue = color & 31;
+        rgb[0] = (red << 3) | (red >> 2);
+        rgb[1] = (green << 2) | (green >> 4);
+        rgb[2] = (blue << 3) | (blue >> 2);
+    }
+
+    void DecodeBc1Colors(const uint8_t* input, bool fourColors, RgbaBlock& block)
+    {
+        uint16_t color0;
+        uint16_t color1;
+        uint32_t bits;
+        std::memcpy(&color0, input, sizeof(color0));
+        std::memcpy(&color1, input + 2, sizeof(color1));
+        std::memcpy(&bits, input + 4, sizeof(bits));
+
+        uint32_t palette[4][4] = {};
+        Expand565(color0, palette[0]);
+        Expand565(color1, palette[1]);
+        palette[0][3] = palette[1][3] = palette[2][3] = 255;
+
+        // Interpolants round to nearest, closer to what GPUs sample than truncating
+        if (fourColors || color0 > color1)
+        {
+            palette[3][3] = 255;
+            for (int c = 0; c < 3; ++c)
+            {
+                palette[2][c] = (2 * palette[0][c] + palette[1][c] + 1) / 3;
+                palette[3][c] = (palette[0][c] + 2 * palette[1][c] + 1) / 3;
+            }
+        }
+        else
+        {
+            // Three colours and transparent black
+            for (int c = 0; c < 3; ++c)
+            {
+                palette[2][c] = (palette[0][c] + palette[1][c] + 1) / 2;
+            }
+        }
+
+        for (uint32_t texel = 0; texel < BlockTexelCount; ++texel)
+        {
+            const uint32_t* color = palette[(bits >> (texel * 2)) & 3];
+            for (int c = 0; c < 4; ++c)
+            {
+                block[texel][c] = static_cast<uint8_t>(color[c]);
+            }
+        }
+    }
+
+    void DecodeBc4Values(const uint8_t* input, RgbaBlock& block, uint32_t channel)
+    {
+        uint32_t palette[8];
+        palette[0] = input[0];
+        palette[1] = input[1];
+        if (palette[0] > palette[1])
+        {
+            for (uint32_t i = 1; i < 7; ++i)
+            {
+                palette[i + 1] = ((7 - i) * palette[0] + i * palette[1] + 3) / 7;
+            }
+        }
+        else
+        {
+            for (uint32_t i = 1; i < 5; ++i)
+            {
+                palette[i + 1] = ((5 - i) * palette[0] + i * palette[1] + 2) / 5;
+            }
+            palette[6] = 0;
+            palette[7] = 255;
+        }
+
+        uint64_t bits = 0;
+        for (uint32_t i = 0; i < 6; ++i)
+        {
+            bits |= static_cast<uint64_t>(input[2 + i]) << (i * 8);
+        }
+        for (uint32_t texel = 0; texel < BlockTexelCount; ++texel)
+        {
+            block[texel][channel] = static_cast<uint8_t>(palette[(bits >> (texel * 3)) & 7]);
+        }
+    }
+}
+
+const char* MiniEngine::Graphics::ToString(TextureEncodeQuality quality)
+{
+    switch (quality)
+    {
+    case TextureEncodeQuality::Fast:   return "fast";
+    case TextureEncodeQuality::Normal: return "normal";
+    case TextureEncodeQuality::High:   return "high";
+    }
+    return "unknown";
+}
+
+bool MiniEngine::Graphics::CanEncodeTexture(TextureFormat format)
+{
+    switch (format)
+    {
+    case TextureFormat::Bc1RgbaUnorm:
+    case TextureFormat::Bc1RgbaSrgb:
+    case TextureFormat::Bc3Unorm:
+    case TextureFormat::Bc3Srgb:
+    case TextureFormat::Bc4Unorm:
+    case TextureFormat::Bc5Unorm:
+    case TextureFormat::Bc7Unorm:
+    case TextureFormat::Bc7Srgb:
+        return true;
+    default:
+        return false;
+    }
+}
+
+uint32_t MiniEngine::Graphics::GetEncodedChannelCount(TextureFormat format)
+{
+    switch (format)
+    {
+    case TextureFormat::Bc1RgbaUnorm:
+    case TextureFormat::Bc1RgbaSrgb:
+        return 3;
+    case TextureFormat::Bc4Unorm:
+        return 1;
+    case TextureFormat::Bc5Unorm:
+        return 2;
+    default:
+        return 4;
+    }
+}
+
+TextureEncoder::TextureEncoder()
+    : TextureEncoder(Core::GetSupportedSimdLevel())
+{
+}
+
+TextureEncoder::TextureEncoder(Core::SimdLevel simdLevel)
+{
+    SetSimdLevel(simdLevel);
+}
+
+void TextureEncoder::SetSimdLevel(Core::SimdLevel simdLevel)
+{
+    m_SimdLevel = std::min(simdLevel, Core::GetSupportedSimdLevel());
+
+    spdlog::debug("Texture encoder using {} kernels", Core::ToString(m_SimdLevel));
+}
+
+void TextureEncoder::Encode(TextureFormat format, TextureEncodeQuality quality, const uint8_t* rgba, uint32_t width, uint32_t height, void* destination,
+                            Core::JobSystem* jobs) const
+{
+    if (!CanEncodeTexture(format))
+    {
+        throw std::invalid_argument(std::string("Cannot encode textures as ") + ToString(format));
+    }
+    if (width == 0 || height == 0)
+    {
+        throw std::invalid_argument("Textures to encode need at least one texel");
+    }
+
+    const uint32_t blocksX = (width + 3) / 4;
+    const uint32_t blocksY = (height + 3) / 4;
+    const uint32_t bytesPerBlock = GetBytesPerBlock(format);
+    const Detail::FitBlockIndicesFunction fitIndices = GetKernel(m_SimdLevel);
+    uint8_t* output = static_cast<uint8_t*>(destination);
+
+    auto encodeRows = [&](size_t begin, size_t end)
+    {
+        RgbaBlock block;
+        for (size_t blockY = begin; blockY < end; ++blockY)
+        {
+            for (uint32_t blockX = 0; blockX < blocksX; ++blockX)
+            {
+                LoadBlock(rgba, width, height, blockX, static_cast<uint32_t>(blockY), block);
+                EncodeBlock(format, quality, block, fitIndices, output + (blockY * blocksX + blockX) * bytesPerBlock);
+            }
+        }
+    };
+
+    if (jobs)
+    {
+        jobs->ParallelFor(blocksY, 1, encodeRows);
+    }
+    else
+    {
+        encodeRows(0, blocksY);
+    }
+}
+
+void MiniEngine::Graphics::DecodeTexture(TextureFormat format, const void* blocks, uint32_t width, uint32_t height, uint8_t* rgba)
+{
+    if (!CanEncodeTexture(format))
+    {
+        throw std::invalid_argument(std::string("Cannot decode textures in ") + ToString(format));
+    }
+
+    const uint32_t blocksX = (width + 3) / 4;
+    const uint32_t blocksY = (height + 3) / 4;
+    const uint32_t bytesPerBlock = GetBytesPerBlock(format);
+    const uint8_t* input = static_cast<const uint8_t*>(blocks);
+
+    RgbaBlock block;
+    for (uint32_t blockY = 0; blockY < blocksY; ++blockY)
+    {
+        for (uint32_t blockX = 0; blockX < blocksX; ++blockX, input += bytesPerBlock)
+        {
+            switch (format)
+            {
+            case TextureFormat::Bc1RgbaUnorm:
+            case TextureFormat::Bc1RgbaSrgb:
+                DecodeBc1Colors(input, false, block);
+                break;
+            case TextureFormat::Bc3Unorm:
+            case TextureFormat::Bc3Srgb:
+                DecodeBc1Colors(input + 8, true, block);
+                DecodeBc4Values(input, block, 3);
+                break;
+            case TextureFormat::Bc4Unorm:
+            case TextureFormat::Bc5Unorm:
+                for (uint32_t texel = 0; texel < BlockTexelCount; ++texel)
+                {
+                    block[texel][0] = block[texel][1] = block[texel][2] = 0;
+                    block[texel][3] = 255;
+                }
+                DecodeBc4Values(input, block, 0);
+                if (format == TextureFormat::Bc5Unorm)
+                {
+                    DecodeBc4Values(input + 8, block, 1);
+                }
+                break;
+            default:
+                DecodeBc7Block(input, block);
+                break;
+            }
+
+            for (uint32_t y = 0; y < 4 && blockY * 4 + y < height; ++y)
+            {
+                for (uint32_t x = 0; x < 4 && blockX * 4 + x < width; ++x)
+                {
+                    std::memcpy(rgba + ((static_cast<size_t>(blockY) * 4 + y) * width + blockX * 4 + x) * 4, block[y * 4 + x], 4);
+                }
+            }
+        }
+    }
+}
+
+double MiniEngine::Graphics::ComputePsnr(const uint8_t* reference, const uint8_t* image, uint32_t width, uint32_t height, uint32_t channelCount)
+{
+    const size_t texelCount = static_cast<size_t>(width) * height;
+    uint64_t squaredError = 0;
+    for (size_t texel = 0; texel < texelCount; ++texel)
+    {
+        for (uint32_t c = 0; c < channelCount; ++c)
+        {
+            const int32_t difference = static_cast<int32_t>(reference[texel * 4 + c]) - static_cast<int32_t>(image[texel * 4 + c]);
+            squaredError += static_cast<uint64_t>(difference * difference);
+        }
+    }
+
+    if (squaredError == 0)
+    {
+        return std::numeric_limits<double>::infinity();
+    }
+    const double meanSquaredError = static_cast<double>(squaredError) / (static_cast<double>(texelCount) * channelCount);
+    return 10.0 * std::log10(255.0 * 255.0 / meanSquaredError);
+}
@@ -0,0 +1,42 @@
+#include "TextureEncoderKernels.hpp"
+
+using namespace MiniEngine::Graphics;
+
+void Detail::FitBlockIndicesScalar(const BlockTexels& texels, const float* start, const float* end, uint32_t steps, uint8_t* indices, float* errors)
+{
+    float direction[4];
+    float lengthSquared = 0.0f;
+    for (int c = 0; c < 4; ++c)
+    {
+        direction[c] = end[c] - start[c];
+        lengthSquared += direction[c] * direction[c];
+    }
+
+    const float last = static_cast<float>(steps - 1);
+    const float scale = lengthSquared > 0.0f ? last / lengthSquared : 0.0f;
+
+    for (uint32_t texel = 0; texel < BlockTexelCount; ++texel)
+    {
+        float offset[4];
+        float projection = 0.0f;
+        for (int c = 0; c < 4; ++c)
+        {
+            offset[c] = texels.channel[c][texel] - start[c];
+            projection += offset[c] * direction[c];
+        }
+
+        float step = projection * scale + 0.5f;
+        step = step < 0.0f ? 0.0f : (step > last ? last : step);
+        const uint32_t index = static_cast<uint32_t>(step);
+        indices[texel] = static_cast<uint8_t>(index);
+
+        const float weight = static_cast<float>(index) / last;
+        float error = 0.0f;
+        for (int c = 0; c < 4; ++c)
+        {
+            const float difference = offset[c] - direction[c] * weight;
+            error += difference * difference;
+        }
+        errors[texel] = error;
+    }
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+// Private to MiniEngine: shared by the per-instruction-set kernel translation units.
+// Kept free of glm and the standard library so the AVX2 unit cannot leak wide
+// instructions into inline functions that other units also instantiate.
+
+#include <cstddef>
+#include <cstdint>
+
+namespace MiniEngine::Graphics::Detail
+{
+    constexpr uint32_t BlockTexelCount = 16;
+
+    // A 4x4 block split by channel, in texel order, values from 0 to 255. Channels a fit does not
+    // use are left at zero, in the texels and in the endpoints alike.
+    struct BlockTexels
+    {
+        alignas(32) float channel[4][BlockTexelCount];
+    };
+
+    // Gives each texel the index of the nearest of steps points spread evenly from start to end and
+    // its squared distance to that point. The points lie on a line, so the nearest is found by
+    // projecting onto it. steps is at least 2; indices and errors have room for BlockTexelCount
+    // entries.
+    //
+    // Every kernel evaluates the same expressions in the same order, without fused multiply-adds
+    // (the kernel sources are built with contraction off), so they agree to the bit. Errors are
+    // returned per texel for the same reason: the caller sums them in a fixed order, which then no
+    // longer depends on how many texels a kernel handles at once.
+    using FitBlockIndicesFunction = void (*)(const BlockTexels& texels, const float* start, const float* end, uint32_t steps, uint8_t* indices, float* errors);
+
+    void FitBlockIndicesScalar(const BlockTexels& texels, const float* start, const float* end, uint32_t steps, uint8_t* indices, float* errors);
+    void FitBlockIndicesSse(const BlockTexels& texels, const float* start, const float* end, uint32_t steps, uint8_t* indices, float* errors);
+    void FitBlockIndicesAvx2(const BlockTexels& texels, const float* start, const float* end, uint32_t steps, uint8_t* indices, float* errors);
+}
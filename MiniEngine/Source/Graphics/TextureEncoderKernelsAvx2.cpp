@@ -0,0 +1,71 @@
+#include "TextureEncoderKernels.hpp"
+
+#include "MiniEngine/Core/CpuFeatures.hpp"
+
+#if MINIENGINE_SIMD_X86
+#include <immintrin.h>
+#endif
+
+using namespace MiniEngine::Graphics;
+
+#if MINIENGINE_SIMD_X86
+
+void Detail::FitBlockIndicesAvx2(const BlockTexels& texels, const float* start, const float* end, uint32_t steps, uint8_t* indices, float* errors)
+{
+    __m256 startC[4];
+    __m256 directionC[4];
+    float lengthSquared = 0.0f;
+    for (int c = 0; c < 4; ++c)
+    {
+        const float direction = end[c] - start[c];
+        lengthSquared += direction * direction;
+        startC[c] = _mm256_set1_ps(start[c]);
+        directionC[c] = _mm256_set1_ps(direction);
+    }
+
+    const float last = static_cast<float>(steps - 1);
+    const __m256 lastV = _mm256_set1_ps(last);
+    const __m256 scale = _mm256_set1_ps(lengthSquared > 0.0f ? last / lengthSquared : 0.0f);
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 zero = _mm256_setzero_ps();
+
+    for (uint32_t texel = 0; texel < BlockTexelCount; texel += 8)
+    {
+        // Eight texels per instruction, one channel at a time. Separate multiplies and adds, not
+        // fused ones, so every product is rounded as the other kernels round it.
+        __m256 offset[4];
+        __m256 projection = zero;
+        for (int c = 0; c < 4; ++c)
+        {
+            offset[c] = _mm256_sub_ps(_mm256_load_ps(texels.channel[c] + texel), startC[c]);
+            projection = _mm256_add_ps(projection, _mm256_mul_ps(offset[c], directionC[c]));
+        }
+
+        const __m256 step = _mm256_min_ps(_mm256_max_ps(_mm256_add_ps(_mm256_mul_ps(projection, scale), half), zero), lastV);
+        const __m256i index = _mm256_cvttps_epi32(step);
+        const __m256 weight = _mm256_div_ps(_mm256_cvtepi32_ps(index), lastV);
+
+        __m256 error = zero;
+        for (int c = 0; c < 4; ++c)
+        {
+            const __m256 difference = _mm256_sub_ps(offset[c], _mm256_mul_ps(directionC[c], weight));
+            error = _mm256_add_ps(error, _mm256_mul_ps(difference, difference));
+        }
+        _mm256_storeu_ps(errors + texel, error);
+
+        // Narrow the eight 32-bit indices to bytes: pack to 16 bits within each half, then gather the halves
+        const __m256i words = _mm256_packs_epi32(index, index);
+        const __m256i bytes = _mm256_packus_epi16(words, words);
+        const __m256i ordered = _mm256_permutevar8x32_epi32(bytes, _mm256_setr_epi32(0, 4, 0, 4, 0, 4, 0, 4));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(indices + texel), _mm256_castsi256_si128(ordered));
+    }
+}
+
+#else
+
+void Detail::FitBlockIndicesAvx2(const BlockTexels& texels, const float* start, const float* end, uint32_t steps, uint8_t* indices, float* errors)
+{
+    FitBlockIndicesScalar(texels, start, end, steps, indices, errors);
+}
+
+#endif
@@ -0,0 +1,71 @@
+#include "TextureEncoderKernels.hpp"
+
+#include "MiniEngine/Core/CpuFeatures.hpp"
+
+#if MINIENGINE_SIMD_X86
+#include <emmintrin.h>
+#endif
+
+using namespace MiniEngine::Graphics;
+
+#if MINIENGINE_SIMD_X86
+
+void Detail::FitBlockIndicesSse(const BlockTexels& texels, const float* start, const float* end, uint32_t steps, uint8_t* indices, float* errors)
+{
+    __m128 startC[4];
+    __m128 directionC[4];
+    float lengthSquared = 0.0f;
+    for (int c = 0; c < 4; ++c)
+    {
+        const float direction = end[c] - start[c];
+        lengthSquared += direction * direction;
+        startC[c] = _mm_set1_ps(start[c]);
+        directionC[c] = _mm_set1_ps(direction);
+    }
+
+    const float last = static_cast<float>(steps - 1);
+    const __m128 lastV = _mm_set1_ps(last);
+    const __m128 scale = _mm_set1_ps(lengthSquared > 0.0f ? last / lengthSquared : 0.0f);
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 zero = _mm_setzero_ps();
+
+    for (uint32_t texel = 0; texel < BlockTexelCount; texel += 4)
+    {
+        // Four texels per instruction, one channel at a time
+        __m128 offset[4];
+        __m128 projection = zero;
+        for (int c = 0; c < 4; ++c)
+        {
+            offset[c] = _mm_sub_ps(_mm_load_ps(texels.channel[c] + texel), startC[c]);
+            projection = _mm_add_ps(projection, _mm_mul_ps(offset[c], directionC[c]));
+        }
+
+        const __m128 step = _mm_min_ps(_mm_max_ps(_mm_add_ps(_mm_mul_ps(projection, scale), half), zero), lastV);
+        const __m128i index = _mm_cvttps_epi32(step);
+        const __m128 weight = _mm_div_ps(_mm_cvtepi32_ps(index), lastV);
+
+        __m128 error = zero;
+        for (int c = 0; c < 4; ++c)
+        {
+            const __m128 difference = _mm_sub_ps(offset[c], _mm_mul_ps(directionC[c], weight));
+            error = _mm_add_ps(error, _mm_mul_ps(difference, difference));
+        }
+        _mm_storeu_ps(errors + texel, error);
+
+        alignas(16) int32_t lanes[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), index);
+        for (int lane = 0; lane < 4; ++lane)
+        {
+            indices[texel + lane] = static_cast<uint8_t>(lanes[lane]);
+        }
+    }
+}
+
+#else
+
+void Detail::FitBlockIndicesSse(const BlockTexels& texels, const float* start, const float* end, uint32_t steps, uint8_t* indices, float* errors)
+{
+    FitBlockIndicesScalar(texels, start, end, steps, indices, errors);
+}
+
+#endif
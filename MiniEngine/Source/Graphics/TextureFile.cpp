@@ -0,0 +1,677 @@
+#include "MiniEngine/Graphics/TextureFile.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cstring>
+
+using namespace MiniEngine::Graphics;
+
+namespace
+{
+    constexpr uint32_t MaxTextureSize = 16384;
+    constexpr uint64_t LevelAlignment = 16; // A multiple of every block size and of the 4 bytes buffer copies need
+
+    constexpr uint8_t Ktx2Identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+    constexpr uint32_t Ktx2HeaderSize = 80;
+    constexpr uint32_t Ktx2LevelIndexEntrySize = 24;
+
+    constexpr uint32_t DdsMagic = 0x20534444; // "DDS "
+    constexpr uint32_t DdsHeaderSize = 124;
+    constexpr uint32_t DdsDx10HeaderSize = 20;
+    constexpr uint32_t DdsFlagsMipMapCount = 0x20000;
+    constexpr uint32_t DdsPixelFormatFourCc = 0x4;
+    constexpr uint32_t DdsPixelFormatRgb = 0x40;
+    constexpr uint32_t DdsCaps2CubeOrVolume = 0x200 | 0x200000;
+    constexpr uint32_t DdsResourceDimensionTexture2D = 3;
+    constexpr uint32_t DdsMiscTextureCube = 0x4;
+
+    constexpr uint32_t MakeFourCc(char a, char b, char c, char d)
+    {
+        return static_cast<uint32_t>(a) | (static_cast<uint32_t>(b) << 8) | (static_cast<uint32_t>(c) << 16) | (static_cast<uint32_t>(d) << 24);
+    }
+
+    struct DxgiMapping
+    {
+        uint32_t      dxgiFormat;
+        TextureFormat format;
+    };
+
+    constexpr DxgiMapping DxgiMappings[] = {
+        { 28, TextureFormat::R8G8B8A8Unorm }, { 29, TextureFormat::R8G8B8A8Srgb },
+        { 87, TextureFormat::B8G8R8A8Unorm }, { 91, TextureFormat::B8G8R8A8Srgb },
+        { 71, TextureFormat::Bc1RgbaUnorm },  { 72, TextureFormat::Bc1RgbaSrgb },
+        { 74, TextureFormat::Bc2Unorm },      { 75, TextureFormat::Bc2Srgb },
+        { 77, TextureFormat::Bc3Unorm },      { 78, TextureFormat::Bc3Srgb },
+        { 80, TextureFormat::Bc4Unorm },      { 81, TextureFormat::Bc4Snorm },
+        { 83, TextureFormat::Bc5Unorm },      { 84, TextureFormat::Bc5Snorm },
+        { 95, TextureFormat::Bc6hUfloat },    { 96, TextureFormat::Bc6hSfloat },
+        { 98, TextureFormat::Bc7Unorm },      { 99, TextureFormat::Bc7Srgb },
+    };
+
+    TextureFormat FromDxgiFormat(uint32_t dxgiFormat)
+    {
+        for (const DxgiMapping& mapping : DxgiMappings)
+        {
+            if (mapping.dxgiFormat == dxgiFormat)
+            {
+                return mapping.format;
+            }
+        }
+        return TextureFormat::Undefined;
+    }
+
+    uint32_t ToDxgiFormat(TextureFormat format)
+    {
+        for (const DxgiMapping& mapping : DxgiMappings)
+        {
+            if (mapping.format == format)
+            {
+                return mapping.dxgiFormat;
+            }
+        }
+        return 0;
+    }
+
+    uint32_t ReadU32(const uint8_t* bytes)
+    {
+        uint32_t value;
+        std::memcpy(&value, bytes, sizeof(value));
+        return value;
+    }
+
+    uint64_t ReadU64(const uint8_t* bytes)
+    {
+        uint64_t value;
+        std::memcpy(&value, bytes, sizeof(value));
+        return value;
+    }
+
+    void AppendU32(std::vector<uint8_t>& bytes, uint32_t value)
+    {
+        const uint8_t* source = reinterpret_cast<const uint8_t*>(&value);
+        bytes.insert(bytes.end(), source, source + sizeof(value));
+    }
+
+    void AppendU64(std::vector<uint8_t>& bytes, uint64_t value)
+    {
+        const uint8_t* source = reinterpret_cast<const uint8_t*>(&value);
+        bytes.insert(bytes.end(), source, source + sizeof(value));
+    }
+
+    bool ReadAt(std::FILE* file, uint64_t offset, void* destination, uint64_t size)
+    {
+        return std::fseek(file, static_cast<long>(offset), SEEK_SET) == 0 && std::fread(destination, 1, size, file) == size;
+    }
+
+    // The Khronos data format descriptor KTX2 requires: one basic block describing the texel block and its samples
+    std::vector<uint8_t> MakeDataFormatDescriptor(TextureFormat format)
+    {
+        struct Sample
+        {
+            uint16_t bitOffset;
+            uint8_t  bitLength; // Minus one
+            uint8_t  channel;   // Channel type and qualifier bits
+            uint32_t upper;
+        };
+
+        constexpr uint8_t Alpha = 15;
+        constexpr uint8_t Linear = 0x10; // Alpha stays linear in sRGB formats
+        constexpr uint8_t Signed = 0x40;
+        constexpr uint8_t Float = 0x80;
+
+        const bool srgb = IsSrgb(format);
+        const uint8_t alpha = static_cast<uint8_t>(Alpha | (srgb ? Linear : 0));
+        uint8_t model = 1; // RGBSDA
+        std::vector<Sample> samples;
+        switch (format)
+        {
+        case TextureFormat::R8G8B8A8Unorm:
+        case TextureFormat::R8G8B8A8Srgb:
+            samples = { { 0, 7, 0, 255 }, { 8, 7, 1, 255 }, { 16, 7, 2, 255 }, { 24, 7, alpha, 255 } };
+            break;
+        case TextureFormat::B8G8R8A8Unorm:
+        case TextureFormat::B8G8R8A8Srgb:
+            samples = { { 0, 7, 2, 255 }, { 8, 7, 1, 255 }, { 16, 7, 0, 255 }, { 24, 7, alpha, 255 } };
+            break;
+        case TextureFormat::Bc1RgbaUnorm:
+        case TextureFormat::Bc1RgbaSrgb:
+            model = 128;
+            samples = { { 0, 63, 1, 0xFFFFFFFF } }; // Color with one bit of alpha
+            break;
+        case TextureFormat::Bc2Unorm:
+        case TextureFormat::Bc2Srgb:
+            model = 129;
+            samples = { { 0, 63, alpha, 0xFFFFFFFF }, { 64, 63, 0, 0xFFFFFFFF } };
+            break;
+        case TextureFormat::Bc3Unorm:
+        case TextureFormat::Bc3Srgb:
+            model = 130;
+            samples = { { 0, 63, alpha, 0xFFFFFFFF }, { 64, 63, 0, 0xFFFFFFFF } };
+            break;
+        case TextureFormat::Bc4Unorm:
+            model = 131;
+            samples = { { 0, 63, 0, 0xFFFFFFFF } };
+            break;
+        case TextureFormat::Bc4Snorm:
+            model = 131;
+            samples = { { 0, 63, Signed, 0x7FFFFFFF } };
+            break;
+        case TextureFormat::Bc5Unorm:
+            model = 132;
+            samples = { { 0, 63, 0, 0xFFFFFFFF }, { 64, 63, 1, 0xFFFFFFFF } };
+            break;
+        case TextureFormat::Bc5Snorm:
+            model = 132;
+            samples = { { 0, 63, Signed, 0x7FFFFFFF }, { 64, 63, 1 | Signed, 0x7FFFFFFF } };
+            break;
+        case TextureFormat::Bc6hUfloat:
+            model = 133;
+            samples = { { 0, 127, Float, 0x7F800000 } };
+            break;
+        case TextureFormat::Bc6hSfloat:
+            model = 133;
+            samples = { { 0, 127, Float | Signed, 0x7F800000 } };
+            break;
+        case TextureFormat::Bc7Unorm:
+        case TextureFormat::Bc7Srgb:
+            model = 134;
+            samples = { { 0, 127, 0, 0xFFFFFFFF } };
+            break;
+        default:
+            break;
+        }
+
+        const uint32_t blockSize = 24 + 16 * static_cast<uint32_t>(samples.size());
+        const uint8_t blockDimension = IsBlockCompressed(format) ? 3 : 0;
+
+        std::vector<uint8_t> bytes;
+        AppendU32(bytes, 4 + blockSize);
+        AppendU32(bytes, 0);                     // Khronos vendor, basic descriptor type
+        AppendU32(bytes, 2 | (blockSize << 16)); // Version 2
+        bytes.insert(bytes.end(), { model, 1, static_cast<uint8_t>(srgb ? 2 : 1), 0 }); // BT.709 primaries, sRGB or linear transfer
+        bytes.insert(bytes.end(), { blockDimension, blockDimension, 0, 0 });
+        bytes.insert(bytes.end(), { static_cast<uint8_t>(GetBytesPerBlock(format)), 0, 0, 0, 0, 0, 0, 0 });
+        for (const Sample& sample : samples)
+        {
+            AppendU32(bytes, sample.bitOffset | (static_cast<uint32_t>(sample.bitLength) << 16) | (static_cast<uint32_t>(sample.channel) << 24));
+            AppendU32(bytes, 0); // Sample position
+            AppendU32(bytes, (sample.channel & Signed) ? 0x80000000 : 0);
+            AppendU32(bytes, sample.upper);
+        }
+        return bytes;
+    }
+}
+
+const char* MiniEngine::Graphics::ToString(TextureFormat format)
+{
+    switch (format)
+    {
+    case TextureFormat::R8G8B8A8Unorm: return "RGBA8";
+    case TextureFormat::R8G8B8A8Srgb:  return "RGBA8 sRGB";
+    case TextureFormat::B8G8R8A8Unorm: return "BGRA8";
+    case TextureFormat::B8G8R8A8Srgb:  return "BGRA8 sRGB";
+    case TextureFormat::Bc1RgbaUnorm:  return "BC1";
+    case TextureFormat::Bc1RgbaSrgb:   return "BC1 sRGB";
+    case TextureFormat::Bc2Unorm:      return "BC2";
+    case TextureFormat::Bc2Srgb:       return "BC2 sRGB";
+    case TextureFormat::Bc3Unorm:      return "BC3";
+    case TextureFormat::Bc3Srgb:       return "BC3 sRGB";
+    case TextureFormat::Bc4Unorm:      return "BC4";
+    case TextureFormat::Bc4Snorm:      return "BC4 signed";
+    case TextureFormat::Bc5Unorm:      return "BC5";
+    case TextureFormat::Bc5Snorm:      return "BC5 signed";
+    case TextureFormat::Bc6hUfloat:    return "BC6H";
+    case TextureFormat::Bc6hSfloat:    return "BC6H signed";
+    case TextureFormat::Bc7Unorm:      return "BC7";
+    case TextureFormat::Bc7Srgb:       return "BC7 sRGB";
+    default:                           return "unknown";
+    }
+}
+
+bool MiniEngine::Graphics::IsBlockCompressed(TextureFormat format)
+{
+    return format >= TextureFormat::Bc1RgbaUnorm && format <= TextureFormat::Bc7Srgb;
+}
+
+bool MiniEngine::Graphics::IsSrgb(TextureFormat format)
+{
+    switch (format)
+    {
+    case TextureFormat::R8G8B8A8Srgb:
+    case TextureFormat::B8G8R8A8Srgb:
+    case TextureFormat::Bc1RgbaSrgb:
+    case TextureFormat::Bc2Srgb:
+    case TextureFormat::Bc3Srgb:
+    case TextureFormat::Bc7Srgb:
+        return true;
+    default:
+        return false;
+    }
+}
+
+uint32_t MiniEngine::Graphics::GetBytesPerBlock(TextureFormat format)
+{
+    switch (format)
+    {
+    case TextureFormat::R8G8B8A8Unorm:
+    case TextureFormat::R8G8B8A8Srgb:
+    case TextureFormat::B8G8R8A8Unorm:
+    case TextureFormat::B8G8R8A8Srgb:
+        return 4;
+    case TextureFormat::Bc1RgbaUnorm:
+    case TextureFormat::Bc1RgbaSrgb:
+    case TextureFormat::Bc4Unorm:
+    case TextureFormat::Bc4Snorm:
+        return 8;
+    case TextureFormat::Bc2Unorm:
+    case TextureFormat::Bc2Srgb:
+    case TextureFormat::Bc3Unorm:
+    case TextureFormat::Bc3Srgb:
+    case TextureFormat::Bc5Unorm:
+    case TextureFormat::Bc5Snorm:
+    case TextureFormat::Bc6hUfloat:
+    case TextureFormat::Bc6hSfloat:
+    case TextureFormat::Bc7Unorm:
+    case TextureFormat::Bc7Srgb:
+        return 16;
+    default:
+        return 0;
+    }
+}
+
+uint64_t MiniEngine::Graphics::GetTextureLevelSize(TextureFormat format, uint32_t width, uint32_t height)
+{
+    if (IsBlockCompressed(format))
+    {
+        return static_cast<uint64_t>((width + 3) / 4) * ((height + 3) / 4) * GetBytesPerBlock(format);
+    }
+    return static_cast<uint64_t>(width) * height * GetBytesPerBlock(format);
+}
+
+uint32_t MiniEngine::Graphics::GetFullMipCount(uint32_t width, uint32_t height)
+{
+    uint32_t count = 1;
+    for (uint32_t size = std::max(width, height); size > 1; size /= 2)
+    {
+        ++count;
+    }
+    return count;
+}
+
+TextureDescription MiniEngine::Graphics::MakeTextureDescription(TextureFormat format, uint32_t width, uint32_t height, uint32_t levelCount)
+{
+    TextureDescription description;
+    description.format = format;
+    description.width = width;
+    description.height = height;
+    description.levels.resize(std::clamp(levelCount, 1u, GetFullMipCount(width, height)));
+
+    uint64_t offset = 0;
+    for (size_t i = 0; i < description.levels.size(); ++i)
+    {
+        TextureLevel& level = description.levels[i];
+        level.width = std::max(width >> i, 1u);
+        level.height = std::max(height >> i, 1u);
+        level.size = GetTextureLevelSize(format, level.width, level.height);
+        level.dataOffset = offset;
+        offset = (offset + level.size + LevelAlignment - 1) & ~(LevelAlignment - 1);
+    }
+    description.dataSize = offset;
+    return description;
+}
+
+TextureFile::~TextureFile()
+{
+    Close();
+}
+
+bool TextureFile::Open(const std::filesystem::path& path)
+{
+    Close();
+    m_Path = path;
+
+#ifdef _WIN32
+    m_File = _wfopen(path.c_str(), L"rb");
+#else
+    m_File = std::fopen(path.c_str(), "rb");
+#endif
+    if (m_File == nullptr)
+    {
+        return Fail("cannot open the file");
+    }
+
+    std::error_code error;
+    m_FileSize = std::filesystem::file_size(path, error);
+    if (error)
+    {
+        return Fail("cannot read the file size");
+    }
+
+    uint8_t identifier[12] = {};
+    if (!ReadAt(m_File, 0, identifier, sizeof(identifier)))
+    {
+        return Fail("too short to be a texture");
+    }
+    if (std::memcmp(identifier, Ktx2Identifier, sizeof(Ktx2Identifier)) == 0)
+    {
+        return ParseKtx2();
+    }
+    if (ReadU32(identifier) == DdsMagic)
+    {
+        return ParseDds();
+    }
+    return Fail("neither KTX2 nor DDS");
+}
+
+void TextureFile::Close()
+{
+    if (m_File != nullptr)
+    {
+        std::fclose(m_File);
+        m_File = nullptr;
+    }
+    m_FileSize = 0;
+    m_Description = {};
+}
+
+bool TextureFile::ReadLevels(void* destination)
+{
+    if (m_File == nullptr)
+    {
+        return false;
+    }
+
+    uint8_t* bytes = static_cast<uint8_t*>(destination);
+    for (const TextureLevel& level : m_Description.levels)
+    {
+        if (!ReadAt(m_File, level.fileOffset, bytes + level.dataOffset, level.size))
+        {
+            return Fail("level data cut short");
+        }
+    }
+    return true;
+}
+
+bool TextureFile::ParseKtx2()
+{
+    uint8_t header[Ktx2HeaderSize];
+    if (!ReadAt(m_File, 0, header, sizeof(header)))
+    {
+        return Fail("KTX2 header cut short");
+    }
+
+    const TextureFormat format = static_cast<TextureFormat>(ReadU32(header + 12));
+    const uint32_t width = ReadU32(header + 20);
+    const uint32_t height = ReadU32(header + 24);
+    const uint32_t depth = ReadU32(header + 28);
+    const uint32_t layerCount = ReadU32(header + 32);
+    const uint32_t faceCount = ReadU32(header + 36);
+    const uint32_t levelCount = ReadU32(header + 40);
+    const uint32_t supercompression = ReadU32(header + 44);
+
+    if (GetBytesPerBlock(format) == 0)
+    {
+        return Fail("unsupported KTX2 format");
+    }
+    if (supercompression != 0)
+    {
+        return Fail("supercompressed KTX2 is not supported");
+    }
+    if (depth > 1 || layerCount > 1 || faceCount != 1)
+    {
+        return Fail("only 2D KTX2 textures are supported");
+    }
+    if (width == 0 || height == 0 || width > MaxTextureSize || height > MaxTextureSize)
+    {
+        return Fail("invalid KTX2 dimensions");
+    }
+
+    // A level count of 0 asks the loader to generate the mip chain
+    const uint32_t storedLevels = std::max(levelCount, 1u);
+    if (storedLevels > GetFullMipCount(width, height))
+    {
+        return Fail("more KTX2 levels than the size allows");
+    }
+
+    std::vector<uint8_t> levelIndex(static_cast<size_t>(storedLevels) * Ktx2LevelIndexEntrySize);
+    if (!ReadAt(m_File, Ktx2HeaderSize, levelIndex.data(), levelIndex.size()))
+    {
+        return Fail("KTX2 level index cut short");
+    }
+
+    m_Description = MakeTextureDescription(format, width, height, storedLevels);
+    for (uint32_t i = 0; i < storedLevels; ++i)
+    {
+        TextureLevel& level = m_Description.levels[i];
+        const uint8_t* entry = levelIndex.data() + static_cast<size_t>(i) * Ktx2LevelIndexEntrySize;
+        level.fileOffset = ReadU64(entry);
+        if (ReadU64(entry + 8) != level.size)
+        {
+            return Fail("KTX2 level size does not match its format and dimensions");
+        }
+        if (level.fileOffset > m_FileSize || level.size > m_FileSize - level.fileOffset)
+        {
+            return Fail("KTX2 level data cut short");
+        }
+    }
+
+    m_Description.generateMips = !IsBlockCompressed(format) && storedLevels < GetFullMipCount(width, height);
+    return true;
+}
+
+bool TextureFile::ParseDds()
+{
+    uint8_t header[4 + DdsHeaderSize];
+    if (!ReadAt(m_File, 0, header, sizeof(header)) || ReadU32(header + 4) != DdsHeaderSize)
+    {
+        return Fail("DDS header cut short");
+    }
+
+    const uint32_t flags = ReadU32(header + 8);
+    const uint32_t height = ReadU32(header + 12);
+    const uint32_t width = ReadU32(header + 16);
+    const uint32_t mipMapCount = ReadU32(header + 28);
+    const uint32_t pixelFormatFlags = ReadU32(header + 80);
+    const uint32_t fourCc = ReadU32(header + 84);
+    const uint32_t rgbBitCount = ReadU32(header + 88);
+    const uint32_t redMask = ReadU32(header + 92);
+    const uint32_t caps2 = ReadU32(header + 112);
+
+    if ((caps2 & DdsCaps2CubeOrVolume) != 0)
+    {
+        return Fail("only 2D DDS textures are supported");
+    }
+
+    uint64_t dataOffset = sizeof(header);
+    TextureFormat format = TextureFormat::Undefined;
+    if ((pixelFormatFlags & DdsPixelFormatFourCc) != 0)
+    {
+        switch (fourCc)
+        {
+        case MakeFourCc('D', 'X', 'T', '1'): format = TextureFormat::Bc1RgbaUnorm; break;
+        case MakeFourCc('D', 'X', 'T', '3'): format = TextureFormat::Bc2Unorm; break;
+        case MakeFourCc('D', 'X', 'T', '5'): format = TextureFormat::Bc3Unorm; break;
+        case MakeFourCc('A', 'T', 'I', '1'):
+        case MakeFourCc('B', 'C', '4', 'U'): format = TextureFormat::Bc4Unorm; break;
+        case MakeFourCc('B', 'C', '4', 'S'): format = TextureFormat::Bc4Snorm; break;
+        case MakeFourCc('A', 'T', 'I', '2'):
+        case MakeFourCc('B', 'C', '5', 'U'): format = TextureFormat::Bc5Unorm; break;
+        case MakeFourCc('B', 'C', '5', 'S'): format = TextureFormat::Bc5Snorm; break;
+        case MakeFourCc('D', 'X', '1', '0'):
+        {
+            uint8_t dx10Header[DdsDx10HeaderSize];
+            if (!ReadAt(m_File, dataOffset, dx10Header, sizeof(dx10Header)))
+            {
+                return Fail("DDS DX10 header cut short");
+            }
+            if (ReadU32(dx10Header + 4) != DdsResourceDimensionTexture2D || (ReadU32(dx10Header + 8) & DdsMiscTextureCube) != 0 ||
+                ReadU32(dx10Header + 12) > 1)
+            {
+                return Fail("only 2D DDS textures are supported");
+            }
+            format = FromDxgiFormat(ReadU32(dx10Header));
+            dataOffset += DdsDx10HeaderSize;
+            break;
+        }
+        default:
+            break;
+        }
+    }
+    else if ((pixelFormatFlags & DdsPixelFormatRgb) != 0 && rgbBitCount == 32)
+    {
+        format = redMask == 0x000000FF ? TextureFormat::R8G8B8A8Unorm : redMask == 0x00FF0000 ? TextureFormat::B8G8R8A8Unorm : TextureFormat::Undefined;
+    }
+
+    if (format == TextureFormat::Undefined)
+    {
+        return Fail("unsupported DDS format");
+    }
+    if (width == 0 || height == 0 || width > MaxTextureSize || height > MaxTextureSize)
+    {
+        return Fail("invalid DDS dimensions");
+    }
+
+    const uint32_t storedLevels = (flags & DdsFlagsMipMapCount) != 0 ? std::max(mipMapCount, 1u) : 1;
+    if (storedLevels > GetFullMipCount(width, height))
+    {
+        return Fail("more DDS levels than the size allows");
+    }
+
+    // Levels follow the headers back to back, largest first
+    m_Description = MakeTextureDescription(format, width, height, storedLevels);
+    for (TextureLevel& level : m_Description.levels)
+    {
+        level.fileOffset = dataOffset;
+        dataOffset += level.size;
+    }
+    if (dataOffset > m_FileSize)
+    {
+        return Fail("DDS level data cut short");
+    }
+
+    m_Description.generateMips = !IsBlockCompressed(format) && storedLevels < GetFullMipCount(width, height);
+    return true;
+}
+
+bool TextureFile::Fail(const char* reason)
+{
+    spdlog::error("Texture {}: {}", m_Path.string(), reason);
+    Close();
+    return false;
+}
+
+bool MiniEngine::Graphics::WriteTextureFile(const std::filesystem::path& path, TextureContainer container, const TextureDescription& description, const void* data)
+{
+    const uint32_t levelCount = static_cast<uint32_t>(description.levels.size());
+    std::vector<uint8_t> bytes;
+
+    if (container == TextureContainer::Ktx2)
+    {
+        const std::vector<uint8_t> descriptor = MakeDataFormatDescriptor(description.format);
+        const uint32_t descriptorOffset = Ktx2HeaderSize + levelCount * Ktx2LevelIndexEntrySize;
+
+        bytes.insert(bytes.end(), std::begin(Ktx2Identifier), std::end(Ktx2Identifier));
+        AppendU32(bytes, static_cast<uint32_t>(description.format));
+        AppendU32(bytes, 1); // Type size: bytes for block compressed and 8-bit formats alike
+        AppendU32(bytes, description.width);
+        AppendU32(bytes, description.height);
+        AppendU32(bytes, 0); // Depth
+        AppendU32(bytes, 0); // Layers
+        AppendU32(bytes, 1); // Faces
+        AppendU32(bytes, levelCount);
+        AppendU32(bytes, 0); // No supercompression
+        AppendU32(bytes, descriptorOffset);
+        AppendU32(bytes, static_cast<uint32_t>(descriptor.size()));
+        AppendU32(bytes, 0); // No key/value data
+        AppendU32(bytes, 0);
+        AppendU64(bytes, 0); // No supercompression global data
+        AppendU64(bytes, 0);
+
+        // The specification stores the smallest level first, each aligned to lcm(block size, 4)
+        const uint64_t alignment = GetBytesPerBlock(description.format) % 4 == 0 ? GetBytesPerBlock(description.format) : 4;
+        std::vector<uint64_t> fileOffsets(levelCount);
+        uint64_t offset = descriptorOffset + descriptor.size();
+        for (uint32_t i = levelCount; i-- > 0;)
+        {
+            offset = (offset + alignment - 1) / alignment * alignment;
+            fileOffsets[i] = offset;
+            offset += description.levels[i].size;
+        }
+        for (uint32_t i = 0; i < levelCount; ++i)
+        {
+            AppendU64(bytes, fileOffsets[i]);
+            AppendU64(bytes, description.levels[i].size);
+            AppendU64(bytes, description.levels[i].size);
+        }
+        bytes.insert(bytes.end(), descriptor.begin(), descriptor.end());
+
+        bytes.resize(offset, 0);
+        for (uint32_t i = 0; i < levelCount; ++i)
+        {
+            std::memcpy(bytes.data() + fileOffsets[i], static_cast<const uint8_t*>(data) + description.levels[i].dataOffset, description.levels[i].size);
+        }
+    }
+    else
+    {
+        // Always the DX10 extension, the only way to tell sRGB and the newer BC formats apart
+        AppendU32(bytes, DdsMagic);
+        AppendU32(bytes, DdsHeaderSize);
+        // Caps, height, width, pixel format and mip count, plus the linear size of compressed or the pitch of uncompressed levels
+        const bool compressed = IsBlockCompressed(description.format);
+        AppendU32(bytes, 0x1 | 0x2 | 0x4 | 0x1000 | DdsFlagsMipMapCount | (compressed ? 0x80000 : 0x8));
+        AppendU32(bytes, description.height);
+        AppendU32(bytes, description.width);
+        AppendU32(bytes, compressed ? static_cast<uint32_t>(description.levels.front().size) : description.width * GetBytesPerBlock(description.format));
+        AppendU32(bytes, 0); // Depth
+        AppendU32(bytes, levelCount);
+        bytes.resize(bytes.size() + 11 * 4, 0);
+        AppendU32(bytes, 32); // Pixel format size
+        AppendU32(bytes, DdsPixelFormatFourCc);
+        AppendU32(bytes, MakeFourCc('D', 'X', '1', '0'));
+        bytes.resize(bytes.size() + 5 * 4, 0);
+        AppendU32(bytes, 0x1000 | (levelCount > 1 ? 0x400008 : 0)); // Texture, plus mipmap and complex when there are levels
+        bytes.resize(bytes.size() + 4 * 4, 0);
+
+        AppendU32(bytes, ToDxgiFormat(description.format));
+        AppendU32(bytes, DdsResourceDimensionTexture2D);
+        AppendU32(bytes, 0);
+        AppendU32(bytes, 1); // Array size
+        AppendU32(bytes, 0);
+
+        for (const TextureLevel& level : description.levels)
+        {
+            const uint8_t* source = static_cast<const uint8_t*>(data) + level.dataOffset;
+            bytes.insert(bytes.end(), source, source + level.size);
+        }
+    }
+
+    // Written next to the target and renamed over it, so a reader never sees half a file
+    std::filesystem::path temporaryPath = path;
+    temporaryPath += ".tmp";
+#ifdef _WIN32
+    std::FILE* file = _wfopen(temporaryPath.c_str(), L"wb");
+#else
+    std::FILE* file = std::fopen(temporaryPath.c_str(), "wb");
+#endif
+    if (file == nullptr)
+    {
+        spdlog::error("Texture {}: cannot create the file", path.string());
+        return false;
+    }
+    const bool written = std::fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+    const bool closed = std::fclose(file) == 0;
+
+    std::error_code error;
+    if (written && closed)
+    {
+        std::filesystem::rename(temporaryPath, path, error);
+    }
+    if (!written || !closed || error)
+    {
+        spdlog::error("Texture {}: write failed", path.string());
+        std::filesystem::remove(temporaryPath, error);
+        return false;
+    }
+    return true;
+}
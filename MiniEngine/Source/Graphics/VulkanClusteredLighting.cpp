@@ -0,0 +1,435 @@
+#include "MiniEngine/Graphics/VulkanClusteredLighting.hpp"
+
+#include "MiniEngine/Graphics/VulkanCommandEncoder.hpp"
+#include "MiniEngine/Graphics/VulkanQueues.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace MiniEngine::Graphics;
+
+namespace
+{
+    // Per-frame constants of the light binning and lit shaders (std140 layout)
+    struct LightingUniforms
+    {
+        glm::mat4 view;
+        glm::vec4 screenSizeTileSize; // Framebuffer size in xy, pixels covered by one cluster in zw
+        glm::vec4 projection;         // Tangents of the half field of view in xy, near and far plane in zw
+        glm::vec4 ambientSliceScale;  // Ambient light in xyz, depth slices per unit of log view depth in w
+        uint32_t  gridSizeX;
+        uint32_t  gridSizeY;
+        uint32_t  gridSizeZ;
+        uint32_t  lightCount;
+        float     sliceBias;
+        uint32_t  clustered;          // 0 shades every fragment with every light
+        uint32_t  padding[2];
+    };
+
+    // Offset and length of a cluster's run in the light index list (std430 layout)
+    struct GpuCluster
+    {
+        uint32_t offset;
+        uint32_t count;
+    };
+
+    enum LightingTimestamp : uint32_t
+    {
+        TimestampBinBegin,
+        TimestampBinEnd,
+        TimestampFrameEnd,
+        TimestampCount
+    };
+
+    // Constants, lights, cluster ranges, light indices and the index counter
+    constexpr uint32_t BindingCount = 5;
+    constexpr uint32_t CounterBinding = 4;
+    constexpr uint32_t MinLightCapacity = 256;
+}
+
+VulkanClusteredLighting::~VulkanClusteredLighting()
+{
+    Destroy();
+}
+
+bool VulkanClusteredLighting::Initialize(const VulkanContext& context, const std::string& cullShader)
+{
+    Destroy();
+    m_Device = context.device;
+    m_Memory = context.memory;
+
+    // Binning and shading both run on the graphics queue
+    m_TimestampPeriod = MiniEngine::Graphics::GetTimestampPeriod(context.physicalDevice, context.queues->GetGraphics().family);
+
+    // The vertex shader only needs the view matrix from the constants, the counter is private to binning
+    VkDescriptorSetLayoutBinding bindings[BindingCount]{};
+    for (uint32_t i = 0; i < BindingCount; ++i)
+    {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = i == 0 ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = i == CounterBinding ? VK_SHADER_STAGE_COMPUTE_BIT : (VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT);
+    }
+    bindings[0].stageFlags |= VK_SHADER_STAGE_VERTEX_BIT;
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = BindingCount;
+    layoutInfo.pBindings = bindings;
+
+    if (vkCreateDescriptorSetLayout(m_Device, &layoutInfo, nullptr, &m_SetLayout) != VK_SUCCESS)
+    {
+        spdlog::critical("Failed to create lighting descriptor set layout");
+        return false;
+    }
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = 1;
+    pipelineLayoutInfo.pSetLayouts = &m_SetLayout;
+
+    if (vkCreatePipelineLayout(m_Device, &pipelineLayoutInfo, nullptr, &m_CullPipelineLayout) != VK_SUCCESS)
+    {
+        spdlog::critical("Failed to create light binning pipeline layout");
+        return false;
+    }
+
+    if (!CreateComputePipeline(context, m_CullPipelineLayout, cullShader, m_CullPipeline))
+    {
+        return false;
+    }
+
+    const uint32_t frameCount = context.framesInFlight;
+    VkDescriptorPoolSize poolSizes[] = {
+        { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, frameCount },
+        { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, frameCount * (BindingCount - 1) },
+    };
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets = frameCount;
+    poolInfo.poolSizeCount = 2;
+    poolInfo.pPoolSizes = poolSizes;
+
+    if (vkCreateDescriptorPool(m_Device, &poolInfo, nullptr, &m_DescriptorPool) != VK_SUCCESS)
+    {
+        spdlog::critical("Failed to create lighting descriptor pool");
+        return false;
+    }
+
+    // The light buffer grows with the scene; the cluster lists are sized so no cluster ever runs out
+    m_Frames.resize(frameCount);
+    for (Frame& frame : m_Frames)
+    {
+        if (!m_Memory->CreateBuffer(sizeof(LightingUniforms), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU,
+                                    MemoryCategory::FrameData, frame.uniformBuffer, frame.uniformAllocation, &frame.uniformMapped) ||
+            !m_Memory->CreateBuffer(sizeof(GpuCluster) * ClusterCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY,
+                                    MemoryCategory::FrameData, frame.clusterBuffer, frame.clusterAllocation) ||
+            !m_Memory->CreateBuffer(sizeof(uint32_t) * ClusterCount * MaxLightsPerCluster, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                                    VMA_MEMORY_USAGE_GPU_ONLY, MemoryCategory::FrameData, frame.lightIndexBuffer, frame.lightIndexAllocation) ||
+            !m_Memory->CreateBuffer(sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_TO_CPU,
+                                    MemoryCategory::FrameData, frame.counterBuffer, frame.counterAllocation, &frame.counterMapped))
+        {
+            return false;
+        }
+
+        if (m_TimestampPeriod > 0.0f)
+        {
+            VkQueryPoolCreateInfo queryPoolInfo{};
+            queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+            queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+            queryPoolInfo.queryCount = TimestampCount;
+
+            if (vkCreateQueryPool(m_Device, &queryPoolInfo, nullptr, &frame.timestampPool) != VK_SUCCESS)
+            {
+                spdlog::critical("Failed to create lighting timestamp query pool");
+                return false;
+            }
+        }
+
+        VkDescriptorSetAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool = m_DescriptorPool;
+        allocInfo.descriptorSetCount = 1;
+        allocInfo.pSetLayouts = &m_SetLayout;
+
+        if (vkAllocateDescriptorSets(m_Device, &allocInfo, &frame.descriptorSet) != VK_SUCCESS)
+        {
+            spdlog::critical("Failed to allocate lighting descriptor set");
+            return false;
+        }
+
+        // Also writes the descriptor set, so it is valid before the scene has any lights
+        if (!ReserveLights(frame, 1))
+        {
+            return false;
+        }
+    }
+
+    spdlog::info("Clustered lighting created with a {}x{}x{} cluster grid", GridSizeX, GridSizeY, GridSizeZ);
+    return true;
+}
+
+void VulkanClusteredLighting::Destroy()
+{
+    if (m_Device == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    for (Frame& frame : m_Frames)
+    {
+        if (frame.timestampPool != VK_NULL_HANDLE)
+        {
+            vkDestroyQueryPool(m_Device, frame.timestampPool, nullptr);
+        }
+        m_Memory->DestroyBuffer(frame.uniformBuffer, frame.uniformAllocation);
+        m_Memory->DestroyBuffer(frame.lightBuffer, frame.lightAllocation);
+        m_Memory->DestroyBuffer(frame.clusterBuffer, frame.clusterAllocation);
+        m_Memory->DestroyBuffer(frame.lightIndexBuffer, frame.lightIndexAllocation);
+        m_Memory->DestroyBuffer(frame.counterBuffer, frame.counterAllocation);
+    }
+    m_Frames.clear();
+
+    // Destroying the pool frees every set allocated from it
+    if (m_DescriptorPool != VK_NULL_HANDLE)
+    {
+        vkDestroyDescriptorPool(m_Device, m_DescriptorPool, nullptr);
+        m_DescriptorPool = VK_NULL_HANDLE;
+    }
+    if (m_CullPipeline != VK_NULL_HANDLE)
+    {
+        vkDestroyPipeline(m_Device, m_CullPipeline, nullptr);
+        m_CullPipeline = VK_NULL_HANDLE;
+    }
+    if (m_CullPipelineLayout != VK_NULL_HANDLE)
+    {
+        vkDestroyPipelineLayout(m_Device, m_CullPipelineLayout, nullptr);
+        m_CullPipelineLayout = VK_NULL_HANDLE;
+    }
+    if (m_SetLayout != VK_NULL_HANDLE)
+    {
+        vkDestroyDescriptorSetLayout(m_Device, m_SetLayout, nullptr);
+        m_SetLayout = VK_NULL_HANDLE;
+    }
+
+    m_Device = VK_NULL_HANDLE;
+    spdlog::debug("Clustered lighting destroyed");
+}
+
+bool VulkanClusteredLighting::PrepareFrame(uint32_t frameIndex, std::span<const ClusteredLight> lights, const LightingCamera& camera, VkExtent2D extent)
+{
+    Frame& frame = m_Frames[frameIndex];
+    ReadResults(frame);
+
+    const uint32_t lightCount = static_cast<uint32_t>(lights.size());
+    if (!ReserveLights(frame, lightCount))
+    {
+        return false;
+    }
+    if (lightCount > 0)
+    {
+        std::memcpy(frame.lightMapped, lights.data(), sizeof(ClusteredLight) * lightCount);
+        vmaFlushAllocation(m_Memory->GetAllocator(), frame.lightAllocation, 0, sizeof(ClusteredLight) * lightCount);
+    }
+
+    // Slices are spaced exponentially, so clusters keep roughly the same proportions at every depth
+    const float logDepthRange = std::log(camera.farPlane / camera.nearPlane);
+
+    LightingUniforms uniforms{};
+    uniforms.view = camera.view;
+    uniforms.screenSizeTileSize = glm::vec4(
+        static_cast<float>(extent.width), static_cast<float>(extent.height),
+        std::ceil(static_cast<float>(extent.width) / GridSizeX),
+        std::ceil(static_cast<float>(extent.height) / GridSizeY));
+    uniforms.projection = glm::vec4(1.0f / camera.projection[0][0], 1.0f / std::abs(camera.projection[1][1]),
+                                    camera.nearPlane, camera.farPlane);
+    uniforms.ambientSliceScale = glm::vec4(m_Ambient, GridSizeZ / logDepthRange);
+    uniforms.gridSizeX = GridSizeX;
+    uniforms.gridSizeY = GridSizeY;
+    uniforms.gridSizeZ = GridSizeZ;
+    uniforms.lightCount = lightCount;
+    uniforms.sliceBias = GridSizeZ * std::log(camera.nearPlane) / logDepthRange;
+    uniforms.clustered = m_Clustered ? 1 : 0;
+    std::memcpy(frame.uniformMapped, &uniforms, sizeof(uniforms));
+    vmaFlushAllocation(m_Memory->GetAllocator(), frame.uniformAllocation, 0, sizeof(uniforms));
+
+    frame.lightCount = lightCount;
+    frame.clustered = m_Clustered;
+    return true;
+}
+
+void VulkanClusteredLighting::RecordBinning(VulkanCommandEncoder& encoder, uint32_t frameIndex)
+{
+    const Frame& frame = m_Frames[frameIndex];
+    VkCommandBuffer commandBuffer = encoder.GetCommandBuffer();
+
+    if (frame.timestampPool != VK_NULL_HANDLE)
+    {
+        vkCmdResetQueryPool(commandBuffer, frame.timestampPool, 0, TimestampCount);
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, frame.timestampPool, TimestampBinBegin);
+    }
+
+    if (frame.clustered)
+    {
+        vkCmdFillBuffer(commandBuffer, frame.counterBuffer, 0, sizeof(uint32_t), 0);
+
+        VkMemoryBarrier counterBarrier{};
+        counterBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        counterBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        counterBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &counterBarrier, 0, nullptr, 0, nullptr);
+
+        encoder.BindPipeline(VK_PIPELINE_BIND_POINT_COMPUTE, m_CullPipeline);
+        encoder.BindDescriptorSets(VK_PIPELINE_BIND_POINT_COMPUTE, m_CullPipelineLayout, 0, 1, &frame.descriptorSet);
+        encoder.Dispatch(GridSizeX, GridSizeY, GridSizeZ);
+
+        VkMemoryBarrier listBarrier{};
+        listBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        listBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        listBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 1, &listBarrier, 0, nullptr, 0, nullptr);
+    }
+
+    if (frame.timestampPool != VK_NULL_HANDLE)
+    {
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frame.timestampPool, TimestampBinEnd);
+    }
+}
+
+void VulkanClusteredLighting::RecordFrameEnd(VkCommandBuffer commandBuffer, uint32_t frameIndex)
+{
+    const Frame& frame = m_Frames[frameIndex];
+    if (frame.timestampPool != VK_NULL_HANDLE)
+    {
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frame.timestampPool, TimestampFrameEnd);
+    }
+}
+
+VkDeviceSize VulkanClusteredLighting::Trim(uint32_t frameIndex)
+{
+    Frame& frame = m_Frames[frameIndex];
+    const uint32_t needed = std::max(frame.lightCount, MinLightCapacity);
+    if (frame.lightCapacity <= needed * 2)
+    {
+        return 0;
+    }
+
+    const VkDeviceSize before = m_Memory->GetCategoryUsage()[static_cast<size_t>(MemoryCategory::FrameData)].bytes;
+    frame.lightCapacity = 0;
+    if (!ReserveLights(frame, needed))
+    {
+        return 0;
+    }
+    const VkDeviceSize after = m_Memory->GetCategoryUsage()[static_cast<size_t>(MemoryCategory::FrameData)].bytes;
+    return before > after ? before - after : 0;
+}
+
+// Points the frame's descriptor set at its current buffers
+void VulkanClusteredLighting::WriteDescriptorSet(Frame& frame)
+{
+    VkDescriptorBufferInfo bufferInfos[BindingCount] = {
+        { frame.uniformBuffer, 0, VK_WHOLE_SIZE },
+        { frame.lightBuffer, 0, VK_WHOLE_SIZE },
+        { frame.clusterBuffer, 0, VK_WHOLE_SIZE },
+        { frame.lightIndexBuffer, 0, VK_WHOLE_SIZE },
+        { frame.counterBuffer, 0, VK_WHOLE_SIZE },
+    };
+
+    VkWriteDescriptorSet writes[BindingCount]{};
+    for (uint32_t i = 0; i < BindingCount; ++i)
+    {
+        writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[i].dstSet = frame.descriptorSet;
+        writes[i].dstBinding = i;
+        writes[i].descriptorCount = 1;
+        writes[i].descriptorType = i == 0 ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        writes[i].pBufferInfo = &bufferInfos[i];
+    }
+    vkUpdateDescriptorSets(m_Device, BindingCount, writes, 0, nullptr);
+}
+
+// Grows the light buffer of a frame that is not in flight and points its descriptor set at it
+bool VulkanClusteredLighting::ReserveLights(Frame& frame, uint32_t lightCount)
+{
+    if (lightCount <= frame.lightCapacity)
+    {
+        return true;
+    }
+
+    uint32_t capacity = std::max(frame.lightCapacity, MinLightCapacity);
+    while (capacity < lightCount)
+    {
+        capacity *= 2;
+    }
+
+    m_Memory->DestroyBuffer(frame.lightBuffer, frame.lightAllocation);
+    frame.lightCapacity = 0;
+
+    // Transfer usage lets defragmentation copy it elsewhere
+    const VkBufferUsageFlags usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    const VkDeviceSize lightBytes = sizeof(ClusteredLight) * capacity;
+    if (!m_Memory->CreateBuffer(lightBytes, usage, VMA_MEMORY_USAGE_CPU_TO_GPU, MemoryCategory::FrameData,
+                                frame.lightBuffer, frame.lightAllocation, &frame.lightMapped))
+    {
+        return false;
+    }
+    frame.lightCapacity = capacity;
+    WriteDescriptorSet(frame);
+    m_Memory->RegisterMovableBuffer(frame.lightAllocation, { &frame.lightBuffer, &frame.lightMapped, lightBytes, usage,
+                                                             [this, &frame] { WriteDescriptorSet(frame); } });
+
+    spdlog::debug("Light buffer sized for {} lights", capacity);
+    return true;
+}
+
+// Collects the list length and timestamps of the frame's previous submission; its fence must have signaled
+void VulkanClusteredLighting::ReadResults(Frame& frame)
+{
+    if (!frame.submitted)
+    {
+        return;
+    }
+
+    m_Stats.lightCount = frame.lightCount;
+    if (frame.clustered)
+    {
+        vmaInvalidateAllocation(m_Memory->GetAllocator(), frame.counterAllocation, 0, sizeof(uint32_t));
+        std::memcpy(&m_Stats.lightIndices, frame.counterMapped, sizeof(uint32_t));
+    }
+
+    if (frame.timestampPool == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    uint64_t timestamps[TimestampCount];
+    if (vkGetQueryPoolResults(m_Device, frame.timestampPool, 0, TimestampCount, sizeof(timestamps), timestamps,
+                              sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) != VK_SUCCESS)
+    {
+        return;
+    }
+
+    const double ticksToMs = m_TimestampPeriod / 1e6;
+    const double binMs = (timestamps[TimestampBinEnd] - timestamps[TimestampBinBegin]) * ticksToMs;
+    const double frameMs = (timestamps[TimestampFrameEnd] - timestamps[TimestampBinBegin]) * ticksToMs;
+
+    // Smoothed separately per mode, so toggling gives a direct comparison
+    const int mode = frame.clustered ? 1 : 0;
+    if (frame.clustered)
+    {
+        m_Stats.gpuBinMs = m_Stats.samples[1] == 0 ? binMs : m_Stats.gpuBinMs + (binMs - m_Stats.gpuBinMs) * 0.05;
+    }
+    if (m_Stats.samples[mode] == 0)
+    {
+        m_Stats.gpuFrameMs[mode] = frameMs;
+    }
+    else
+    {
+        m_Stats.gpuFrameMs[mode] += (frameMs - m_Stats.gpuFrameMs[mode]) * 0.05;
+    }
+    ++m_Stats.samples[mode];
+}
@@ -0,0 +1,339 @@
+#include "MiniEngine/Graphics/VulkanCommandEncoder.hpp"
+
+#include <cstring>
+
+using namespace MiniEngine::Graphics;
+
+namespace
+{
+    constexpr uint32_t UntrackedBindPoint = 2;
+}
+
+const char* MiniEngine::Graphics::ToString(EncodedCommand command)
+{
+    switch (command)
+    {
+    case EncodedCommand::BindPipeline:       return "BindPipeline";
+    case EncodedCommand::BindDescriptorSets: return "BindDescriptorSets";
+    case EncodedCommand::BindVertexBuffers:  return "BindVertexBuffers";
+    case EncodedCommand::BindIndexBuffer:    return "BindIndexBuffer";
+    case EncodedCommand::PushConstants:      return "PushConstants";
+    case EncodedCommand::SetViewport:        return "SetViewport";
+    case EncodedCommand::SetScissor:         return "SetScissor";
+    case EncodedCommand::Draw:               return "Draw";
+    case EncodedCommand::Dispatch:           return "Dispatch";
+    default:                                 return "Unknown";
+    }
+}
+
+uint32_t CommandEncoderStats::GetIssued() const
+{
+    uint32_t total = 0;
+    for (uint32_t count : issued)
+    {
+        total += count;
+    }
+    return total;
+}
+
+uint32_t CommandEncoderStats::GetElided() const
+{
+    uint32_t total = 0;
+    for (uint32_t count : elided)
+    {
+        total += count;
+    }
+    return total;
+}
+
+void VulkanCommandEncoder::Begin(VkCommandBuffer commandBuffer)
+{
+    m_CommandBuffer = commandBuffer;
+    m_Stats = {};
+    Invalidate();
+}
+
+void VulkanCommandEncoder::Invalidate()
+{
+    m_BindPoints = {};
+    m_VertexBound.reset();
+    m_IndexBuffer = VK_NULL_HANDLE;
+    m_PushConstantLayout = VK_NULL_HANDLE;
+    m_PushConstantStages = {};
+    m_ViewportSet.reset();
+    m_ScissorSet.reset();
+}
+
+void VulkanCommandEncoder::BindPipeline(VkPipelineBindPoint bindPoint, VkPipeline pipeline)
+{
+    const uint32_t index = GetBindPointIndex(bindPoint);
+    if (index != UntrackedBindPoint)
+    {
+        if (m_BindPoints[index].pipeline == pipeline)
+        {
+            Count(EncodedCommand::BindPipeline, false);
+            return;
+        }
+        m_BindPoints[index].pipeline = pipeline;
+    }
+
+    // A pipeline with static viewport or scissor state overwrites the dynamic values
+    if (bindPoint == VK_PIPELINE_BIND_POINT_GRAPHICS)
+    {
+        m_ViewportSet.reset();
+        m_ScissorSet.reset();
+    }
+
+    vkCmdBindPipeline(m_CommandBuffer, bindPoint, pipeline);
+    Count(EncodedCommand::BindPipeline, true);
+}
+
+void VulkanCommandEncoder::BindDescriptorSets(VkPipelineBindPoint bindPoint, VkPipelineLayout layout, uint32_t firstSet, uint32_t setCount,
+                                              const VkDescriptorSet* sets, uint32_t dynamicOffsetCount, const uint32_t* dynamicOffsets)
+{
+    const uint32_t index = GetBindPointIndex(bindPoint);
+    const bool tracked = index != UntrackedBindPoint && firstSet + setCount <= MaxDescriptorSets;
+
+    if (tracked)
+    {
+        BindPointState& state = m_BindPoints[index];
+
+        bool unchanged = dynamicOffsetCount == 0;
+        for (uint32_t i = 0; i < setCount && unchanged; ++i)
+        {
+            unchanged = state.sets[firstSet + i] == sets[i] && state.setLayouts[firstSet + i] == layout;
+        }
+        if (unchanged)
+        {
+            Count(EncodedCommand::BindDescriptorSets, false);
+            return;
+        }
+
+        // Binding with another layout may disturb sets bound through it, so only trust sets bound with this one
+        for (uint32_t set = 0; set < MaxDescriptorSets; ++set)
+        {
+            if (state.setLayouts[set] != layout)
+            {
+                state.sets[set] = VK_NULL_HANDLE;
+                state.setLayouts[set] = VK_NULL_HANDLE;
+            }
+        }
+        for (uint32_t i = 0; i < setCount; ++i)
+        {
+            // Dynamic offsets are not shadowed, so such sets must be bound again next time
+            state.sets[firstSet + i] = dynamicOffsetCount == 0 ? sets[i] : VK_NULL_HANDLE;
+            state.setLayouts[firstSet + i] = dynamicOffsetCount == 0 ? layout : VK_NULL_HANDLE;
+        }
+    }
+    else if (index != UntrackedBindPoint)
+    {
+        m_BindPoints[index].sets = {};
+        m_BindPoints[index].setLayouts = {};
+    }
+
+    vkCmdBindDescriptorSets(m_CommandBuffer, bindPoint, layout, firstSet, setCount, sets, dynamicOffsetCount, dynamicOffsets);
+    Count(EncodedCommand::BindDescriptorSets, true);
+}
+
+void VulkanCommandEncoder::BindVertexBuffers(uint32_t firstBinding, uint32_t bindingCount, const VkBuffer* buffers, const VkDeviceSize* offsets)
+{
+    const bool tracked = firstBinding + bindingCount <= MaxVertexBindings;
+
+    if (tracked)
+    {
+        bool unchanged = true;
+        for (uint32_t i = 0; i < bindingCount && unchanged; ++i)
+        {
+            const uint32_t binding = firstBinding + i;
+            unchanged = m_VertexBound[binding] && m_VertexBuffers[binding] == buffers[i] && m_VertexOffsets[binding] == offsets[i];
+        }
+        if (unchanged)
+        {
+            Count(EncodedCommand::BindVertexBuffers, false);
+            return;
+        }
+
+        for (uint32_t i = 0; i < bindingCount; ++i)
+        {
+            const uint32_t binding = firstBinding + i;
+            m_VertexBuffers[binding] = buffers[i];
+            m_VertexOffsets[binding] = offsets[i];
+            m_VertexBound[binding] = true;
+        }
+    }
+    else
+    {
+        m_VertexBound.reset();
+    }
+
+    vkCmdBindVertexBuffers(m_CommandBuffer, firstBinding, bindingCount, buffers, offsets);
+    Count(EncodedCommand::BindVertexBuffers, true);
+}
+
+void VulkanCommandEncoder::BindIndexBuffer(VkBuffer buffer, VkDeviceSize offset, VkIndexType indexType)
+{
+    if (m_IndexBuffer != VK_NULL_HANDLE && m_IndexBuffer == buffer && m_IndexOffset == offset && m_IndexType == indexType)
+    {
+        Count(EncodedCommand::BindIndexBuffer, false);
+        return;
+    }
+
+    m_IndexBuffer = buffer;
+    m_IndexOffset = offset;
+    m_IndexType = indexType;
+
+    vkCmdBindIndexBuffer(m_CommandBuffer, buffer, offset, indexType);
+    Count(EncodedCommand::BindIndexBuffer, true);
+}
+
+void VulkanCommandEncoder::PushConstants(VkPipelineLayout layout, VkShaderStageFlags stages, uint32_t offset, uint32_t size, const void* data)
+{
+    const bool tracked = offset + size <= MaxPushConstantSize;
+
+    // Push constants are only kept across layouts with compatible ranges; assume they are not
+    if (layout != m_PushConstantLayout)
+    {
+        m_PushConstantLayout = layout;
+        m_PushConstantStages = {};
+    }
+
+    if (tracked)
+    {
+        bool unchanged = std::memcmp(&m_PushConstantData[offset], data, size) == 0;
+        for (uint32_t byte = offset; byte < offset + size && unchanged; ++byte)
+        {
+            unchanged = m_PushConstantStages[byte] == stages;
+        }
+        if (unchanged)
+        {
+            Count(EncodedCommand::PushConstants, false);
+            return;
+        }
+
+        std::memcpy(&m_PushConstantData[offset], data, size);
+        for (uint32_t byte = offset; byte < offset + size; ++byte)
+        {
+            m_PushConstantStages[byte] = stages;
+        }
+    }
+
+    vkCmdPushConstants(m_CommandBuffer, layout, stages, offset, size, data);
+    Count(EncodedCommand::PushConstants, true);
+}
+
+void VulkanCommandEncoder::SetViewport(uint32_t firstViewport, uint32_t viewportCount, const VkViewport* viewports)
+{
+    const bool tracked = firstViewport + viewportCount <= MaxViewports;
+
+    if (tracked)
+    {
+        bool unchanged = true;
+        for (uint32_t i = 0; i < viewportCount && unchanged; ++i)
+        {
+            const uint32_t viewport = firstViewport + i;
+            unchanged = m_ViewportSet[viewport] && std::memcmp(&m_Viewports[viewport], &viewports[i], sizeof(VkViewport)) == 0;
+        }
+        if (unchanged)
+        {
+            Count(EncodedCommand::SetViewport, false);
+            return;
+        }
+
+        for (uint32_t i = 0; i < viewportCount; ++i)
+        {
+            m_Viewports[firstViewport + i] = viewports[i];
+            m_ViewportSet[firstViewport + i] = true;
+        }
+    }
+
+    vkCmdSetViewport(m_CommandBuffer, firstViewport, viewportCount, viewports);
+    Count(EncodedCommand::SetViewport, true);
+}
+
+void VulkanCommandEncoder::SetScissor(uint32_t firstScissor, uint32_t scissorCount, const VkRect2D* scissors)
+{
+    const bool tracked = firstScissor + scissorCount <= MaxViewports;
+
+    if (tracked)
+    {
+        bool unchanged = true;
+        for (uint32_t i = 0; i < scissorCount && unchanged; ++i)
+        {
+            const uint32_t scissor = firstScissor + i;
+            unchanged = m_ScissorSet[scissor] && std::memcmp(&m_Scissors[scissor], &scissors[i], sizeof(VkRect2D)) == 0;
+        }
+        if (unchanged)
+        {
+            Count(EncodedCommand::SetScissor, false);
+            return;
+        }
+
+        for (uint32_t i = 0; i < scissorCount; ++i)
+        {
+            m_Scissors[firstScissor + i] = scissors[i];
+            m_ScissorSet[firstScissor + i] = true;
+        }
+    }
+
+    vkCmdSetScissor(m_CommandBuffer, firstScissor, scissorCount, scissors);
+    Count(EncodedCommand::SetScissor, true);
+}
+
+void VulkanCommandEncoder::Draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance)
+{
+    vkCmdDraw(m_CommandBuffer, vertexCount, instanceCount, firstVertex, firstInstance);
+    Count(EncodedCommand::Draw, true);
+}
+
+void VulkanCommandEncoder::DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance)
+{
+    vkCmdDrawIndexed(m_CommandBuffer, indexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
+    Count(EncodedCommand::Draw, true);
+}
+
+void VulkanCommandEncoder::DrawIndirect(VkBuffer buffer, VkDeviceSize offset, uint32_t drawCount, uint32_t stride)
+{
+    vkCmdDrawIndirect(m_CommandBuffer, buffer, offset, drawCount, stride);
+    Count(EncodedCommand::Draw, true);
+}
+
+void VulkanCommandEncoder::DrawIndexedIndirect(VkBuffer buffer, VkDeviceSize offset, uint32_t drawCount, uint32_t stride)
+{
+    vkCmdDrawIndexedIndirect(m_CommandBuffer, buffer, offset, drawCount, stride);
+    Count(EncodedCommand::Draw, true);
+}
+
+void VulkanCommandEncoder::DrawIndexedIndirectCount(VkBuffer buffer, VkDeviceSize offset, VkBuffer countBuffer, VkDeviceSize countOffset,
+                                                    uint32_t maxDrawCount, uint32_t stride)
+{
+    vkCmdDrawIndexedIndirectCount(m_CommandBuffer, buffer, offset, countBuffer, countOffset, maxDrawCount, stride);
+    Count(EncodedCommand::Draw, true);
+}
+
+void VulkanCommandEncoder::Dispatch(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ)
+{
+    vkCmdDispatch(m_CommandBuffer, groupCountX, groupCountY, groupCountZ);
+    Count(EncodedCommand::Dispatch, true);
+}
+
+void VulkanCommandEncoder::DispatchIndirect(VkBuffer buffer, VkDeviceSize offset)
+{
+    vkCmdDispatchIndirect(m_CommandBuffer, buffer, offset);
+    Count(EncodedCommand::Dispatch, true);
+}
+
+uint32_t VulkanCommandEncoder::GetBindPointIndex(VkPipelineBindPoint bindPoint)
+{
+    switch (bindPoint)
+    {
+    case VK_PIPELINE_BIND_POINT_GRAPHICS: return 0;
+    case VK_PIPELINE_BIND_POINT_COMPUTE:  return 1;
+    default:                              return UntrackedBindPoint;
+    }
+}
+
+void VulkanCommandEncoder::Count(EncodedCommand command, bool issued)
+{
+    std::array<uint32_t, static_cast<size_t>(EncodedCommand::Count)>& counts = issued ? m_Stats.issued : m_Stats.elided;
+    ++counts[static_cast<size_t>(command)];
+}
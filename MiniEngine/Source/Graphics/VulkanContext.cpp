@@ -0,0 +1,77 @@
+#include "MiniEngine/Graphics/VulkanContext.hpp"
+
+#include "MiniEngine/Graphics/VulkanDebugUtils.hpp"
+
+#include <spdlog/spdlog.h>
+
+using namespace MiniEngine::Graphics;
+
+VkShaderModule MiniEngine::Graphics::CreateShaderModule(const VulkanContext& context, const std::string& shaderPath)
+{
+    const std::vector<char> code = context.loadShader(shaderPath);
+    if (code.empty())
+    {
+        spdlog::critical("Failed to read shader {}", shaderPath);
+        return VK_NULL_HANDLE;
+    }
+
+    VkShaderModuleCreateInfo moduleInfo{};
+    moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    moduleInfo.codeSize = code.size();
+    moduleInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+
+    VkShaderModule shaderModule = VK_NULL_HANDLE;
+    if (vkCreateShaderModule(context.device, &moduleInfo, nullptr, &shaderModule) != VK_SUCCESS)
+    {
+        spdlog::critical("Failed to create shader module from {}", shaderPath);
+        return VK_NULL_HANDLE;
+    }
+    return shaderModule;
+}
+
+bool MiniEngine::Graphics::CreateComputePipeline(const VulkanContext& context, VkPipelineLayout layout, const std::string& shaderPath, VkPipeline& pipeline)
+{
+    VkShaderModule shaderModule = CreateShaderModule(context, shaderPath);
+    if (shaderModule == VK_NULL_HANDLE)
+    {
+        return false;
+    }
+
+    VkComputePipelineCreateInfo pipelineInfo{};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipelineInfo.stage.module = shaderModule;
+    pipelineInfo.stage.pName = "main";
+    pipelineInfo.layout = layout;
+
+    const VkResult result = vkCreateComputePipelines(context.device, context.pipelineCache, 1, &pipelineInfo, nullptr, &pipeline);
+    vkDestroyShaderModule(context.device, shaderModule, nullptr);
+
+    if (result != VK_SUCCESS)
+    {
+        spdlog::critical("Failed to create compute pipeline from {}", shaderPath);
+        return false;
+    }
+    context.debugUtils->SetObjectName(VK_OBJECT_TYPE_PIPELINE, pipeline, shaderPath.c_str());
+
+    spdlog::debug("Compute pipeline created from {}", shaderPath);
+    return true;
+}
+
+float MiniEngine::Graphics::GetTimestampPeriod(VkPhysicalDevice physicalDevice, uint32_t queueFamily)
+{
+    uint32_t familyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> families(familyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, families.data());
+
+    if (queueFamily >= familyCount || families[queueFamily].timestampValidBits == 0)
+    {
+        return 0.0f;
+    }
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    return properties.limits.timestampPeriod;
+}
@@ -0,0 +1,88 @@
+#include "MiniEngine/Graphics/VulkanDebugUtils.hpp"
+
+using namespace MiniEngine::Graphics;
+
+const char* MiniEngine::Graphics::ToString(InstrumentationLevel level)
+{
+    switch (level)
+    {
+    case InstrumentationLevel::Off:            return "off";
+    case InstrumentationLevel::Labels:         return "labels";
+    case InstrumentationLevel::Validation:     return "validation";
+    case InstrumentationLevel::FullValidation: return "full";
+    default:                                   return "unknown";
+    }
+}
+
+bool MiniEngine::Graphics::ParseInstrumentationLevel(std::string_view text, InstrumentationLevel& level)
+{
+    for (InstrumentationLevel candidate : { InstrumentationLevel::Off, InstrumentationLevel::Labels,
+                                            InstrumentationLevel::Validation, InstrumentationLevel::FullValidation })
+    {
+        if (text == ToString(candidate))
+        {
+            level = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+void VulkanDebugUtils::Load(VkInstance instance, VkDevice device, InstrumentationLevel level)
+{
+    *this = {};
+    if (level < InstrumentationLevel::Labels)
+    {
+        return;
+    }
+
+    auto setObjectName = reinterpret_cast<PFN_vkSetDebugUtilsObjectNameEXT>(vkGetInstanceProcAddr(instance, "vkSetDebugUtilsObjectNameEXT"));
+    auto beginLabel = reinterpret_cast<PFN_vkCmdBeginDebugUtilsLabelEXT>(vkGetInstanceProcAddr(instance, "vkCmdBeginDebugUtilsLabelEXT"));
+    auto endLabel = reinterpret_cast<PFN_vkCmdEndDebugUtilsLabelEXT>(vkGetInstanceProcAddr(instance, "vkCmdEndDebugUtilsLabelEXT"));
+
+    // All or nothing, so a label can never be begun without being ended
+    if (setObjectName == nullptr || beginLabel == nullptr || endLabel == nullptr)
+    {
+        return;
+    }
+
+    m_Device = device;
+    m_SetObjectName = setObjectName;
+    m_BeginLabel = beginLabel;
+    m_EndLabel = endLabel;
+}
+
+void VulkanDebugUtils::SetHandleName(VkObjectType type, uint64_t handle, const char* name) const
+{
+    VkDebugUtilsObjectNameInfoEXT nameInfo{};
+    nameInfo.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_OBJECT_NAME_INFO_EXT;
+    nameInfo.objectType = type;
+    nameInfo.objectHandle = handle;
+    nameInfo.pObjectName = name;
+    m_SetObjectName(m_Device, &nameInfo);
+}
+
+void VulkanDebugUtils::BeginLabel(VkCommandBuffer commandBuffer, const char* name, const std::array<float, 4>& color) const
+{
+    if (m_BeginLabel == nullptr)
+    {
+        return;
+    }
+
+    VkDebugUtilsLabelEXT label{};
+    label.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_LABEL_EXT;
+    label.pLabelName = name;
+    for (size_t i = 0; i < color.size(); ++i)
+    {
+        label.color[i] = color[i];
+    }
+    m_BeginLabel(commandBuffer, &label);
+}
+
+void VulkanDebugUtils::EndLabel(VkCommandBuffer commandBuffer) const
+{
+    if (m_EndLabel != nullptr)
+    {
+        m_EndLabel(commandBuffer);
+    }
+}
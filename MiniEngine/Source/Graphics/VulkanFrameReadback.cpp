@@ -0,0 +1,255 @@
+#include "MiniEngine/Graphics/VulkanFrameReadback.hpp"
+
+#include "MiniEngine/Graphics/VulkanDebugUtils.hpp"
+#include "MiniEngine/Graphics/VulkanQueues.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+
+using namespace MiniEngine::Graphics;
+
+VulkanFrameReadback::~VulkanFrameReadback()
+{
+    Destroy();
+}
+
+bool VulkanFrameReadback::Initialize(const VulkanContext& context, const FrameReadbackInfo& info)
+{
+    Destroy();
+
+    // The copy is byte for byte, so only 8-bit RGBA and BGRA images can be written out
+    switch (info.imageFormat)
+    {
+    case VK_FORMAT_B8G8R8A8_UNORM:
+    case VK_FORMAT_B8G8R8A8_SRGB:
+        m_Layout = PixelLayout::Bgra8;
+        break;
+    case VK_FORMAT_R8G8B8A8_UNORM:
+    case VK_FORMAT_R8G8B8A8_SRGB:
+        m_Layout = PixelLayout::Rgba8;
+        break;
+    default:
+        spdlog::error("Frame capture does not support image format {}", static_cast<int>(info.imageFormat));
+        return false;
+    }
+
+    m_Device = context.device;
+    m_Memory = context.memory;
+    m_DebugUtils = context.debugUtils;
+
+    // The copies go to the graphics queue, after the frame that presents the image
+    VkCommandPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    poolInfo.queueFamilyIndex = context.queues->GetGraphics().family;
+    if (vkCreateCommandPool(m_Device, &poolInfo, nullptr, &m_CommandPool) != VK_SUCCESS)
+    {
+        spdlog::error("Failed to create frame capture command pool");
+        Destroy();
+        return false;
+    }
+
+    m_CommandBuffers.resize(context.framesInFlight);
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool = m_CommandPool;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = context.framesInFlight;
+    if (vkAllocateCommandBuffers(m_Device, &allocInfo, m_CommandBuffers.data()) != VK_SUCCESS)
+    {
+        spdlog::error("Failed to allocate frame capture command buffers");
+        m_CommandBuffers.clear();
+        Destroy();
+        return false;
+    }
+    m_FrameSlots.assign(context.framesInFlight, -1);
+
+    // Every frame in flight may hold a slot, and the writer needs at least one more to work on
+    m_Slots.resize(std::max(info.slotCount, context.framesInFlight + 1));
+    for (uint32_t i = 0; i < m_Slots.size(); ++i)
+    {
+        if (!ReserveSlot(m_Slots[i], info.extent))
+        {
+            Destroy();
+            return false;
+        }
+        m_FreeSlots.push_back(i);
+    }
+
+    if (!m_Writer.Start(info.directory, info.fileFormat))
+    {
+        Destroy();
+        return false;
+    }
+
+    spdlog::debug("Frame readback created with {} slots", m_Slots.size());
+    return true;
+}
+
+void VulkanFrameReadback::Destroy()
+{
+    if (m_Device == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    // The writer reads straight from the slots, so it has to finish before they go
+    m_Writer.Stop();
+    for (Slot& slot : m_Slots)
+    {
+        m_Memory->DestroyBuffer(slot.buffer, slot.allocation);
+    }
+    m_Slots.clear();
+    m_FreeSlots.clear();
+    m_FrameSlots.clear();
+
+    // Destroying the pool frees its command buffers
+    if (m_CommandPool != VK_NULL_HANDLE)
+    {
+        vkDestroyCommandPool(m_Device, m_CommandPool, nullptr);
+        m_CommandPool = VK_NULL_HANDLE;
+    }
+    m_CommandBuffers.clear();
+    m_Enabled = false;
+    m_Stats = {};
+
+    m_Device = VK_NULL_HANDLE;
+}
+
+void VulkanFrameReadback::ReadResults(uint32_t frame)
+{
+    if (m_FrameSlots.empty() || m_FrameSlots[frame] < 0)
+    {
+        return;
+    }
+
+    const uint32_t slotIndex = static_cast<uint32_t>(m_FrameSlots[frame]);
+    m_FrameSlots[frame] = -1;
+
+    Slot& slot = m_Slots[slotIndex];
+    vmaInvalidateAllocation(m_Memory->GetAllocator(), slot.allocation, 0, VK_WHOLE_SIZE);
+
+    SequenceImage image;
+    image.pixels = static_cast<const uint8_t*>(slot.mapped);
+    image.width = slot.extent.width;
+    image.height = slot.extent.height;
+    image.rowPitch = slot.extent.width * 4;
+    image.layout = m_Layout;
+    ++m_Stats.copied;
+
+    // Runs on the writer's thread once the file is written
+    m_Writer.Write(image, [this, slotIndex] { ReturnSlot(slotIndex); });
+}
+
+VkCommandBuffer VulkanFrameReadback::Record(uint32_t frame, VkImage image, VkExtent2D extent, VkImageLayout layout)
+{
+    if (!m_Enabled)
+    {
+        return VK_NULL_HANDLE;
+    }
+
+    uint32_t slotIndex = 0;
+    {
+        std::lock_guard lock(m_Mutex);
+        if (m_FreeSlots.empty())
+        {
+            ++m_Stats.skipped;
+            return VK_NULL_HANDLE;
+        }
+        slotIndex = m_FreeSlots.back();
+        m_FreeSlots.pop_back();
+    }
+
+    Slot& slot = m_Slots[slotIndex];
+    if (!ReserveSlot(slot, extent))
+    {
+        ReturnSlot(slotIndex);
+        return VK_NULL_HANDLE;
+    }
+
+    VkCommandBuffer commandBuffer = m_CommandBuffers[frame];
+    vkResetCommandBuffer(commandBuffer, 0);
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+    {
+        ReturnSlot(slotIndex);
+        return VK_NULL_HANDLE;
+    }
+    m_DebugUtils->BeginLabel(commandBuffer, "Frame readback");
+
+    VkImageMemoryBarrier imageBarrier{};
+    imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    imageBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    imageBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    imageBarrier.oldLayout = layout;
+    imageBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    imageBarrier.image = image;
+    imageBarrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         0, 0, nullptr, 0, nullptr, 1, &imageBarrier);
+
+    VkBufferImageCopy region{};
+    region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+    region.imageExtent = { extent.width, extent.height, 1 };
+    vkCmdCopyImageToBuffer(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, slot.buffer, 1, &region);
+
+    // Back to the frame's layout, and the copy visible to the host once the fence signals
+    imageBarrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    imageBarrier.dstAccessMask = 0;
+    imageBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    imageBarrier.newLayout = layout;
+    VkBufferMemoryBarrier bufferBarrier{};
+    bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    bufferBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    bufferBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    bufferBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    bufferBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    bufferBarrier.buffer = slot.buffer;
+    bufferBarrier.size = VK_WHOLE_SIZE;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT | VK_PIPELINE_STAGE_HOST_BIT,
+                         0, 0, nullptr, 1, &bufferBarrier, 1, &imageBarrier);
+
+    m_DebugUtils->EndLabel(commandBuffer);
+    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+    {
+        spdlog::error("Failed to record frame readback");
+        ReturnSlot(slotIndex);
+        return VK_NULL_HANDLE;
+    }
+
+    m_FrameSlots[frame] = static_cast<int32_t>(slotIndex);
+    return commandBuffer;
+}
+
+// Keeps the buffer while the extent is unchanged, so only a resize reallocates
+bool VulkanFrameReadback::ReserveSlot(Slot& slot, VkExtent2D extent)
+{
+    if (slot.buffer != VK_NULL_HANDLE && slot.extent.width == extent.width && slot.extent.height == extent.height)
+    {
+        return true;
+    }
+    m_Memory->DestroyBuffer(slot.buffer, slot.allocation);
+
+    const VkDeviceSize size = static_cast<VkDeviceSize>(extent.width) * extent.height * 4;
+    if (!m_Memory->CreateBuffer(size, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_TO_CPU, MemoryCategory::FrameData,
+                                slot.buffer, slot.allocation, &slot.mapped))
+    {
+        slot.extent = {};
+        return false;
+    }
+    slot.extent = extent;
+    m_DebugUtils->SetObjectName(VK_OBJECT_TYPE_BUFFER, slot.buffer, "Frame readback");
+    return true;
+}
+
+void VulkanFrameReadback::ReturnSlot(uint32_t slotIndex)
+{
+    std::lock_guard lock(m_Mutex);
+    m_FreeSlots.push_back(slotIndex);
+}
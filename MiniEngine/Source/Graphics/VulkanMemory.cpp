@@ -0,0 +1,511 @@
+#define VMA_IMPLEMENTATION
+#include "MiniEngine/Graphics/VulkanMemory.hpp"
+
+#include "MiniEngine/Core/Log.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+
+using namespace MiniEngine::Graphics;
+
+namespace
+{
+    constexpr double MiB = 1024.0 * 1024.0;
+
+    // The category travels with the allocation as its user data, so destruction needs nothing but the allocation
+    MemoryCategory GetAllocationCategory(const VmaAllocationInfo& allocationInfo)
+    {
+        return static_cast<MemoryCategory>(reinterpret_cast<uintptr_t>(allocationInfo.pUserData));
+    }
+}
+
+const char* MiniEngine::Graphics::ToString(MemoryCategory category)
+{
+    switch (category)
+    {
+    case MemoryCategory::Geometry:      return "geometry";
+    case MemoryCategory::Textures:      return "textures";
+    case MemoryCategory::RenderTargets: return "renderTargets";
+    case MemoryCategory::Staging:       return "staging";
+    case MemoryCategory::FrameData:     return "frameData";
+    default:                            return "unknown";
+    }
+}
+
+VulkanMemory::~VulkanMemory()
+{
+    Destroy();
+}
+
+bool VulkanMemory::Initialize(const VmaAllocatorCreateInfo& info, bool budgetExtension)
+{
+    Destroy();
+
+    VmaAllocatorCreateInfo allocatorInfo = info;
+    if (budgetExtension)
+    {
+        allocatorInfo.flags |= VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
+    }
+    if (vmaCreateAllocator(&allocatorInfo, &m_Allocator) != VK_SUCCESS)
+    {
+        spdlog::critical("Failed to create VMA allocator");
+        m_Allocator = VK_NULL_HANDLE;
+        return false;
+    }
+
+    m_Device = info.device;
+    m_BudgetExtension = budgetExtension;
+    spdlog::info("Memory budget: {}", budgetExtension ? "VK_EXT_memory_budget" : "estimated");
+    return true;
+}
+
+void VulkanMemory::Destroy()
+{
+    if (m_Allocator == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    spdlog::debug("Destroying VMA allocator");
+    EndDefragmentation();
+    vmaDestroyAllocator(m_Allocator);
+    m_Allocator = VK_NULL_HANDLE;
+    m_Device = VK_NULL_HANDLE;
+    m_MovableBuffers.clear();
+    m_EvictionHooks.clear();
+}
+
+bool VulkanMemory::CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VmaMemoryUsage memoryUsage, MemoryCategory category,
+                                VkBuffer& buffer, VmaAllocation& allocation, void** mapped)
+{
+    VkBufferCreateInfo bufferInfo{};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = size;
+    bufferInfo.usage = usage;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    VmaAllocationCreateInfo allocInfo = {};
+    allocInfo.usage = memoryUsage;
+    if (mapped)
+    {
+        allocInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+    }
+
+    VmaAllocationInfo allocationInfo = {};
+    if (vmaCreateBuffer(m_Allocator, &bufferInfo, &allocInfo, &buffer, &allocation, &allocationInfo) != VK_SUCCESS)
+    {
+        spdlog::critical("Failed to create {} buffer of {} bytes", ToString(category), size);
+        return false;
+    }
+    Track(allocation, category);
+
+    if (mapped)
+    {
+        *mapped = allocationInfo.pMappedData;
+    }
+    return true;
+}
+
+bool VulkanMemory::CreateImage(const VkImageCreateInfo& info, MemoryCategory category, VkImage& image, VmaAllocation& allocation)
+{
+    VmaAllocationCreateInfo allocInfo = {};
+    allocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+    if (vmaCreateImage(m_Allocator, &info, &allocInfo, &image, &allocation, nullptr) != VK_SUCCESS)
+    {
+        return false;
+    }
+    Track(allocation, category);
+    return true;
+}
+
+void VulkanMemory::DestroyBuffer(VkBuffer& buffer, VmaAllocation& allocation)
+{
+    if (allocation != VK_NULL_HANDLE)
+    {
+        VmaAllocationInfo allocationInfo = {};
+        vmaGetAllocationInfo(m_Allocator, allocation, &allocationInfo);
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        MemoryCategoryUsage& usage = m_Categories[static_cast<size_t>(GetAllocationCategory(allocationInfo))];
+        usage.bytes -= allocationInfo.size;
+        --usage.allocations;
+        m_MovableBuffers.erase(allocation);
+    }
+    vmaDestroyBuffer(m_Allocator, buffer, allocation);
+    buffer = VK_NULL_HANDLE;
+    allocation = VK_NULL_HANDLE;
+}
+
+void VulkanMemory::DestroyImage(VkImage& image, VmaAllocation& allocation)
+{
+    if (allocation != VK_NULL_HANDLE)
+    {
+        VmaAllocationInfo allocationInfo = {};
+        vmaGetAllocationInfo(m_Allocator, allocation, &allocationInfo);
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        MemoryCategoryUsage& usage = m_Categories[static_cast<size_t>(GetAllocationCategory(allocationInfo))];
+        usage.bytes -= allocationInfo.size;
+        --usage.allocations;
+    }
+    vmaDestroyImage(m_Allocator, image, allocation);
+    image = VK_NULL_HANDLE;
+    allocation = VK_NULL_HANDLE;
+}
+
+void VulkanMemory::Track(VmaAllocation allocation, MemoryCategory category)
+{
+    vmaSetAllocationUserData(m_Allocator, allocation, reinterpret_cast<void*>(static_cast<uintptr_t>(category)));
+    vmaSetAllocationName(m_Allocator, allocation, ToString(category));
+
+    VmaAllocationInfo allocationInfo = {};
+    vmaGetAllocationInfo(m_Allocator, allocation, &allocationInfo);
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    MemoryCategoryUsage& usage = m_Categories[static_cast<size_t>(category)];
+    usage.bytes += allocationInfo.size;
+    usage.peakBytes = std::max(usage.peakBytes, usage.bytes);
+    ++usage.allocations;
+}
+
+void VulkanMemory::RegisterMovableBuffer(VmaAllocation allocation, const MovableBuffer& movable)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_MovableBuffers[allocation] = movable;
+}
+
+std::array<MemoryCategoryUsage, MemoryCategoryCount> VulkanMemory::GetCategoryUsage() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Categories;
+}
+
+std::vector<MemoryHeapUsage> VulkanMemory::GetHeapUsage() const
+{
+    const VkPhysicalDeviceMemoryProperties* memoryProperties = nullptr;
+    vmaGetMemoryProperties(m_Allocator, &memoryProperties);
+
+    VmaBudget budgets[VK_MAX_MEMORY_HEAPS] = {};
+    vmaGetHeapBudgets(m_Allocator, budgets);
+
+    std::vector<MemoryHeapUsage> heaps(memoryProperties->memoryHeapCount);
+    for (uint32_t i = 0; i < memoryProperties->memoryHeapCount; ++i)
+    {
+        heaps[i].heapIndex = i;
+        heaps[i].deviceLocal = (memoryProperties->memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+        heaps[i].usage = budgets[i].usage;
+        heaps[i].budget = budgets[i].budget;
+        heaps[i].blockBytes = budgets[i].statistics.blockBytes;
+        heaps[i].allocationBytes = budgets[i].statistics.allocationBytes;
+    }
+    return heaps;
+}
+
+void VulkanMemory::AddEvictionHook(std::string name, MemoryEvictionHook hook)
+{
+    m_EvictionHooks.emplace_back(std::move(name), std::move(hook));
+}
+
+void VulkanMemory::UpdateBudget(uint32_t frameIndex)
+{
+    vmaSetCurrentFrameIndex(m_Allocator, ++m_FrameIndex);
+
+    VkDeviceSize overshoot = 0;
+    for (const MemoryHeapUsage& heap : GetHeapUsage())
+    {
+        const VkDeviceSize threshold = static_cast<VkDeviceSize>(static_cast<double>(heap.budget) * EvictionThreshold);
+        if (heap.deviceLocal && heap.usage > threshold)
+        {
+            overshoot += heap.usage - threshold;
+        }
+    }
+    if (overshoot == 0)
+    {
+        return;
+    }
+
+    VkDeviceSize released = 0;
+    for (auto& [name, hook] : m_EvictionHooks)
+    {
+        const VkDeviceSize bytes = hook(frameIndex, overshoot - released);
+        if (bytes > 0)
+        {
+            ++m_Evictions;
+            m_EvictedBytes += bytes;
+            released += bytes;
+            MINIENGINE_LOG_DEBUG("Memory eviction: {} released {:.1f} MiB", name, bytes / MiB);
+        }
+        if (released >= overshoot)
+        {
+            break;
+        }
+    }
+
+    MINIENGINE_LOG_WARN_RATE_LIMITED(2000, "Device-local memory {:.1f} MiB over {:.0f}% of its budget, eviction released {:.1f} MiB",
+                                     overshoot / MiB, EvictionThreshold * 100.0f, released / MiB);
+}
+
+VkDeviceSize VulkanMemory::GetUnusedBlockBytes() const
+{
+    VkDeviceSize unused = 0;
+    for (const MemoryHeapUsage& heap : GetHeapUsage())
+    {
+        unused += heap.blockBytes - heap.allocationBytes;
+    }
+    return unused;
+}
+
+bool VulkanMemory::WriteStats(const std::string& path) const
+{
+    std::string json = "{\n  \"heaps\": [";
+    const std::vector<MemoryHeapUsage> heaps = GetHeapUsage();
+    for (size_t i = 0; i < heaps.size(); ++i)
+    {
+        const MemoryHeapUsage& heap = heaps[i];
+        json += fmt::format("{}\n    {{ \"index\": {}, \"deviceLocal\": {}, \"usage\": {}, \"budget\": {}, \"blockBytes\": {}, \"allocationBytes\": {} }}",
+                            i == 0 ? "" : ",", heap.heapIndex, heap.deviceLocal, heap.usage, heap.budget, heap.blockBytes, heap.allocationBytes);
+    }
+    json += fmt::format("\n  ],\n  \"budgetExtension\": {},\n  \"categories\": {{", m_BudgetExtension);
+    const std::array<MemoryCategoryUsage, MemoryCategoryCount> categories = GetCategoryUsage();
+    for (size_t category = 0; category < MemoryCategoryCount; ++category)
+    {
+        const MemoryCategoryUsage& usage = categories[category];
+        json += fmt::format("{}\n    \"{}\": {{ \"bytes\": {}, \"peakBytes\": {}, \"allocations\": {} }}", category == 0 ? "" : ",",
+                            ToString(static_cast<MemoryCategory>(category)), usage.bytes, usage.peakBytes, usage.allocations);
+    }
+    const MemoryDefragmentationStats& defragmentation = m_DefragmentationStats;
+    json += fmt::format("\n  }},\n  \"eviction\": {{ \"count\": {}, \"bytes\": {} }},", m_Evictions, m_EvictedBytes);
+    json += fmt::format("\n  \"defragmentation\": {{ \"active\": {}, \"passes\": {}, \"allocationsMoved\": {}, \"movesIgnored\": {}, "
+                        "\"bytesMoved\": {}, \"bytesFreed\": {}, \"blocksFreed\": {} }},",
+                        IsDefragmenting(), defragmentation.passes, defragmentation.allocationsMoved, defragmentation.movesIgnored,
+                        defragmentation.bytesMoved, defragmentation.bytesFreed, defragmentation.blocksFreed);
+
+    // VMA's own detailed report, already JSON
+    char* allocatorStats = nullptr;
+    vmaBuildStatsString(m_Allocator, &allocatorStats, VK_TRUE);
+    json += fmt::format("\n  \"allocator\": {}\n}}\n", allocatorStats);
+    vmaFreeStatsString(m_Allocator, allocatorStats);
+
+    // Written next to the target and renamed over it, so a reader never sees half a file
+    const std::string temporaryPath = path + ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        if (!file.write(json.data(), static_cast<std::streamsize>(json.size())))
+        {
+            spdlog::error("Failed to write memory stats to {}", temporaryPath);
+            return false;
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(temporaryPath, path, error);
+    if (error)
+    {
+        spdlog::error("Failed to replace {}: {}", path, error.message());
+        return false;
+    }
+    return true;
+}
+
+std::string VulkanMemory::FormatOverlay() const
+{
+    VkDeviceSize usage = 0;
+    VkDeviceSize budget = 0;
+    for (const MemoryHeapUsage& heap : GetHeapUsage())
+    {
+        if (heap.deviceLocal)
+        {
+            usage += heap.usage;
+            budget += heap.budget;
+        }
+    }
+
+    const std::array<MemoryCategoryUsage, MemoryCategoryCount> categories = GetCategoryUsage();
+    auto megabytes = [&](MemoryCategory category)
+    {
+        return categories[static_cast<size_t>(category)].bytes / MiB;
+    };
+    return fmt::format("VRAM {:.0f}/{:.0f} MiB | geo {:.1f} tex {:.1f} rt {:.1f} stg {:.1f} frame {:.1f} MiB{}",
+                       usage / MiB, budget / MiB, megabytes(MemoryCategory::Geometry), megabytes(MemoryCategory::Textures),
+                       megabytes(MemoryCategory::RenderTargets), megabytes(MemoryCategory::Staging), megabytes(MemoryCategory::FrameData),
+                       IsDefragmenting() ? " | defragmenting" : "");
+}
+
+bool VulkanMemory::BeginDefragmentation()
+{
+    if (IsDefragmenting())
+    {
+        return true;
+    }
+
+    VmaDefragmentationInfo defragmentationInfo = {};
+    defragmentationInfo.flags = VMA_DEFRAGMENTATION_FLAG_ALGORITHM_BALANCED_BIT;
+    defragmentationInfo.maxBytesPerPass = DefragmentBytesPerPass;
+    defragmentationInfo.maxAllocationsPerPass = DefragmentMovesPerPass;
+    if (vmaBeginDefragmentation(m_Allocator, &defragmentationInfo, &m_Defragmentation) != VK_SUCCESS)
+    {
+        spdlog::error("Failed to begin memory defragmentation");
+        m_Defragmentation = VK_NULL_HANDLE;
+        return false;
+    }
+
+    m_DefragmentationStats = {};
+    spdlog::info("Memory defragmentation started");
+    return true;
+}
+
+void VulkanMemory::DefragmentIfWasteful()
+{
+    if (IsDefragmenting())
+    {
+        return;
+    }
+
+    VkDeviceSize blockBytes = 0;
+    VkDeviceSize allocationBytes = 0;
+    for (const MemoryHeapUsage& heap : GetHeapUsage())
+    {
+        blockBytes += heap.blockBytes;
+        allocationBytes += heap.allocationBytes;
+    }
+    const VkDeviceSize wastedBytes = blockBytes - allocationBytes;
+
+    // Waste has to grow well past what the last run left before another starts
+    m_WasteAtDefragmentation = std::min(m_WasteAtDefragmentation, wastedBytes);
+    if (wastedBytes > m_WasteAtDefragmentation + DefragmentMinWaste &&
+        wastedBytes > static_cast<VkDeviceSize>(static_cast<double>(blockBytes) * DefragmentWaste))
+    {
+        BeginDefragmentation();
+        m_WasteAtDefragmentation = wastedBytes;
+    }
+}
+
+bool VulkanMemory::Defragment(const ImmediateCommandsFunction& execute, uint32_t& buffersMoved)
+{
+    buffersMoved = 0;
+    if (!IsDefragmenting())
+    {
+        return false;
+    }
+
+    VmaDefragmentationPassMoveInfo passInfo = {};
+    VkResult result = vmaBeginDefragmentationPass(m_Allocator, m_Defragmentation, &passInfo);
+    if (result == VK_SUCCESS)
+    {
+        EndDefragmentation();
+        return false;
+    }
+    if (result != VK_INCOMPLETE)
+    {
+        spdlog::error("Memory defragmentation pass failed");
+        EndDefragmentation();
+        return false;
+    }
+
+    struct PendingMove
+    {
+        MovableBuffer* movable   = nullptr;
+        VkBuffer       newBuffer = VK_NULL_HANDLE;
+    };
+    std::vector<PendingMove> pending;
+    pending.reserve(passInfo.moveCount);
+    for (uint32_t i = 0; i < passInfo.moveCount; ++i)
+    {
+        VmaDefragmentationMove& move = passInfo.pMoves[i];
+        auto found = m_MovableBuffers.find(move.srcAllocation);
+        if (found == m_MovableBuffers.end())
+        {
+            move.operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_IGNORE;
+            ++m_DefragmentationStats.movesIgnored;
+            continue;
+        }
+
+        VkBufferCreateInfo bufferInfo{};
+        bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferInfo.size = found->second.size;
+        bufferInfo.usage = found->second.usage;
+        bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        VkBuffer newBuffer = VK_NULL_HANDLE;
+        if (vkCreateBuffer(m_Device, &bufferInfo, nullptr, &newBuffer) != VK_SUCCESS ||
+            vmaBindBufferMemory(m_Allocator, move.dstTmpAllocation, newBuffer) != VK_SUCCESS)
+        {
+            vkDestroyBuffer(m_Device, newBuffer, nullptr);
+            move.operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_IGNORE;
+            ++m_DefragmentationStats.movesIgnored;
+            continue;
+        }
+        pending.push_back({ &found->second, newBuffer });
+    }
+
+    // Ignored moves need no wait; copies and destroying the old buffers need every frame finished
+    if (!pending.empty())
+    {
+        vkDeviceWaitIdle(m_Device);
+        execute([&](VkCommandBuffer commandBuffer)
+        {
+            for (const PendingMove& move : pending)
+            {
+                VkBufferCopy region{ 0, 0, move.movable->size };
+                vkCmdCopyBuffer(commandBuffer, *move.movable->buffer, move.newBuffer, 1, &region);
+            }
+        });
+    }
+
+    // From here on each source allocation refers to the new memory
+    result = vmaEndDefragmentationPass(m_Allocator, m_Defragmentation, &passInfo);
+    ++m_DefragmentationStats.passes;
+
+    for (uint32_t i = 0; i < passInfo.moveCount; ++i)
+    {
+        const VmaDefragmentationMove& move = passInfo.pMoves[i];
+        if (move.operation != VMA_DEFRAGMENTATION_MOVE_OPERATION_COPY)
+        {
+            continue;
+        }
+        MovableBuffer& movable = m_MovableBuffers[move.srcAllocation];
+        if (movable.mapped != nullptr)
+        {
+            VmaAllocationInfo allocationInfo = {};
+            vmaGetAllocationInfo(m_Allocator, move.srcAllocation, &allocationInfo);
+            *movable.mapped = allocationInfo.pMappedData;
+        }
+    }
+    for (const PendingMove& move : pending)
+    {
+        vkDestroyBuffer(m_Device, *move.movable->buffer, nullptr);
+        *move.movable->buffer = move.newBuffer;
+        if (move.movable->relocated)
+        {
+            move.movable->relocated();
+        }
+    }
+    buffersMoved = static_cast<uint32_t>(pending.size());
+
+    if (result == VK_SUCCESS)
+    {
+        EndDefragmentation();
+        return false;
+    }
+    return true;
+}
+
+void VulkanMemory::EndDefragmentation()
+{
+    if (!IsDefragmenting())
+    {
+        return;
+    }
+
+    VmaDefragmentationStats stats = {};
+    vmaEndDefragmentation(m_Allocator, m_Defragmentation, &stats);
+    m_Defragmentation = VK_NULL_HANDLE;
+
+    MemoryDefragmentationStats& totals = m_DefragmentationStats;
+    totals.allocationsMoved = stats.allocationsMoved;
+    totals.bytesMoved = stats.bytesMoved;
+    totals.bytesFreed = stats.bytesFreed;
+    totals.blocksFreed = stats.deviceMemoryBlocksFreed;
+    spdlog::info("Memory defragmentation finished after {} passes: moved {} allocations ({:.1f} MiB), ignored {}, freed {} blocks ({:.1f} MiB)",
+                 totals.passes, totals.allocationsMoved, totals.bytesMoved / MiB, totals.movesIgnored, totals.blocksFreed, totals.bytesFreed / MiB);
+}
@@ -0,0 +1,835 @@
+#include "MiniEngine/Graphics/VulkanOcclusionCulling.hpp"
+
+#include "MiniEngine/Graphics/VulkanCommandEncoder.hpp"
+#include "MiniEngine/Graphics/VulkanDebugUtils.hpp"
+#include "MiniEngine/Graphics/VulkanQueues.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+using namespace MiniEngine::Graphics;
+
+namespace
+{
+    // Counters written by the culling shader, read back once the frame's fence has signaled
+    struct OcclusionCounters
+    {
+        uint32_t phase1Visible;      // Passed the test against last frame's pyramid
+        uint32_t phase2Visible;      // Failed it, but passed against this frame's pyramid
+        uint32_t occluded;           // Failed both and never reached the rasterizer
+        uint32_t meshletsTested;     // Of the visible objects
+        uint32_t drawCounts[2];      // Draws each phase wrote, totalled by the scan and read by its indirect draw
+        uint32_t meshletsBackfacing; // Every triangle facing away from the camera
+        uint32_t meshletsOutside;    // Outside the frustum, of an object that is not
+        uint32_t triangles;          // In the emitted draws
+        uint32_t padding[3];
+    };
+
+    // Push constants of the culling and scan shaders
+    struct CullStep
+    {
+        uint32_t phase; // 0 tests against last frame's pyramid, 1 retests what phase 0 rejected
+        uint32_t emit;  // 0 counts each object's draws, 1 writes them at the offsets the scan left
+    };
+
+    // GPU timestamps written around the passes of a frame
+    enum FrameTimestamp : uint32_t
+    {
+        TimestampFrameBegin,
+        TimestampPhase1Culled,
+        TimestampPhase1Drawn,
+        TimestampPhase2Culled,
+        TimestampFrameEnd,
+        TimestampCount
+    };
+
+    constexpr uint32_t MinObjectCapacity = 1024;
+    constexpr uint32_t SceneBindingCount = 9;
+    constexpr uint32_t PyramidBinding = 6;
+}
+
+VulkanOcclusionCulling::~VulkanOcclusionCulling()
+{
+    Destroy();
+}
+
+bool VulkanOcclusionCulling::Initialize(const VulkanContext& context, const OcclusionCullingInfo& info)
+{
+    Destroy();
+    m_Device = context.device;
+    m_Memory = context.memory;
+    m_DebugUtils = context.debugUtils;
+    m_MeshletBuffer = info.meshletBuffer;
+    m_DrawsPerObject = std::max(info.drawsPerObject, 1u);
+    m_DepthImage = info.depthImage;
+
+    // GPU timing needs timestamp support on the graphics queue
+    m_TimestampPeriod = MiniEngine::Graphics::GetTimestampPeriod(context.physicalDevice, context.queues->GetGraphics().family);
+    if (m_TimestampPeriod <= 0.0f)
+    {
+        spdlog::warn("Graphics queue does not support timestamps, GPU times will not be reported");
+    }
+
+    // Scene set: frame constants, objects, both phases' draw commands, visibility, counters, the pyramid, the mesh's meshlets
+    // and the draw offsets
+    VkDescriptorSetLayoutBinding sceneBindings[SceneBindingCount]{};
+    for (uint32_t i = 0; i < SceneBindingCount; ++i)
+    {
+        sceneBindings[i].binding = i;
+        sceneBindings[i].descriptorType = i == 0 ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER
+                                        : i == PyramidBinding ? VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER
+                                        : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        sceneBindings[i].descriptorCount = 1;
+        sceneBindings[i].stageFlags = i < 2 ? (VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_COMPUTE_BIT) : VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+
+    VkDescriptorSetLayoutCreateInfo sceneLayoutInfo{};
+    sceneLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    sceneLayoutInfo.bindingCount = SceneBindingCount;
+    sceneLayoutInfo.pBindings = sceneBindings;
+
+    if (vkCreateDescriptorSetLayout(m_Device, &sceneLayoutInfo, nullptr, &m_SceneSetLayout) != VK_SUCCESS)
+    {
+        spdlog::critical("Failed to create scene descriptor set layout");
+        return false;
+    }
+
+    // Reduction set: the level being read and the level being written
+    VkDescriptorSetLayoutBinding reduceBindings[2]{};
+    reduceBindings[0].binding = 0;
+    reduceBindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    reduceBindings[0].descriptorCount = 1;
+    reduceBindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    reduceBindings[1].binding = 1;
+    reduceBindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    reduceBindings[1].descriptorCount = 1;
+    reduceBindings[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+    VkDescriptorSetLayoutCreateInfo reduceLayoutInfo{};
+    reduceLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    reduceLayoutInfo.bindingCount = 2;
+    reduceLayoutInfo.pBindings = reduceBindings;
+
+    if (vkCreateDescriptorSetLayout(m_Device, &reduceLayoutInfo, nullptr, &m_ReduceSetLayout) != VK_SUCCESS)
+    {
+        spdlog::critical("Failed to create Hi-Z descriptor set layout");
+        return false;
+    }
+
+    // Compute pipelines; the culling and scan shaders get the step as a push constant
+    VkPushConstantRange stepRange{};
+    stepRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    stepRange.offset = 0;
+    stepRange.size = sizeof(CullStep);
+
+    VkPipelineLayoutCreateInfo cullLayoutInfo{};
+    cullLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    cullLayoutInfo.setLayoutCount = 1;
+    cullLayoutInfo.pSetLayouts = &m_SceneSetLayout;
+    cullLayoutInfo.pushConstantRangeCount = 1;
+    cullLayoutInfo.pPushConstantRanges = &stepRange;
+
+    VkPipelineLayoutCreateInfo reducePipelineLayoutInfo{};
+    reducePipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    reducePipelineLayoutInfo.setLayoutCount = 1;
+    reducePipelineLayoutInfo.pSetLayouts = &m_ReduceSetLayout;
+
+    if (vkCreatePipelineLayout(m_Device, &cullLayoutInfo, nullptr, &m_CullPipelineLayout) != VK_SUCCESS ||
+        vkCreatePipelineLayout(m_Device, &reducePipelineLayoutInfo, nullptr, &m_ReducePipelineLayout) != VK_SUCCESS)
+    {
+        spdlog::critical("Failed to create occlusion culling pipeline layouts");
+        return false;
+    }
+
+    if (!CreateComputePipeline(context, m_CullPipelineLayout, info.cullShader, m_CullPipeline) ||
+        !CreateComputePipeline(context, m_CullPipelineLayout, info.scanShader, m_ScanPipeline) ||
+        !CreateComputePipeline(context, m_ReducePipelineLayout, info.reduceShader, m_ReducePipeline))
+    {
+        return false;
+    }
+
+    // Shaders only use texelFetch; the sampler exists because sampled images need one
+    VkSamplerCreateInfo samplerInfo{};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter = VK_FILTER_NEAREST;
+    samplerInfo.minFilter = VK_FILTER_NEAREST;
+    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+
+    if (vkCreateSampler(m_Device, &samplerInfo, nullptr, &m_PyramidSampler) != VK_SUCCESS)
+    {
+        spdlog::critical("Failed to create Hi-Z sampler");
+        return false;
+    }
+
+    // Pyramid: level 0 is half the depth resolution, each texel holds the farthest depth it covers
+    m_PyramidExtent.width = std::max(1u, (info.depthExtent.width + 1) / 2);
+    m_PyramidExtent.height = std::max(1u, (info.depthExtent.height + 1) / 2);
+    m_PyramidMipCount = 1;
+    while ((std::max(m_PyramidExtent.width, m_PyramidExtent.height) >> m_PyramidMipCount) > 0)
+    {
+        ++m_PyramidMipCount;
+    }
+
+    VkImageCreateInfo pyramidInfo{};
+    pyramidInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    pyramidInfo.imageType = VK_IMAGE_TYPE_2D;
+    pyramidInfo.format = VK_FORMAT_R32_SFLOAT;
+    pyramidInfo.extent = { m_PyramidExtent.width, m_PyramidExtent.height, 1 };
+    pyramidInfo.mipLevels = m_PyramidMipCount;
+    pyramidInfo.arrayLayers = 1;
+    pyramidInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    pyramidInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    pyramidInfo.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    pyramidInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    pyramidInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    if (!m_Memory->CreateImage(pyramidInfo, MemoryCategory::RenderTargets, m_PyramidImage, m_PyramidAllocation))
+    {
+        spdlog::critical("Failed to create Hi-Z pyramid image");
+        return false;
+    }
+    m_DebugUtils->SetObjectName(VK_OBJECT_TYPE_IMAGE, m_PyramidImage, "Hi-Z pyramid");
+
+    VkImageViewCreateInfo pyramidViewInfo{};
+    pyramidViewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    pyramidViewInfo.image = m_PyramidImage;
+    pyramidViewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    pyramidViewInfo.format = VK_FORMAT_R32_SFLOAT;
+    pyramidViewInfo.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, m_PyramidMipCount, 0, 1 };
+
+    if (vkCreateImageView(m_Device, &pyramidViewInfo, nullptr, &m_PyramidView) != VK_SUCCESS)
+    {
+        spdlog::critical("Failed to create Hi-Z pyramid view");
+        return false;
+    }
+
+    m_PyramidMipViews.assign(m_PyramidMipCount, VK_NULL_HANDLE);
+    for (uint32_t mip = 0; mip < m_PyramidMipCount; ++mip)
+    {
+        pyramidViewInfo.subresourceRange.baseMipLevel = mip;
+        pyramidViewInfo.subresourceRange.levelCount = 1;
+        if (vkCreateImageView(m_Device, &pyramidViewInfo, nullptr, &m_PyramidMipViews[mip]) != VK_SUCCESS)
+        {
+            spdlog::critical("Failed to create Hi-Z pyramid view for mip {}", mip);
+            return false;
+        }
+    }
+
+    // The pyramid lives in the general layout, written as a storage image and read as a sampled one
+    const bool transitioned = context.executeImmediate([&](VkCommandBuffer commandBuffer)
+    {
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = m_PyramidImage;
+        barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, m_PyramidMipCount, 0, 1 };
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+    });
+    if (!transitioned)
+    {
+        return false;
+    }
+
+    // Descriptor pool for one scene set per frame and one reduction set per mip
+    const uint32_t frameCount = context.framesInFlight;
+    VkDescriptorPoolSize poolSizes[] = {
+        { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, frameCount },
+        { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, frameCount * (SceneBindingCount - 2) },
+        { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, frameCount + m_PyramidMipCount },
+        { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, m_PyramidMipCount },
+    };
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets = frameCount + m_PyramidMipCount;
+    poolInfo.poolSizeCount = 4;
+    poolInfo.pPoolSizes = poolSizes;
+
+    if (vkCreateDescriptorPool(m_Device, &poolInfo, nullptr, &m_DescriptorPool) != VK_SUCCESS)
+    {
+        spdlog::critical("Failed to create occlusion culling descriptor pool");
+        return false;
+    }
+
+    // Reduction sets: mip 0 reads the depth buffer, every later mip reads the one before it
+    std::vector<VkDescriptorSetLayout> reduceLayouts(m_PyramidMipCount, m_ReduceSetLayout);
+    VkDescriptorSetAllocateInfo reduceAllocInfo{};
+    reduceAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    reduceAllocInfo.descriptorPool = m_DescriptorPool;
+    reduceAllocInfo.descriptorSetCount = m_PyramidMipCount;
+    reduceAllocInfo.pSetLayouts = reduceLayouts.data();
+
+    m_ReduceSets.assign(m_PyramidMipCount, VK_NULL_HANDLE);
+    if (vkAllocateDescriptorSets(m_Device, &reduceAllocInfo, m_ReduceSets.data()) != VK_SUCCESS)
+    {
+        spdlog::critical("Failed to allocate Hi-Z descriptor sets");
+        return false;
+    }
+
+    for (uint32_t mip = 0; mip < m_PyramidMipCount; ++mip)
+    {
+        VkDescriptorImageInfo sourceInfo{};
+        sourceInfo.sampler = m_PyramidSampler;
+        sourceInfo.imageView = mip == 0 ? info.depthView : m_PyramidMipViews[mip - 1];
+        sourceInfo.imageLayout = mip == 0 ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_GENERAL;
+
+        VkDescriptorImageInfo destinationInfo{};
+        destinationInfo.imageView = m_PyramidMipViews[mip];
+        destinationInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+        VkWriteDescriptorSet writes[2]{};
+        writes[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[0].dstSet = m_ReduceSets[mip];
+        writes[0].dstBinding = 0;
+        writes[0].descriptorCount = 1;
+        writes[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        writes[0].pImageInfo = &sourceInfo;
+        writes[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[1].dstSet = m_ReduceSets[mip];
+        writes[1].dstBinding = 1;
+        writes[1].descriptorCount = 1;
+        writes[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        writes[1].pImageInfo = &destinationInfo;
+        vkUpdateDescriptorSets(m_Device, 2, writes, 0, nullptr);
+    }
+
+    // Per-frame resources. Sized once: relocation callbacks hold on to the frames.
+    m_Frames.resize(frameCount);
+    for (Frame& frame : m_Frames)
+    {
+        if (!m_Memory->CreateBuffer(sizeof(OcclusionUniforms), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU, MemoryCategory::FrameData,
+                                    frame.uniformBuffer, frame.uniformAllocation, &frame.uniformMapped) ||
+            !m_Memory->CreateBuffer(sizeof(OcclusionCounters), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                    VMA_MEMORY_USAGE_GPU_TO_CPU, MemoryCategory::FrameData, frame.counterBuffer, frame.counterAllocation, &frame.counterMapped))
+        {
+            return false;
+        }
+
+        if (m_TimestampPeriod > 0.0f)
+        {
+            VkQueryPoolCreateInfo queryPoolInfo{};
+            queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+            queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+            queryPoolInfo.queryCount = TimestampCount;
+
+            if (vkCreateQueryPool(m_Device, &queryPoolInfo, nullptr, &frame.timestampPool) != VK_SUCCESS)
+            {
+                spdlog::critical("Failed to create timestamp query pool");
+                return false;
+            }
+        }
+
+        VkDescriptorSetAllocateInfo sceneAllocInfo{};
+        sceneAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        sceneAllocInfo.descriptorPool = m_DescriptorPool;
+        sceneAllocInfo.descriptorSetCount = 1;
+        sceneAllocInfo.pSetLayouts = &m_SceneSetLayout;
+
+        if (vkAllocateDescriptorSets(m_Device, &sceneAllocInfo, &frame.descriptorSet) != VK_SUCCESS)
+        {
+            spdlog::critical("Failed to allocate scene descriptor set");
+            return false;
+        }
+
+        // Object buffers start small and grow with the visible set
+        if (!ReserveObjects(frame, MinObjectCapacity))
+        {
+            return false;
+        }
+    }
+
+    spdlog::info("Occlusion culling created, Hi-Z pyramid {}x{} with {} mips", m_PyramidExtent.width, m_PyramidExtent.height, m_PyramidMipCount);
+    return true;
+}
+
+void VulkanOcclusionCulling::Destroy()
+{
+    if (m_Device == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    for (Frame& frame : m_Frames)
+    {
+        if (frame.timestampPool != VK_NULL_HANDLE)
+        {
+            vkDestroyQueryPool(m_Device, frame.timestampPool, nullptr);
+        }
+        m_Memory->DestroyBuffer(frame.uniformBuffer, frame.uniformAllocation);
+        m_Memory->DestroyBuffer(frame.counterBuffer, frame.counterAllocation);
+        m_Memory->DestroyBuffer(frame.objectBuffer, frame.objectAllocation);
+        m_Memory->DestroyBuffer(frame.drawCommandBuffers[0], frame.drawCommandAllocations[0]);
+        m_Memory->DestroyBuffer(frame.drawCommandBuffers[1], frame.drawCommandAllocations[1]);
+        m_Memory->DestroyBuffer(frame.visibilityBuffer, frame.visibilityAllocation);
+        m_Memory->DestroyBuffer(frame.drawOffsetBuffer, frame.drawOffsetAllocation);
+    }
+    m_Frames.clear();
+
+    // Destroying the pool frees every set allocated from it
+    if (m_DescriptorPool != VK_NULL_HANDLE)
+    {
+        vkDestroyDescriptorPool(m_Device, m_DescriptorPool, nullptr);
+        m_DescriptorPool = VK_NULL_HANDLE;
+    }
+    m_ReduceSets.clear();
+
+    for (VkImageView view : m_PyramidMipViews)
+    {
+        if (view != VK_NULL_HANDLE)
+        {
+            vkDestroyImageView(m_Device, view, nullptr);
+        }
+    }
+    m_PyramidMipViews.clear();
+
+    if (m_PyramidView != VK_NULL_HANDLE)
+    {
+        vkDestroyImageView(m_Device, m_PyramidView, nullptr);
+        m_PyramidView = VK_NULL_HANDLE;
+    }
+    m_Memory->DestroyImage(m_PyramidImage, m_PyramidAllocation);
+    if (m_PyramidSampler != VK_NULL_HANDLE)
+    {
+        vkDestroySampler(m_Device, m_PyramidSampler, nullptr);
+        m_PyramidSampler = VK_NULL_HANDLE;
+    }
+
+    for (VkPipeline* pipeline : { &m_CullPipeline, &m_ScanPipeline, &m_ReducePipeline })
+    {
+        if (*pipeline != VK_NULL_HANDLE)
+        {
+            vkDestroyPipeline(m_Device, *pipeline, nullptr);
+            *pipeline = VK_NULL_HANDLE;
+        }
+    }
+    for (VkPipelineLayout* layout : { &m_CullPipelineLayout, &m_ReducePipelineLayout })
+    {
+        if (*layout != VK_NULL_HANDLE)
+        {
+            vkDestroyPipelineLayout(m_Device, *layout, nullptr);
+            *layout = VK_NULL_HANDLE;
+        }
+    }
+    for (VkDescriptorSetLayout* layout : { &m_SceneSetLayout, &m_ReduceSetLayout })
+    {
+        if (*layout != VK_NULL_HANDLE)
+        {
+            vkDestroyDescriptorSetLayout(m_Device, *layout, nullptr);
+            *layout = VK_NULL_HANDLE;
+        }
+    }
+
+    m_PyramidValid = false;
+    m_Device = VK_NULL_HANDLE;
+    spdlog::debug("Occlusion culling destroyed");
+}
+
+bool VulkanOcclusionCulling::PrepareFrame(uint32_t frameIndex, std::span<const OcclusionObject> objects, OcclusionUniforms& uniforms)
+{
+    Frame& frame = m_Frames[frameIndex];
+    ReadResults(frame);
+
+    const uint32_t objectCount = static_cast<uint32_t>(objects.size());
+    if (!ReserveObjects(frame, objectCount))
+    {
+        return false;
+    }
+    if (objectCount > 0)
+    {
+        std::memcpy(frame.objectMapped, objects.data(), objects.size_bytes());
+        vmaFlushAllocation(m_Memory->GetAllocator(), frame.objectAllocation, 0, objects.size_bytes());
+    }
+
+    uniforms.previousViewProjection = m_PreviousViewProjection;
+    uniforms.previousRenderScale = m_PreviousRenderScale;
+    uniforms.pyramidSize = glm::vec2(static_cast<float>(m_PyramidExtent.width), static_cast<float>(m_PyramidExtent.height));
+    uniforms.pyramidMipCount = m_PyramidMipCount;
+    uniforms.pyramidValid = m_PyramidValid ? 1 : 0;
+    uniforms.objectCount = objectCount;
+    uniforms.occlusionEnabled = m_Enabled ? 1 : 0;
+    uniforms.meshletCulling = m_MeshletCulling ? 1 : 0;
+    std::memcpy(frame.uniformMapped, &uniforms, sizeof(uniforms));
+    vmaFlushAllocation(m_Memory->GetAllocator(), frame.uniformAllocation, 0, sizeof(uniforms));
+
+    frame.objectCount = objectCount;
+    frame.occlusionEnabled = m_Enabled;
+    frame.viewProjection = uniforms.viewProjection;
+    frame.renderScale = uniforms.renderScale;
+    return true;
+}
+
+void VulkanOcclusionCulling::MarkSubmitted(uint32_t frameIndex)
+{
+    Frame& frame = m_Frames[frameIndex];
+    frame.submitted = true;
+
+    m_PreviousViewProjection = frame.viewProjection;
+    m_PreviousRenderScale = frame.renderScale;
+    m_PyramidValid = frame.occlusionEnabled;
+}
+
+void VulkanOcclusionCulling::RecordPhase1(VulkanCommandEncoder& encoder, uint32_t frameIndex)
+{
+    Frame& frame = m_Frames[frameIndex];
+    VkCommandBuffer commandBuffer = encoder.GetCommandBuffer();
+
+    if (frame.timestampPool != VK_NULL_HANDLE)
+    {
+        vkCmdResetQueryPool(commandBuffer, frame.timestampPool, 0, TimestampCount);
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, frame.timestampPool, TimestampFrameBegin);
+    }
+
+    m_DebugUtils->BeginLabel(commandBuffer, "Occlusion culling, phase 1");
+
+    // Reset the counters before the culling shader accumulates into them
+    vkCmdFillBuffer(commandBuffer, frame.counterBuffer, 0, sizeof(OcclusionCounters), 0);
+
+    VkMemoryBarrier counterBarrier{};
+    counterBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    counterBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    counterBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &counterBarrier, 0, nullptr, 0, nullptr);
+
+    RecordCulling(encoder, frame, 0);
+    m_DebugUtils->EndLabel(commandBuffer);
+
+    if (frame.timestampPool != VK_NULL_HANDLE)
+    {
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frame.timestampPool, TimestampPhase1Culled);
+    }
+}
+
+void VulkanOcclusionCulling::RecordPhase2(VulkanCommandEncoder& encoder, uint32_t frameIndex)
+{
+    Frame& frame = m_Frames[frameIndex];
+    VkCommandBuffer commandBuffer = encoder.GetCommandBuffer();
+
+    if (frame.timestampPool != VK_NULL_HANDLE)
+    {
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frame.timestampPool, TimestampPhase1Drawn);
+    }
+
+    if (frame.occlusionEnabled)
+    {
+        m_DebugUtils->BeginLabel(commandBuffer, "Occlusion culling, phase 2");
+        RecordDepthPyramid(encoder);
+        RecordCulling(encoder, frame, 1);
+        m_DebugUtils->EndLabel(commandBuffer);
+    }
+
+    if (frame.timestampPool != VK_NULL_HANDLE)
+    {
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frame.timestampPool, TimestampPhase2Culled);
+    }
+}
+
+void VulkanOcclusionCulling::RecordDraws(VulkanCommandEncoder& encoder, uint32_t frameIndex, uint32_t phase)
+{
+    // The culling shader packs the draws it keeps in object order and counts them for the indirect draw
+    const Frame& frame = m_Frames[frameIndex];
+    encoder.DrawIndexedIndirectCount(frame.drawCommandBuffers[phase], 0, frame.counterBuffer, offsetof(OcclusionCounters, drawCounts) + sizeof(uint32_t) * phase,
+                                     frame.objectCapacity * m_DrawsPerObject, sizeof(VkDrawIndexedIndirectCommand));
+}
+
+void VulkanOcclusionCulling::RecordFrameEnd(VkCommandBuffer commandBuffer, uint32_t frameIndex)
+{
+    const Frame& frame = m_Frames[frameIndex];
+    if (frame.timestampPool != VK_NULL_HANDLE)
+    {
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frame.timestampPool, TimestampFrameEnd);
+    }
+}
+
+VkDeviceSize VulkanOcclusionCulling::Trim(uint32_t frameIndex)
+{
+    Frame& frame = m_Frames[frameIndex];
+    const uint32_t needed = std::max(frame.objectCount, MinObjectCapacity);
+    if (frame.objectCapacity <= needed * 2)
+    {
+        return 0;
+    }
+
+    const VkDeviceSize before = m_Memory->GetCategoryUsage()[static_cast<size_t>(MemoryCategory::FrameData)].bytes;
+    frame.objectCapacity = 0;
+    if (!ReserveObjects(frame, needed))
+    {
+        return 0;
+    }
+    const VkDeviceSize after = m_Memory->GetCategoryUsage()[static_cast<size_t>(MemoryCategory::FrameData)].bytes;
+    return before > after ? before - after : 0;
+}
+
+// Points the frame's descriptor set at its current buffers
+void VulkanOcclusionCulling::WriteDescriptorSet(Frame& frame)
+{
+    VkDescriptorBufferInfo bufferInfos[SceneBindingCount] = {
+        { frame.uniformBuffer, 0, VK_WHOLE_SIZE },
+        { frame.objectBuffer, 0, VK_WHOLE_SIZE },
+        { frame.drawCommandBuffers[0], 0, VK_WHOLE_SIZE },
+        { frame.drawCommandBuffers[1], 0, VK_WHOLE_SIZE },
+        { frame.visibilityBuffer, 0, VK_WHOLE_SIZE },
+        { frame.counterBuffer, 0, VK_WHOLE_SIZE },
+        {},
+        { m_MeshletBuffer, 0, VK_WHOLE_SIZE },
+        { frame.drawOffsetBuffer, 0, VK_WHOLE_SIZE },
+    };
+
+    VkDescriptorImageInfo pyramidInfo{};
+    pyramidInfo.sampler = m_PyramidSampler;
+    pyramidInfo.imageView = m_PyramidView;
+    pyramidInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+    VkWriteDescriptorSet writes[SceneBindingCount]{};
+    for (uint32_t i = 0; i < SceneBindingCount; ++i)
+    {
+        writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[i].dstSet = frame.descriptorSet;
+        writes[i].dstBinding = i;
+        writes[i].descriptorCount = 1;
+        if (i == 0)
+        {
+            writes[i].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+            writes[i].pBufferInfo = &bufferInfos[i];
+        }
+        else if (i == PyramidBinding)
+        {
+            writes[i].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            writes[i].pImageInfo = &pyramidInfo;
+        }
+        else
+        {
+            writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            writes[i].pBufferInfo = &bufferInfos[i];
+        }
+    }
+    vkUpdateDescriptorSets(m_Device, SceneBindingCount, writes, 0, nullptr);
+}
+
+// Grows the per-object buffers of a frame that is not in flight and points its descriptor set at them
+bool VulkanOcclusionCulling::ReserveObjects(Frame& frame, uint32_t objectCount)
+{
+    if (objectCount <= frame.objectCapacity)
+    {
+        return true;
+    }
+
+    uint32_t capacity = std::max(frame.objectCapacity, MinObjectCapacity);
+    while (capacity < objectCount)
+    {
+        capacity *= 2;
+    }
+
+    m_Memory->DestroyBuffer(frame.objectBuffer, frame.objectAllocation);
+    m_Memory->DestroyBuffer(frame.drawCommandBuffers[0], frame.drawCommandAllocations[0]);
+    m_Memory->DestroyBuffer(frame.drawCommandBuffers[1], frame.drawCommandAllocations[1]);
+    m_Memory->DestroyBuffer(frame.visibilityBuffer, frame.visibilityAllocation);
+    m_Memory->DestroyBuffer(frame.drawOffsetBuffer, frame.drawOffsetAllocation);
+    frame.objectCapacity = 0;
+
+    // Transfer usage lets defragmentation copy them elsewhere
+    const VkBufferUsageFlags movableUsage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    const VkBufferUsageFlags storageUsage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | movableUsage;
+    const VkBufferUsageFlags drawUsage = storageUsage | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+    const VkDeviceSize objectBytes = sizeof(OcclusionObject) * capacity;
+    const VkDeviceSize drawBytes = sizeof(VkDrawIndexedIndirectCommand) * capacity * m_DrawsPerObject;
+    const VkDeviceSize countBytes = sizeof(uint32_t) * capacity;
+    if (!m_Memory->CreateBuffer(objectBytes, storageUsage, VMA_MEMORY_USAGE_CPU_TO_GPU, MemoryCategory::FrameData,
+                                frame.objectBuffer, frame.objectAllocation, &frame.objectMapped) ||
+        !m_Memory->CreateBuffer(drawBytes, drawUsage, VMA_MEMORY_USAGE_GPU_ONLY, MemoryCategory::FrameData,
+                                frame.drawCommandBuffers[0], frame.drawCommandAllocations[0]) ||
+        !m_Memory->CreateBuffer(drawBytes, drawUsage, VMA_MEMORY_USAGE_GPU_ONLY, MemoryCategory::FrameData,
+                                frame.drawCommandBuffers[1], frame.drawCommandAllocations[1]) ||
+        !m_Memory->CreateBuffer(countBytes, storageUsage, VMA_MEMORY_USAGE_GPU_ONLY, MemoryCategory::FrameData,
+                                frame.visibilityBuffer, frame.visibilityAllocation) ||
+        !m_Memory->CreateBuffer(countBytes, storageUsage, VMA_MEMORY_USAGE_GPU_ONLY, MemoryCategory::FrameData,
+                                frame.drawOffsetBuffer, frame.drawOffsetAllocation))
+    {
+        return false;
+    }
+    frame.objectCapacity = capacity;
+    WriteDescriptorSet(frame);
+
+    auto relocated = [this, &frame] { WriteDescriptorSet(frame); };
+    m_Memory->RegisterMovableBuffer(frame.objectAllocation, { &frame.objectBuffer, &frame.objectMapped, objectBytes, storageUsage, relocated });
+    for (uint32_t phase = 0; phase < 2; ++phase)
+    {
+        m_Memory->RegisterMovableBuffer(frame.drawCommandAllocations[phase], { &frame.drawCommandBuffers[phase], nullptr, drawBytes, drawUsage, relocated });
+    }
+    m_Memory->RegisterMovableBuffer(frame.visibilityAllocation, { &frame.visibilityBuffer, nullptr, countBytes, storageUsage, relocated });
+    m_Memory->RegisterMovableBuffer(frame.drawOffsetAllocation, { &frame.drawOffsetBuffer, nullptr, countBytes, storageUsage, relocated });
+
+    spdlog::debug("Occlusion culling buffers sized for {} objects", capacity);
+    return true;
+}
+
+// Collects counters and timestamps of the frame's previous submission; its fence must have signaled
+void VulkanOcclusionCulling::ReadResults(Frame& frame)
+{
+    if (!frame.submitted)
+    {
+        return;
+    }
+
+    OcclusionCounters counters;
+    vmaInvalidateAllocation(m_Memory->GetAllocator(), frame.counterAllocation, 0, sizeof(counters));
+    std::memcpy(&counters, frame.counterMapped, sizeof(counters));
+
+    m_Stats.frustumVisible = frame.objectCount;
+    m_Stats.phase1Visible = counters.phase1Visible;
+    m_Stats.phase2Visible = counters.phase2Visible;
+    m_Stats.occluded = counters.occluded;
+    m_Stats.meshletsTested = counters.meshletsTested;
+    m_Stats.meshletsBackfacing = counters.meshletsBackfacing;
+    m_Stats.meshletsOutside = counters.meshletsOutside;
+    m_Stats.draws = counters.drawCounts[0] + counters.drawCounts[1];
+    m_Stats.triangles = counters.triangles;
+
+    if (frame.timestampPool == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    uint64_t timestamps[TimestampCount];
+    if (vkGetQueryPoolResults(m_Device, frame.timestampPool, 0, TimestampCount, sizeof(timestamps), timestamps,
+                              sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) != VK_SUCCESS)
+    {
+        return;
+    }
+
+    const double ticksToMs = m_TimestampPeriod / 1e6;
+    const double frameMs = (timestamps[TimestampFrameEnd] - timestamps[TimestampFrameBegin]) * ticksToMs;
+    const double cullMs = ((timestamps[TimestampPhase1Culled] - timestamps[TimestampFrameBegin])
+        + (timestamps[TimestampPhase2Culled] - timestamps[TimestampPhase1Drawn])) * ticksToMs;
+
+    // Smoothed separately per mode, so toggling gives a direct comparison
+    const int mode = frame.occlusionEnabled ? 1 : 0;
+    if (m_Stats.samples[mode] == 0)
+    {
+        m_Stats.gpuFrameMs[mode] = frameMs;
+        m_Stats.gpuCullMs[mode] = cullMs;
+    }
+    else
+    {
+        m_Stats.gpuFrameMs[mode] += (frameMs - m_Stats.gpuFrameMs[mode]) * 0.05;
+        m_Stats.gpuCullMs[mode] += (cullMs - m_Stats.gpuCullMs[mode]) * 0.05;
+    }
+    ++m_Stats.samples[mode];
+}
+
+// One phase of culling in three dispatches: count each object's draws, scan the counts into offsets,
+// then write the draws at them. The draws keep the order of the objects, which the caller may have
+// sorted front to back; appending them through an atomic counter would leave them in whatever order
+// the invocations happened to run.
+void VulkanOcclusionCulling::RecordCulling(VulkanCommandEncoder& encoder, Frame& frame, uint32_t phase)
+{
+    VkCommandBuffer commandBuffer = encoder.GetCommandBuffer();
+    const uint32_t groupCount = (frame.objectCapacity + 63) / 64;
+
+    // Each dispatch reads what the one before it wrote
+    VkMemoryBarrier stepBarrier{};
+    stepBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    stepBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    stepBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+    CullStep step = { phase, 0 };
+    encoder.BindPipeline(VK_PIPELINE_BIND_POINT_COMPUTE, m_CullPipeline);
+    encoder.BindDescriptorSets(VK_PIPELINE_BIND_POINT_COMPUTE, m_CullPipelineLayout, 0, 1, &frame.descriptorSet);
+    encoder.PushConstants(m_CullPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(step), &step);
+    if (groupCount > 0)
+    {
+        encoder.Dispatch(groupCount, 1, 1);
+    }
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &stepBarrier, 0, nullptr, 0, nullptr);
+
+    encoder.BindPipeline(VK_PIPELINE_BIND_POINT_COMPUTE, m_ScanPipeline);
+    encoder.Dispatch(1, 1, 1);
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &stepBarrier, 0, nullptr, 0, nullptr);
+
+    step.emit = 1;
+    encoder.BindPipeline(VK_PIPELINE_BIND_POINT_COMPUTE, m_CullPipeline);
+    encoder.PushConstants(m_CullPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(step), &step);
+    if (groupCount > 0)
+    {
+        encoder.Dispatch(groupCount, 1, 1);
+    }
+
+    // The draws and their count feed the indirect draws; the second phase reads visibility
+    VkMemoryBarrier cullBarrier = stepBarrier;
+    cullBarrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | (phase == 0 ? VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT : 0);
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | (phase == 0 ? VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT : 0),
+                         0, 1, &cullBarrier, 0, nullptr, 0, nullptr);
+}
+
+void VulkanOcclusionCulling::RecordDepthPyramid(VulkanCommandEncoder& encoder)
+{
+    VkCommandBuffer commandBuffer = encoder.GetCommandBuffer();
+
+    // Depth goes from attachment to sampled, and the previous pyramid must be done being read
+    VkImageMemoryBarrier barriers[2]{};
+    barriers[0].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barriers[0].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    barriers[0].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    barriers[0].oldLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+    barriers[0].newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+    barriers[0].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barriers[0].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barriers[0].image = m_DepthImage;
+    barriers[0].subresourceRange = { VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, 0, 1 };
+
+    barriers[1].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barriers[1].srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    barriers[1].dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barriers[1].oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+    barriers[1].newLayout = VK_IMAGE_LAYOUT_GENERAL;
+    barriers[1].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barriers[1].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barriers[1].image = m_PyramidImage;
+    barriers[1].subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, m_PyramidMipCount, 0, 1 };
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         0, 0, nullptr, 0, nullptr, 2, barriers);
+
+    encoder.BindPipeline(VK_PIPELINE_BIND_POINT_COMPUTE, m_ReducePipeline);
+
+    // Each level reads the one below, so every dispatch waits for the previous one
+    VkImageMemoryBarrier levelBarrier = barriers[1];
+    levelBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    levelBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    levelBarrier.subresourceRange.levelCount = 1;
+
+    for (uint32_t mip = 0; mip < m_PyramidMipCount; ++mip)
+    {
+        const uint32_t width = std::max(1u, m_PyramidExtent.width >> mip);
+        const uint32_t height = std::max(1u, m_PyramidExtent.height >> mip);
+
+        encoder.BindDescriptorSets(VK_PIPELINE_BIND_POINT_COMPUTE, m_ReducePipelineLayout, 0, 1, &m_ReduceSets[mip]);
+        encoder.Dispatch((width + 7) / 8, (height + 7) / 8, 1);
+
+        levelBarrier.subresourceRange.baseMipLevel = mip;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             0, 0, nullptr, 0, nullptr, 1, &levelBarrier);
+    }
+
+    // Depth back to an attachment for the second phase
+    VkImageMemoryBarrier depthBarrier = barriers[0];
+    depthBarrier.srcAccessMask = 0;
+    depthBarrier.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    depthBarrier.oldLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+    depthBarrier.newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
+                         0, 0, nullptr, 0, nullptr, 1, &depthBarrier);
+}
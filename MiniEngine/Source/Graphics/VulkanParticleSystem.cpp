@@ -0,0 +1,612 @@
+#include "MiniEngine/Graphics/VulkanParticleSystem.hpp"
+
+#include "MiniEngine/Graphics/VulkanDebugUtils.hpp"
+#include "MiniEngine/Graphics/VulkanQueues.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+using namespace MiniEngine::Graphics;
+
+namespace
+{
+    // Simulation state of one particle and what the vertex shader draws for it (std430 layouts)
+    struct GpuParticle
+    {
+        glm::vec4 positionLife;     // Remaining life in seconds in w
+        glm::vec4 velocityLifetime; // Total life in seconds in w
+    };
+
+    struct GpuParticleInstance
+    {
+        glm::vec4 positionSize;
+        glm::vec4 color;
+    };
+
+    // Per-frame constants of the particle passes (std140 layout)
+    struct ParticleUniforms
+    {
+        glm::mat4 viewProjection;
+        glm::vec4 cameraRight; // Particle size in w
+        glm::vec4 cameraUp;
+        glm::vec4 emitterPositionRadius;
+        glm::vec4 gravityDeltaTime;
+        uint32_t  emitCount;
+        uint32_t  capacity;
+        uint32_t  seed;
+        float     lifetime;
+    };
+
+    // Bookkeeping of the particle passes, only ever touched by the GPU (std430 layout)
+    struct ParticleCounters
+    {
+        uint32_t                  aliveCount;
+        uint32_t                  nextAliveCount;
+        uint32_t                  deadCount;
+        uint32_t                  emitCount;
+        uint32_t                  emitFirst;
+        uint32_t                  currentList;
+        uint32_t                  padding[2];
+        VkDispatchIndirectCommand emitDispatch;
+        uint32_t                  emitPadding;
+        VkDispatchIndirectCommand simulateDispatch;
+        uint32_t                  simulatePadding;
+    };
+
+    // GPU timestamps of the particle work; the first two are written on the compute queue
+    enum ParticleTimestamp : uint32_t
+    {
+        TimestampSimulateBegin,
+        TimestampSimulateEnd,
+        TimestampRenderBegin,
+        TimestampRenderEnd,
+        TimestampCount
+    };
+
+    // Constants, particles, alive lists, dead list, counters, instances and the draw
+    constexpr uint32_t BindingCount = 7;
+    constexpr uint32_t InstanceBinding = 5;
+}
+
+VulkanParticleSystem::~VulkanParticleSystem()
+{
+    Destroy();
+}
+
+bool VulkanParticleSystem::Initialize(const VulkanContext& context, const ParticleSystemInfo& info)
+{
+    Destroy();
+    m_Device = context.device;
+    m_Memory = context.memory;
+    m_Queues = context.queues;
+    m_Capacity = info.capacity;
+    m_SharingFamilies[0] = m_Queues->GetCompute().family;
+    m_SharingFamilies[1] = m_Queues->GetGraphics().family;
+
+    // Simulate and render times come from different queues, both need timestamps
+    const float computePeriod = MiniEngine::Graphics::GetTimestampPeriod(context.physicalDevice, m_SharingFamilies[0]);
+    const float graphicsPeriod = MiniEngine::Graphics::GetTimestampPeriod(context.physicalDevice, m_SharingFamilies[1]);
+    m_TimestampPeriod = computePeriod > 0.0f && graphicsPeriod > 0.0f ? graphicsPeriod : 0.0f;
+    if (m_TimestampPeriod <= 0.0f)
+    {
+        spdlog::warn("Compute or graphics queue does not support timestamps, particle GPU times will not be reported");
+    }
+
+    // One set per frame; the constants and instances are also read by the vertex shader
+    VkDescriptorSetLayoutBinding bindings[BindingCount]{};
+    for (uint32_t i = 0; i < BindingCount; ++i)
+    {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = i == 0 ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = (i == 0 || i == InstanceBinding) ? (VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_COMPUTE_BIT) : VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = BindingCount;
+    layoutInfo.pBindings = bindings;
+
+    if (vkCreateDescriptorSetLayout(m_Device, &layoutInfo, nullptr, &m_SetLayout) != VK_SUCCESS)
+    {
+        spdlog::critical("Failed to create particle descriptor set layout");
+        return false;
+    }
+
+    // The prepare pass gets the reset flag as a push constant
+    VkPushConstantRange resetRange{};
+    resetRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    resetRange.offset = 0;
+    resetRange.size = sizeof(uint32_t);
+
+    VkPipelineLayoutCreateInfo computeLayoutInfo{};
+    computeLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    computeLayoutInfo.setLayoutCount = 1;
+    computeLayoutInfo.pSetLayouts = &m_SetLayout;
+    computeLayoutInfo.pushConstantRangeCount = 1;
+    computeLayoutInfo.pPushConstantRanges = &resetRange;
+
+    VkPipelineLayoutCreateInfo renderLayoutInfo{};
+    renderLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    renderLayoutInfo.setLayoutCount = 1;
+    renderLayoutInfo.pSetLayouts = &m_SetLayout;
+
+    if (vkCreatePipelineLayout(m_Device, &computeLayoutInfo, nullptr, &m_ComputeLayout) != VK_SUCCESS ||
+        vkCreatePipelineLayout(m_Device, &renderLayoutInfo, nullptr, &m_RenderLayout) != VK_SUCCESS)
+    {
+        spdlog::critical("Failed to create particle pipeline layouts");
+        return false;
+    }
+
+    if (!CreateComputePipeline(context, m_ComputeLayout, info.prepareShader, m_PreparePipeline) ||
+        !CreateComputePipeline(context, m_ComputeLayout, info.emitShader, m_EmitPipeline) ||
+        !CreateComputePipeline(context, m_ComputeLayout, info.simulateShader, m_SimulatePipeline) ||
+        !CreateRenderPipeline(context, info))
+    {
+        return false;
+    }
+
+    // Simulation state stays on the compute queue
+    if (!m_Memory->CreateBuffer(sizeof(GpuParticle) * m_Capacity, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY,
+                                MemoryCategory::Geometry, m_ParticleBuffer, m_ParticleAllocation) ||
+        !m_Memory->CreateBuffer(sizeof(uint32_t) * m_Capacity * 2, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY,
+                                MemoryCategory::Geometry, m_AliveListBuffer, m_AliveListAllocation) ||
+        !m_Memory->CreateBuffer(sizeof(uint32_t) * m_Capacity, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY,
+                                MemoryCategory::Geometry, m_DeadListBuffer, m_DeadListAllocation) ||
+        !m_Memory->CreateBuffer(sizeof(ParticleCounters), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+                                VMA_MEMORY_USAGE_GPU_ONLY, MemoryCategory::Geometry, m_CounterBuffer, m_CounterAllocation))
+    {
+        return false;
+    }
+
+    const uint32_t frameCount = context.framesInFlight;
+    VkDescriptorPoolSize poolSizes[] = {
+        { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, frameCount },
+        { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, frameCount * (BindingCount - 1) },
+    };
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets = frameCount;
+    poolInfo.poolSizeCount = 2;
+    poolInfo.pPoolSizes = poolSizes;
+
+    if (vkCreateDescriptorPool(m_Device, &poolInfo, nullptr, &m_DescriptorPool) != VK_SUCCESS)
+    {
+        spdlog::critical("Failed to create particle descriptor pool");
+        return false;
+    }
+
+    m_Frames.resize(frameCount);
+    for (Frame& frame : m_Frames)
+    {
+        if (!CreateFrameBuffer(sizeof(ParticleUniforms), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU,
+                               frame.uniformBuffer, frame.uniformAllocation, &frame.uniformMapped) ||
+            !CreateFrameBuffer(sizeof(GpuParticleInstance) * m_Capacity, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY,
+                               frame.instanceBuffer, frame.instanceAllocation, nullptr) ||
+            !CreateFrameBuffer(sizeof(VkDrawIndirectCommand), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+                               VMA_MEMORY_USAGE_GPU_TO_CPU, frame.drawBuffer, frame.drawAllocation, &frame.drawMapped))
+        {
+            return false;
+        }
+
+        if (m_TimestampPeriod > 0.0f)
+        {
+            VkQueryPoolCreateInfo queryPoolInfo{};
+            queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+            queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+            queryPoolInfo.queryCount = TimestampCount;
+
+            if (vkCreateQueryPool(m_Device, &queryPoolInfo, nullptr, &frame.timestampPool) != VK_SUCCESS)
+            {
+                spdlog::critical("Failed to create particle timestamp query pool");
+                return false;
+            }
+        }
+
+        VkDescriptorSetAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool = m_DescriptorPool;
+        allocInfo.descriptorSetCount = 1;
+        allocInfo.pSetLayouts = &m_SetLayout;
+
+        if (vkAllocateDescriptorSets(m_Device, &allocInfo, &frame.descriptorSet) != VK_SUCCESS)
+        {
+            spdlog::critical("Failed to allocate particle descriptor set");
+            return false;
+        }
+
+        VkDescriptorBufferInfo bufferInfos[BindingCount] = {
+            { frame.uniformBuffer, 0, VK_WHOLE_SIZE },
+            { m_ParticleBuffer, 0, VK_WHOLE_SIZE },
+            { m_AliveListBuffer, 0, VK_WHOLE_SIZE },
+            { m_DeadListBuffer, 0, VK_WHOLE_SIZE },
+            { m_CounterBuffer, 0, VK_WHOLE_SIZE },
+            { frame.instanceBuffer, 0, VK_WHOLE_SIZE },
+            { frame.drawBuffer, 0, VK_WHOLE_SIZE },
+        };
+
+        VkWriteDescriptorSet writes[BindingCount]{};
+        for (uint32_t i = 0; i < BindingCount; ++i)
+        {
+            writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[i].dstSet = frame.descriptorSet;
+            writes[i].dstBinding = i;
+            writes[i].descriptorCount = 1;
+            writes[i].descriptorType = bindings[i].descriptorType;
+            writes[i].pBufferInfo = &bufferInfos[i];
+        }
+        vkUpdateDescriptorSets(m_Device, BindingCount, writes, 0, nullptr);
+    }
+
+    spdlog::info("Particle system created for {} particles ({:.1f} MB)", m_Capacity,
+        (m_Capacity * (sizeof(GpuParticle) + sizeof(uint32_t) * 3 + sizeof(GpuParticleInstance) * frameCount)) / (1024.0 * 1024.0));
+    return true;
+}
+
+void VulkanParticleSystem::Destroy()
+{
+    if (m_Device == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    for (Frame& frame : m_Frames)
+    {
+        if (frame.timestampPool != VK_NULL_HANDLE)
+        {
+            vkDestroyQueryPool(m_Device, frame.timestampPool, nullptr);
+        }
+        m_Memory->DestroyBuffer(frame.uniformBuffer, frame.uniformAllocation);
+        m_Memory->DestroyBuffer(frame.instanceBuffer, frame.instanceAllocation);
+        m_Memory->DestroyBuffer(frame.drawBuffer, frame.drawAllocation);
+    }
+    m_Frames.clear();
+
+    // Destroying the pool frees every set allocated from it
+    if (m_DescriptorPool != VK_NULL_HANDLE)
+    {
+        vkDestroyDescriptorPool(m_Device, m_DescriptorPool, nullptr);
+        m_DescriptorPool = VK_NULL_HANDLE;
+    }
+
+    m_Memory->DestroyBuffer(m_ParticleBuffer, m_ParticleAllocation);
+    m_Memory->DestroyBuffer(m_AliveListBuffer, m_AliveListAllocation);
+    m_Memory->DestroyBuffer(m_DeadListBuffer, m_DeadListAllocation);
+    m_Memory->DestroyBuffer(m_CounterBuffer, m_CounterAllocation);
+
+    for (VkPipeline* pipeline : { &m_PreparePipeline, &m_EmitPipeline, &m_SimulatePipeline, &m_RenderPipeline })
+    {
+        if (*pipeline != VK_NULL_HANDLE)
+        {
+            vkDestroyPipeline(m_Device, *pipeline, nullptr);
+            *pipeline = VK_NULL_HANDLE;
+        }
+    }
+    for (VkPipelineLayout* layout : { &m_ComputeLayout, &m_RenderLayout })
+    {
+        if (*layout != VK_NULL_HANDLE)
+        {
+            vkDestroyPipelineLayout(m_Device, *layout, nullptr);
+            *layout = VK_NULL_HANDLE;
+        }
+    }
+    if (m_SetLayout != VK_NULL_HANDLE)
+    {
+        vkDestroyDescriptorSetLayout(m_Device, m_SetLayout, nullptr);
+        m_SetLayout = VK_NULL_HANDLE;
+    }
+
+    m_Capacity = 0;
+    m_Initialized = false;
+    m_Device = VK_NULL_HANDLE;
+    spdlog::debug("Particle system destroyed");
+}
+
+void VulkanParticleSystem::Update(const glm::mat4& view, float deltaTime)
+{
+    const glm::mat4 cameraToWorld = glm::inverse(view);
+    const glm::vec3 eye = glm::vec3(cameraToWorld[3]);
+    const glm::vec3 forward = -glm::vec3(cameraToWorld[2]);
+    m_EmitterPosition = glm::vec3(eye.x + forward.x * 20.0f, 0.0f, eye.z + forward.z * 20.0f);
+
+    // Particles live for lifetime on average, so emitting target / lifetime per second holds the population there
+    m_DeltaTime = std::min(deltaTime, 0.1f);
+    m_EmitAccumulator += m_TargetCount / m_Lifetime * m_DeltaTime;
+    m_EmitCount = static_cast<uint32_t>(m_EmitAccumulator);
+    m_EmitAccumulator -= static_cast<float>(m_EmitCount);
+    ++m_Seed;
+}
+
+void VulkanParticleSystem::ReadResults(uint32_t frameIndex)
+{
+    Frame& frame = m_Frames[frameIndex];
+    if (!frame.submitted)
+    {
+        return;
+    }
+
+    VkDrawIndirectCommand draw;
+    vmaInvalidateAllocation(m_Memory->GetAllocator(), frame.drawAllocation, 0, sizeof(draw));
+    std::memcpy(&draw, frame.drawMapped, sizeof(draw));
+    m_Stats.alive = draw.instanceCount;
+
+    if (frame.timestampPool == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    uint64_t timestamps[TimestampCount];
+    if (vkGetQueryPoolResults(m_Device, frame.timestampPool, 0, TimestampCount, sizeof(timestamps), timestamps,
+                              sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) != VK_SUCCESS)
+    {
+        return;
+    }
+
+    // Each pair comes from a single queue, so only differences within a pair are meaningful
+    const double ticksToMs = m_TimestampPeriod / 1e6;
+    const double simulateMs = (timestamps[TimestampSimulateEnd] - timestamps[TimestampSimulateBegin]) * ticksToMs;
+    const double renderMs = (timestamps[TimestampRenderEnd] - timestamps[TimestampRenderBegin]) * ticksToMs;
+
+    if (m_Stats.samples == 0)
+    {
+        m_Stats.gpuSimulateMs = simulateMs;
+        m_Stats.gpuRenderMs = renderMs;
+    }
+    else
+    {
+        m_Stats.gpuSimulateMs += (simulateMs - m_Stats.gpuSimulateMs) * 0.05;
+        m_Stats.gpuRenderMs += (renderMs - m_Stats.gpuRenderMs) * 0.05;
+    }
+    ++m_Stats.samples;
+}
+
+bool VulkanParticleSystem::Simulate(uint32_t frameIndex, const glm::mat4& view, const glm::mat4& viewProjection)
+{
+    Frame& frame = m_Frames[frameIndex];
+
+    ParticleUniforms uniforms{};
+    uniforms.viewProjection = viewProjection;
+    uniforms.cameraRight = glm::vec4(view[0][0], view[1][0], view[2][0], m_ParticleSize);
+    uniforms.cameraUp = glm::vec4(view[0][1], view[1][1], view[2][1], 0.0f);
+    uniforms.emitterPositionRadius = glm::vec4(m_EmitterPosition, m_EmitterRadius);
+    uniforms.gravityDeltaTime = glm::vec4(0.0f, -9.81f, 0.0f, m_DeltaTime);
+    uniforms.emitCount = m_EmitCount;
+    uniforms.capacity = m_Capacity;
+    uniforms.seed = m_Seed;
+    uniforms.lifetime = m_Lifetime;
+    std::memcpy(frame.uniformMapped, &uniforms, sizeof(uniforms));
+    vmaFlushAllocation(m_Memory->GetAllocator(), frame.uniformAllocation, 0, sizeof(uniforms));
+
+    VkCommandBuffer commandBuffer = m_Queues->BeginCompute(frameIndex);
+    if (commandBuffer == VK_NULL_HANDLE)
+    {
+        return false;
+    }
+    m_Encoder.Begin(commandBuffer);
+
+    if (frame.timestampPool != VK_NULL_HANDLE)
+    {
+        vkCmdResetQueryPool(commandBuffer, frame.timestampPool, 0, TimestampCount);
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, frame.timestampPool, TimestampSimulateBegin);
+    }
+
+    // Every pass reads what the one before it wrote, including the previous frame's last pass
+    VkMemoryBarrier passBarrier{};
+    passBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    passBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    passBarrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    const VkPipelineStageFlags passStages = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, passStages, 0, 1, &passBarrier, 0, nullptr, 0, nullptr);
+
+    m_Encoder.BindPipeline(VK_PIPELINE_BIND_POINT_COMPUTE, m_PreparePipeline);
+    m_Encoder.BindDescriptorSets(VK_PIPELINE_BIND_POINT_COMPUTE, m_ComputeLayout, 0, 1, &frame.descriptorSet);
+
+    // The first simulation puts every particle on the dead list
+    if (!m_Initialized)
+    {
+        uint32_t reset = 1;
+        m_Encoder.PushConstants(m_ComputeLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(reset), &reset);
+        m_Encoder.Dispatch((m_Capacity + 255) / 256, 1, 1);
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, passStages, 0, 1, &passBarrier, 0, nullptr, 0, nullptr);
+        m_Initialized = true;
+    }
+
+    uint32_t reset = 0;
+    m_Encoder.PushConstants(m_ComputeLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(reset), &reset);
+    m_Encoder.Dispatch(1, 1, 1);
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, passStages, 0, 1, &passBarrier, 0, nullptr, 0, nullptr);
+
+    m_Encoder.BindPipeline(VK_PIPELINE_BIND_POINT_COMPUTE, m_EmitPipeline);
+    m_Encoder.DispatchIndirect(m_CounterBuffer, offsetof(ParticleCounters, emitDispatch));
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, passStages, 0, 1, &passBarrier, 0, nullptr, 0, nullptr);
+
+    m_Encoder.BindPipeline(VK_PIPELINE_BIND_POINT_COMPUTE, m_SimulatePipeline);
+    m_Encoder.DispatchIndirect(m_CounterBuffer, offsetof(ParticleCounters, simulateDispatch));
+
+    if (frame.timestampPool != VK_NULL_HANDLE)
+    {
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, frame.timestampPool, TimestampSimulateEnd);
+    }
+
+    // The graphics queue is covered by the semaphore; the alive count is read back by the host
+    VkMemoryBarrier readbackBarrier{};
+    readbackBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    readbackBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    readbackBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &readbackBarrier, 0, nullptr, 0, nullptr);
+
+    if (!m_Queues->SubmitCompute(frameIndex, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT))
+    {
+        return false;
+    }
+    frame.submitted = true;
+    return true;
+}
+
+void VulkanParticleSystem::RecordDraw(VulkanCommandEncoder& encoder, uint32_t frameIndex)
+{
+    const Frame& frame = m_Frames[frameIndex];
+    VkCommandBuffer commandBuffer = encoder.GetCommandBuffer();
+
+    if (frame.timestampPool != VK_NULL_HANDLE)
+    {
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, frame.timestampPool, TimestampRenderBegin);
+    }
+
+    encoder.BindPipeline(VK_PIPELINE_BIND_POINT_GRAPHICS, m_RenderPipeline);
+    encoder.BindDescriptorSets(VK_PIPELINE_BIND_POINT_GRAPHICS, m_RenderLayout, 0, 1, &frame.descriptorSet);
+    encoder.DrawIndirect(frame.drawBuffer, 0, 1, sizeof(VkDrawIndirectCommand));
+
+    if (frame.timestampPool != VK_NULL_HANDLE)
+    {
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frame.timestampPool, TimestampRenderEnd);
+    }
+}
+
+// Additive, depth-tested quads without depth writes, so the draw order of particles does not matter
+bool VulkanParticleSystem::CreateRenderPipeline(const VulkanContext& context, const ParticleSystemInfo& info)
+{
+    VkShaderModule vertexModule = CreateShaderModule(context, info.vertexShader);
+    VkShaderModule fragmentModule = CreateShaderModule(context, info.fragmentShader);
+    if (vertexModule == VK_NULL_HANDLE || fragmentModule == VK_NULL_HANDLE)
+    {
+        vkDestroyShaderModule(m_Device, vertexModule, nullptr);
+        vkDestroyShaderModule(m_Device, fragmentModule, nullptr);
+        return false;
+    }
+
+    VkPipelineShaderStageCreateInfo shaderStages[2]{};
+    shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    shaderStages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+    shaderStages[0].module = vertexModule;
+    shaderStages[0].pName = "main";
+    shaderStages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    shaderStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+    shaderStages[1].module = fragmentModule;
+    shaderStages[1].pName = "main";
+
+    // Quads are expanded from the instance buffer, nothing comes from vertex buffers
+    VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
+    vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+
+    VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
+    inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+    VkPipelineViewportStateCreateInfo viewportState{};
+    viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    viewportState.viewportCount = 1;
+    viewportState.scissorCount = 1;
+
+    VkDynamicState dynamicStates[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+    VkPipelineDynamicStateCreateInfo dynamicState{};
+    dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamicState.dynamicStateCount = 2;
+    dynamicState.pDynamicStates = dynamicStates;
+
+    VkPipelineRasterizationStateCreateInfo rasterizer{};
+    rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+    rasterizer.lineWidth = 1.0f;
+    rasterizer.cullMode = VK_CULL_MODE_NONE;
+    rasterizer.frontFace = VK_FRONT_FACE_CLOCKWISE;
+
+    VkPipelineMultisampleStateCreateInfo multisampling{};
+    multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+    VkPipelineDepthStencilStateCreateInfo depthStencil{};
+    depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+    depthStencil.depthTestEnable = VK_TRUE;
+    depthStencil.depthWriteEnable = VK_FALSE;
+    depthStencil.depthCompareOp = VK_COMPARE_OP_LESS;
+
+    VkPipelineColorBlendAttachmentState colorBlendAttachment{};
+    colorBlendAttachment.blendEnable = VK_TRUE;
+    colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
+    colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE;
+    colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+    colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+    colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+    colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+    colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+
+    VkPipelineColorBlendStateCreateInfo colorBlending{};
+    colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    colorBlending.attachmentCount = 1;
+    colorBlending.pAttachments = &colorBlendAttachment;
+
+    VkGraphicsPipelineCreateInfo pipelineInfo{};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipelineInfo.stageCount = 2;
+    pipelineInfo.pStages = shaderStages;
+    pipelineInfo.pVertexInputState = &vertexInputInfo;
+    pipelineInfo.pInputAssemblyState = &inputAssembly;
+    pipelineInfo.pViewportState = &viewportState;
+    pipelineInfo.pDynamicState = &dynamicState;
+    pipelineInfo.pRasterizationState = &rasterizer;
+    pipelineInfo.pMultisampleState = &multisampling;
+    pipelineInfo.pDepthStencilState = &depthStencil;
+    pipelineInfo.pColorBlendState = &colorBlending;
+    pipelineInfo.layout = m_RenderLayout;
+    pipelineInfo.renderPass = info.renderPass;
+    pipelineInfo.subpass = 0;
+
+    const VkResult result = vkCreateGraphicsPipelines(m_Device, context.pipelineCache, 1, &pipelineInfo, nullptr, &m_RenderPipeline);
+    vkDestroyShaderModule(m_Device, vertexModule, nullptr);
+    vkDestroyShaderModule(m_Device, fragmentModule, nullptr);
+
+    if (result != VK_SUCCESS)
+    {
+        spdlog::critical("Failed to create particle pipeline");
+        return false;
+    }
+    context.debugUtils->SetObjectName(VK_OBJECT_TYPE_PIPELINE, m_RenderPipeline, "Particles");
+    return true;
+}
+
+// Written on the compute queue and read on the graphics queue every frame, so shared concurrently
+// instead of changing owner twice a frame
+bool VulkanParticleSystem::CreateFrameBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VmaMemoryUsage memoryUsage,
+                                             VkBuffer& buffer, VmaAllocation& allocation, void** mapped)
+{
+    VkBufferCreateInfo bufferInfo{};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = size;
+    bufferInfo.usage = usage;
+    if (m_SharingFamilies[0] != m_SharingFamilies[1])
+    {
+        bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+        bufferInfo.queueFamilyIndexCount = 2;
+        bufferInfo.pQueueFamilyIndices = m_SharingFamilies;
+    }
+    else
+    {
+        bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    }
+
+    VmaAllocationCreateInfo allocInfo = {};
+    allocInfo.usage = memoryUsage;
+    if (mapped)
+    {
+        allocInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+    }
+
+    VmaAllocationInfo allocationInfo = {};
+    if (vmaCreateBuffer(m_Memory->GetAllocator(), &bufferInfo, &allocInfo, &buffer, &allocation, &allocationInfo) != VK_SUCCESS)
+    {
+        spdlog::critical("Failed to create particle buffer of {} bytes", size);
+        return false;
+    }
+    m_Memory->Track(allocation, MemoryCategory::FrameData);
+    if (mapped)
+    {
+        *mapped = allocationInfo.pMappedData;
+    }
+    return true;
+}
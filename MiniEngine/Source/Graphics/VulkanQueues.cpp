@@ -0,0 +1,330 @@
+#include "MiniEngine/Graphics/VulkanQueues.hpp"
+
+#include "MiniEngine/Graphics/VulkanDebugUtils.hpp"
+#include "MiniEngine/Graphics/VulkanMemory.hpp"
+
+#include <VkBootstrap.h>
+#include <spdlog/spdlog.h>
+
+#include <cstring>
+
+using namespace MiniEngine::Graphics;
+
+namespace
+{
+    VulkanQueue GetQueue(const vkb::Device& device, vkb::QueueType type, const VulkanQueue& fallback)
+    {
+        auto index = device.get_queue_index(type);
+        auto queue = device.get_queue(type);
+        if (!index || !queue)
+        {
+            return fallback;
+        }
+        return { static_cast<uint32_t>(index.value()), queue.value() };
+    }
+}
+
+void MiniEngine::Graphics::RecordBufferRelease(VkCommandBuffer commandBuffer, VkBuffer buffer, uint32_t srcFamily, uint32_t dstFamily,
+                                               VkPipelineStageFlags srcStage, VkAccessFlags srcAccess)
+{
+    if (srcFamily == dstFamily)
+    {
+        return;
+    }
+
+    VkBufferMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.srcAccessMask = srcAccess;
+    barrier.dstAccessMask = 0;
+    barrier.srcQueueFamilyIndex = srcFamily;
+    barrier.dstQueueFamilyIndex = dstFamily;
+    barrier.buffer = buffer;
+    barrier.offset = 0;
+    barrier.size = VK_WHOLE_SIZE;
+
+    vkCmdPipelineBarrier(commandBuffer, srcStage, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+}
+
+void MiniEngine::Graphics::RecordBufferAcquire(VkCommandBuffer commandBuffer, VkBuffer buffer, uint32_t srcFamily, uint32_t dstFamily,
+                                               VkPipelineStageFlags dstStage, VkAccessFlags dstAccess)
+{
+    if (srcFamily == dstFamily)
+    {
+        return;
+    }
+
+    VkBufferMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = dstAccess;
+    barrier.srcQueueFamilyIndex = srcFamily;
+    barrier.dstQueueFamilyIndex = dstFamily;
+    barrier.buffer = buffer;
+    barrier.offset = 0;
+    barrier.size = VK_WHOLE_SIZE;
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, dstStage, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+}
+
+VulkanQueues::~VulkanQueues()
+{
+    Destroy();
+}
+
+void VulkanQueues::Select(const vkb::Device& device)
+{
+    m_Graphics = { static_cast<uint32_t>(device.get_queue_index(vkb::QueueType::graphics).value()),
+                   device.get_queue(vkb::QueueType::graphics).value() };
+    m_Compute = GetQueue(device, vkb::QueueType::compute, m_Graphics);
+    m_Transfer = GetQueue(device, vkb::QueueType::transfer, m_Graphics);
+
+    spdlog::info("Compute queue family index: {} ({}), transfer queue family index: {} ({})",
+                 m_Compute.family, HasAsyncCompute() ? "async" : "shared with graphics",
+                 m_Transfer.family, m_Transfer.queue != m_Graphics.queue ? "async" : "shared with graphics");
+}
+
+bool VulkanQueues::Initialize(VkDevice device, uint32_t framesInFlight, const VulkanDebugUtils& debugUtils)
+{
+    Destroy();
+    m_Device = device;
+    m_DebugUtils = &debugUtils;
+
+    VkCommandPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    poolInfo.queueFamilyIndex = m_Compute.family;
+
+    if (vkCreateCommandPool(m_Device, &poolInfo, nullptr, &m_ComputeCommandPool) != VK_SUCCESS)
+    {
+        spdlog::critical("Failed to create compute command pool");
+        return false;
+    }
+
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    poolInfo.queueFamilyIndex = m_Transfer.family;
+
+    if (vkCreateCommandPool(m_Device, &poolInfo, nullptr, &m_TransferCommandPool) != VK_SUCCESS)
+    {
+        spdlog::critical("Failed to create transfer command pool");
+        return false;
+    }
+
+    m_ComputeCommandBuffers.resize(framesInFlight);
+
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool = m_ComputeCommandPool;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = framesInFlight;
+
+    if (vkAllocateCommandBuffers(m_Device, &allocInfo, m_ComputeCommandBuffers.data()) != VK_SUCCESS)
+    {
+        spdlog::critical("Failed to allocate compute command buffers");
+        m_ComputeCommandBuffers.clear();
+        return false;
+    }
+
+    VkSemaphoreCreateInfo semaphoreInfo{};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+    m_ComputeFinished.assign(framesInFlight, VK_NULL_HANDLE);
+    m_GraphicsWaitStages.assign(framesInFlight, 0);
+    for (VkSemaphore& semaphore : m_ComputeFinished)
+    {
+        if (vkCreateSemaphore(m_Device, &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS)
+        {
+            spdlog::critical("Failed to create compute semaphore");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void VulkanQueues::Destroy()
+{
+    if (m_Device == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    for (VkSemaphore semaphore : m_ComputeFinished)
+    {
+        if (semaphore != VK_NULL_HANDLE)
+        {
+            vkDestroySemaphore(m_Device, semaphore, nullptr);
+        }
+    }
+    m_ComputeFinished.clear();
+    m_GraphicsWaitStages.clear();
+
+    if (m_ComputeCommandPool != VK_NULL_HANDLE)
+    {
+        vkDestroyCommandPool(m_Device, m_ComputeCommandPool, nullptr);
+        m_ComputeCommandPool = VK_NULL_HANDLE;
+    }
+    m_ComputeCommandBuffers.clear();
+
+    if (m_TransferCommandPool != VK_NULL_HANDLE)
+    {
+        vkDestroyCommandPool(m_Device, m_TransferCommandPool, nullptr);
+        m_TransferCommandPool = VK_NULL_HANDLE;
+    }
+
+    m_Device = VK_NULL_HANDLE;
+    spdlog::debug("Async compute resources destroyed");
+}
+
+VkCommandBuffer VulkanQueues::BeginCompute(uint32_t frame)
+{
+    VkCommandBuffer commandBuffer = m_ComputeCommandBuffers[frame];
+    vkResetCommandBuffer(commandBuffer, 0);
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+    {
+        spdlog::critical("Failed to begin compute command buffer");
+        return VK_NULL_HANDLE;
+    }
+    m_DebugUtils->BeginLabel(commandBuffer, "Async compute");
+    return commandBuffer;
+}
+
+bool VulkanQueues::SubmitCompute(uint32_t frame, VkPipelineStageFlags graphicsWaitStage)
+{
+    m_DebugUtils->EndLabel(m_ComputeCommandBuffers[frame]);
+    if (vkEndCommandBuffer(m_ComputeCommandBuffers[frame]) != VK_SUCCESS)
+    {
+        spdlog::critical("Failed to record compute command buffer");
+        return false;
+    }
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &m_ComputeCommandBuffers[frame];
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores = &m_ComputeFinished[frame];
+
+    if (vkQueueSubmit(m_Compute.queue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+    {
+        spdlog::critical("Failed to submit compute command buffer");
+        return false;
+    }
+
+    m_GraphicsWaitStages[frame] = graphicsWaitStage;
+    return true;
+}
+
+bool VulkanQueues::TakeComputeWait(uint32_t frame, VkSemaphore& semaphore, VkPipelineStageFlags& stage)
+{
+    if (m_GraphicsWaitStages[frame] == 0)
+    {
+        return false;
+    }
+
+    semaphore = m_ComputeFinished[frame];
+    stage = m_GraphicsWaitStages[frame];
+    m_GraphicsWaitStages[frame] = 0;
+    return true;
+}
+
+bool VulkanQueues::UploadBuffer(VulkanMemory& memory, VkCommandPool graphicsCommandPool, VkBuffer buffer, const void* data, VkDeviceSize size,
+                                VkPipelineStageFlags dstStage, VkAccessFlags dstAccess)
+{
+    VkBuffer stagingBuffer = VK_NULL_HANDLE;
+    VmaAllocation stagingAllocation = VK_NULL_HANDLE;
+    void* stagingMapped = nullptr;
+    if (!memory.CreateBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY, MemoryCategory::Staging,
+                             stagingBuffer, stagingAllocation, &stagingMapped))
+    {
+        return false;
+    }
+    std::memcpy(stagingMapped, data, size);
+    vmaFlushAllocation(memory.GetAllocator(), stagingAllocation, 0, size);
+
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool = m_TransferCommandPool;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = 1;
+
+    VkCommandBuffer transferCommands = VK_NULL_HANDLE;
+    VkSemaphore transferred = VK_NULL_HANDLE;
+    VkSemaphoreCreateInfo semaphoreInfo{};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+    bool success = vkAllocateCommandBuffers(m_Device, &allocInfo, &transferCommands) == VK_SUCCESS
+        && vkCreateSemaphore(m_Device, &semaphoreInfo, nullptr, &transferred) == VK_SUCCESS;
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    if (success)
+    {
+        vkBeginCommandBuffer(transferCommands, &beginInfo);
+        VkBufferCopy region{ 0, 0, size };
+        vkCmdCopyBuffer(transferCommands, stagingBuffer, buffer, 1, &region);
+        RecordBufferRelease(transferCommands, buffer, m_Transfer.family, m_Graphics.family, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+        vkEndCommandBuffer(transferCommands);
+
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &transferCommands;
+        submitInfo.signalSemaphoreCount = 1;
+        submitInfo.pSignalSemaphores = &transferred;
+        success = vkQueueSubmit(m_Transfer.queue, 1, &submitInfo, VK_NULL_HANDLE) == VK_SUCCESS;
+    }
+
+    // The graphics queue acquires the buffer once the copy has finished
+    if (success)
+    {
+        VkCommandBuffer acquireCommands = VK_NULL_HANDLE;
+        allocInfo.commandPool = graphicsCommandPool;
+        success = vkAllocateCommandBuffers(m_Device, &allocInfo, &acquireCommands) == VK_SUCCESS;
+
+        if (success)
+        {
+            vkBeginCommandBuffer(acquireCommands, &beginInfo);
+            RecordBufferAcquire(acquireCommands, buffer, m_Transfer.family, m_Graphics.family, dstStage, dstAccess);
+            vkEndCommandBuffer(acquireCommands);
+
+            VkPipelineStageFlags waitStage = dstStage;
+            VkSubmitInfo submitInfo{};
+            submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+            submitInfo.waitSemaphoreCount = 1;
+            submitInfo.pWaitSemaphores = &transferred;
+            submitInfo.pWaitDstStageMask = &waitStage;
+            submitInfo.commandBufferCount = 1;
+            submitInfo.pCommandBuffers = &acquireCommands;
+
+            success = vkQueueSubmit(m_Graphics.queue, 1, &submitInfo, VK_NULL_HANDLE) == VK_SUCCESS
+                && vkQueueWaitIdle(m_Graphics.queue) == VK_SUCCESS;
+
+            vkFreeCommandBuffers(m_Device, graphicsCommandPool, 1, &acquireCommands);
+        }
+    }
+
+    // Graphics waited on the transfer, so once the graphics queue is idle the transfer is done too
+    if (!success)
+    {
+        vkQueueWaitIdle(m_Transfer.queue);
+        spdlog::critical("Failed to upload {} bytes through the transfer queue", size);
+    }
+
+    if (transferCommands != VK_NULL_HANDLE)
+    {
+        vkFreeCommandBuffers(m_Device, m_TransferCommandPool, 1, &transferCommands);
+    }
+    if (transferred != VK_NULL_HANDLE)
+    {
+        vkDestroySemaphore(m_Device, transferred, nullptr);
+    }
+    memory.DestroyBuffer(stagingBuffer, stagingAllocation);
+    return success;
+}
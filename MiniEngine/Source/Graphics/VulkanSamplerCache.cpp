@@ -0,0 +1,80 @@
+#include "MiniEngine/Graphics/VulkanSamplerCache.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <bit>
+
+using namespace MiniEngine::Graphics;
+
+size_t VulkanSamplerCache::KeyHash::operator()(const Key& key) const
+{
+    // FNV-1a over the words
+    uint64_t hash = 14695981039346656037ull;
+    for (uint32_t word : key)
+    {
+        hash = (hash ^ word) * 1099511628211ull;
+    }
+    return static_cast<size_t>(hash);
+}
+
+VulkanSamplerCache::~VulkanSamplerCache()
+{
+    Destroy();
+}
+
+void VulkanSamplerCache::Initialize(VkDevice device)
+{
+    Destroy();
+    m_Device = device;
+}
+
+void VulkanSamplerCache::Destroy()
+{
+    for (const auto& [key, sampler] : m_Samplers)
+    {
+        vkDestroySampler(m_Device, sampler, nullptr);
+    }
+    m_Samplers.clear();
+    m_Requests = 0;
+}
+
+VkSampler VulkanSamplerCache::Get(const VkSamplerCreateInfo& info)
+{
+    ++m_Requests;
+
+    const Key key = {
+        info.flags,
+        static_cast<uint32_t>(info.magFilter),
+        static_cast<uint32_t>(info.minFilter),
+        static_cast<uint32_t>(info.mipmapMode),
+        static_cast<uint32_t>(info.addressModeU),
+        static_cast<uint32_t>(info.addressModeV),
+        static_cast<uint32_t>(info.addressModeW),
+        std::bit_cast<uint32_t>(info.mipLodBias),
+        info.anisotropyEnable,
+        std::bit_cast<uint32_t>(info.anisotropyEnable ? info.maxAnisotropy : 0.0f),
+        info.compareEnable,
+        static_cast<uint32_t>(info.compareEnable ? info.compareOp : VK_COMPARE_OP_NEVER),
+        std::bit_cast<uint32_t>(info.minLod),
+        std::bit_cast<uint32_t>(info.maxLod),
+        static_cast<uint32_t>(info.borderColor),
+        info.unnormalizedCoordinates,
+    };
+
+    auto found = m_Samplers.find(key);
+    if (found != m_Samplers.end())
+    {
+        return found->second;
+    }
+
+    VkSampler sampler = VK_NULL_HANDLE;
+    if (vkCreateSampler(m_Device, &info, nullptr, &sampler) != VK_SUCCESS)
+    {
+        spdlog::error("Failed to create sampler, {} already cached", m_Samplers.size());
+        return VK_NULL_HANDLE;
+    }
+
+    m_Samplers.emplace(key, sampler);
+    spdlog::debug("Sampler {} created", m_Samplers.size());
+    return sampler;
+}
@@ -0,0 +1,910 @@
+#include "MiniEngine/Graphics/VulkanTextureSystem.hpp"
+
+#include "MiniEngine/Graphics/VulkanDebugUtils.hpp"
+#include "MiniEngine/Graphics/VulkanQueues.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <chrono>
+#include <cctype>
+#include <cstring>
+#include <system_error>
+
+using namespace MiniEngine::Graphics;
+
+VulkanTextureSystem::~VulkanTextureSystem()
+{
+    Destroy();
+}
+
+bool VulkanTextureSystem::Initialize(const VulkanContext& context, const TextureSystemInfo& info)
+{
+    Destroy();
+    m_Device = context.device;
+    m_PhysicalDevice = context.physicalDevice;
+    m_Memory = context.memory;
+    m_Queues = context.queues;
+    m_DebugUtils = context.debugUtils;
+    m_TextureCompressionBC = info.textureCompressionBC;
+    m_Samplers.Initialize(m_Device);
+
+    m_SamplerInfo = {};
+    m_SamplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    m_SamplerInfo.magFilter = VK_FILTER_LINEAR;
+    m_SamplerInfo.minFilter = VK_FILTER_LINEAR;
+    m_SamplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    m_SamplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    m_SamplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    m_SamplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    m_SamplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+    m_SamplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+
+    VkDescriptorSetLayoutBinding binding{};
+    binding.binding = 0;
+    binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    binding.descriptorCount = 1;
+    binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = 1;
+    layoutInfo.pBindings = &binding;
+
+    if (vkCreateDescriptorSetLayout(m_Device, &layoutInfo, nullptr, &m_SetLayout) != VK_SUCCESS)
+    {
+        spdlog::critical("Failed to create texture descriptor set layout");
+        return false;
+    }
+
+    VkDescriptorPoolSize poolSize = { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, MaxTextures };
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets = MaxTextures;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+
+    if (vkCreateDescriptorPool(m_Device, &poolInfo, nullptr, &m_DescriptorPool) != VK_SUCCESS)
+    {
+        spdlog::critical("Failed to create texture descriptor pool");
+        return false;
+    }
+
+    // Mip generation reads the level above and writes the next one, both as storage images
+    VkDescriptorSetLayoutBinding mipBindings[2]{};
+    for (uint32_t i = 0; i < 2; ++i)
+    {
+        mipBindings[i].binding = i;
+        mipBindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        mipBindings[i].descriptorCount = 1;
+        mipBindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+    layoutInfo.bindingCount = 2;
+    layoutInfo.pBindings = mipBindings;
+
+    if (vkCreateDescriptorSetLayout(m_Device, &layoutInfo, nullptr, &m_MipSetLayout) != VK_SUCCESS)
+    {
+        spdlog::critical("Failed to create mip generation descriptor set layout");
+        return false;
+    }
+
+    VkPushConstantRange pushConstantRange{ VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(uint32_t) }; // Whether the texture is sRGB
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = 1;
+    pipelineLayoutInfo.pSetLayouts = &m_MipSetLayout;
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+    if (vkCreatePipelineLayout(m_Device, &pipelineLayoutInfo, nullptr, &m_MipPipelineLayout) != VK_SUCCESS)
+    {
+        spdlog::critical("Failed to create mip generation pipeline layout");
+        return false;
+    }
+
+    if (!CreateComputePipeline(context, m_MipPipelineLayout, info.mipShader, m_MipPipeline))
+    {
+        return false;
+    }
+
+    // The mip generation is recorded on the render thread, apart from the application's own graphics commands
+    VkCommandPoolCreateInfo commandPoolInfo{};
+    commandPoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    commandPoolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    commandPoolInfo.queueFamilyIndex = m_Queues->GetGraphics().family;
+
+    if (vkCreateCommandPool(m_Device, &commandPoolInfo, nullptr, &m_CommandPool) != VK_SUCCESS)
+    {
+        spdlog::critical("Failed to create texture command pool");
+        return false;
+    }
+
+    // The white texel every object samples until a loaded texture is picked
+    VulkanTexture white;
+    white.name = "White";
+    white.format = VK_FORMAT_R8G8B8A8_UNORM;
+    white.extent = { 1, 1 };
+    white.mipCount = 1;
+    if (!CreateTextureImage(white, false))
+    {
+        return false;
+    }
+    if (!UploadWhiteTexel(white, context.executeImmediate) || !WriteDescriptorSet(white))
+    {
+        DestroyTexture(white);
+        return false;
+    }
+    m_Textures.push_back(std::move(white));
+
+    m_Stopping = false;
+    m_Loader = std::thread([this] { RunLoader(); });
+
+    spdlog::debug("Texture system created");
+    return true;
+}
+
+void VulkanTextureSystem::Destroy()
+{
+    if (m_Device == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    if (m_Loader.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Stopping = true;
+        }
+        m_Condition.notify_all();
+        m_Loader.join();
+    }
+
+    // Batches still in flight finish before their resources go
+    for (Batch& batch : m_Batches)
+    {
+        vkWaitForFences(m_Device, 1, &batch.finished, VK_TRUE, UINT64_MAX);
+        for (Upload& upload : batch.uploads)
+        {
+            m_Ready.push_back(std::move(upload));
+        }
+        ReleaseBatch(batch);
+    }
+    m_Batches.clear();
+    for (Upload& upload : m_Ready)
+    {
+        m_Memory->DestroyBuffer(upload.stagingBuffer, upload.stagingAllocation);
+        DestroyTexture(upload.texture);
+    }
+    m_Ready.clear();
+    m_Requests.clear();
+    m_StagingBytes = 0;
+    m_FailedLoads = 0;
+
+    for (VulkanTexture& texture : m_Textures)
+    {
+        DestroyTexture(texture);
+    }
+    m_Textures.clear();
+    m_Active = 0;
+    m_Stats = {};
+
+    if (m_CommandPool != VK_NULL_HANDLE)
+    {
+        vkDestroyCommandPool(m_Device, m_CommandPool, nullptr);
+        m_CommandPool = VK_NULL_HANDLE;
+    }
+    if (m_MipPipeline != VK_NULL_HANDLE)
+    {
+        vkDestroyPipeline(m_Device, m_MipPipeline, nullptr);
+        m_MipPipeline = VK_NULL_HANDLE;
+    }
+    if (m_MipPipelineLayout != VK_NULL_HANDLE)
+    {
+        vkDestroyPipelineLayout(m_Device, m_MipPipelineLayout, nullptr);
+        m_MipPipelineLayout = VK_NULL_HANDLE;
+    }
+    if (m_MipSetLayout != VK_NULL_HANDLE)
+    {
+        vkDestroyDescriptorSetLayout(m_Device, m_MipSetLayout, nullptr);
+        m_MipSetLayout = VK_NULL_HANDLE;
+    }
+    if (m_DescriptorPool != VK_NULL_HANDLE)
+    {
+        vkDestroyDescriptorPool(m_Device, m_DescriptorPool, nullptr);
+        m_DescriptorPool = VK_NULL_HANDLE;
+    }
+    if (m_SetLayout != VK_NULL_HANDLE)
+    {
+        vkDestroyDescriptorSetLayout(m_Device, m_SetLayout, nullptr);
+        m_SetLayout = VK_NULL_HANDLE;
+    }
+    m_Samplers.Destroy();
+
+    m_Device = VK_NULL_HANDLE;
+    spdlog::debug("Texture system destroyed");
+}
+
+bool VulkanTextureSystem::RequestTexture(const std::filesystem::path& path)
+{
+    // One descriptor set is taken by the white texture
+    if (m_Stats.requested + 1 >= MaxTextures)
+    {
+        spdlog::warn("Texture {} not loaded, the limit of {} textures is reached", path.string(), MaxTextures);
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Requests.push_back(path);
+    }
+    m_Condition.notify_one();
+    ++m_Stats.requested;
+    return true;
+}
+
+uint32_t VulkanTextureSystem::RequestDirectory(const std::filesystem::path& directory)
+{
+    std::error_code error;
+    std::vector<std::filesystem::path> paths;
+    for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(directory, error))
+    {
+        std::string extension = entry.path().extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        if (entry.is_regular_file() && (extension == ".ktx2" || extension == ".dds"))
+        {
+            paths.push_back(entry.path());
+        }
+    }
+    if (error)
+    {
+        spdlog::error("Failed to list textures in {}: {}", directory.string(), error.message());
+        return 0;
+    }
+
+    std::sort(paths.begin(), paths.end());
+    uint32_t requested = 0;
+    for (const std::filesystem::path& path : paths)
+    {
+        if (!RequestTexture(path))
+        {
+            break;
+        }
+        ++requested;
+    }
+    return requested;
+}
+
+bool VulkanTextureSystem::Update()
+{
+    while (!m_Batches.empty() && vkGetFenceStatus(m_Device, m_Batches.front().finished) == VK_SUCCESS)
+    {
+        Batch& batch = m_Batches.front();
+        VkDeviceSize releasedBytes = 0;
+        uint32_t failed = 0;
+        for (Upload& upload : batch.uploads)
+        {
+            releasedBytes += upload.description.dataSize;
+            m_Memory->DestroyBuffer(upload.stagingBuffer, upload.stagingAllocation);
+            if (!WriteDescriptorSet(upload.texture))
+            {
+                DestroyTexture(upload.texture);
+                ++failed;
+                continue;
+            }
+            m_Stats.uploadedBytes += upload.description.dataSize;
+            m_Stats.readMs += upload.readMs;
+            ++m_Stats.loaded;
+            m_Textures.push_back(std::move(upload.texture));
+        }
+        ReleaseBatch(batch);
+        m_Batches.pop_front();
+
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_StagingBytes -= releasedBytes;
+            m_FailedLoads += failed;
+        }
+        m_Condition.notify_one();
+    }
+
+    Batch batch;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stats.failed = m_FailedLoads;
+
+        VkDeviceSize batchBytes = 0;
+        while (!m_Ready.empty() && batch.uploads.size() < MaxUploadsPerFrame)
+        {
+            const VkDeviceSize size = m_Ready.front().description.dataSize;
+            if (!batch.uploads.empty() && batchBytes + size > MaxUploadBytesPerFrame)
+            {
+                break;
+            }
+            batchBytes += size;
+            batch.uploads.push_back(std::move(m_Ready.front()));
+            m_Ready.pop_front();
+        }
+    }
+    if (batch.uploads.empty())
+    {
+        return true;
+    }
+
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool = m_Queues->GetTransferCommandPool();
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = 1;
+
+    VkSemaphoreCreateInfo semaphoreInfo{};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    VkFenceCreateInfo fenceInfo{};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+    bool success = vkAllocateCommandBuffers(m_Device, &allocInfo, &batch.transferCommands) == VK_SUCCESS;
+    allocInfo.commandPool = m_CommandPool;
+    success = success
+        && vkAllocateCommandBuffers(m_Device, &allocInfo, &batch.graphicsCommands) == VK_SUCCESS
+        && vkCreateSemaphore(m_Device, &semaphoreInfo, nullptr, &batch.transferred) == VK_SUCCESS
+        && vkCreateFence(m_Device, &fenceInfo, nullptr, &batch.finished) == VK_SUCCESS;
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    bool transferSubmitted = false;
+    if (success)
+    {
+        vkBeginCommandBuffer(batch.transferCommands, &beginInfo);
+        m_DebugUtils->BeginLabel(batch.transferCommands, "Texture copies");
+        RecordCopies(batch);
+        m_DebugUtils->EndLabel(batch.transferCommands);
+        vkEndCommandBuffer(batch.transferCommands);
+
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &batch.transferCommands;
+        submitInfo.signalSemaphoreCount = 1;
+        submitInfo.pSignalSemaphores = &batch.transferred;
+        success = transferSubmitted = vkQueueSubmit(m_Queues->GetTransfer().queue, 1, &submitInfo, VK_NULL_HANDLE) == VK_SUCCESS;
+    }
+
+    if (success)
+    {
+        const VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+
+        vkBeginCommandBuffer(batch.graphicsCommands, &beginInfo);
+        m_DebugUtils->BeginLabel(batch.graphicsCommands, "Texture mip generation");
+        const uint32_t generatedMips = RecordMipGeneration(batch, waitStage);
+        m_DebugUtils->EndLabel(batch.graphicsCommands);
+        vkEndCommandBuffer(batch.graphicsCommands);
+
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.waitSemaphoreCount = 1;
+        submitInfo.pWaitSemaphores = &batch.transferred;
+        submitInfo.pWaitDstStageMask = &waitStage;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &batch.graphicsCommands;
+        success = vkQueueSubmit(m_Queues->GetGraphics().queue, 1, &submitInfo, batch.finished) == VK_SUCCESS;
+        if (success)
+        {
+            m_Stats.generatedMips += generatedMips;
+        }
+    }
+
+    if (!success)
+    {
+        spdlog::error("Failed to submit the uploads of {} textures", batch.uploads.size());
+        if (transferSubmitted)
+        {
+            vkQueueWaitIdle(m_Queues->GetTransfer().queue);
+        }
+        VkDeviceSize releasedBytes = 0;
+        for (Upload& upload : batch.uploads)
+        {
+            releasedBytes += upload.description.dataSize;
+            m_Memory->DestroyBuffer(upload.stagingBuffer, upload.stagingAllocation);
+            DestroyTexture(upload.texture);
+        }
+        ReleaseBatch(batch);
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_StagingBytes -= releasedBytes;
+        m_FailedLoads += static_cast<uint32_t>(batch.uploads.size());
+        return false;
+    }
+
+    ++m_Stats.batches;
+    m_Batches.push_back(std::move(batch));
+    return true;
+}
+
+// Images that get mips generated are also storage images, written through R8G8B8A8_UNORM views.
+// sRGB and BGRA formats rarely support storage themselves, hence the mutable format and extended usage.
+bool VulkanTextureSystem::CreateTextureImage(VulkanTexture& texture, bool generateMips)
+{
+    VkImageCreateInfo imageInfo{};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.flags = generateMips ? VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT | VK_IMAGE_CREATE_EXTENDED_USAGE_BIT : 0;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.format = texture.format;
+    imageInfo.extent = { texture.extent.width, texture.extent.height, 1 };
+    imageInfo.mipLevels = texture.mipCount;
+    imageInfo.arrayLayers = 1;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | (generateMips ? VK_IMAGE_USAGE_STORAGE_BIT : 0);
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    if (!m_Memory->CreateImage(imageInfo, MemoryCategory::Textures, texture.image, texture.allocation))
+    {
+        spdlog::error("Failed to create image for texture {}", texture.name);
+        return false;
+    }
+    m_DebugUtils->SetObjectName(VK_OBJECT_TYPE_IMAGE, texture.image, texture.name.c_str());
+
+    // The sampled view must not inherit the storage usage its format may not support
+    VkImageViewUsageCreateInfo viewUsage{};
+    viewUsage.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_USAGE_CREATE_INFO;
+    viewUsage.usage = VK_IMAGE_USAGE_SAMPLED_BIT;
+
+    VkImageViewCreateInfo viewInfo{};
+    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.pNext = generateMips ? &viewUsage : nullptr;
+    viewInfo.image = texture.image;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format = texture.format;
+    viewInfo.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, texture.mipCount, 0, 1 };
+
+    if (vkCreateImageView(m_Device, &viewInfo, nullptr, &texture.view) != VK_SUCCESS)
+    {
+        spdlog::error("Failed to create image view for texture {}", texture.name);
+        m_Memory->DestroyImage(texture.image, texture.allocation);
+        return false;
+    }
+    return true;
+}
+
+void VulkanTextureSystem::DestroyTexture(VulkanTexture& texture)
+{
+    if (texture.view != VK_NULL_HANDLE)
+    {
+        vkDestroyImageView(m_Device, texture.view, nullptr);
+        texture.view = VK_NULL_HANDLE;
+    }
+    m_Memory->DestroyImage(texture.image, texture.allocation);
+}
+
+// Descriptor sets are never freed individually; a texture keeps its set until the system goes away
+bool VulkanTextureSystem::WriteDescriptorSet(VulkanTexture& texture)
+{
+    texture.sampler = m_Samplers.Get(m_SamplerInfo);
+    if (texture.sampler == VK_NULL_HANDLE)
+    {
+        return false;
+    }
+
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = m_DescriptorPool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &m_SetLayout;
+
+    if (vkAllocateDescriptorSets(m_Device, &allocInfo, &texture.descriptorSet) != VK_SUCCESS)
+    {
+        spdlog::error("Failed to allocate descriptor set for texture {}", texture.name);
+        return false;
+    }
+
+    VkDescriptorImageInfo imageInfo{ texture.sampler, texture.view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+
+    VkWriteDescriptorSet write{};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = texture.descriptorSet;
+    write.dstBinding = 0;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    write.pImageInfo = &imageInfo;
+    vkUpdateDescriptorSets(m_Device, 1, &write, 0, nullptr);
+    return true;
+}
+
+bool VulkanTextureSystem::UploadWhiteTexel(VulkanTexture& white, const ImmediateCommandsFunction& execute)
+{
+    VkBuffer stagingBuffer = VK_NULL_HANDLE;
+    VmaAllocation stagingAllocation = VK_NULL_HANDLE;
+    void* stagingMapped = nullptr;
+    if (!m_Memory->CreateBuffer(sizeof(uint32_t), VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY, MemoryCategory::Staging,
+                                stagingBuffer, stagingAllocation, &stagingMapped))
+    {
+        return false;
+    }
+    const uint32_t texel = 0xffffffffu;
+    std::memcpy(stagingMapped, &texel, sizeof(texel));
+    vmaFlushAllocation(m_Memory->GetAllocator(), stagingAllocation, 0, sizeof(texel));
+
+    const bool uploaded = execute([&](VkCommandBuffer commandBuffer)
+    {
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = white.image;
+        barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+        VkBufferImageCopy region{};
+        region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+        region.imageExtent = { 1, 1, 1 };
+        vkCmdCopyBufferToImage(commandBuffer, stagingBuffer, white.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+    });
+    m_Memory->DestroyBuffer(stagingBuffer, stagingAllocation);
+    return uploaded;
+}
+
+// Runs on the loader thread. Everything it touches is free-threaded: VMA synchronizes itself, and
+// the memory telemetry and debug names only involve the new objects.
+bool VulkanTextureSystem::Load(Upload& upload, const std::filesystem::path& path)
+{
+    const auto readStart = std::chrono::steady_clock::now();
+
+    TextureFile file;
+    if (!file.Open(path))
+    {
+        return false;
+    }
+    const TextureDescription& description = file.GetDescription();
+
+    if (IsBlockCompressed(description.format) && !m_TextureCompressionBC)
+    {
+        spdlog::error("Texture {}: {} needs BC texture compression, which the device does not support",
+                      path.string(), ToString(description.format));
+        return false;
+    }
+
+    const VkFormat format = static_cast<VkFormat>(description.format);
+    VkFormatProperties properties;
+    vkGetPhysicalDeviceFormatProperties(m_PhysicalDevice, format, &properties);
+    if ((properties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT) == 0)
+    {
+        spdlog::error("Texture {}: the device cannot sample {}", path.string(), ToString(description.format));
+        return false;
+    }
+
+    // The levels go from the file straight into mapped staging memory, laid out for the copy
+    void* mapped = nullptr;
+    if (!m_Memory->CreateBuffer(description.dataSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY, MemoryCategory::Staging,
+                                upload.stagingBuffer, upload.stagingAllocation, &mapped))
+    {
+        return false;
+    }
+    if (!file.ReadLevels(mapped))
+    {
+        m_Memory->DestroyBuffer(upload.stagingBuffer, upload.stagingAllocation);
+        return false;
+    }
+    vmaFlushAllocation(m_Memory->GetAllocator(), upload.stagingAllocation, 0, description.dataSize);
+    upload.readMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - readStart).count();
+
+    upload.texture.name = path.filename().string();
+    upload.texture.format = format;
+    upload.texture.extent = { description.width, description.height };
+    upload.texture.mipCount = description.generateMips
+        ? GetFullMipCount(description.width, description.height)
+        : static_cast<uint32_t>(description.levels.size());
+    if (!CreateTextureImage(upload.texture, description.generateMips))
+    {
+        m_Memory->DestroyBuffer(upload.stagingBuffer, upload.stagingAllocation);
+        return false;
+    }
+
+    upload.description = description;
+    return true;
+}
+
+// Loads requests until the system stops, pausing while too much read data waits for its copy
+void VulkanTextureSystem::RunLoader()
+{
+    for (;;)
+    {
+        std::filesystem::path path;
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_Condition.wait(lock, [this]
+            {
+                return m_Stopping || (!m_Requests.empty() && m_StagingBytes < MaxStagingBytes);
+            });
+            if (m_Stopping)
+            {
+                return;
+            }
+            path = std::move(m_Requests.front());
+            m_Requests.pop_front();
+        }
+
+        Upload upload;
+        const bool loaded = Load(upload, path);
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (loaded)
+        {
+            m_StagingBytes += upload.description.dataSize;
+            m_Ready.push_back(std::move(upload));
+        }
+        else
+        {
+            ++m_FailedLoads;
+        }
+    }
+}
+
+// Returns a batch's command buffers, synchronization and mip generation objects; its uploads are left alone
+void VulkanTextureSystem::ReleaseBatch(Batch& batch)
+{
+    if (batch.transferCommands != VK_NULL_HANDLE)
+    {
+        vkFreeCommandBuffers(m_Device, m_Queues->GetTransferCommandPool(), 1, &batch.transferCommands);
+        batch.transferCommands = VK_NULL_HANDLE;
+    }
+    if (batch.graphicsCommands != VK_NULL_HANDLE)
+    {
+        vkFreeCommandBuffers(m_Device, m_CommandPool, 1, &batch.graphicsCommands);
+        batch.graphicsCommands = VK_NULL_HANDLE;
+    }
+    if (batch.transferred != VK_NULL_HANDLE)
+    {
+        vkDestroySemaphore(m_Device, batch.transferred, nullptr);
+        batch.transferred = VK_NULL_HANDLE;
+    }
+    if (batch.finished != VK_NULL_HANDLE)
+    {
+        vkDestroyFence(m_Device, batch.finished, nullptr);
+        batch.finished = VK_NULL_HANDLE;
+    }
+    if (batch.mipDescriptorPool != VK_NULL_HANDLE)
+    {
+        vkDestroyDescriptorPool(m_Device, batch.mipDescriptorPool, nullptr);
+        batch.mipDescriptorPool = VK_NULL_HANDLE;
+    }
+    for (VkImageView view : batch.mipViews)
+    {
+        vkDestroyImageView(m_Device, view, nullptr);
+    }
+    batch.mipViews.clear();
+}
+
+// Records the copies of a batch on the transfer queue and hands the images to the graphics queue. Levels
+// the file stored end up shader-readable; textures with mips to generate go to GENERAL for the compute pass.
+void VulkanTextureSystem::RecordCopies(Batch& batch)
+{
+    const bool ownershipTransfer = m_Queues->TransfersOwnership();
+
+    std::vector<VkImageMemoryBarrier> barriers(batch.uploads.size());
+    for (size_t i = 0; i < batch.uploads.size(); ++i)
+    {
+        VkImageMemoryBarrier& barrier = barriers[i];
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = batch.uploads[i].texture.image;
+        barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, batch.uploads[i].texture.mipCount, 0, 1 };
+    }
+    vkCmdPipelineBarrier(batch.transferCommands, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         0, 0, nullptr, 0, nullptr, static_cast<uint32_t>(barriers.size()), barriers.data());
+
+    std::vector<VkBufferImageCopy> regions;
+    for (const Upload& upload : batch.uploads)
+    {
+        regions.clear();
+        for (uint32_t level = 0; level < upload.description.levels.size(); ++level)
+        {
+            const TextureLevel& stored = upload.description.levels[level];
+            VkBufferImageCopy region{};
+            region.bufferOffset = stored.dataOffset;
+            region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1 };
+            region.imageExtent = { stored.width, stored.height, 1 };
+            regions.push_back(region);
+        }
+        vkCmdCopyBufferToImage(batch.transferCommands, upload.stagingBuffer, upload.texture.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                               static_cast<uint32_t>(regions.size()), regions.data());
+    }
+
+    // Within one family this is the transition itself; across families the release half, with the
+    // acquire half recorded by RecordMipGeneration
+    for (size_t i = 0; i < batch.uploads.size(); ++i)
+    {
+        const bool generateMips = batch.uploads[i].description.generateMips;
+        VkImageMemoryBarrier& barrier = barriers[i];
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = ownershipTransfer ? 0 : (generateMips ? VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT : VK_ACCESS_SHADER_READ_BIT);
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = generateMips ? VK_IMAGE_LAYOUT_GENERAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        barrier.srcQueueFamilyIndex = ownershipTransfer ? m_Queues->GetTransfer().family : VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = ownershipTransfer ? m_Queues->GetGraphics().family : VK_QUEUE_FAMILY_IGNORED;
+    }
+    vkCmdPipelineBarrier(batch.transferCommands, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         ownershipTransfer ? VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT : VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                         0, 0, nullptr, 0, nullptr, static_cast<uint32_t>(barriers.size()), barriers.data());
+}
+
+// The graphics queue's half: takes the images over, then generates missing mips one level at a time,
+// each from the level above it. Returns the number of levels generated.
+uint32_t VulkanTextureSystem::RecordMipGeneration(Batch& batch, VkPipelineStageFlags waitStage)
+{
+    VkCommandBuffer commandBuffer = batch.graphicsCommands;
+
+    if (m_Queues->TransfersOwnership())
+    {
+        std::vector<VkImageMemoryBarrier> barriers(batch.uploads.size());
+        for (size_t i = 0; i < batch.uploads.size(); ++i)
+        {
+            const bool generateMips = batch.uploads[i].description.generateMips;
+            VkImageMemoryBarrier& barrier = barriers[i];
+            barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            barrier.srcAccessMask = 0;
+            barrier.dstAccessMask = generateMips ? VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT : VK_ACCESS_SHADER_READ_BIT;
+            barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            barrier.newLayout = generateMips ? VK_IMAGE_LAYOUT_GENERAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+            barrier.srcQueueFamilyIndex = m_Queues->GetTransfer().family;
+            barrier.dstQueueFamilyIndex = m_Queues->GetGraphics().family;
+            barrier.image = batch.uploads[i].texture.image;
+            barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, batch.uploads[i].texture.mipCount, 0, 1 };
+        }
+        vkCmdPipelineBarrier(commandBuffer, waitStage, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                             0, 0, nullptr, 0, nullptr, static_cast<uint32_t>(barriers.size()), barriers.data());
+    }
+
+    uint32_t plannedLevels = 0;
+    for (const Upload& upload : batch.uploads)
+    {
+        if (upload.description.generateMips)
+        {
+            plannedLevels += upload.texture.mipCount - static_cast<uint32_t>(upload.description.levels.size());
+        }
+    }
+    if (plannedLevels == 0)
+    {
+        return 0;
+    }
+
+    // One set per generated level, each binding the level above and the level itself
+    VkDescriptorPoolSize poolSize = { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, plannedLevels * 2 };
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets = plannedLevels;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+
+    if (vkCreateDescriptorPool(m_Device, &poolInfo, nullptr, &batch.mipDescriptorPool) != VK_SUCCESS)
+    {
+        batch.mipDescriptorPool = VK_NULL_HANDLE;
+    }
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_MipPipeline);
+
+    uint32_t generatedLevels = 0;
+    std::vector<VkImageMemoryBarrier> finalBarriers;
+    std::vector<VkImageView> levelViews;
+    for (const Upload& upload : batch.uploads)
+    {
+        if (!upload.description.generateMips)
+        {
+            continue;
+        }
+        const VulkanTexture& texture = upload.texture;
+        const uint32_t firstLevel = static_cast<uint32_t>(upload.description.levels.size());
+        const uint32_t srgb = IsSrgb(upload.description.format) ? 1 : 0;
+        vkCmdPushConstants(commandBuffer, m_MipPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(srgb), &srgb);
+
+        // One view per level from the last stored one down, each the destination of one pass and the source of the next
+        levelViews.clear();
+        for (uint32_t level = firstLevel - 1; level < texture.mipCount && batch.mipDescriptorPool != VK_NULL_HANDLE; ++level)
+        {
+            VkImageViewCreateInfo viewInfo{};
+            viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+            viewInfo.image = texture.image;
+            viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+            viewInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+            viewInfo.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, level, 1, 0, 1 };
+
+            VkImageView view = VK_NULL_HANDLE;
+            if (vkCreateImageView(m_Device, &viewInfo, nullptr, &view) != VK_SUCCESS)
+            {
+                break;
+            }
+            batch.mipViews.push_back(view);
+            levelViews.push_back(view);
+        }
+
+        for (uint32_t level = firstLevel; level < firstLevel - 1 + levelViews.size(); ++level)
+        {
+            VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+            VkDescriptorSetAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+            allocInfo.descriptorPool = batch.mipDescriptorPool;
+            allocInfo.descriptorSetCount = 1;
+            allocInfo.pSetLayouts = &m_MipSetLayout;
+
+            if (vkAllocateDescriptorSets(m_Device, &allocInfo, &descriptorSet) != VK_SUCCESS)
+            {
+                break;
+            }
+
+            VkDescriptorImageInfo imageInfos[2] = {
+                { VK_NULL_HANDLE, levelViews[level - firstLevel], VK_IMAGE_LAYOUT_GENERAL },
+                { VK_NULL_HANDLE, levelViews[level - firstLevel + 1], VK_IMAGE_LAYOUT_GENERAL },
+            };
+            VkWriteDescriptorSet writes[2]{};
+            for (uint32_t i = 0; i < 2; ++i)
+            {
+                writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                writes[i].dstSet = descriptorSet;
+                writes[i].dstBinding = i;
+                writes[i].descriptorCount = 1;
+                writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+                writes[i].pImageInfo = &imageInfos[i];
+            }
+            vkUpdateDescriptorSets(m_Device, 2, writes, 0, nullptr);
+
+            vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_MipPipelineLayout, 0, 1, &descriptorSet, 0, nullptr);
+            const uint32_t width = std::max(texture.extent.width >> level, 1u);
+            const uint32_t height = std::max(texture.extent.height >> level, 1u);
+            vkCmdDispatch(commandBuffer, (width + 7) / 8, (height + 7) / 8, 1);
+            ++generatedLevels;
+
+            // The next pass reads what this one wrote
+            VkImageMemoryBarrier barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+            barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+            barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+            barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.image = texture.image;
+            barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, level, 1, 0, 1 };
+            vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                 0, 0, nullptr, 0, nullptr, 1, &barrier);
+        }
+        if (levelViews.size() < texture.mipCount - firstLevel + 1)
+        {
+            spdlog::error("Failed to prepare the mips of texture {}, the levels below its stored ones are left undefined", texture.name);
+        }
+
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = texture.image;
+        barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, texture.mipCount, 0, 1 };
+        finalBarriers.push_back(barrier);
+    }
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                         0, 0, nullptr, 0, nullptr, static_cast<uint32_t>(finalBarriers.size()), finalBarriers.data());
+    return generatedLevels;
+}
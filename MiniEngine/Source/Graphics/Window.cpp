@@ -27,6 +27,7 @@ Window::Window(const std::string& title, uint32_t width, uint32_t height)
         throw std::runtime_error("Failed to create GLFW window");
     }
 
+    m_RedrawScheduler.Attach(m_Handle);
     spdlog::info("Window created: {} ({}x{})", m_Title, m_Width, m_Height);
 }
 
@@ -34,6 +35,7 @@ Window::~Window()
 {
     if (m_Handle)
     {
+        m_RedrawScheduler.Attach(nullptr);
         glfwDestroyWindow(m_Handle);
         m_Handle = nullptr;
         spdlog::debug("GLFW window destroyed");
@@ -43,3 +45,12 @@ Window::~Window()
     spdlog::debug("GLFW terminated");
 }
 
+bool Window::Update()
+{
+    const bool redraw = m_RedrawScheduler.WaitForRedraw(m_Redraw);
+    if (m_RedrawScheduler.IsQuitRequested())
+    {
+        glfwSetWindowShouldClose(m_Handle, GLFW_TRUE);
+    }
+    return redraw;
+}
@@ -0,0 +1,136 @@
+#include "MiniEngine/Scene/Archetype.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+
+using namespace MiniEngine::Scene;
+
+namespace
+{
+    // Columns are cache-line aligned so SIMD loops over them never straddle lines at the start
+    constexpr std::align_val_t ColumnAlignment{ 64 };
+
+    struct ComponentTypeInfo
+    {
+        size_t size      = 0;
+        size_t alignment = 0;
+    };
+
+    std::mutex s_ComponentTypesMutex;
+    std::vector<ComponentTypeInfo> s_ComponentTypes;
+
+    ComponentTypeInfo GetComponentTypeInfo(ComponentId id)
+    {
+        std::lock_guard lock(s_ComponentTypesMutex);
+        return s_ComponentTypes[id];
+    }
+}
+
+ComponentId Detail::RegisterComponentType(size_t size, size_t alignment)
+{
+    std::lock_guard lock(s_ComponentTypesMutex);
+
+    if (s_ComponentTypes.size() >= MaxComponentTypes)
+    {
+        throw std::length_error("Too many component types registered");
+    }
+
+    if (alignment > static_cast<size_t>(ColumnAlignment))
+    {
+        throw std::invalid_argument("Component alignment exceeds column alignment");
+    }
+
+    s_ComponentTypes.push_back({ size, alignment });
+    return static_cast<ComponentId>(s_ComponentTypes.size() - 1);
+}
+
+Archetype::Archetype(ComponentMask mask)
+    : m_Mask(mask)
+{
+    m_ColumnIndex.fill(NoColumn);
+
+    for (ComponentId id = 0; id < MaxComponentTypes; ++id)
+    {
+        if (HasComponent(id))
+        {
+            m_ColumnIndex[id] = static_cast<uint8_t>(m_Columns.size());
+            m_Columns.push_back({ id, GetComponentTypeInfo(id).size, nullptr });
+        }
+    }
+}
+
+Archetype::~Archetype()
+{
+    for (Column& column : m_Columns)
+    {
+        ::operator delete(column.data, ColumnAlignment);
+    }
+}
+
+void Archetype::Reserve(size_t capacity)
+{
+    if (capacity <= m_Capacity)
+    {
+        return;
+    }
+
+    for (Column& column : m_Columns)
+    {
+        auto* data = static_cast<std::byte*>(::operator new(capacity * column.elementSize, ColumnAlignment));
+        if (column.data)
+        {
+            std::memcpy(data, column.data, m_Entities.size() * column.elementSize);
+            ::operator delete(column.data, ColumnAlignment);
+        }
+        column.data = data;
+    }
+
+    m_Entities.reserve(capacity);
+    m_Capacity = capacity;
+}
+
+uint32_t Archetype::AddRow(Entity entity)
+{
+    if (m_Entities.size() == m_Capacity)
+    {
+        Reserve(std::max<size_t>(64, m_Capacity * 2));
+    }
+
+    m_Entities.push_back(entity);
+    return static_cast<uint32_t>(m_Entities.size() - 1);
+}
+
+Entity Archetype::RemoveRow(uint32_t row)
+{
+    const uint32_t last = static_cast<uint32_t>(m_Entities.size() - 1);
+    Entity moved;
+
+    if (row != last)
+    {
+        for (Column& column : m_Columns)
+        {
+            std::memcpy(column.data + row * column.elementSize, column.data + last * column.elementSize, column.elementSize);
+        }
+        m_Entities[row] = m_Entities[last];
+        moved = m_Entities[row];
+    }
+
+    m_Entities.pop_back();
+    return moved;
+}
+
+void Archetype::CopyRowTo(uint32_t row, Archetype& target, uint32_t targetRow) const
+{
+    for (const Column& column : m_Columns)
+    {
+        void* destination = target.GetColumn(column.id);
+        if (destination)
+        {
+            std::memcpy(static_cast<std::byte*>(destination) + targetRow * column.elementSize,
+                column.data + row * column.elementSize, column.elementSize);
+        }
+    }
+}
@@ -0,0 +1,34 @@
+#include "CullingKernels.hpp"
+
+using namespace MiniEngine::Scene;
+
+size_t Detail::CullObjectsScalar(const FrustumPlanes& planes, const BoundsStreams& bounds, uint32_t first, uint32_t count, uint32_t* output)
+{
+    size_t visible = 0;
+
+    for (uint32_t object = first; object < first + count; ++object)
+    {
+        bool inside = true;
+        for (int plane = 0; plane < 6 && inside; ++plane)
+        {
+            const float distance = planes.normalX[plane] * bounds.centerX[object]
+                + planes.normalY[plane] * bounds.centerY[object]
+                + planes.normalZ[plane] * bounds.centerZ[object]
+                + planes.distance[plane];
+
+            const float boxRadius = planes.absNormalX[plane] * bounds.extentX[object]
+                + planes.absNormalY[plane] * bounds.extentY[object]
+                + planes.absNormalZ[plane] * bounds.extentZ[object];
+
+            const float radius = boxRadius < bounds.radius[object] ? boxRadius : bounds.radius[object];
+            inside = distance + radius >= 0.0f;
+        }
+
+        if (inside)
+        {
+            output[visible++] = bounds.userData[object];
+        }
+    }
+
+    return visible;
+}
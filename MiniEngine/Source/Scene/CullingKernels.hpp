@@ -0,0 +1,45 @@
+#pragma once
+
+// Private to MiniEngine: shared by the per-instruction-set kernel translation units.
+// Kept free of glm and the standard library so the AVX2 unit cannot leak wide
+// instructions into inline functions that other units also instantiate.
+
+#include <cstddef>
+#include <cstdint>
+
+namespace MiniEngine::Scene::Detail
+{
+    // Frustum planes split by component so a kernel can broadcast them
+    struct FrustumPlanes
+    {
+        float normalX[6];
+        float normalY[6];
+        float normalZ[6];
+        float distance[6];
+        float absNormalX[6];
+        float absNormalY[6];
+        float absNormalZ[6];
+    };
+
+    // Object bounds in structure-of-arrays form
+    struct BoundsStreams
+    {
+        const float*    centerX;
+        const float*    centerY;
+        const float*    centerZ;
+        const float*    extentX;
+        const float*    extentY;
+        const float*    extentZ;
+        const float*    radius;
+        const uint32_t* userData;
+    };
+
+    // Tests objects [first, first + count) and writes the user data of visible ones to output, which
+    // must have room for count entries. An object is kept unless it lies fully behind a plane,
+    // using the tighter of its box and sphere.
+    using CullObjectsFunction = size_t (*)(const FrustumPlanes& planes, const BoundsStreams& bounds, uint32_t first, uint32_t count, uint32_t* output);
+
+    size_t CullObjectsScalar(const FrustumPlanes& planes, const BoundsStreams& bounds, uint32_t first, uint32_t count, uint32_t* output);
+    size_t CullObjectsSse(const FrustumPlanes& planes, const BoundsStreams& bounds, uint32_t first, uint32_t count, uint32_t* output);
+    size_t CullObjectsAvx2(const FrustumPlanes& planes, const BoundsStreams& bounds, uint32_t first, uint32_t count, uint32_t* output);
+}
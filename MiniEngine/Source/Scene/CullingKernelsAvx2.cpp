@@ -0,0 +1,65 @@
+#include "CullingKernels.hpp"
+
+#include "MiniEngine/Core/CpuFeatures.hpp"
+
+#if MINIENGINE_SIMD_X86
+#include <immintrin.h>
+#endif
+
+using namespace MiniEngine::Scene;
+
+#if MINIENGINE_SIMD_X86
+
+size_t Detail::CullObjectsAvx2(const FrustumPlanes& planes, const BoundsStreams& bounds, uint32_t first, uint32_t count, uint32_t* output)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    size_t visible = 0;
+
+    uint32_t object = first;
+    const uint32_t end = first + count;
+    for (; object + 8 <= end; object += 8)
+    {
+        // Eight boxes per instruction, one plane at a time
+        const __m256 centerX = _mm256_loadu_ps(bounds.centerX + object);
+        const __m256 centerY = _mm256_loadu_ps(bounds.centerY + object);
+        const __m256 centerZ = _mm256_loadu_ps(bounds.centerZ + object);
+        const __m256 extentX = _mm256_loadu_ps(bounds.extentX + object);
+        const __m256 extentY = _mm256_loadu_ps(bounds.extentY + object);
+        const __m256 extentZ = _mm256_loadu_ps(bounds.extentZ + object);
+        const __m256 sphereRadius = _mm256_loadu_ps(bounds.radius + object);
+
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (int plane = 0; plane < 6; ++plane)
+        {
+            const __m256 distance = _mm256_fmadd_ps(_mm256_set1_ps(planes.normalX[plane]), centerX,
+                _mm256_fmadd_ps(_mm256_set1_ps(planes.normalY[plane]), centerY,
+                    _mm256_fmadd_ps(_mm256_set1_ps(planes.normalZ[plane]), centerZ, _mm256_set1_ps(planes.distance[plane]))));
+
+            const __m256 boxRadius = _mm256_fmadd_ps(_mm256_set1_ps(planes.absNormalX[plane]), extentX,
+                _mm256_fmadd_ps(_mm256_set1_ps(planes.absNormalY[plane]), extentY,
+                    _mm256_mul_ps(_mm256_set1_ps(planes.absNormalZ[plane]), extentZ)));
+
+            const __m256 radius = _mm256_min_ps(boxRadius, sphereRadius);
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(distance, radius), zero, _CMP_GE_OQ));
+        }
+
+        // Branchless compaction: every lane is written, but only visible ones advance the cursor
+        const int mask = _mm256_movemask_ps(inside);
+        for (int lane = 0; lane < 8; ++lane)
+        {
+            output[visible] = bounds.userData[object + lane];
+            visible += (mask >> lane) & 1;
+        }
+    }
+
+    return visible + CullObjectsScalar(planes, bounds, object, end - object, output + visible);
+}
+
+#else
+
+size_t Detail::CullObjectsAvx2(const FrustumPlanes& planes, const BoundsStreams& bounds, uint32_t first, uint32_t count, uint32_t* output)
+{
+    return CullObjectsScalar(planes, bounds, first, count, output);
+}
+
+#endif
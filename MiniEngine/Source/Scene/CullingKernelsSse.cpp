@@ -0,0 +1,68 @@
+#include "CullingKernels.hpp"
+
+#include "MiniEngine/Core/CpuFeatures.hpp"
+
+#if MINIENGINE_SIMD_X86
+#include <emmintrin.h>
+#endif
+
+using namespace MiniEngine::Scene;
+
+#if MINIENGINE_SIMD_X86
+
+size_t Detail::CullObjectsSse(const FrustumPlanes& planes, const BoundsStreams& bounds, uint32_t first, uint32_t count, uint32_t* output)
+{
+    const __m128 zero = _mm_setzero_ps();
+    size_t visible = 0;
+
+    uint32_t object = first;
+    const uint32_t end = first + count;
+    for (; object + 4 <= end; object += 4)
+    {
+        // Four boxes per instruction, one plane at a time
+        const __m128 centerX = _mm_loadu_ps(bounds.centerX + object);
+        const __m128 centerY = _mm_loadu_ps(bounds.centerY + object);
+        const __m128 centerZ = _mm_loadu_ps(bounds.centerZ + object);
+        const __m128 extentX = _mm_loadu_ps(bounds.extentX + object);
+        const __m128 extentY = _mm_loadu_ps(bounds.extentY + object);
+        const __m128 extentZ = _mm_loadu_ps(bounds.extentZ + object);
+        const __m128 sphereRadius = _mm_loadu_ps(bounds.radius + object);
+
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (int plane = 0; plane < 6; ++plane)
+        {
+            const __m128 distance = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes.normalX[plane]), centerX),
+                           _mm_mul_ps(_mm_set1_ps(planes.normalY[plane]), centerY)),
+                _mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes.normalZ[plane]), centerZ),
+                           _mm_set1_ps(planes.distance[plane])));
+
+            const __m128 boxRadius = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes.absNormalX[plane]), extentX),
+                           _mm_mul_ps(_mm_set1_ps(planes.absNormalY[plane]), extentY)),
+                _mm_mul_ps(_mm_set1_ps(planes.absNormalZ[plane]), extentZ));
+
+            const __m128 radius = _mm_min_ps(boxRadius, sphereRadius);
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(distance, radius), zero));
+        }
+
+        // Branchless compaction: every lane is written, but only visible ones advance the cursor
+        const int mask = _mm_movemask_ps(inside);
+        for (int lane = 0; lane < 4; ++lane)
+        {
+            output[visible] = bounds.userData[object + lane];
+            visible += (mask >> lane) & 1;
+        }
+    }
+
+    return visible + CullObjectsScalar(planes, bounds, object, end - object, output + visible);
+}
+
+#else
+
+size_t Detail::CullObjectsSse(const FrustumPlanes& planes, const BoundsStreams& bounds, uint32_t first, uint32_t count, uint32_t* output)
+{
+    return CullObjectsScalar(planes, bounds, first, count, output);
+}
+
+#endif
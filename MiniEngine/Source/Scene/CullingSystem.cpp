@@ -0,0 +1,537 @@
+#include "MiniEngine/Scene/CullingSystem.hpp"
+
+#include "CullingKernels.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+using namespace MiniEngine::Scene;
+
+namespace
+{
+    // One AVX2 batch per leaf
+    constexpr uint32_t MaxLeafObjects = 8;
+
+    // Refits keep the topology of the last build while objects move, so leaves drift apart and their
+    // boxes overlap more. Total leaf area tracks that loss of quality; past this multiple of the area
+    // at build time the tree is rebuilt.
+    constexpr float RebuildAreaRatio = 2.0f;
+
+    // Below this many objects the whole traversal is cheaper than distributing it
+    constexpr size_t ParallelObjectThreshold = 16384;
+    constexpr uint32_t TasksPerThread = 8;
+
+    constexpr uint32_t AllPlanes = (1u << Frustum::PlaneCount) - 1;
+    constexpr uint32_t Outside = 0xFFFFFFFFu;
+    constexpr uint32_t MaxTraversalDepth = 64;
+
+    Detail::CullObjectsFunction GetKernel(MiniEngine::Core::SimdLevel simdLevel)
+    {
+        switch (simdLevel)
+        {
+        case MiniEngine::Core::SimdLevel::Avx2: return Detail::CullObjectsAvx2;
+        case MiniEngine::Core::SimdLevel::Sse:  return Detail::CullObjectsSse;
+        default:                                return Detail::CullObjectsScalar;
+        }
+    }
+
+    Detail::FrustumPlanes ToPlanes(const Frustum& frustum)
+    {
+        Detail::FrustumPlanes planes;
+        for (int i = 0; i < Frustum::PlaneCount; ++i)
+        {
+            const glm::vec4& plane = frustum.planes[i];
+            planes.normalX[i] = plane.x;
+            planes.normalY[i] = plane.y;
+            planes.normalZ[i] = plane.z;
+            planes.distance[i] = plane.w;
+            planes.absNormalX[i] = std::abs(plane.x);
+            planes.absNormalY[i] = std::abs(plane.y);
+            planes.absNormalZ[i] = std::abs(plane.z);
+        }
+        return planes;
+    }
+
+    float SurfaceArea(const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+    {
+        const glm::vec3 size = boundsMax - boundsMin;
+        return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+    }
+
+    double MillisecondsSince(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+CullingSystem::CullingSystem()
+    : CullingSystem(Core::GetSupportedSimdLevel())
+{
+}
+
+CullingSystem::CullingSystem(Core::SimdLevel simdLevel)
+{
+    SetSimdLevel(simdLevel);
+}
+
+CullingSystem::ObjectId CullingSystem::AddObject(const Bounds& bounds, uint32_t userData)
+{
+    ObjectId object;
+    if (!m_FreeObjects.empty())
+    {
+        object = m_FreeObjects.back();
+        m_FreeObjects.pop_back();
+    }
+    else
+    {
+        object = static_cast<ObjectId>(m_Objects.size());
+        m_Objects.emplace_back();
+    }
+
+    m_Objects[object] = { bounds, userData, 0, true };
+    ++m_ObjectCount;
+    m_StructureDirty = true;
+    return object;
+}
+
+void CullingSystem::UpdateObject(ObjectId object, const Bounds& bounds)
+{
+    if (object >= m_Objects.size() || !m_Objects[object].alive)
+    {
+        throw std::invalid_argument("Invalid culling object");
+    }
+
+    m_Objects[object].bounds = bounds;
+
+    if (!m_StructureDirty)
+    {
+        const uint32_t slot = m_Objects[object].slot;
+        WriteSlot(slot, m_Objects[object]);
+        MarkDirty(m_SlotLeaf[slot]);
+    }
+}
+
+void CullingSystem::RemoveObject(ObjectId object)
+{
+    if (object >= m_Objects.size() || !m_Objects[object].alive)
+    {
+        throw std::invalid_argument("Invalid culling object");
+    }
+
+    m_Objects[object].alive = false;
+    m_FreeObjects.push_back(object);
+    --m_ObjectCount;
+    m_StructureDirty = true;
+}
+
+void CullingSystem::Cull(const Frustum& frustum, std::vector<uint32_t>& visible, Core::JobSystem* jobs)
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    Commit();
+    m_Frustum = frustum;
+
+    m_Stats.objectCount = static_cast<uint32_t>(m_ObjectCount);
+    m_Stats.testedNodes = 0;
+    m_Stats.testedObjects = 0;
+    m_Stats.acceptedObjects = 0;
+
+    if (m_Nodes.empty())
+    {
+        visible.clear();
+        m_Stats.visibleObjects = 0;
+        m_Stats.cullTimeMs = MillisecondsSince(start);
+        return;
+    }
+
+    if (!jobs || jobs->GetWorkerCount() == 0 || m_ObjectCount < ParallelObjectThreshold)
+    {
+        Counters counters;
+        visible.resize(m_ObjectCount);
+        visible.resize(TraverseSubtree({ 0, AllPlanes, false }, visible.data(), counters));
+
+        m_Stats.testedNodes = counters.testedNodes;
+        m_Stats.testedObjects = counters.testedObjects;
+        m_Stats.acceptedObjects = counters.acceptedObjects;
+    }
+    else
+    {
+        // Expand the top of the tree breadth-first until there are enough independent subtrees
+        const size_t targetTasks = static_cast<size_t>(jobs->GetConcurrency()) * TasksPerThread;
+        Counters frontierCounters;
+
+        m_Tasks.clear();
+        m_Pending.assign(1, { 0, AllPlanes, false });
+        size_t head = 0;
+
+        while (head < m_Pending.size() && m_Tasks.size() + (m_Pending.size() - head) < targetTasks)
+        {
+            const Task task = m_Pending[head++];
+            const Node& node = m_Nodes[task.node];
+            const uint32_t planeMask = Classify(node, task.planeMask, frontierCounters);
+
+            if (planeMask == Outside)
+            {
+                continue;
+            }
+
+            if (planeMask == 0 || node.firstChild == 0)
+            {
+                m_Tasks.push_back({ task.node, planeMask, planeMask == 0, true });
+                continue;
+            }
+
+            m_Pending.push_back({ node.firstChild, planeMask, false });
+            m_Pending.push_back({ node.firstChild + 1, planeMask, false });
+        }
+        m_Tasks.insert(m_Tasks.end(), m_Pending.begin() + head, m_Pending.end());
+
+        // Subtrees own disjoint slot ranges, so slot order gives the same output as the serial walk
+        std::sort(m_Tasks.begin(), m_Tasks.end(), [this](const Task& a, const Task& b)
+        {
+            return m_Nodes[a.node].objectFirst < m_Nodes[b.node].objectFirst;
+        });
+
+        const size_t taskCount = m_Tasks.size();
+        if (m_TaskOutputs.size() < taskCount)
+        {
+            m_TaskOutputs.resize(taskCount);
+        }
+        m_TaskVisible.assign(taskCount, 0);
+        m_TaskCounters.assign(taskCount, Counters{});
+
+        jobs->ParallelFor(taskCount, 1, [this](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                std::vector<uint32_t>& output = m_TaskOutputs[i];
+                output.resize(m_Nodes[m_Tasks[i].node].objectCount);
+                m_TaskVisible[i] = TraverseSubtree(m_Tasks[i], output.data(), m_TaskCounters[i]);
+            }
+        });
+
+        visible.clear();
+        m_Stats.testedNodes = frontierCounters.testedNodes;
+        for (size_t i = 0; i < taskCount; ++i)
+        {
+            visible.insert(visible.end(), m_TaskOutputs[i].begin(), m_TaskOutputs[i].begin() + m_TaskVisible[i]);
+            m_Stats.testedNodes += m_TaskCounters[i].testedNodes;
+            m_Stats.testedObjects += m_TaskCounters[i].testedObjects;
+            m_Stats.acceptedObjects += m_TaskCounters[i].acceptedObjects;
+        }
+    }
+
+    m_Stats.visibleObjects = static_cast<uint32_t>(visible.size());
+    m_Stats.cullTimeMs = MillisecondsSince(start);
+}
+
+void CullingSystem::CullLinear(const Frustum& frustum, std::vector<uint32_t>& visible)
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    Commit();
+    m_Frustum = frustum;
+
+    const Detail::FrustumPlanes planes = ToPlanes(frustum);
+    const Detail::BoundsStreams streams = {
+        m_CenterX.data(), m_CenterY.data(), m_CenterZ.data(),
+        m_ExtentX.data(), m_ExtentY.data(), m_ExtentZ.data(),
+        m_Radius.data(), m_UserData.data(),
+    };
+
+    const uint32_t count = static_cast<uint32_t>(m_SlotObject.size());
+    visible.resize(count);
+    visible.resize(GetKernel(m_SimdLevel)(planes, streams, 0, count, visible.data()));
+
+    m_Stats.objectCount = count;
+    m_Stats.testedNodes = 0;
+    m_Stats.testedObjects = count;
+    m_Stats.acceptedObjects = 0;
+    m_Stats.visibleObjects = static_cast<uint32_t>(visible.size());
+    m_Stats.cullTimeMs = MillisecondsSince(start);
+}
+
+void CullingSystem::SetSimdLevel(Core::SimdLevel simdLevel)
+{
+    m_SimdLevel = std::min(simdLevel, Core::GetSupportedSimdLevel());
+
+    spdlog::debug("Culling system using {} kernels", Core::ToString(m_SimdLevel));
+}
+
+void CullingSystem::Commit()
+{
+    m_Stats.rebuilt = false;
+    m_Stats.refittedNodes = 0;
+
+    if (m_StructureDirty)
+    {
+        Rebuild();
+        return;
+    }
+
+    if (!m_HasDirtyNodes)
+    {
+        return;
+    }
+
+    // Children always follow their parent, so a reverse sweep refits bottom-up
+    for (size_t i = m_Nodes.size(); i-- > 0;)
+    {
+        if (m_NodeDirty[i])
+        {
+            RefitNode(m_Nodes[i]);
+            m_NodeDirty[i] = 0;
+            ++m_Stats.refittedNodes;
+        }
+    }
+    m_HasDirtyNodes = false;
+
+    // A build whose leaves have no area, such as one of points, has no ratio to degrade by; any
+    // movement would rebuild it every frame, so it waits for the next added or removed object
+    if (m_BuildLeafArea > 0.0f && m_LeafArea > m_BuildLeafArea * RebuildAreaRatio)
+    {
+        spdlog::debug("Culling BVH degraded by refits ({:.1f}x leaf area), rebuilding", m_LeafArea / m_BuildLeafArea);
+        Rebuild();
+    }
+}
+
+void CullingSystem::Rebuild()
+{
+    m_SlotObject.clear();
+    for (ObjectId object = 0; object < m_Objects.size(); ++object)
+    {
+        if (m_Objects[object].alive)
+        {
+            m_SlotObject.push_back(object);
+        }
+    }
+
+    const uint32_t count = static_cast<uint32_t>(m_SlotObject.size());
+    m_CenterX.resize(count);
+    m_CenterY.resize(count);
+    m_CenterZ.resize(count);
+    m_ExtentX.resize(count);
+    m_ExtentY.resize(count);
+    m_ExtentZ.resize(count);
+    m_Radius.resize(count);
+    m_UserData.resize(count);
+    m_SlotLeaf.resize(count);
+
+    m_Nodes.clear();
+    if (count > 0)
+    {
+        m_Nodes.reserve(2 * ((count + MaxLeafObjects - 1) / MaxLeafObjects) + 1);
+        m_Nodes.emplace_back();
+        BuildNode(0, 0, count);
+    }
+
+    for (uint32_t slot = 0; slot < count; ++slot)
+    {
+        Object& object = m_Objects[m_SlotObject[slot]];
+        object.slot = slot;
+        WriteSlot(slot, object);
+    }
+
+    m_LeafArea = 0.0f;
+    for (size_t i = m_Nodes.size(); i-- > 0;)
+    {
+        RefitNode(m_Nodes[i]);
+    }
+    m_BuildLeafArea = m_LeafArea;
+
+    m_NodeDirty.assign(m_Nodes.size(), 0);
+    m_HasDirtyNodes = false;
+    m_StructureDirty = false;
+    m_Stats.rebuilt = true;
+}
+
+void CullingSystem::BuildNode(uint32_t nodeIndex, uint32_t first, uint32_t count)
+{
+    m_Nodes[nodeIndex].objectFirst = first;
+    m_Nodes[nodeIndex].objectCount = count;
+
+    if (count <= MaxLeafObjects)
+    {
+        m_Nodes[nodeIndex].firstChild = 0;
+        std::fill(m_SlotLeaf.begin() + first, m_SlotLeaf.begin() + first + count, nodeIndex);
+        return;
+    }
+
+    // Median split along the axis where the object centers spread the most
+    glm::vec3 centerMin(std::numeric_limits<float>::max());
+    glm::vec3 centerMax(std::numeric_limits<float>::lowest());
+    for (uint32_t slot = first; slot < first + count; ++slot)
+    {
+        const glm::vec3& center = m_Objects[m_SlotObject[slot]].bounds.center;
+        centerMin = glm::min(centerMin, center);
+        centerMax = glm::max(centerMax, center);
+    }
+
+    const glm::vec3 spread = centerMax - centerMin;
+    const int axis = spread.x > spread.y ? (spread.x > spread.z ? 0 : 2) : (spread.y > spread.z ? 1 : 2);
+    const uint32_t half = count / 2;
+
+    auto begin = m_SlotObject.begin() + first;
+    std::nth_element(begin, begin + half, begin + count, [this, axis](ObjectId a, ObjectId b)
+    {
+        return m_Objects[a].bounds.center[axis] < m_Objects[b].bounds.center[axis];
+    });
+
+    const uint32_t children = static_cast<uint32_t>(m_Nodes.size());
+    m_Nodes.resize(m_Nodes.size() + 2);
+    m_Nodes[nodeIndex].firstChild = children;
+    m_Nodes[children].parent = nodeIndex;
+    m_Nodes[children + 1].parent = nodeIndex;
+
+    BuildNode(children, first, half);
+    BuildNode(children + 1, first + half, count - half);
+}
+
+void CullingSystem::WriteSlot(uint32_t slot, const Object& object)
+{
+    m_CenterX[slot] = object.bounds.center.x;
+    m_CenterY[slot] = object.bounds.center.y;
+    m_CenterZ[slot] = object.bounds.center.z;
+    m_ExtentX[slot] = object.bounds.extents.x;
+    m_ExtentY[slot] = object.bounds.extents.y;
+    m_ExtentZ[slot] = object.bounds.extents.z;
+    m_Radius[slot] = object.bounds.radius;
+    m_UserData[slot] = object.userData;
+}
+
+void CullingSystem::MarkDirty(uint32_t node)
+{
+    // Stop at the first ancestor that is already marked, its own ancestors are too
+    while (!m_NodeDirty[node])
+    {
+        m_NodeDirty[node] = 1;
+        if (node == 0)
+        {
+            break;
+        }
+        node = m_Nodes[node].parent;
+    }
+    m_HasDirtyNodes = true;
+}
+
+void CullingSystem::RefitNode(Node& node)
+{
+    if (node.firstChild != 0)
+    {
+        const Node& left = m_Nodes[node.firstChild];
+        const Node& right = m_Nodes[node.firstChild + 1];
+        node.boundsMin = glm::min(left.boundsMin, right.boundsMin);
+        node.boundsMax = glm::max(left.boundsMax, right.boundsMax);
+        return;
+    }
+
+    const float previousArea = node.objectCount > 0 ? SurfaceArea(node.boundsMin, node.boundsMax) : 0.0f;
+
+    glm::vec3 boundsMin(std::numeric_limits<float>::max());
+    glm::vec3 boundsMax(std::numeric_limits<float>::lowest());
+    for (uint32_t slot = node.objectFirst; slot < node.objectFirst + node.objectCount; ++slot)
+    {
+        const glm::vec3 center(m_CenterX[slot], m_CenterY[slot], m_CenterZ[slot]);
+        const glm::vec3 extents(m_ExtentX[slot], m_ExtentY[slot], m_ExtentZ[slot]);
+        boundsMin = glm::min(boundsMin, center - extents);
+        boundsMax = glm::max(boundsMax, center + extents);
+    }
+
+    node.boundsMin = boundsMin;
+    node.boundsMax = boundsMax;
+    m_LeafArea += SurfaceArea(boundsMin, boundsMax) - previousArea;
+}
+
+uint32_t CullingSystem::Classify(const Node& node, uint32_t planeMask, Counters& counters) const
+{
+    ++counters.testedNodes;
+
+    const glm::vec3 center = (node.boundsMin + node.boundsMax) * 0.5f;
+    const glm::vec3 extents = (node.boundsMax - node.boundsMin) * 0.5f;
+
+    // Planes the node is fully in front of are dropped from the mask for the whole subtree
+    for (int i = 0; i < Frustum::PlaneCount; ++i)
+    {
+        if (!(planeMask & (1u << i)))
+        {
+            continue;
+        }
+
+        const glm::vec4& plane = m_Frustum.planes[i];
+        const glm::vec3 normal(plane.x, plane.y, plane.z);
+        const float distance = glm::dot(normal, center) + plane.w;
+        const float radius = glm::dot(glm::abs(normal), extents);
+
+        if (distance + radius < 0.0f)
+        {
+            return Outside;
+        }
+        if (distance - radius >= 0.0f)
+        {
+            planeMask &= ~(1u << i);
+        }
+    }
+
+    return planeMask;
+}
+
+size_t CullingSystem::TraverseSubtree(const Task& task, uint32_t* output, Counters& counters) const
+{
+    if (task.accepted)
+    {
+        const Node& node = m_Nodes[task.node];
+        std::copy_n(m_UserData.begin() + node.objectFirst, node.objectCount, output);
+        counters.acceptedObjects += node.objectCount;
+        return node.objectCount;
+    }
+
+    const Detail::FrustumPlanes planes = ToPlanes(m_Frustum);
+    const Detail::BoundsStreams streams = {
+        m_CenterX.data(), m_CenterY.data(), m_CenterZ.data(),
+        m_ExtentX.data(), m_ExtentY.data(), m_ExtentZ.data(),
+        m_Radius.data(), m_UserData.data(),
+    };
+    const Detail::CullObjectsFunction kernel = GetKernel(m_SimdLevel);
+
+    Task stack[MaxTraversalDepth];
+    uint32_t stackSize = 0;
+    stack[stackSize++] = task;
+
+    size_t visible = 0;
+    while (stackSize > 0)
+    {
+        const Task current = stack[--stackSize];
+        const Node& node = m_Nodes[current.node];
+        const uint32_t planeMask = current.classified ? current.planeMask : Classify(node, current.planeMask, counters);
+
+        if (planeMask == Outside)
+        {
+            continue;
+        }
+
+        if (planeMask == 0)
+        {
+            std::copy_n(m_UserData.begin() + node.objectFirst, node.objectCount, output + visible);
+            visible += node.objectCount;
+            counters.acceptedObjects += node.objectCount;
+        }
+        else if (node.firstChild == 0)
+        {
+            visible += kernel(planes, streams, node.objectFirst, node.objectCount, output + visible);
+            counters.testedObjects += node.objectCount;
+        }
+        else
+        {
+            // Right first so the left subtree is emitted first and output follows slot order
+            stack[stackSize++] = { node.firstChild + 1, planeMask, false };
+            stack[stackSize++] = { node.firstChild, planeMask, false };
+        }
+    }
+
+    return visible;
+}
@@ -0,0 +1,45 @@
+#include "MiniEngine/Scene/Frustum.hpp"
+
+#include <algorithm>
+
+using namespace MiniEngine::Scene;
+
+Frustum Frustum::FromMatrix(const glm::mat4& viewProjection)
+{
+    // Rows of the column-major matrix
+    const glm::vec4 row0(viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0]);
+    const glm::vec4 row1(viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1]);
+    const glm::vec4 row2(viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2]);
+    const glm::vec4 row3(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+
+    Frustum frustum;
+    frustum.planes[Left]   = row3 + row0;
+    frustum.planes[Right]  = row3 - row0;
+    frustum.planes[Bottom] = row3 + row1;
+    frustum.planes[Top]    = row3 - row1;
+    frustum.planes[Near]   = row2;
+    frustum.planes[Far]    = row3 - row2;
+
+    for (glm::vec4& plane : frustum.planes)
+    {
+        plane = plane / glm::length(glm::vec3(plane.x, plane.y, plane.z));
+    }
+
+    return frustum;
+}
+
+bool Frustum::Intersects(const Bounds& bounds) const
+{
+    for (const glm::vec4& plane : planes)
+    {
+        const glm::vec3 normal(plane.x, plane.y, plane.z);
+        const float distance = glm::dot(normal, bounds.center) + plane.w;
+        const float boxRadius = glm::dot(glm::abs(normal), bounds.extents);
+
+        if (distance + std::min(boxRadius, bounds.radius) < 0.0f)
+        {
+            return false;
+        }
+    }
+    return true;
+}
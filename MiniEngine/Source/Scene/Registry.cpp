@@ -0,0 +1,117 @@
+#include "MiniEngine/Scene/Registry.hpp"
+
+#include <stdexcept>
+
+using namespace MiniEngine::Scene;
+
+Registry::Registry()
+{
+    // Entities without components live in the empty archetype, so every live record has one
+    GetOrCreateArchetype(0);
+}
+
+Registry::~Registry() = default;
+
+Entity Registry::Create()
+{
+    Archetype& archetype = *m_ArchetypesByMask.at(0);
+    const Entity entity = AllocateEntity();
+    m_Records[entity.index].archetype = &archetype;
+    m_Records[entity.index].row = archetype.AddRow(entity);
+    return entity;
+}
+
+void Registry::Destroy(Entity entity)
+{
+    EntityRecord& record = GetRecord(entity);
+
+    const Entity moved = record.archetype->RemoveRow(record.row);
+    if (moved.IsValid())
+    {
+        m_Records[moved.index].row = record.row;
+    }
+
+    record.archetype = nullptr;
+    record.row = 0;
+    ++record.generation;
+
+    m_FreeIndices.push_back(entity.index);
+    --m_AliveCount;
+}
+
+bool Registry::IsAlive(Entity entity) const
+{
+    return entity.index < m_Records.size()
+        && m_Records[entity.index].generation == entity.generation
+        && m_Records[entity.index].archetype != nullptr;
+}
+
+Registry::EntityRecord& Registry::GetRecord(Entity entity)
+{
+    if (!IsAlive(entity))
+    {
+        throw std::invalid_argument("Entity handle is stale or invalid");
+    }
+    return m_Records[entity.index];
+}
+
+const Registry::EntityRecord& Registry::GetRecord(Entity entity) const
+{
+    if (!IsAlive(entity))
+    {
+        throw std::invalid_argument("Entity handle is stale or invalid");
+    }
+    return m_Records[entity.index];
+}
+
+Entity Registry::AllocateEntity()
+{
+    ++m_AliveCount;
+
+    if (!m_FreeIndices.empty())
+    {
+        const uint32_t index = m_FreeIndices.back();
+        m_FreeIndices.pop_back();
+        return { index, m_Records[index].generation };
+    }
+
+    m_Records.emplace_back();
+    return { static_cast<uint32_t>(m_Records.size() - 1), 0 };
+}
+
+Archetype& Registry::GetOrCreateArchetype(ComponentMask mask)
+{
+    auto it = m_ArchetypesByMask.find(mask);
+    if (it != m_ArchetypesByMask.end())
+    {
+        return *it->second;
+    }
+
+    m_Archetypes.push_back(std::make_unique<Archetype>(mask));
+    Archetype* archetype = m_Archetypes.back().get();
+    m_ArchetypesByMask.emplace(mask, archetype);
+    return *archetype;
+}
+
+void Registry::MoveEntity(EntityRecord& record, Archetype& target)
+{
+    Archetype& source = *record.archetype;
+    const Entity entity = source.GetEntities()[record.row];
+
+    const uint32_t targetRow = target.AddRow(entity);
+    source.CopyRowTo(record.row, target, targetRow);
+
+    const Entity moved = source.RemoveRow(record.row);
+    if (moved.IsValid())
+    {
+        m_Records[moved.index].row = record.row;
+    }
+
+    record.archetype = &target;
+    record.row = targetRow;
+}
+
+void Registry::ThrowMissingComponent()
+{
+    throw std::out_of_range("Entity does not have the requested component");
+}
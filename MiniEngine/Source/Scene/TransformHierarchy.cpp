@@ -0,0 +1,395 @@
+#include "MiniEngine/Scene/TransformHierarchy.hpp"
+
+#include "TransformKernels.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace MiniEngine::Scene;
+
+namespace
+{
+    // Below this many dirty nodes in one depth level, handing work to other threads costs more than it saves
+    constexpr size_t ParallelLevelThreshold = 8192;
+    constexpr size_t ParallelBatchSize = 2048;
+
+    constexpr uint32_t RootSlot = 0;
+    constexpr uint32_t InvalidSlot = 0xFFFFFFFFu;
+    constexpr uint32_t UnresolvedDepth = 0xFFFFFFFFu;
+
+    Detail::ComputeWorldMatricesFunction GetKernel(MiniEngine::Core::SimdLevel simdLevel)
+    {
+        switch (simdLevel)
+        {
+        case MiniEngine::Core::SimdLevel::Avx2: return Detail::ComputeWorldMatricesAvx2;
+        case MiniEngine::Core::SimdLevel::Sse:  return Detail::ComputeWorldMatricesSse;
+        default:                                return Detail::ComputeWorldMatricesScalar;
+        }
+    }
+
+    template <typename T>
+    void Permute(std::vector<T>& values, const std::vector<uint32_t>& newSlots, size_t newCount)
+    {
+        std::vector<T> permuted(newCount);
+        for (size_t slot = 0; slot < values.size(); ++slot)
+        {
+            if (newSlots[slot] != InvalidSlot)
+            {
+                permuted[newSlots[slot]] = values[slot];
+            }
+        }
+        values = std::move(permuted);
+    }
+}
+
+TransformHierarchy::TransformHierarchy()
+    : TransformHierarchy(Core::GetSupportedSimdLevel())
+{
+}
+
+TransformHierarchy::TransformHierarchy(Core::SimdLevel simdLevel)
+{
+    SetSimdLevel(simdLevel);
+
+    AppendSlot(InvalidNode, RootSlot, Transform{});
+    m_Dirty[RootSlot] = 0;
+    m_World[RootSlot] = glm::mat4(1.0f);
+    m_LevelOffsets = { 1 };
+}
+
+TransformHierarchy::NodeId TransformHierarchy::CreateNode(NodeId parent, const Transform& local)
+{
+    const uint32_t parentSlot = parent == InvalidNode ? RootSlot : GetSlot(parent);
+
+    NodeId node;
+    if (!m_FreeIndices.empty())
+    {
+        node.index = m_FreeIndices.back();
+        m_FreeIndices.pop_back();
+    }
+    else
+    {
+        node.index = static_cast<uint32_t>(m_SlotOfNode.size());
+        m_SlotOfNode.push_back(0);
+        m_NodeGenerations.push_back(0);
+    }
+    node.generation = m_NodeGenerations[node.index];
+
+    m_SlotOfNode[node.index] = static_cast<uint32_t>(m_NodeOfSlot.size());
+    AppendSlot(node, parentSlot, local);
+
+    // Appending may break the depth ordering; it is restored lazily by the next Update
+    m_OrderDirty = true;
+    ++m_NodeCount;
+    return node;
+}
+
+void TransformHierarchy::DestroyNode(NodeId node)
+{
+    // Descendants can only be found by walking forward in parent-before-child order
+    if (m_OrderDirty)
+    {
+        Reorder();
+    }
+
+    const uint32_t first = GetSlot(node);
+    m_Alive[first] = 0;
+    size_t destroyed = 1;
+
+    for (uint32_t other = first + 1; other < m_NodeOfSlot.size(); ++other)
+    {
+        if (m_Alive[other] && !m_Alive[m_Parent[other]])
+        {
+            m_Alive[other] = 0;
+            ++destroyed;
+        }
+    }
+
+    m_NodeCount -= destroyed;
+    m_OrderDirty = true;
+}
+
+bool TransformHierarchy::IsAlive(NodeId node) const
+{
+    // The slot keeps the handle it was created for, generation included, until the next reorder
+    const uint32_t slot = node.index < m_SlotOfNode.size() ? m_SlotOfNode[node.index] : InvalidSlot;
+    return slot < m_NodeOfSlot.size() && m_NodeOfSlot[slot] == node && m_Alive[slot];
+}
+
+void TransformHierarchy::SetParent(NodeId node, NodeId parent)
+{
+    const uint32_t slot = GetSlot(node);
+    const uint32_t parentSlot = parent == InvalidNode ? RootSlot : GetSlot(parent);
+
+    for (uint32_t ancestor = parentSlot; ancestor != RootSlot; ancestor = m_Parent[ancestor])
+    {
+        if (ancestor == slot)
+        {
+            throw std::invalid_argument("Cannot parent a transform node to its own descendant");
+        }
+    }
+
+    m_Parent[slot] = parentSlot;
+    m_Dirty[slot] = 1;
+    m_OrderDirty = true;
+}
+
+TransformHierarchy::NodeId TransformHierarchy::GetParent(NodeId node) const
+{
+    const uint32_t parentSlot = m_Parent[GetSlot(node)];
+    return parentSlot == RootSlot ? InvalidNode : m_NodeOfSlot[parentSlot];
+}
+
+void TransformHierarchy::SetLocalTransform(NodeId node, const Transform& local)
+{
+    const uint32_t slot = GetSlot(node);
+    WriteLocal(slot, local);
+    m_Dirty[slot] = 1;
+}
+
+void TransformHierarchy::SetLocalPosition(NodeId node, const glm::vec3& position)
+{
+    const uint32_t slot = GetSlot(node);
+    m_PositionX[slot] = position.x;
+    m_PositionY[slot] = position.y;
+    m_PositionZ[slot] = position.z;
+    m_Dirty[slot] = 1;
+}
+
+void TransformHierarchy::SetLocalRotation(NodeId node, const glm::quat& rotation)
+{
+    const uint32_t slot = GetSlot(node);
+    m_RotationX[slot] = rotation.x;
+    m_RotationY[slot] = rotation.y;
+    m_RotationZ[slot] = rotation.z;
+    m_RotationW[slot] = rotation.w;
+    m_Dirty[slot] = 1;
+}
+
+void TransformHierarchy::SetLocalScale(NodeId node, const glm::vec3& scale)
+{
+    const uint32_t slot = GetSlot(node);
+    m_ScaleX[slot] = scale.x;
+    m_ScaleY[slot] = scale.y;
+    m_ScaleZ[slot] = scale.z;
+    m_Dirty[slot] = 1;
+}
+
+Transform TransformHierarchy::GetLocalTransform(NodeId node) const
+{
+    const uint32_t slot = GetSlot(node);
+
+    Transform local;
+    local.position = glm::vec3(m_PositionX[slot], m_PositionY[slot], m_PositionZ[slot]);
+    local.rotation = glm::quat(m_RotationW[slot], m_RotationX[slot], m_RotationY[slot], m_RotationZ[slot]);
+    local.scale = glm::vec3(m_ScaleX[slot], m_ScaleY[slot], m_ScaleZ[slot]);
+    return local;
+}
+
+const glm::mat4& TransformHierarchy::GetWorldMatrix(NodeId node) const
+{
+    return m_World[GetSlot(node)];
+}
+
+size_t TransformHierarchy::Update(Core::JobSystem* jobs)
+{
+    if (m_OrderDirty)
+    {
+        Reorder();
+    }
+
+    const Detail::TransformStreams streams = {
+        m_PositionX.data(), m_PositionY.data(), m_PositionZ.data(),
+        m_RotationX.data(), m_RotationY.data(), m_RotationZ.data(), m_RotationW.data(),
+        m_ScaleX.data(), m_ScaleY.data(), m_ScaleZ.data(),
+        m_Parent.data(),
+        &m_World[0][0][0],
+    };
+    const Detail::ComputeWorldMatricesFunction kernel = GetKernel(m_SimdLevel);
+
+    size_t updated = 0;
+    for (size_t level = 1; level < m_LevelOffsets.size(); ++level)
+    {
+        // Parents sit in the previous level, so their dirty flags are already final
+        m_DirtySlots.clear();
+        for (uint32_t slot = m_LevelOffsets[level - 1]; slot < m_LevelOffsets[level]; ++slot)
+        {
+            m_Dirty[slot] |= m_Dirty[m_Parent[slot]];
+            if (m_Dirty[slot])
+            {
+                m_DirtySlots.push_back(slot);
+            }
+        }
+
+        const size_t count = m_DirtySlots.size();
+        if (jobs && count >= ParallelLevelThreshold)
+        {
+            jobs->ParallelFor(count, ParallelBatchSize, [&](size_t begin, size_t end)
+            {
+                kernel(streams, m_DirtySlots.data() + begin, end - begin);
+            });
+        }
+        else if (count > 0)
+        {
+            kernel(streams, m_DirtySlots.data(), count);
+        }
+
+        updated += count;
+    }
+
+    std::fill(m_Dirty.begin(), m_Dirty.end(), uint8_t{ 0 });
+    return updated;
+}
+
+void TransformHierarchy::SetSimdLevel(Core::SimdLevel simdLevel)
+{
+    const Core::SimdLevel supported = Core::GetSupportedSimdLevel();
+    m_SimdLevel = std::min(simdLevel, supported);
+
+    spdlog::debug("Transform hierarchy using {} kernels", Core::ToString(m_SimdLevel));
+}
+
+uint32_t TransformHierarchy::GetSlot(NodeId node) const
+{
+    if (!IsAlive(node))
+    {
+        throw std::invalid_argument("Transform node handle is stale or invalid");
+    }
+    return m_SlotOfNode[node.index];
+}
+
+void TransformHierarchy::AppendSlot(NodeId node, uint32_t parentSlot, const Transform& local)
+{
+    m_PositionX.push_back(0.0f);
+    m_PositionY.push_back(0.0f);
+    m_PositionZ.push_back(0.0f);
+    m_RotationX.push_back(0.0f);
+    m_RotationY.push_back(0.0f);
+    m_RotationZ.push_back(0.0f);
+    m_RotationW.push_back(1.0f);
+    m_ScaleX.push_back(1.0f);
+    m_ScaleY.push_back(1.0f);
+    m_ScaleZ.push_back(1.0f);
+    m_Parent.push_back(parentSlot);
+    m_Dirty.push_back(1);
+    m_Alive.push_back(1);
+    m_World.emplace_back(1.0f);
+    m_NodeOfSlot.push_back(node);
+
+    WriteLocal(static_cast<uint32_t>(m_NodeOfSlot.size() - 1), local);
+}
+
+void TransformHierarchy::WriteLocal(uint32_t slot, const Transform& local)
+{
+    m_PositionX[slot] = local.position.x;
+    m_PositionY[slot] = local.position.y;
+    m_PositionZ[slot] = local.position.z;
+    m_RotationX[slot] = local.rotation.x;
+    m_RotationY[slot] = local.rotation.y;
+    m_RotationZ[slot] = local.rotation.z;
+    m_RotationW[slot] = local.rotation.w;
+    m_ScaleX[slot] = local.scale.x;
+    m_ScaleY[slot] = local.scale.y;
+    m_ScaleZ[slot] = local.scale.z;
+}
+
+void TransformHierarchy::Reorder()
+{
+    const size_t slotCount = m_NodeOfSlot.size();
+
+    // Resolve depths (and liveness through destroyed ancestors) without assuming any order
+    std::vector<uint32_t> depth(slotCount, UnresolvedDepth);
+    depth[RootSlot] = 0;
+
+    std::vector<uint32_t> chain;
+    uint32_t maxDepth = 0;
+    for (uint32_t slot = 1; slot < slotCount; ++slot)
+    {
+        for (uint32_t current = slot; depth[current] == UnresolvedDepth; current = m_Parent[current])
+        {
+            chain.push_back(current);
+        }
+
+        for (auto it = chain.rbegin(); it != chain.rend(); ++it)
+        {
+            const uint32_t parent = m_Parent[*it];
+            depth[*it] = depth[parent] + 1;
+            m_Alive[*it] = m_Alive[*it] && m_Alive[parent];
+            maxDepth = std::max(maxDepth, depth[*it]);
+        }
+        chain.clear();
+    }
+
+    // Stable counting sort of the live slots by depth
+    std::vector<uint32_t> levelOffsets(maxDepth + 1, 0);
+    for (uint32_t slot = 1; slot < slotCount; ++slot)
+    {
+        if (m_Alive[slot])
+        {
+            ++levelOffsets[depth[slot]];
+        }
+    }
+
+    uint32_t offset = 1;
+    for (uint32_t level = 1; level <= maxDepth; ++level)
+    {
+        const uint32_t count = levelOffsets[level];
+        levelOffsets[level] = offset;
+        offset += count;
+    }
+
+    std::vector<uint32_t> newSlots(slotCount, InvalidSlot);
+    newSlots[RootSlot] = RootSlot;
+    for (uint32_t slot = 1; slot < slotCount; ++slot)
+    {
+        if (m_Alive[slot])
+        {
+            newSlots[slot] = levelOffsets[depth[slot]]++;
+        }
+        else
+        {
+            // Only now is the index free for reuse; bumping the generation retires every handle to it
+            const uint32_t index = m_NodeOfSlot[slot].index;
+            ++m_NodeGenerations[index];
+            m_FreeIndices.push_back(index);
+        }
+    }
+
+    const size_t newCount = offset;
+    for (uint32_t& parent : m_Parent)
+    {
+        parent = newSlots[parent] == InvalidSlot ? RootSlot : newSlots[parent];
+    }
+
+    Permute(m_PositionX, newSlots, newCount);
+    Permute(m_PositionY, newSlots, newCount);
+    Permute(m_PositionZ, newSlots, newCount);
+    Permute(m_RotationX, newSlots, newCount);
+    Permute(m_RotationY, newSlots, newCount);
+    Permute(m_RotationZ, newSlots, newCount);
+    Permute(m_RotationW, newSlots, newCount);
+    Permute(m_ScaleX, newSlots, newCount);
+    Permute(m_ScaleY, newSlots, newCount);
+    Permute(m_ScaleZ, newSlots, newCount);
+    Permute(m_Parent, newSlots, newCount);
+    Permute(m_Dirty, newSlots, newCount);
+    Permute(m_Alive, newSlots, newCount);
+    Permute(m_World, newSlots, newCount);
+    Permute(m_NodeOfSlot, newSlots, newCount);
+
+    for (uint32_t slot = 1; slot < newCount; ++slot)
+    {
+        m_SlotOfNode[m_NodeOfSlot[slot].index] = slot;
+    }
+
+    // After the prefix pass each entry holds the end of its level, which is the next level's start
+    m_LevelOffsets.assign(1, 1);
+    for (uint32_t level = 1; level <= maxDepth; ++level)
+    {
+        m_LevelOffsets.push_back(levelOffsets[level]);
+    }
+
+    m_OrderDirty = false;
+}
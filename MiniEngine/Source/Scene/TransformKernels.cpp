@@ -0,0 +1,41 @@
+#include "TransformKernels.hpp"
+
+using namespace MiniEngine::Scene;
+
+void Detail::ComputeWorldMatricesScalar(const TransformStreams& streams, const uint32_t* slots, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        const uint32_t slot = slots[i];
+
+        const float x = streams.rotationX[slot];
+        const float y = streams.rotationY[slot];
+        const float z = streams.rotationZ[slot];
+        const float w = streams.rotationW[slot];
+        const float sx = streams.scaleX[slot];
+        const float sy = streams.scaleY[slot];
+        const float sz = streams.scaleZ[slot];
+
+        // Columns of T * R * S; the last row is implicitly (0, 0, 0, 1)
+        const float local[4][3] = {
+            { (1.0f - 2.0f * (y * y + z * z)) * sx, 2.0f * (x * y + w * z) * sx, 2.0f * (x * z - w * y) * sx },
+            { 2.0f * (x * y - w * z) * sy, (1.0f - 2.0f * (x * x + z * z)) * sy, 2.0f * (y * z + w * x) * sy },
+            { 2.0f * (x * z + w * y) * sz, 2.0f * (y * z - w * x) * sz, (1.0f - 2.0f * (x * x + y * y)) * sz },
+            { streams.positionX[slot], streams.positionY[slot], streams.positionZ[slot] },
+        };
+
+        const float* parent = streams.world + static_cast<size_t>(streams.parent[slot]) * 16;
+        float* world = streams.world + static_cast<size_t>(slot) * 16;
+
+        for (int column = 0; column < 4; ++column)
+        {
+            for (int row = 0; row < 4; ++row)
+            {
+                world[column * 4 + row] = parent[0 * 4 + row] * local[column][0]
+                    + parent[1 * 4 + row] * local[column][1]
+                    + parent[2 * 4 + row] * local[column][2]
+                    + (column == 3 ? parent[3 * 4 + row] : 0.0f);
+            }
+        }
+    }
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+// Private to MiniEngine: shared by the per-instruction-set kernel translation units.
+// Kept free of glm and the standard library so the AVX2 unit cannot leak wide
+// instructions into inline functions that other units also instantiate.
+
+#include <cstddef>
+#include <cstdint>
+
+namespace MiniEngine::Scene::Detail
+{
+    // Structure-of-arrays view of the hierarchy, indexed by storage slot
+    struct TransformStreams
+    {
+        const float*    positionX;
+        const float*    positionY;
+        const float*    positionZ;
+        const float*    rotationX;
+        const float*    rotationY;
+        const float*    rotationZ;
+        const float*    rotationW;
+        const float*    scaleX;
+        const float*    scaleY;
+        const float*    scaleZ;
+        const uint32_t* parent;
+        float*          world; // 16 floats per slot, column-major like glm::mat4
+    };
+
+    // world[slot] = world[parent[slot]] * T * R * S for every slot in the list.
+    // Parents must already be up to date, i.e. all slots in one call share a hierarchy depth.
+    using ComputeWorldMatricesFunction = void (*)(const TransformStreams& streams, const uint32_t* slots, size_t count);
+
+    void ComputeWorldMatricesScalar(const TransformStreams& streams, const uint32_t* slots, size_t count);
+    void ComputeWorldMatricesSse(const TransformStreams& streams, const uint32_t* slots, size_t count);
+    void ComputeWorldMatricesAvx2(const TransformStreams& streams, const uint32_t* slots, size_t count);
+}
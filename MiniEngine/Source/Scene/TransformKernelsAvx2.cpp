@@ -0,0 +1,100 @@
+#include "TransformKernels.hpp"
+
+#include "MiniEngine/Core/CpuFeatures.hpp"
+
+#if MINIENGINE_SIMD_X86
+#include <immintrin.h>
+#endif
+
+using namespace MiniEngine::Scene;
+
+#if MINIENGINE_SIMD_X86
+
+namespace
+{
+    __m256 Gather(const float* stream, __m256i slots)
+    {
+        return _mm256_i32gather_ps(stream, slots, 4);
+    }
+
+    // Low half holds a, high half holds b
+    __m256 Splat2(float a, float b)
+    {
+        return _mm256_set_m128(_mm_set1_ps(b), _mm_set1_ps(a));
+    }
+}
+
+void Detail::ComputeWorldMatricesAvx2(const TransformStreams& streams, const uint32_t* slots, size_t count)
+{
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 two = _mm256_set1_ps(2.0f);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const uint32_t* group = slots + i;
+        const __m256i indices = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(group));
+
+        // Build the 3x4 local matrices of eight nodes at once, one register per element
+        const __m256 x = Gather(streams.rotationX, indices);
+        const __m256 y = Gather(streams.rotationY, indices);
+        const __m256 z = Gather(streams.rotationZ, indices);
+        const __m256 w = Gather(streams.rotationW, indices);
+        const __m256 sx = Gather(streams.scaleX, indices);
+        const __m256 sy = Gather(streams.scaleY, indices);
+        const __m256 sz = Gather(streams.scaleZ, indices);
+
+        const __m256 xx = _mm256_mul_ps(x, x), yy = _mm256_mul_ps(y, y), zz = _mm256_mul_ps(z, z);
+        const __m256 xy = _mm256_mul_ps(x, y), xz = _mm256_mul_ps(x, z), yz = _mm256_mul_ps(y, z);
+        const __m256 wx = _mm256_mul_ps(w, x), wy = _mm256_mul_ps(w, y), wz = _mm256_mul_ps(w, z);
+
+        alignas(32) float local[12][8];
+        _mm256_store_ps(local[0], _mm256_mul_ps(_mm256_fnmadd_ps(two, _mm256_add_ps(yy, zz), one), sx));
+        _mm256_store_ps(local[1], _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xy, wz)), sx));
+        _mm256_store_ps(local[2], _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xz, wy)), sx));
+        _mm256_store_ps(local[3], _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xy, wz)), sy));
+        _mm256_store_ps(local[4], _mm256_mul_ps(_mm256_fnmadd_ps(two, _mm256_add_ps(xx, zz), one), sy));
+        _mm256_store_ps(local[5], _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(yz, wx)), sy));
+        _mm256_store_ps(local[6], _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xz, wy)), sz));
+        _mm256_store_ps(local[7], _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(yz, wx)), sz));
+        _mm256_store_ps(local[8], _mm256_mul_ps(_mm256_fnmadd_ps(two, _mm256_add_ps(xx, yy), one), sz));
+        _mm256_store_ps(local[9], Gather(streams.positionX, indices));
+        _mm256_store_ps(local[10], Gather(streams.positionY, indices));
+        _mm256_store_ps(local[11], Gather(streams.positionZ, indices));
+
+        // world = parent * local, two columns per register
+        for (int lane = 0; lane < 8; ++lane)
+        {
+            const float* parent = streams.world + static_cast<size_t>(streams.parent[group[lane]]) * 16;
+            float* world = streams.world + static_cast<size_t>(group[lane]) * 16;
+
+            const __m128 p3 = _mm_loadu_ps(parent + 12);
+            const __m256 p0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(parent + 0));
+            const __m256 p1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(parent + 4));
+            const __m256 p2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(parent + 8));
+
+            const __m256 columns01 = _mm256_fmadd_ps(p0, Splat2(local[0][lane], local[3][lane]),
+                _mm256_fmadd_ps(p1, Splat2(local[1][lane], local[4][lane]),
+                    _mm256_mul_ps(p2, Splat2(local[2][lane], local[5][lane]))));
+
+            const __m256 columns23 = _mm256_fmadd_ps(p0, Splat2(local[6][lane], local[9][lane]),
+                _mm256_fmadd_ps(p1, Splat2(local[7][lane], local[10][lane]),
+                    _mm256_fmadd_ps(p2, Splat2(local[8][lane], local[11][lane]),
+                        _mm256_insertf128_ps(_mm256_setzero_ps(), p3, 1))));
+
+            _mm256_storeu_ps(world + 0, columns01);
+            _mm256_storeu_ps(world + 8, columns23);
+        }
+    }
+
+    ComputeWorldMatricesScalar(streams, slots + i, count - i);
+}
+
+#else
+
+void Detail::ComputeWorldMatricesAvx2(const TransformStreams& streams, const uint32_t* slots, size_t count)
+{
+    ComputeWorldMatricesScalar(streams, slots, count);
+}
+
+#endif
@@ -0,0 +1,96 @@
+#include "TransformKernels.hpp"
+
+#include "MiniEngine/Core/CpuFeatures.hpp"
+
+#if MINIENGINE_SIMD_X86
+#include <emmintrin.h>
+#endif
+
+using namespace MiniEngine::Scene;
+
+#if MINIENGINE_SIMD_X86
+
+namespace
+{
+    __m128 Gather(const float* stream, const uint32_t* slots)
+    {
+        return _mm_set_ps(stream[slots[3]], stream[slots[2]], stream[slots[1]], stream[slots[0]]);
+    }
+}
+
+void Detail::ComputeWorldMatricesSse(const TransformStreams& streams, const uint32_t* slots, size_t count)
+{
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 two = _mm_set1_ps(2.0f);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        const uint32_t* group = slots + i;
+
+        // Build the 3x4 local matrices of four nodes at once, one register per element
+        const __m128 x = Gather(streams.rotationX, group);
+        const __m128 y = Gather(streams.rotationY, group);
+        const __m128 z = Gather(streams.rotationZ, group);
+        const __m128 w = Gather(streams.rotationW, group);
+        const __m128 sx = Gather(streams.scaleX, group);
+        const __m128 sy = Gather(streams.scaleY, group);
+        const __m128 sz = Gather(streams.scaleZ, group);
+
+        const __m128 xx = _mm_mul_ps(x, x), yy = _mm_mul_ps(y, y), zz = _mm_mul_ps(z, z);
+        const __m128 xy = _mm_mul_ps(x, y), xz = _mm_mul_ps(x, z), yz = _mm_mul_ps(y, z);
+        const __m128 wx = _mm_mul_ps(w, x), wy = _mm_mul_ps(w, y), wz = _mm_mul_ps(w, z);
+
+        alignas(16) float local[12][4];
+        _mm_store_ps(local[0], _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), sx));
+        _mm_store_ps(local[1], _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), sx));
+        _mm_store_ps(local[2], _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), sx));
+        _mm_store_ps(local[3], _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), sy));
+        _mm_store_ps(local[4], _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), sy));
+        _mm_store_ps(local[5], _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), sy));
+        _mm_store_ps(local[6], _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), sz));
+        _mm_store_ps(local[7], _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), sz));
+        _mm_store_ps(local[8], _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), sz));
+        _mm_store_ps(local[9], Gather(streams.positionX, group));
+        _mm_store_ps(local[10], Gather(streams.positionY, group));
+        _mm_store_ps(local[11], Gather(streams.positionZ, group));
+
+        // world = parent * local, one column per register
+        for (int lane = 0; lane < 4; ++lane)
+        {
+            const float* parent = streams.world + static_cast<size_t>(streams.parent[group[lane]]) * 16;
+            float* world = streams.world + static_cast<size_t>(group[lane]) * 16;
+
+            const __m128 p0 = _mm_loadu_ps(parent + 0);
+            const __m128 p1 = _mm_loadu_ps(parent + 4);
+            const __m128 p2 = _mm_loadu_ps(parent + 8);
+            const __m128 p3 = _mm_loadu_ps(parent + 12);
+
+            for (int column = 0; column < 4; ++column)
+            {
+                __m128 result = _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(p0, _mm_set1_ps(local[column * 3 + 0][lane])),
+                               _mm_mul_ps(p1, _mm_set1_ps(local[column * 3 + 1][lane]))),
+                    _mm_mul_ps(p2, _mm_set1_ps(local[column * 3 + 2][lane])));
+
+                if (column == 3)
+                {
+                    result = _mm_add_ps(result, p3);
+                }
+
+                _mm_storeu_ps(world + column * 4, result);
+            }
+        }
+    }
+
+    ComputeWorldMatricesScalar(streams, slots + i, count - i);
+}
+
+#else
+
+void Detail::ComputeWorldMatricesSse(const TransformStreams& streams, const uint32_t* slots, size_t count)
+{
+    ComputeWorldMatricesScalar(streams, slots, count);
+}
+
+#endif
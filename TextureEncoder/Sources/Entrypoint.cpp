@@ -0,0 +1,395 @@
+#include <MiniEngine/Core/JobSystem.hpp>
+#include <MiniEngine/Graphics/TextureEncoder.hpp>
+#include <MiniEngine/Graphics/TextureFile.hpp>
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+using namespace MiniEngine;
+
+namespace
+{
+    struct Image
+    {
+        uint32_t             width  = 0;
+        uint32_t             height = 0;
+        bool                 srgb   = false;
+        std::vector<uint8_t> rgba;
+    };
+
+    struct FormatName
+    {
+        const char*             name;
+        Graphics::TextureFormat linear;
+        Graphics::TextureFormat srgb; // Undefined when the format has no sRGB variant
+    };
+
+    constexpr FormatName FormatNames[] = {
+        { "bc1", Graphics::TextureFormat::Bc1RgbaUnorm, Graphics::TextureFormat::Bc1RgbaSrgb },
+        { "bc3", Graphics::TextureFormat::Bc3Unorm,     Graphics::TextureFormat::Bc3Srgb },
+        { "bc4", Graphics::TextureFormat::Bc4Unorm,     Graphics::TextureFormat::Undefined },
+        { "bc5", Graphics::TextureFormat::Bc5Unorm,     Graphics::TextureFormat::Undefined },
+        { "bc7", Graphics::TextureFormat::Bc7Unorm,     Graphics::TextureFormat::Bc7Srgb },
+    };
+
+    bool HasArgument(int argc, char** argv, const char* name)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            if (std::strcmp(argv[i], name) == 0)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // The value following name on the command line, e.g. "--format bc7"
+    std::string GetArgument(int argc, char** argv, const char* name, const char* defaultValue)
+    {
+        for (int i = 1; i + 1 < argc; ++i)
+        {
+            if (std::strcmp(argv[i], name) == 0)
+            {
+                return argv[i + 1];
+            }
+        }
+        return defaultValue;
+    }
+
+    // Skips whitespace and comments, then reads a decimal number
+    bool ReadNetpbmNumber(std::FILE* file, uint32_t& value)
+    {
+        int c = std::fgetc(file);
+        while (c == '#' || std::isspace(c))
+        {
+            if (c == '#')
+            {
+                while (c != '\n' && c != EOF)
+                {
+                    c = std::fgetc(file);
+                }
+            }
+            c = std::fgetc(file);
+        }
+        if (!std::isdigit(c))
+        {
+            return false;
+        }
+        value = 0;
+        while (std::isdigit(c))
+        {
+            value = value * 10 + static_cast<uint32_t>(c - '0');
+            c = std::fgetc(file);
+        }
+        return true;
+    }
+
+    // Binary PPM (P6) and PAM (P7) with 8-bit RGB or RGBA, which most image tools export
+    bool ReadNetpbm(const std::filesystem::path& path, Image& image)
+    {
+        std::FILE* file = std::fopen(path.string().c_str(), "rb");
+        if (!file)
+        {
+            spdlog::error("Failed to open {}", path.string());
+            return false;
+        }
+
+        char magic[3] = {};
+        uint32_t channels = 0;
+        uint32_t maxValue = 0;
+        bool valid = std::fread(magic, 1, 2, file) == 2;
+        if (valid && std::strcmp(magic, "P6") == 0)
+        {
+            channels = 3;
+            valid = ReadNetpbmNumber(file, image.width) && ReadNetpbmNumber(file, image.height) && ReadNetpbmNumber(file, maxValue);
+        }
+        else if (valid && std::strcmp(magic, "P7") == 0)
+        {
+            // Key and value lines up to ENDHDR
+            char line[256];
+            while (valid && std::fgets(line, sizeof(line), file) && std::strncmp(line, "ENDHDR", 6) != 0)
+            {
+                char key[32] = {};
+                uint32_t value = 0;
+                if (std::sscanf(line, "%31s %u", key, &value) == 2)
+                {
+                    image.width = std::strcmp(key, "WIDTH") == 0 ? value : image.width;
+                    image.height = std::strcmp(key, "HEIGHT") == 0 ? value : image.height;
+                    channels = std::strcmp(key, "DEPTH") == 0 ? value : channels;
+                    maxValue = std::strcmp(key, "MAXVAL") == 0 ? value : maxValue;
+                }
+            }
+        }
+        else
+        {
+            valid = false;
+        }
+
+        valid = valid && maxValue == 255 && (channels == 3 || channels == 4) && image.width > 0 && image.height > 0;
+        std::vector<uint8_t> texels;
+        if (valid)
+        {
+            texels.resize(static_cast<size_t>(image.width) * image.height * channels);
+            valid = std::fread(texels.data(), 1, texels.size(), file) == texels.size();
+        }
+        std::fclose(file);
+        if (!valid)
+        {
+            spdlog::error("{} is not an 8-bit RGB or RGBA binary PPM or PAM file", path.string());
+            return false;
+        }
+
+        const size_t texelCount = static_cast<size_t>(image.width) * image.height;
+        image.rgba.resize(texelCount * 4);
+        for (size_t texel = 0; texel < texelCount; ++texel)
+        {
+            std::memcpy(&image.rgba[texel * 4], &texels[texel * channels], channels);
+            image.rgba[texel * 4 + 3] = channels == 4 ? texels[texel * channels + 3] : 255;
+        }
+
+        // Netpbm images hold sRGB colours unless they say otherwise
+        image.srgb = true;
+        return true;
+    }
+
+    // The top level of an uncompressed KTX2 or DDS file
+    bool ReadTexture(const std::filesystem::path& path, Image& image)
+    {
+        Graphics::TextureFile file;
+        if (!file.Open(path))
+        {
+            return false;
+        }
+
+        const Graphics::TextureDescription& description = file.GetDescription();
+        const Graphics::TextureFormat format = description.format;
+        const bool bgra = format == Graphics::TextureFormat::B8G8R8A8Unorm || format == Graphics::TextureFormat::B8G8R8A8Srgb;
+        if (!bgra && format != Graphics::TextureFormat::R8G8B8A8Unorm && format != Graphics::TextureFormat::R8G8B8A8Srgb)
+        {
+            spdlog::error("{} holds {} texels; only RGBA8 and BGRA8 can be encoded", path.string(), Graphics::ToString(format));
+            return false;
+        }
+
+        std::vector<uint8_t> data(description.dataSize);
+        if (!file.ReadLevels(data.data()))
+        {
+            return false;
+        }
+
+        image.width = description.width;
+        image.height = description.height;
+        image.srgb = Graphics::IsSrgb(format);
+        image.rgba.assign(data.begin() + description.levels[0].dataOffset, data.begin() + description.levels[0].dataOffset + description.levels[0].size);
+        if (bgra)
+        {
+            for (size_t texel = 0; texel < image.rgba.size(); texel += 4)
+            {
+                std::swap(image.rgba[texel], image.rgba[texel + 2]);
+            }
+        }
+        return true;
+    }
+
+    float SrgbToLinear(float value)
+    {
+        return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+    }
+
+    float LinearToSrgb(float value)
+    {
+        return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+    }
+
+    // Averages each 2x2 square into one texel, an odd last row or column joining the square before it.
+    // sRGB colours are averaged in linear light so mips do not darken; alpha is always linear.
+    Image Downsample(const Image& source, const std::array<float, 256>& toLinear)
+    {
+        Image level;
+        level.width = std::max(source.width / 2, 1u);
+        level.height = std::max(source.height / 2, 1u);
+        level.srgb = source.srgb;
+        level.rgba.resize(static_cast<size_t>(level.width) * level.height * 4);
+
+        for (uint32_t y = 0; y < level.height; ++y)
+        {
+            const uint32_t firstRow = std::min(y * 2, source.height - 1);
+            const uint32_t lastRow = y + 1 == level.height ? source.height - 1 : std::min(y * 2 + 1, source.height - 1);
+            for (uint32_t x = 0; x < level.width; ++x)
+            {
+                const uint32_t firstColumn = std::min(x * 2, source.width - 1);
+                const uint32_t lastColumn = x + 1 == level.width ? source.width - 1 : std::min(x * 2 + 1, source.width - 1);
+
+                float sums[4] = {};
+                uint32_t count = 0;
+                for (uint32_t row = firstRow; row <= lastRow; ++row)
+                {
+                    for (uint32_t column = firstColumn; column <= lastColumn; ++column, ++count)
+                    {
+                        const uint8_t* texel = &source.rgba[(static_cast<size_t>(row) * source.width + column) * 4];
+                        for (int c = 0; c < 4; ++c)
+                        {
+                            sums[c] += source.srgb && c < 3 ? toLinear[texel[c]] : texel[c] / 255.0f;
+                        }
+                    }
+                }
+
+                uint8_t* texel = &level.rgba[(static_cast<size_t>(y) * level.width + x) * 4];
+                for (int c = 0; c < 4; ++c)
+                {
+                    const float average = sums[c] / count;
+                    const float value = source.srgb && c < 3 ? LinearToSrgb(average) : average;
+                    texel[c] = static_cast<uint8_t>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+                }
+            }
+        }
+        return level;
+    }
+
+    void PrintUsage()
+    {
+        spdlog::info("Usage: TextureEncoder <input.ppm|.pam|.ktx2|.dds> <output.ktx2|.dds> [options]");
+        spdlog::info("  --format bc1|bc3|bc4|bc5|bc7     block format (default bc7)");
+        spdlog::info("  --quality fast|normal|high       endpoint search effort (default normal)");
+        spdlog::info("  --srgb / --linear                colour space of BC1, BC3 and BC7 (default: the input's)");
+        spdlog::info("  --no-mips                        only the top level; otherwise the full chain is written");
+        spdlog::info("  --threads N                      0 for every hardware thread (default)");
+        spdlog::info("  --simd scalar|sse|avx2           cap the kernels used (default: the widest supported)");
+    }
+}
+
+// Compresses an image into a BC1, BC3, BC4, BC5 or BC7 texture, with a box filtered mip chain, and
+// writes it as KTX2 or DDS for the renderer's texture loader. Reports each level's PSNR against the
+// texels it was encoded from and the encoding throughput.
+int main(int argc, char** argv)
+{
+    if (argc < 3 || HasArgument(argc, argv, "--help"))
+    {
+        PrintUsage();
+        return argc < 3 ? 1 : 0;
+    }
+    const std::filesystem::path inputPath = argv[1];
+    const std::filesystem::path outputPath = argv[2];
+
+    const std::string formatName = GetArgument(argc, argv, "--format", "bc7");
+    const FormatName* format = std::find_if(std::begin(FormatNames), std::end(FormatNames),
+        [&](const FormatName& candidate) { return formatName == candidate.name; });
+    if (format == std::end(FormatNames))
+    {
+        spdlog::error("Unknown format '{}'", formatName);
+        PrintUsage();
+        return 1;
+    }
+
+    const std::string qualityName = GetArgument(argc, argv, "--quality", "normal");
+    Graphics::TextureEncodeQuality quality = Graphics::TextureEncodeQuality::Normal;
+    if (qualityName == "fast")
+    {
+        quality = Graphics::TextureEncodeQuality::Fast;
+    }
+    else if (qualityName == "high")
+    {
+        quality = Graphics::TextureEncodeQuality::High;
+    }
+    else if (qualityName != "normal")
+    {
+        spdlog::error("Unknown quality '{}'", qualityName);
+        PrintUsage();
+        return 1;
+    }
+
+    const std::string simdName = GetArgument(argc, argv, "--simd", "avx2");
+    Core::SimdLevel simdLevel = Core::SimdLevel::Avx2;
+    if (simdName == "scalar")
+    {
+        simdLevel = Core::SimdLevel::Scalar;
+    }
+    else if (simdName == "sse")
+    {
+        simdLevel = Core::SimdLevel::Sse;
+    }
+    else if (simdName != "avx2")
+    {
+        spdlog::error("Unknown SIMD level '{}'", simdName);
+        PrintUsage();
+        return 1;
+    }
+
+    const std::string extension = inputPath.extension().string();
+    Image image;
+    const bool read = extension == ".ppm" || extension == ".pam" ? ReadNetpbm(inputPath, image) : ReadTexture(inputPath, image);
+    if (!read)
+    {
+        return 1;
+    }
+
+    image.srgb = HasArgument(argc, argv, "--srgb") || (image.srgb && !HasArgument(argc, argv, "--linear"));
+    const Graphics::TextureFormat textureFormat = image.srgb && format->srgb != Graphics::TextureFormat::Undefined ? format->srgb : format->linear;
+    const Graphics::TextureContainer container = outputPath.extension() == ".dds" ? Graphics::TextureContainer::Dds : Graphics::TextureContainer::Ktx2;
+
+    const std::string threadArgument = GetArgument(argc, argv, "--threads", "0");
+    if (threadArgument.empty() || !std::all_of(threadArgument.begin(), threadArgument.end(), [](char c) { return std::isdigit(static_cast<unsigned char>(c)); }))
+    {
+        spdlog::error("Invalid thread count '{}'", threadArgument);
+        return 1;
+    }
+    const uint32_t threadCount = static_cast<uint32_t>(std::stoul(threadArgument));
+    Core::JobSystem jobs(threadCount);
+    const Graphics::TextureEncoder encoder(simdLevel);
+
+    const uint32_t levelCount = HasArgument(argc, argv, "--no-mips") ? 1 : Graphics::GetFullMipCount(image.width, image.height);
+    const Graphics::TextureDescription description = Graphics::MakeTextureDescription(textureFormat, image.width, image.height, levelCount);
+    spdlog::info("{}: {}x{}, {} levels as {}, {} quality, {} kernels on {} threads", inputPath.string(), image.width, image.height, levelCount,
+        Graphics::ToString(textureFormat), Graphics::ToString(quality), Core::ToString(encoder.GetSimdLevel()), jobs.GetConcurrency());
+
+    std::array<float, 256> toLinear;
+    for (uint32_t value = 0; value < 256; ++value)
+    {
+        toLinear[value] = SrgbToLinear(value / 255.0f);
+    }
+
+    using Clock = std::chrono::steady_clock;
+    std::vector<uint8_t> data(description.dataSize);
+    std::vector<uint8_t> decoded;
+    double encodeSeconds = 0.0;
+    uint64_t texelCount = 0;
+    Image level = std::move(image);
+    for (uint32_t i = 0; i < levelCount; ++i)
+    {
+        if (i > 0)
+        {
+            level = Downsample(level, toLinear);
+        }
+
+        const Graphics::TextureLevel& layout = description.levels[i];
+        const Clock::time_point start = Clock::now();
+        encoder.Encode(textureFormat, quality, level.rgba.data(), level.width, level.height, data.data() + layout.dataOffset, &jobs);
+        encodeSeconds += std::chrono::duration<double>(Clock::now() - start).count();
+        texelCount += static_cast<uint64_t>(level.width) * level.height;
+
+        decoded.resize(level.rgba.size());
+        Graphics::DecodeTexture(textureFormat, data.data() + layout.dataOffset, level.width, level.height, decoded.data());
+        const double psnr = Graphics::ComputePsnr(level.rgba.data(), decoded.data(), level.width, level.height, Graphics::GetEncodedChannelCount(textureFormat));
+        spdlog::info("  level {:2} {:5}x{:<5} PSNR {:6.2f} dB", i, level.width, level.height, psnr);
+    }
+
+    spdlog::info("Encoded {:.2f} megapixels in {:.1f} ms: {:.1f} MP/s", texelCount / 1e6, encodeSeconds * 1000.0, texelCount / 1e6 / encodeSeconds);
+
+    if (!Graphics::WriteTextureFile(outputPath, container, description, data.data()))
+    {
+        return 1;
+    }
+    spdlog::info("Wrote {} ({:.1f} KiB)", outputPath.string(), description.dataSize / 1024.0);
+    return 0;
+}
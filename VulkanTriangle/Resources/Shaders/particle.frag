@@ -0,0 +1,12 @@
+#version 450
+
+layout(location = 0) in  vec3 vColor;
+layout(location = 1) in  vec2 vCorner;
+layout(location = 0) out vec4 outColor;
+
+// Blended additively, so a soft round falloff is all a particle needs
+void main()
+{
+    float falloff = max(1.0 - dot(vCorner, vCorner), 0.0);
+    outColor = vec4(vColor * falloff, 1.0);
+}
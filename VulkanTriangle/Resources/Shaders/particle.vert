@@ -0,0 +1,37 @@
+#version 450
+
+// Expands each particle instance into a camera-facing quad; there is no vertex buffer
+
+layout(location = 0) out vec3 vColor;
+layout(location = 1) out vec2 vCorner;
+
+struct Instance
+{
+    vec4 positionSize;
+    vec4 color;
+};
+
+layout(set = 0, binding = 0) uniform ParticleUniforms
+{
+    mat4 viewProjection;
+    vec4 cameraRight; // w is the particle size
+    vec4 cameraUp;
+} frame;
+
+layout(std430, set = 0, binding = 5) readonly buffer Instances { Instance instances[]; };
+
+const vec2 corners[6] = vec2[](
+    vec2(-1.0, -1.0), vec2(1.0, -1.0), vec2(1.0, 1.0),
+    vec2(-1.0, -1.0), vec2(1.0, 1.0), vec2(-1.0, 1.0)
+);
+
+void main()
+{
+    Instance instance = instances[gl_InstanceIndex];
+    vec2 corner = corners[gl_VertexIndex];
+    vec3 offset = (frame.cameraRight.xyz * corner.x + frame.cameraUp.xyz * corner.y) * instance.positionSize.w;
+
+    gl_Position = frame.viewProjection * vec4(instance.positionSize.xyz + offset, 1.0);
+    vColor      = instance.color.rgb;
+    vCorner     = corner;
+}
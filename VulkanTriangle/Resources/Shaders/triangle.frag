@@ -1,9 +1,102 @@
 #version 450
 
+// Forward shading with clustered light lists. The fragment finds its cluster from its screen
+// position and view depth and only evaluates the lights binned there; with clustering off it
+// loops over every light, which is the reference the clustered path is measured against.
+
 layout(location = 0) in  vec3 vColor;
+layout(location = 1) in  vec3 vViewPosition;
+layout(location = 2) in  vec2 vTexCoord;
 layout(location = 0) out vec4 outColor;
 
+struct Light
+{
+    vec4 positionRange;
+    vec4 directionCosine;
+    vec4 color;
+};
+
+struct Cluster
+{
+    uint offset;
+    uint count;
+};
+
+layout(set = 1, binding = 0) uniform LightingUniforms
+{
+    mat4  view;
+    vec4  screenSizeTileSize;
+    vec4  projection;
+    vec4  ambientSliceScale;
+    uint  gridSizeX;
+    uint  gridSizeY;
+    uint  gridSizeZ;
+    uint  lightCount;
+    float sliceBias;
+    uint  clustered;
+} lighting;
+
+layout(std430, set = 1, binding = 1) readonly buffer Lights { Light lights[]; };
+layout(std430, set = 1, binding = 2) readonly buffer Clusters { Cluster clusters[]; };
+layout(std430, set = 1, binding = 3) readonly buffer LightIndices { uint lightIndices[]; };
+
+layout(set = 2, binding = 0) uniform sampler2D albedo;
+
+vec3 shadeLight(Light light, vec3 position, vec3 normal)
+{
+    vec3  toLight  = light.positionRange.xyz - position;
+    float distance = length(toLight);
+    float range    = light.positionRange.w;
+    if (distance >= range)
+    {
+        return vec3(0.0);
+    }
+    vec3 direction = toLight / distance;
+
+    // Inverse square falloff windowed to reach zero at the range
+    float window      = clamp(1.0 - pow(distance / range, 4.0), 0.0, 1.0);
+    float attenuation = window * window / (distance * distance + 1.0);
+
+    float cosOuter = light.directionCosine.w;
+    if (cosOuter > -1.0)
+    {
+        float cosAngle = dot(-direction, light.directionCosine.xyz);
+        attenuation *= smoothstep(cosOuter, min(cosOuter + 0.1, 1.0), cosAngle);
+    }
+
+    return light.color.rgb * attenuation * max(dot(normal, direction), 0.0);
+}
+
 void main()
 {
-    outColor = vec4(vColor, 1.0);
+    // The triangles carry no normals; the face normal, turned towards the camera, lights both sides
+    vec3 normal = normalize(cross(dFdx(vViewPosition), dFdy(vViewPosition)));
+    if (dot(normal, vViewPosition) > 0.0)
+    {
+        normal = -normal;
+    }
+
+    vec3 light = lighting.ambientSliceScale.rgb;
+
+    if (lighting.clustered != 0)
+    {
+        float depth = -vViewPosition.z;
+        uint  sliceZ = uint(clamp(log(depth) * lighting.ambientSliceScale.w - lighting.sliceBias, 0.0, float(lighting.gridSizeZ - 1u)));
+        uvec2 tile   = min(uvec2(gl_FragCoord.xy / lighting.screenSizeTileSize.zw), uvec2(lighting.gridSizeX - 1u, lighting.gridSizeY - 1u));
+
+        Cluster cluster = clusters[(sliceZ * lighting.gridSizeY + tile.y) * lighting.gridSizeX + tile.x];
+        for (uint i = 0; i < cluster.count; ++i)
+        {
+            light += shadeLight(lights[lightIndices[cluster.offset + i]], vViewPosition, normal);
+        }
+    }
+    else
+    {
+        for (uint i = 0; i < lighting.lightCount; ++i)
+        {
+            light += shadeLight(lights[i], vViewPosition, normal);
+        }
+    }
+
+    outColor = vec4(vColor * texture(albedo, vTexCoord).rgb * light, 1.0);
 }
@@ -1,22 +1,39 @@
 #version 450
 
-// Per-vertex position & color calculated from gl_VertexIndex
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inColor;
+layout(location = 2) in vec2 inTexCoord;
+
 layout(location = 0) out vec3 vColor;
+layout(location = 1) out vec3 vViewPosition;
+layout(location = 2) out vec2 vTexCoord;
 
-void main()
+struct Object
+{
+    mat4 model;
+    vec4 boundsCenterRadius;
+    vec4 boundsExtents;
+};
+
+layout(set = 0, binding = 0) uniform FrameUniforms
 {
-    const vec2  positions[3] = vec2[3](
-        vec2( 0.0, -0.5),   // bottom-center
-        vec2( 0.5,  0.5),   // top-right
-        vec2(-0.5,  0.5)    // top-left
-    );
+    mat4 viewProjection;
+} frame;
 
-    const vec3  colors[3] = vec3[3](
-        vec3(1.0, 0.0, 0.0),   // red
-        vec3(0.0, 1.0, 0.0),   // green
-        vec3(0.0, 0.0, 1.0)    // blue
-    );
+// Indirect draws set firstInstance to the object index
+layout(std430, set = 0, binding = 1) readonly buffer Objects { Object objects[]; };
 
-    gl_Position = vec4(positions[gl_VertexIndex], 0.0, 1.0);
-    vColor      = colors[gl_VertexIndex];
+// Only the view matrix at the start of the lighting constants is needed here
+layout(set = 1, binding = 0) uniform LightingUniforms
+{
+    mat4 view;
+} lighting;
+
+void main()
+{
+    vec4 worldPosition = objects[gl_InstanceIndex].model * vec4(inPosition, 1.0);
+    gl_Position   = frame.viewProjection * worldPosition;
+    vColor        = inColor;
+    vViewPosition = (lighting.view * worldPosition).xyz;
+    vTexCoord     = inTexCoord;
 }
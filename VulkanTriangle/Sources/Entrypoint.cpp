@@ -2,13 +2,54 @@
 #include <GLFW/glfw3.h>
 #include <spdlog/spdlog.h>
 #include <VkBootstrap.h>
-#define VMA_IMPLEMENTATION
 #include <vk_mem_alloc.h>
 
+#include <MiniEngine/Core/FrameClock.hpp>
+#include <MiniEngine/Core/FramePipeline.hpp>
+#include <MiniEngine/Core/JobSystem.hpp>
+#include <MiniEngine/Core/Log.hpp>
+#include <MiniEngine/Core/TaskGraph.hpp>
+#include <MiniEngine/Graphics/DrawQueue.hpp>
+#include <MiniEngine/Graphics/FrameTrace.hpp>
+#include <MiniEngine/Graphics/ImageSequenceWriter.hpp>
+#include <MiniEngine/Graphics/MeshLod.hpp>
+#include <MiniEngine/Graphics/Meshlet.hpp>
+#include <MiniEngine/Graphics/RedrawScheduler.hpp>
+#include <MiniEngine/Graphics/VulkanDebugUtils.hpp>
+#include <MiniEngine/Graphics/VulkanMemory.hpp>
+#include <MiniEngine/Graphics/VulkanQueues.hpp>
+#include <MiniEngine/Graphics/VulkanClusteredLighting.hpp>
+#include <MiniEngine/Graphics/VulkanCommandEncoder.hpp>
+#include <MiniEngine/Graphics/VulkanContext.hpp>
+#include <MiniEngine/Graphics/VulkanFrameReadback.hpp>
+#include <MiniEngine/Graphics/VulkanOcclusionCulling.hpp>
+#include <MiniEngine/Graphics/VulkanParticleSystem.hpp>
+#include <MiniEngine/Graphics/VulkanTextureSystem.hpp>
+#include <MiniEngine/Scene/Components.hpp>
+#include <MiniEngine/Scene/CullingSystem.hpp>
+#include <MiniEngine/Scene/Frustum.hpp>
+#include <MiniEngine/Scene/Registry.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <mutex>
+#include <span>
 #include <string>
+#include <thread>
 #include <vector>
+#include <filesystem>
 #include <fstream> // For readFile
+#include <functional>
+#include <iterator>
+#include <random>
+#include <unordered_map>
 #include <glm/glm.hpp> // For Vertex struct
+#include <glm/gtc/matrix_transform.hpp>
 
 /// Data structures
 struct Window
@@ -17,6 +58,8 @@ struct Window
 	uint32_t width;
 	uint32_t height;
 	GLFWwindow* handle = nullptr;
+	bool visible = true;
+	bool vsync = true; // Off presents immediately where the surface allows it
 };
 
 // Define these structs before they are used
@@ -31,7 +74,13 @@ struct VulkanDevice
 	VkQueue                  graphicsQueue            = VK_NULL_HANDLE;
 	uint32_t                 presentQueueFamilyIndex  = 0;
 	VkQueue                  presentQueue             = VK_NULL_HANDLE;
-	VmaAllocator             allocator                = VK_NULL_HANDLE;
+	bool                     textureCompressionBC     = false; // BC1-7 textures can be sampled
+	VkPipelineCache          pipelineCache            = VK_NULL_HANDLE; // Seeded from the previous run's, saved on exit
+	std::unordered_map<std::string, std::vector<char>> shaderCode; // SPIR-V read during startup, by path, taken by the first pipeline using it
+	MiniEngine::Graphics::InstrumentationLevel instrumentation = MiniEngine::Graphics::DefaultInstrumentationLevel; // Set before createVulkanDevice
+	MiniEngine::Graphics::VulkanDebugUtils     debugUtils;      // Object names and command buffer labels, no-ops below Labels
+	MiniEngine::Graphics::VulkanMemory         memory;          // The allocator, counting what each allocation is for
+	MiniEngine::Graphics::VulkanQueues         queues;          // Graphics with the compute and transfer queues beside it
 };
 
 struct VulkanSwapChain
@@ -47,6 +96,10 @@ struct VulkanSwapChain
 	VkImage                    depthImage           = VK_NULL_HANDLE;
 	VmaAllocation              depthImageAllocation = VK_NULL_HANDLE;
 	VkImageView                depthImageView       = VK_NULL_HANDLE;
+	// Scene color, rendered at the dynamic resolution and blitted to the presented image
+	VkImage                    sceneColorImage      = VK_NULL_HANDLE;
+	VmaAllocation              sceneColorAllocation = VK_NULL_HANDLE;
+	VkImageView                sceneColorView       = VK_NULL_HANDLE;
 	// Framebuffers (one per image in the swap chain)
 	std::vector<VkFramebuffer> framebuffers;
 };
@@ -68,42 +121,286 @@ struct VulkanSynchronization
 
 // --- New Data Structures ---
 struct Vertex {
-    glm::vec3 pos;
-    glm::vec3 color;
-    // glm::vec2 texCoord; // Could be added later for texturing
+	glm::vec3 pos;
+	glm::vec3 color;
+	glm::vec2 texCoord;
 };
 
+// Levels of detail a mesh may have; the culling shader holds each level's index range in its uniforms
+constexpr uint32_t MaxMeshLods = MiniEngine::Graphics::MaxOcclusionLods;
+
 struct VulkanMesh {
-    VkBuffer      vertexBuffer       = VK_NULL_HANDLE;
-    VmaAllocation vertexBufferMemory = VK_NULL_HANDLE;
-    uint32_t      vertexCount        = 0;
-    // VkBuffer      indexBuffer        = VK_NULL_HANDLE; // Optional for indexed drawing
-    // VmaAllocation indexBufferMemory  = VK_NULL_HANDLE;
-    // uint32_t      indexCount         = 0;
+	VkBuffer      vertexBuffer       = VK_NULL_HANDLE;
+	VmaAllocation vertexBufferMemory = VK_NULL_HANDLE;
+	uint32_t      vertexCount        = 0;
+	VkBuffer      indexBuffer        = VK_NULL_HANDLE; // Every level's indices, level 0 first
+	VmaAllocation indexBufferMemory  = VK_NULL_HANDLE;
+	uint32_t      indexCount         = 0;
+	VkBuffer      meshletBuffer      = VK_NULL_HANDLE; // Every level's meshlets, read by the culling shader
+	VmaAllocation meshletBufferMemory = VK_NULL_HANDLE;
+	std::vector<MiniEngine::Graphics::MeshLod> lods;
+	std::vector<MiniEngine::Graphics::Meshlet> meshlets;
+	std::vector<glm::uvec2>                    lodMeshlets; // First meshlet and count of each level
 };
 
 struct VulkanPipeline {
-    VkPipelineLayout pipelineLayout   = VK_NULL_HANDLE;
-    VkRenderPass     renderPass       = VK_NULL_HANDLE;
-    VkPipeline       graphicsPipeline = VK_NULL_HANDLE;
-    // VkShaderModule   vertShaderModule = VK_NULL_HANDLE; // Optional: if managed by pipeline
-    // VkShaderModule   fragShaderModule = VK_NULL_HANDLE; // Optional: if managed by pipeline
+	VkPipelineLayout pipelineLayout   = VK_NULL_HANDLE;
+	VkRenderPass     renderPass       = VK_NULL_HANDLE;
+	VkRenderPass     loadRenderPass   = VK_NULL_HANDLE; // Continues renderPass's attachments instead of clearing them
+	VkPipeline       graphicsPipeline = VK_NULL_HANDLE;
+	// VkShaderModule   vertShaderModule = VK_NULL_HANDLE; // Optional: if managed by pipeline
+	// VkShaderModule   fragShaderModule = VK_NULL_HANDLE; // Optional: if managed by pipeline
 };
 // --- End New Data Structures ---
 
+// Scene components, next to the engine ones in MiniEngine::Scene
+struct Renderable {
+	uint32_t drawIndex     = 0; // Index into SceneState::modelMatrices, also the culling user data
+	uint32_t cullingObject = 0;
+};
+
+struct Spin {
+	float speed = 0.0f; // Radians per second around the vertical axis
+};
+
+// A point light, or a spot light aimed along the transform's -Y axis when coneAngle is set
+struct LightSource {
+	glm::vec3 color     = glm::vec3(1.0f); // Linear, premultiplied by intensity
+	float     range     = 4.0f;
+	float     coneAngle = 0.0f;            // Half angle in radians, 0 for point lights
+};
+
+// Circles around center in the horizontal plane
+struct Orbit {
+	glm::vec3 center = glm::vec3(0.0f);
+	float     radius = 0.0f;
+	float     speed  = 0.0f; // Radians per second
+	float     phase  = 0.0f;
+};
+
+// Triangles sent to the GPU for the frustum-visible objects; occlusion culling may still drop some
+struct LodStats {
+	uint64_t                           triangles           = 0;
+	uint64_t                           fullDetailTriangles = 0; // Had every object been drawn at level 0
+	std::array<uint32_t, MaxMeshLods>  objects{};               // Per level
+};
+
+struct SceneState {
+	MiniEngine::Scene::Registry            registry;
+	MiniEngine::Scene::CullingSystem       culling;
+	std::vector<glm::mat4>                 modelMatrices;
+	std::vector<MiniEngine::Scene::Bounds> objectBounds; // World bounds, indexed like modelMatrices
+	std::vector<uint32_t>                  visible;
+	MiniEngine::Graphics::DrawQueue        drawQueue; // Orders the visible objects before upload
+	std::vector<MiniEngine::Scene::Entity> lights;
+	float                                  extent = 0.0f; // Half the side of the object grid
+	float                                  interpolation = 1.0f; // Where rendering sits between the last two simulation steps
+	std::vector<MiniEngine::Graphics::MeshLod> meshLods; // Of the mesh every object draws
+	std::vector<uint8_t>                   objectLods; // Level each object drew last frame, indexed like modelMatrices
+	bool                                   lodEnabled = true;
+	float                                  lodThresholdPixels = 1.0f; // Screen error a level may have before a finer one is drawn
+	LodStats                               lodStats;
+};
+
+// Per-object data read by the occlusion culling and vertex shaders
+using GpuObject = MiniEngine::Graphics::OcclusionObject;
+
+// A light as the binning and lit shaders read it
+using GpuLight = MiniEngine::Graphics::ClusteredLight;
+
+// Everything the command buffer needs for one frame, produced by frustum culling
+struct DrawList {
+	glm::mat4              view           = glm::mat4(1.0f);
+	glm::mat4              projection     = glm::mat4(1.0f);
+	glm::mat4              viewProjection = glm::mat4(1.0f);
+	float                  nearPlane      = 0.1f;
+	float                  farPlane       = 200.0f;
+	std::vector<GpuObject> objects;
+	std::vector<GpuLight>  lights;
+};
+
+// Everything about a captured frame besides its objects and lights, stored in the trace as raw bytes
+enum TraceFlags : uint32_t {
+	TraceOcclusion = 1u << 0,
+	TraceClustered = 1u << 1,
+	TraceReuse     = 1u << 2,
+	TraceMeshlets  = 1u << 3,
+};
+
+struct TraceFrameState {
+	glm::mat4 view;
+	glm::mat4 projection;
+	float     nearPlane;
+	float     farPlane;
+	float     deltaTime;
+	float     renderScale;
+	uint32_t  flags;        // TraceFlags
+	uint32_t  textureIndex;
+	uint32_t  padding[2];
+};
+
+// The trace's streams: one state record, then the frame's objects and lights
+constexpr uint32_t TraceRecordSizes[] = { sizeof(TraceFrameState), sizeof(GpuObject), sizeof(GpuLight) };
+
+// Key presses the render thread acts on, one frame each
+struct RenderInput {
+	bool toggleOcclusion  = false;
+	bool toggleMeshlets   = false;
+	bool toggleReuse      = false;
+	bool toggleLighting   = false;
+	bool toggleResolution = false;
+	bool defragment       = false;
+	bool nextTexture      = false;
+};
+
+// Whether each key behind RenderInput was down at the last poll, so holding one counts as one press
+struct RenderInputKeys {
+	bool occlusion  = false;
+	bool meshlets   = false;
+	bool reuse      = false;
+	bool lighting   = false;
+	bool resolution = false;
+	bool defragment = false;
+	bool texture    = false;
+};
+
+// One simulated frame, handed from the main thread to the render thread. Nothing in it points back
+// into the scene, so the main thread can simulate the next frame while this one is rendered.
+struct FramePacket {
+	DrawList                             drawList;
+	RenderInput                          input;
+	double                               now           = 0.0;
+	float                                deltaTime     = 0.0f;
+	bool                                 memoryOverlay = false;
+	double                               simulateMs    = 0.0; // Main thread time spent producing it
+	MiniEngine::Core::FrameClockStats    clock;
+	bool                                 replayed      = false; // Read from a trace, drawn with replayState's settings
+	TraceFrameState                      replayState   = {};
+	MiniEngine::Graphics::Redraw         redraw;
+	MiniEngine::Scene::CullingStats      culling;
+	MiniEngine::Graphics::DrawQueueStats drawQueue;
+	LodStats                             lod;
+};
+
+// Where each side of the frame pipeline spent its time, summed since startup
+struct FrameTimings {
+	uint64_t frames       = 0;
+	double   simulateMs   = 0.0; // Main thread: input, scene update and draw list
+	double   mainWaitMs   = 0.0; // Main thread: waiting for a free packet
+	double   renderMs     = 0.0; // Render thread: from taking a packet to presenting it
+	double   renderWaitMs = 0.0; // Render thread: waiting for a packet
+};
+
+// Where a benchmark is in its steps, each of which settles before it is measured
+struct BenchmarkSchedule {
+	size_t step      = 0;
+	double stepStart = 0.0;
+	bool   measuring = false;
+};
+
+enum class BenchmarkEvent {
+	None,
+	Settled, // The step starts being measured
+	Measured // The step is done, and the schedule has moved on to the next one
+};
+
+// Frame rate and each thread's times in this run's rendering mode, over one measured step
+struct PipelineBenchmark {
+	BenchmarkSchedule schedule;
+	double            measureStart = 0.0;
+	FrameTimings      startTimings;
+};
+
+// Redraws and the CPU used waiting between them, over one measured step
+struct IdleBenchmark {
+	BenchmarkSchedule                 schedule;
+	MiniEngine::Graphics::RedrawStats startStats;
+};
+
+// What a command buffer was recorded against; it can be submitted again while all of it still matches
+struct RecordedCommands {
+	uint64_t        generation        = 0; // 0 when never recorded
+	uint32_t        objectCapacity    = 0;
+	uint32_t        lightCapacity     = 0;
+	VkExtent2D      renderExtent      = {};
+	bool            occlusionEnabled  = false;
+	bool            clusteredLighting = false;
+	VkDescriptorSet textureSet        = VK_NULL_HANDLE;
+};
+
+// CPU cost of getting a frame's commands to the queue: recording (or reusing) plus submission
+struct CommandRecordingStats {
+	double   cpuMs[2]   = { 0.0, 0.0 }; // Smoothed, without / with command buffer reuse
+	uint32_t samples[2] = { 0, 0 };
+	uint32_t recorded   = 0;
+	uint32_t reused     = 0;
+};
+
+enum ResolutionTimestamp : uint32_t {
+	ResolutionTimestampFrameBegin,
+	ResolutionTimestampFrameEnd, // After the upscale, so the whole frame counts against the budget
+	ResolutionTimestampCount
+};
+
+// Resources owned by one frame in flight
+struct VulkanResolutionFrame {
+	VkQueryPool timestampPool = VK_NULL_HANDLE;
+	VkExtent2D  renderExtent  = {}; // Resolution of the last submission
+	bool        submitted     = false;
+};
+
+struct DynamicResolutionStats {
+	double   gpuFrameMs = 0.0;  // Smoothed GPU time of the whole frame, upscale included
+	float    minScale   = 1.0f; // Lowest scale since the last report
+	uint32_t increases  = 0;
+	uint32_t decreases  = 0;
+};
+
+// Dynamic resolution. The scene renders into the top-left part of a scene color target the size of
+// the swap chain, and a final blit scales that part up to the presented image. The part shrinks as
+// soon as a few frames in a row go over the GPU budget, and only grows back after a long run of
+// frames with enough headroom that the next step up is predicted to stay within it. The scale moves
+// in fixed steps, so only a handful of distinct recordings ever exist.
+struct VulkanDynamicResolution {
+	static constexpr float    MinScale         = 0.5f;
+	static constexpr float    ScaleStep        = 0.05f;
+	static constexpr uint32_t DecreaseFrames   = 3;    // Consecutive frames over budget before scaling down
+	static constexpr uint32_t IncreaseFrames   = 60;   // Consecutive frames with headroom before scaling up
+	static constexpr double   IncreaseHeadroom = 0.85; // Fraction of the budget a step up must be predicted to stay under
+
+	std::vector<VulkanResolutionFrame> frames;
+	float                              timestampPeriod  = 0.0f; // Nanoseconds per tick, 0 when unsupported
+	bool                               enabled          = false;
+	double                             budgetMs         = 16.0;
+	float                              scale            = 1.0f;
+	VkExtent2D                         renderExtent     = {};
+	uint32_t                           overBudgetFrames = 0;
+	uint32_t                           headroomFrames   = 0;
+	DynamicResolutionStats             stats;
+};
+
 struct VulkanRenderer
 {
 	VulkanDevice                 device;         // Use composition instead of pointers
 	VulkanSwapChain              swapChain;      // Use composition instead of pointers
 	VulkanSynchronization        synchronization;// Use composition instead of pointers
 	VkCommandPool                commandPool     = VK_NULL_HANDLE;
-	std::vector<VkCommandBuffer> commandBuffers;
+	std::vector<VkCommandBuffer> commandBuffers;    // One per frame in flight and swap chain image
+	std::vector<RecordedCommands> recordedCommands; // Indexed like commandBuffers
+	uint64_t                     commandGeneration = 1; // Bumped to invalidate every recorded command buffer
+	bool                         reuseCommandBuffers = true;
+	CommandRecordingStats        recordingStats;
+	MiniEngine::Graphics::VulkanCommandEncoder commandEncoder; // Records the frame, skipping redundant state changes
+	MiniEngine::Graphics::VulkanContext        context;        // What the MiniEngine rendering modules are created with
 };
 
 /// Function declarations
 bool initWindow(Window& window);
-bool initVulkanRenderer(VulkanRenderer& renderer, const Window& window);
-bool createVulkanDevice(VulkanDevice& device, const Window& window);
+bool initVulkanRenderer(VulkanRenderer& renderer, const vkb::Instance& instance, const Window& window); // Once the window and instance exist
+bool createVulkanInstance(vkb::Instance& instance, VulkanDevice& device, const Window& window); // Needs nothing from the window but its title
+bool createVulkanDevice(VulkanDevice& device, const vkb::Instance& instance, const Window& window);
+bool createPipelineCache(VulkanDevice& device, const std::vector<char>& data); // Empty data starts an empty cache
+bool savePipelineCache(VulkanDevice& device, const std::string& path);
 bool createSwapChain(VulkanSwapChain& swapChain, VulkanDevice& device, const Window& window);
 bool createSynchronization(VulkanSynchronization& sync, VulkanDevice& device, const VulkanSwapChain& swapChain); // Added
 
@@ -115,25 +412,92 @@ void destroyWindow(Window& window);
 
 // Utility Functions
 std::vector<char> readFile(const std::string& filename);
+bool readShaderDirectory(std::unordered_map<std::string, std::vector<char>>& shaderCode, const std::string& directory); // Every .spv file, checked to be SPIR-V
+std::vector<char> readShaderFile(VulkanDevice& device, const std::string& path); // Preloaded code if there is any, otherwise from disk
 VkShaderModule createShaderModule(VkDevice device, const std::vector<char>& code);
 VkVertexInputBindingDescription getVertexBindingDescription();
 std::vector<VkVertexInputAttributeDescription> getVertexAttributeDescriptions();
+uint32_t parseUintArgument(int argc, char** argv, const std::string& name, uint32_t defaultValue);
+std::string parseStringArgument(int argc, char** argv, const std::string& name, const std::string& defaultValue = {});
+MiniEngine::Graphics::InstrumentationLevel parseInstrumentationArgument(int argc, char** argv);
+bool hasArgument(int argc, char** argv, const std::string& name);
+
+// Scene
+void createScene(SceneState& scene, uint32_t objectCount);
+void createLights(SceneState& scene, uint32_t lightCount); // Replaces the scene's lights
+void updateScene(SceneState& scene, float time, float deltaTime); // One fixed simulation step, ending at time
+void interpolateScene(SceneState& scene, float alpha); // Places moving objects for rendering, alpha of the way through the last step
+void buildDrawList(DrawList& drawList, SceneState& scene, VkExtent2D extent, float time, MiniEngine::Core::JobSystem& jobs);
+std::string formatFrameTimings(const FrameTimings& current, const FrameTimings& previous, double seconds); // Per frame averages of the difference
+
+// Frame Capture
+bool captureFrame(MiniEngine::Graphics::FrameTraceWriter& trace, const DrawList& drawList, TraceFrameState state); // Takes the camera from drawList
+bool readReplayFrame(MiniEngine::Graphics::FrameTraceReader& trace, DrawList& drawList, TraceFrameState& state);
+TraceFrameState currentTraceState( // The settings captureFrame stores with the frame
+	float deltaTime,
+	const VulkanRenderer& renderer,
+	const MiniEngine::Graphics::VulkanOcclusionCulling& occlusion,
+	const MiniEngine::Graphics::VulkanClusteredLighting& lighting,
+	const VulkanDynamicResolution& resolution,
+	const MiniEngine::Graphics::VulkanTextureSystem& textures
+);
+
+// Frame Loop
+bool wasKeyPressed(GLFWwindow* window, int key, bool& keyDown); // True on the poll the key goes down
+void pollRenderInput(GLFWwindow* window, RenderInputKeys& keys, RenderInput& input);
+void applyRenderInput( // A replayed frame's settings, then the key presses
+	const FramePacket& packet,
+	VulkanRenderer& renderer,
+	MiniEngine::Graphics::VulkanOcclusionCulling& occlusion,
+	MiniEngine::Graphics::VulkanClusteredLighting& lighting,
+	VulkanDynamicResolution& resolution,
+	MiniEngine::Graphics::VulkanTextureSystem& textures
+);
+void logRenderStats( // Restarts the counters that are reported per interval
+	const FramePacket& packet,
+	VulkanRenderer& renderer,
+	const VulkanMesh& mesh,
+	const MiniEngine::Graphics::VulkanOcclusionCulling& occlusion,
+	const MiniEngine::Graphics::VulkanClusteredLighting& lighting,
+	VulkanDynamicResolution& resolution,
+	const MiniEngine::Graphics::VulkanParticleSystem& particles,
+	const MiniEngine::Graphics::VulkanFrameReadback& readback,
+	const MiniEngine::Graphics::VulkanTextureSystem& textures
+);
+void logStartupTimeline(const MiniEngine::Core::TaskGraph& startup, const std::string& tracePath); // Writes the trace when a path is given
+BenchmarkEvent advanceBenchmark(BenchmarkSchedule& schedule, double now, double settleSeconds, double measureSeconds);
+void updatePipelineBenchmark(PipelineBenchmark& benchmark, double now, const FrameTimings& timings, const std::string& renderingMode,
+	MiniEngine::Graphics::RedrawScheduler& redraw);
+void updateIdleBenchmark(IdleBenchmark& benchmark, double now, MiniEngine::Graphics::RedrawScheduler& redraw);
+void updateTextureBenchmark(const MiniEngine::Graphics::VulkanTextureSystem& textures, double elapsedSeconds, MiniEngine::Graphics::RedrawScheduler& redraw);
+
+// Depth & Occlusion Culling
+bool createDepthResources(VulkanSwapChain& swapChain, VulkanDevice& device);
+void destroyDepthResources(VulkanSwapChain& swapChain, VulkanDevice& device);
+bool executeImmediateCommands(VulkanRenderer& renderer, const std::function<void(VkCommandBuffer)>& record);
+MiniEngine::Graphics::VulkanContext createVulkanContext(VulkanRenderer& renderer); // Once the device, its pipeline cache and the command pool exist
 
 // Mesh Lifecycle
-bool createVertexBuffer(VulkanMesh& mesh, VulkanDevice& device, VmaAllocator allocator, const std::vector<Vertex>& vertices);
-void destroyMesh(VulkanMesh& mesh, VulkanDevice& device, VmaAllocator allocator);
+void tessellateTriangle(const Vertex (&corners)[3], uint32_t subdivisions, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+bool createTriangleMesh(VulkanMesh& mesh, VulkanRenderer& renderer); // Tessellated, with its levels of detail split into meshlets
+bool createVertexBuffer(VulkanMesh& mesh, VulkanRenderer& renderer, const std::vector<Vertex>& vertices);
+bool createIndexBuffer(VulkanMesh& mesh, VulkanRenderer& renderer, const std::vector<uint32_t>& indices);
+bool createMeshletBuffer(VulkanMesh& mesh, VulkanRenderer& renderer); // From mesh.meshlets
+void destroyMesh(VulkanMesh& mesh, VulkanDevice& device);
 
 // Pipeline Lifecycle
-bool createRenderPass(VkRenderPass& renderPass, VulkanDevice& device, VkFormat swapChainImageFormat);
+bool createRenderPass(VkRenderPass& renderPass, VulkanDevice& device, VkFormat swapChainImageFormat, VkFormat depthFormat, bool clearAttachments);
 void destroyRenderPass(VkRenderPass& renderPass, VulkanDevice& device); // If render pass is managed separately
 
 bool createGraphicsPipeline(
-    VulkanPipeline& pipeline,
-    VulkanDevice& device,
-    VkExtent2D swapChainExtent,
-    VkRenderPass compatibleRenderPass,
-    const std::string& vertShaderPath,
-    const std::string& fragShaderPath
+	VulkanPipeline& pipeline,
+	VulkanDevice& device,
+	VkRenderPass compatibleRenderPass,
+	VkDescriptorSetLayout sceneSetLayout,
+	VkDescriptorSetLayout lightingSetLayout,
+	VkDescriptorSetLayout textureSetLayout,
+	const std::string& vertShaderPath,
+	const std::string& fragShaderPath
 );
 void destroyVulkanPipeline(VulkanPipeline& pipeline, VulkanDevice& device);
 
@@ -144,135 +508,790 @@ void destroyFramebuffers(VulkanSwapChain& swapChain, VulkanDevice& device);
 // Command Pool & Buffer Management
 bool createCommandPool(VulkanRenderer& renderer);
 bool createCommandBuffers(VulkanRenderer& renderer); // Renamed from createPrimaryCommandBuffers for clarity
+void invalidateRecordedCommands(VulkanRenderer& renderer); // Call when anything recorded into command buffers changes
+
+// Dynamic Resolution
+bool createSceneColorResources(VulkanSwapChain& swapChain, VulkanDevice& device);
+void destroySceneColorResources(VulkanSwapChain& swapChain, VulkanDevice& device);
+bool createDynamicResolution(VulkanDynamicResolution& resolution, VulkanRenderer& renderer);
+void destroyDynamicResolution(VulkanDynamicResolution& resolution, VulkanDevice& device);
+void setRenderScale(VulkanDynamicResolution& resolution, float scale, VkExtent2D targetExtent);
+void readResolutionResults(VulkanResolutionFrame& frame, VulkanDynamicResolution& resolution, VulkanDevice& device, VkExtent2D targetExtent);
+void recordUpscale(VkCommandBuffer commandBuffer, VulkanDynamicResolution& resolution, VulkanResolutionFrame& frame, VulkanSwapChain& swapChain, uint32_t imageIndex);
+
+
 
 // Drawing Operations
 bool drawFrame(
-    VulkanRenderer& renderer,
-    VulkanPipeline& activePipeline,
-    VulkanMesh& meshToDraw
+	VulkanRenderer& renderer,
+	VulkanPipeline& activePipeline,
+	VulkanMesh& meshToDraw,
+	MiniEngine::Graphics::VulkanOcclusionCulling& occlusion,
+	MiniEngine::Graphics::VulkanClusteredLighting& lighting,
+	VulkanDynamicResolution& resolution,
+	MiniEngine::Graphics::VulkanParticleSystem& particles,
+	MiniEngine::Graphics::VulkanFrameReadback& readback,
+	VkDescriptorSet textureSet,
+	const DrawList& drawList
 );
 
 void recordCommandBuffer(
-    VkCommandBuffer commandBuffer,
-    uint32_t imageIndex,
-    VulkanRenderer& renderer,
-    VulkanPipeline& activePipeline,
-    VulkanMesh& meshToDraw
+	VkCommandBuffer commandBuffer,
+	uint32_t imageIndex,
+	VulkanRenderer& renderer,
+	VulkanPipeline& activePipeline,
+	VulkanMesh& meshToDraw,
+	MiniEngine::Graphics::VulkanOcclusionCulling& occlusion,
+	MiniEngine::Graphics::VulkanClusteredLighting& lighting,
+	VulkanDynamicResolution& resolution,
+	MiniEngine::Graphics::VulkanParticleSystem& particles,
+	VkDescriptorSet textureSet
 );
 // --- End New Function Declarations ---
 
+// Calls release when it goes out of scope, so main frees what it created on every return path
+template <typename Function>
+struct ScopeExit {
+	Function release;
+
+	explicit ScopeExit(Function function) : release(std::move(function)) {}
+	~ScopeExit() { release(); }
+
+	ScopeExit(const ScopeExit&) = delete;
+	ScopeExit& operator=(const ScopeExit&) = delete;
+};
+
 int main(int argc, char** argv)
 {
-	spdlog::set_level(spdlog::level::debug); // Set log level to debug
+	// The startup timeline is measured from here
+	const MiniEngine::Core::TaskGraph::Clock::time_point launchTime = MiniEngine::Core::TaskGraph::Clock::now();
+
+	// Console output is formatted and written on a worker thread unless --sync-logging is given
+	MiniEngine::Core::LogSettings logSettings;
+	logSettings.async = !hasArgument(argc, argv, "--sync-logging");
+	MiniEngine::Core::InitializeLogging(logSettings);
 	spdlog::info("Vulkan Triangle Application Starting...");
 
-	Window window = { "Vulkan Triangle", 800, 600 };
-	if (!initWindow(window))
+	// What main creates below is released by guards like this one, in reverse order, on every return
+	ScopeExit shutdownLogging([] {
+		spdlog::info("Application terminated");
+		MiniEngine::Core::ShutdownLogging();
+	});
+
+	// A replay draws a captured trace instead of the scene, in a hidden window and as fast as it can.
+	// The replay tool is this application built to do nothing else.
+#if defined(VULKAN_TRIANGLE_REPLAY)
+	const std::string replayPath = argc > 1 && argv[1][0] != '-' ? argv[1] : std::string();
+	if (replayPath.empty())
 	{
-		spdlog::critical("Failed to initialize GLFW window");
-		destroyWindow(window);
+		spdlog::critical("Usage: VulkanTriangleReplay TRACE [--replay-loops N] [--show-replay] [--textures DIR]");
 		return EXIT_FAILURE;
 	}
+#else
+	const std::string replayPath = parseStringArgument(argc, argv, "--replay");
+#endif
+	const bool replaying = !replayPath.empty();
+
+	Window window = { "Vulkan Triangle", 800, 600 };
+	window.visible = !replaying || hasArgument(argc, argv, "--show-replay");
+	window.vsync = !replaying;
 	VulkanRenderer renderer;
-	if (!initVulkanRenderer(renderer, window))
+	renderer.device.instrumentation = parseInstrumentationArgument(argc, argv);
+
+	// Startup steps that do not need each other run side by side on the job system; the window stays
+	// on the main thread, as GLFW requires. --serial-startup runs them one after another for comparison.
+	MiniEngine::Core::JobSystem jobs;
+	MiniEngine::Core::TaskGraph startup(launchTime);
+	using MiniEngine::Core::TaskThread;
+	const std::string pipelineCachePath = parseStringArgument(argc, argv, "--pipeline-cache", "pipeline_cache.bin");
+	vkb::Instance instance;
+	std::unordered_map<std::string, std::vector<char>> shaderCode;
+	std::vector<char> pipelineCacheData;
+	bool windowCreated = false;
+
+	const auto windowTask = startup.Add("Window", [&] {
+		windowCreated = initWindow(window);
+		return windowCreated;
+	}, {}, TaskThread::Main);
+	const auto instanceTask = startup.Add("Vulkan instance", [&] {
+		return createVulkanInstance(instance, renderer.device, window);
+	});
+	startup.Add("Shaders", [&] {
+		// Note: In production, this would be part of your build process
+		system("compile_shaders.bat");
+		return readShaderDirectory(shaderCode, "Resources/Shaders/spirv");
+	});
+	const auto cacheFileTask = startup.Add("Pipeline cache file", [&] {
+		std::error_code error;
+		if (std::filesystem::exists(pipelineCachePath, error)) {
+			pipelineCacheData = readFile(pipelineCachePath);
+		}
+		return true;
+	});
+	const auto deviceTask = startup.Add("Device and swap chain", [&] {
+		return initVulkanRenderer(renderer, instance, window);
+	}, { windowTask, instanceTask });
+	startup.Add("Pipeline cache", [&] {
+		return createPipelineCache(renderer.device, pipelineCacheData);
+	}, { deviceTask, cacheFileTask });
+
+	const bool serialStartup = hasArgument(argc, argv, "--serial-startup");
+	if (!startup.Run(serialStartup ? nullptr : &jobs))
 	{
 		spdlog::critical("Failed to initialize Vulkan renderer");
-		destroyWindow(window);
+		if (renderer.device.logicalDevice != VK_NULL_HANDLE)
+		{
+			destroyVulkanRenderer(renderer);
+		}
+		else
+		{
+			// The device never came up; anything created before it is released with it
+			destroyVulkanDevice(renderer.device);
+		}
+		if (windowCreated)
+		{
+			destroyWindow(window);
+		}
 		return EXIT_FAILURE;
 	}
-
-	// Create a basic render pass
+	ScopeExit releaseWindow([&] { destroyWindow(window); });
+	ScopeExit releaseRenderer([&] { destroyVulkanRenderer(renderer); });
+	renderer.device.shaderCode = std::move(shaderCode);
+	renderer.context = createVulkanContext(renderer);
+	spdlog::info("Startup tasks finished in {:.1f} ms{}", startup.GetElapsedMs(), serialStartup ? " (serial)" : "");
+	const MiniEngine::Core::TaskGraph::Clock::time_point resourcesStart = MiniEngine::Core::TaskGraph::Clock::now();
+
+	// Create a basic render pass, and one continuing its attachments for the second occlusion phase
 	VkRenderPass renderPass = VK_NULL_HANDLE;
-	if (!createRenderPass(renderPass, renderer.device, renderer.swapChain.imageFormat))
+	VkRenderPass loadRenderPass = VK_NULL_HANDLE;
+	ScopeExit releaseRenderPasses([&] {
+		destroyRenderPass(loadRenderPass, renderer.device);
+		destroyRenderPass(renderPass, renderer.device);
+	});
+	if (!createRenderPass(renderPass, renderer.device, renderer.swapChain.imageFormat, renderer.swapChain.depthFormat, true) ||
+		!createRenderPass(loadRenderPass, renderer.device, renderer.swapChain.imageFormat, renderer.swapChain.depthFormat, false))
 	{
 		spdlog::critical("Failed to create render pass");
-		destroyVulkanRenderer(renderer);
-		destroyWindow(window);
 		return EXIT_FAILURE;
 	}
 	spdlog::info("Render pass created successfully");
 
 	// Create framebuffers for the swap chain
+	ScopeExit releaseFramebuffers([&] { destroyFramebuffers(renderer.swapChain, renderer.device); });
 	if (!createFramebuffers(renderer.swapChain, renderer.device, renderPass))
 	{
 		spdlog::critical("Failed to create framebuffers");
-		// Clean up created resources
-		destroyRenderPass(renderPass, renderer.device);
-		destroyVulkanRenderer(renderer);
-		destroyWindow(window);
 		return EXIT_FAILURE;
 	}
 	spdlog::info("Framebuffers created successfully");
+
+	// Create a triangle mesh, drawn once per visible object
+	VulkanMesh triangleMesh;
+	ScopeExit releaseMesh([&] { destroyMesh(triangleMesh, renderer.device); });
+	if (!createTriangleMesh(triangleMesh, renderer)) {
+		return EXIT_FAILURE;
+	}
+
 	// Create a graphics pipeline for our triangle
 	VulkanPipeline pipeline;
 	pipeline.renderPass = renderPass;
-	
-	// Compile shaders if needed
-	// Note: In production, this would be part of your build process
-	system("compile_shaders.bat");
-	
+	pipeline.loadRenderPass = loadRenderPass;
+
+	// Occlusion culling owns the descriptor layout the graphics pipeline reads its objects through.
+	// Each visible object may emit a draw for every meshlet of its level.
+	MiniEngine::Graphics::OcclusionCullingInfo occlusionInfo;
+	occlusionInfo.cullShader = "Resources/Shaders/spirv/OcclusionCull.comp.spv";
+	occlusionInfo.scanShader = "Resources/Shaders/spirv/DrawScan.comp.spv";
+	occlusionInfo.reduceShader = "Resources/Shaders/spirv/HiZReduce.comp.spv";
+	occlusionInfo.meshletBuffer = triangleMesh.meshletBuffer;
+	for (const glm::uvec2& range : triangleMesh.lodMeshlets) {
+		occlusionInfo.drawsPerObject = std::max(occlusionInfo.drawsPerObject, range.y);
+	}
+	occlusionInfo.depthImage = renderer.swapChain.depthImage;
+	occlusionInfo.depthView = renderer.swapChain.depthImageView;
+	occlusionInfo.depthExtent = renderer.swapChain.extent;
+
+	MiniEngine::Graphics::VulkanOcclusionCulling occlusion;
+	occlusion.SetEnabled(!hasArgument(argc, argv, "--no-occlusion"));
+	occlusion.SetMeshletCulling(!hasArgument(argc, argv, "--no-meshlet-culling"));
+	renderer.reuseCommandBuffers = !hasArgument(argc, argv, "--no-command-reuse");
+	if (!occlusion.Initialize(renderer.context, occlusionInfo)) {
+		spdlog::critical("Failed to create occlusion culling");
+		return EXIT_FAILURE;
+	}
+	spdlog::info("Occlusion culling {} (press O to toggle)", occlusion.IsEnabled() ? "enabled" : "disabled");
+
+	// Clustered lighting owns the descriptor layout the lit shader reads its lights through
+	MiniEngine::Graphics::VulkanClusteredLighting lighting;
+	lighting.SetClustered(!hasArgument(argc, argv, "--naive-lighting"));
+	if (!lighting.Initialize(renderer.context, "Resources/Shaders/spirv/LightCull.comp.spv")) {
+		spdlog::critical("Failed to create clustered lighting");
+		return EXIT_FAILURE;
+	}
+
+	// Textures stream in on a loader thread; every object samples the active one
+	MiniEngine::Graphics::TextureSystemInfo textureInfo;
+	textureInfo.mipShader = "Resources/Shaders/spirv/TextureMipgen.comp.spv";
+	textureInfo.textureCompressionBC = renderer.device.textureCompressionBC;
+	MiniEngine::Graphics::VulkanTextureSystem textures;
+	if (!textures.Initialize(renderer.context, textureInfo)) {
+		spdlog::critical("Failed to create texture system");
+		return EXIT_FAILURE;
+	}
+	const std::string textureDirectory = parseStringArgument(argc, argv, "--textures");
+	if (!textureDirectory.empty()) {
+		spdlog::info("{} textures requested from {} (press T to cycle through them)",
+			textures.RequestDirectory(textureDirectory), textureDirectory);
+	}
 	// Create the graphics pipeline with our vertex and fragment shaders
+	ScopeExit releasePipeline([&] { destroyVulkanPipeline(pipeline, renderer.device); });
 	if (!createGraphicsPipeline(
-	    pipeline,
-	    renderer.device,
-	    renderer.swapChain.extent,
-	    renderPass,
-	    "Resources/Shaders/spirv/Triangle.vert.spv",
-	    "Resources/Shaders/spirv/Triangle.frag.spv"
+		pipeline,
+		renderer.device,
+		renderPass,
+		occlusion.GetSceneSetLayout(),
+		lighting.GetSetLayout(),
+		textures.GetSetLayout(),
+		"Resources/Shaders/spirv/Triangle.vert.spv",
+		"Resources/Shaders/spirv/Triangle.frag.spv"
 	)) {
-	    spdlog::critical("Failed to create graphics pipeline");
-	    destroyFramebuffers(renderer.swapChain, renderer.device);
-	    destroyRenderPass(renderPass, renderer.device);
-	    destroyVulkanRenderer(renderer);
-	    destroyWindow(window);
-	    return EXIT_FAILURE;
+		spdlog::critical("Failed to create graphics pipeline");
+		return EXIT_FAILURE;
 	}
 	spdlog::info("Graphics pipeline created successfully");
 
-	// Create a triangle mesh
-	// For this shader, we'll use a hardcoded triangle in the shader itself
-	// (see Triangle.vert), so we just need a dummy mesh with 3 vertices
-	VulkanMesh triangleMesh;
-	std::vector<Vertex> vertices(3);
-	
-	// The actual vertex data will be defined in the shader
-	// We just need to create a buffer with the correct number of vertices
-	if (!createVertexBuffer(triangleMesh, renderer.device, renderer.device.allocator, vertices)) {
-	    spdlog::critical("Failed to create vertex buffer");
-	    destroyVulkanPipeline(pipeline, renderer.device);
-	    destroyFramebuffers(renderer.swapChain, renderer.device);
-	    destroyRenderPass(renderPass, renderer.device);
-	    destroyVulkanRenderer(renderer);
-	    destroyWindow(window);
-	    return EXIT_FAILURE;
-	}
-	spdlog::info("Triangle mesh created successfully with {} vertices", triangleMesh.vertexCount);
+	// GPU particles, simulated on the async compute queue; capacity leaves room for the population to
+	// fluctuate around its target. VulkanSceneBenchmark times a range of populations.
+	MiniEngine::Graphics::VulkanParticleSystem particles;
+	particles.SetTargetCount(parseUintArgument(argc, argv, "--particles", 65536));
+	const uint32_t particleCapacity = particles.GetTargetCount();
+	if (particleCapacity > 0)
+	{
+		MiniEngine::Graphics::ParticleSystemInfo particleInfo;
+		particleInfo.prepareShader = "Resources/Shaders/spirv/ParticlePrepare.comp.spv";
+		particleInfo.emitShader = "Resources/Shaders/spirv/ParticleEmit.comp.spv";
+		particleInfo.simulateShader = "Resources/Shaders/spirv/ParticleSimulate.comp.spv";
+		particleInfo.vertexShader = "Resources/Shaders/spirv/Particle.vert.spv";
+		particleInfo.fragmentShader = "Resources/Shaders/spirv/Particle.frag.spv";
+		particleInfo.renderPass = loadRenderPass;
+		particleInfo.capacity = particleCapacity + particleCapacity / 4;
+		if (!particles.Initialize(renderer.context, particleInfo))
+		{
+			spdlog::critical("Failed to create particle system");
+			return EXIT_FAILURE;
+		}
+	}
+
+	// Dynamic resolution trades render resolution for GPU time once a frame goes over the budget
+	VulkanDynamicResolution resolution;
+	ScopeExit releaseResolution([&] { destroyDynamicResolution(resolution, renderer.device); });
+	resolution.enabled = hasArgument(argc, argv, "--dynamic-resolution");
+	resolution.budgetMs = parseUintArgument(argc, argv, "--gpu-budget", 16);
+	if (!createDynamicResolution(resolution, renderer)) {
+		spdlog::critical("Failed to create dynamic resolution");
+		return EXIT_FAILURE;
+	}
+	spdlog::info("Dynamic resolution {}, GPU budget {:.1f} ms (press R to toggle)",
+		resolution.enabled ? "enabled" : "disabled", resolution.budgetMs);
+
+	// --record-frames DIR writes every presented frame to DIR as PNG, or with --record-format pam as
+	// uncompressed Netpbm images. Capture is optional, so failing to set it up only turns it off.
+	MiniEngine::Graphics::VulkanFrameReadback readback;
+	const std::string recordDirectory = parseStringArgument(argc, argv, "--record-frames");
+	if (!recordDirectory.empty())
+	{
+		MiniEngine::Graphics::FrameReadbackInfo readbackInfo;
+		readbackInfo.directory = recordDirectory;
+		readbackInfo.fileFormat = parseStringArgument(argc, argv, "--record-format") == "pam"
+			? MiniEngine::Graphics::ImageFileFormat::Pam : MiniEngine::Graphics::ImageFileFormat::Png;
+		readbackInfo.imageFormat = renderer.swapChain.imageFormat;
+		readbackInfo.extent = renderer.swapChain.extent;
+		readbackInfo.slotCount = parseUintArgument(argc, argv, "--readback-slots", 4);
+		if (readback.Initialize(renderer.context, readbackInfo))
+		{
+			readback.SetEnabled(true);
+			spdlog::info("Recording frames to {} as {}, {} readback buffers", recordDirectory,
+				MiniEngine::Graphics::ToString(readbackInfo.fileFormat), readback.GetSlotCount());
+		}
+	}
+
+	// Build the scene: a grid of triangles, some of them spinning
+	SceneState scene;
+	createScene(scene, parseUintArgument(argc, argv, "--objects", 4096));
+	scene.meshLods = triangleMesh.lods;
+	scene.lodEnabled = !hasArgument(argc, argv, "--no-lod");
+	spdlog::info("Scene created with {} objects, culling on {} threads", scene.culling.GetObjectCount(), jobs.GetConcurrency());
+
+	// VulkanSceneBenchmark compares clustered and naive shading at larger light counts
+	createLights(scene, parseUintArgument(argc, argv, "--lights", 1024));
+	spdlog::info("{} lights, {} (press L to toggle)", scene.lights.size(), lighting.IsClustered() ? "clustered" : "naive");
+
+	// Over budget, per-frame buffers that grew for a peak give back what their last frame did not need
+	renderer.device.memory.AddEvictionHook("Occlusion culling buffers", [&](uint32_t frameIndex, VkDeviceSize) {
+		const VkDeviceSize released = occlusion.Trim(frameIndex);
+		if (released > 0)
+		{
+			invalidateRecordedCommands(renderer);
+		}
+		return released;
+	});
+	renderer.device.memory.AddEvictionHook("Light buffers", [&](uint32_t frameIndex, VkDeviceSize) {
+		const VkDeviceSize released = lighting.Trim(frameIndex);
+		if (released > 0)
+		{
+			invalidateRecordedCommands(renderer);
+		}
+		return released;
+	});
+
+	// The memory report is rewritten with every stats line when a path is given
+	const std::string memoryStatsPath = parseStringArgument(argc, argv, "--memory-stats");
+	bool memoryOverlay = false;
+	double memoryOverlayTime = 0.0;
+	spdlog::info("Memory telemetry{} (press M for the overlay, D to defragment)",
+		memoryStatsPath.empty() ? "" : fmt::format(" written to {}", memoryStatsPath));
+
+	// The texture benchmark times the whole directory from the first request until the last texture is resident
+	const bool textureBenchmark = hasArgument(argc, argv, "--texture-benchmark");
+	if (textureBenchmark && textures.GetStats().requested == 0) {
+		spdlog::warn("Texture benchmark needs --textures DIR with .ktx2 or .dds files");
+	}
 
 	spdlog::info("Application initialization complete");
 
-	while (!glfwWindowShouldClose(window.handle))
+	// The main thread polls input and simulates, then hands each frame to a render thread in a packet to
+	// record, submit and present. --frame-packets sets how many packets are in flight (the main thread
+	// runs up to one frame fewer ahead); --serial-rendering does both on the main thread, one after the other.
+	const bool serialRendering = hasArgument(argc, argv, "--serial-rendering");
+	const uint32_t packetCount = serialRendering ? 1 : std::clamp(parseUintArgument(argc, argv, "--frame-packets", 2), 2u, 3u);
+	const std::string renderingMode = serialRendering ? std::string("serial") : fmt::format("render thread, {} packets", packetCount);
+	MiniEngine::Core::FramePipeline framePipeline(packetCount);
+	std::vector<FramePacket> packets(packetCount);
+	spdlog::info("Rendering: {}", renderingMode);
+
+	// The pipeline benchmark measures frame rate and each thread's times in this run's mode; run it with and
+	// without --serial-rendering to compare
+	const bool pipelineBenchmark = hasArgument(argc, argv, "--pipeline-benchmark");
+
+	// --on-demand only renders for input, a resize or work the render thread still has to finish, and
+	// while the scene animates (A pauses and resumes it; it starts paused). The idle benchmark leaves the
+	// scene paused, redraws a corner twice a second, and reports the CPU used while waiting and how long
+	// each redraw took from waking up to being queued for presentation.
+	const bool idleBenchmark = hasArgument(argc, argv, "--idle-benchmark");
+	const bool onDemand = !replaying && (idleBenchmark || hasArgument(argc, argv, "--on-demand"));
+	MiniEngine::Graphics::RedrawScheduler redraw(onDemand ? MiniEngine::Graphics::RedrawMode::OnDemand : MiniEngine::Graphics::RedrawMode::Continuous);
+	redraw.Attach(window.handle);
+	bool animating = !onDemand;
+	uint32_t sceneAnimation = animating ? redraw.AddAnimation({}, 0.0) : 0;
+	if (idleBenchmark)
+	{
+		redraw.AddAnimation({ 0, 0, 64, 64 }, 0.5);
+	}
+	spdlog::info("Redrawing {} (press A to {} the scene)", MiniEngine::Graphics::ToString(redraw.GetMode()), animating ? "pause" : "animate");
+
+	// The scene simulates in fixed steps and is drawn between the last two, so its cost per second
+	// stays the same whatever the frame rate
+	MiniEngine::Core::FrameClock frameClock(1.0 / std::max(parseUintArgument(argc, argv, "--simulation-rate", 60), 1u));
+	frameClock.SetPaused(!animating);
+	MiniEngine::Core::FrameClockStats frameClockStats;
+	spdlog::info("Simulating at {:.0f} Hz", 1.0 / frameClock.GetStepSeconds());
+
+	double startTime = glfwGetTime();
+	double frameClockStatsTime = startTime;
+	double sceneTime = 0.0; // Only advances while the scene animates
+	bool animationKeyDown = false;
+	bool memoryOverlayKeyDown = false;
+	bool lodKeyDown = false;
+	RenderInputKeys renderInputKeys;
+
+	// Shared between the threads
+	std::mutex overlayMutex;
+	std::string overlayTitle; // Set by the render thread, shown by the main thread
+	std::atomic<double> simulateMsTotal = 0.0;
+
+	// Render thread state
+	double statsTime = startTime;
+	FrameTimings statsTimings;
+	double renderMsTotal = 0.0;
+	PipelineBenchmark pipelineBenchmarkState{ { 0, startTime } };
+
+	// Main thread state
+	IdleBenchmark idleBenchmarkState{ { 0, startTime } };
+
+	// --capture PATH records every frame the render thread draws; the render thread owns the writer
+	MiniEngine::Graphics::FrameTraceWriter capture;
+	const std::string capturePath = parseStringArgument(argc, argv, "--capture");
+	if (!capturePath.empty() && capture.Open(capturePath, TraceRecordSizes))
+	{
+		spdlog::info("Capturing frames to {}", capturePath);
+	}
+
+	// Replays keep the captured resolution, so dynamic resolution stays out of it
+	MiniEngine::Graphics::FrameTraceReader replayTrace;
+	const uint32_t replayLoops = std::max(parseUintArgument(argc, argv, "--replay-loops", 1), 1u);
+	uint32_t replayedLoops = 0;
+	uint64_t replayedFrames = 0;
+	double replayStart = startTime;
+	if (replaying)
 	{
-		glfwPollEvents();
-				// Draw a frame with our triangle
-		if (!drawFrame(renderer, pipeline, triangleMesh))
+		if (replayTrace.Open(replayPath, TraceRecordSizes))
+		{
+			// An unfinished trace has no frame count and is read to the end of the file
+			const uint64_t frameCount = replayTrace.GetFrameCount();
+			spdlog::info("Replaying {} frames from {}, {} times", frameCount > 0 ? std::to_string(frameCount) : "all", replayPath, replayLoops);
+		}
+		else
+		{
+			redraw.RequestQuit();
+		}
+		resolution.enabled = false;
+	}
+
+	auto currentTimings = [&]() {
+		const MiniEngine::Core::FramePipelineStats pipelineStats = framePipeline.GetStats();
+		FrameTimings timings;
+		timings.frames = pipelineStats.packets;
+		timings.simulateMs = simulateMsTotal;
+		timings.mainWaitMs = pipelineStats.producerWaitMs;
+		timings.renderMs = renderMsTotal;
+		timings.renderWaitMs = pipelineStats.consumerWaitMs;
+		return timings;
+	};
+
+	// The first present closes the startup timeline, which the render thread then logs and writes out
+	const std::string startupTracePath = parseStringArgument(argc, argv, "--startup-trace");
+	bool firstFramePresented = false;
+
+	// Everything the loop used to do after simulating, now driven by the packet alone
+	auto renderFrame = [&](const FramePacket& packet) {
+		const auto renderStart = std::chrono::steady_clock::now();
+		const double now = packet.now;
+		const float deltaTime = packet.deltaTime;
+		const DrawList& drawList = packet.drawList;
+
+		applyRenderInput(packet, renderer, occlusion, lighting, resolution, textures);
+
+		if (particles.GetCapacity() > 0)
+		{
+			particles.Update(drawList.view, deltaTime);
+		}
+
+		// Copies what the loader has read since the last frame; textures appear once their copies finish
+		if (!textures.Update())
+		{
+			MINIENGINE_LOG_WARN_RATE_LIMITED(1000, "Failed to submit texture uploads");
+		}
+
+		if (textureBenchmark)
+		{
+			updateTextureBenchmark(textures, now - startTime, redraw);
+		}
+
+		if (now - statsTime >= 2.0)
+		{
+			logRenderStats(packet, renderer, triangleMesh, occlusion, lighting, resolution, particles, readback, textures);
+
+			MiniEngine::Graphics::VulkanMemory& memory = renderer.device.memory;
+			memory.DefragmentIfWasteful();
+			if (!memoryStatsPath.empty())
+			{
+				memory.WriteStats(memoryStatsPath);
+			}
+
+			const FrameTimings timings = currentTimings();
+			spdlog::info("Frame pipeline: {} ({})", formatFrameTimings(timings, statsTimings, now - statsTime), renderingMode);
+			statsTimings = timings;
+
+			if (onDemand)
+			{
+				const MiniEngine::Graphics::RedrawStats redrawStats = redraw.GetStats();
+				spdlog::info("Redraw: {} frames after {} wakeups, idle {:.1f} s at {:.2f}% CPU, wake to present {:.3f} ms on average, {:.3f} ms at most",
+					redrawStats.frames, redrawStats.wakeups, redrawStats.idleSeconds,
+					redrawStats.idleSeconds > 0.0 ? 100.0 * redrawStats.idleCpuSeconds / redrawStats.idleSeconds : 0.0,
+					redrawStats.presents > 0 ? redrawStats.wakeToPresentMs / redrawStats.presents : 0.0, redrawStats.maxWakeToPresentMs);
+			}
+			statsTime = now;
+		}
+
+		if (pipelineBenchmark)
+		{
+			updatePipelineBenchmark(pipelineBenchmarkState, now, currentTimings(), renderingMode, redraw);
+		}
+
+		// The window belongs to the main thread, which shows the overlay on its next frame
+		if (packet.memoryOverlay && now - memoryOverlayTime >= 0.5)
+		{
+			std::lock_guard lock(overlayMutex);
+			overlayTitle = fmt::format("{} - {}", window.title, renderer.device.memory.FormatOverlay());
+			memoryOverlayTime = now;
+		}
+
+		// Between frames, so the pass can wait for the device without a frame half submitted
+		uint32_t buffersMoved = 0;
+		renderer.device.memory.Defragment([&](const std::function<void(VkCommandBuffer)>& record) { return executeImmediateCommands(renderer, record); },
+			buffersMoved);
+		if (buffersMoved > 0)
+		{
+			invalidateRecordedCommands(renderer);
+		}
+
+		if (capture.IsOpen() && !captureFrame(capture, drawList, currentTraceState(deltaTime, renderer, occlusion, lighting, resolution, textures)))
+		{
+			capture.Close();
+		}
+
+		// Draw a frame with the visible triangles
+		if (drawFrame(renderer, pipeline, triangleMesh, occlusion, lighting, resolution, particles, readback,
+			textures.GetActiveTexture().descriptorSet, drawList))
+		{
+			redraw.NotifyPresented(packet.redraw);
+			if (!firstFramePresented)
+			{
+				firstFramePresented = true;
+				startup.Record("First frame", renderStart, std::chrono::steady_clock::now());
+				logStartupTimeline(startup, startupTracePath);
+			}
+		}
+		else
 		{
 			// Handle swap chain recreation or other errors
-			spdlog::warn("Failed to draw frame");
+			MINIENGINE_LOG_WARN_RATE_LIMITED(1000, "Failed to draw frame");
+		}
+
+		// On demand, work still in flight asks for the frames it needs to finish
+		const MiniEngine::Graphics::TextureStats& textureStats = textures.GetStats();
+		if (onDemand && (textureStats.loaded + textureStats.failed < textureStats.requested ||
+			renderer.device.memory.IsDefragmenting()))
+		{
+			redraw.Invalidate();
+		}
+
+		renderMsTotal += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - renderStart).count();
+	};
+
+	// Hands the packet to the render thread, or renders it right away when serial
+	auto publishPacket = [&]() {
+		framePipeline.EndWrite();
+		if (serialRendering)
+		{
+			uint32_t slot = 0;
+			framePipeline.BeginRead(slot);
+			renderFrame(packets[slot]);
+			framePipeline.EndRead();
+		}
+	};
+
+	startup.Record("Renderer resources", resourcesStart, std::chrono::steady_clock::now());
+
+	std::thread renderThread;
+	if (!serialRendering)
+	{
+		renderThread = std::thread([&] {
+			uint32_t slot = 0;
+			while (framePipeline.BeginRead(slot))
+			{
+				renderFrame(packets[slot]);
+				framePipeline.EndRead();
+			}
+		});
+	}
+
+	while (!glfwWindowShouldClose(window.handle))
+	{
+		// Only this thread may close the window; the render thread and the benchmarks ask the scheduler
+		// to quit, which also wakes a wait for events
+		if (redraw.IsQuitRequested())
+		{
+			glfwSetWindowShouldClose(window.handle, GLFW_TRUE);
+			break;
+		}
+
+		// Waiting for a free packet comes first, so the input below is as fresh as it can be when rendered
+		uint32_t slot = 0;
+		if (!framePipeline.BeginWrite(slot))
+		{
+			break;
+		}
+
+		// On demand this sleeps until there is a reason to draw. The slot stays ours meanwhile, and
+		// when the wait ends without a frame the next BeginWrite hands it back.
+		MiniEngine::Graphics::Redraw frameRedraw;
+		const bool drawRequested = redraw.WaitForRedraw(frameRedraw);
+
+		if (idleBenchmark)
+		{
+			updateIdleBenchmark(idleBenchmarkState, glfwGetTime(), redraw);
+		}
+		if (!drawRequested)
+		{
+			continue;
+		}
+
+		const auto simulateStart = std::chrono::steady_clock::now();
+		FramePacket& packet = packets[slot];
+		packet.input = RenderInput();
+		packet.redraw = frameRedraw;
+
+		// Replayed frames take the place of the simulation; the trace is read as fast as frames are presented
+		packet.replayed = replaying;
+		if (replaying)
+		{
+			bool read = readReplayFrame(replayTrace, packet.drawList, packet.replayState);
+			if (!read && replayedLoops + 1 < replayLoops && replayTrace.Rewind())
+			{
+				++replayedLoops;
+				read = readReplayFrame(replayTrace, packet.drawList, packet.replayState);
+			}
+			if (!read)
+			{
+				redraw.RequestQuit();
+				continue;
+			}
+			if (replayedFrames++ == 0)
+			{
+				replayStart = glfwGetTime();
+			}
+
+			packet.now = glfwGetTime();
+			packet.deltaTime = packet.replayState.deltaTime;
+			packet.memoryOverlay = false;
+			packet.culling = {};
+			packet.drawQueue = {};
+			packet.lod = {};
+			packet.clock = {};
+			packet.simulateMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - simulateStart).count();
+			simulateMsTotal.fetch_add(packet.simulateMs);
+			publishPacket();
+			continue;
+		}
+
+		// A pauses and resumes the scene; on demand, a paused scene only redraws when something else asks
+		if (wasKeyPressed(window.handle, GLFW_KEY_A, animationKeyDown))
+		{
+			animating = !animating;
+			frameClock.SetPaused(!animating);
+			if (animating)
+			{
+				sceneAnimation = redraw.AddAnimation({}, 0.0);
+			}
+			else
+			{
+				redraw.RemoveAnimation(sceneAnimation);
+			}
+			spdlog::info("Scene {}", animating ? "animating" : "paused");
+		}
+
+		// O, K, C, L, R, D and T are acted on by the render thread
+		pollRenderInput(window.handle, renderInputKeys, packet.input);
+
+		// M shows memory usage in the window title; there is no text rendering to draw it with
+		if (wasKeyPressed(window.handle, GLFW_KEY_M, memoryOverlayKeyDown))
+		{
+			memoryOverlay = !memoryOverlay;
+			if (!memoryOverlay)
+			{
+				std::lock_guard lock(overlayMutex);
+				overlayTitle.clear();
+				glfwSetWindowTitle(window.handle, window.title.c_str());
+			}
+		}
+
+		// G switches mesh levels of detail, to compare the triangle count with every object at full detail
+		if (wasKeyPressed(window.handle, GLFW_KEY_G, lodKeyDown))
+		{
+			scene.lodEnabled = !scene.lodEnabled;
+			spdlog::info("Mesh levels of detail {}", scene.lodEnabled ? "enabled" : "disabled");
+		}
+
+		if (memoryOverlay)
+		{
+			std::lock_guard lock(overlayMutex);
+			if (!overlayTitle.empty())
+			{
+				glfwSetWindowTitle(window.handle, overlayTitle.c_str());
+				overlayTitle.clear();
+			}
+		}
+
+		// Sleeping on demand with the scene paused is neither a frame nor simulation time
+		if (frameRedraw.idle)
+		{
+			frameClock.Resync();
+		}
+
+		double now = glfwGetTime();
+		const uint32_t steps = frameClock.Tick();
+		const double step = frameClock.GetStepSeconds();
+		for (uint32_t i = 0; i < steps; ++i)
+		{
+			sceneTime += step;
+			updateScene(scene, static_cast<float>(sceneTime), static_cast<float>(step));
 		}
+		const float alpha = frameClock.GetAlpha();
+		interpolateScene(scene, alpha);
+		const float renderTime = static_cast<float>(sceneTime - (1.0 - alpha) * step);
+		const float deltaTime = animating ? static_cast<float>(frameClock.GetFrameSeconds()) : 0.0f;
+
+		// The percentile takes a sort, so the frame time stats are refreshed once a second
+		if (now - frameClockStatsTime >= 1.0)
+		{
+			frameClockStats = frameClock.GetStats();
+			frameClockStatsTime = now;
+		}
+
+		// The swap chain belongs to the render thread; it follows the framebuffer size, so the camera does too
+		int framebufferWidth = 0;
+		int framebufferHeight = 0;
+		glfwGetFramebufferSize(window.handle, &framebufferWidth, &framebufferHeight);
+		const VkExtent2D extent = { static_cast<uint32_t>(framebufferWidth), static_cast<uint32_t>(framebufferHeight) };
+		buildDrawList(packet.drawList, scene, extent, renderTime, jobs);
+
+		packet.now = now;
+		packet.deltaTime = deltaTime;
+		packet.clock = frameClockStats;
+		packet.memoryOverlay = memoryOverlay;
+		packet.culling = scene.culling.GetStats();
+		packet.drawQueue = scene.drawQueue.GetStats();
+		packet.lod = scene.lodStats;
+		packet.simulateMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - simulateStart).count();
+		simulateMsTotal.fetch_add(packet.simulateMs); // Only this thread adds to it
+		publishPacket();
+	}
+
+	// The render thread finishes the packets it was handed, then stops
+	framePipeline.Close();
+	if (renderThread.joinable())
+	{
+		renderThread.join();
+	}
+	redraw.Attach(nullptr);
+
+	if (capture.IsOpen())
+	{
+		const MiniEngine::Graphics::FrameTraceStats& traceStats = capture.GetStats();
+		capture.Close();
+		spdlog::info("Captured {} frames to {}: {:.1f} MiB, {:.1f} MiB before unchanged records were left out",
+			traceStats.frames, capturePath, traceStats.encodedBytes / (1024.0 * 1024.0), traceStats.rawBytes / (1024.0 * 1024.0));
 	}
+
 	// Wait for the device to finish all operations before cleanup
 	vkDeviceWaitIdle(renderer.device.logicalDevice);
-	
-	spdlog::info("Attempting to terminate gracefully");
-	// Clean up resources in reverse order of creation
-	destroyMesh(triangleMesh, renderer.device, renderer.device.allocator);
-	destroyVulkanPipeline(pipeline, renderer.device);
-	destroyFramebuffers(renderer.swapChain, renderer.device);
-	destroyRenderPass(renderPass, renderer.device);
-	destroyVulkanRenderer(renderer);
-	destroyWindow(window);
-	spdlog::info("Application terminated");
 
+	// The render thread is done, so its numbers can be read here
+	if (replayedFrames > 0)
+	{
+		const double replaySeconds = glfwGetTime() - replayStart;
+		spdlog::info("Replay: {} frames in {:.2f} s, {:.1f} fps; render thread {:.3f} ms per frame, record and submit {:.3f} ms, GPU frame {:.3f} ms{}",
+			replayedFrames, replaySeconds, replayedFrames / replaySeconds, renderMsTotal / replayedFrames,
+			renderer.recordingStats.cpuMs[renderer.reuseCommandBuffers ? 1 : 0], occlusion.GetStats().gpuFrameMs[occlusion.IsEnabled() ? 1 : 0],
+			occlusion.GetTimestampPeriod() > 0.0f ? "" : " (no timestamps)");
+	}
+
+	// Pipelines created this run make the next startup cheaper
+	savePipelineCache(renderer.device, pipelineCachePath);
+
+	// Resources are released by their guards in reverse order of creation
+	spdlog::info("Attempting to terminate gracefully");
 	return EXIT_SUCCESS;
 }
 
@@ -292,6 +1311,7 @@ bool initWindow(Window& window)
 
 	glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API); // No OpenGL context
 	glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);   // Allow resizing
+	glfwWindowHint(GLFW_VISIBLE, window.visible ? GLFW_TRUE : GLFW_FALSE);
 
 	window.handle = glfwCreateWindow(window.width, window.height, window.title.c_str(), nullptr, nullptr);
 
@@ -323,12 +1343,12 @@ void destroyWindow(Window& window)
 
 
 // -----------------------------------------------------------------------------
-// Vulkan 
+// Vulkan
 // -----------------------------------------------------------------------------
-bool initVulkanRenderer(VulkanRenderer& renderer, const Window& window)
+bool initVulkanRenderer(VulkanRenderer& renderer, const vkb::Instance& instance, const Window& window)
 {
 	// Initialize the device directly within the renderer
-	if (!createVulkanDevice(renderer.device, window))
+	if (!createVulkanDevice(renderer.device, instance, window))
 	{
 		spdlog::error("Failed to create Vulkan device");
 		return false;
@@ -339,12 +1359,30 @@ bool initVulkanRenderer(VulkanRenderer& renderer, const Window& window)
 	if (!createSwapChain(renderer.swapChain, renderer.device, window))
 	{
 		spdlog::error("Failed to create Vulkan swap chain");
-		// No need to explicitly call destroyVulkanDevice here, 
+		// No need to explicitly call destroyVulkanDevice here,
 		// as the caller of initVulkanRenderer will handle it if this function returns false.
 		return false;
 	}
 	spdlog::info("Vulkan swap chain created successfully");
 
+	// Create the depth buffer, also the source of the Hi-Z pyramid
+	if (!createDepthResources(renderer.swapChain, renderer.device))
+	{
+		spdlog::error("Failed to create depth resources");
+		destroySwapChain(renderer.swapChain, renderer.device);
+		return false;
+	}
+	spdlog::info("Depth resources created successfully");
+
+	// Create the scene color target the frame renders into before it is scaled to the swap chain
+	if (!createSceneColorResources(renderer.swapChain, renderer.device))
+	{
+		spdlog::error("Failed to create scene color resources");
+		destroySwapChain(renderer.swapChain, renderer.device);
+		return false;
+	}
+	spdlog::info("Scene color resources created successfully");
+
 	// Create Synchronization objects
 	if (!createSynchronization(renderer.synchronization, renderer.device, renderer.swapChain))
 	{
@@ -353,7 +1391,7 @@ bool initVulkanRenderer(VulkanRenderer& renderer, const Window& window)
 		return false;
 	}
 	spdlog::info("Vulkan synchronization objects created successfully");
-	
+
 	// Create Command Pool
 	if (!createCommandPool(renderer))
 	{
@@ -374,20 +1412,47 @@ bool initVulkanRenderer(VulkanRenderer& renderer, const Window& window)
 		return false;
 	}
 	spdlog::info("Command buffers allocated successfully");
-	
+
+	// Create the compute and transfer queue command pools
+	if (!renderer.device.queues.Initialize(renderer.device.logicalDevice, renderer.synchronization.maxFramesInFlight, renderer.device.debugUtils))
+	{
+		spdlog::error("Failed to create async compute resources");
+		renderer.device.queues.Destroy();
+		destroySynchronization(renderer.synchronization, renderer.device);
+		destroySwapChain(renderer.swapChain, renderer.device);
+		return false;
+	}
+	spdlog::info("Async compute resources created successfully");
+
 	return true;
 }
 
-bool createVulkanDevice(VulkanDevice& device, const Window& window)
+bool createVulkanInstance(vkb::Instance& instance, VulkanDevice& device, const Window& window)
 {
 	// Create Vulkan instance using VkBootstrap
+	// Validation checks every API call, so it is only loaded at the levels that ask for it. Labels
+	// need the debug utils extension alone, which costs nothing until something is named or labelled.
+	using MiniEngine::Graphics::InstrumentationLevel;
 	vkb::InstanceBuilder instanceBuilder;
-	auto instanceResult = instanceBuilder.set_app_name(window.title.c_str())
+	instanceBuilder.set_app_name(window.title.c_str())
 		.set_engine_name("MiniEngine")
-		.request_validation_layers(true)
-		.use_default_debug_messenger()
-		.require_api_version(1, 2, 0)
-		.build();
+		.require_api_version(1, 2, 0);
+	if (device.instrumentation >= InstrumentationLevel::Labels)
+	{
+		instanceBuilder.enable_extension(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+	}
+	if (device.instrumentation >= InstrumentationLevel::Validation)
+	{
+		instanceBuilder.request_validation_layers(true)
+			.use_default_debug_messenger();
+	}
+	if (device.instrumentation >= InstrumentationLevel::FullValidation)
+	{
+		instanceBuilder.add_validation_feature_enable(VK_VALIDATION_FEATURE_ENABLE_SYNCHRONIZATION_VALIDATION_EXT)
+			.add_validation_feature_enable(VK_VALIDATION_FEATURE_ENABLE_GPU_ASSISTED_EXT)
+			.add_validation_feature_enable(VK_VALIDATION_FEATURE_ENABLE_GPU_ASSISTED_RESERVE_BINDING_SLOT_EXT);
+	}
+	auto instanceResult = instanceBuilder.build();
 
 	if (!instanceResult)
 	{
@@ -395,13 +1460,17 @@ bool createVulkanDevice(VulkanDevice& device, const Window& window)
 		return false;
 	}
 
-	vkb::Instance vkbInstance = instanceResult.value();
-	device.instance = vkbInstance.instance;
-	device.debugMessenger = vkbInstance.debug_messenger;
+	instance = instanceResult.value();
+	device.instance = instance.instance;
+	device.debugMessenger = instance.debug_messenger;
 
-	spdlog::debug("Vulkan instance created successfully");
+	spdlog::info("Vulkan instance created with {} instrumentation", MiniEngine::Graphics::ToString(device.instrumentation));
+	return true;
+}
 
-	// Create surface using GLFW
+bool createVulkanDevice(VulkanDevice& device, const vkb::Instance& instance, const Window& window)
+{
+	// Create surface using GLFW; unlike the window itself, this may happen on any thread
 	if (glfwCreateWindowSurface(device.instance, window.handle, nullptr, &device.surface) != VK_SUCCESS)
 	{
 		spdlog::critical("Failed to create Vulkan surface");
@@ -411,8 +1480,19 @@ bool createVulkanDevice(VulkanDevice& device, const Window& window)
 	spdlog::debug("Vulkan surface created successfully");
 
 	// Select physical device
-	vkb::PhysicalDeviceSelector deviceSelector{ vkbInstance, device.surface };
+	// Occlusion culling draws through indirect commands whose firstInstance selects the object, as
+	// many as the culling shader counted
+	VkPhysicalDeviceFeatures requiredFeatures{};
+	requiredFeatures.multiDrawIndirect = VK_TRUE;
+	requiredFeatures.drawIndirectFirstInstance = VK_TRUE;
+	VkPhysicalDeviceVulkan12Features requiredFeatures12{};
+	requiredFeatures12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+	requiredFeatures12.drawIndirectCount = VK_TRUE;
+
+	vkb::PhysicalDeviceSelector deviceSelector{ instance, device.surface };
 	auto physicalDeviceResult = deviceSelector.set_minimum_version(1, 2)
+		.set_required_features(requiredFeatures)
+		.set_required_features_12(requiredFeatures12)
 		.select();
 
 	if (!physicalDeviceResult)
@@ -425,6 +1505,14 @@ bool createVulkanDevice(VulkanDevice& device, const Window& window)
 	device.physicalDevice = vkbPhysicalDevice.physical_device;
 	spdlog::info("Physical device selected: {}", vkbPhysicalDevice.name);
 
+	// BC textures where the device has them; loading refuses them otherwise
+	VkPhysicalDeviceFeatures textureFeatures{};
+	textureFeatures.textureCompressionBC = VK_TRUE;
+	device.textureCompressionBC = vkbPhysicalDevice.enable_features_if_present(textureFeatures);
+
+	// Real heap budgets and usage from the driver; without it VMA estimates them from its own allocations
+	const bool memoryBudget = vkbPhysicalDevice.enable_extension_if_present(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+
 	// Create logical device
 	vkb::DeviceBuilder deviceBuilder{ vkbPhysicalDevice };
 	auto logicalDeviceResult = deviceBuilder.build();
@@ -437,6 +1525,7 @@ bool createVulkanDevice(VulkanDevice& device, const Window& window)
 
 	vkb::Device vkbDevice = logicalDeviceResult.value();
 	device.logicalDevice = vkbDevice.device;
+	device.debugUtils.Load(device.instance, device.logicalDevice, device.instrumentation);
 
 	spdlog::debug("Logical device created successfully");
 
@@ -446,6 +1535,8 @@ bool createVulkanDevice(VulkanDevice& device, const Window& window)
 	device.presentQueueFamilyIndex = static_cast<uint32_t>(vkbDevice.get_queue_index(vkb::QueueType::present).value());
 	device.presentQueue = vkbDevice.get_queue(vkb::QueueType::present).value();
 
+	device.queues.Select(vkbDevice);
+
 	spdlog::debug("Graphics queue family index: {}, Present queue family index: {}",
 		device.graphicsQueueFamilyIndex, device.presentQueueFamilyIndex);
 	// Create VMA allocator
@@ -455,192 +1546,260 @@ bool createVulkanDevice(VulkanDevice& device, const Window& window)
 	allocatorInfo.device = device.logicalDevice;
 	allocatorInfo.instance = device.instance;
 	// Remove VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT flag since bufferDeviceAddress feature is not enabled
+	return device.memory.Initialize(allocatorInfo, memoryBudget);
+}
 
-	if (vmaCreateAllocator(&allocatorInfo, &device.allocator) != VK_SUCCESS)
+bool createPipelineCache(VulkanDevice& device, const std::vector<char>& data)
+{
+	// A cache from another driver or device is rejected by the header check; start empty then
+	VkPipelineCacheCreateInfo cacheInfo{};
+	cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	cacheInfo.initialDataSize = data.size();
+	cacheInfo.pInitialData = data.empty() ? nullptr : data.data();
+	if (vkCreatePipelineCache(device.logicalDevice, &cacheInfo, nullptr, &device.pipelineCache) == VK_SUCCESS)
 	{
-		spdlog::critical("Failed to create VMA allocator");
-		return false;
+		spdlog::info("Pipeline cache created from {} bytes", data.size());
+		return true;
 	}
 
+	cacheInfo.initialDataSize = 0;
+	cacheInfo.pInitialData = nullptr;
+	if (vkCreatePipelineCache(device.logicalDevice, &cacheInfo, nullptr, &device.pipelineCache) != VK_SUCCESS)
+	{
+		spdlog::error("Failed to create pipeline cache");
+		device.pipelineCache = VK_NULL_HANDLE;
+		return false;
+	}
+	spdlog::warn("Saved pipeline cache rejected, starting with an empty one");
 	return true;
 }
 
-bool createSwapChain(VulkanSwapChain& swapChain, VulkanDevice& device, const Window& window)
+bool savePipelineCache(VulkanDevice& device, const std::string& path)
 {
-    // Corrected SwapchainBuilder instantiation
-    vkb::SwapchainBuilder swapchainBuilder(device.physicalDevice, 
-                                           device.logicalDevice, 
-                                           device.surface, 
-                                           device.graphicsQueueFamilyIndex, 
-                                           device.presentQueueFamilyIndex);
-
-    auto swapchainResult = swapchainBuilder
-        .use_default_format_selection()
-        .set_desired_present_mode(VK_PRESENT_MODE_FIFO_KHR) // FIFO is a good default and widely supported
-        .set_desired_extent(window.width, window.height)
-        //.set_desired_min_image_count(3) // Optional: request triple buffering
-        .build();
-
-    if (!swapchainResult)
-    {
-        spdlog::critical("Failed to create swap chain: {}", swapchainResult.error().message());
-        return false;
-    }
-
-    auto vkbSwapchain = swapchainResult.value();
-    swapChain.handle = vkbSwapchain.swapchain; // Corrected member name
-
-    auto imagesResult = vkbSwapchain.get_images();
-    if (!imagesResult) {
-        spdlog::critical("Failed to get swap chain images: {}", imagesResult.error().message());
-        // vkb::destroy_swapchain is not directly available, cleanup is handled by vkDestroySwapchainKHR
-        // in destroySwapChain if this function returns false and initVulkanRenderer handles device cleanup.
-        // If vkbSwapchain.swapchain was successfully created, it will be cleaned up by destroySwapChain.
-        return false;
-    }
-    swapChain.images = imagesResult.value();
-    swapChain.imageFormat = vkbSwapchain.image_format;
-    swapChain.extent = vkbSwapchain.extent;
-
-    // Create image views
-    swapChain.imageViews.resize(swapChain.images.size());
-    for (size_t i = 0; i < swapChain.images.size(); ++i)
-    {
-        VkImageViewCreateInfo viewInfo{};
-        viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-        viewInfo.image = swapChain.images[i];
-        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-        viewInfo.format = swapChain.imageFormat;
-        viewInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
-        viewInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
-        viewInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
-        viewInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
-        viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        viewInfo.subresourceRange.baseMipLevel = 0;
-        viewInfo.subresourceRange.levelCount = 1;
-        viewInfo.subresourceRange.baseArrayLayer = 0;
-        viewInfo.subresourceRange.layerCount = 1;
-
-        if (vkCreateImageView(device.logicalDevice, &viewInfo, nullptr, &swapChain.imageViews[i]) != VK_SUCCESS)
-        {
-            spdlog::critical("Failed to create image views for swap chain");
-            // Cleanup already created image views before returning
-            for (size_t j = 0; j < i; ++j) {
-                vkDestroyImageView(device.logicalDevice, swapChain.imageViews[j], nullptr);
-            }
-            swapChain.imageViews.clear();
-            // The swapchain itself (vkbSwapchain.swapchain) will be cleaned up by destroySwapChain
-            // if this function returns false and initVulkanRenderer handles device cleanup.
-            return false;
-        }
-    }
-    spdlog::info("Swap chain created successfully with {} images.", swapChain.images.size());
-    return true;
-}
+	size_t size = 0;
+	if (device.pipelineCache == VK_NULL_HANDLE ||
+		vkGetPipelineCacheData(device.logicalDevice, device.pipelineCache, &size, nullptr) != VK_SUCCESS)
+	{
+		return false;
+	}
+	std::vector<char> data(size);
+	if (vkGetPipelineCacheData(device.logicalDevice, device.pipelineCache, &size, data.data()) != VK_SUCCESS)
+	{
+		return false;
+	}
 
-bool createSynchronization(VulkanSynchronization& sync, VulkanDevice& device, const VulkanSwapChain& swapChain)
-{
-    // Create semaphores per swap chain image (not per frame in flight)
-    uint32_t imageCount = static_cast<uint32_t>(swapChain.images.size());
-    sync.imageAvailableSemaphores.assign(imageCount, VK_NULL_HANDLE);
-    sync.renderFinishedSemaphores.assign(imageCount, VK_NULL_HANDLE);
-    
-    // We still maintain one fence per frame in flight for CPU-GPU synchronization
-    sync.inFlightFences.assign(sync.maxFramesInFlight, VK_NULL_HANDLE);
-    
-    // imagesInFlight still sized based on the number of swap chain images
-    // It stores VK_NULL_HANDLE or a pointer to one of the inFlightFences
-    sync.imagesInFlight.assign(imageCount, VK_NULL_HANDLE);
-
-    VkSemaphoreCreateInfo semaphoreInfo{};
-    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
-
-    VkFenceCreateInfo fenceInfo{};
-    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-    fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT; // Create fences in signaled state for the first frame
-
-    bool success = true;
-    
-    // Create semaphores for each swap chain image
-    for (uint32_t i = 0; i < imageCount; ++i)
-    {
-        if (vkCreateSemaphore(device.logicalDevice, &semaphoreInfo, nullptr, &sync.imageAvailableSemaphores[i]) != VK_SUCCESS) {
-            spdlog::critical("Failed to create imageAvailableSemaphore #{}", i);
-            success = false; break;
-        }
-        if (vkCreateSemaphore(device.logicalDevice, &semaphoreInfo, nullptr, &sync.renderFinishedSemaphores[i]) != VK_SUCCESS) {
-            spdlog::critical("Failed to create renderFinishedSemaphore #{}", i);
-            success = false; break;
-        }
-    }
-    
-    // Create fences for each frame in flight
-    for (uint32_t i = 0; i < sync.maxFramesInFlight && success; ++i)
-    {
-        if (vkCreateFence(device.logicalDevice, &fenceInfo, nullptr, &sync.inFlightFences[i]) != VK_SUCCESS) {
-            spdlog::critical("Failed to create inFlightFence #{}", i);
-            success = false; break;
-        }
-    }    if (!success) {
-        spdlog::critical("Failed to create all synchronization objects. Cleaning up partially created ones.");
-        // Cleanup all potentially created sync objects by this call
-        
-        // Clean up semaphores (per swap chain image)
-        for (uint32_t i = 0; i < sync.imageAvailableSemaphores.size(); ++i) {
-            if (sync.imageAvailableSemaphores[i] != VK_NULL_HANDLE) {
-                vkDestroySemaphore(device.logicalDevice, sync.imageAvailableSemaphores[i], nullptr);
-            }
-            if (i < sync.renderFinishedSemaphores.size() && sync.renderFinishedSemaphores[i] != VK_NULL_HANDLE) {
-                vkDestroySemaphore(device.logicalDevice, sync.renderFinishedSemaphores[i], nullptr);
-            }
-        }
-        
-        // Clean up fences (per frame in flight)
-        for (uint32_t i = 0; i < sync.inFlightFences.size(); ++i) {
-            if (sync.inFlightFences[i] != VK_NULL_HANDLE) {
-                vkDestroyFence(device.logicalDevice, sync.inFlightFences[i], nullptr);
-            }
-        }
-        
-        // Clear all vectors
-        sync.imageAvailableSemaphores.clear();
-        sync.renderFinishedSemaphores.clear();
-        sync.inFlightFences.clear();
-        sync.imagesInFlight.clear();
-        return false;
-    }
-
-    spdlog::info("Synchronization primitives created successfully ({} frames in flight).", sync.maxFramesInFlight);
-    return true;
+	// Written next to the old one and renamed over it, so an interrupted run never leaves half a cache
+	const std::string temporaryPath = path + ".tmp";
+	{
+		std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+		if (!file.write(data.data(), static_cast<std::streamsize>(size)))
+		{
+			spdlog::error("Failed to write pipeline cache {}", temporaryPath);
+			return false;
+		}
+	}
+	std::error_code error;
+	std::filesystem::rename(temporaryPath, path, error);
+	if (error)
+	{
+		spdlog::error("Failed to replace pipeline cache {}: {}", path, error.message());
+		return false;
+	}
+	spdlog::debug("Pipeline cache saved: {} bytes", size);
+	return true;
+}
+
+bool createSwapChain(VulkanSwapChain& swapChain, VulkanDevice& device, const Window& window)
+{
+	// Corrected SwapchainBuilder instantiation
+	vkb::SwapchainBuilder swapchainBuilder(device.physicalDevice,
+		device.logicalDevice,
+		device.surface,
+		device.graphicsQueueFamilyIndex,
+		device.presentQueueFamilyIndex);
+
+	auto swapchainResult = swapchainBuilder
+		.use_default_format_selection()
+		.set_desired_present_mode(window.vsync ? VK_PRESENT_MODE_FIFO_KHR : VK_PRESENT_MODE_IMMEDIATE_KHR) // FIFO is a good default and widely supported
+		.set_desired_extent(window.width, window.height)
+		.add_image_usage_flags(VK_IMAGE_USAGE_TRANSFER_DST_BIT) // The scene is blitted in rather than rendered
+		.add_image_usage_flags(VK_IMAGE_USAGE_TRANSFER_SRC_BIT) // And copied out when frames are captured
+		//.set_desired_min_image_count(3) // Optional: request triple buffering
+		.build();
+
+	if (!swapchainResult)
+	{
+		spdlog::critical("Failed to create swap chain: {}", swapchainResult.error().message());
+		return false;
+	}
+
+	auto vkbSwapchain = swapchainResult.value();
+	swapChain.handle = vkbSwapchain.swapchain; // Corrected member name
+
+	auto imagesResult = vkbSwapchain.get_images();
+	if (!imagesResult) {
+		spdlog::critical("Failed to get swap chain images: {}", imagesResult.error().message());
+		// vkb::destroy_swapchain is not directly available, cleanup is handled by vkDestroySwapchainKHR
+		// in destroySwapChain if this function returns false and initVulkanRenderer handles device cleanup.
+		// If vkbSwapchain.swapchain was successfully created, it will be cleaned up by destroySwapChain.
+		return false;
+	}
+	swapChain.images = imagesResult.value();
+	swapChain.imageFormat = vkbSwapchain.image_format;
+	swapChain.extent = vkbSwapchain.extent;
+	if (device.debugUtils.IsEnabled()) {
+		for (size_t i = 0; i < swapChain.images.size(); ++i) {
+			device.debugUtils.SetObjectName(VK_OBJECT_TYPE_IMAGE, swapChain.images[i], fmt::format("Swap chain image {}", i).c_str());
+		}
+	}
+
+	// Create image views
+	swapChain.imageViews.resize(swapChain.images.size());
+	for (size_t i = 0; i < swapChain.images.size(); ++i)
+	{
+		VkImageViewCreateInfo viewInfo{};
+		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.image = swapChain.images[i];
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = swapChain.imageFormat;
+		viewInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+		viewInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+		viewInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+		viewInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+		viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		viewInfo.subresourceRange.baseMipLevel = 0;
+		viewInfo.subresourceRange.levelCount = 1;
+		viewInfo.subresourceRange.baseArrayLayer = 0;
+		viewInfo.subresourceRange.layerCount = 1;
+
+		if (vkCreateImageView(device.logicalDevice, &viewInfo, nullptr, &swapChain.imageViews[i]) != VK_SUCCESS)
+		{
+			spdlog::critical("Failed to create image views for swap chain");
+			// Cleanup already created image views before returning
+			for (size_t j = 0; j < i; ++j) {
+				vkDestroyImageView(device.logicalDevice, swapChain.imageViews[j], nullptr);
+			}
+			swapChain.imageViews.clear();
+			// The swapchain itself (vkbSwapchain.swapchain) will be cleaned up by destroySwapChain
+			// if this function returns false and initVulkanRenderer handles device cleanup.
+			return false;
+		}
+	}
+	spdlog::info("Swap chain created successfully with {} images.", swapChain.images.size());
+	return true;
+}
+
+bool createSynchronization(VulkanSynchronization& sync, VulkanDevice& device, const VulkanSwapChain& swapChain)
+{
+	// Create semaphores per swap chain image (not per frame in flight)
+	uint32_t imageCount = static_cast<uint32_t>(swapChain.images.size());
+	sync.imageAvailableSemaphores.assign(imageCount, VK_NULL_HANDLE);
+	sync.renderFinishedSemaphores.assign(imageCount, VK_NULL_HANDLE);
+
+	// We still maintain one fence per frame in flight for CPU-GPU synchronization
+	sync.inFlightFences.assign(sync.maxFramesInFlight, VK_NULL_HANDLE);
+
+	// imagesInFlight still sized based on the number of swap chain images
+	// It stores VK_NULL_HANDLE or a pointer to one of the inFlightFences
+	sync.imagesInFlight.assign(imageCount, VK_NULL_HANDLE);
+
+	VkSemaphoreCreateInfo semaphoreInfo{};
+	semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+	VkFenceCreateInfo fenceInfo{};
+	fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+	fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT; // Create fences in signaled state for the first frame
+
+	bool success = true;
+
+	// Create semaphores for each swap chain image
+	for (uint32_t i = 0; i < imageCount; ++i)
+	{
+		if (vkCreateSemaphore(device.logicalDevice, &semaphoreInfo, nullptr, &sync.imageAvailableSemaphores[i]) != VK_SUCCESS) {
+			spdlog::critical("Failed to create imageAvailableSemaphore #{}", i);
+			success = false;
+			break;
+		}
+		if (vkCreateSemaphore(device.logicalDevice, &semaphoreInfo, nullptr, &sync.renderFinishedSemaphores[i]) != VK_SUCCESS) {
+			spdlog::critical("Failed to create renderFinishedSemaphore #{}", i);
+			success = false;
+			break;
+		}
+	}
+
+	// Create fences for each frame in flight
+	for (uint32_t i = 0; i < sync.maxFramesInFlight && success; ++i)
+	{
+		if (vkCreateFence(device.logicalDevice, &fenceInfo, nullptr, &sync.inFlightFences[i]) != VK_SUCCESS) {
+			spdlog::critical("Failed to create inFlightFence #{}", i);
+			success = false;
+			break;
+		}
+	}
+
+	if (!success) {
+		spdlog::critical("Failed to create all synchronization objects. Cleaning up partially created ones.");
+		// Cleanup all potentially created sync objects by this call
+
+		// Clean up semaphores (per swap chain image)
+		for (uint32_t i = 0; i < sync.imageAvailableSemaphores.size(); ++i) {
+			if (sync.imageAvailableSemaphores[i] != VK_NULL_HANDLE) {
+				vkDestroySemaphore(device.logicalDevice, sync.imageAvailableSemaphores[i], nullptr);
+			}
+			if (i < sync.renderFinishedSemaphores.size() && sync.renderFinishedSemaphores[i] != VK_NULL_HANDLE) {
+				vkDestroySemaphore(device.logicalDevice, sync.renderFinishedSemaphores[i], nullptr);
+			}
+		}
+
+		// Clean up fences (per frame in flight)
+		for (uint32_t i = 0; i < sync.inFlightFences.size(); ++i) {
+			if (sync.inFlightFences[i] != VK_NULL_HANDLE) {
+				vkDestroyFence(device.logicalDevice, sync.inFlightFences[i], nullptr);
+			}
+		}
+
+		// Clear all vectors
+		sync.imageAvailableSemaphores.clear();
+		sync.renderFinishedSemaphores.clear();
+		sync.inFlightFences.clear();
+		sync.imagesInFlight.clear();
+		return false;
+	}
+
+	spdlog::info("Synchronization primitives created successfully ({} frames in flight).", sync.maxFramesInFlight);
+	return true;
 }
 
 void destroyVulkanRenderer(VulkanRenderer& renderer)
 {
 	spdlog::debug("Destroying Vulkan renderer resources");
-    // Destroy in reverse order of creation
-    
-    // Destroy command pool (this implicitly frees all allocated command buffers)
-    if (renderer.commandPool != VK_NULL_HANDLE) {
-        vkDestroyCommandPool(renderer.device.logicalDevice, renderer.commandPool, nullptr);
-        renderer.commandPool = VK_NULL_HANDLE;
-        spdlog::debug("Command pool destroyed");
-    }
-    
-    destroySynchronization(renderer.synchronization, renderer.device);
+	// Destroy in reverse order of creation
+
+	renderer.device.queues.Destroy();
+
+	// Destroy command pool (this implicitly frees all allocated command buffers)
+	if (renderer.commandPool != VK_NULL_HANDLE) {
+		vkDestroyCommandPool(renderer.device.logicalDevice, renderer.commandPool, nullptr);
+		renderer.commandPool = VK_NULL_HANDLE;
+		spdlog::debug("Command pool destroyed");
+	}
+
+	destroySynchronization(renderer.synchronization, renderer.device);
 	destroySwapChain(renderer.swapChain, renderer.device);
 	destroyVulkanDevice(renderer.device);
-    spdlog::info("Vulkan renderer resources destroyed.");
+	spdlog::info("Vulkan renderer resources destroyed.");
 }
 
 void destroyVulkanDevice(VulkanDevice& device)
 {
-	if (device.allocator != VK_NULL_HANDLE)
+	if (device.pipelineCache != VK_NULL_HANDLE)
 	{
-		spdlog::debug("Destroying VMA allocator");
-		vmaDestroyAllocator(device.allocator);
-		device.allocator = VK_NULL_HANDLE;
+		vkDestroyPipelineCache(device.logicalDevice, device.pipelineCache, nullptr);
+		device.pipelineCache = VK_NULL_HANDLE;
 	}
 
+	device.memory.Destroy();
+
 	if (device.logicalDevice != VK_NULL_HANDLE)
 	{
 		spdlog::debug("Destroying logical device");
@@ -672,6 +1831,9 @@ void destroyVulkanDevice(VulkanDevice& device)
 
 void destroySwapChain(VulkanSwapChain& swapChain, VulkanDevice& device)
 {
+	destroySceneColorResources(swapChain, device);
+	destroyDepthResources(swapChain, device);
+
 	for (auto imageView : swapChain.imageViews)
 	{
 		if (imageView != VK_NULL_HANDLE)
@@ -686,7 +1848,7 @@ void destroySwapChain(VulkanSwapChain& swapChain, VulkanDevice& device)
 		vkDestroySwapchainKHR(device.logicalDevice, swapChain.handle, nullptr);
 		swapChain.handle = VK_NULL_HANDLE;
 	}
-	
+
 	// Clear other swapchain members if necessary, e.g., images, format, extent
 	swapChain.images.clear();
 	swapChain.imageFormat = VK_FORMAT_UNDEFINED;
@@ -697,552 +1859,1897 @@ void destroySwapChain(VulkanSwapChain& swapChain, VulkanDevice& device)
 
 void destroySynchronization(VulkanSynchronization& sync, VulkanDevice& device)
 {
-    spdlog::debug("Destroying synchronization primitives...");
-    // Destroy image-specific semaphores
-    for (VkSemaphore semaphore : sync.imageAvailableSemaphores) {
-        if (semaphore != VK_NULL_HANDLE) {
-            vkDestroySemaphore(device.logicalDevice, semaphore, nullptr);
-        }
-    }
-    sync.imageAvailableSemaphores.clear();
-
-    for (VkSemaphore semaphore : sync.renderFinishedSemaphores) {
-        if (semaphore != VK_NULL_HANDLE) {
-            vkDestroySemaphore(device.logicalDevice, semaphore, nullptr);
-        }
-    }
-    sync.renderFinishedSemaphores.clear();
-
-    // Destroy frame-specific fences
-    for (VkFence fence : sync.inFlightFences) {
-        if (fence != VK_NULL_HANDLE) {
-            vkDestroyFence(device.logicalDevice, fence, nullptr);
-        }
-    }
-    sync.inFlightFences.clear();
-    
-    sync.imagesInFlight.clear(); // Does not own Vulkan objects, just clears the vector
-
-    spdlog::debug("Synchronization primitives destroyed.");
+	spdlog::debug("Destroying synchronization primitives...");
+	// Destroy image-specific semaphores
+	for (VkSemaphore semaphore : sync.imageAvailableSemaphores) {
+		if (semaphore != VK_NULL_HANDLE) {
+			vkDestroySemaphore(device.logicalDevice, semaphore, nullptr);
+		}
+	}
+	sync.imageAvailableSemaphores.clear();
+
+	for (VkSemaphore semaphore : sync.renderFinishedSemaphores) {
+		if (semaphore != VK_NULL_HANDLE) {
+			vkDestroySemaphore(device.logicalDevice, semaphore, nullptr);
+		}
+	}
+	sync.renderFinishedSemaphores.clear();
+
+	// Destroy frame-specific fences
+	for (VkFence fence : sync.inFlightFences) {
+		if (fence != VK_NULL_HANDLE) {
+			vkDestroyFence(device.logicalDevice, fence, nullptr);
+		}
+	}
+	sync.inFlightFences.clear();
+
+	sync.imagesInFlight.clear(); // Does not own Vulkan objects, just clears the vector
+
+	spdlog::debug("Synchronization primitives destroyed.");
 }
 
 // --- New Function Definitions ---
 // Utility Functions
 std::vector<char> readFile(const std::string& filename) {
-    std::ifstream file(filename, std::ios::ate | std::ios::binary);
-    if (!file.is_open()) {
-        spdlog::critical("Failed to open file: {}", filename);
-        return {};
-    }
+	std::ifstream file(filename, std::ios::ate | std::ios::binary);
+	if (!file.is_open()) {
+		spdlog::critical("Failed to open file: {}", filename);
+		return {};
+	}
 
-    size_t fileSize = static_cast<size_t>(file.tellg());
-    std::vector<char> buffer(fileSize);
+	size_t fileSize = static_cast<size_t>(file.tellg());
+	std::vector<char> buffer(fileSize);
 
-    file.seekg(0);
-    file.read(buffer.data(), fileSize);
+	file.seekg(0);
+	file.read(buffer.data(), fileSize);
 
-    file.close();
-    spdlog::debug("Read {} bytes from file: {}", fileSize, filename);
-    return buffer;
+	file.close();
+	spdlog::debug("Read {} bytes from file: {}", fileSize, filename);
+	return buffer;
 }
 
-VkShaderModule createShaderModule(VkDevice device, const std::vector<char>& code) {
-    VkShaderModuleCreateInfo createInfo{};
-    createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    createInfo.codeSize = code.size();
-    createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+bool readShaderDirectory(std::unordered_map<std::string, std::vector<char>>& shaderCode, const std::string& directory) {
+	constexpr uint32_t SpirvMagic = 0x07230203;
 
-    VkShaderModule shaderModule;
-    if (vkCreateShaderModule(device, &createInfo, nullptr, &shaderModule) != VK_SUCCESS) {
-        spdlog::critical("Failed to create shader module");
-        return VK_NULL_HANDLE;
-    }
+	std::error_code error;
+	std::filesystem::directory_iterator entries(directory, error);
+	if (error) {
+		spdlog::error("Failed to list shaders in {}: {}", directory, error.message());
+		return false;
+	}
 
-    spdlog::debug("Shader module created successfully");
-    return shaderModule;
+	// Keyed the way the pipelines name their shaders, so a lookup is a plain string compare
+	for (const std::filesystem::directory_entry& entry : entries) {
+		if (entry.path().extension() != ".spv") {
+			continue;
+		}
+		const std::string path = directory + "/" + entry.path().filename().string();
+		std::vector<char> code = readFile(path);
+		uint32_t magic = 0;
+		if (code.size() >= sizeof(magic)) {
+			memcpy(&magic, code.data(), sizeof(magic));
+		}
+		if (code.size() % 4 != 0 || magic != SpirvMagic) {
+			spdlog::error("{} is not SPIR-V", path);
+			return false;
+		}
+		shaderCode[path] = std::move(code);
+	}
+	return true;
+}
+
+std::vector<char> readShaderFile(VulkanDevice& device, const std::string& path) {
+	// Only the startup thread fills the map, before any pipeline is created
+	auto preloaded = device.shaderCode.find(path);
+	if (preloaded == device.shaderCode.end()) {
+		return readFile(path);
+	}
+	std::vector<char> code = std::move(preloaded->second);
+	device.shaderCode.erase(preloaded);
+	return code;
+}
+
+VkShaderModule createShaderModule(VkDevice device, const std::vector<char>& code) {
+	VkShaderModuleCreateInfo createInfo{};
+	createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+	createInfo.codeSize = code.size();
+	createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+
+	VkShaderModule shaderModule;
+	if (vkCreateShaderModule(device, &createInfo, nullptr, &shaderModule) != VK_SUCCESS) {
+		spdlog::critical("Failed to create shader module");
+		return VK_NULL_HANDLE;
+	}
+
+	spdlog::debug("Shader module created successfully");
+	return shaderModule;
 }
 
 // Vertex Input Descriptions (Vulkan-specific for our Vertex struct)
 VkVertexInputBindingDescription getVertexBindingDescription() {
-    VkVertexInputBindingDescription bindingDescription{};
-    bindingDescription.binding = 0;
-    bindingDescription.stride = sizeof(Vertex);
-    bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-    return bindingDescription;
+	VkVertexInputBindingDescription bindingDescription{};
+	bindingDescription.binding = 0;
+	bindingDescription.stride = sizeof(Vertex);
+	bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+	return bindingDescription;
 }
 
 std::vector<VkVertexInputAttributeDescription> getVertexAttributeDescriptions() {
-    return {
-        // Position attribute
-        { 0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, pos) },
-        // Color attribute
-        { 0, 1, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, color) },
-        // TexCoord attribute (if added in the future)
-        // { 0, 2, VK_FORMAT_R32G32_SFLOAT, offsetof(Vertex, texCoord) },
-    };
+	return {
+		// Position attribute
+		{ 0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, pos) },
+		// Color attribute
+		{ 0, 1, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, color) },
+		// TexCoord attribute
+		{ 0, 2, VK_FORMAT_R32G32_SFLOAT, offsetof(Vertex, texCoord) },
+	};
+}
+
+// Returns the value following name on the command line, e.g. "--objects 10000"
+uint32_t parseUintArgument(int argc, char** argv, const std::string& name, uint32_t defaultValue) {
+	for (int i = 1; i + 1 < argc; ++i) {
+		if (name == argv[i]) {
+			try {
+				return static_cast<uint32_t>(std::stoul(argv[i + 1]));
+			} catch (const std::exception&) {
+				spdlog::warn("Invalid value '{}' for {}, using {}", argv[i + 1], name, defaultValue);
+				return defaultValue;
+			}
+		}
+	}
+	return defaultValue;
+}
+
+// Returns the value following name on the command line, e.g. "--memory-stats memory.json"
+std::string parseStringArgument(int argc, char** argv, const std::string& name, const std::string& defaultValue) {
+	for (int i = 1; i + 1 < argc; ++i) {
+		if (name == argv[i]) {
+			return argv[i + 1];
+		}
+	}
+	return defaultValue;
+}
+
+// "--instrumentation off|labels|validation|full", the build's default otherwise
+MiniEngine::Graphics::InstrumentationLevel parseInstrumentationArgument(int argc, char** argv) {
+	MiniEngine::Graphics::InstrumentationLevel level = MiniEngine::Graphics::DefaultInstrumentationLevel;
+	for (int i = 1; i + 1 < argc; ++i) {
+		if (std::string("--instrumentation") == argv[i] && !MiniEngine::Graphics::ParseInstrumentationLevel(argv[i + 1], level)) {
+			spdlog::warn("Invalid value '{}' for --instrumentation, using {}", argv[i + 1], MiniEngine::Graphics::ToString(level));
+		}
+	}
+	return level;
+}
+
+bool hasArgument(int argc, char** argv, const std::string& name) {
+	for (int i = 1; i < argc; ++i) {
+		if (name == argv[i]) {
+			return true;
+		}
+	}
+	return false;
 }
 
 // Mesh Lifecycle
-bool createVertexBuffer(VulkanMesh& mesh, VulkanDevice& device, VmaAllocator allocator, const std::vector<Vertex>& vertices) {
-    mesh.vertexCount = static_cast<uint32_t>(vertices.size());    // Create the vertex buffer
-    VkBufferCreateInfo bufferInfo{};
-    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-    bufferInfo.size = sizeof(Vertex) * mesh.vertexCount;
-    bufferInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
-    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE; // Assuming single queue family for now
-
-    VmaAllocationCreateInfo allocInfo = {};
-    allocInfo.usage = VMA_MEMORY_USAGE_CPU_TO_GPU; // Host visible memory for mapping
-    // Don't set the requiredFlags to allow VMA to choose appropriate memory type
-
-    if (vmaCreateBuffer(allocator, &bufferInfo, &allocInfo, &mesh.vertexBuffer, &mesh.vertexBufferMemory, nullptr) != VK_SUCCESS) {
-        spdlog::critical("Failed to create vertex buffer");
-        return false;
-    }
-
-    // Copy vertex data to the buffer
-    void* data;
-    if (vmaMapMemory(allocator, mesh.vertexBufferMemory, &data) != VK_SUCCESS) {
-        spdlog::critical("Failed to map vertex buffer memory");
-        return false;
-    }
-    memcpy(data, vertices.data(), sizeof(Vertex) * mesh.vertexCount);
-    vmaUnmapMemory(allocator, mesh.vertexBufferMemory);
-
-    spdlog::info("Vertex buffer created with {} vertices", mesh.vertexCount);
-    return true;
-}
-
-void destroyMesh(VulkanMesh& mesh, VulkanDevice& device, VmaAllocator allocator) {
-    if (mesh.vertexBuffer != VK_NULL_HANDLE) {
-        vmaDestroyBuffer(allocator, mesh.vertexBuffer, mesh.vertexBufferMemory);
-        mesh.vertexBuffer = VK_NULL_HANDLE;
-        mesh.vertexBufferMemory = VK_NULL_HANDLE;
-        mesh.vertexCount = 0;
-        spdlog::debug("Vertex buffer destroyed");
-    }
-    // Add index buffer destruction here if implemented
+// Splits the triangle into subdivisions^2 smaller ones, interpolating every attribute, and ripples
+// the surface by a few hundredths of its size so the result is no longer flat. The back is a second
+// copy with its own vertices and the winding reversed, so back faces can be culled, down to whole
+// clusters of them.
+void tessellateTriangle(const Vertex (&corners)[3], uint32_t subdivisions, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+	vertices.clear();
+	indices.clear();
+
+	// Row r runs from the first corner's side (r = 0, a single vertex) to the edge between the other two
+	auto rowStart = [](uint32_t row) { return row * (row + 1) / 2; };
+	for (uint32_t row = 0; row <= subdivisions; ++row) {
+		for (uint32_t column = 0; column <= row; ++column) {
+			const float toEdge = static_cast<float>(row) / static_cast<float>(subdivisions);
+			const float along = static_cast<float>(column) / static_cast<float>(subdivisions);
+			const float weights[3] = { 1.0f - toEdge, along, toEdge - along };
+			Vertex vertex{ glm::vec3(0.0f), glm::vec3(0.0f), glm::vec2(0.0f) };
+			for (uint32_t corner = 0; corner < 3; ++corner) {
+				vertex.pos += corners[corner].pos * weights[corner];
+				vertex.color += corners[corner].color * weights[corner];
+				vertex.texCoord = vertex.texCoord + corners[corner].texCoord * weights[corner];
+			}
+			vertex.pos.z += 0.04f * std::sin(vertex.pos.x * 9.0f) * std::sin(vertex.pos.y * 7.0f);
+			vertices.push_back(vertex);
+		}
+	}
+
+	for (uint32_t row = 0; row < subdivisions; ++row) {
+		for (uint32_t column = 0; column <= row; ++column) {
+			const uint32_t top = rowStart(row) + column;
+			const uint32_t below = rowStart(row + 1) + column;
+			indices.insert(indices.end(), { top, below + 1, below });
+			if (column < row) {
+				indices.insert(indices.end(), { top, top + 1, below + 1 });
+			}
+		}
+	}
+
+	const uint32_t frontVertices = static_cast<uint32_t>(vertices.size());
+	const size_t frontIndices = indices.size();
+	vertices.insert(vertices.end(), vertices.begin(), vertices.end());
+	for (size_t i = 0; i < frontIndices; i += 3) {
+		indices.insert(indices.end(), { indices[i] + frontVertices, indices[i + 2] + frontVertices, indices[i + 1] + frontVertices });
+	}
+}
+
+// Finely tessellated and rippled, so distant objects have detail to shed. There is no asset pipeline,
+// so the levels of detail are built here at load. Logs and returns false on failure.
+bool createTriangleMesh(VulkanMesh& mesh, VulkanRenderer& renderer) {
+	const Vertex corners[3] = {
+		{ { 0.0f, -0.5f, 0.0f }, { 1.0f, 0.0f, 0.0f }, { 0.5f, 0.0f } }, // bottom-center, red
+		{ { 0.5f,  0.5f, 0.0f }, { 0.0f, 1.0f, 0.0f }, { 1.0f, 1.0f } }, // top-right, green
+		{ {-0.5f,  0.5f, 0.0f }, { 0.0f, 0.0f, 1.0f }, { 0.0f, 1.0f } }, // top-left, blue
+	};
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+	tessellateTriangle(corners, 48, vertices, indices);
+
+	MiniEngine::Graphics::MeshLodSettings lodSettings;
+	lodSettings.maxLevels = MaxMeshLods;
+	const auto lodStart = std::chrono::steady_clock::now();
+	mesh.lods = MiniEngine::Graphics::BuildMeshLods(indices, &vertices[0].pos.x, vertices.size(), sizeof(Vertex), lodSettings);
+	spdlog::info("Built {} levels of detail in {:.1f} ms", mesh.lods.size(),
+		std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - lodStart).count());
+
+	// Each level is then split into meshlets the culling shader can reject on their own
+	for (const MiniEngine::Graphics::MeshLod& lod : mesh.lods) {
+		std::vector<MiniEngine::Graphics::Meshlet> meshlets = MiniEngine::Graphics::BuildMeshlets(
+			std::span<uint32_t>(indices).subspan(lod.firstIndex, lod.indexCount), lod.firstIndex, &vertices[0].pos.x, vertices.size(), sizeof(Vertex));
+		mesh.lodMeshlets.emplace_back(static_cast<uint32_t>(mesh.meshlets.size()), static_cast<uint32_t>(meshlets.size()));
+		mesh.meshlets.insert(mesh.meshlets.end(), meshlets.begin(), meshlets.end());
+	}
+
+	if (!createVertexBuffer(mesh, renderer, vertices) || !createIndexBuffer(mesh, renderer, indices) ||
+		!createMeshletBuffer(mesh, renderer)) {
+		spdlog::critical("Failed to create mesh buffers");
+		return false;
+	}
+	for (size_t level = 0; level < mesh.lods.size(); ++level) {
+		spdlog::info("  Level {}: {} triangles in {} meshlets, error {:.5f}", level, mesh.lods[level].indexCount / 3,
+			mesh.lodMeshlets[level].y, mesh.lods[level].error);
+	}
+	spdlog::info("Triangle mesh created successfully with {} vertices", mesh.vertexCount);
+	return true;
+}
+
+bool createVertexBuffer(VulkanMesh& mesh, VulkanRenderer& renderer, const std::vector<Vertex>& vertices) {
+	mesh.vertexCount = static_cast<uint32_t>(vertices.size());
+	const VkDeviceSize size = sizeof(Vertex) * mesh.vertexCount;
+
+	// Device-local memory, filled through the transfer queue
+	if (!renderer.device.memory.CreateBuffer(size, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VMA_MEMORY_USAGE_GPU_ONLY, MiniEngine::Graphics::MemoryCategory::Geometry, mesh.vertexBuffer, mesh.vertexBufferMemory, nullptr)) {
+		spdlog::critical("Failed to create vertex buffer");
+		return false;
+	}
+	renderer.device.debugUtils.SetObjectName(VK_OBJECT_TYPE_BUFFER, mesh.vertexBuffer, "Mesh vertices");
+
+	if (!renderer.device.queues.UploadBuffer(renderer.device.memory, renderer.commandPool, mesh.vertexBuffer, vertices.data(), size,
+		VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT)) {
+		spdlog::critical("Failed to upload vertex buffer");
+		return false;
+	}
+
+	spdlog::info("Vertex buffer created with {} vertices", mesh.vertexCount);
+	return true;
+}
+
+bool createIndexBuffer(VulkanMesh& mesh, VulkanRenderer& renderer, const std::vector<uint32_t>& indices) {
+	mesh.indexCount = static_cast<uint32_t>(indices.size());
+	const VkDeviceSize size = sizeof(uint32_t) * mesh.indexCount;
+
+	if (!renderer.device.memory.CreateBuffer(size, VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VMA_MEMORY_USAGE_GPU_ONLY, MiniEngine::Graphics::MemoryCategory::Geometry, mesh.indexBuffer, mesh.indexBufferMemory, nullptr)) {
+		spdlog::critical("Failed to create index buffer");
+		return false;
+	}
+	renderer.device.debugUtils.SetObjectName(VK_OBJECT_TYPE_BUFFER, mesh.indexBuffer, "Mesh indices");
+
+	if (!renderer.device.queues.UploadBuffer(renderer.device.memory, renderer.commandPool, mesh.indexBuffer, indices.data(), size,
+		VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_INDEX_READ_BIT)) {
+		spdlog::critical("Failed to upload index buffer");
+		return false;
+	}
+
+	spdlog::info("Index buffer created with {} indices", mesh.indexCount);
+	return true;
+}
+
+bool createMeshletBuffer(VulkanMesh& mesh, VulkanRenderer& renderer) {
+	const VkDeviceSize size = sizeof(MiniEngine::Graphics::Meshlet) * std::max<size_t>(mesh.meshlets.size(), 1);
+
+	if (!renderer.device.memory.CreateBuffer(size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VMA_MEMORY_USAGE_GPU_ONLY, MiniEngine::Graphics::MemoryCategory::Geometry, mesh.meshletBuffer, mesh.meshletBufferMemory, nullptr)) {
+		spdlog::critical("Failed to create meshlet buffer");
+		return false;
+	}
+	renderer.device.debugUtils.SetObjectName(VK_OBJECT_TYPE_BUFFER, mesh.meshletBuffer, "Mesh meshlets");
+
+	if (!mesh.meshlets.empty() &&
+		!renderer.device.queues.UploadBuffer(renderer.device.memory, renderer.commandPool, mesh.meshletBuffer, mesh.meshlets.data(), sizeof(MiniEngine::Graphics::Meshlet) * mesh.meshlets.size(),
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT)) {
+		spdlog::critical("Failed to upload meshlet buffer");
+		return false;
+	}
+
+	spdlog::info("Meshlet buffer created with {} meshlets", mesh.meshlets.size());
+	return true;
+}
+
+void destroyMesh(VulkanMesh& mesh, VulkanDevice& device) {
+	if (mesh.vertexBuffer != VK_NULL_HANDLE) {
+		device.memory.DestroyBuffer(mesh.vertexBuffer, mesh.vertexBufferMemory);
+		mesh.vertexBuffer = VK_NULL_HANDLE;
+		mesh.vertexBufferMemory = VK_NULL_HANDLE;
+		mesh.vertexCount = 0;
+		spdlog::debug("Vertex buffer destroyed");
+	}
+	if (mesh.indexBuffer != VK_NULL_HANDLE) {
+		device.memory.DestroyBuffer(mesh.indexBuffer, mesh.indexBufferMemory);
+		mesh.indexBuffer = VK_NULL_HANDLE;
+		mesh.indexBufferMemory = VK_NULL_HANDLE;
+		mesh.indexCount = 0;
+		spdlog::debug("Index buffer destroyed");
+	}
+	if (mesh.meshletBuffer != VK_NULL_HANDLE) {
+		device.memory.DestroyBuffer(mesh.meshletBuffer, mesh.meshletBufferMemory);
+		mesh.meshletBuffer = VK_NULL_HANDLE;
+		mesh.meshletBufferMemory = VK_NULL_HANDLE;
+		spdlog::debug("Meshlet buffer destroyed");
+	}
+	mesh.lods.clear();
+	mesh.meshlets.clear();
+	mesh.lodMeshlets.clear();
 }
 
 // Pipeline Lifecycle
-bool createRenderPass(VkRenderPass& renderPass, VulkanDevice& device, VkFormat swapChainImageFormat) {
-    VkAttachmentDescription colorAttachment{};
-    colorAttachment.format = swapChainImageFormat;
-    colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-    colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-    colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-    colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-    colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-
-    VkAttachmentReference colorAttachmentRef{};
-    colorAttachmentRef.attachment = 0;
-    colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-    VkSubpassDescription subpass{};
-    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-    subpass.colorAttachmentCount = 1;
-    subpass.pColorAttachments = &colorAttachmentRef;
-
-    VkRenderPassCreateInfo renderPassInfo{};
-    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-    renderPassInfo.attachmentCount = 1;
-    renderPassInfo.pAttachments = &colorAttachment;
-    renderPassInfo.subpassCount = 1;
-    renderPassInfo.pSubpasses = &subpass;
-
-    if (vkCreateRenderPass(device.logicalDevice, &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS) {
-        spdlog::critical("Failed to create render pass");
-        return false;
-    }
-
-    spdlog::debug("Render pass created successfully");
-    return true;
+// The clearing pass starts a frame and leaves the attachments ready for more drawing; the loading
+// pass continues from there and hands the scene color to the upscaling blit. Both are compatible,
+// so they share framebuffers and pipelines.
+bool createRenderPass(VkRenderPass& renderPass, VulkanDevice& device, VkFormat swapChainImageFormat, VkFormat depthFormat, bool clearAttachments) {
+	VkAttachmentDescription colorAttachment{};
+	colorAttachment.format = swapChainImageFormat;
+	colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+	colorAttachment.loadOp = clearAttachments ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD;
+	colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+	colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	colorAttachment.initialLayout = clearAttachments ? VK_IMAGE_LAYOUT_UNDEFINED : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	colorAttachment.finalLayout = clearAttachments ? VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+
+	// Depth is stored after the first pass so the Hi-Z pyramid can be built from it
+	VkAttachmentDescription depthAttachment{};
+	depthAttachment.format = depthFormat;
+	depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+	depthAttachment.loadOp = clearAttachments ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD;
+	depthAttachment.storeOp = clearAttachments ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	depthAttachment.initialLayout = clearAttachments ? VK_IMAGE_LAYOUT_UNDEFINED : VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+	depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+	VkAttachmentDescription attachments[] = { colorAttachment, depthAttachment };
+
+	VkAttachmentReference colorAttachmentRef{};
+	colorAttachmentRef.attachment = 0;
+	colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+	VkAttachmentReference depthAttachmentRef{};
+	depthAttachmentRef.attachment = 1;
+	depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+	VkSubpassDescription subpass{};
+	subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+	subpass.colorAttachmentCount = 1;
+	subpass.pColorAttachments = &colorAttachmentRef;
+	subpass.pDepthStencilAttachment = &depthAttachmentRef;
+
+	// Wait for earlier attachment writes, for the Hi-Z build reading the shared depth image and for
+	// the previous frame's upscale reading the shared scene color
+	VkSubpassDependency dependency{};
+	dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+	dependency.dstSubpass = 0;
+	dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT
+		| VK_PIPELINE_STAGE_TRANSFER_BIT;
+	dependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+	dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT
+		| VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+	VkRenderPassCreateInfo renderPassInfo{};
+	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+	renderPassInfo.attachmentCount = 2;
+	renderPassInfo.pAttachments = attachments;
+	renderPassInfo.subpassCount = 1;
+	renderPassInfo.pSubpasses = &subpass;
+	renderPassInfo.dependencyCount = 1;
+	renderPassInfo.pDependencies = &dependency;
+
+	if (vkCreateRenderPass(device.logicalDevice, &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS) {
+		spdlog::critical("Failed to create render pass");
+		return false;
+	}
+
+	spdlog::debug("Render pass created successfully");
+	return true;
 }
 
 void destroyRenderPass(VkRenderPass& renderPass, VulkanDevice& device) {
-    if (renderPass != VK_NULL_HANDLE) {
-        vkDestroyRenderPass(device.logicalDevice, renderPass, nullptr);
-        renderPass = VK_NULL_HANDLE;
-        spdlog::debug("Render pass destroyed");
-    }
+	if (renderPass != VK_NULL_HANDLE) {
+		vkDestroyRenderPass(device.logicalDevice, renderPass, nullptr);
+		renderPass = VK_NULL_HANDLE;
+		spdlog::debug("Render pass destroyed");
+	}
 }
 
 bool createGraphicsPipeline(
-    VulkanPipeline& pipeline,
-    VulkanDevice& device,
-    VkExtent2D swapChainExtent,
-    VkRenderPass compatibleRenderPass,
-    const std::string& vertShaderPath,
-    const std::string& fragShaderPath
+	VulkanPipeline& pipeline,
+	VulkanDevice& device,
+	VkRenderPass compatibleRenderPass,
+	VkDescriptorSetLayout sceneSetLayout,
+	VkDescriptorSetLayout lightingSetLayout,
+	VkDescriptorSetLayout textureSetLayout,
+	const std::string& vertShaderPath,
+	const std::string& fragShaderPath
 ) {
-    // Load and create shader modules
-    auto vertShaderCode = readFile(vertShaderPath);
-    auto fragShaderCode = readFile(fragShaderPath);
-
-    if (vertShaderCode.empty() || fragShaderCode.empty()) {
-        spdlog::critical("Failed to read shader files");
-        return false;
-    }
-
-    VkShaderModule vertShaderModule = createShaderModule(device.logicalDevice, vertShaderCode);
-    VkShaderModule fragShaderModule = createShaderModule(device.logicalDevice, fragShaderCode);
-
-    if (vertShaderModule == VK_NULL_HANDLE || fragShaderModule == VK_NULL_HANDLE) {
-        spdlog::critical("Failed to create shader modules");
-        return false;
-    }
-
-    // Pipeline layout (assuming no dynamic descriptors or push constants for now)
-    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
-    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    pipelineLayoutInfo.setLayoutCount = 0; // No descriptor sets for now
-    pipelineLayoutInfo.pushConstantRangeCount = 0; // No push constants for now
-
-    if (vkCreatePipelineLayout(device.logicalDevice, &pipelineLayoutInfo, nullptr, &pipeline.pipelineLayout) != VK_SUCCESS) {
-        spdlog::critical("Failed to create pipeline layout");
-        return false;
-    }
-
-    // Render pass (assuming compatible with swap chain)
-    pipeline.renderPass = compatibleRenderPass;
-
-    // Graphics pipeline creation
-    VkGraphicsPipelineCreateInfo pipelineInfo{};
-    pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-    pipelineInfo.stageCount = 2; // Vertex and fragment shaders
-    pipelineInfo.pStages = nullptr; // To be filled later
-
-    // Fixed function states (simplified)
-    VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
-    inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-    inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-    inputAssembly.primitiveRestartEnable = VK_FALSE;
-
-    VkViewport viewport{};
-    viewport.x = 0.0f;
-    viewport.y = 0.0f;
-    viewport.width = static_cast<float>(swapChainExtent.width);
-    viewport.height = static_cast<float>(swapChainExtent.height);
-    viewport.minDepth = 0.0f;
-    viewport.maxDepth = 1.0f;
-
-    VkRect2D scissor{};
-    scissor.offset = { 0, 0 };
-    scissor.extent = swapChainExtent;
-
-    VkPipelineViewportStateCreateInfo viewportState{};
-    viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-    viewportState.viewportCount = 1;
-    viewportState.pViewports = &viewport;
-    viewportState.scissorCount = 1;
-    viewportState.pScissors = &scissor;
-
-    VkPipelineRasterizationStateCreateInfo rasterizer{};
-    rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-    rasterizer.depthClampEnable = VK_FALSE;
-    rasterizer.rasterizerDiscardEnable = VK_FALSE;
-    rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
-    rasterizer.lineWidth = 1.0f;
-    rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
-    rasterizer.frontFace = VK_FRONT_FACE_CLOCKWISE;
-    rasterizer.depthBiasEnable = VK_FALSE;
-
-    VkPipelineMultisampleStateCreateInfo multisampling{};
-    multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-    multisampling.sampleShadingEnable = VK_FALSE;
-    multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
-
-    VkPipelineColorBlendAttachmentState colorBlendAttachment{};
-    colorBlendAttachment.blendEnable = VK_FALSE;
-    colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-
-    VkPipelineColorBlendStateCreateInfo colorBlending{};
-    colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-    colorBlending.attachmentCount = 1;
-    colorBlending.pAttachments = &colorBlendAttachment;
-
-    // Assign shader stages to pipeline
-    VkPipelineShaderStageCreateInfo shaderStages[2] = {};
-
-    // Vertex shader stage
-    shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    shaderStages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
-    shaderStages[0].module = vertShaderModule;
-    shaderStages[0].pName = "main";
-
-    // Fragment shader stage
-    shaderStages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    shaderStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-    shaderStages[1].module = fragShaderModule;
-    shaderStages[1].pName = "main";
-
-    pipelineInfo.pStages = shaderStages;    // Vertex input state
-    VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
-    vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-    
-    // For our shader which uses gl_VertexIndex, we don't need any vertex input bindings
-    // If we were using an actual vertex buffer with data, we would fill these in
-    vertexInputInfo.vertexBindingDescriptionCount = 0;
-    vertexInputInfo.vertexAttributeDescriptionCount = 0;
-    
-    pipelineInfo.pVertexInputState = &vertexInputInfo;
-
-    // Input assembly state
-    pipelineInfo.pInputAssemblyState = &inputAssembly;
-
-    // Viewport and scissor state
-    pipelineInfo.pViewportState = &viewportState;
-
-    // Rasterization state
-    pipelineInfo.pRasterizationState = &rasterizer;
-
-    // Multisample state
-    pipelineInfo.pMultisampleState = &multisampling;
-
-    // Color blend state
-    pipelineInfo.pColorBlendState = &colorBlending;
-
-    // Pipeline layout and render pass
-    pipelineInfo.layout = pipeline.pipelineLayout;
-    pipelineInfo.renderPass = pipeline.renderPass;
-    pipelineInfo.subpass = 0; // Assuming single subpass
-
-    if (vkCreateGraphicsPipelines(device.logicalDevice, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline.graphicsPipeline) != VK_SUCCESS) {
-        spdlog::critical("Failed to create graphics pipeline");
-        return false;
-    }
-
-    // Cleanup shader modules if not managed by the pipeline
-    vkDestroyShaderModule(device.logicalDevice, vertShaderModule, nullptr);
-    vkDestroyShaderModule(device.logicalDevice, fragShaderModule, nullptr);
-
-    spdlog::info("Graphics pipeline created successfully");
-    return true;
+	// Load and create shader modules
+	auto vertShaderCode = readShaderFile(device, vertShaderPath);
+	auto fragShaderCode = readShaderFile(device, fragShaderPath);
+
+	if (vertShaderCode.empty() || fragShaderCode.empty()) {
+		spdlog::critical("Failed to read shader files");
+		return false;
+	}
+
+	VkShaderModule vertShaderModule = createShaderModule(device.logicalDevice, vertShaderCode);
+	VkShaderModule fragShaderModule = createShaderModule(device.logicalDevice, fragShaderCode);
+
+	if (vertShaderModule == VK_NULL_HANDLE || fragShaderModule == VK_NULL_HANDLE) {
+		spdlog::critical("Failed to create shader modules");
+		return false;
+	}
+
+	// Pipeline layout: objects and the camera come from the scene descriptor set, indexed by instance,
+	// the lights with their cluster lists from the lighting set, and the albedo texture from the texture set
+	VkDescriptorSetLayout setLayouts[] = { sceneSetLayout, lightingSetLayout, textureSetLayout };
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutInfo.setLayoutCount = 3;
+	pipelineLayoutInfo.pSetLayouts = setLayouts;
+	pipelineLayoutInfo.pushConstantRangeCount = 0;
+
+	if (vkCreatePipelineLayout(device.logicalDevice, &pipelineLayoutInfo, nullptr, &pipeline.pipelineLayout) != VK_SUCCESS) {
+		spdlog::critical("Failed to create pipeline layout");
+		return false;
+	}
+
+	// Render pass (assuming compatible with swap chain)
+	pipeline.renderPass = compatibleRenderPass;
+
+	// Graphics pipeline creation
+	VkGraphicsPipelineCreateInfo pipelineInfo{};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+	pipelineInfo.stageCount = 2; // Vertex and fragment shaders
+	pipelineInfo.pStages = nullptr; // To be filled later
+
+	// Fixed function states (simplified)
+	VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
+	inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+	inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+	inputAssembly.primitiveRestartEnable = VK_FALSE;
+
+	// Viewport and scissor follow the dynamic resolution, so they are set while recording
+	VkPipelineViewportStateCreateInfo viewportState{};
+	viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+	viewportState.viewportCount = 1;
+	viewportState.scissorCount = 1;
+
+	VkDynamicState dynamicStates[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+	VkPipelineDynamicStateCreateInfo dynamicState{};
+	dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+	dynamicState.dynamicStateCount = 2;
+	dynamicState.pDynamicStates = dynamicStates;
+
+	VkPipelineRasterizationStateCreateInfo rasterizer{};
+	rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+	rasterizer.depthClampEnable = VK_FALSE;
+	rasterizer.rasterizerDiscardEnable = VK_FALSE;
+	rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+	rasterizer.lineWidth = 1.0f;
+	rasterizer.cullMode = VK_CULL_MODE_BACK_BIT; // The mesh has a back of its own, so spinning triangles still show both faces
+	rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE; // Counter-clockwise in world space, through the Y-flipped projection
+	rasterizer.depthBiasEnable = VK_FALSE;
+
+	VkPipelineMultisampleStateCreateInfo multisampling{};
+	multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+	multisampling.sampleShadingEnable = VK_FALSE;
+	multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+	VkPipelineDepthStencilStateCreateInfo depthStencil{};
+	depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+	depthStencil.depthTestEnable = VK_TRUE;
+	depthStencil.depthWriteEnable = VK_TRUE;
+	depthStencil.depthCompareOp = VK_COMPARE_OP_LESS;
+	depthStencil.depthBoundsTestEnable = VK_FALSE;
+	depthStencil.stencilTestEnable = VK_FALSE;
+
+	VkPipelineColorBlendAttachmentState colorBlendAttachment{};
+	colorBlendAttachment.blendEnable = VK_FALSE;
+	colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+
+	VkPipelineColorBlendStateCreateInfo colorBlending{};
+	colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+	colorBlending.attachmentCount = 1;
+	colorBlending.pAttachments = &colorBlendAttachment;
+
+	// Assign shader stages to pipeline
+	VkPipelineShaderStageCreateInfo shaderStages[2] = {};
+
+	// Vertex shader stage
+	shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	shaderStages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+	shaderStages[0].module = vertShaderModule;
+	shaderStages[0].pName = "main";
+
+	// Fragment shader stage
+	shaderStages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	shaderStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+	shaderStages[1].module = fragShaderModule;
+	shaderStages[1].pName = "main";
+
+	pipelineInfo.pStages = shaderStages;
+
+	// Vertex input state
+	VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
+	vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+
+	VkVertexInputBindingDescription bindingDescription = getVertexBindingDescription();
+	std::vector<VkVertexInputAttributeDescription> attributeDescriptions = getVertexAttributeDescriptions();
+	vertexInputInfo.vertexBindingDescriptionCount = 1;
+	vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
+	vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
+	vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
+
+	pipelineInfo.pVertexInputState = &vertexInputInfo;
+
+	// Input assembly state
+	pipelineInfo.pInputAssemblyState = &inputAssembly;
+
+	// Viewport and scissor state
+	pipelineInfo.pViewportState = &viewportState;
+	pipelineInfo.pDynamicState = &dynamicState;
+
+	// Rasterization state
+	pipelineInfo.pRasterizationState = &rasterizer;
+
+	// Multisample state
+	pipelineInfo.pMultisampleState = &multisampling;
+
+	// Depth state
+	pipelineInfo.pDepthStencilState = &depthStencil;
+
+	// Color blend state
+	pipelineInfo.pColorBlendState = &colorBlending;
+
+	// Pipeline layout and render pass
+	pipelineInfo.layout = pipeline.pipelineLayout;
+	pipelineInfo.renderPass = pipeline.renderPass;
+	pipelineInfo.subpass = 0; // Assuming single subpass
+
+	if (vkCreateGraphicsPipelines(device.logicalDevice, device.pipelineCache, 1, &pipelineInfo, nullptr, &pipeline.graphicsPipeline) != VK_SUCCESS) {
+		spdlog::critical("Failed to create graphics pipeline");
+		return false;
+	}
+	device.debugUtils.SetObjectName(VK_OBJECT_TYPE_PIPELINE, pipeline.graphicsPipeline, "Scene");
+
+	// Cleanup shader modules if not managed by the pipeline
+	vkDestroyShaderModule(device.logicalDevice, vertShaderModule, nullptr);
+	vkDestroyShaderModule(device.logicalDevice, fragShaderModule, nullptr);
+
+	spdlog::info("Graphics pipeline created successfully");
+	return true;
 }
 
 void destroyVulkanPipeline(VulkanPipeline& pipeline, VulkanDevice& device) {
-    if (pipeline.graphicsPipeline != VK_NULL_HANDLE) {
-        vkDestroyPipeline(device.logicalDevice, pipeline.graphicsPipeline, nullptr);
-        pipeline.graphicsPipeline = VK_NULL_HANDLE;
-        spdlog::debug("Graphics pipeline destroyed");
-    }
-    if (pipeline.pipelineLayout != VK_NULL_HANDLE) {
-        vkDestroyPipelineLayout(device.logicalDevice, pipeline.pipelineLayout, nullptr);
-        pipeline.pipelineLayout = VK_NULL_HANDLE;
-        spdlog::debug("Pipeline layout destroyed");
-    }
-    // Render pass destruction is now managed separately
+	if (pipeline.graphicsPipeline != VK_NULL_HANDLE) {
+		vkDestroyPipeline(device.logicalDevice, pipeline.graphicsPipeline, nullptr);
+		pipeline.graphicsPipeline = VK_NULL_HANDLE;
+		spdlog::debug("Graphics pipeline destroyed");
+	}
+	if (pipeline.pipelineLayout != VK_NULL_HANDLE) {
+		vkDestroyPipelineLayout(device.logicalDevice, pipeline.pipelineLayout, nullptr);
+		pipeline.pipelineLayout = VK_NULL_HANDLE;
+		spdlog::debug("Pipeline layout destroyed");
+	}
+	// Render pass destruction is now managed separately
 }
 
 // Framebuffer Lifecycle
 bool createFramebuffers(VulkanSwapChain& swapChain, VulkanDevice& device, VkRenderPass renderPass) {
-    swapChain.framebuffers.resize(swapChain.imageViews.size());
-
-    for (size_t i = 0; i < swapChain.imageViews.size(); i++) {
-        VkFramebufferCreateInfo framebufferInfo{};
-        framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-        framebufferInfo.renderPass = renderPass;
-        framebufferInfo.attachmentCount = 1;
-        framebufferInfo.pAttachments = &swapChain.imageViews[i];
-        framebufferInfo.width = swapChain.extent.width;
-        framebufferInfo.height = swapChain.extent.height;
-        framebufferInfo.layers = 1;
-
-        if (vkCreateFramebuffer(device.logicalDevice, &framebufferInfo, nullptr, &swapChain.framebuffers[i]) != VK_SUCCESS) {
-            spdlog::critical("Failed to create framebuffer for swap chain image view {}", i);
-            return false;
-        }
-    }
+	swapChain.framebuffers.resize(swapChain.imageViews.size());
+
+	for (size_t i = 0; i < swapChain.imageViews.size(); i++) {
+		VkFramebufferCreateInfo framebufferInfo{};
+		framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+		// Every image renders into the same scene color target, which the upscale then copies to it
+		VkImageView attachments[] = { swapChain.sceneColorView, swapChain.depthImageView };
+
+		framebufferInfo.renderPass = renderPass;
+		framebufferInfo.attachmentCount = 2;
+		framebufferInfo.pAttachments = attachments;
+		framebufferInfo.width = swapChain.extent.width;
+		framebufferInfo.height = swapChain.extent.height;
+		framebufferInfo.layers = 1;
+
+		if (vkCreateFramebuffer(device.logicalDevice, &framebufferInfo, nullptr, &swapChain.framebuffers[i]) != VK_SUCCESS) {
+			spdlog::critical("Failed to create framebuffer for swap chain image view {}", i);
+			return false;
+		}
+	}
 
-    spdlog::info("Framebuffers created successfully");
-    return true;
+	spdlog::info("Framebuffers created successfully");
+	return true;
 }
 
 void destroyFramebuffers(VulkanSwapChain& swapChain, VulkanDevice& device) {
-    for (auto framebuffer : swapChain.framebuffers) {
-        if (framebuffer != VK_NULL_HANDLE) {
-            vkDestroyFramebuffer(device.logicalDevice, framebuffer, nullptr);
-        }
-    }
-    swapChain.framebuffers.clear();
-    spdlog::debug("Framebuffers destroyed");
+	for (auto framebuffer : swapChain.framebuffers) {
+		if (framebuffer != VK_NULL_HANDLE) {
+			vkDestroyFramebuffer(device.logicalDevice, framebuffer, nullptr);
+		}
+	}
+	swapChain.framebuffers.clear();
+	spdlog::debug("Framebuffers destroyed");
 }
 
 // Command Pool & Buffer Management
 bool createCommandPool(VulkanRenderer& renderer) {
-    // Create a command pool for the graphics queue
-    VkCommandPoolCreateInfo poolInfo{};
-    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-    poolInfo.queueFamilyIndex = renderer.device.graphicsQueueFamilyIndex;
-    poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT; // Allow command buffer to be reset
-
-    if (vkCreateCommandPool(renderer.device.logicalDevice, &poolInfo, nullptr, &renderer.commandPool) != VK_SUCCESS) {
-        spdlog::critical("Failed to create command pool");
-        return false;
-    }
+	// Create a command pool for the graphics queue
+	VkCommandPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	poolInfo.queueFamilyIndex = renderer.device.graphicsQueueFamilyIndex;
+	poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT; // Allow command buffer to be reset
+
+	if (vkCreateCommandPool(renderer.device.logicalDevice, &poolInfo, nullptr, &renderer.commandPool) != VK_SUCCESS) {
+		spdlog::critical("Failed to create command pool");
+		return false;
+	}
 
-    spdlog::debug("Command pool created successfully");
-    return true;
+	spdlog::debug("Command pool created successfully");
+	return true;
 }
 
 bool createCommandBuffers(VulkanRenderer& renderer) {
-    // Allocate command buffers from the command pool
-    renderer.commandBuffers.resize(renderer.synchronization.maxFramesInFlight);
-
-    VkCommandBufferAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    allocInfo.commandPool = renderer.commandPool;
-    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    allocInfo.commandBufferCount = static_cast<uint32_t>(renderer.commandBuffers.size());
+	// Allocate command buffers from the command pool. Each frame in flight gets one per swap chain image,
+	// so a recorded buffer always targets the same framebuffer and can be submitted again unchanged.
+	renderer.commandBuffers.resize(renderer.synchronization.maxFramesInFlight * renderer.swapChain.images.size());
+	renderer.recordedCommands.assign(renderer.commandBuffers.size(), RecordedCommands{});
+
+	VkCommandBufferAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocInfo.commandPool = renderer.commandPool;
+	allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocInfo.commandBufferCount = static_cast<uint32_t>(renderer.commandBuffers.size());
+
+	if (vkAllocateCommandBuffers(renderer.device.logicalDevice, &allocInfo, renderer.commandBuffers.data()) != VK_SUCCESS) {
+		spdlog::critical("Failed to allocate command buffers");
+		return false;
+	}
+	if (renderer.device.debugUtils.IsEnabled()) {
+		for (size_t i = 0; i < renderer.commandBuffers.size(); ++i) {
+			renderer.device.debugUtils.SetObjectName(VK_OBJECT_TYPE_COMMAND_BUFFER, renderer.commandBuffers[i], fmt::format("Frame commands {}", i).c_str());
+		}
+	}
 
-    if (vkAllocateCommandBuffers(renderer.device.logicalDevice, &allocInfo, renderer.commandBuffers.data()) != VK_SUCCESS) {
-        spdlog::critical("Failed to allocate command buffers");
-        return false;
-    }
+	spdlog::debug("Command buffers allocated successfully");
+	return true;
+}
 
-    spdlog::debug("Command buffers allocated successfully");
-    return true;
+void invalidateRecordedCommands(VulkanRenderer& renderer) {
+	++renderer.commandGeneration;
 }
 
 // Drawing Operations
 bool drawFrame(
-    VulkanRenderer& renderer,
-    VulkanPipeline& activePipeline,
-    VulkanMesh& meshToDraw
+	VulkanRenderer& renderer,
+	VulkanPipeline& activePipeline,
+	VulkanMesh& meshToDraw,
+	MiniEngine::Graphics::VulkanOcclusionCulling& occlusion,
+	MiniEngine::Graphics::VulkanClusteredLighting& lighting,
+	VulkanDynamicResolution& resolution,
+	MiniEngine::Graphics::VulkanParticleSystem& particles,
+	MiniEngine::Graphics::VulkanFrameReadback& readback,
+	VkDescriptorSet textureSet,
+	const DrawList& drawList
 ) {
-    // Wait for the previous frame to complete
-    vkWaitForFences(renderer.device.logicalDevice, 1, &renderer.synchronization.inFlightFences[renderer.synchronization.currentFrame], VK_TRUE, UINT64_MAX);    // Get the index of the next image to render to
-    uint32_t imageIndex;
-    // Since we have one semaphore per swap chain image, we can always use semaphore 0 to acquire the next image
-    // After acquisition, we'll use the semaphore corresponding to the acquired image index
-    VkResult result = vkAcquireNextImageKHR(renderer.device.logicalDevice, renderer.swapChain.handle, UINT64_MAX,
-                                           renderer.synchronization.imageAvailableSemaphores[0],
-                                           VK_NULL_HANDLE, &imageIndex);
-    
-    if (result == VK_ERROR_OUT_OF_DATE_KHR) {
-        spdlog::warn("Swap chain out of date, recreate swap chain");
-        // Handle swap chain recreation (signal a flag, call recreateSwapChain, etc.)
-        return false;
-    } else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
-        spdlog::critical("Failed to acquire swap chain image");
-        return false;
-    }
-
-    // Check if a previous frame is using this image (i.e. there is its fence to wait on)
-    if (renderer.synchronization.imagesInFlight[imageIndex] != VK_NULL_HANDLE) {
-        vkWaitForFences(renderer.device.logicalDevice, 1, &renderer.synchronization.imagesInFlight[imageIndex], VK_TRUE, UINT64_MAX);
-    }
-    // Mark the image as now being in use by this frame
-    renderer.synchronization.imagesInFlight[imageIndex] = renderer.synchronization.inFlightFences[renderer.synchronization.currentFrame];
-
-    // Reset the fence for the current frame
-    vkResetFences(renderer.device.logicalDevice, 1, &renderer.synchronization.inFlightFences[renderer.synchronization.currentFrame]);
-
-    // Reset the command buffer for this frame
-    vkResetCommandBuffer(renderer.commandBuffers[renderer.synchronization.currentFrame], 0);
-
-    // Record commands for this frame
-    recordCommandBuffer(renderer.commandBuffers[renderer.synchronization.currentFrame], imageIndex, renderer, activePipeline, meshToDraw);    // Submit the command buffer for execution
-    VkSubmitInfo submitInfo{};
-    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;    // Wait for the imageAvailable semaphore that we used to acquire the image (always semaphore 0)
-    VkSemaphore waitSemaphores[] = {renderer.synchronization.imageAvailableSemaphores[0]};
-    VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-    submitInfo.waitSemaphoreCount = 1;
-    submitInfo.pWaitSemaphores = waitSemaphores;
-    submitInfo.pWaitDstStageMask = waitStages;
-    
-    // Command buffer to submit
-    submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &renderer.commandBuffers[renderer.synchronization.currentFrame];    // Signal the renderFinished semaphore for the specific image
-    VkSemaphore signalSemaphores[] = {renderer.synchronization.renderFinishedSemaphores[imageIndex]};
-    submitInfo.signalSemaphoreCount = 1;
-    submitInfo.pSignalSemaphores = signalSemaphores;
-      // Submit the command buffer
-    if (vkQueueSubmit(renderer.device.graphicsQueue, 1, &submitInfo, 
-                     renderer.synchronization.inFlightFences[renderer.synchronization.currentFrame]) != VK_SUCCESS) {
-        spdlog::critical("Failed to submit draw command buffer");
-        return false;
-    }
-
-    // Present the image
-    VkPresentInfoKHR presentInfo{};
-    presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;    presentInfo.waitSemaphoreCount = 1;
-    presentInfo.pWaitSemaphores = &renderer.synchronization.renderFinishedSemaphores[imageIndex];
-    presentInfo.swapchainCount = 1;
-    presentInfo.pSwapchains = &renderer.swapChain.handle;
-    presentInfo.pImageIndices = &imageIndex;
-
-    result = vkQueuePresentKHR(renderer.device.presentQueue, &presentInfo);
-	
+	// Wait for the previous frame to complete
+	vkWaitForFences(renderer.device.logicalDevice, 1, &renderer.synchronization.inFlightFences[renderer.synchronization.currentFrame], VK_TRUE, UINT64_MAX);
+
+	// This frame's resources are idle now: collect what their last submission measured, then refill them
+	const uint32_t frameIndex = renderer.synchronization.currentFrame;
+	VulkanResolutionFrame& resolutionFrame = resolution.frames[renderer.synchronization.currentFrame];
+	readResolutionResults(resolutionFrame, resolution, renderer.device, renderer.swapChain.extent);
+	if (particles.GetCapacity() > 0) {
+		particles.ReadResults(frameIndex);
+	}
+	renderer.device.memory.UpdateBudget(renderer.synchronization.currentFrame);
+	readback.ReadResults(frameIndex);
+
+	// Occlusion culling fills in the rest of the uniforms and uploads them with the objects
+	MiniEngine::Graphics::OcclusionUniforms uniforms{};
+	uniforms.viewProjection = drawList.viewProjection;
+	uniforms.lodCount = static_cast<uint32_t>(std::min<size_t>(meshToDraw.lods.size(), MaxMeshLods));
+	for (uint32_t level = 0; level < uniforms.lodCount; ++level) {
+		const glm::uvec2 meshlets = level < meshToDraw.lodMeshlets.size() ? meshToDraw.lodMeshlets[level] : glm::uvec2(0, 0);
+		uniforms.lods[level] = glm::uvec4(meshToDraw.lods[level].indexCount, meshToDraw.lods[level].firstIndex, meshlets.x, meshlets.y);
+	}
+	const MiniEngine::Scene::Frustum frustum = MiniEngine::Scene::Frustum::FromMatrix(drawList.viewProjection);
+	std::copy(frustum.planes.begin(), frustum.planes.end(), uniforms.frustumPlanes);
+	uniforms.cameraPosition = glm::inverse(drawList.view)[3];
+	uniforms.renderScale = glm::vec2(
+		static_cast<float>(resolution.renderExtent.width) / static_cast<float>(renderer.swapChain.extent.width),
+		static_cast<float>(resolution.renderExtent.height) / static_cast<float>(renderer.swapChain.extent.height));
+	if (!occlusion.PrepareFrame(frameIndex, drawList.objects, uniforms)) {
+		return false;
+	}
+
+	MiniEngine::Graphics::LightingCamera camera;
+	camera.view = drawList.view;
+	camera.projection = drawList.projection;
+	camera.nearPlane = drawList.nearPlane;
+	camera.farPlane = drawList.farPlane;
+	if (!lighting.PrepareFrame(frameIndex, drawList.lights, camera, resolution.renderExtent)) {
+		return false;
+	}
+	resolutionFrame.renderExtent = resolution.renderExtent;
+	// Get the index of the next image to render to
+	uint32_t imageIndex;
+	// Since we have one semaphore per swap chain image, we can always use semaphore 0 to acquire the next image
+	// After acquisition, we'll use the semaphore corresponding to the acquired image index
+	VkResult result = vkAcquireNextImageKHR(renderer.device.logicalDevice, renderer.swapChain.handle, UINT64_MAX,
+		renderer.synchronization.imageAvailableSemaphores[0],
+		VK_NULL_HANDLE, &imageIndex);
+
+	if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+		MINIENGINE_LOG_WARN_RATE_LIMITED(1000, "Swap chain out of date, recreate swap chain");
+		// Handle swap chain recreation (signal a flag, call recreateSwapChain, etc.)
+		invalidateRecordedCommands(renderer);
+		return false;
+	} else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
+		spdlog::critical("Failed to acquire swap chain image");
+		return false;
+	}
+
+	// Check if a previous frame is using this image (i.e. there is its fence to wait on)
+	if (renderer.synchronization.imagesInFlight[imageIndex] != VK_NULL_HANDLE) {
+		vkWaitForFences(renderer.device.logicalDevice, 1, &renderer.synchronization.imagesInFlight[imageIndex], VK_TRUE, UINT64_MAX);
+	}
+	// Mark the image as now being in use by this frame
+	renderer.synchronization.imagesInFlight[imageIndex] = renderer.synchronization.inFlightFences[renderer.synchronization.currentFrame];
+
+	// Reset the fence for the current frame
+	vkResetFences(renderer.device.logicalDevice, 1, &renderer.synchronization.inFlightFences[renderer.synchronization.currentFrame]);
+
+	// Particles simulate on the compute queue while the graphics queue may still be busy with the previous frame.
+	// Submitted only once the image is acquired, so the graphics submission below always consumes the semaphore.
+	if (particles.GetCapacity() > 0 && !particles.Simulate(frameIndex, drawList.view, drawList.viewProjection)) {
+		return false;
+	}
+
+	// Per-frame data lives in buffers, so commands only need recording again when the target image, the
+	// render resolution, the buffer sizes, the occlusion or lighting mode, the texture or something invalidating the renderer changed
+	const auto recordStart = std::chrono::steady_clock::now();
+	const size_t commandIndex = renderer.synchronization.currentFrame * renderer.swapChain.images.size() + imageIndex;
+	VkCommandBuffer commandBuffer = renderer.commandBuffers[commandIndex];
+	RecordedCommands& recorded = renderer.recordedCommands[commandIndex];
+
+	bool reusable = renderer.reuseCommandBuffers
+		&& recorded.generation == renderer.commandGeneration
+		&& recorded.objectCapacity == occlusion.GetObjectCapacity(frameIndex)
+		&& recorded.lightCapacity == lighting.GetLightCapacity(frameIndex)
+		&& recorded.renderExtent.width == resolutionFrame.renderExtent.width
+		&& recorded.renderExtent.height == resolutionFrame.renderExtent.height
+		&& recorded.occlusionEnabled == occlusion.IsEnabledFor(frameIndex)
+		&& recorded.clusteredLighting == lighting.IsClusteredFor(frameIndex)
+		&& recorded.textureSet == textureSet;
+
+	if (reusable) {
+		++renderer.recordingStats.reused;
+	} else {
+		vkResetCommandBuffer(commandBuffer, 0);
+		recordCommandBuffer(commandBuffer, imageIndex, renderer, activePipeline, meshToDraw, occlusion, lighting, resolution, particles, textureSet);
+
+		recorded.generation = renderer.commandGeneration;
+		recorded.objectCapacity = occlusion.GetObjectCapacity(frameIndex);
+		recorded.lightCapacity = lighting.GetLightCapacity(frameIndex);
+		recorded.renderExtent = resolutionFrame.renderExtent;
+		recorded.occlusionEnabled = occlusion.IsEnabledFor(frameIndex);
+		recorded.clusteredLighting = lighting.IsClusteredFor(frameIndex);
+		recorded.textureSet = textureSet;
+		++renderer.recordingStats.recorded;
+	}
+
+	// Captured frames copy the presented image out in a command buffer of their own
+	VkCommandBuffer commandBuffers[2] = { commandBuffer, readback.Record(frameIndex, renderer.swapChain.images[imageIndex], renderer.swapChain.extent) };
+
+	// Submit the command buffer for execution
+	VkSubmitInfo submitInfo{};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+
+	// Wait for the imageAvailable semaphore that we used to acquire the image (always semaphore 0).
+	// The upscale blit is the first and only thing touching the swap chain image
+	VkSemaphore waitSemaphores[2] = {renderer.synchronization.imageAvailableSemaphores[0]};
+	VkPipelineStageFlags waitStages[2] = {VK_PIPELINE_STAGE_TRANSFER_BIT};
+	submitInfo.waitSemaphoreCount = 1;
+
+	// And for this frame's async compute work, only at the stage that consumes its results
+	if (renderer.device.queues.TakeComputeWait(renderer.synchronization.currentFrame, waitSemaphores[1], waitStages[1])) {
+		submitInfo.waitSemaphoreCount = 2;
+	}
+	submitInfo.pWaitSemaphores = waitSemaphores;
+	submitInfo.pWaitDstStageMask = waitStages;
+
+	// Command buffer to submit
+	submitInfo.commandBufferCount = commandBuffers[1] != VK_NULL_HANDLE ? 2 : 1;
+	submitInfo.pCommandBuffers = commandBuffers;
+
+	// Signal the renderFinished semaphore for the specific image
+	VkSemaphore signalSemaphores[] = {renderer.synchronization.renderFinishedSemaphores[imageIndex]};
+	submitInfo.signalSemaphoreCount = 1;
+	submitInfo.pSignalSemaphores = signalSemaphores;
+
+	// Submit the command buffer
+	if (vkQueueSubmit(renderer.device.graphicsQueue, 1, &submitInfo,
+		renderer.synchronization.inFlightFences[renderer.synchronization.currentFrame]) != VK_SUCCESS) {
+		spdlog::critical("Failed to submit draw command buffer");
+		return false;
+	}
+	occlusion.MarkSubmitted(frameIndex);
+	lighting.MarkSubmitted(frameIndex);
+	resolutionFrame.submitted = true;
+
+	CommandRecordingStats& recordingStats = renderer.recordingStats;
+	const double recordMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - recordStart).count();
+	const int mode = renderer.reuseCommandBuffers ? 1 : 0;
+	recordingStats.cpuMs[mode] = recordingStats.samples[mode] == 0 ? recordMs : recordingStats.cpuMs[mode] + (recordMs - recordingStats.cpuMs[mode]) * 0.05;
+	++recordingStats.samples[mode];
+
+	// Present the image
+	VkPresentInfoKHR presentInfo{};
+	presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+	presentInfo.waitSemaphoreCount = 1;
+	presentInfo.pWaitSemaphores = &renderer.synchronization.renderFinishedSemaphores[imageIndex];
+	presentInfo.swapchainCount = 1;
+	presentInfo.pSwapchains = &renderer.swapChain.handle;
+	presentInfo.pImageIndices = &imageIndex;
+
+	result = vkQueuePresentKHR(renderer.device.presentQueue, &presentInfo);
+
 	if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
-        spdlog::warn("Swap chain out of date or suboptimal, recreate swap chain");
-        // Handle swap chain recreation
-        return false;
-    } else if (result != VK_SUCCESS) {
-        spdlog::critical("Failed to present swap chain image");
-        return false;
-    }
+		MINIENGINE_LOG_WARN_RATE_LIMITED(1000, "Swap chain out of date or suboptimal, recreate swap chain");
+		// Handle swap chain recreation
+		invalidateRecordedCommands(renderer);
+		return false;
+	} else if (result != VK_SUCCESS) {
+		spdlog::critical("Failed to present swap chain image");
+		return false;
+	}
 
-    // Move to the next frame
-    renderer.synchronization.currentFrame = (renderer.synchronization.currentFrame + 1) % renderer.synchronization.maxFramesInFlight;
+	// Move to the next frame
+	renderer.synchronization.currentFrame = (renderer.synchronization.currentFrame + 1) % renderer.synchronization.maxFramesInFlight;
 
-    return true;
+	return true;
 }
 
 void recordCommandBuffer(
-    VkCommandBuffer commandBuffer,
-    uint32_t imageIndex,
-    VulkanRenderer& renderer,
-    VulkanPipeline& activePipeline,
-    VulkanMesh& meshToDraw
+	VkCommandBuffer commandBuffer,
+	uint32_t imageIndex,
+	VulkanRenderer& renderer,
+	VulkanPipeline& activePipeline,
+	VulkanMesh& meshToDraw,
+	MiniEngine::Graphics::VulkanOcclusionCulling& occlusion,
+	MiniEngine::Graphics::VulkanClusteredLighting& lighting,
+	VulkanDynamicResolution& resolution,
+	MiniEngine::Graphics::VulkanParticleSystem& particles,
+	VkDescriptorSet textureSet
 ) {
-    // Begin command buffer recording
-    VkCommandBufferBeginInfo beginInfo{};
-    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-    beginInfo.flags = 0; // Optional: VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-
-    if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
-        spdlog::critical("Failed to begin recording command buffer");
-        return;
-    }
-
-    // Begin render pass
-    VkRenderPassBeginInfo renderPassInfo{};
-    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-    renderPassInfo.renderPass = activePipeline.renderPass;
-    renderPassInfo.framebuffer = renderer.swapChain.framebuffers[imageIndex];
-    renderPassInfo.renderArea.offset = {0, 0};
-    renderPassInfo.renderArea.extent = renderer.swapChain.extent;
-    
-    // Set clear color to dark gray (RGBA in normalized floats: 0.2, 0.2, 0.2, 1.0)
-    VkClearValue clearColor{};
-    clearColor.color = {0.2f, 0.2f, 0.2f, 1.0f};
-    
-    renderPassInfo.clearValueCount = 1;
-    renderPassInfo.pClearValues = &clearColor;
-    
-    vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-    
-    // If we have a valid pipeline and mesh, draw it
-    if (activePipeline.graphicsPipeline != VK_NULL_HANDLE && meshToDraw.vertexCount > 0) {
-        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, activePipeline.graphicsPipeline);
-        
-        VkBuffer vertexBuffers[] = {meshToDraw.vertexBuffer};
-        VkDeviceSize offsets[] = {0};
-        vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
-        
-        vkCmdDraw(commandBuffer, meshToDraw.vertexCount, 1, 0, 0);
-    }
-    
-    vkCmdEndRenderPass(commandBuffer);
-    
-    // End command buffer recording
-    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
-        spdlog::critical("Failed to record command buffer");
-        return;
-    }
-
-    spdlog::debug("Command buffer recorded successfully for image index {}", imageIndex);
-}
\ No newline at end of file
+	// Begin command buffer recording
+	VkCommandBufferBeginInfo beginInfo{};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = 0; // Optional: VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+	if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+		spdlog::critical("Failed to begin recording command buffer");
+		return;
+	}
+
+	MiniEngine::Graphics::VulkanCommandEncoder& encoder = renderer.commandEncoder;
+	encoder.Begin(commandBuffer);
+
+	// Regions for capture tools; recorded only when the instrumentation level includes labels
+	const MiniEngine::Graphics::VulkanDebugUtils& debugUtils = renderer.device.debugUtils;
+
+	// The resolution timestamps bracket the whole frame, so the scale adapts to all of its GPU time
+	VulkanResolutionFrame& resolutionFrame = resolution.frames[renderer.synchronization.currentFrame];
+	if (resolution.timestampPeriod > 0.0f) {
+		vkCmdResetQueryPool(commandBuffer, resolutionFrame.timestampPool, 0, ResolutionTimestampCount);
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, resolutionFrame.timestampPool, ResolutionTimestampFrameBegin);
+	}
+
+	// Lights are binned first; nothing reads the cluster lists before the first render pass
+	const uint32_t frameIndex = renderer.synchronization.currentFrame;
+	debugUtils.BeginLabel(commandBuffer, "Light binning");
+	lighting.RecordBinning(encoder, frameIndex);
+	debugUtils.EndLabel(commandBuffer);
+
+	const VkDescriptorSet lightingSet = lighting.GetDescriptorSet(frameIndex);
+	const VkDescriptorSet sceneSet = occlusion.GetSceneSet(frameIndex);
+	const bool occlusionEnabled = occlusion.IsEnabledFor(frameIndex);
+	const bool drawable = activePipeline.graphicsPipeline != VK_NULL_HANDLE && meshToDraw.indexCount > 0 && !meshToDraw.lods.empty()
+		&& occlusion.GetObjectCapacity(frameIndex) > 0;
+
+	// Phase 1: test against the pyramid from the previous frame
+	occlusion.RecordPhase1(encoder, frameIndex);
+
+	// Begin render pass
+	VkRenderPassBeginInfo renderPassInfo{};
+	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+	renderPassInfo.renderPass = activePipeline.renderPass;
+	renderPassInfo.framebuffer = renderer.swapChain.framebuffers[imageIndex];
+	renderPassInfo.renderArea.offset = {0, 0};
+	renderPassInfo.renderArea.extent = renderer.swapChain.extent;
+
+	// Set clear color to dark gray (RGBA in normalized floats: 0.2, 0.2, 0.2, 1.0) and depth to the far plane
+	VkClearValue clearValues[2]{};
+	clearValues[0].color = {0.2f, 0.2f, 0.2f, 1.0f};
+	clearValues[1].depthStencil = {1.0f, 0};
+
+	renderPassInfo.clearValueCount = 2;
+	renderPassInfo.pClearValues = clearValues;
+
+	VkBuffer vertexBuffers[] = {meshToDraw.vertexBuffer};
+	VkDeviceSize offsets[] = {0};
+
+	debugUtils.BeginLabel(commandBuffer, "Scene, phase 1");
+	vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+	// The render area clears the whole target, so the depth outside the scaled viewport reads as far
+	// plane in the Hi-Z pyramid. Drawing only covers the top-left part the upscale reads from.
+	VkViewport viewport{};
+	viewport.width = static_cast<float>(resolutionFrame.renderExtent.width);
+	viewport.height = static_cast<float>(resolutionFrame.renderExtent.height);
+	viewport.maxDepth = 1.0f;
+	VkRect2D scissor{};
+	scissor.extent = resolutionFrame.renderExtent;
+	encoder.SetViewport(0, 1, &viewport);
+	encoder.SetScissor(0, 1, &scissor);
+
+	// Draw what phase 1 kept; culled objects and meshlets emitted no draw and never reach the rasterizer
+	if (drawable) {
+		encoder.BindPipeline(VK_PIPELINE_BIND_POINT_GRAPHICS, activePipeline.graphicsPipeline);
+		encoder.BindDescriptorSets(VK_PIPELINE_BIND_POINT_GRAPHICS, activePipeline.pipelineLayout, 0, 1, &sceneSet);
+		encoder.BindDescriptorSets(VK_PIPELINE_BIND_POINT_GRAPHICS, activePipeline.pipelineLayout, 1, 1, &lightingSet);
+		encoder.BindDescriptorSets(VK_PIPELINE_BIND_POINT_GRAPHICS, activePipeline.pipelineLayout, 2, 1, &textureSet);
+		encoder.BindVertexBuffers(0, 1, vertexBuffers, offsets);
+		encoder.BindIndexBuffer(meshToDraw.indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+		occlusion.RecordDraws(encoder, frameIndex, 0);
+	}
+
+	vkCmdEndRenderPass(commandBuffer);
+	debugUtils.EndLabel(commandBuffer);
+
+	// Phase 2: rebuild the pyramid from this frame's depth and retest what phase 1 rejected
+	occlusion.RecordPhase2(encoder, frameIndex);
+
+	renderPassInfo.renderPass = activePipeline.loadRenderPass;
+	renderPassInfo.clearValueCount = 0;
+	renderPassInfo.pClearValues = nullptr;
+
+	debugUtils.BeginLabel(commandBuffer, "Scene, phase 2 and particles");
+	vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+	if (drawable && occlusionEnabled) {
+		encoder.BindPipeline(VK_PIPELINE_BIND_POINT_GRAPHICS, activePipeline.graphicsPipeline);
+		encoder.BindDescriptorSets(VK_PIPELINE_BIND_POINT_GRAPHICS, activePipeline.pipelineLayout, 0, 1, &sceneSet);
+		encoder.BindDescriptorSets(VK_PIPELINE_BIND_POINT_GRAPHICS, activePipeline.pipelineLayout, 1, 1, &lightingSet);
+		encoder.BindDescriptorSets(VK_PIPELINE_BIND_POINT_GRAPHICS, activePipeline.pipelineLayout, 2, 1, &textureSet);
+		encoder.BindVertexBuffers(0, 1, vertexBuffers, offsets);
+		encoder.BindIndexBuffer(meshToDraw.indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+		occlusion.RecordDraws(encoder, frameIndex, 1);
+	}
+
+	// Particles go last, tested against the finished depth without writing it. The indirect draw
+	// holds this frame's survivor count, so the recording stays valid as the population changes.
+	if (particles.GetCapacity() > 0) {
+		particles.RecordDraw(encoder, frameIndex);
+	}
+
+	vkCmdEndRenderPass(commandBuffer);
+	debugUtils.EndLabel(commandBuffer);
+
+	occlusion.RecordFrameEnd(commandBuffer, frameIndex);
+	lighting.RecordFrameEnd(commandBuffer, frameIndex);
+
+	debugUtils.BeginLabel(commandBuffer, "Upscale");
+	recordUpscale(commandBuffer, resolution, resolutionFrame, renderer.swapChain, imageIndex);
+	debugUtils.EndLabel(commandBuffer);
+
+	// Make the counters visible to the host once the fence signals
+	VkMemoryBarrier readbackBarrier{};
+	readbackBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	readbackBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	readbackBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &readbackBarrier, 0, nullptr, 0, nullptr);
+
+	// End command buffer recording
+	if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+		spdlog::critical("Failed to record command buffer");
+		return;
+	}
+
+	MINIENGINE_LOG_DEBUG_RATE_LIMITED(1000, "Command buffer recorded successfully for image index {}", imageIndex);
+}
+
+// -----------------------------------------------------------------------------
+// Depth & Occlusion Culling
+// -----------------------------------------------------------------------------
+bool createDepthResources(VulkanSwapChain& swapChain, VulkanDevice& device) {
+	// The depth buffer is sampled when building the Hi-Z pyramid, so the format must allow both
+	const VkFormat candidates[] = { VK_FORMAT_D32_SFLOAT, VK_FORMAT_D16_UNORM };
+	const VkFormatFeatureFlags requiredFeatures = VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT;
+
+	swapChain.depthFormat = VK_FORMAT_UNDEFINED;
+	for (VkFormat candidate : candidates) {
+		VkFormatProperties properties;
+		vkGetPhysicalDeviceFormatProperties(device.physicalDevice, candidate, &properties);
+		if ((properties.optimalTilingFeatures & requiredFeatures) == requiredFeatures) {
+			swapChain.depthFormat = candidate;
+			break;
+		}
+	}
+
+	if (swapChain.depthFormat == VK_FORMAT_UNDEFINED) {
+		spdlog::critical("No depth format supports both depth attachments and sampling");
+		return false;
+	}
+
+	VkImageCreateInfo imageInfo{};
+	imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	imageInfo.imageType = VK_IMAGE_TYPE_2D;
+	imageInfo.format = swapChain.depthFormat;
+	imageInfo.extent = { swapChain.extent.width, swapChain.extent.height, 1 };
+	imageInfo.mipLevels = 1;
+	imageInfo.arrayLayers = 1;
+	imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+	imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+	imageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+	imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+	if (!device.memory.CreateImage(imageInfo, MiniEngine::Graphics::MemoryCategory::RenderTargets, swapChain.depthImage, swapChain.depthImageAllocation)) {
+		spdlog::critical("Failed to create depth image");
+		return false;
+	}
+	device.debugUtils.SetObjectName(VK_OBJECT_TYPE_IMAGE, swapChain.depthImage, "Depth");
+
+	VkImageViewCreateInfo viewInfo{};
+	viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	viewInfo.image = swapChain.depthImage;
+	viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	viewInfo.format = swapChain.depthFormat;
+	viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+	viewInfo.subresourceRange.baseMipLevel = 0;
+	viewInfo.subresourceRange.levelCount = 1;
+	viewInfo.subresourceRange.baseArrayLayer = 0;
+	viewInfo.subresourceRange.layerCount = 1;
+
+	if (vkCreateImageView(device.logicalDevice, &viewInfo, nullptr, &swapChain.depthImageView) != VK_SUCCESS) {
+		spdlog::critical("Failed to create depth image view");
+		return false;
+	}
+
+	spdlog::debug("Depth buffer created ({}x{}, format {})", swapChain.extent.width, swapChain.extent.height, static_cast<int>(swapChain.depthFormat));
+	return true;
+}
+
+void destroyDepthResources(VulkanSwapChain& swapChain, VulkanDevice& device) {
+	if (swapChain.depthImageView != VK_NULL_HANDLE) {
+		vkDestroyImageView(device.logicalDevice, swapChain.depthImageView, nullptr);
+		swapChain.depthImageView = VK_NULL_HANDLE;
+	}
+	if (swapChain.depthImage != VK_NULL_HANDLE) {
+		device.memory.DestroyImage(swapChain.depthImage, swapChain.depthImageAllocation);
+		swapChain.depthImage = VK_NULL_HANDLE;
+		swapChain.depthImageAllocation = VK_NULL_HANDLE;
+	}
+	swapChain.depthFormat = VK_FORMAT_UNDEFINED;
+}
+
+bool executeImmediateCommands(VulkanRenderer& renderer, const std::function<void(VkCommandBuffer)>& record) {
+	VkCommandBufferAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocInfo.commandPool = renderer.commandPool;
+	allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocInfo.commandBufferCount = 1;
+
+	VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+	if (vkAllocateCommandBuffers(renderer.device.logicalDevice, &allocInfo, &commandBuffer) != VK_SUCCESS) {
+		spdlog::critical("Failed to allocate an immediate command buffer");
+		return false;
+	}
+
+	VkCommandBufferBeginInfo beginInfo{};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+	vkBeginCommandBuffer(commandBuffer, &beginInfo);
+	record(commandBuffer);
+	vkEndCommandBuffer(commandBuffer);
+
+	VkSubmitInfo submitInfo{};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &commandBuffer;
+
+	bool success = vkQueueSubmit(renderer.device.graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE) == VK_SUCCESS
+		&& vkQueueWaitIdle(renderer.device.graphicsQueue) == VK_SUCCESS;
+
+	vkFreeCommandBuffers(renderer.device.logicalDevice, renderer.commandPool, 1, &commandBuffer);
+
+	if (!success) {
+		spdlog::critical("Failed to execute immediate commands");
+	}
+	return success;
+}
+
+MiniEngine::Graphics::VulkanContext createVulkanContext(VulkanRenderer& renderer) {
+	MiniEngine::Graphics::VulkanContext context;
+	context.physicalDevice = renderer.device.physicalDevice;
+	context.device = renderer.device.logicalDevice;
+	context.pipelineCache = renderer.device.pipelineCache;
+	context.framesInFlight = renderer.synchronization.maxFramesInFlight;
+	context.memory = &renderer.device.memory;
+	context.queues = &renderer.device.queues;
+	context.debugUtils = &renderer.device.debugUtils;
+	context.loadShader = [&renderer](const std::string& path) { return readShaderFile(renderer.device, path); };
+	context.executeImmediate = [&renderer](const std::function<void(VkCommandBuffer)>& record) { return executeImmediateCommands(renderer, record); };
+	return context;
+}
+
+// -----------------------------------------------------------------------------
+// Dynamic Resolution
+// -----------------------------------------------------------------------------
+// The scene color has the swap chain's size and format, so at full scale the upscale is a plain copy
+bool createSceneColorResources(VulkanSwapChain& swapChain, VulkanDevice& device) {
+	const VkFormatFeatureFlags requiredFeatures = VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT | VK_FORMAT_FEATURE_BLIT_SRC_BIT
+		| VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+
+	VkFormatProperties properties;
+	vkGetPhysicalDeviceFormatProperties(device.physicalDevice, swapChain.imageFormat, &properties);
+	if ((properties.optimalTilingFeatures & requiredFeatures) != requiredFeatures) {
+		spdlog::critical("The swap chain format does not support filtered blits, needed to upscale the scene");
+		return false;
+	}
+
+	VkImageCreateInfo imageInfo{};
+	imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	imageInfo.imageType = VK_IMAGE_TYPE_2D;
+	imageInfo.format = swapChain.imageFormat;
+	imageInfo.extent = { swapChain.extent.width, swapChain.extent.height, 1 };
+	imageInfo.mipLevels = 1;
+	imageInfo.arrayLayers = 1;
+	imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+	imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+	imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+	imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+	if (!device.memory.CreateImage(imageInfo, MiniEngine::Graphics::MemoryCategory::RenderTargets, swapChain.sceneColorImage, swapChain.sceneColorAllocation)) {
+		spdlog::critical("Failed to create scene color image");
+		return false;
+	}
+	device.debugUtils.SetObjectName(VK_OBJECT_TYPE_IMAGE, swapChain.sceneColorImage, "Scene color");
+
+	VkImageViewCreateInfo viewInfo{};
+	viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	viewInfo.image = swapChain.sceneColorImage;
+	viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	viewInfo.format = swapChain.imageFormat;
+	viewInfo.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+
+	if (vkCreateImageView(device.logicalDevice, &viewInfo, nullptr, &swapChain.sceneColorView) != VK_SUCCESS) {
+		spdlog::critical("Failed to create scene color image view");
+		return false;
+	}
+
+	spdlog::debug("Scene color target created ({}x{})", swapChain.extent.width, swapChain.extent.height);
+	return true;
+}
+
+void destroySceneColorResources(VulkanSwapChain& swapChain, VulkanDevice& device) {
+	if (swapChain.sceneColorView != VK_NULL_HANDLE) {
+		vkDestroyImageView(device.logicalDevice, swapChain.sceneColorView, nullptr);
+		swapChain.sceneColorView = VK_NULL_HANDLE;
+	}
+	if (swapChain.sceneColorImage != VK_NULL_HANDLE) {
+		device.memory.DestroyImage(swapChain.sceneColorImage, swapChain.sceneColorAllocation);
+		swapChain.sceneColorImage = VK_NULL_HANDLE;
+		swapChain.sceneColorAllocation = VK_NULL_HANDLE;
+	}
+}
+
+bool createDynamicResolution(VulkanDynamicResolution& resolution, VulkanRenderer& renderer) {
+	VulkanDevice& device = renderer.device;
+
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(device.physicalDevice, &properties);
+
+	uint32_t queueFamilyCount = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(device.physicalDevice, &queueFamilyCount, nullptr);
+	std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+	vkGetPhysicalDeviceQueueFamilyProperties(device.physicalDevice, &queueFamilyCount, queueFamilies.data());
+
+	if (queueFamilies[device.graphicsQueueFamilyIndex].timestampValidBits > 0) {
+		resolution.timestampPeriod = properties.limits.timestampPeriod;
+	} else if (resolution.enabled) {
+		spdlog::warn("No GPU timestamps on the graphics queue, dynamic resolution stays at full scale");
+	}
+
+	resolution.frames.resize(renderer.synchronization.maxFramesInFlight);
+	if (resolution.timestampPeriod > 0.0f) {
+		for (VulkanResolutionFrame& frame : resolution.frames) {
+			VkQueryPoolCreateInfo queryPoolInfo{};
+			queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+			queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+			queryPoolInfo.queryCount = ResolutionTimestampCount;
+
+			if (vkCreateQueryPool(device.logicalDevice, &queryPoolInfo, nullptr, &frame.timestampPool) != VK_SUCCESS) {
+				spdlog::critical("Failed to create resolution timestamp query pool");
+				return false;
+			}
+		}
+	}
+
+	setRenderScale(resolution, 1.0f, renderer.swapChain.extent);
+	return true;
+}
+
+// Snaps the scale to a whole step between the minimum and full resolution
+void setRenderScale(VulkanDynamicResolution& resolution, float scale, VkExtent2D targetExtent) {
+	const float steps = std::round(std::clamp(scale, VulkanDynamicResolution::MinScale, 1.0f) / VulkanDynamicResolution::ScaleStep);
+	resolution.scale = std::min(steps * VulkanDynamicResolution::ScaleStep, 1.0f);
+	resolution.renderExtent.width = std::max(1u, static_cast<uint32_t>(std::lround(targetExtent.width * resolution.scale)));
+	resolution.renderExtent.height = std::max(1u, static_cast<uint32_t>(std::lround(targetExtent.height * resolution.scale)));
+	resolution.overBudgetFrames = 0;
+	resolution.headroomFrames = 0;
+	resolution.stats.minScale = std::min(resolution.stats.minScale, resolution.scale);
+}
+
+// Collects the GPU time of the frame's previous submission and adapts the scale to it; the frame's fence must have signaled
+void readResolutionResults(VulkanResolutionFrame& frame, VulkanDynamicResolution& resolution, VulkanDevice& device, VkExtent2D targetExtent) {
+	if (!frame.submitted || resolution.timestampPeriod <= 0.0f) {
+		return;
+	}
+
+	uint64_t timestamps[ResolutionTimestampCount];
+	if (vkGetQueryPoolResults(device.logicalDevice, frame.timestampPool, 0, ResolutionTimestampCount, sizeof(timestamps), timestamps,
+		sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) != VK_SUCCESS) {
+		return;
+	}
+
+	const double frameMs = (timestamps[ResolutionTimestampFrameEnd] - timestamps[ResolutionTimestampFrameBegin]) * (resolution.timestampPeriod / 1e6);
+	DynamicResolutionStats& stats = resolution.stats;
+	stats.gpuFrameMs = stats.gpuFrameMs == 0.0 ? frameMs : stats.gpuFrameMs + (frameMs - stats.gpuFrameMs) * 0.05;
+
+	// Frames recorded before the last change measure the old resolution and must not trigger another one
+	if (!resolution.enabled || frame.renderExtent.width != resolution.renderExtent.width || frame.renderExtent.height != resolution.renderExtent.height) {
+		return;
+	}
+
+	// Over budget: drop quickly, straight to the scale predicted to fit. The pixel cost follows the
+	// area, and the target leaves the same headroom growing back needs, so the drop holds.
+	if (frameMs > resolution.budgetMs) {
+		resolution.headroomFrames = 0;
+		const bool canDecrease = resolution.scale > VulkanDynamicResolution::MinScale + VulkanDynamicResolution::ScaleStep * 0.5f;
+		if (canDecrease && ++resolution.overBudgetFrames >= VulkanDynamicResolution::DecreaseFrames) {
+			const float fitScale = resolution.scale * static_cast<float>(std::sqrt(resolution.budgetMs * VulkanDynamicResolution::IncreaseHeadroom / frameMs));
+			setRenderScale(resolution, std::min(fitScale, resolution.scale - VulkanDynamicResolution::ScaleStep), targetExtent);
+			++stats.decreases;
+		}
+		return;
+	}
+	resolution.overBudgetFrames = 0;
+
+	// Under budget: grow one step at a time, and only once the step is predicted to keep the headroom
+	const float nextScale = resolution.scale + VulkanDynamicResolution::ScaleStep;
+	const double predictedMs = frameMs * (nextScale * nextScale) / (resolution.scale * resolution.scale);
+	if (resolution.scale < 1.0f && predictedMs < resolution.budgetMs * VulkanDynamicResolution::IncreaseHeadroom) {
+		if (++resolution.headroomFrames >= VulkanDynamicResolution::IncreaseFrames) {
+			setRenderScale(resolution, nextScale, targetExtent);
+			++stats.increases;
+		}
+	} else {
+		resolution.headroomFrames = 0;
+	}
+}
+
+// Scales the rendered part of the scene color up to the whole swap chain image and hands that to presentation
+void recordUpscale(VkCommandBuffer commandBuffer, VulkanDynamicResolution& resolution, VulkanResolutionFrame& frame, VulkanSwapChain& swapChain, uint32_t imageIndex) {
+	// The render pass left the scene color in the transfer layout; the swap chain image's old contents are discarded
+	VkImageMemoryBarrier barriers[2]{};
+	barriers[0].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barriers[0].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	barriers[0].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+	barriers[0].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	barriers[0].newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	barriers[0].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barriers[0].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barriers[0].image = swapChain.sceneColorImage;
+	barriers[0].subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+
+	barriers[1] = barriers[0];
+	barriers[1].srcAccessMask = 0;
+	barriers[1].dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barriers[1].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	barriers[1].newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barriers[1].image = swapChain.images[imageIndex];
+
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+		0, 0, nullptr, 0, nullptr, 2, barriers);
+
+	VkImageBlit blit{};
+	blit.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+	blit.srcOffsets[1] = { static_cast<int32_t>(frame.renderExtent.width), static_cast<int32_t>(frame.renderExtent.height), 1 };
+	blit.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+	blit.dstOffsets[1] = { static_cast<int32_t>(swapChain.extent.width), static_cast<int32_t>(swapChain.extent.height), 1 };
+	vkCmdBlitImage(commandBuffer, swapChain.sceneColorImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+		swapChain.images[imageIndex], VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+
+	VkImageMemoryBarrier presentBarrier = barriers[1];
+	presentBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	presentBarrier.dstAccessMask = 0;
+	presentBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	presentBarrier.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+		0, 0, nullptr, 0, nullptr, 1, &presentBarrier);
+
+	if (resolution.timestampPeriod > 0.0f) {
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frame.timestampPool, ResolutionTimestampFrameEnd);
+	}
+}
+
+void destroyDynamicResolution(VulkanDynamicResolution& resolution, VulkanDevice& device) {
+	for (VulkanResolutionFrame& frame : resolution.frames) {
+		if (frame.timestampPool != VK_NULL_HANDLE) {
+			vkDestroyQueryPool(device.logicalDevice, frame.timestampPool, nullptr);
+		}
+	}
+	resolution.frames.clear();
+	spdlog::debug("Dynamic resolution destroyed");
+}
+
+// -----------------------------------------------------------------------------
+// Scene
+// -----------------------------------------------------------------------------
+namespace {
+	// Sphere around the unit triangle and its ripples, so the bounds stay valid however it is rotated
+	constexpr float TriangleMeshRadius = 0.71f;
+
+	// The levels of detail switch back only once their error is this much under the threshold
+	constexpr float LodHysteresis = 0.25f;
+
+	MiniEngine::Scene::Bounds computeBounds(const MiniEngine::Scene::Transform& transform) {
+		float radius = TriangleMeshRadius * std::max(transform.scale.x, std::max(transform.scale.y, transform.scale.z));
+		return { transform.position, radius, glm::vec3(radius) };
+	}
+
+	glm::mat4 computeModelMatrix(const MiniEngine::Scene::Transform& transform) {
+		return glm::translate(glm::mat4(1.0f), transform.position) * glm::mat4_cast(transform.rotation) * glm::scale(glm::mat4(1.0f), transform.scale);
+	}
+}
+
+void createScene(SceneState& scene, uint32_t objectCount) {
+	const uint32_t side = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<float>(objectCount))));
+	const float spacing = 2.0f;
+	scene.extent = side * spacing * 0.5f;
+	scene.modelMatrices.resize(objectCount);
+	scene.objectBounds.resize(objectCount);
+
+	for (uint32_t i = 0; i < objectCount; ++i) {
+		MiniEngine::Scene::Transform transform;
+		transform.position = glm::vec3((i % side) * spacing - scene.extent, 0.5f, (i / side) * spacing - scene.extent);
+		transform.rotation = glm::angleAxis(static_cast<float>(i), glm::vec3(0.0f, 1.0f, 0.0f));
+
+		// A few large triangles act as occluders for the ones behind them
+		if (i % 97 == 0) {
+			transform.position.y = 3.0f;
+			transform.scale = glm::vec3(6.0f);
+		}
+
+		Renderable renderable;
+		renderable.drawIndex = i;
+		scene.objectBounds[i] = computeBounds(transform);
+		renderable.cullingObject = scene.culling.AddObject(scene.objectBounds[i], i);
+		scene.modelMatrices[i] = computeModelMatrix(transform);
+
+		// Every tenth object spins, so the culling hierarchy has something to refit each frame
+		if (i % 10 == 0) {
+			scene.registry.Create(transform, renderable, Spin{ 1.0f + (i % 7) * 0.25f }, MiniEngine::Scene::PreviousTransform{ transform });
+		} else {
+			scene.registry.Create(transform, renderable);
+		}
+	}
+}
+
+// Lights hover over the grid, each circling a point of its own. Every fourth one is a spot light
+// pointing down with a longer reach. The sequence is fixed, so a smaller set is a prefix of a larger one.
+void createLights(SceneState& scene, uint32_t lightCount) {
+	for (MiniEngine::Scene::Entity light : scene.lights) {
+		scene.registry.Destroy(light);
+	}
+	scene.lights.clear();
+	scene.lights.reserve(lightCount);
+
+	std::mt19937 random(11);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	for (uint32_t i = 0; i < lightCount; ++i) {
+		Orbit orbit;
+		orbit.center = glm::vec3((unit(random) * 2.0f - 1.0f) * scene.extent, 1.0f + unit(random) * 2.0f, (unit(random) * 2.0f - 1.0f) * scene.extent);
+		orbit.radius = 1.0f + unit(random) * 3.0f;
+		orbit.speed = 0.2f + unit(random) * 0.6f;
+		orbit.phase = unit(random) * 6.2831853f;
+
+		LightSource light;
+		light.color = glm::vec3(0.3f + 0.7f * unit(random), 0.3f + 0.7f * unit(random), 0.3f + 0.7f * unit(random)) * 4.0f;
+		if (i % 4 == 3) {
+			light.range = 6.0f;
+			light.coneAngle = 0.6f;
+		}
+
+		MiniEngine::Scene::Transform transform;
+		transform.position = orbit.center + glm::vec3(orbit.radius, 0.0f, 0.0f);
+		scene.lights.push_back(scene.registry.Create(transform, light, orbit, MiniEngine::Scene::PreviousTransform{ transform }));
+	}
+}
+
+void updateScene(SceneState& scene, float time, float deltaTime) {
+	scene.registry.Query<MiniEngine::Scene::Transform, MiniEngine::Scene::PreviousTransform, Orbit>().Each(
+		[&](MiniEngine::Scene::Entity, MiniEngine::Scene::Transform& transform, MiniEngine::Scene::PreviousTransform& previous, Orbit& orbit) {
+			previous.value = transform;
+			const float angle = orbit.phase + orbit.speed * time;
+			transform.position = orbit.center + glm::vec3(std::cos(angle), 0.0f, std::sin(angle)) * orbit.radius;
+		});
+
+	scene.registry.Query<MiniEngine::Scene::Transform, MiniEngine::Scene::PreviousTransform, Renderable, Spin>().Each(
+		[&](MiniEngine::Scene::Entity, MiniEngine::Scene::Transform& transform, MiniEngine::Scene::PreviousTransform& previous,
+			Renderable& renderable, Spin& spin) {
+			previous.value = transform;
+			transform.rotation = glm::normalize(glm::angleAxis(spin.speed * deltaTime, glm::vec3(0.0f, 1.0f, 0.0f)) * transform.rotation);
+			transform.position.y = 0.5f * transform.scale.y + 0.5f * std::sin(time * spin.speed + renderable.drawIndex);
+		});
+}
+
+// Only objects that move have a previous transform; the rest keep the matrices and bounds they were created with
+void interpolateScene(SceneState& scene, float alpha) {
+	scene.interpolation = alpha;
+	scene.registry.Query<MiniEngine::Scene::Transform, MiniEngine::Scene::PreviousTransform, Renderable>().Each(
+		[&](MiniEngine::Scene::Entity, const MiniEngine::Scene::Transform& transform, const MiniEngine::Scene::PreviousTransform& previous,
+			const Renderable& renderable) {
+			const MiniEngine::Scene::Transform rendered = MiniEngine::Scene::Interpolate(previous.value, transform, alpha);
+			scene.modelMatrices[renderable.drawIndex] = computeModelMatrix(rendered);
+			scene.objectBounds[renderable.drawIndex] = computeBounds(rendered);
+			scene.culling.UpdateObject(renderable.cullingObject, scene.objectBounds[renderable.drawIndex]);
+		});
+}
+
+void buildDrawList(DrawList& drawList, SceneState& scene, VkExtent2D extent, float time, MiniEngine::Core::JobSystem& jobs) {
+	// Orbit inside the grid looking outwards, so most of the scene is behind or beside the camera
+	const float orbitRadius = scene.extent * 0.5f;
+	glm::vec3 eye(std::cos(time * 0.2f) * orbitRadius, 6.0f, std::sin(time * 0.2f) * orbitRadius);
+	glm::vec3 target = eye + glm::vec3(std::cos(time * 0.2f), -0.15f, std::sin(time * 0.2f));
+
+	const float nearPlane = 0.1f;
+	const float farPlane = 200.0f;
+	float aspect = extent.height > 0 ? static_cast<float>(extent.width) / static_cast<float>(extent.height) : 1.0f;
+	glm::mat4 projection = glm::perspective(glm::radians(60.0f), aspect, nearPlane, farPlane);
+	projection[1][1] *= -1.0f; // Vulkan clip space has Y pointing down
+	drawList.view = glm::lookAt(eye, target, glm::vec3(0.0f, 1.0f, 0.0f));
+	drawList.projection = projection;
+	drawList.viewProjection = projection * drawList.view;
+	drawList.nearPlane = nearPlane;
+	drawList.farPlane = farPlane;
+
+	// Lights go to the GPU in view space, where the cluster grid is defined; the GPU bins them all
+	drawList.lights.clear();
+	scene.registry.Query<MiniEngine::Scene::Transform, MiniEngine::Scene::PreviousTransform, LightSource>().Each(
+		[&](MiniEngine::Scene::Entity, const MiniEngine::Scene::Transform& current, const MiniEngine::Scene::PreviousTransform& previous,
+			const LightSource& source) {
+			const MiniEngine::Scene::Transform transform = MiniEngine::Scene::Interpolate(previous.value, current, scene.interpolation);
+			const glm::vec3 direction = transform.rotation * glm::vec3(0.0f, -1.0f, 0.0f);
+			GpuLight light;
+			light.positionRange = glm::vec4(glm::vec3(drawList.view * glm::vec4(transform.position, 1.0f)), source.range);
+			light.directionCosine = glm::vec4(glm::vec3(drawList.view * glm::vec4(direction, 0.0f)), source.coneAngle > 0.0f ? std::cos(source.coneAngle) : -1.0f);
+			light.color = glm::vec4(source.color, 1.0f);
+			drawList.lights.push_back(light);
+		});
+
+	scene.culling.Cull(MiniEngine::Scene::Frustum::FromMatrix(drawList.viewProjection), scene.visible, &jobs);
+
+	// Everything shares one pipeline and material, so the keys order the draws front to back,
+	// which lets early depth testing reject more fragments and fills the Hi-Z pyramid with near occluders.
+	// The culling shader writes the draws it keeps in this order (see VulkanOcclusionCulling::RecordCulling).
+	const glm::vec3 forward = glm::normalize(target - eye);
+	scene.drawQueue.Clear();
+	for (uint32_t drawIndex : scene.visible) {
+		float viewDepth = glm::dot(scene.objectBounds[drawIndex].center - eye, forward);
+		uint32_t depthBucket = MiniEngine::Graphics::DrawKey::MakeDepthBucket(viewDepth, nearPlane, farPlane);
+		scene.drawQueue.Submit(MiniEngine::Graphics::DrawKey::Make(MiniEngine::Graphics::DrawPass::Opaque, 0, 0, depthBucket), drawIndex);
+	}
+	scene.drawQueue.Sort();
+
+	// Frustum-visible objects go to the GPU, which culls them again against the depth pyramid. Each
+	// draws the coarsest level of detail whose error stays under the threshold on screen, judged at
+	// the nearest point of its bounds.
+	const std::vector<MiniEngine::Graphics::QueuedDraw>& draws = scene.drawQueue.GetDraws();
+	const float pixelsPerUnitAtOne = std::abs(projection[1][1]) * static_cast<float>(extent.height) * 0.5f;
+	scene.objectLods.resize(scene.modelMatrices.size(), 0);
+	scene.lodStats = {};
+	drawList.objects.resize(draws.size());
+	for (size_t i = 0; i < draws.size(); ++i) {
+		const uint32_t drawIndex = draws[i].drawIndex;
+		const MiniEngine::Scene::Bounds& bounds = scene.objectBounds[drawIndex];
+		uint32_t lod = 0;
+		if (scene.lodEnabled && !scene.meshLods.empty()) {
+			const float distance = std::max(glm::length(bounds.center - eye) - bounds.radius, nearPlane);
+			const float pixelsPerUnit = pixelsPerUnitAtOne * (bounds.radius / TriangleMeshRadius) / distance;
+			lod = MiniEngine::Graphics::SelectMeshLod(scene.meshLods, pixelsPerUnit, scene.objectLods[drawIndex], scene.lodThresholdPixels, LodHysteresis);
+		}
+		scene.objectLods[drawIndex] = static_cast<uint8_t>(lod);
+		if (!scene.meshLods.empty()) {
+			scene.lodStats.triangles += scene.meshLods[lod].indexCount / 3;
+			scene.lodStats.fullDetailTriangles += scene.meshLods[0].indexCount / 3;
+			++scene.lodStats.objects[lod];
+		}
+
+		drawList.objects[i].model = scene.modelMatrices[drawIndex];
+		drawList.objects[i].boundsCenterRadius = glm::vec4(bounds.center, bounds.radius);
+		drawList.objects[i].boundsExtents = glm::vec4(bounds.extents, static_cast<float>(lod));
+	}
+}
+
+std::string formatFrameTimings(const FrameTimings& current, const FrameTimings& previous, double seconds) {
+	const uint64_t frames = current.frames - previous.frames;
+	const double perFrame = frames > 0 ? 1.0 / static_cast<double>(frames) : 0.0;
+	return fmt::format("{:.1f} fps; main thread simulates {:.3f} ms and waits {:.3f} ms per frame, render thread renders {:.3f} ms and waits {:.3f} ms",
+		seconds > 0.0 ? frames / seconds : 0.0,
+		(current.simulateMs - previous.simulateMs) * perFrame, (current.mainWaitMs - previous.mainWaitMs) * perFrame,
+		(current.renderMs - previous.renderMs) * perFrame, (current.renderWaitMs - previous.renderWaitMs) * perFrame);
+}
+
+// -----------------------------------------------------------------------------
+// Frame Capture
+// -----------------------------------------------------------------------------
+bool captureFrame(MiniEngine::Graphics::FrameTraceWriter& trace, const DrawList& drawList, TraceFrameState state) {
+	state.view = drawList.view;
+	state.projection = drawList.projection;
+	state.nearPlane = drawList.nearPlane;
+	state.farPlane = drawList.farPlane;
+
+	const std::span<const uint8_t> streams[] = {
+		std::span(reinterpret_cast<const uint8_t*>(&state), sizeof(state)),
+		std::span(reinterpret_cast<const uint8_t*>(drawList.objects.data()), drawList.objects.size() * sizeof(GpuObject)),
+		std::span(reinterpret_cast<const uint8_t*>(drawList.lights.data()), drawList.lights.size() * sizeof(GpuLight)),
+	};
+	return trace.WriteFrame(streams);
+}
+
+bool readReplayFrame(MiniEngine::Graphics::FrameTraceReader& trace, DrawList& drawList, TraceFrameState& state) {
+	if (!trace.ReadFrame() || trace.GetStream(0).size() != sizeof(TraceFrameState)) {
+		return false;
+	}
+
+	std::memcpy(&state, trace.GetStream(0).data(), sizeof(state));
+	drawList.view = state.view;
+	drawList.projection = state.projection;
+	drawList.viewProjection = state.projection * state.view;
+	drawList.nearPlane = state.nearPlane;
+	drawList.farPlane = state.farPlane;
+
+	const std::span<const uint8_t> objects = trace.GetStream(1);
+	drawList.objects.resize(objects.size() / sizeof(GpuObject));
+	std::memcpy(drawList.objects.data(), objects.data(), drawList.objects.size() * sizeof(GpuObject));
+	const std::span<const uint8_t> lights = trace.GetStream(2);
+	drawList.lights.resize(lights.size() / sizeof(GpuLight));
+	std::memcpy(drawList.lights.data(), lights.data(), drawList.lights.size() * sizeof(GpuLight));
+	return true;
+}
+
+TraceFrameState currentTraceState(
+	float deltaTime,
+	const VulkanRenderer& renderer,
+	const MiniEngine::Graphics::VulkanOcclusionCulling& occlusion,
+	const MiniEngine::Graphics::VulkanClusteredLighting& lighting,
+	const VulkanDynamicResolution& resolution,
+	const MiniEngine::Graphics::VulkanTextureSystem& textures) {
+	TraceFrameState state = {};
+	state.deltaTime = deltaTime;
+	state.renderScale = resolution.scale;
+	state.flags = (occlusion.IsEnabled() ? TraceOcclusion : 0) | (lighting.IsClustered() ? TraceClustered : 0) |
+		(renderer.reuseCommandBuffers ? TraceReuse : 0) | (occlusion.IsMeshletCulling() ? TraceMeshlets : 0);
+	state.textureIndex = textures.GetActiveIndex();
+	return state;
+}
+
+// -----------------------------------------------------------------------------
+// Frame Loop
+// -----------------------------------------------------------------------------
+bool wasKeyPressed(GLFWwindow* window, int key, bool& keyDown) {
+	const bool down = glfwGetKey(window, key) == GLFW_PRESS;
+	const bool pressed = down && !keyDown;
+	keyDown = down;
+	return pressed;
+}
+
+void pollRenderInput(GLFWwindow* window, RenderInputKeys& keys, RenderInput& input) {
+	// O switches occlusion culling, so its GPU cost and savings can be compared on the same scene
+	input.toggleOcclusion = wasKeyPressed(window, GLFW_KEY_O, keys.occlusion);
+	// K switches meshlet culling, against drawing each visible object whole
+	input.toggleMeshlets = wasKeyPressed(window, GLFW_KEY_K, keys.meshlets);
+	// C switches command buffer reuse, to compare the CPU cost of re-recording every frame
+	input.toggleReuse = wasKeyPressed(window, GLFW_KEY_C, keys.reuse);
+	// L switches between clustered and naive lighting
+	input.toggleLighting = wasKeyPressed(window, GLFW_KEY_L, keys.lighting);
+	// R switches dynamic resolution; switching it off goes straight back to full resolution
+	input.toggleResolution = wasKeyPressed(window, GLFW_KEY_R, keys.resolution);
+	// D defragments memory over the next frames, one bounded pass per frame
+	input.defragment = wasKeyPressed(window, GLFW_KEY_D, keys.defragment);
+	// T cycles through the resident textures, starting over at the white one
+	input.nextTexture = wasKeyPressed(window, GLFW_KEY_T, keys.texture);
+}
+
+void applyRenderInput(
+	const FramePacket& packet,
+	VulkanRenderer& renderer,
+	MiniEngine::Graphics::VulkanOcclusionCulling& occlusion,
+	MiniEngine::Graphics::VulkanClusteredLighting& lighting,
+	VulkanDynamicResolution& resolution,
+	MiniEngine::Graphics::VulkanTextureSystem& textures) {
+	// A replayed frame brings the settings it was captured with
+	if (packet.replayed) {
+		const TraceFrameState& state = packet.replayState;
+		occlusion.SetEnabled((state.flags & TraceOcclusion) != 0);
+		occlusion.SetMeshletCulling((state.flags & TraceMeshlets) != 0);
+		lighting.SetClustered((state.flags & TraceClustered) != 0);
+		renderer.reuseCommandBuffers = (state.flags & TraceReuse) != 0;
+		if (state.renderScale != resolution.scale) {
+			setRenderScale(resolution, state.renderScale, renderer.swapChain.extent);
+		}
+		textures.SetActiveIndex(state.textureIndex);
+	}
+
+	const RenderInput& input = packet.input;
+	if (input.toggleOcclusion) {
+		occlusion.SetEnabled(!occlusion.IsEnabled());
+		spdlog::info("Occlusion culling {}", occlusion.IsEnabled() ? "enabled" : "disabled");
+	}
+	if (input.toggleMeshlets) {
+		occlusion.SetMeshletCulling(!occlusion.IsMeshletCulling());
+		spdlog::info("Meshlet culling {}", occlusion.IsMeshletCulling() ? "enabled" : "disabled");
+	}
+	if (input.toggleReuse) {
+		renderer.reuseCommandBuffers = !renderer.reuseCommandBuffers;
+		spdlog::info("Command buffer reuse {}", renderer.reuseCommandBuffers ? "enabled" : "disabled");
+	}
+	if (input.toggleLighting) {
+		lighting.SetClustered(!lighting.IsClustered());
+		spdlog::info("{} lighting", lighting.IsClustered() ? "Clustered" : "Naive");
+	}
+	if (input.toggleResolution) {
+		resolution.enabled = !resolution.enabled;
+		if (!resolution.enabled) {
+			setRenderScale(resolution, 1.0f, renderer.swapChain.extent);
+		}
+		spdlog::info("Dynamic resolution {}", resolution.enabled ? "enabled" : "disabled");
+	}
+	if (input.defragment) {
+		renderer.device.memory.BeginDefragmentation();
+	}
+	if (input.nextTexture) {
+		textures.SetActiveIndex((textures.GetActiveIndex() + 1) % textures.GetTextureCount());
+		const MiniEngine::Graphics::VulkanTexture& texture = textures.GetActiveTexture();
+		spdlog::info("Texture {}: {}x{}, {} mips", texture.name, texture.extent.width, texture.extent.height, texture.mipCount);
+	}
+}
+
+void logRenderStats(
+	const FramePacket& packet,
+	VulkanRenderer& renderer,
+	const VulkanMesh& mesh,
+	const MiniEngine::Graphics::VulkanOcclusionCulling& occlusion,
+	const MiniEngine::Graphics::VulkanClusteredLighting& lighting,
+	VulkanDynamicResolution& resolution,
+	const MiniEngine::Graphics::VulkanParticleSystem& particles,
+	const MiniEngine::Graphics::VulkanFrameReadback& readback,
+	const MiniEngine::Graphics::VulkanTextureSystem& textures) {
+	const MiniEngine::Scene::CullingStats& stats = packet.culling;
+	spdlog::info("Culling: {}/{} visible, {} nodes and {} objects tested, {} accepted by node, {} nodes refitted{}, {:.3f} ms",
+		stats.visibleObjects, stats.objectCount, stats.testedNodes, stats.testedObjects, stats.acceptedObjects,
+		stats.refittedNodes, stats.rebuilt ? " (rebuilt)" : "", stats.cullTimeMs);
+	const MiniEngine::Graphics::CommandEncoderStats& encoderStats = renderer.commandEncoder.GetStats();
+	spdlog::info("Command encoder: {} commands issued, {} redundant ones elided in the last recording",
+		encoderStats.GetIssued(), encoderStats.GetElided());
+
+	CommandRecordingStats& recordingStats = renderer.recordingStats;
+	spdlog::info("Command buffers: {} recorded, {} reused; record and submit {:.3f} ms with reuse, {:.3f} ms without{}",
+		recordingStats.recorded, recordingStats.reused, recordingStats.cpuMs[1], recordingStats.cpuMs[0],
+		recordingStats.samples[0] > 0 && recordingStats.samples[1] > 0 ? "" : " (press C to compare)");
+	recordingStats.recorded = 0;
+	recordingStats.reused = 0;
+	spdlog::info("Draw queue: {} draws sorted in {:.3f} ms ({} radix passes)",
+		packet.drawQueue.drawCount, packet.drawQueue.sortTimeMs, packet.drawQueue.radixPasses);
+
+	const LodStats& lodStats = packet.lod;
+	std::string lodLevels;
+	for (size_t level = 0; level < mesh.lods.size(); ++level) {
+		lodLevels += fmt::format("{}{}", level > 0 ? ", " : "", lodStats.objects[level]);
+	}
+	spdlog::info("Levels of detail: {} triangles, {} at full detail ({:.1f}x fewer); objects per level {}",
+		lodStats.triangles, lodStats.fullDetailTriangles,
+		lodStats.triangles > 0 ? static_cast<double>(lodStats.fullDetailTriangles) / static_cast<double>(lodStats.triangles) : 1.0, lodLevels);
+
+	if (particles.GetCapacity() > 0) {
+		const MiniEngine::Graphics::ParticleStats& particleStats = particles.GetStats();
+		spdlog::info("Particles: {}/{} alive, simulate {:.3f} ms on the {} queue, render {:.3f} ms",
+			particleStats.alive, particles.GetCapacity(), particleStats.gpuSimulateMs,
+			renderer.device.queues.HasAsyncCompute() ? "async compute" : "graphics", particleStats.gpuRenderMs);
+	}
+
+	const MiniEngine::Graphics::LightingStats& lightingStats = lighting.GetStats();
+	if (lighting.IsClustered()) {
+		spdlog::info("Lighting: {} lights, {:.1f} per cluster on average, binning {:.3f} ms",
+			lightingStats.lightCount, static_cast<double>(lightingStats.lightIndices) / MiniEngine::Graphics::VulkanClusteredLighting::ClusterCount,
+			lightingStats.gpuBinMs);
+	}
+	if (lightingStats.samples[0] > 0 && lightingStats.samples[1] > 0) {
+		spdlog::info("GPU lit frame: {:.3f} ms clustered, {:.3f} ms naive",
+			lightingStats.gpuFrameMs[1], lightingStats.gpuFrameMs[0]);
+	}
+
+	DynamicResolutionStats& resolutionStats = resolution.stats;
+	if (resolution.timestampPeriod > 0.0f) {
+		spdlog::info("Resolution: {}x{} ({:.0f}%, lowest {:.0f}%), GPU frame {:.3f} ms of {:.1f} ms budget, {} decreases, {} increases{}",
+			resolution.renderExtent.width, resolution.renderExtent.height, resolution.scale * 100.0f, resolutionStats.minScale * 100.0f,
+			resolutionStats.gpuFrameMs, resolution.budgetMs, resolutionStats.decreases, resolutionStats.increases,
+			resolution.enabled ? "" : " (fixed, press R to adapt)");
+		resolutionStats.minScale = resolution.scale;
+		resolutionStats.decreases = 0;
+		resolutionStats.increases = 0;
+	}
+
+	if (const std::shared_ptr<MiniEngine::Core::AsyncLogSink> logSink = MiniEngine::Core::GetAsyncLogSink()) {
+		const MiniEngine::Core::AsyncLogStats logStats = logSink->GetStats();
+		if (logStats.dropped > 0 || logStats.truncated > 0) {
+			spdlog::info("Logging: {} messages written, {} dropped on a full queue, {} truncated",
+				logStats.written, logStats.dropped, logStats.truncated);
+		}
+	}
+
+	if (readback.IsEnabled()) {
+		const MiniEngine::Graphics::ImageSequenceStats writerStats = readback.GetWriterStats();
+		spdlog::info("Frame capture: {} copied, {} skipped with every readback buffer busy, {} written ({:.1f} MiB), {} failed, {:.3f} ms to write each, queue up to {}",
+			readback.GetStats().copied, readback.GetStats().skipped, writerStats.written, writerStats.bytes / (1024.0 * 1024.0), writerStats.failed,
+			writerStats.written > 0 ? writerStats.encodeMs / writerStats.written : 0.0, writerStats.maxQueueDepth);
+	}
+
+	const MiniEngine::Graphics::TextureStats& textureStats = textures.GetStats();
+	if (textureStats.requested > 0) {
+		spdlog::info("Textures: {}/{} resident, {} failed, {:.1f} MiB in {} batches, {} mips generated, {} samplers for {} requests",
+			textureStats.loaded, textureStats.requested, textureStats.failed, textureStats.uploadedBytes / (1024.0 * 1024.0),
+			textureStats.batches, textureStats.generatedMips, textures.GetSamplers().GetSamplerCount(), textures.GetSamplers().GetRequestCount());
+	}
+
+	const MiniEngine::Graphics::VulkanMemory& memory = renderer.device.memory;
+	spdlog::info("Memory: {}; {:.1f} MiB unused in blocks, {} evictions released {:.1f} MiB", memory.FormatOverlay(),
+		memory.GetUnusedBlockBytes() / (1024.0 * 1024.0), memory.GetEvictionCount(), memory.GetEvictedBytes() / (1024.0 * 1024.0));
+
+	const MiniEngine::Graphics::OcclusionStats& occlusionStats = occlusion.GetStats();
+	if (occlusionStats.frustumVisible > 0) {
+		spdlog::info("Occlusion: {:.1f}% of {} frustum-visible objects occluded, {} drawn in phase 1, {} in phase 2",
+			100.0 * occlusionStats.occluded / occlusionStats.frustumVisible, occlusionStats.frustumVisible,
+			occlusionStats.phase1Visible, occlusionStats.phase2Visible);
+		spdlog::info("Meshlets: {} tested, {} back-facing and {} outside the frustum rejected; {} draws, {} triangles{}",
+			occlusionStats.meshletsTested, occlusionStats.meshletsBackfacing, occlusionStats.meshletsOutside,
+			occlusionStats.draws, occlusionStats.triangles, occlusion.IsMeshletCulling() ? "" : " (meshlet culling off, press K to compare)");
+	}
+	if (occlusionStats.samples[0] > 0 && occlusionStats.samples[1] > 0) {
+		spdlog::info("GPU frame: {:.3f} ms with occlusion (culling and Hi-Z {:.3f} ms), {:.3f} ms without, {:.3f} ms saved",
+			occlusionStats.gpuFrameMs[1], occlusionStats.gpuCullMs[1], occlusionStats.gpuFrameMs[0],
+			occlusionStats.gpuFrameMs[0] - occlusionStats.gpuFrameMs[1]);
+	}
+	else if (occlusionStats.samples[0] + occlusionStats.samples[1] > 0) {
+		int mode = occlusionStats.samples[1] > 0 ? 1 : 0;
+		spdlog::info("GPU frame: {:.3f} ms with occlusion {}, press O to compare",
+			occlusionStats.gpuFrameMs[mode], mode ? "on" : "off");
+	}
+
+	const MiniEngine::Core::FrameClockStats& clockStats = packet.clock;
+	spdlog::info("Frame clock: {} steps simulated, {} dropped; frame {:.3f} ms on average, {:.3f} ms min, {:.3f} ms max, {:.3f} ms 99th percentile",
+		clockStats.steps, clockStats.droppedSteps, clockStats.averageFrameMs, clockStats.minFrameMs, clockStats.maxFrameMs, clockStats.p99FrameMs);
+}
+
+void logStartupTimeline(const MiniEngine::Core::TaskGraph& startup, const std::string& tracePath) {
+	for (const MiniEngine::Core::TaskTiming& timing : startup.GetTimeline()) {
+		spdlog::info("Startup: {:<22} {:8.1f} ms  +{:7.1f} ms  thread {}{}", timing.name, timing.startMs, timing.durationMs,
+			timing.thread, timing.skipped ? " (skipped)" : timing.succeeded ? "" : " (failed)");
+	}
+	spdlog::info("First frame presented {:.1f} ms after launch", startup.GetElapsedMs());
+	if (!tracePath.empty() && startup.WriteChromeTrace(tracePath)) {
+		spdlog::info("Startup trace written to {}", tracePath);
+	}
+}
+
+// Settled once the step has run for settleSeconds, measured once it has run for measureSeconds more
+BenchmarkEvent advanceBenchmark(BenchmarkSchedule& schedule, double now, double settleSeconds, double measureSeconds) {
+	const double elapsed = now - schedule.stepStart;
+	if (!schedule.measuring && elapsed >= settleSeconds) {
+		schedule.measuring = true;
+		return BenchmarkEvent::Settled;
+	}
+	if (schedule.measuring && elapsed >= settleSeconds + measureSeconds) {
+		++schedule.step;
+		schedule.stepStart = now;
+		schedule.measuring = false;
+		return BenchmarkEvent::Measured;
+	}
+	return BenchmarkEvent::None;
+}
+
+// A second to settle, then three measured
+void updatePipelineBenchmark(PipelineBenchmark& benchmark, double now, const FrameTimings& timings, const std::string& renderingMode,
+	MiniEngine::Graphics::RedrawScheduler& redraw) {
+	const BenchmarkEvent event = advanceBenchmark(benchmark.schedule, now, 1.0, 3.0);
+	if (event == BenchmarkEvent::Settled) {
+		benchmark.startTimings = timings;
+		benchmark.measureStart = now;
+	}
+	else if (event == BenchmarkEvent::Measured) {
+		spdlog::info("Pipeline benchmark: {}: {}", renderingMode, formatFrameTimings(timings, benchmark.startTimings, now - benchmark.measureStart));
+		redraw.RequestQuit();
+	}
+}
+
+// Settles for a second, then measures for three. Idle CPU covers the whole process while the main
+// thread waited; the render thread blocks as well, since no packets arrive.
+void updateIdleBenchmark(IdleBenchmark& benchmark, double now, MiniEngine::Graphics::RedrawScheduler& redraw) {
+	const BenchmarkEvent event = advanceBenchmark(benchmark.schedule, now, 1.0, 3.0);
+	if (event == BenchmarkEvent::Settled) {
+		benchmark.startStats = redraw.GetStats();
+	}
+	else if (event == BenchmarkEvent::Measured) {
+		const MiniEngine::Graphics::RedrawStats stats = redraw.GetStats();
+		const MiniEngine::Graphics::RedrawStats& start = benchmark.startStats;
+		const double idleSeconds = stats.idleSeconds - start.idleSeconds;
+		const uint64_t presents = stats.presents - start.presents;
+		spdlog::info("Idle benchmark: {} frames, {} wakeups, idle {:.2f} s at {:.2f}% CPU, wake to present {:.3f} ms on average, {:.3f} ms at most",
+			stats.frames - start.frames, stats.wakeups - start.wakeups, idleSeconds,
+			idleSeconds > 0.0 ? 100.0 * (stats.idleCpuSeconds - start.idleCpuSeconds) / idleSeconds : 0.0,
+			presents > 0 ? (stats.wakeToPresentMs - start.wakeToPresentMs) / presents : 0.0, stats.maxWakeToPresentMs);
+		redraw.RequestQuit();
+	}
+}
+
+// Done once every requested texture has loaded or failed, elapsedSeconds after the first request
+void updateTextureBenchmark(const MiniEngine::Graphics::VulkanTextureSystem& textures, double elapsedSeconds, MiniEngine::Graphics::RedrawScheduler& redraw) {
+	const MiniEngine::Graphics::TextureStats& textureStats = textures.GetStats();
+	if (textureStats.loaded + textureStats.failed != textureStats.requested) {
+		return;
+	}
+	spdlog::info("Texture benchmark: {} textures ({} failed), {:.1f} MiB resident after {:.1f} ms; loader read for {:.1f} ms, "
+		"{} upload batches, {} mips generated",
+		textureStats.loaded, textureStats.failed, textureStats.uploadedBytes / (1024.0 * 1024.0), elapsedSeconds * 1000.0,
+		textureStats.readMs, textureStats.batches, textureStats.generatedMips);
+	redraw.RequestQuit();
+}
@@ -22,5 +22,15 @@ if not exist "Resources\Shaders\spirv" mkdir "Resources\Shaders\spirv"
 :: Compile shaders
 %GLSLC% -o Resources\Shaders\spirv\Triangle.vert.spv Resources\Shaders\Triangle.vert
 %GLSLC% -o Resources\Shaders\spirv\Triangle.frag.spv Resources\Shaders\Triangle.frag
+%GLSLC% -o Resources\Shaders\spirv\OcclusionCull.comp.spv Resources\Shaders\occlusion_cull.comp
+%GLSLC% -o Resources\Shaders\spirv\HiZReduce.comp.spv Resources\Shaders\hiz_reduce.comp
+%GLSLC% -o Resources\Shaders\spirv\DrawScan.comp.spv Resources\Shaders\draw_scan.comp
+%GLSLC% -o Resources\Shaders\spirv\LightCull.comp.spv Resources\Shaders\light_cull.comp
+%GLSLC% -o Resources\Shaders\spirv\TextureMipgen.comp.spv Resources\Shaders\texture_mipgen.comp
+%GLSLC% -o Resources\Shaders\spirv\ParticlePrepare.comp.spv Resources\Shaders\particle_prepare.comp
+%GLSLC% -o Resources\Shaders\spirv\ParticleEmit.comp.spv Resources\Shaders\particle_emit.comp
+%GLSLC% -o Resources\Shaders\spirv\ParticleSimulate.comp.spv Resources\Shaders\particle_simulate.comp
+%GLSLC% -o Resources\Shaders\spirv\Particle.vert.spv Resources\Shaders\particle.vert
+%GLSLC% -o Resources\Shaders\spirv\Particle.frag.spv Resources\Shaders\particle.frag
 
 echo Shader compilation complete!